@@ -34,6 +34,7 @@
 #include "audio/decoders/vorbis.h"
 #include "audio/decoders/wave.h"
 #include "audio/mixer.h"
+#include "audio/prefetching_stream.h"
 
 
 namespace Audio {
@@ -47,25 +48,27 @@ struct StreamFileFormat {
 	 * Return NULL in case of an error (invalid/nonexisting file).
 	 */
 	SeekableAudioStream *(*openStreamFile)(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse);
+	/** Whether decoding the format is expensive enough to be worth doing ahead. */
+	bool compressed;
 };
 
 static const StreamFileFormat STREAM_FILEFORMATS[] = {
-	/* decoderName,  fileExt, openStreamFunction */
+	/* decoderName,  fileExt, openStreamFunction, compressed */
 #ifdef USE_FLAC
-	{ "FLAC",         ".flac", makeFLACStream },
-	{ "FLAC",         ".fla",  makeFLACStream },
+	{ "FLAC",         ".flac", makeFLACStream,      true },
+	{ "FLAC",         ".fla",  makeFLACStream,      true },
 #endif
 #ifdef USE_VORBIS
-	{ "Ogg Vorbis",   ".ogg",  makeVorbisStream },
+	{ "Ogg Vorbis",   ".ogg",  makeVorbisStream,    true },
 #endif
 #ifdef USE_MAD
-	{ "MPEG Layer 3", ".mp3",  makeMP3Stream },
+	{ "MPEG Layer 3", ".mp3",  makeMP3Stream,       true },
 #endif
-	{ "MPEG-4 Audio", ".m4a",  makeQuickTimeStream },
-	{ "WAV",          ".wav",  makeWAVStream },
+	{ "MPEG-4 Audio", ".m4a",  makeQuickTimeStream, true },
+	{ "WAV",          ".wav",  makeWAVStream,       false },
 };
 
-SeekableAudioStream *SeekableAudioStream::openStreamFile(const Common::Path &basename) {
+SeekableAudioStream *SeekableAudioStream::openStreamFile(const Common::Path &basename, bool prefetch) {
 	SeekableAudioStream *stream = nullptr;
 	Common::File *fileHandle = new Common::File();
 
@@ -76,6 +79,8 @@ SeekableAudioStream *SeekableAudioStream::openStreamFile(const Common::Path &bas
 			// Create the stream object
 			stream = STREAM_FILEFORMATS[i].openStreamFile(fileHandle, DisposeAfterUse::YES);
 			fileHandle = nullptr;
+			if (stream && prefetch && STREAM_FILEFORMATS[i].compressed)
+				stream = makePrefetchingAudioStream(stream);
 			break;
 		}
 	}
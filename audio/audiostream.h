@@ -218,11 +218,14 @@ public:
 	 * it is still the responsibility of the caller.
 	 *
 	 * @param basename  File name without an extension.
+	 * @param prefetch  Decode compressed files ahead on a worker thread, see
+	 *                  PrefetchingAudioStream. The file is then read from
+	 *                  that thread.
 	 *
 	 * @return  A SeekableAudioStream ready to use in case of success.
 	 *          NULL in case of an error (e.g. invalid/non-existing file).
 	 */
-	static SeekableAudioStream *openStreamFile(const Common::Path &basename);
+	static SeekableAudioStream *openStreamFile(const Common::Path &basename, bool prefetch = false);
 
 	/**
 	 * Seek to a given offset in the stream.
@@ -97,7 +97,8 @@ EmulatedChip::EmulatedChip() :
 	_nextTick(0),
 	_samplesPerTick(0),
 	_baseFreq(0),
-	_handle(new Audio::SoundHandle()) { }
+	_callbackFrame(-1),
+	_handle(nullptr) { }
 
 EmulatedChip::~EmulatedChip() {
 	// Stop callbacks, just in case. If it's still playing at this
@@ -114,6 +115,35 @@ int EmulatedChip::readBuffer(int16 *buffer, const int numSamples) {
 	int len = numSamples / stereoFactor;
 	int step;
 
+	// The callbacks may run on another thread than the other writes, which
+	// can only be told apart when the backend knows the threads
+	const uint32 thread = queuesWrites() ? g_system->getCurrentThreadId() : 0;
+	if (thread) {
+		// Same steps as below, but the writes of the callbacks are queued
+		// with their position and the buffer is generated afterwards.
+		_callbackThread.store(thread);
+		int frame = 0;
+		do {
+			step = len - frame;
+			if (step > (_nextTick >> FIXP_SHIFT))
+				step = (_nextTick >> FIXP_SHIFT);
+
+			frame += step;
+			_nextTick -= step << FIXP_SHIFT;
+			if (!(_nextTick >> FIXP_SHIFT)) {
+				_callbackFrame = frame;
+				if (_callback && _callback->isValid())
+					(*_callback)();
+				_callbackFrame = -1;
+
+				_nextTick += _samplesPerTick;
+			}
+		} while (frame < len);
+
+		generateSamples(buffer, len * stereoFactor);
+		return numSamples;
+	}
+
 	do {
 		step = len;
 		if (step > (_nextTick >> FIXP_SHIFT))
@@ -136,17 +166,28 @@ int EmulatedChip::readBuffer(int16 *buffer, const int numSamples) {
 	return numSamples;
 }
 
+int EmulatedChip::getCallbackFrame() const {
+	// Only read by the thread which writes it
+	if (g_system->getCurrentThreadId() != _callbackThread.load())
+		return -1;
+	return _callbackFrame;
+}
+
 int EmulatedChip::getRate() const {
 	return g_system->getMixer()->getOutputRate();
 }
 
 void EmulatedChip::startCallbacks(int timerFrequency) {
 	setCallbackFrequency(timerFrequency);
+	if (!_handle)
+		_handle = new Audio::SoundHandle();
 	g_system->getMixer()->playStream(Audio::Mixer::kPlainSoundType, _handle, this, -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::NO, true);
 }
 
 void EmulatedChip::stopCallbacks() {
-	g_system->getMixer()->stopHandle(*_handle);
+	// Nothing plays before the chip is started
+	if (_handle)
+		g_system->getMixer()->stopHandle(*_handle);
 }
 
 void EmulatedChip::setCallbackFrequency(int timerFrequency) {
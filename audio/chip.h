@@ -22,6 +22,7 @@
 #ifndef AUDIO_CHIP_H
 #define AUDIO_CHIP_H
 
+#include "common/atomic.h"
 #include "common/func.h"
 #include "common/ptr.h"
 
@@ -142,8 +143,31 @@ protected:
 	 */
 	virtual void generateSamples(int16 *buffer, int numSamples) = 0;
 
+	/**
+	 * Return true if the chip queues the register writes done in the timer
+	 * callbacks, at the frame returned by getCallbackFrame(), and applies
+	 * them itself at that frame in generateSamples().
+	 *
+	 * readBuffer() then calls all the callbacks which are due in a buffer
+	 * first, and generates the whole buffer at once, instead of generating
+	 * the small chunks between two callbacks. This needs the backend to
+	 * tell the threads apart, see OSystem::getCurrentThreadId().
+	 */
+	virtual bool queuesWrites() const { return false; }
+
+	/**
+	 * The frame of the buffer being read at which the current timer
+	 * callback is due, for chips which queue their writes. It is -1 when no
+	 * callback runs from readBuffer(), and on the threads other than the
+	 * one reading the buffer, whose writes must be applied right away.
+	 */
+	int getCallbackFrame() const;
+
 private:
 	int _baseFreq;
+	int _callbackFrame;
+	/** The thread which reads the buffers, for the chips which queue their writes. */
+	Common::Atomic<uint32> _callbackThread;
 
 	int _nextTick;
 	int _samplesPerTick;
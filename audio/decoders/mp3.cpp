@@ -33,6 +33,7 @@
 #include "common/util.h"
 
 #include "audio/audiostream.h"
+#include "audio/prefetching_stream.h"
 
 #include <mad.h>
 
@@ -549,6 +550,17 @@ SeekableAudioStream *makeMP3Stream(
 	}
 }
 
+SeekableAudioStream *makeMP3Stream(
+	Common::SeekableReadStream *stream,
+	DisposeAfterUse::Flag disposeAfterUse,
+	bool prefetch) {
+
+	SeekableAudioStream *s = makeMP3Stream(stream, disposeAfterUse);
+	if (s && prefetch)
+		s = makePrefetchingAudioStream(s);
+	return s;
+}
+
 PacketizedAudioStream *makePacketizedMP3Stream(Common::SeekableReadStream &firstPacket) {
 	return new PacketizedMP3Stream(firstPacket);
 }
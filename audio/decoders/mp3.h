@@ -67,6 +67,22 @@ SeekableAudioStream *makeMP3Stream(
 	Common::SeekableReadStream *stream,
 	DisposeAfterUse::Flag disposeAfterUse);
 
+/**
+ * Create a new SeekableAudioStream from the MP3 data in the given stream,
+ * optionally decoded ahead of the mixer.
+ *
+ * @param stream			the SeekableReadStream from which to read the MP3 data
+ * @param disposeAfterUse	whether to delete the stream after use
+ * @param prefetch			whether to decode the stream ahead on a worker thread,
+ *							see PrefetchingAudioStream. The stream must not be
+ *							shared, since it is then read from that thread.
+ * @return	a new SeekableAudioStream, or NULL, if an error occurred
+ */
+SeekableAudioStream *makeMP3Stream(
+	Common::SeekableReadStream *stream,
+	DisposeAfterUse::Flag disposeAfterUse,
+	bool prefetch);
+
 /**
  * Create a new PacketizedAudioStream from the first packet in the given
  * stream. It does not own the packet and must be queued again later.
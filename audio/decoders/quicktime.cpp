@@ -28,6 +28,7 @@
 #include "audio/decoders/codec.h"
 #include "audio/decoders/quicktime.h"
 #include "audio/decoders/quicktime_intern.h"
+#include "audio/prefetching_stream.h"
 
 // Codecs
 #include "audio/decoders/aac.h"
@@ -709,4 +710,18 @@ SeekableAudioStream *makeQuickTimeStream(Common::SeekableReadStream *stream, Dis
 	return audioStream;
 }
 
+SeekableAudioStream *makeQuickTimeStream(const Common::Path &filename, bool prefetch) {
+	SeekableAudioStream *audioStream = makeQuickTimeStream(filename);
+	if (audioStream && prefetch)
+		audioStream = makePrefetchingAudioStream(audioStream);
+	return audioStream;
+}
+
+SeekableAudioStream *makeQuickTimeStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, bool prefetch) {
+	SeekableAudioStream *audioStream = makeQuickTimeStream(stream, disposeAfterUse);
+	if (audioStream && prefetch)
+		audioStream = makePrefetchingAudioStream(audioStream);
+	return audioStream;
+}
+
 } // End of namespace Audio
@@ -63,6 +63,28 @@ SeekableAudioStream *makeQuickTimeStream(const Common::Path &filename);
  */
 SeekableAudioStream *makeQuickTimeStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse = DisposeAfterUse::YES);
 
+/**
+ * Try to load a QuickTime sound file from the given file name and create a SeekableAudioStream
+ * from that data, optionally decoded ahead of the mixer.
+ *
+ * @param filename          the filename of the file from which to read the data
+ * @param prefetch          whether to decode the stream ahead on a worker thread, see PrefetchingAudioStream
+ * @return  a new SeekableAudioStream, or NULL, if an error occurred
+ */
+SeekableAudioStream *makeQuickTimeStream(const Common::Path &filename, bool prefetch);
+
+/**
+ * Try to load a QuickTime sound file from the given seekable stream and create a SeekableAudioStream
+ * from that data, optionally decoded ahead of the mixer.
+ *
+ * @param stream            the SeekableReadStream from which to read the data
+ * @param disposeAfterUse   whether to delete the stream after use
+ * @param prefetch          whether to decode the stream ahead on a worker thread, see PrefetchingAudioStream.
+ *                          The stream must not be shared, since it is then read from that thread.
+ * @return  a new SeekableAudioStream, or NULL, if an error occurred
+ */
+SeekableAudioStream *makeQuickTimeStream(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse, bool prefetch);
+
 } // End of namespace Audio
 
 #endif
@@ -34,6 +34,7 @@
 #include "common/util.h"
 
 #include "audio/audiostream.h"
+#include "audio/prefetching_stream.h"
 
 #ifdef USE_TREMOR
 #ifdef USE_TREMOLO
@@ -251,6 +252,16 @@ SeekableAudioStream *makeVorbisStream(
 	}
 }
 
+SeekableAudioStream *makeVorbisStream(
+	Common::SeekableReadStream *stream,
+	DisposeAfterUse::Flag disposeAfterUse,
+	bool prefetch) {
+	SeekableAudioStream *s = makeVorbisStream(stream, disposeAfterUse);
+	if (s && prefetch)
+		s = makePrefetchingAudioStream(s);
+	return s;
+}
+
 } // End of namespace Audio
 
 #endif // #ifdef USE_VORBIS
@@ -67,6 +67,22 @@ SeekableAudioStream *makeVorbisStream(
 	Common::SeekableReadStream *stream,
 	DisposeAfterUse::Flag disposeAfterUse);
 
+/**
+ * Create a new SeekableAudioStream from the Ogg Vorbis data in the given stream,
+ * optionally decoded ahead of the mixer.
+ *
+ * @param stream			the SeekableReadStream from which to read the Ogg Vorbis data
+ * @param disposeAfterUse	whether to delete the stream after use
+ * @param prefetch			whether to decode the stream ahead on a worker thread,
+ *							see PrefetchingAudioStream. The stream must not be
+ *							shared, since it is then read from that thread.
+ * @return	a new SeekableAudioStream, or NULL, if an error occurred
+ */
+SeekableAudioStream *makeVorbisStream(
+	Common::SeekableReadStream *stream,
+	DisposeAfterUse::Flag disposeAfterUse,
+	bool prefetch);
+
 } // End of namespace Audio
 
 #endif // #ifdef USE_VORBIS
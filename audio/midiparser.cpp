@@ -50,7 +50,9 @@ _activeTrack(255),
 _abortParse(false),
 _jumpingToTick(false),
 _doParse(true),
-_pause(false) {
+_pause(false),
+_markerCallbackProc(nullptr),
+_markerCallbackData(nullptr) {
 	memset(_activeNotes, 0, sizeof(_activeNotes));
 	memset(_tracks, 0, sizeof(_tracks));
 	memset(_numSubtracks, 1, sizeof(_numSubtracks));
@@ -254,6 +256,9 @@ void MidiParser::onTimer() {
 			bool ret = processEvent(info);
 			if (!ret)
 				return;
+
+			if (info.marker >= 0 && _markerCallbackProc)
+				_markerCallbackProc((MarkerType)info.marker, info.markerIndex, _markerCallbackData);
 		}
 
 		loopEvent |= info.loop;
@@ -156,6 +156,8 @@ struct EventInfo {
 	bool   loop;   ///< Indicates that this event loops (part of) the MIDI data.
 	bool   noop;   ///< Indicates that no action should be taken for this event
 				   ///< (only delta should be handled).
+	int8   marker; ///< The MidiParser::MarkerType of the position this event marks, or -1.
+	byte   markerIndex; ///< For a kMarkerJumpIndex, the index number of the position.
 
 	byte channel() const { return event & 0x0F; } ///< Separates the MIDI channel from the event.
 	byte command() const { return event >> 4; }   ///< Separates the command code from the event.
@@ -171,6 +173,8 @@ struct EventInfo {
 		length = 0;
 		loop = false;
 		noop = false;
+		marker = -1;
+		markerIndex = 0;
 	}
 
 	EventInfo() : subtrack(0) { clear(); }
@@ -352,6 +356,19 @@ struct NoteTimer {
  * memory block containing the music data.)
  */
 class MidiParser {
+public:
+	/**
+	 * Positions in the MIDI data which playback may jump back to, reported
+	 * by the parser when they are played.
+	 */
+	enum MarkerType {
+		kMarkerLoopStart = 0, ///< The start of a loop which repeats forever, like an XMIDI FOR with a count of 0.
+		kMarkerLoopEnd   = 1, ///< The jump back to the start of that loop.
+		kMarkerJumpIndex = 2  ///< The position of a jump index, see jumpToIndex.
+	};
+
+	typedef void (*MarkerCallbackProc)(MarkerType type, byte index, void *refCon);
+
 protected:
 	static const uint8 MAXIMUM_TRACKS = 120;
 	static const uint8 MAXIMUM_SUBTRACKS = AUDIO_MIDIPARSER_MAXIMUM_SUBTRACKS;
@@ -391,6 +408,9 @@ protected:
 	bool   _doParse;       ///< True if the parser should be parsing; false if it should not be active
 	bool   _pause;		   ///< True if the parser has paused parsing
 
+	MarkerCallbackProc _markerCallbackProc; ///< Called when an event which marks a position is played.
+	void  *_markerCallbackData;
+
 	/**
 	 * The source number to use when sending MIDI messages to the driver.
 	 * When using multiple sources, use source 0 and higher. This must be
@@ -578,6 +598,15 @@ public:
 	 * points.
 	 */
 	virtual bool jumpToIndex(uint8 index, bool stopNotes = true) { return false; }
+	/**
+	 * Sets a function which is called each time an event marking a position
+	 * is played, e.g. to find out where the loops and jump indices are in a
+	 * recording of the playback. Only some formats have such events.
+	 */
+	void setMarkerCallback(MarkerCallbackProc proc, void *refCon) {
+		_markerCallbackProc = proc;
+		_markerCallbackData = refCon;
+	}
 
 	uint32 getPPQN() { return _ppqn; }
 	virtual uint32 getTick() { return _position._playTick; }
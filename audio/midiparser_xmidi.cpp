@@ -157,6 +157,7 @@ void MidiParser_XMIDI::parseNextEvent(EventInfo &info) {
 	info.start = playPos;
 	info.delta = readVLQ2(playPos);
 	info.loop = false;
+	info.marker = -1;
 
 	// Process the next event.
 	info.event = *(playPos++);
@@ -210,6 +211,8 @@ void MidiParser_XMIDI::parseNextEvent(EventInfo &info) {
 
 				_loop[_loopCount].pos = pos;
 				_loop[_loopCount].repeat = info.basic.param2;
+				if (!info.basic.param2)
+					info.marker = kMarkerLoopStart;
 				break;
 			}
 
@@ -230,6 +233,7 @@ void MidiParser_XMIDI::parseNextEvent(EventInfo &info) {
 					} else {
 						playPos = _loop[_loopCount].pos;
 						info.loop = true;
+						info.marker = kMarkerLoopEnd;
 					}
 				}
 			}
@@ -243,7 +247,10 @@ void MidiParser_XMIDI::parseNextEvent(EventInfo &info) {
 		case 0x78:	// XMIDI_CONTROLLER_SEQ_BRANCH_INDEX
 			// This controller marks a branch point. It is converted
 			// to an entry in the RBRN header by the XMIDI conversion
-			// tool. For playback it is unnecessary.
+			// tool. For playback it is unnecessary, but it tells
+			// where the branch is in a recording of the playback.
+			info.marker = kMarkerJumpIndex;
+			info.markerIndex = info.basic.param2;
 			break;
 
 		case 0x6e:	// XMIDI_CONTROLLER_CHAN_LOCK
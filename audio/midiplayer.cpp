@@ -21,8 +21,11 @@
 
 #include "audio/midiplayer.h"
 #include "audio/midiparser.h"
+#include "audio/midirender.h"
+#include "audio/softsynth/emumidi.h"
 
 #include "common/config-manager.h"
+#include "common/system.h"
 
 namespace Audio {
 
@@ -33,7 +36,10 @@ MidiPlayer::MidiPlayer() :
 	_isLooping(false),
 	_isPlaying(false),
 	_masterVolume(0),
-	_nativeMT32(false) {
+	_nativeMT32(false),
+	_device(0),
+	_renderedMarkers(nullptr),
+	_renderer(nullptr) {
 
 	memset(_channelsTable, 0, sizeof(_channelsTable));
 	memset(_channelsVolume, 127, sizeof(_channelsVolume));
@@ -47,6 +53,7 @@ MidiPlayer::~MidiPlayer() {
 	// Hopefully, this make no real difference, but we should
 	// watch out for regressions.
 	stop();
+	delete _renderer;
 
 	// Unhook & unload the driver
 	if (_driver) {
@@ -61,6 +68,7 @@ void MidiPlayer::createDriver(int flags) {
 	MidiDriver::DeviceHandle dev = MidiDriver::detectDevice(flags);
 	_nativeMT32 = ((MidiDriver::getMusicType(dev) == MT_MT32) || ConfMan.getBool("native_mt32"));
 
+	_device = dev;
 	_driver = MidiDriver::createMidi(dev);
 	assert(_driver);
 	if (_nativeMT32)
@@ -76,6 +84,8 @@ void MidiPlayer::setVolume(int volume) {
 	Common::StackLock lock(_mutex);
 
 	_masterVolume = volume;
+	if (_renderedMarkers)
+		g_system->getMixer()->setChannelVolume(_renderedHandle, _masterVolume);
 	for (int i = 0; i < kNumChannels; ++i) {
 		if (_channelsTable[i]) {
 			_channelsTable[i]->volume(_channelsVolume[i] * _masterVolume / 255);
@@ -154,11 +164,16 @@ void MidiPlayer::onTimer() {
 
 	if (_isPlaying && _parser) {
 		_parser->onTimer();
+	} else if (_isPlaying && _renderedMarkers && !g_system->getMixer()->isSoundHandleActive(_renderedHandle)) {
+		// The song from the render cache ended
+		_isPlaying = false;
 	}
 }
 
 
 void MidiPlayer::stop() {
+	stopCached();
+
 	Common::StackLock lock(_mutex);
 
 	_isPlaying = false;
@@ -183,12 +198,142 @@ void MidiPlayer::pause() {
 //	debugC(2, kDraciSoundDebugLevel, "Pausing track %d", _track);
 	_isPlaying = false;
 	setVolume(-1);	// FIXME: This should be 0, shouldn't it?
+	if (_renderedMarkers)
+		g_system->getMixer()->pauseHandle(_renderedHandle, true);
 }
 
 void MidiPlayer::resume() {
 //	debugC(2, kDraciSoundDebugLevel, "Resuming track %d", _track);
 	syncVolume();
+	if (_renderedMarkers)
+		g_system->getMixer()->pauseHandle(_renderedHandle, false);
 	_isPlaying = true;
 }
 
+bool MidiPlayer::playRendered(const byte *data, uint32 size, MidiParser *renderParser, bool loop, int track) {
+	assert(renderParser);
+	stop();
+
+	_isLooping = loop;
+
+	// Only the synths which are emulated can render faster than real time
+	if (!ConfMan.getBool("music_render_cache") || !dynamic_cast<MidiDriver_Emulated *>(_driver)) {
+		delete renderParser;
+		return false;
+	}
+
+	const Common::String key = MidiRenderer::getCacheKey(data, size, track, MidiDriver::getDeviceString(_device, MidiDriver::kDeviceId),
+	                                                     g_system->getMixer()->getOutputRate());
+	MidiRenderMarkers *markers = new MidiRenderMarkers();
+	if (!MidiRenderer::loadCachedMarkers(key, *markers)) {
+		delete markers;
+		startRendering(key, data, size, renderParser, track);
+		return false;
+	}
+	delete renderParser;
+
+	_renderedKey = key;
+	_renderedMarkers = markers;
+	if (!playCached(0)) {
+		stopCached();
+		return false;
+	}
+
+	Common::StackLock lock(_mutex);
+	_isPlaying = true;
+	return true;
+}
+
+void MidiPlayer::startRendering(const Common::String &key, const byte *data, uint32 size, MidiParser *renderParser, int track) {
+	// Render one song at a time: the others are rendered the next time
+	// they are played
+	if (_renderer) {
+		if (_renderer->isCaching()) {
+			delete renderParser;
+			return;
+		}
+		delete _renderer;
+		_renderer = nullptr;
+	}
+
+	MidiDriver *driver = MidiDriver::createMidi(_device);
+	MidiDriver_Emulated *synth = dynamic_cast<MidiDriver_Emulated *>(driver);
+	if (!synth) {
+		delete driver;
+		delete renderParser;
+		return;
+	}
+
+	synth->setOffline(true);
+	if (_nativeMT32)
+		synth->property(MidiDriver::PROP_CHANNEL_MASK, 0x03FE);
+	if (synth->open() != 0) {
+		delete synth;
+		delete renderParser;
+		return;
+	}
+
+	byte *songData = (byte *)malloc(size);
+	memcpy(songData, data, size);
+	_renderer = new MidiRenderer(synth, renderParser, songData, size, track);
+	if (!_renderer->startCaching(key)) {
+		delete _renderer;
+		_renderer = nullptr;
+	}
+}
+
+// The mixer calls onTimer() with its mutex locked, through the driver, so
+// the methods below are called without _mutex locked
+bool MidiPlayer::playCached(uint32 startFrame) {
+	AudioStream *stream = MidiRenderer::openCachedStream(_renderedKey, *_renderedMarkers, startFrame, _isLooping);
+	if (!stream)
+		return false;
+
+	Mixer *mixer = g_system->getMixer();
+	mixer->stopHandle(_renderedHandle);
+	mixer->playStream(Mixer::kPlainSoundType, &_renderedHandle, stream, -1, _masterVolume);
+
+	// The live synth has nothing to play meanwhile, but its timer still
+	// tells onTimer() when the song ends
+	((MidiDriver_Emulated *)_driver)->setIdle(true);
+	return true;
+}
+
+void MidiPlayer::stopCached() {
+	if (!_renderedMarkers)
+		return;
+
+	g_system->getMixer()->stopHandle(_renderedHandle);
+	((MidiDriver_Emulated *)_driver)->setIdle(false);
+
+	Common::StackLock lock(_mutex);
+	delete _renderedMarkers;
+	_renderedMarkers = nullptr;
+	_renderedKey.clear();
+}
+
+bool MidiPlayer::jumpToTick(uint32 tick) {
+	if (_parser) {
+		Common::StackLock lock(_mutex);
+		return _parser->jumpToTick(tick);
+	}
+	if (!_renderedMarkers)
+		return false;
+
+	const int32 frame = _renderedMarkers->getTickFrame(tick);
+	return frame >= 0 && playCached(frame);
+}
+
+bool MidiPlayer::jumpToIndex(uint8 index) {
+	if (_parser) {
+		Common::StackLock lock(_mutex);
+		return _parser->jumpToIndex(index);
+	}
+	if (!_renderedMarkers)
+		return false;
+
+	const int32 frame = _renderedMarkers->getJumpIndexFrame(index);
+	return frame >= 0 && playCached(frame);
+}
+
 } // End of namespace Audio
@@ -24,12 +24,17 @@
 
 #include "common/scummsys.h"
 #include "common/mutex.h"
+#include "common/str.h"
 #include "audio/mididrv.h"
+#include "audio/mixer.h"
 
 class MidiParser;
 
 namespace Audio {
 
+class MidiRenderer;
+struct MidiRenderMarkers;
+
 /**
  * @defgroup audio_midiplayer MIDI player
  * @ingroup audio
@@ -121,6 +126,44 @@ public:
 	// TODO: Document this
 	bool hasNativeMT32() const { return _nativeMT32; }
 
+	/**
+	 * Play a song from the music render cache, when the "music_render_cache"
+	 * option is set and the music device is a software synth (the MT-32 or
+	 * FluidSynth emulation). When the song was not rendered yet, it is
+	 * rendered in the background for the next time, and the caller should
+	 * play it live as usual. While the song is played from the cache, the
+	 * live synth is left idle.
+	 *
+	 * Call it without _mutex locked, since it stops the song played before
+	 * through the mixer.
+	 *
+	 * The song is rendered through a synth of its own, with the default
+	 * send() and sendToChannel(): only the songs which do not depend on
+	 * what the engine sends to the driver otherwise should be played this
+	 * way.
+	 *
+	 * @param data          The song data, which is copied.
+	 * @param size          Size of the song data.
+	 * @param renderParser  A new parser for the format of the song, which is
+	 *                      deleted by this method or the renderer.
+	 * @param loop          Whether to repeat the song.
+	 * @param track         Track of the song to play.
+	 * @return True if the song is played from the cache.
+	 */
+	bool playRendered(const byte *data, uint32 size, MidiParser *renderParser, bool loop, int track = 0);
+
+	/**
+	 * Jump to a tick of the song, whether it is played live or from the
+	 * render cache.
+	 */
+	bool jumpToTick(uint32 tick);
+
+	/**
+	 * Jump to a jump index of the song (see MidiParser::jumpToIndex),
+	 * whether it is played live or from the render cache.
+	 */
+	bool jumpToIndex(uint8 index);
+
 	// MidiDriver_BASE implementation
 	void send(uint32 b) override;
 	void metaEvent(byte type, byte *data, uint16 length) override;
@@ -148,6 +191,11 @@ protected:
 
 	void createDriver(int flags = MDT_MIDI | MDT_ADLIB | MDT_PREFER_GM);
 
+private:
+	void startRendering(const Common::String &key, const byte *data, uint32 size, MidiParser *renderParser, int track);
+	bool playCached(uint32 startFrame);
+	void stopCached();
+
 protected:
 	enum {
 		/**
@@ -187,6 +235,20 @@ protected:
 	int _masterVolume;	// FIXME: byte or int ?
 
 	bool _nativeMT32;
+
+	/** The device which createDriver() created the driver for. */
+	MidiDriver::DeviceHandle _device;
+
+	/**
+	 * The song played from the render cache: its name in the cache, and
+	 * its markers, which are set while it is played.
+	 */
+	Common::String _renderedKey;
+	MidiRenderMarkers *_renderedMarkers;
+	SoundHandle _renderedHandle;
+
+	/** The song rendered into the cache in the background, if any. */
+	MidiRenderer *_renderer;
 };
 
 /** @} */
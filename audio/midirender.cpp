@@ -0,0 +1,271 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/compression/deflate.h"
+#include "common/config-manager.h"
+#include "common/endian.h"
+#include "common/system.h"
+#include "common/thread.h"
+
+#include "audio/midirender.h"
+#include "audio/softsynth/emumidi.h"
+
+namespace Audio {
+
+MidiRenderer::MidiRenderer(MidiDriver_Emulated *driver, MidiParser *parser, byte *data, uint32 size, int track) :
+	_driver(driver),
+	_parser(parser),
+	_data(data),
+	_markers(nullptr),
+	_frame(0),
+	_endOfTrack(false),
+	_loopedBack(false),
+	_ticksLooped(false),
+	_thread(nullptr),
+	_cachePcm(nullptr) {
+	assert(_driver && _driver->isOpen() && _driver->isOffline());
+	assert(_parser);
+
+	memset(_channelsTable, 0, sizeof(_channelsTable));
+	_quit.store(0);
+	_done.store(0);
+
+	_parser->setMidiDriver(this);
+	_parser->property(MidiParser::mpAutoLoop, 0);
+	_parser->setMarkerCallback(markerCallback, this);
+	if (!_parser->loadMusic(_data, size) || !_parser->setTrack(track))
+		_parser->unloadMusic();
+}
+
+MidiRenderer::~MidiRenderer() {
+	if (_thread) {
+		_quit.store(1);
+		_thread->join();
+		delete _thread;
+	}
+	delete _cachePcm;
+
+	_parser->unloadMusic();
+	_parser->setMidiDriver(nullptr);
+	delete _parser;
+
+	for (int i = 0; i < kNumChannels; i++) {
+		if (_channelsTable[i])
+			_channelsTable[i]->release();
+	}
+	_driver->close();
+	delete _driver;
+
+	free(_data);
+}
+
+bool MidiRenderer::render(Common::WriteStream &pcm, MidiRenderMarkers &markers) {
+	markers.clear();
+	markers.rate = _driver->getRate();
+	markers.stereo = _driver->isStereo();
+
+	_markers = &markers;
+	_frame = 0;
+	_endOfTrack = false;
+	_loopedBack = false;
+	_ticksLooped = false;
+
+	// Call the parser at the same positions as the timer of the synth would,
+	// with the frames between two calls in 16.16 fixed point
+	const uint32 baseTempo = _driver->getBaseTempo();
+	const uint32 framesPerTimer = (uint32)(((uint64)markers.rate * baseTempo << 16) / 1000000);
+	const uint32 maxFrames = kMaxLength * markers.rate;
+	uint32 fraction = 0;
+	bool complete = true;
+
+	_parser->setTimerRate(baseTempo);
+	while (_parser->isPlaying()) {
+		if (_frame >= maxFrames || _quit.load()) {
+			complete = false;
+			break;
+		}
+
+		_parser->onTimer();
+		if (_loopedBack || _endOfTrack)
+			break;
+
+		const uint32 tick = _parser->getTick();
+		if (!_ticksLooped) {
+			if (markers.ticks.empty() || tick > markers.ticks.back().tick) {
+				MidiRenderMarkers::TickFrame tickFrame;
+				tickFrame.tick = tick;
+				tickFrame.frame = _frame;
+				markers.ticks.push_back(tickFrame);
+			} else if (tick < markers.ticks.back().tick) {
+				_ticksLooped = true;
+			}
+		}
+
+		fraction += framesPerTimer;
+		if (!renderFrames(pcm, fraction >> 16)) {
+			complete = false;
+			break;
+		}
+		fraction &= 0xFFFF;
+	}
+
+	if (complete && !_loopedBack) {
+		// The song ended: let the last notes fade out
+		if (!_endOfTrack)
+			markers.endFrame = _frame;
+		complete = renderFrames(pcm, (uint32)((uint64)kTailLength * markers.rate / 1000));
+	}
+
+	markers.numFrames = _frame;
+	_markers = nullptr;
+	return complete && markers.endFrame > 0;
+}
+
+bool MidiRenderer::renderFrames(Common::WriteStream &pcm, uint32 numFrames) {
+	const int channels = _driver->isStereo() ? 2 : 1;
+
+	while (numFrames) {
+		if (_quit.load())
+			return false;
+
+		const uint32 frames = MIN<uint32>(numFrames, kChunkFrames);
+		const int samples = frames * channels;
+		_driver->readBuffer(_chunk, samples);
+#ifdef SCUMM_BIG_ENDIAN
+		for (int i = 0; i < samples; i++)
+			WRITE_LE_INT16(&_chunk[i], _chunk[i]);
+#endif
+		if (pcm.write(_chunk, samples * 2) != (uint32)samples * 2)
+			return false;
+
+		_frame += frames;
+		numFrames -= frames;
+	}
+	return true;
+}
+
+void MidiRenderer::send(uint32 b) {
+	// Like MidiPlayer, at full master volume
+	const byte ch = (byte)(b & 0x0F);
+	if ((b & 0xFFF0) == 0x007BB0 && !_channelsTable[ch])
+		return;
+
+	if (!_channelsTable[ch])
+		_channelsTable[ch] = (ch == 9) ? _driver->getPercussionChannel() : _driver->allocateChannel();
+	if (_channelsTable[ch])
+		_channelsTable[ch]->send(b);
+}
+
+void MidiRenderer::metaEvent(byte type, byte *data, uint16 length) {
+	if (type == 0x2F && _markers && !_endOfTrack) {
+		_endOfTrack = true;
+		_markers->endFrame = _frame;
+	}
+}
+
+void MidiRenderer::markerCallback(MidiParser::MarkerType type, byte index, void *refCon) {
+	MidiRenderer *renderer = (MidiRenderer *)refCon;
+	MidiRenderMarkers *markers = renderer->_markers;
+	if (!markers)
+		return;
+
+	switch (type) {
+	case MidiParser::kMarkerLoopStart:
+		if (markers->loopStartFrame < 0)
+			markers->loopStartFrame = renderer->_frame;
+		break;
+	case MidiParser::kMarkerLoopEnd:
+		// The rest would repeat the loop forever
+		if (markers->loopStartFrame >= 0 && (uint32)markers->loopStartFrame < renderer->_frame) {
+			renderer->_loopedBack = true;
+			markers->endFrame = renderer->_frame;
+		}
+		break;
+	case MidiParser::kMarkerJumpIndex:
+		if (markers->getJumpIndexFrame(index) < 0) {
+			MidiRenderMarkers::JumpIndexFrame jumpIndex;
+			jumpIndex.index = index;
+			jumpIndex.frame = renderer->_frame;
+			markers->jumpIndices.push_back(jumpIndex);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+bool MidiRenderer::startCaching(const Common::String &key) {
+	assert(!_thread);
+
+	const int maxSize = ConfMan.getInt("music_render_cache_size");
+	if (maxSize > 0)
+		purgeCache((uint64)maxSize * 1024 * 1024);
+
+	const Common::FSNode pcmFile = getCacheFile(key, "pcm");
+	Common::FSNode dir = pcmFile.getParent();
+	if (!dir.exists() && !dir.createDirectory()) {
+		warning("Unable to create the music render cache directory '%s'", dir.getPath().toString(Common::Path::kNativeSeparator).c_str());
+		return false;
+	}
+
+	_cachePcm = Common::wrapCompressedWriteStream(pcmFile.createWriteStream());
+	if (!_cachePcm) {
+		warning("Unable to write music render cache '%s'", pcmFile.getPath().toString(Common::Path::kNativeSeparator).c_str());
+		return false;
+	}
+	_cacheMarkersFile = getCacheFile(key, "markers");
+	markCacheUsed(key);
+
+	_thread = g_system->createThread(threadProc, this);
+	if (!_thread) {
+		delete _cachePcm;
+		_cachePcm = nullptr;
+		return false;
+	}
+	return true;
+}
+
+void MidiRenderer::threadProc(void *data) {
+	((MidiRenderer *)data)->cache();
+}
+
+void MidiRenderer::cache() {
+	MidiRenderMarkers markers;
+	bool complete = render(*_cachePcm, markers);
+
+	_cachePcm->finalize();
+	complete = complete && !_cachePcm->err();
+	delete _cachePcm;
+	_cachePcm = nullptr;
+
+	// The markers are written last, since they tell that the samples are complete
+	if (complete) {
+		Common::ScopedPtr<Common::WriteStream> stream(Common::wrapCompressedWriteStream(_cacheMarkersFile.createWriteStream()));
+		if (stream) {
+			markers.save(*stream);
+			stream->finalize();
+		}
+	}
+
+	_done.store(1);
+}
+
+} // End of namespace Audio
@@ -0,0 +1,252 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AUDIO_MIDIRENDER_H
+#define AUDIO_MIDIRENDER_H
+
+#include "common/array.h"
+#include "common/atomic.h"
+#include "common/fs.h"
+#include "common/noncopyable.h"
+#include "common/scummsys.h"
+#include "common/str.h"
+
+#include "audio/mididrv.h"
+#include "audio/midiparser.h"
+
+class MidiDriver_Emulated;
+
+namespace Common {
+class ReadStream;
+class ThreadInternal;
+class WriteStream;
+}
+
+namespace Audio {
+
+class AudioStream;
+
+/**
+ * @defgroup audio_midirender MIDI render cache
+ * @ingroup audio
+ *
+ * @brief Rendering of MIDI songs to PCM ahead of time.
+ * @{
+ */
+
+/**
+ * The positions of a song in its rendering, in sample frames.
+ */
+struct MidiRenderMarkers {
+	struct TickFrame {
+		uint32 tick;
+		uint32 frame;
+	};
+
+	struct JumpIndexFrame {
+		byte index;
+		uint32 frame;
+	};
+
+	int rate;
+	bool stereo;
+
+	/** Length of the rendering, with the release of the last notes. */
+	uint32 numFrames;
+	/**
+	 * Position of the end of the track, or of the jump back of the loop
+	 * which repeats forever.
+	 */
+	uint32 endFrame;
+	/** Start of the loop which repeats forever, or -1 if the song ends. */
+	int32 loopStartFrame;
+
+	/**
+	 * The frame at which each tick is played, up to the first loop, after
+	 * which the parser counts the ticks from 0 again.
+	 */
+	Common::Array<TickFrame> ticks;
+	/** The frame at which each jump index is first played. */
+	Common::Array<JumpIndexFrame> jumpIndices;
+
+	MidiRenderMarkers() { clear(); }
+
+	void clear();
+
+	/** @return The frame at which @p tick is played, or -1 if it is not known. */
+	int32 getTickFrame(uint32 tick) const;
+
+	/** @return The frame of the jump index @p index, or -1 if it is not known. */
+	int32 getJumpIndexFrame(byte index) const;
+
+	void save(Common::WriteStream &stream) const;
+	bool load(Common::ReadStream &stream);
+};
+
+/**
+ * Renders a MIDI song to PCM through a software synth, as fast as the CPU
+ * allows, so that the song can be played from the render cache afterwards
+ * instead of running the synth live.
+ *
+ * The render cache lives in the "musiccache" directory next to the
+ * configuration file, unless the "music_render_cache_path" setting points
+ * somewhere else. Each song is stored as two files: the compressed
+ * samples, and the markers, which are written last and tell that the
+ * rendering is complete. An index keeps the songs in the order in which
+ * they were last used, and the least recently used ones are removed when
+ * the cache grows over the "music_render_cache_size" setting, in MB.
+ *
+ * The song is sent to the synth the way MidiPlayer does by default: the
+ * parser is driven at the timer rate of the synth, with the channels of the
+ * song allocated from the synth, and with auto-looping disabled. The
+ * renderer follows the markers reported by the parser, and stops at the
+ * end of the track or when a loop which repeats forever jumps back.
+ */
+class MidiRenderer : public MidiDriver_BASE, Common::NonCopyable {
+public:
+	/**
+	 * Create a renderer.
+	 *
+	 * @param driver  Software synth, opened with setOffline(true). It is
+	 *                closed and deleted with the renderer.
+	 * @param parser  Parser for the format of the song, which is deleted
+	 *                with the renderer.
+	 * @param data    The song data, allocated with malloc(), which is freed
+	 *                with the renderer.
+	 * @param size    Size of the song data.
+	 * @param track   Track of the song to render.
+	 */
+	MidiRenderer(MidiDriver_Emulated *driver, MidiParser *parser, byte *data, uint32 size, int track);
+
+	/** Stop caching, if the song is still being rendered in the background. */
+	~MidiRenderer();
+
+	/**
+	 * Render the song on the calling thread.
+	 *
+	 * @param pcm      Receives the samples, as little endian 16-bit values.
+	 * @param markers  Receives the positions of the song.
+	 * @return False if the song could not be loaded, is longer than
+	 *         kMaxLength, or the rendering was stopped.
+	 */
+	bool render(Common::WriteStream &pcm, MidiRenderMarkers &markers);
+
+	/**
+	 * Render the song into the render cache on a thread of its own, after
+	 * making room for it in the cache.
+	 *
+	 * @return False if the backend does not support threads, or the cache
+	 *         files could not be created.
+	 */
+	bool startCaching(const Common::String &key);
+
+	/** Return true while the song is rendered into the cache. */
+	bool isCaching() const { return _thread && !_done.load(); }
+
+	/**
+	 * Get the name under which a song is cached, from a hash of its data and
+	 * of the settings of the device which renders it.
+	 *
+	 * @param deviceId    Identifier of the device, see MidiDriver::getDeviceString.
+	 * @param outputRate  Output rate of the mixer, which the synths may render at.
+	 */
+	static Common::String getCacheKey(const byte *data, uint32 size, int track, const Common::String &deviceId, uint outputRate);
+
+	/**
+	 * Load the markers of a cached song, and mark it as the most recently
+	 * used one.
+	 *
+	 * @return False if the song is not in the cache, or is being rendered.
+	 */
+	static bool loadCachedMarkers(const Common::String &key, MidiRenderMarkers &markers);
+
+	/**
+	 * Open a stream of a cached song.
+	 *
+	 * @param key         Name of the song in the cache.
+	 * @param markers     Markers of the song, as loaded by loadCachedMarkers().
+	 * @param startFrame  Position to start playing at.
+	 * @param loop        Whether to repeat the whole song. A song with a loop
+	 *                    which repeats forever repeats that loop anyway.
+	 * @return The stream, or nullptr if the samples could not be read.
+	 */
+	static AudioStream *openCachedStream(const Common::String &key, const MidiRenderMarkers &markers,
+	                                     uint32 startFrame, bool loop);
+
+	/** Get the directory of the render cache, which may not exist yet. */
+	static Common::FSNode getCacheDirectory();
+
+	/** Get one of the files of a cached song, "pcm" or "markers". */
+	static Common::FSNode getCacheFile(const Common::String &key, const char *extension);
+
+	/**
+	 * Remove the least recently used songs from the render cache, until
+	 * its files take at most @p maxSize bytes. A size of 0 empties it.
+	 */
+	static void purgeCache(uint64 maxSize);
+
+	// MidiDriver_BASE implementation
+	void send(uint32 b) override;
+	void metaEvent(byte type, byte *data, uint16 length) override;
+
+private:
+	enum {
+		/** Longest song which is rendered, in seconds. */
+		kMaxLength = 20 * 60,
+		/** Time given to the last notes to fade out, in milliseconds. */
+		kTailLength = 2000,
+		/** Number of frames rendered at a time. */
+		kChunkFrames = 1024,
+		kNumChannels = 16
+	};
+
+	static void markCacheUsed(const Common::String &key);
+
+	static void markerCallback(MidiParser::MarkerType type, byte index, void *refCon);
+	static void threadProc(void *data);
+	void cache();
+
+	bool renderFrames(Common::WriteStream &pcm, uint32 numFrames);
+
+	MidiDriver_Emulated *_driver;
+	MidiParser *_parser;
+	byte *_data;
+	MidiChannel *_channelsTable[kNumChannels];
+
+	/** The markers of the song being rendered, and the current position. */
+	MidiRenderMarkers *_markers;
+	uint32 _frame;
+	bool _endOfTrack;
+	bool _loopedBack;
+	bool _ticksLooped;
+
+	Common::ThreadInternal *_thread;
+	Common::Atomic<uint32> _quit;
+	Common::Atomic<uint32> _done;
+	Common::WriteStream *_cachePcm;
+	Common::FSNode _cacheMarkersFile;
+	int16 _chunk[kChunkFrames * 2];
+};
+
+/** @} */
+} // End of namespace Audio
+
+#endif
@@ -0,0 +1,370 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/algorithm.h"
+#include "common/compression/deflate.h"
+#include "common/config-manager.h"
+#include "common/endian.h"
+#include "common/hashmap.h"
+#include "common/md5.h"
+#include "common/memstream.h"
+#include "common/ptr.h"
+#include "common/str-array.h"
+#include "common/system.h"
+
+#include "audio/audiostream.h"
+#include "audio/decoders/raw.h"
+#include "audio/midirender.h"
+
+// The render cache, which does not depend on the synths
+
+namespace Audio {
+
+#define MIDI_RENDER_CACHE_DIRECTORY "musiccache"
+// The keys of the cached songs, from the least recently used
+#define MIDI_RENDER_CACHE_INDEX "index"
+
+enum {
+	kMidiRenderCacheVersion = 1
+};
+
+void MidiRenderMarkers::clear() {
+	rate = 0;
+	stereo = false;
+	numFrames = 0;
+	endFrame = 0;
+	loopStartFrame = -1;
+	ticks.clear();
+	jumpIndices.clear();
+}
+
+int32 MidiRenderMarkers::getTickFrame(uint32 tick) const {
+	// The events up to each tick are played at the frame of that tick
+	uint lo = 0, hi = ticks.size();
+	while (lo < hi) {
+		const uint mid = (lo + hi) / 2;
+		if (ticks[mid].tick < tick)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo < ticks.size() ? (int32)ticks[lo].frame : -1;
+}
+
+int32 MidiRenderMarkers::getJumpIndexFrame(byte index) const {
+	for (uint i = 0; i < jumpIndices.size(); i++) {
+		if (jumpIndices[i].index == index)
+			return jumpIndices[i].frame;
+	}
+	return -1;
+}
+
+void MidiRenderMarkers::save(Common::WriteStream &stream) const {
+	stream.writeUint32BE(MKTAG('M', 'R', 'N', 'D'));
+	stream.writeUint32LE(kMidiRenderCacheVersion);
+	stream.writeUint32LE(rate);
+	stream.writeByte(stereo ? 1 : 0);
+	stream.writeUint32LE(numFrames);
+	stream.writeUint32LE(endFrame);
+	stream.writeSint32LE(loopStartFrame);
+
+	stream.writeUint32LE(ticks.size());
+	for (uint i = 0; i < ticks.size(); i++) {
+		stream.writeUint32LE(ticks[i].tick);
+		stream.writeUint32LE(ticks[i].frame);
+	}
+
+	stream.writeUint32LE(jumpIndices.size());
+	for (uint i = 0; i < jumpIndices.size(); i++) {
+		stream.writeByte(jumpIndices[i].index);
+		stream.writeUint32LE(jumpIndices[i].frame);
+	}
+}
+
+bool MidiRenderMarkers::load(Common::ReadStream &stream) {
+	clear();
+	if (stream.readUint32BE() != MKTAG('M', 'R', 'N', 'D') || stream.readUint32LE() != kMidiRenderCacheVersion)
+		return false;
+
+	rate = stream.readUint32LE();
+	stereo = stream.readByte() != 0;
+	numFrames = stream.readUint32LE();
+	endFrame = stream.readUint32LE();
+	loopStartFrame = stream.readSint32LE();
+
+	uint32 count = stream.readUint32LE();
+	for (uint32 i = 0; i < count && !stream.eos(); i++) {
+		TickFrame tick;
+		tick.tick = stream.readUint32LE();
+		tick.frame = stream.readUint32LE();
+		ticks.push_back(tick);
+	}
+
+	count = stream.readUint32LE();
+	for (uint32 i = 0; i < count && !stream.eos(); i++) {
+		JumpIndexFrame jumpIndex;
+		jumpIndex.index = stream.readByte();
+		jumpIndex.frame = stream.readUint32LE();
+		jumpIndices.push_back(jumpIndex);
+	}
+
+	if (stream.err() || stream.eos() || rate <= 0 || !endFrame || endFrame > numFrames ||
+	    loopStartFrame >= (int32)endFrame) {
+		clear();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Plays the samples of a cached song, from a position, and repeats the loop
+ * of the song if it has one.
+ */
+class CachedMidiStream : public AudioStream {
+public:
+	CachedMidiStream(SeekableAudioStream *parent, uint32 pos, uint32 numFrames, bool loop, uint32 loopStart, uint32 loopEnd) :
+		_parent(parent), _pos(pos), _numFrames(numFrames), _loop(loop), _loopStart(loopStart), _loopEnd(loopEnd) {}
+
+	int readBuffer(int16 *buffer, const int numSamples) override {
+		const int channels = isStereo() ? 2 : 1;
+		int samples = 0;
+
+		while (samples < numSamples) {
+			if (_loop && _pos >= _loopEnd) {
+				if (!_parent->seek(Timestamp(0, _loopStart, getRate()))) {
+					_loop = false;
+					break;
+				}
+				_pos = _loopStart;
+			}
+
+			const uint32 end = _loop ? _loopEnd : _numFrames;
+			if (_pos >= end)
+				break;
+
+			const int read = _parent->readBuffer(buffer + samples, MIN<uint32>(numSamples - samples, (end - _pos) * channels));
+			if (read <= 0) {
+				// The file is shorter than its markers tell
+				_loop = false;
+				_numFrames = _pos;
+				break;
+			}
+
+			samples += read;
+			_pos += read / channels;
+		}
+
+		return samples;
+	}
+
+	bool isStereo() const override { return _parent->isStereo(); }
+	int getRate() const override { return _parent->getRate(); }
+	bool endOfData() const override { return !_loop && _pos >= _numFrames; }
+
+private:
+	Common::ScopedPtr<SeekableAudioStream> _parent;
+	uint32 _pos;
+	uint32 _numFrames;
+	bool _loop;
+	uint32 _loopStart;
+	uint32 _loopEnd;
+};
+
+static Common::StringArray loadCacheIndex(const Common::FSNode &dir) {
+	Common::StringArray keys;
+	const Common::FSNode file = dir.getChild(MIDI_RENDER_CACHE_INDEX);
+	if (!file.exists())
+		return keys;
+
+	Common::ScopedPtr<Common::SeekableReadStream> stream(file.createReadStream());
+	while (stream && !stream->eos() && !stream->err()) {
+		const Common::String key = stream->readLine();
+		if (!key.empty())
+			keys.push_back(key);
+	}
+	return keys;
+}
+
+static void saveCacheIndex(const Common::FSNode &dir, const Common::StringArray &keys) {
+	Common::ScopedPtr<Common::WriteStream> stream(dir.getChild(MIDI_RENDER_CACHE_INDEX).createWriteStream());
+	if (!stream)
+		return;
+
+	for (uint i = 0; i < keys.size(); i++)
+		stream->writeString(keys[i] + "\n");
+	stream->finalize();
+}
+
+static uint64 getCacheFileSize(const Common::FSNode &file) {
+	int64 size, modificationTime;
+	if (file.getFileStat(size, modificationTime))
+		return size;
+
+	Common::ScopedPtr<Common::SeekableReadStream> stream(file.createReadStream());
+	return stream ? stream->size() : 0;
+}
+
+Common::FSNode MidiRenderer::getCacheDirectory() {
+	const Common::Path path = ConfMan.getPath("music_render_cache_path");
+	if (!path.empty())
+		return Common::FSNode(path);
+
+	Common::Path configFile = ConfMan.getCustomConfigFileName();
+	if (configFile.empty())
+		configFile = g_system->getDefaultConfigFileName();
+	return Common::FSNode(configFile).getParent().getChild(MIDI_RENDER_CACHE_DIRECTORY);
+}
+
+Common::FSNode MidiRenderer::getCacheFile(const Common::String &key, const char *extension) {
+	return getCacheDirectory().getChild(key + "." + extension);
+}
+
+void MidiRenderer::markCacheUsed(const Common::String &key) {
+	const Common::FSNode dir = getCacheDirectory();
+	if (!dir.isDirectory())
+		return;
+
+	Common::StringArray keys = loadCacheIndex(dir);
+	for (uint i = 0; i < keys.size(); i++) {
+		if (keys[i] == key) {
+			if (i == keys.size() - 1)
+				return;
+			keys.remove_at(i);
+			break;
+		}
+	}
+	keys.push_back(key);
+	saveCacheIndex(dir, keys);
+}
+
+void MidiRenderer::purgeCache(uint64 maxSize) {
+	const Common::FSNode dir = getCacheDirectory();
+	Common::FSList files;
+	if (!dir.isDirectory() || !dir.getChildren(files, Common::FSNode::kListFilesOnly))
+		return;
+
+	// The size of the files of each song
+	typedef Common::HashMap<Common::String, uint64> SizeMap;
+	SizeMap sizes;
+	uint64 totalSize = 0;
+	for (Common::FSList::const_iterator file = files.begin(); file != files.end(); ++file) {
+		const Common::String name = file->getName();
+		if (!name.hasSuffix(".pcm") && !name.hasSuffix(".markers"))
+			continue;
+
+		const uint64 size = getCacheFileSize(*file);
+		sizes[Common::String(name.c_str(), name.findLastOf('.'))] += size;
+		totalSize += size;
+	}
+
+	// The songs missing from the index, which are left from an older cache,
+	// are evicted first, then the least recently used ones
+	const Common::StringArray index = loadCacheIndex(dir);
+	Common::StringArray keys;
+	for (SizeMap::const_iterator song = sizes.begin(); song != sizes.end(); ++song) {
+		if (Common::find(index.begin(), index.end(), song->_key) == index.end())
+			keys.push_back(song->_key);
+	}
+	for (uint i = 0; i < index.size(); i++) {
+		if (sizes.contains(index[i]))
+			keys.push_back(index[i]);
+	}
+
+	uint evicted = 0;
+	while (evicted < keys.size() && totalSize > maxSize) {
+		const Common::String &key = keys[evicted++];
+		getCacheFile(key, "markers").removeFile();
+		getCacheFile(key, "pcm").removeFile();
+		totalSize -= sizes[key];
+	}
+
+	// The songs which are left are all in the index from now on
+	if (evicted || keys.size() != index.size())
+		saveCacheIndex(dir, Common::StringArray(keys.begin() + evicted, keys.size() - evicted));
+}
+
+Common::String MidiRenderer::getCacheKey(const byte *data, uint32 size, int track, const Common::String &deviceId, uint outputRate) {
+	// The settings which change the sound of the synths
+	static const char *const settingKeys[] = {
+		"midi_gain", "native_mt32", "soundfont",
+		"fluidsynth_chorus_activate", "fluidsynth_chorus_nr", "fluidsynth_chorus_level",
+		"fluidsynth_chorus_speed", "fluidsynth_chorus_depth", "fluidsynth_chorus_waveform",
+		"fluidsynth_reverb_activate", "fluidsynth_reverb_roomsize", "fluidsynth_reverb_damping",
+		"fluidsynth_reverb_width", "fluidsynth_reverb_level", "fluidsynth_misc_interpolation"
+	};
+
+	Common::String settings = Common::String::format("%s;%d;%u", deviceId.c_str(), track, outputRate);
+	for (uint i = 0; i < ARRAYSIZE(settingKeys); i++) {
+		if (ConfMan.hasKey(settingKeys[i]))
+			settings += Common::String::format(";%s=%s", settingKeys[i], ConfMan.get(settingKeys[i]).c_str());
+	}
+
+	Common::MemoryReadStream dataStream(data, size);
+	Common::MemoryReadStream settingsStream((const byte *)settings.c_str(), settings.size());
+	const Common::String settingsHash = Common::computeStreamMD5AsString(settingsStream);
+	return Common::computeStreamMD5AsString(dataStream) + "-" + Common::String(settingsHash.c_str(), 8);
+}
+
+bool MidiRenderer::loadCachedMarkers(const Common::String &key, MidiRenderMarkers &markers) {
+	const Common::FSNode file = getCacheFile(key, "markers");
+	if (!file.exists())
+		return false;
+
+	Common::ScopedPtr<Common::SeekableReadStream> stream(Common::wrapCompressedReadStream(file.createReadStream()));
+	if (!stream || !markers.load(*stream))
+		return false;
+
+	markCacheUsed(key);
+	return true;
+}
+
+AudioStream *MidiRenderer::openCachedStream(const Common::String &key, const MidiRenderMarkers &markers,
+                                            uint32 startFrame, bool loop) {
+	const uint32 size = markers.numFrames * (markers.stereo ? 4 : 2);
+	Common::SeekableReadStream *pcm = Common::wrapCompressedReadStream(getCacheFile(key, "pcm").createReadStream(),
+	                                                                   DisposeAfterUse::YES, size);
+	if (!pcm || pcm->size() != size) {
+		delete pcm;
+		return nullptr;
+	}
+
+	byte flags = FLAG_16BITS | FLAG_LITTLE_ENDIAN;
+	if (markers.stereo)
+		flags |= FLAG_STEREO;
+	SeekableAudioStream *stream = makeRawStream(pcm, markers.rate, flags);
+
+	uint32 loopStart = 0;
+	if (markers.loopStartFrame >= 0) {
+		loop = true;
+		loopStart = markers.loopStartFrame;
+	}
+
+	if (startFrame >= markers.numFrames || (loop && startFrame >= markers.endFrame))
+		startFrame = 0;
+	if (startFrame && !stream->seek(Timestamp(0, startFrame, markers.rate))) {
+		delete stream;
+		return nullptr;
+	}
+
+	return new CachedMidiStream(stream, startFrame, markers.numFrames, loop, loopStart, markers.endFrame);
+}
+
+} // End of namespace Audio
@@ -21,11 +21,13 @@
 
 #include "gui/EventRecorder.h"
 
+#include "common/profiler.h"
 #include "common/util.h"
 #include "common/textconsole.h"
 
 #include "audio/mixer_intern.h"
 #include "audio/rate.h"
+#include "audio/rate_kernels.h"
 #include "audio/audiostream.h"
 #include "audio/timestamp.h"
 
@@ -46,15 +48,15 @@ public:
 	~Channel();
 
 	/**
-	 * Mixes the channel's samples into the given buffer.
+	 * Mixes the channel's samples into the given mixing bus, without clipping.
 	 *
-	 * @param data buffer where to mix the data
+	 * @param data mixing bus where to mix the data
 	 * @param len  number of sample *pairs*. So a value of
-	 *             10 means that the buffer contains twice 10 sample, each
-	 *             16 bits, for a total of 40 bytes.
+	 *             10 means that the bus contains twice 10 sample, each
+	 *             32 bits, for a total of 80 bytes.
 	 * @return number of sample pairs processed (which can still be silence!)
 	 */
-	int mix(int16 *data, uint len);
+	int mix(int32 *data, uint len);
 
 	/**
 	 * Queries whether the channel is still playing or not.
@@ -98,7 +100,7 @@ public:
 	 *
 	 * @return volume
 	 */
-	byte getVolume();
+	byte getVolume() const;
 
 	/**
 	 * Sets the channel's balance setting.
@@ -112,7 +114,7 @@ public:
 	 *
 	 * @return balance
 	 */
-	int8 getBalance();
+	int8 getBalance() const;
 
 	/**
 	 * Set the channel's sample rate.
@@ -126,7 +128,7 @@ public:
 	 * 
 	 * @return The current sample rate of the channel.
 	*/
-	uint32 getRate();
+	uint32 getRate() const;
 
 	/**
 	 * Reset the sample rate of the channel back to its
@@ -141,9 +143,17 @@ public:
 	void notifyGlobalVolChange() { updateChannelVolumes(); }
 
 	/**
-	 * Queries how long the channel has been playing.
+	 * Queries the timing information getElapsedTime() is computed from.
 	 */
-	Timestamp getElapsedTime();
+	uint32 getSamplesConsumed() const { return _samplesConsumed; }
+	uint32 getMixerTimeStamp() const { return _mixerTimeStamp; }
+	uint32 getPauseStartTime() const { return _pauseStartTime; }
+	uint32 getPauseTime() const { return _pauseTime; }
+
+	/**
+	 * Queries the sample rate of the channel's AudioStream.
+	 */
+	uint32 getStreamRate() const { return _stream->getRate(); }
 
 	/**
 	 * Replaces the channel's stream with a version that loops indefinitely.
@@ -201,8 +211,14 @@ MixerImpl::MixerImpl(uint sampleRate, bool stereo, uint outBufSize)
 
 	assert(sampleRate > 0);
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	// Avoid allocating in the audio callback, as long as the backend asks
+	// for the buffer size it announced
+	_mixBus.resize(outBufSize * (stereo ? 2 : 1));
+
+	for (int i = 0; i != NUM_CHANNELS; i++) {
 		_channels[i] = nullptr;
+		_channelStatus[i].handle.store(SoundHandle()._val);
+	}
 }
 
 MixerImpl::~MixerImpl() {
@@ -211,9 +227,7 @@ MixerImpl::~MixerImpl() {
 }
 
 void MixerImpl::setReady(bool ready) {
-	Common::StackLock lock(_mutex);
-
-	_mixerReady = ready;
+	_mixerReady.store(ready);
 }
 
 uint MixerImpl::getOutputRate() const {
@@ -251,6 +265,83 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 	_handleSeed++;
 	if (handle)
 		*handle = chanHandle;
+
+	Common::StackLock statusLock(_commandMutex);
+	updateChannelStatus(index, true);
+}
+
+void MixerImpl::deleteChannel(int index) {
+	delete _channels[index];
+	_channels[index] = nullptr;
+
+	Common::StackLock statusLock(_commandMutex);
+	updateChannelStatus(index, false);
+}
+
+void MixerImpl::updateChannelStatus(int index, bool settings) {
+	ChannelStatus &status = _channelStatus[index];
+	const Channel *chan = _channels[index];
+
+	status.sequence.fetchAdd(1);
+
+	if (!chan) {
+		status.handle.store(SoundHandle()._val);
+	} else {
+		status.handle.store(chan->getHandle()._val);
+		status.id.store(chan->getId());
+		status.type.store(chan->getType());
+
+		if (settings) {
+			status.volume.store(chan->getVolume());
+			status.balance.store(chan->getBalance());
+			status.rate.store(chan->getRate());
+			status.streamRate.store(chan->getStreamRate());
+		}
+
+		status.paused.store(chan->isPaused());
+		status.samplesConsumed.store(chan->getSamplesConsumed());
+		status.mixerTimeStamp.store(chan->getMixerTimeStamp());
+		status.pauseStartTime.store(chan->getPauseStartTime());
+		status.pauseTime.store(chan->getPauseTime());
+	}
+
+	status.sequence.fetchAdd(1);
+}
+
+bool MixerImpl::readChannelStatus(int index, ChannelSnapshot &snapshot) const {
+	const ChannelStatus &status = _channelStatus[index];
+
+	for (int tries = 0; tries < 64; tries++) {
+		const uint32 sequence = status.sequence.load();
+		if (sequence & 1)
+			continue;
+
+		snapshot.handle = status.handle.load();
+		snapshot.id = status.id.load();
+		snapshot.type = (SoundType)status.type.load();
+		snapshot.volume = status.volume.load();
+		snapshot.balance = status.balance.load();
+		snapshot.rate = status.rate.load();
+		snapshot.streamRate = status.streamRate.load();
+		snapshot.paused = status.paused.load() != 0;
+		snapshot.samplesConsumed = status.samplesConsumed.load();
+		snapshot.mixerTimeStamp = status.mixerTimeStamp.load();
+		snapshot.pauseStartTime = status.pauseStartTime.load();
+		snapshot.pauseTime = status.pauseTime.load();
+
+		if (status.sequence.load() == sequence)
+			return snapshot.handle != SoundHandle()._val;
+	}
+
+	// The thread updating the status must have been preempted. Wait for it
+	// instead of spinning any longer.
+	Common::StackLock lock(_commandMutex);
+	return readChannelStatus(index, snapshot);
+}
+
+bool MixerImpl::readChannelStatus(SoundHandle handle, ChannelSnapshot &snapshot) const {
+	const int index = handle._val % NUM_CHANNELS;
+	return readChannelStatus(index, snapshot) && snapshot.handle == handle._val;
 }
 
 void MixerImpl::playStream(
@@ -269,7 +360,7 @@ void MixerImpl::playStream(
 	}
 
 
-	assert(_mixerReady);
+	assert(isReady());
 
 	// Prevent duplicate sounds
 	if (id != -1) {
@@ -299,6 +390,7 @@ void MixerImpl::playStream(
 }
 
 int MixerImpl::mixCallback(byte *samples, uint len) {
+	PROFILE_ZONE("MixerImpl::mixCallback");
 	assert(samples);
 
 	Common::StackLock lock(_mutex);
@@ -306,10 +398,10 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	int16 *buf = (int16 *)samples;
 
 	// Since the mixer callback has been called, the mixer must be ready...
-	_mixerReady = true;
+	_mixerReady.store(true);
 
-	//  zero the buf
-	memset(buf, 0, len);
+	// Apply the channel setting changes made since the last callback
+	processCommands();
 
 	// we store 16-bit samples
 	if (_stereo) {
@@ -320,30 +412,106 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 		len >>= 1;
 	}
 
+	const uint numSamples = _stereo ? len * 2 : len;
+	if (_mixBus.size() < numSamples)
+		_mixBus.resize(numSamples);
+	int32 *bus = _mixBus.data();
+	memset(bus, 0, numSamples * sizeof(int32));
+
 	// mix all channels
 	int res = 0, tmp;
+	int playing = 0;
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		if (_channels[i]) {
 			if (_channels[i]->isFinished()) {
-				delete _channels[i];
-				_channels[i] = nullptr;
+				deleteChannel(i);
 			} else if (!_channels[i]->isPaused()) {
-				tmp = _channels[i]->mix(buf, len);
+				tmp = _channels[i]->mix(bus, len);
+				playing++;
 
 				if (tmp > res)
 					res = tmp;
 			}
 		}
 
+	PROFILE_COUNTER("Mixer channels", playing);
+
+	RateKernels::get().clamp(buf, bus, numSamples);
+
+	// Publish the new playback positions
+	Common::StackLock statusLock(_commandMutex);
+	for (int i = 0; i != NUM_CHANNELS; i++)
+		if (_channels[i] && !_channels[i]->isPaused())
+			updateChannelStatus(i, false);
+
 	return res;
 }
 
+void MixerImpl::queueCommand(ChannelCommand::Type type, uint32 handle, int32 value) {
+	ChannelCommand command;
+	command.type = type;
+	command.handle = handle;
+	command.value = value;
+
+	{
+		Common::StackLock lock(_commandMutex);
+		if (_commands.push(command))
+			return;
+	}
+
+	// The queue only fills up if mixCallback() has not been called for a
+	// while, e.g. because the audio output is paused, so there is nothing
+	// to wait for here.
+	Common::StackLock lock(_mutex);
+	processCommands();
+	applyCommand(command);
+}
+
+void MixerImpl::processCommands() {
+	// Only one thread at a time can pop commands; this is guaranteed by
+	// the callers holding _mutex
+	ChannelCommand command;
+	while (_commands.pop(command))
+		applyCommand(command);
+}
+
+void MixerImpl::applyCommand(const ChannelCommand &command) {
+	if (command.type == ChannelCommand::kUpdateSoundTypeVolume) {
+		for (int i = 0; i != NUM_CHANNELS; ++i) {
+			if (_channels[i] && _channels[i]->getType() == (SoundType)command.handle)
+				_channels[i]->notifyGlobalVolChange();
+		}
+		return;
+	}
+
+	// Ignore changes to sounds that terminated in the meantime
+	const int index = command.handle % NUM_CHANNELS;
+	if (!_channels[index] || _channels[index]->getHandle()._val != command.handle)
+		return;
+
+	switch (command.type) {
+	case ChannelCommand::kSetVolume:
+		_channels[index]->setVolume(command.value);
+		break;
+	case ChannelCommand::kSetBalance:
+		_channels[index]->setBalance(command.value);
+		break;
+	case ChannelCommand::kSetRate:
+		_channels[index]->setRate(command.value);
+		break;
+	case ChannelCommand::kResetRate:
+		_channels[index]->resetRate();
+		break;
+	default:
+		break;
+	}
+}
+
 void MixerImpl::stopAll() {
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != nullptr && !_channels[i]->isPermanent()) {
-			delete _channels[i];
-			_channels[i] = nullptr;
+			deleteChannel(i);
 		}
 	}
 }
@@ -352,8 +520,7 @@ void MixerImpl::stopID(int id) {
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != nullptr && _channels[i]->getId() == id) {
-			delete _channels[i];
-			_channels[i] = nullptr;
+			deleteChannel(i);
 		}
 	}
 }
@@ -366,87 +533,107 @@ void MixerImpl::stopHandle(SoundHandle handle) {
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return;
 
-	delete _channels[index];
-	_channels[index] = nullptr;
+	deleteChannel(index);
 }
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
 	assert(0 <= (int)type && (int)type < ARRAYSIZE(_soundTypeSettings));
-	_soundTypeSettings[type].mute = mute;
+	_soundTypeSettings[type].mute.store(mute);
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	queueCommand(ChannelCommand::kUpdateSoundTypeVolume, type, 0);
 }
 
 bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 	assert(0 <= (int)type && (int)type < ARRAYSIZE(_soundTypeSettings));
-	return _soundTypeSettings[type].mute;
+	return _soundTypeSettings[type].mute.load() != 0;
 }
 
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
-	Common::StackLock lock(_mutex);
+	{
+		Common::StackLock lock(_commandMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
+		ChannelStatus &status = _channelStatus[handle._val % NUM_CHANNELS];
+		if (status.handle.load() != handle._val)
+			return;
+
+		status.sequence.fetchAdd(1);
+		status.volume.store(volume);
+		status.sequence.fetchAdd(1);
+	}
 
-	_channels[index]->setVolume(volume);
+	queueCommand(ChannelCommand::kSetVolume, handle._val, volume);
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	ChannelSnapshot snapshot;
+	if (!readChannelStatus(handle, snapshot))
 		return 0;
 
-	return _channels[index]->getVolume();
+	return snapshot.volume;
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
-	Common::StackLock lock(_mutex);
+	{
+		Common::StackLock lock(_commandMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
+		ChannelStatus &status = _channelStatus[handle._val % NUM_CHANNELS];
+		if (status.handle.load() != handle._val)
+			return;
 
-	_channels[index]->setBalance(balance);
+		status.sequence.fetchAdd(1);
+		status.balance.store(balance);
+		status.sequence.fetchAdd(1);
+	}
+
+	queueCommand(ChannelCommand::kSetBalance, handle._val, balance);
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	ChannelSnapshot snapshot;
+	if (!readChannelStatus(handle, snapshot))
 		return 0;
 
-	return _channels[index]->getBalance();
+	return snapshot.balance;
 }
 
 void MixerImpl::setChannelRate(SoundHandle handle, uint32 rate) {
-	Common::StackLock lock(_mutex);
+	{
+		Common::StackLock lock(_commandMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
+		ChannelStatus &status = _channelStatus[handle._val % NUM_CHANNELS];
+		if (status.handle.load() != handle._val)
+			return;
+
+		status.sequence.fetchAdd(1);
+		status.rate.store(rate);
+		status.sequence.fetchAdd(1);
+	}
 
-	_channels[index]->setRate(rate);
+	queueCommand(ChannelCommand::kSetRate, handle._val, rate);
 }
 
 uint32 MixerImpl::getChannelRate(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	ChannelSnapshot snapshot;
+	if (!readChannelStatus(handle, snapshot))
 		return 0;
-	
-	return _channels[index]->getRate();
+
+	return snapshot.rate;
 }
 
 void MixerImpl::resetChannelRate(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	{
+		Common::StackLock lock(_commandMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
-	
-	_channels[index]->resetRate();
+		ChannelStatus &status = _channelStatus[handle._val % NUM_CHANNELS];
+		if (status.handle.load() != handle._val)
+			return;
+
+		status.sequence.fetchAdd(1);
+		status.rate.store(status.streamRate.load());
+		status.sequence.fetchAdd(1);
+	}
+
+	queueCommand(ChannelCommand::kResetRate, handle._val, 0);
 }
 
 uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
@@ -454,13 +641,33 @@ uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
 }
 
 Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	Audio::Timestamp ts(0, _sampleRate);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return Timestamp(0, _sampleRate);
+	ChannelSnapshot snapshot;
+	if (!readChannelStatus(handle, snapshot))
+		return ts;
+
+	if (snapshot.mixerTimeStamp == 0)
+		return ts;
+
+	uint32 delta = 0;
+	if (snapshot.paused)
+		delta = snapshot.pauseStartTime - snapshot.mixerTimeStamp;
+	else
+		delta = g_system->getMillis(true) - snapshot.mixerTimeStamp - snapshot.pauseTime;
+
+	// Convert the number of samples into a time duration.
+
+	ts = ts.addFrames(snapshot.samplesConsumed);
+	ts = ts.addMsecs(delta);
+
+	// In theory it would seem like a good idea to limit the approximation
+	// so that it never exceeds the theoretical upper bound set by
+	// _samplesDecoded. Meanwhile, back in the real world, doing so makes
+	// the Broken Sword cutscenes noticeably jerkier. I guess the mixer
+	// isn't invoked at the regular intervals that I first imagined.
 
-	return _channels[index]->getElapsedTime();
+	return ts;
 }
 
 void MixerImpl::loopChannel(SoundHandle handle) {
@@ -475,18 +682,22 @@ void MixerImpl::loopChannel(SoundHandle handle) {
 
 void MixerImpl::pauseAll(bool paused) {
 	Common::StackLock lock(_mutex);
+	Common::StackLock statusLock(_commandMutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != nullptr) {
 			_channels[i]->pause(paused);
+			updateChannelStatus(i, false);
 		}
 	}
 }
 
 void MixerImpl::pauseID(int id, bool paused) {
 	Common::StackLock lock(_mutex);
+	Common::StackLock statusLock(_commandMutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != nullptr && _channels[i]->getId() == id) {
 			_channels[i]->pause(paused);
+			updateChannelStatus(i, false);
 			return;
 		}
 	}
@@ -501,44 +712,43 @@ void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
 		return;
 
 	_channels[index]->pause(paused);
+
+	Common::StackLock statusLock(_commandMutex);
+	updateChannelStatus(index, false);
 }
 
 bool MixerImpl::isSoundIDActive(int id) {
-	Common::StackLock lock(_mutex);
-
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
+	ChannelSnapshot snapshot;
 	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getId() == id)
+		if (readChannelStatus(i, snapshot) && snapshot.id == id)
 			return true;
 	return false;
 }
 
 int MixerImpl::getSoundID(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
-	const int index = handle._val % NUM_CHANNELS;
-	if (_channels[index] && _channels[index]->getHandle()._val == handle._val)
-		return _channels[index]->getId();
+	ChannelSnapshot snapshot;
+	if (readChannelStatus(handle, snapshot))
+		return snapshot.id;
 	return 0;
 }
 
 bool MixerImpl::isSoundHandleActive(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
-
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
-	const int index = handle._val % NUM_CHANNELS;
-	return _channels[index] && _channels[index]->getHandle()._val == handle._val;
+	ChannelSnapshot snapshot;
+	return readChannelStatus(handle, snapshot);
 }
 
 bool MixerImpl::hasActiveChannelOfType(SoundType type) {
-	Common::StackLock lock(_mutex);
+	ChannelSnapshot snapshot;
 	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getType() == type)
+		if (readChannelStatus(i, snapshot) && snapshot.type == type)
 			return true;
 	return false;
 }
@@ -552,19 +762,15 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 	// TODO: Maybe we should do logarithmic (not linear) volume
 	// scaling? See also Player_V2::setMasterVolume
 
-	Common::StackLock lock(_mutex);
-	_soundTypeSettings[type].volume = volume;
+	_soundTypeSettings[type].volume.store(volume);
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	queueCommand(ChannelCommand::kUpdateSoundTypeVolume, type, 0);
 }
 
 int MixerImpl::getVolumeForSoundType(SoundType type) const {
 	assert(0 <= (int)type && (int)type < ARRAYSIZE(_soundTypeSettings));
 
-	return _soundTypeSettings[type].volume;
+	return _soundTypeSettings[type].volume.load();
 }
 
 
@@ -594,7 +800,7 @@ void Channel::setVolume(const byte volume) {
 	updateChannelVolumes();
 }
 
-byte Channel::getVolume() {
+byte Channel::getVolume() const {
 	return _volume;
 }
 
@@ -603,7 +809,7 @@ void Channel::setBalance(const int8 balance) {
 	updateChannelVolumes();
 }
 
-int8 Channel::getBalance() {
+int8 Channel::getBalance() const {
 	return _balance;
 }
 
@@ -612,7 +818,7 @@ void Channel::setRate(uint32 rate) {
 		_converter->setInputRate(rate);
 }
 
-uint32 Channel::getRate() {
+uint32 Channel::getRate() const {
 	if (_converter)
 		return _converter->getInputRate();
 	
@@ -670,34 +876,6 @@ void Channel::pause(bool paused) {
 	}
 }
 
-Timestamp Channel::getElapsedTime() {
-	const uint32 rate = _mixer->getOutputRate();
-	uint32 delta = 0;
-
-	Audio::Timestamp ts(0, rate);
-
-	if (_mixerTimeStamp == 0)
-		return ts;
-
-	if (isPaused())
-		delta = _pauseStartTime - _mixerTimeStamp;
-	else
-		delta = g_system->getMillis(true) - _mixerTimeStamp - _pauseTime;
-
-	// Convert the number of samples into a time duration.
-
-	ts = ts.addFrames(_samplesConsumed);
-	ts = ts.addMsecs(delta);
-
-	// In theory it would seem like a good idea to limit the approximation
-	// so that it never exceeds the theoretical upper bound set by
-	// _samplesDecoded. Meanwhile, back in the real world, doing so makes
-	// the Broken Sword cutscenes noticeably jerkier. I guess the mixer
-	// isn't invoked at the regular intervals that I first imagined.
-
-	return ts;
-}
-
 void Channel::loop() {
 	assert(_stream);
 
@@ -707,7 +885,7 @@ void Channel::loop() {
 	}
 }
 
-int Channel::mix(int16 *data, uint len) {
+int Channel::mix(int32 *data, uint len) {
 	assert(_stream);
 	assert(_converter);
 
@@ -23,7 +23,10 @@
 #define AUDIO_MIXER_INTERN_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
+#include "common/atomic.h"
 #include "common/mutex.h"
+#include "common/spsc-queue.h"
 #include "audio/mixer.h"
 
 namespace Audio {
@@ -53,12 +56,19 @@ namespace Audio {
  * (partial) alternative implementations of the mixer, e.g. to make
  * better use of native sound mixing support on low-end devices.
  *
+ * Playing, stopping and pausing sounds takes the mixer mutex, which
+ * mixCallback() holds while mixing. Channel volume, balance and rate changes
+ * are instead queued up and applied by the next mixCallback(), and queries
+ * about the channels read a snapshot of their state. Neither has to wait for
+ * the mixer to finish mixing.
+ *
  * @see OSystem::getMixer()
  */
 class MixerImpl : public Mixer {
 private:
 	enum {
-		NUM_CHANNELS = 32
+		NUM_CHANNELS = 32,
+		COMMAND_QUEUE_SIZE = 256
 	};
 
 	Common::Mutex _mutex;
@@ -66,26 +76,102 @@ private:
 	const uint _sampleRate;
 	const bool _stereo;
 	const uint _outBufSize;
-	bool _mixerReady;
+	Common::Atomic<int32> _mixerReady;
 	uint32 _handleSeed;
 
 	struct SoundTypeSettings {
 		SoundTypeSettings() : mute(false), volume(kMaxMixerVolume) {}
 
-		bool mute;
-		int volume;
+		Common::Atomic<int32> mute;
+		Common::Atomic<int32> volume;
 	};
 
 	SoundTypeSettings _soundTypeSettings[4];
 	Channel *_channels[NUM_CHANNELS];
 
+	/**
+	 * The channels are summed in 32 bits, and only clipped to the output
+	 * once they are all mixed.
+	 */
+	Common::Array<int32> _mixBus;
+
+	/** A channel setting change, waiting to be applied by mixCallback(). */
+	struct ChannelCommand {
+		enum Type {
+			kSetVolume,
+			kSetBalance,
+			kSetRate,
+			kResetRate,
+			kUpdateSoundTypeVolume
+		};
+
+		Type type;
+		uint32 handle; ///< Sound handle, or the sound type for kUpdateSoundTypeVolume
+		int32 value;
+	};
+
+	Common::SPSCQueue<ChannelCommand, COMMAND_QUEUE_SIZE> _commands;
+
+	/**
+	 * The state of a channel, as seen from outside the mixer thread.
+	 *
+	 * Every update increments the sequence number before and after changing
+	 * the fields, so that readers can detect when they read the fields while
+	 * they were being changed, and retry.
+	 */
+	struct ChannelStatus {
+		Common::Atomic<uint32> sequence;
+
+		Common::Atomic<uint32> handle;
+		Common::Atomic<int32> id;
+		Common::Atomic<int32> type;
+
+		// Written by the threads changing the settings, so they are up to
+		// date before mixCallback() applies the queued command
+		Common::Atomic<int32> volume;
+		Common::Atomic<int32> balance;
+		Common::Atomic<uint32> rate;
+		Common::Atomic<uint32> streamRate;
+
+		Common::Atomic<int32> paused;
+		Common::Atomic<uint32> samplesConsumed;
+		Common::Atomic<uint32> mixerTimeStamp;
+		Common::Atomic<uint32> pauseStartTime;
+		Common::Atomic<uint32> pauseTime;
+	};
+
+	/** A consistent copy of a ChannelStatus. */
+	struct ChannelSnapshot {
+		uint32 handle;
+		int id;
+		SoundType type;
+		byte volume;
+		int8 balance;
+		uint32 rate;
+		uint32 streamRate;
+		bool paused;
+		uint32 samplesConsumed;
+		uint32 mixerTimeStamp;
+		uint32 pauseStartTime;
+		uint32 pauseTime;
+	};
+
+	ChannelStatus _channelStatus[NUM_CHANNELS];
+
+	/**
+	 * Serializes the threads queuing commands, and all updates of the
+	 * channel status. It is only ever held for a short time, and never while
+	 * mixing.
+	 */
+	Common::Mutex _commandMutex;
+
 
 public:
 
 	MixerImpl(uint sampleRate, bool stereo = true, uint outBufSize = 0);
 	~MixerImpl();
 
-	virtual bool isReady() const { Common::StackLock lock(_mutex); return _mixerReady; }
+	virtual bool isReady() const { return _mixerReady.load() != 0; }
 
 	virtual Common::Mutex &mutex() { return _mutex; }
 
@@ -139,6 +225,23 @@ public:
 protected:
 	void insertChannel(SoundHandle *handle, Channel *chan);
 
+private:
+	void deleteChannel(int index);
+
+	void queueCommand(ChannelCommand::Type type, uint32 handle, int32 value);
+	void processCommands();
+	void applyCommand(const ChannelCommand &command);
+
+	/**
+	 * Copy the state of a channel to its status. Both _mutex and
+	 * _commandMutex must be held.
+	 *
+	 * @param settings Whether to also copy the volume, balance and rate.
+	 */
+	void updateChannelStatus(int index, bool settings);
+	bool readChannelStatus(int index, ChannelSnapshot &snapshot) const;
+	bool readChannelStatus(SoundHandle handle, ChannelSnapshot &snapshot) const;
+
 public:
 	/**
 	 * The mixer callback function, to be called at regular intervals by
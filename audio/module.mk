@@ -16,6 +16,8 @@ MODULE_OBJS := \
 	midiparser_xmidi.o \
 	midiparser.o \
 	midiplayer.o \
+	midirender.o \
+	midirender_cache.o \
 	miles_adlib.o \
 	miles_midi.o \
 	mixer.o \
@@ -23,6 +25,7 @@ MODULE_OBJS := \
 	mt32gm.o \
 	musicplugin.o \
 	null.o \
+	prefetching_stream.o \
 	rate.o \
 	timestamp.o \
 	decoders/3do.o \
@@ -57,6 +60,7 @@ MODULE_OBJS := \
 	mods/soundfx.o \
 	mods/tfmx.o \
 	softsynth/cms.o \
+	softsynth/emumidi.o \
 	softsynth/opl/dbopl.o \
 	softsynth/opl/dosbox.o \
 	softsynth/opl/mame.o \
@@ -65,9 +69,34 @@ MODULE_OBJS := \
 	softsynth/eas.o \
 	softsynth/pcspk.o
 
+ifdef SCUMMVM_NEON
+MODULE_OBJS += \
+	rate_neon.o
+endif
+ifdef SCUMMVM_SSE2
+MODULE_OBJS += \
+	rate_sse2.o
+endif
+ifdef SCUMMVM_AVX2
+MODULE_OBJS += \
+	rate_avx2.o
+endif
+
 ifndef DISABLE_NUKED_OPL
 MODULE_OBJS += \
 	softsynth/opl/nuked.o
+ifdef SCUMMVM_NEON
+MODULE_OBJS += \
+	softsynth/opl/nuked_neon.o
+endif
+ifdef SCUMMVM_SSE2
+MODULE_OBJS += \
+	softsynth/opl/nuked_sse2.o
+endif
+ifdef SCUMMVM_AVX2
+MODULE_OBJS += \
+	softsynth/opl/nuked_avx2.o
+endif
 endif
 
 ifdef USE_A52
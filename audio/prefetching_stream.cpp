@@ -0,0 +1,174 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/system.h"
+#include "common/thread.h"
+
+#include "audio/prefetching_stream.h"
+
+namespace Audio {
+
+PrefetchingAudioStream::PrefetchingAudioStream(SeekableAudioStream *parent) :
+		_parent(parent), _thread(nullptr), _wake(nullptr) {
+	assert(parent);
+	_isStereo = _parent->isStereo();
+	_rate = _parent->getRate();
+	updateEndFlags();
+
+	_wake = g_system->createSemaphore();
+	if (!_wake)
+		return;
+
+	_thread = g_system->createThread(workerProc, this);
+	if (!_thread) {
+		delete _wake;
+		_wake = nullptr;
+		return;
+	}
+
+	wakeWorker();
+}
+
+PrefetchingAudioStream::~PrefetchingAudioStream() {
+	if (_thread) {
+		_quit.store(1);
+		_wake->post();
+		_thread->join();
+
+		delete _thread;
+		delete _wake;
+	}
+
+	delete _parent;
+}
+
+void PrefetchingAudioStream::updateEndFlags() {
+	_parentEndOfData.store(_parent->endOfData());
+	_parentEndOfStream.store(_parent->endOfStream());
+}
+
+void PrefetchingAudioStream::decodeChunk() {
+	const int samples = _parent->readBuffer(_chunk, kChunkSize);
+	if (samples > 0)
+		_ring.push(_chunk, samples);
+
+	// After the push, so that a reader which sees the end of the data
+	// also sees the samples which came before it
+	updateEndFlags();
+}
+
+void PrefetchingAudioStream::wakeWorker() {
+	if (_thread) {
+		if (_wakePending.exchange(1) == 0)
+			_wake->post();
+		return;
+	}
+
+	Common::StackLock lock(_mutex);
+	while (_ring.space() >= kChunkSize && !_parentEndOfData.load())
+		decodeChunk();
+}
+
+void PrefetchingAudioStream::workerProc(void *data) {
+	((PrefetchingAudioStream *)data)->run();
+}
+
+void PrefetchingAudioStream::run() {
+	for (;;) {
+		_wake->wait();
+		if (_quit.load())
+			break;
+
+		_wakePending.store(0);
+
+		// Decode one chunk at a time, so that the mixer thread can take
+		// the mutex in between when it runs dry
+		while (!_quit.load() && _ring.space() >= kChunkSize && !_parentEndOfData.load()) {
+			Common::StackLock lock(_mutex);
+			if (!_parentEndOfData.load())
+				decodeChunk();
+		}
+	}
+}
+
+int PrefetchingAudioStream::readBuffer(int16 *buffer, const int numSamples) {
+	int samples = _ring.pop(buffer, numSamples);
+
+	if (samples < numSamples && !_parentEndOfData.load()) {
+		// The worker fell behind: decode on this thread rather than let
+		// the mixer play silence
+		Common::StackLock lock(_mutex);
+		samples += _ring.pop(buffer + samples, numSamples - samples);
+		if (samples < numSamples) {
+			samples += _parent->readBuffer(buffer + samples, numSamples - samples);
+			updateEndFlags();
+		}
+	}
+
+	if (_ring.space() >= kChunkSize && !_parentEndOfData.load())
+		wakeWorker();
+
+	return samples;
+}
+
+bool PrefetchingAudioStream::endOfData() const {
+	// The flag first: once it is set, all the samples are in the ring
+	return _parentEndOfData.load() && _ring.empty();
+}
+
+bool PrefetchingAudioStream::endOfStream() const {
+	return _parentEndOfStream.load() && _ring.empty();
+}
+
+bool PrefetchingAudioStream::seek(const Timestamp &where) {
+	bool result;
+	{
+		Common::StackLock lock(_mutex);
+		// The worker only pushes with the mutex held
+		_ring.clear();
+		result = _parent->seek(where);
+		updateEndFlags();
+	}
+
+	wakeWorker();
+	return result;
+}
+
+Timestamp PrefetchingAudioStream::getLength() const {
+	Common::StackLock lock(_mutex);
+	return _parent->getLength();
+}
+
+SeekableAudioStream *makePrefetchingAudioStream(SeekableAudioStream *parent) {
+	if (!parent)
+		return nullptr;
+
+	PrefetchingAudioStream *stream = new PrefetchingAudioStream(parent);
+	if (stream->hasThread())
+		return stream;
+
+	// Decoding ahead on the mixer thread would only make its reads longer
+	stream->_parent = nullptr;
+	delete stream;
+	return parent;
+}
+
+} // End of namespace Audio
@@ -0,0 +1,126 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AUDIO_PREFETCHING_STREAM_H
+#define AUDIO_PREFETCHING_STREAM_H
+
+#include "common/atomic.h"
+#include "common/mutex.h"
+#include "common/scummsys.h"
+#include "common/spsc-queue.h"
+
+#include "audio/audiostream.h"
+
+namespace Common {
+class SemaphoreInternal;
+class ThreadInternal;
+}
+
+namespace Audio {
+
+/**
+ * A seekable stream which is decoded ahead of the mixer by a worker thread.
+ *
+ * Compressed streams (MP3, Vorbis, FLAC, AAC...) do their decoding in
+ * readBuffer(), which the mixer calls from the audio callback. Decoding a
+ * packet can take long enough on slow CPUs to cause underruns when several
+ * of them play at once. This stream keeps a lock-free ring of decoded
+ * samples ahead of the mixer instead, and only decodes on the calling
+ * thread when the worker fell behind.
+ *
+ * The wrapped stream is read from the worker thread: its data must not
+ * come from a stream shared with other users, like the member of an
+ * archive which is read in place.
+ */
+class PrefetchingAudioStream : public SeekableAudioStream {
+public:
+	/**
+	 * Wrap a stream and start its worker. When the backend does not support
+	 * threads, the samples are decoded ahead whenever the stream is read.
+	 *
+	 * @param parent  The stream to decode ahead, which is deleted with this one.
+	 */
+	explicit PrefetchingAudioStream(SeekableAudioStream *parent);
+	~PrefetchingAudioStream();
+
+	int readBuffer(int16 *buffer, const int numSamples) override;
+	bool isStereo() const override { return _isStereo; }
+	int getRate() const override { return _rate; }
+	bool endOfData() const override;
+	bool endOfStream() const override;
+
+	/**
+	 * Seek the wrapped stream. The samples which were decoded ahead are
+	 * discarded, and the worker starts again from the new position.
+	 */
+	bool seek(const Timestamp &where) override;
+	Timestamp getLength() const override;
+
+	/** Return true if the samples are decoded by a worker thread. */
+	bool hasThread() const { return _thread != nullptr; }
+
+private:
+	friend SeekableAudioStream *makePrefetchingAudioStream(SeekableAudioStream *parent);
+
+	enum {
+		/** Number of decoded samples kept ahead, about 0.37s of 44.1 kHz stereo. */
+		kRingSize = 32768,
+		/** Number of samples decoded at a time. */
+		kChunkSize = 2048
+	};
+
+	static void workerProc(void *data);
+	void run();
+	/** Decode a chunk into the ring. The mutex must be held. */
+	void decodeChunk();
+	void updateEndFlags();
+	void wakeWorker();
+
+	SeekableAudioStream *_parent;
+	bool _isStereo;
+	int _rate;
+
+	/** Serializes the accesses to the wrapped stream, and the pushes to the ring. */
+	Common::Mutex _mutex;
+	Common::SPSCQueue<int16, kRingSize> _ring;
+	int16 _chunk[kChunkSize];
+	Common::Atomic<uint32> _parentEndOfData;
+	Common::Atomic<uint32> _parentEndOfStream;
+
+	Common::ThreadInternal *_thread;
+	Common::SemaphoreInternal *_wake;
+	Common::Atomic<uint32> _wakePending;
+	Common::Atomic<uint32> _quit;
+};
+
+/**
+ * Decode a stream ahead on a worker thread, if the backend supports threads.
+ *
+ * @param parent  The stream to decode ahead. It is owned by the returned
+ *                stream, which is @p parent itself without threads.
+ *
+ * @return The stream to play.
+ */
+SeekableAudioStream *makePrefetchingAudioStream(SeekableAudioStream *parent);
+
+} // End of namespace Audio
+
+#endif
@@ -29,7 +29,9 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
+#include "audio/rate_kernels.h"
 #include "audio/mixer.h"
+#include "common/system.h"
 #include "common/util.h"
 
 namespace Audio {
@@ -45,9 +47,100 @@ enum {
 	FRAC_HALF_LOW = (1L << (FRAC_BITS_LOW-1))
 };
 
+STATIC_ASSERT((int)FRAC_BITS_LOW == (int)RateKernels::kFracBits, rate_kernels_use_the_same_fixed_point_format);
+STATIC_ASSERT((int)RateKernels::kMaxSIMDVolume == (int)Mixer::kMaxMixerVolume, rate_kernels_support_the_full_mixer_volume);
+
+static inline void addSample(st_sample_t &out, int val) {
+	clampedAdd(out, val);
+}
+
+static inline void addSample(int32 &out, int val) {
+	out += val;
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo, typename T>
+static void mixGeneric(T *out, const st_sample_t *in, uint numFrames, st_volume_t volL, st_volume_t volR) {
+	for (; numFrames > 0; numFrames--) {
+		st_sample_t inL, inR;
+		inL = *in++;
+		inR = (inStereo ? *in++ : inL);
+
+		st_sample_t outL, outR;
+		outL = (inL * (int)volL) / Audio::Mixer::kMaxMixerVolume;
+		outR = (inR * (int)volR) / Audio::Mixer::kMaxMixerVolume;
+
+		if (outStereo) {
+			// Output left channel
+			addSample(out[reverseStereo    ], outL);
+
+			// Output right channel
+			addSample(out[reverseStereo ^ 1], outR);
+
+			out += 2;
+		} else {
+			// Output mono channel
+			addSample(out[0], (outL + outR) / 2);
+
+			out += 1;
+		}
+	}
+}
+
+static void interpolateGeneric(st_sample_t *out, const st_sample_t *pairs, const int16 *weights, uint numSamples) {
+	// Same as last + (((cur - last) * frac + FRAC_HALF_LOW) >> FRAC_BITS_LOW),
+	// but in a form that maps to a single multiply-add in the SIMD kernels.
+	for (; numSamples > 0; numSamples--) {
+		*out++ = (st_sample_t)((pairs[0] * weights[0] + pairs[1] * weights[1] + pairs[0] + FRAC_HALF_LOW) >> FRAC_BITS_LOW);
+		pairs += 2;
+		weights += 2;
+	}
+}
+
+static void clampGeneric(st_sample_t *out, const int32 *in, uint numSamples) {
+	for (; numSamples > 0; numSamples--) {
+		const int32 val = CLIP<int32>(*in++, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+#ifdef OUTPUT_UNSIGNED_AUDIO
+		*out++ = ((st_sample_t)val) ^ 0x8000;
+#else
+		*out++ = (st_sample_t)val;
+#endif
+	}
+}
+
+const RateKernels::Table RateKernels::generic = {
+	{
+		mixGeneric<false, false, false, st_sample_t>,
+		mixGeneric<false, true, false, st_sample_t>,
+		mixGeneric<true, false, false, st_sample_t>,
+		mixGeneric<true, true, false, st_sample_t>,
+		mixGeneric<true, true, true, st_sample_t>
+	},
+	{
+		mixGeneric<false, false, false, int32>,
+		mixGeneric<false, true, false, int32>,
+		mixGeneric<true, false, false, int32>,
+		mixGeneric<true, true, false, int32>,
+		mixGeneric<true, true, true, int32>
+	},
+	interpolateGeneric,
+	clampGeneric
+};
+
+const RateKernels::Table *RateKernels::kernels = nullptr;
+
 template<bool inStereo, bool outStereo, bool reverseStereo>
 class RateConverter_Impl : public RateConverter {
 private:
+	enum {
+		kMode = inStereo ? (outStereo ? (reverseStereo ? RateKernels::kStereoToStereoReversed : RateKernels::kStereoToStereo) : RateKernels::kStereoToMono)
+		                 : (outStereo ? RateKernels::kMonoToStereo : RateKernels::kMonoToMono),
+		kInChannels = inStereo ? 2 : 1,
+		kOutChannels = outStereo ? 2 : 1,
+
+		/** Number of frames resampled at once before they are mixed */
+		kMixFrames = 256
+	};
+
 	/** Input and output rates */
 	st_rate_t _inRate, _outRate;
 
@@ -64,6 +157,13 @@ private:
 	/** Size of data currently loaded into the buffer */
 	int _bufferSize;
 
+	/** Resampled frames waiting to be mixed into the output */
+	st_sample_t _mixBuffer[kMixFrames * kInChannels];
+
+	/** Input sample pairs and weights for the interpolation kernel */
+	st_sample_t _interpolatePairs[kMixFrames * kInChannels * 2];
+	int16 _interpolateWeights[kMixFrames * kInChannels * 2];
+
 	/** How far output is ahead of input when doing simple conversion */
 	frac_t _outPos;
 
@@ -76,15 +176,30 @@ private:
 	/** Current sample(s) in the input stream (left/right channel) */
 	st_sample_t _inCurL, _inCurR;
 
-	int copyConvert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r);
-	int simpleConvert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r);
-	int interpolateConvert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r);
+	static void mixFrames(const RateKernels::Table &kernels, st_sample_t *out, const st_sample_t *in, uint numFrames, st_volume_t volL, st_volume_t volR) {
+		kernels.mix[kMode](out, in, numFrames, volL, volR);
+	}
+
+	static void mixFrames(const RateKernels::Table &kernels, int32 *out, const st_sample_t *in, uint numFrames, st_volume_t volL, st_volume_t volR) {
+		kernels.mixBus[kMode](out, in, numFrames, volL, volR);
+	}
+
+	template<typename T>
+	int convertInto(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r);
+
+	template<typename T>
+	int copyConvert(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r, const RateKernels::Table &kernels);
+	template<typename T>
+	int simpleConvert(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r, const RateKernels::Table &kernels);
+	template<typename T>
+	int interpolateConvert(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r, const RateKernels::Table &kernels);
 
 public:
 	RateConverter_Impl(st_rate_t inputRate, st_rate_t outputRate);
 	virtual ~RateConverter_Impl() {}
 
 	int convert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r) override;
+	int convert(AudioStream &input, int32 *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r) override;
 
 	void setInputRate(st_rate_t inputRate) override { _inRate = inputRate; }
 	void setOutputRate(st_rate_t outputRate) override { _outRate = outputRate; }
@@ -96,11 +211,12 @@ public:
 };
 
 template<bool inStereo, bool outStereo, bool reverseStereo>
-int RateConverter_Impl<inStereo, outStereo, reverseStereo>::copyConvert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
-	st_sample_t *outStart, *outEnd;
+template<typename T>
+int RateConverter_Impl<inStereo, outStereo, reverseStereo>::copyConvert(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR, const RateKernels::Table &kernels) {
+	T *outStart, *outEnd;
 
 	outStart = outBuffer;
-	outEnd = outBuffer + numSamples * (outStereo ? 2 : 1);
+	outEnd = outBuffer + numSamples * kOutChannels;
 
 	while (outBuffer < outEnd) {
 		// Check if we have to refill the buffer
@@ -109,164 +225,169 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::copyConvert(AudioStr
 			_bufferSize = input.readBuffer(_buffer, ARRAYSIZE(_buffer));
 
 			if (_bufferSize <= 0)
-				return (outBuffer - outStart) / (outStereo ? 2 : 1);
+				return (outBuffer - outStart) / kOutChannels;
 		}
 
-		// Mix the data into the output buffer
-		st_sample_t inL, inR;
-		inL = *_bufferPos++;
-		inR = (inStereo ? *_bufferPos++ : inL);
-		_bufferSize -= (inStereo ? 2 : 1);
-
-		st_sample_t outL, outR;
-		outL = (inL * (int)volL) / Audio::Mixer::kMaxMixerVolume;
-		outR = (inR * (int)volR) / Audio::Mixer::kMaxMixerVolume;
-
-		if (outStereo) {
-			// Output left channel
-			clampedAdd(outBuffer[reverseStereo    ], outL);
-
-			// Output right channel
-			clampedAdd(outBuffer[reverseStereo ^ 1], outR);
-
-			outBuffer += 2;
-		} else {
-			// Output mono channel
-			clampedAdd(outBuffer[0], (outL + outR) / 2);
+		// Mix as much of the buffered data as fits into the output buffer
+		uint numFrames = MIN<uint>(_bufferSize / kInChannels, (outEnd - outBuffer) / kOutChannels);
+		mixFrames(kernels, outBuffer, _bufferPos, numFrames, volL, volR);
 
-			outBuffer += 1;
-		}
+		_bufferPos += numFrames * kInChannels;
+		_bufferSize -= numFrames * kInChannels;
+		outBuffer += numFrames * kOutChannels;
 	}
 
-	return (outBuffer - outStart) / (outStereo ? 2 : 1);
+	return (outBuffer - outStart) / kOutChannels;
 }
 
 template<bool inStereo, bool outStereo, bool reverseStereo>
-int RateConverter_Impl<inStereo, outStereo, reverseStereo>::simpleConvert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
+template<typename T>
+int RateConverter_Impl<inStereo, outStereo, reverseStereo>::simpleConvert(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR, const RateKernels::Table &kernels) {
 	// How much to increment _outPos by
 	frac_t outPos_inc = _inRate / _outRate;
 
-	st_sample_t *outStart, *outEnd;
+	T *outStart, *outEnd;
 
 	outStart = outBuffer;
-	outEnd = outBuffer + numSamples * (outStereo ? 2 : 1);
-
-	while (outBuffer < outEnd) {
-		// Read enough input samples so that _outPos >= 0
-		do {
-			// Check if we have to refill the buffer
-			if (_bufferSize == 0) {
-				_bufferPos = _buffer;
-				_bufferSize = input.readBuffer(_buffer, ARRAYSIZE(_buffer));
-
-				if (_bufferSize <= 0)
-					return (outBuffer - outStart) / (outStereo ? 2 : 1);
-			}
-
-			_bufferSize -= (inStereo ? 2 : 1);
-			_outPos--;
-
-			if (_outPos >= 0) {
-				_bufferPos += (inStereo ? 2 : 1);
-			}
-		} while (_outPos >= 0);
-
-		st_sample_t inL, inR;
-		inL = *_bufferPos++;
-		inR = (inStereo ? *_bufferPos++ : inL);
-
-		// Increment output position
-		_outPos += outPos_inc;
-
-		st_sample_t outL, outR;
-		outL = (inL * (int)volL) / Audio::Mixer::kMaxMixerVolume;
-		outR = (inR * (int)volR) / Audio::Mixer::kMaxMixerVolume;
+	outEnd = outBuffer + numSamples * kOutChannels;
+
+	bool endOfInput = false;
+	while (outBuffer < outEnd && !endOfInput) {
+		uint maxFrames = MIN<uint>(kMixFrames, (outEnd - outBuffer) / kOutChannels);
+		uint numFrames = 0;
+		st_sample_t *mixPos = _mixBuffer;
+
+		while (numFrames < maxFrames) {
+			// Read enough input samples so that _outPos >= 0
+			do {
+				// Check if we have to refill the buffer
+				if (_bufferSize == 0) {
+					_bufferPos = _buffer;
+					_bufferSize = input.readBuffer(_buffer, ARRAYSIZE(_buffer));
+
+					if (_bufferSize <= 0) {
+						endOfInput = true;
+						break;
+					}
+				}
+
+				_bufferSize -= kInChannels;
+				_outPos--;
+
+				if (_outPos >= 0) {
+					_bufferPos += kInChannels;
+				}
+			} while (_outPos >= 0);
+
+			if (endOfInput)
+				break;
+
+			*mixPos++ = *_bufferPos++;
+			if (inStereo)
+				*mixPos++ = *_bufferPos++;
 
-		if (outStereo) {
-			// output left channel
-			clampedAdd(outBuffer[reverseStereo    ], outL);
-
-			// output right channel
-			clampedAdd(outBuffer[reverseStereo ^ 1], outR);
-
-			outBuffer += 2;
-		} else {
-			// output mono channel
-			clampedAdd(outBuffer[0], (outL + outR) / 2);
-
-			outBuffer += 1;
+			// Increment output position
+			_outPos += outPos_inc;
+			numFrames++;
 		}
+
+		mixFrames(kernels, outBuffer, _mixBuffer, numFrames, volL, volR);
+		outBuffer += numFrames * kOutChannels;
 	}
-	return (outBuffer - outStart) / (outStereo ? 2 : 1);
+	return (outBuffer - outStart) / kOutChannels;
 }
 
 template<bool inStereo, bool outStereo, bool reverseStereo>
-int RateConverter_Impl<inStereo, outStereo, reverseStereo>::interpolateConvert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
+template<typename T>
+int RateConverter_Impl<inStereo, outStereo, reverseStereo>::interpolateConvert(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR, const RateKernels::Table &kernels) {
 	// How much to increment _outPosFrac by
 	frac_t outPos_inc = (_inRate << FRAC_BITS_LOW) / _outRate;
 
-	st_sample_t *outStart, *outEnd;
+	T *outStart, *outEnd;
 	outStart = outBuffer;
-	outEnd = outBuffer + numSamples * (outStereo ? 2 : 1);
-
-	while (outBuffer < outEnd) {
-		// Read enough input samples so that _outPosFrac < 0
-		while ((frac_t)FRAC_ONE_LOW <= _outPosFrac) {
-			// Check if we have to refill the buffer
-			if (_bufferSize == 0) {
-				_bufferPos = _buffer;
-				_bufferSize = input.readBuffer(_buffer, ARRAYSIZE(_buffer));
-
-				if (_bufferSize <= 0)
-					return (outBuffer - outStart) / (outStereo ? 2 : 1);
+	outEnd = outBuffer + numSamples * kOutChannels;
+
+	// Without SIMD support, interpolating right away is faster than going
+	// through the interpolation kernel
+	const bool interpolateDirectly = (&kernels == &RateKernels::generic);
+
+	bool endOfInput = false;
+	while (outBuffer < outEnd && !endOfInput) {
+		uint maxFrames = MIN<uint>(kMixFrames, (outEnd - outBuffer) / kOutChannels);
+		uint numFrames = 0;
+		st_sample_t *mixPos = _mixBuffer;
+		st_sample_t *pairs = _interpolatePairs;
+		int16 *weights = _interpolateWeights;
+
+		while (numFrames < maxFrames) {
+			// Read enough input samples so that _outPosFrac < 0
+			while ((frac_t)FRAC_ONE_LOW <= _outPosFrac) {
+				// Check if we have to refill the buffer
+				if (_bufferSize == 0) {
+					_bufferPos = _buffer;
+					_bufferSize = input.readBuffer(_buffer, ARRAYSIZE(_buffer));
+
+					if (_bufferSize <= 0) {
+						endOfInput = true;
+						break;
+					}
+				}
+
+				_bufferSize -= kInChannels;
+				_inLastL = _inCurL;
+				_inCurL = *_bufferPos++;
+
+				if (inStereo) {
+					_inLastR = _inCurR;
+					_inCurR = *_bufferPos++;
+				}
+
+				_outPosFrac -= FRAC_ONE_LOW;
 			}
 
-			_bufferSize -= (inStereo ? 2 : 1);
-			_inLastL = _inCurL;
-			_inCurL = *_bufferPos++;
-
-			if (inStereo) {
-				_inLastR = _inCurR;
-				_inCurR = *_bufferPos++;
-			}
+			if (endOfInput)
+				break;
 
-			_outPosFrac -= FRAC_ONE_LOW;
-		}
+			// Queue up interpolations as long as the _outPos trails behind,
+			// and as long as there is still space in the mix buffer.
+			while (_outPosFrac < (frac_t)FRAC_ONE_LOW && numFrames < maxFrames && interpolateDirectly) {
+				*mixPos++ = (st_sample_t)(_inLastL + (((_inCurL - _inLastL) * _outPosFrac + FRAC_HALF_LOW) >> FRAC_BITS_LOW));
+				if (inStereo)
+					*mixPos++ = (st_sample_t)(_inLastR + (((_inCurR - _inLastR) * _outPosFrac + FRAC_HALF_LOW) >> FRAC_BITS_LOW));
 
-		// Loop as long as the _outPos trails behind, and as long as there is
-		// still space in the output buffer.
-		while (_outPosFrac < (frac_t)FRAC_ONE_LOW && outBuffer < outEnd) {
-			// Interpolate
-			st_sample_t inL, inR;
-			inL = (st_sample_t)(_inLastL + (((_inCurL - _inLastL) * _outPosFrac + FRAC_HALF_LOW) >> FRAC_BITS_LOW));
-			inR = (inStereo ?
-						(st_sample_t)(_inLastR + (((_inCurR - _inLastR) * _outPosFrac + FRAC_HALF_LOW) >> FRAC_BITS_LOW)) :
-						inL);
-
-			st_sample_t outL, outR;
-			outL = (inL * (int)volL) / Audio::Mixer::kMaxMixerVolume;
-			outR = (inR * (int)volR) / Audio::Mixer::kMaxMixerVolume;
-
-			if (outStereo) {
-				// Output left channel
-				clampedAdd(outBuffer[reverseStereo    ], outL);
-
-				// Output right channel
-				clampedAdd(outBuffer[reverseStereo ^ 1], outR);
-
-				outBuffer += 2;
-			} else {
-				// Output mono channel
-				clampedAdd(outBuffer[0], (outL + outR) / 2);
-
-				outBuffer += 1;
+				// Increment output position
+				_outPosFrac += outPos_inc;
+				numFrames++;
 			}
 
-			// Increment output position
-			_outPosFrac += outPos_inc;
+			while (_outPosFrac < (frac_t)FRAC_ONE_LOW && numFrames < maxFrames && !interpolateDirectly) {
+				const int16 weightLast = (int16)(FRAC_ONE_LOW - 1 - _outPosFrac);
+				const int16 weightCur = (int16)_outPosFrac;
+
+				*pairs++ = _inLastL;
+				*pairs++ = _inCurL;
+				*weights++ = weightLast;
+				*weights++ = weightCur;
+
+				if (inStereo) {
+					*pairs++ = _inLastR;
+					*pairs++ = _inCurR;
+					*weights++ = weightLast;
+					*weights++ = weightCur;
+				}
+
+				// Increment output position
+				_outPosFrac += outPos_inc;
+				numFrames++;
+			}
 		}
+
+		if (!interpolateDirectly)
+			kernels.interpolate(_mixBuffer, _interpolatePairs, _interpolateWeights, numFrames * kInChannels);
+		mixFrames(kernels, outBuffer, _mixBuffer, numFrames, volL, volR);
+		outBuffer += numFrames * kOutChannels;
 	}
-	return (outBuffer - outStart) / (outStereo ? 2 : 1);
+	return (outBuffer - outStart) / kOutChannels;
 }
 
 template<bool inStereo, bool outStereo, bool reverseStereo>
@@ -284,15 +405,30 @@ RateConverter_Impl<inStereo, outStereo, reverseStereo>::RateConverter_Impl(st_ra
 
 template<bool inStereo, bool outStereo, bool reverseStereo>
 int RateConverter_Impl<inStereo, outStereo, reverseStereo>::convert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
+	return convertInto(input, outBuffer, numSamples, volL, volR);
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+int RateConverter_Impl<inStereo, outStereo, reverseStereo>::convert(AudioStream &input, int32 *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
+	return convertInto(input, outBuffer, numSamples, volL, volR);
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+template<typename T>
+int RateConverter_Impl<inStereo, outStereo, reverseStereo>::convertInto(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
 	assert(input.isStereo() == inStereo);
 
+	// The SIMD kernels only handle the volumes the mixer uses
+	const RateKernels::Table &kernels = (volL <= RateKernels::kMaxSIMDVolume && volR <= RateKernels::kMaxSIMDVolume) ?
+		RateKernels::get() : RateKernels::generic;
+
 	if (_inRate == _outRate) {
-		return copyConvert(input, outBuffer, numSamples, volL, volR);
+		return copyConvert(input, outBuffer, numSamples, volL, volR, kernels);
 	} else {
 		if ((_inRate % _outRate) == 0 && (_inRate < 65536)) {
-			return simpleConvert(input, outBuffer, numSamples, volL, volR);
+			return simpleConvert(input, outBuffer, numSamples, volL, volR, kernels);
 		} else {
-			return interpolateConvert(input, outBuffer, numSamples, volL, volR);
+			return interpolateConvert(input, outBuffer, numSamples, volL, volR, kernels);
 		}
 	}
 }
@@ -90,6 +90,21 @@ public:
 	 */
 	virtual int convert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r) = 0;
 
+	/**
+	 * Convert the provided AudioStream to the target sample rate, and add it
+	 * to a 32-bit mixing bus without clipping. This is what the mixer uses,
+	 * so that the sum of all its channels is only clipped once.
+	 *
+	 * @param input			The AudioStream to read data from.
+	 * @param outBuffer		The mixing bus. Must have size of at least @p numSamples.
+	 * @param numSamples	The desired number of samples to be mixed into the bus.
+	 * @param vol_l			Volume for left channel.
+	 * @param vol_r			Volume for right channel.
+	 *
+	 * @return Number of sample pairs mixed into the bus.
+	 */
+	virtual int convert(AudioStream &input, int32 *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r) = 0;
+
 	virtual void setInputRate(st_rate_t inputRate) = 0;
 	virtual void setOutputRate(st_rate_t outputRate) = 0;
 
@@ -0,0 +1,227 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "audio/rate_kernels.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace Audio {
+
+class RateKernelsImpl_AVX2 {
+public:
+
+/**
+ * Multiplies the samples by the volumes and divides by kMaxMixerVolume,
+ * rounding towards zero like the generic code does.
+ */
+static inline void scale(__m256i samples, __m256i vol, __m256i &lo, __m256i &hi) {
+	__m256i prodLo = _mm256_mullo_epi16(samples, vol);
+	__m256i prodHi = _mm256_mulhi_epi16(samples, vol);
+	lo = _mm256_unpacklo_epi16(prodLo, prodHi);
+	hi = _mm256_unpackhi_epi16(prodLo, prodHi);
+	lo = _mm256_srai_epi32(_mm256_add_epi32(lo, _mm256_srli_epi32(_mm256_srai_epi32(lo, 31), 24)), 8);
+	hi = _mm256_srai_epi32(_mm256_add_epi32(hi, _mm256_srli_epi32(_mm256_srai_epi32(hi, 31), 24)), 8);
+}
+
+static inline __m256i stereoVolume(st_volume_t volL, st_volume_t volR) {
+	return _mm256_set1_epi32((int)((uint32)volR << 16 | volL));
+}
+
+/** Divides by two, rounding towards zero. */
+static inline __m256i halve(__m256i val) {
+	return _mm256_srai_epi32(_mm256_add_epi32(val, _mm256_srli_epi32(val, 31)), 1);
+}
+
+/**
+ * Sums the adjacent pairs of the sixteen values in lo and hi. The eight
+ * sums are returned in order, not interleaved by 128-bit lane.
+ */
+static inline __m256i addPairs(__m256i lo, __m256i hi) {
+	__m256 even = _mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+	__m256 odd  = _mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+	return _mm256_add_epi32(_mm256_castps_si256(even), _mm256_castps_si256(odd));
+}
+
+/**
+ * Adds sixteen 32-bit values to sixteen output samples, clipping the
+ * result. The values are ordered like the result of unpacking the output,
+ * so lo holds samples 0-3 and 8-11 and hi holds samples 4-7 and 12-15.
+ */
+static inline void addToOutput(st_sample_t *out, __m256i lo, __m256i hi) {
+	__m256i dst = _mm256_loadu_si256((const __m256i *)out);
+#ifdef OUTPUT_UNSIGNED_AUDIO
+	dst = _mm256_xor_si256(dst, _mm256_set1_epi16((short)0x8000));
+#endif
+	lo = _mm256_add_epi32(lo, _mm256_srai_epi32(_mm256_unpacklo_epi16(dst, dst), 16));
+	hi = _mm256_add_epi32(hi, _mm256_srai_epi32(_mm256_unpackhi_epi16(dst, dst), 16));
+	dst = _mm256_packs_epi32(lo, hi);
+#ifdef OUTPUT_UNSIGNED_AUDIO
+	dst = _mm256_xor_si256(dst, _mm256_set1_epi16((short)0x8000));
+#endif
+	_mm256_storeu_si256((__m256i *)out, dst);
+}
+
+/**
+ * Adds sixteen 32-bit values to sixteen mixing bus samples. The values are
+ * ordered like for the output samples.
+ */
+static inline void addToOutput(int32 *out, __m256i lo, __m256i hi) {
+	__m256i first = _mm256_permute2x128_si256(lo, hi, 0x20);
+	__m256i second = _mm256_permute2x128_si256(lo, hi, 0x31);
+	_mm256_storeu_si256((__m256i *)out, _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)out), first));
+	_mm256_storeu_si256((__m256i *)(out + 8), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(out + 8)), second));
+}
+
+template<RateKernels::Mode mode, typename T>
+static void mix(T *out, const st_sample_t *in, uint numFrames, st_volume_t volL, st_volume_t volR) {
+	uint i = 0;
+	__m256i lo, hi;
+
+	if (mode == RateKernels::kMonoToMono) {
+		const __m256i vL = _mm256_set1_epi16(volL);
+		const __m256i vR = _mm256_set1_epi16(volR);
+		for (; i + 16 <= numFrames; i += 16) {
+			__m256i samples = _mm256_loadu_si256((const __m256i *)(in + i));
+			__m256i rLo, rHi;
+			scale(samples, vL, lo, hi);
+			scale(samples, vR, rLo, rHi);
+			addToOutput(out + i, halve(_mm256_add_epi32(lo, rLo)), halve(_mm256_add_epi32(hi, rHi)));
+		}
+	} else if (mode == RateKernels::kMonoToStereo) {
+		const __m256i vol = stereoVolume(volL, volR);
+		for (; i + 8 <= numFrames; i += 8) {
+			// Move samples 4-7 to the low half of the upper lane
+			__m256i samples = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(in + i)));
+			samples = _mm256_permute4x64_epi64(samples, _MM_SHUFFLE(1, 1, 1, 0));
+			scale(_mm256_unpacklo_epi16(samples, samples), vol, lo, hi);
+			addToOutput(out + i * 2, lo, hi);
+		}
+	} else if (mode == RateKernels::kStereoToMono) {
+		const __m256i vol = stereoVolume(volL, volR);
+		for (; i + 16 <= numFrames; i += 16) {
+			__m256i lo2, hi2;
+			scale(_mm256_loadu_si256((const __m256i *)(in + i * 2)), vol, lo, hi);
+			scale(_mm256_loadu_si256((const __m256i *)(in + i * 2 + 16)), vol, lo2, hi2);
+			__m256i sum1 = halve(addPairs(lo, hi));
+			__m256i sum2 = halve(addPairs(lo2, hi2));
+			addToOutput(out + i, _mm256_permute2x128_si256(sum1, sum2, 0x20), _mm256_permute2x128_si256(sum1, sum2, 0x31));
+		}
+	} else if (mode == RateKernels::kStereoToStereo) {
+		const __m256i vol = stereoVolume(volL, volR);
+		for (; i + 8 <= numFrames; i += 8) {
+			scale(_mm256_loadu_si256((const __m256i *)(in + i * 2)), vol, lo, hi);
+			addToOutput(out + i * 2, lo, hi);
+		}
+	} else if (mode == RateKernels::kStereoToStereoReversed) {
+		// Swap the channels of the input, so that each lane lines up with
+		// the output sample it is mixed into
+		const __m256i vol = stereoVolume(volR, volL);
+		for (; i + 8 <= numFrames; i += 8) {
+			__m256i samples = _mm256_loadu_si256((const __m256i *)(in + i * 2));
+			samples = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(samples, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+			scale(samples, vol, lo, hi);
+			addToOutput(out + i * 2, lo, hi);
+		}
+	}
+
+	// Mix the remaining frames
+	const int inChannels = (mode == RateKernels::kMonoToMono || mode == RateKernels::kMonoToStereo) ? 1 : 2;
+	const int outChannels = (mode == RateKernels::kMonoToMono || mode == RateKernels::kStereoToMono) ? 1 : 2;
+	RateKernels::mixRemaining(mode, out + i * outChannels, in + i * inChannels, numFrames - i, volL, volR);
+}
+
+static void interpolate(st_sample_t *out, const st_sample_t *pairs, const int16 *weights, uint numSamples) {
+	const __m256i half = _mm256_set1_epi32(RateKernels::kFracHalf);
+	uint i = 0;
+
+	for (; i + 16 <= numSamples; i += 16) {
+		__m256i p1 = _mm256_loadu_si256((const __m256i *)(pairs + i * 2));
+		__m256i p2 = _mm256_loadu_si256((const __m256i *)(pairs + i * 2 + 16));
+		__m256i w1 = _mm256_loadu_si256((const __m256i *)(weights + i * 2));
+		__m256i w2 = _mm256_loadu_si256((const __m256i *)(weights + i * 2 + 16));
+
+		// last * (kFracOne - 1 - frac) + cur * frac + last + kFracHalf
+		__m256i r1 = _mm256_add_epi32(_mm256_madd_epi16(p1, w1), _mm256_srai_epi32(_mm256_slli_epi32(p1, 16), 16));
+		__m256i r2 = _mm256_add_epi32(_mm256_madd_epi16(p2, w2), _mm256_srai_epi32(_mm256_slli_epi32(p2, 16), 16));
+		r1 = _mm256_srai_epi32(_mm256_add_epi32(r1, half), RateKernels::kFracBits);
+		r2 = _mm256_srai_epi32(_mm256_add_epi32(r2, half), RateKernels::kFracBits);
+
+		// Undo the lane interleaving of the pack
+		__m256i res = _mm256_permute4x64_epi64(_mm256_packs_epi32(r1, r2), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256((__m256i *)(out + i), res);
+	}
+
+	RateKernels::generic.interpolate(out + i, pairs + i * 2, weights + i * 2, numSamples - i);
+}
+
+static void clamp(st_sample_t *out, const int32 *in, uint numSamples) {
+	uint i = 0;
+
+	for (; i + 16 <= numSamples; i += 16) {
+		__m256i res = _mm256_packs_epi32(_mm256_loadu_si256((const __m256i *)(in + i)), _mm256_loadu_si256((const __m256i *)(in + i + 8)));
+		// Undo the lane interleaving of the pack
+		res = _mm256_permute4x64_epi64(res, _MM_SHUFFLE(3, 1, 2, 0));
+#ifdef OUTPUT_UNSIGNED_AUDIO
+		res = _mm256_xor_si256(res, _mm256_set1_epi16((short)0x8000));
+#endif
+		_mm256_storeu_si256((__m256i *)(out + i), res);
+	}
+
+	RateKernels::generic.clamp(out + i, in + i, numSamples - i);
+}
+
+}; // End of class RateKernelsImpl_AVX2
+
+const RateKernels::Table RateKernels::avx2 = {
+	{
+		RateKernelsImpl_AVX2::mix<RateKernels::kMonoToMono, st_sample_t>,
+		RateKernelsImpl_AVX2::mix<RateKernels::kMonoToStereo, st_sample_t>,
+		RateKernelsImpl_AVX2::mix<RateKernels::kStereoToMono, st_sample_t>,
+		RateKernelsImpl_AVX2::mix<RateKernels::kStereoToStereo, st_sample_t>,
+		RateKernelsImpl_AVX2::mix<RateKernels::kStereoToStereoReversed, st_sample_t>
+	},
+	{
+		RateKernelsImpl_AVX2::mix<RateKernels::kMonoToMono, int32>,
+		RateKernelsImpl_AVX2::mix<RateKernels::kMonoToStereo, int32>,
+		RateKernelsImpl_AVX2::mix<RateKernels::kStereoToMono, int32>,
+		RateKernelsImpl_AVX2::mix<RateKernels::kStereoToStereo, int32>,
+		RateKernelsImpl_AVX2::mix<RateKernels::kStereoToStereoReversed, int32>
+	},
+	RateKernelsImpl_AVX2::interpolate,
+	RateKernelsImpl_AVX2::clamp
+};
+
+} // End of namespace Audio
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
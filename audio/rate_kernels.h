@@ -0,0 +1,125 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AUDIO_RATE_KERNELS_H
+#define AUDIO_RATE_KERNELS_H
+
+#include "audio/rate.h"
+
+#include "common/cpu-kernels.h"
+
+namespace Audio {
+
+/**
+ * The inner loops of the rate converter. They are kept separate from
+ * RateConverter_Impl so that SIMD versions can be selected at runtime,
+ * through Common::CpuKernels.
+ */
+class RateKernels {
+public:
+	/** The channel layouts a rate converter can be created for. */
+	enum Mode {
+		kMonoToMono,
+		kMonoToStereo,
+		kStereoToMono,
+		kStereoToStereo,
+		kStereoToStereoReversed,
+		kModeCount
+	};
+
+	enum {
+		/** Fractional bits used by the interpolating converter. */
+		kFracBits = 15,
+		kFracOne = (1 << kFracBits),
+		kFracHalf = (1 << (kFracBits - 1)),
+
+		/**
+		 * The largest volume the SIMD kernels handle, Mixer::kMaxMixerVolume.
+		 * With bigger volumes the scaled samples overflow 16 bits, which the
+		 * SIMD kernels do not reproduce; callers fall back to the generic
+		 * kernels for them.
+		 */
+		kMaxSIMDVolume = 256
+	};
+
+	/**
+	 * Scales @p numFrames frames from @p in by the channel volumes and adds
+	 * them with clipping to @p out.
+	 */
+	typedef void (*MixFunc)(st_sample_t *out, const st_sample_t *in, uint numFrames, st_volume_t volL, st_volume_t volR);
+
+	/**
+	 * Scales @p numFrames frames from @p in by the channel volumes and adds
+	 * them to the 32-bit mixing bus @p out, without clipping.
+	 */
+	typedef void (*MixBusFunc)(int32 *out, const st_sample_t *in, uint numFrames, st_volume_t volL, st_volume_t volR);
+
+	/** Clips @p numSamples samples of a mixing bus to output samples. */
+	typedef void (*ClampFunc)(st_sample_t *out, const int32 *in, uint numSamples);
+
+	/**
+	 * Computes @p numSamples linearly interpolated samples. For each sample,
+	 * @p pairs holds the previous and the current input sample, and
+	 * @p weights holds (kFracOne - 1 - frac, frac).
+	 */
+	typedef void (*InterpolateFunc)(st_sample_t *out, const st_sample_t *pairs, const int16 *weights, uint numSamples);
+
+	struct Table {
+		MixFunc mix[kModeCount];
+		MixBusFunc mixBus[kModeCount];
+		InterpolateFunc interpolate;
+		ClampFunc clamp;
+	};
+
+	static const Table generic;
+#ifdef SCUMMVM_NEON
+	static const Table neon;
+#endif
+#ifdef SCUMMVM_SSE2
+	static const Table sse2;
+#endif
+#ifdef SCUMMVM_AVX2
+	static const Table avx2;
+#endif
+
+	/** The kernels in use, see Common::CpuKernels. */
+	static const Table *kernels;
+
+	static const Table &get() { return Common::CpuKernels<RateKernels>::get(); }
+
+	/**
+	 * Mix frames with the generic kernels, into output samples or into a
+	 * mixing bus. The SIMD kernels use them for the frames left over.
+	 */
+	static void mixRemaining(Mode mode, st_sample_t *out, const st_sample_t *in, uint numFrames, st_volume_t volL, st_volume_t volR) {
+		generic.mix[mode](out, in, numFrames, volL, volR);
+	}
+
+	static void mixRemaining(Mode mode, int32 *out, const st_sample_t *in, uint numFrames, st_volume_t volL, st_volume_t volR) {
+		generic.mixBus[mode](out, in, numFrames, volL, volR);
+	}
+
+private:
+};
+
+} // End of namespace Audio
+
+#endif
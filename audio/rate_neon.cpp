@@ -0,0 +1,213 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "audio/rate_kernels.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace Audio {
+
+class RateKernelsImpl_NEON {
+public:
+
+/**
+ * Multiplies the samples by the volumes and divides by kMaxMixerVolume,
+ * rounding towards zero like the generic code does.
+ */
+static inline void scale(int16x8_t samples, int16x8_t vol, int32x4_t &lo, int32x4_t &hi) {
+	lo = vmull_s16(vget_low_s16(samples), vget_low_s16(vol));
+	hi = vmull_s16(vget_high_s16(samples), vget_high_s16(vol));
+	lo = vshrq_n_s32(vaddq_s32(lo, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(lo, 31)), 24))), 8);
+	hi = vshrq_n_s32(vaddq_s32(hi, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(hi, 31)), 24))), 8);
+}
+
+/** Divides by two, rounding towards zero. */
+static inline int32x4_t halve(int32x4_t val) {
+	return vshrq_n_s32(vaddq_s32(val, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(val), 31))), 1);
+}
+
+/** Sums the adjacent pairs of the eight values in lo and hi. */
+static inline int32x4_t addPairs(int32x4_t lo, int32x4_t hi) {
+	int32x4x2_t split = vuzpq_s32(lo, hi);
+	return vaddq_s32(split.val[0], split.val[1]);
+}
+
+/** Adds eight 32-bit values to eight output samples, clipping the result. */
+static inline void addToOutput(st_sample_t *out, int32x4_t lo, int32x4_t hi) {
+	int16x8_t dst = vld1q_s16(out);
+#ifdef OUTPUT_UNSIGNED_AUDIO
+	dst = veorq_s16(dst, vdupq_n_s16((int16)0x8000));
+#endif
+	lo = vaddq_s32(lo, vmovl_s16(vget_low_s16(dst)));
+	hi = vaddq_s32(hi, vmovl_s16(vget_high_s16(dst)));
+	dst = vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi));
+#ifdef OUTPUT_UNSIGNED_AUDIO
+	dst = veorq_s16(dst, vdupq_n_s16((int16)0x8000));
+#endif
+	vst1q_s16(out, dst);
+}
+
+static inline int16x8_t stereoVolume(st_volume_t volL, st_volume_t volR) {
+	return vreinterpretq_s16_u32(vdupq_n_u32((uint32)volR << 16 | volL));
+}
+
+/** Adds eight 32-bit values to eight mixing bus samples. */
+static inline void addToOutput(int32 *out, int32x4_t lo, int32x4_t hi) {
+	vst1q_s32(out, vaddq_s32(vld1q_s32(out), lo));
+	vst1q_s32(out + 4, vaddq_s32(vld1q_s32(out + 4), hi));
+}
+
+template<RateKernels::Mode mode, typename T>
+static void mix(T *out, const st_sample_t *in, uint numFrames, st_volume_t volL, st_volume_t volR) {
+	uint i = 0;
+	int32x4_t lo, hi;
+
+	if (mode == RateKernels::kMonoToMono) {
+		const int16x8_t vL = vdupq_n_s16(volL);
+		const int16x8_t vR = vdupq_n_s16(volR);
+		for (; i + 8 <= numFrames; i += 8) {
+			int16x8_t samples = vld1q_s16(in + i);
+			int32x4_t rLo, rHi;
+			scale(samples, vL, lo, hi);
+			scale(samples, vR, rLo, rHi);
+			addToOutput(out + i, halve(vaddq_s32(lo, rLo)), halve(vaddq_s32(hi, rHi)));
+		}
+	} else if (mode == RateKernels::kMonoToStereo) {
+		const int16x8_t vol = stereoVolume(volL, volR);
+		for (; i + 4 <= numFrames; i += 4) {
+			int16x4_t samples = vld1_s16(in + i);
+			int16x4x2_t dup = vzip_s16(samples, samples);
+			scale(vcombine_s16(dup.val[0], dup.val[1]), vol, lo, hi);
+			addToOutput(out + i * 2, lo, hi);
+		}
+	} else if (mode == RateKernels::kStereoToMono) {
+		const int16x8_t vol = stereoVolume(volL, volR);
+		for (; i + 8 <= numFrames; i += 8) {
+			int32x4_t lo2, hi2;
+			scale(vld1q_s16(in + i * 2), vol, lo, hi);
+			scale(vld1q_s16(in + i * 2 + 8), vol, lo2, hi2);
+			addToOutput(out + i, halve(addPairs(lo, hi)), halve(addPairs(lo2, hi2)));
+		}
+	} else if (mode == RateKernels::kStereoToStereo) {
+		const int16x8_t vol = stereoVolume(volL, volR);
+		for (; i + 4 <= numFrames; i += 4) {
+			scale(vld1q_s16(in + i * 2), vol, lo, hi);
+			addToOutput(out + i * 2, lo, hi);
+		}
+	} else if (mode == RateKernels::kStereoToStereoReversed) {
+		// Swap the channels of the input, so that each lane lines up with
+		// the output sample it is mixed into
+		const int16x8_t vol = stereoVolume(volR, volL);
+		for (; i + 4 <= numFrames; i += 4) {
+			scale(vrev32q_s16(vld1q_s16(in + i * 2)), vol, lo, hi);
+			addToOutput(out + i * 2, lo, hi);
+		}
+	}
+
+	// Mix the remaining frames
+	const int inChannels = (mode == RateKernels::kMonoToMono || mode == RateKernels::kMonoToStereo) ? 1 : 2;
+	const int outChannels = (mode == RateKernels::kMonoToMono || mode == RateKernels::kStereoToMono) ? 1 : 2;
+	RateKernels::mixRemaining(mode, out + i * outChannels, in + i * inChannels, numFrames - i, volL, volR);
+}
+
+static void interpolate(st_sample_t *out, const st_sample_t *pairs, const int16 *weights, uint numSamples) {
+	const int32x4_t half = vdupq_n_s32(RateKernels::kFracHalf);
+	uint i = 0;
+
+	for (; i + 8 <= numSamples; i += 8) {
+		int16x8x2_t p = vld2q_s16(pairs + i * 2);
+		int16x8x2_t w = vld2q_s16(weights + i * 2);
+
+		// last * (kFracOne - 1 - frac) + cur * frac + last + kFracHalf
+		int32x4_t r1 = vaddq_s32(vmovl_s16(vget_low_s16(p.val[0])), half);
+		int32x4_t r2 = vaddq_s32(vmovl_s16(vget_high_s16(p.val[0])), half);
+		r1 = vmlal_s16(vmlal_s16(r1, vget_low_s16(p.val[0]), vget_low_s16(w.val[0])), vget_low_s16(p.val[1]), vget_low_s16(w.val[1]));
+		r2 = vmlal_s16(vmlal_s16(r2, vget_high_s16(p.val[0]), vget_high_s16(w.val[0])), vget_high_s16(p.val[1]), vget_high_s16(w.val[1]));
+
+		vst1q_s16(out + i, vcombine_s16(vshrn_n_s32(r1, RateKernels::kFracBits), vshrn_n_s32(r2, RateKernels::kFracBits)));
+	}
+
+	RateKernels::generic.interpolate(out + i, pairs + i * 2, weights + i * 2, numSamples - i);
+}
+
+static void clamp(st_sample_t *out, const int32 *in, uint numSamples) {
+	uint i = 0;
+
+	for (; i + 8 <= numSamples; i += 8) {
+		int16x8_t res = vcombine_s16(vqmovn_s32(vld1q_s32(in + i)), vqmovn_s32(vld1q_s32(in + i + 4)));
+#ifdef OUTPUT_UNSIGNED_AUDIO
+		res = veorq_s16(res, vdupq_n_s16((int16)0x8000));
+#endif
+		vst1q_s16(out + i, res);
+	}
+
+	RateKernels::generic.clamp(out + i, in + i, numSamples - i);
+}
+
+}; // End of class RateKernelsImpl_NEON
+
+const RateKernels::Table RateKernels::neon = {
+	{
+		RateKernelsImpl_NEON::mix<RateKernels::kMonoToMono, st_sample_t>,
+		RateKernelsImpl_NEON::mix<RateKernels::kMonoToStereo, st_sample_t>,
+		RateKernelsImpl_NEON::mix<RateKernels::kStereoToMono, st_sample_t>,
+		RateKernelsImpl_NEON::mix<RateKernels::kStereoToStereo, st_sample_t>,
+		RateKernelsImpl_NEON::mix<RateKernels::kStereoToStereoReversed, st_sample_t>
+	},
+	{
+		RateKernelsImpl_NEON::mix<RateKernels::kMonoToMono, int32>,
+		RateKernelsImpl_NEON::mix<RateKernels::kMonoToStereo, int32>,
+		RateKernelsImpl_NEON::mix<RateKernels::kStereoToMono, int32>,
+		RateKernelsImpl_NEON::mix<RateKernels::kStereoToStereo, int32>,
+		RateKernelsImpl_NEON::mix<RateKernels::kStereoToStereoReversed, int32>
+	},
+	RateKernelsImpl_NEON::interpolate,
+	RateKernelsImpl_NEON::clamp
+};
+
+} // End of namespace Audio
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
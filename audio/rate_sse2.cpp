@@ -0,0 +1,211 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "audio/rate_kernels.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Audio {
+
+class RateKernelsImpl_SSE2 {
+public:
+
+/**
+ * Multiplies the samples by the volumes and divides by kMaxMixerVolume,
+ * rounding towards zero like the generic code does.
+ */
+static inline void scale(__m128i samples, __m128i vol, __m128i &lo, __m128i &hi) {
+	__m128i prodLo = _mm_mullo_epi16(samples, vol);
+	__m128i prodHi = _mm_mulhi_epi16(samples, vol);
+	lo = _mm_unpacklo_epi16(prodLo, prodHi);
+	hi = _mm_unpackhi_epi16(prodLo, prodHi);
+	lo = _mm_srai_epi32(_mm_add_epi32(lo, _mm_srli_epi32(_mm_srai_epi32(lo, 31), 24)), 8);
+	hi = _mm_srai_epi32(_mm_add_epi32(hi, _mm_srli_epi32(_mm_srai_epi32(hi, 31), 24)), 8);
+}
+
+/** Divides by two, rounding towards zero. */
+static inline __m128i halve(__m128i val) {
+	return _mm_srai_epi32(_mm_add_epi32(val, _mm_srli_epi32(val, 31)), 1);
+}
+
+/** Sums the adjacent pairs of the eight values in lo and hi. */
+static inline __m128i addPairs(__m128i lo, __m128i hi) {
+	__m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+	__m128 odd  = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+	return _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+}
+
+/** Adds eight 32-bit values to eight output samples, clipping the result. */
+static inline void addToOutput(st_sample_t *out, __m128i lo, __m128i hi) {
+	__m128i dst = _mm_loadu_si128((const __m128i *)out);
+#ifdef OUTPUT_UNSIGNED_AUDIO
+	dst = _mm_xor_si128(dst, _mm_set1_epi16((short)0x8000));
+#endif
+	lo = _mm_add_epi32(lo, _mm_srai_epi32(_mm_unpacklo_epi16(dst, dst), 16));
+	hi = _mm_add_epi32(hi, _mm_srai_epi32(_mm_unpackhi_epi16(dst, dst), 16));
+	dst = _mm_packs_epi32(lo, hi);
+#ifdef OUTPUT_UNSIGNED_AUDIO
+	dst = _mm_xor_si128(dst, _mm_set1_epi16((short)0x8000));
+#endif
+	_mm_storeu_si128((__m128i *)out, dst);
+}
+
+/** Adds eight 32-bit values to eight mixing bus samples. */
+static inline void addToOutput(int32 *out, __m128i lo, __m128i hi) {
+	_mm_storeu_si128((__m128i *)out, _mm_add_epi32(_mm_loadu_si128((const __m128i *)out), lo));
+	_mm_storeu_si128((__m128i *)(out + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(out + 4)), hi));
+}
+
+template<RateKernels::Mode mode, typename T>
+static void mix(T *out, const st_sample_t *in, uint numFrames, st_volume_t volL, st_volume_t volR) {
+	uint i = 0;
+	__m128i lo, hi;
+
+	if (mode == RateKernels::kMonoToMono) {
+		const __m128i vL = _mm_set1_epi16(volL);
+		const __m128i vR = _mm_set1_epi16(volR);
+		for (; i + 8 <= numFrames; i += 8) {
+			__m128i samples = _mm_loadu_si128((const __m128i *)(in + i));
+			__m128i rLo, rHi;
+			scale(samples, vL, lo, hi);
+			scale(samples, vR, rLo, rHi);
+			addToOutput(out + i, halve(_mm_add_epi32(lo, rLo)), halve(_mm_add_epi32(hi, rHi)));
+		}
+	} else if (mode == RateKernels::kMonoToStereo) {
+		const __m128i vol = _mm_setr_epi16(volL, volR, volL, volR, volL, volR, volL, volR);
+		for (; i + 4 <= numFrames; i += 4) {
+			__m128i samples = _mm_loadl_epi64((const __m128i *)(in + i));
+			scale(_mm_unpacklo_epi16(samples, samples), vol, lo, hi);
+			addToOutput(out + i * 2, lo, hi);
+		}
+	} else if (mode == RateKernels::kStereoToMono) {
+		const __m128i vol = _mm_setr_epi16(volL, volR, volL, volR, volL, volR, volL, volR);
+		for (; i + 8 <= numFrames; i += 8) {
+			__m128i lo2, hi2;
+			scale(_mm_loadu_si128((const __m128i *)(in + i * 2)), vol, lo, hi);
+			scale(_mm_loadu_si128((const __m128i *)(in + i * 2 + 8)), vol, lo2, hi2);
+			addToOutput(out + i, halve(addPairs(lo, hi)), halve(addPairs(lo2, hi2)));
+		}
+	} else if (mode == RateKernels::kStereoToStereo) {
+		const __m128i vol = _mm_setr_epi16(volL, volR, volL, volR, volL, volR, volL, volR);
+		for (; i + 4 <= numFrames; i += 4) {
+			scale(_mm_loadu_si128((const __m128i *)(in + i * 2)), vol, lo, hi);
+			addToOutput(out + i * 2, lo, hi);
+		}
+	} else if (mode == RateKernels::kStereoToStereoReversed) {
+		// Swap the channels of the input, so that each lane lines up with
+		// the output sample it is mixed into
+		const __m128i vol = _mm_setr_epi16(volR, volL, volR, volL, volR, volL, volR, volL);
+		for (; i + 4 <= numFrames; i += 4) {
+			__m128i samples = _mm_loadu_si128((const __m128i *)(in + i * 2));
+			samples = _mm_shufflehi_epi16(_mm_shufflelo_epi16(samples, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+			scale(samples, vol, lo, hi);
+			addToOutput(out + i * 2, lo, hi);
+		}
+	}
+
+	// Mix the remaining frames
+	const int inChannels = (mode == RateKernels::kMonoToMono || mode == RateKernels::kMonoToStereo) ? 1 : 2;
+	const int outChannels = (mode == RateKernels::kMonoToMono || mode == RateKernels::kStereoToMono) ? 1 : 2;
+	RateKernels::mixRemaining(mode, out + i * outChannels, in + i * inChannels, numFrames - i, volL, volR);
+}
+
+static void interpolate(st_sample_t *out, const st_sample_t *pairs, const int16 *weights, uint numSamples) {
+	const __m128i half = _mm_set1_epi32(RateKernels::kFracHalf);
+	uint i = 0;
+
+	for (; i + 8 <= numSamples; i += 8) {
+		__m128i p1 = _mm_loadu_si128((const __m128i *)(pairs + i * 2));
+		__m128i p2 = _mm_loadu_si128((const __m128i *)(pairs + i * 2 + 8));
+		__m128i w1 = _mm_loadu_si128((const __m128i *)(weights + i * 2));
+		__m128i w2 = _mm_loadu_si128((const __m128i *)(weights + i * 2 + 8));
+
+		// last * (kFracOne - 1 - frac) + cur * frac + last + kFracHalf
+		__m128i r1 = _mm_add_epi32(_mm_madd_epi16(p1, w1), _mm_srai_epi32(_mm_slli_epi32(p1, 16), 16));
+		__m128i r2 = _mm_add_epi32(_mm_madd_epi16(p2, w2), _mm_srai_epi32(_mm_slli_epi32(p2, 16), 16));
+		r1 = _mm_srai_epi32(_mm_add_epi32(r1, half), RateKernels::kFracBits);
+		r2 = _mm_srai_epi32(_mm_add_epi32(r2, half), RateKernels::kFracBits);
+
+		_mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi32(r1, r2));
+	}
+
+	RateKernels::generic.interpolate(out + i, pairs + i * 2, weights + i * 2, numSamples - i);
+}
+
+static void clamp(st_sample_t *out, const int32 *in, uint numSamples) {
+	uint i = 0;
+
+	for (; i + 8 <= numSamples; i += 8) {
+		__m128i res = _mm_packs_epi32(_mm_loadu_si128((const __m128i *)(in + i)), _mm_loadu_si128((const __m128i *)(in + i + 4)));
+#ifdef OUTPUT_UNSIGNED_AUDIO
+		res = _mm_xor_si128(res, _mm_set1_epi16((short)0x8000));
+#endif
+		_mm_storeu_si128((__m128i *)(out + i), res);
+	}
+
+	RateKernels::generic.clamp(out + i, in + i, numSamples - i);
+}
+
+}; // End of class RateKernelsImpl_SSE2
+
+const RateKernels::Table RateKernels::sse2 = {
+	{
+		RateKernelsImpl_SSE2::mix<RateKernels::kMonoToMono, st_sample_t>,
+		RateKernelsImpl_SSE2::mix<RateKernels::kMonoToStereo, st_sample_t>,
+		RateKernelsImpl_SSE2::mix<RateKernels::kStereoToMono, st_sample_t>,
+		RateKernelsImpl_SSE2::mix<RateKernels::kStereoToStereo, st_sample_t>,
+		RateKernelsImpl_SSE2::mix<RateKernels::kStereoToStereoReversed, st_sample_t>
+	},
+	{
+		RateKernelsImpl_SSE2::mix<RateKernels::kMonoToMono, int32>,
+		RateKernelsImpl_SSE2::mix<RateKernels::kMonoToStereo, int32>,
+		RateKernelsImpl_SSE2::mix<RateKernels::kStereoToMono, int32>,
+		RateKernelsImpl_SSE2::mix<RateKernels::kStereoToStereo, int32>,
+		RateKernelsImpl_SSE2::mix<RateKernels::kStereoToStereoReversed, int32>
+	},
+	RateKernelsImpl_SSE2::interpolate,
+	RateKernelsImpl_SSE2::clamp
+};
+
+} // End of namespace Audio
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
@@ -0,0 +1,162 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/system.h"
+#include "common/thread.h"
+
+#include "audio/softsynth/emumidi.h"
+
+MidiDriver_Emulated::~MidiDriver_Emulated() {
+	// The render thread calls generateSamples(), so the subclass must have
+	// stopped it before it was destroyed
+	assert(!_renderThread);
+	delete _renderRing;
+}
+
+void MidiDriver_Emulated::render(int16 *data, int numSamples) {
+	const int stereoFactor = isStereo() ? 2 : 1;
+	int len = numSamples / stereoFactor;
+	int step;
+
+	do {
+		step = len;
+		if (step > (_nextTick >> FIXP_SHIFT))
+			step = (_nextTick >> FIXP_SHIFT);
+
+		if (_idle.load())
+			memset(data, 0, step * stereoFactor * sizeof(int16));
+		else
+			generateSamples(data, step);
+
+		_nextTick -= step << FIXP_SHIFT;
+		if (!(_nextTick >> FIXP_SHIFT)) {
+			if (_timerProc)
+				(*_timerProc)(_timerParam);
+
+			onTimer();
+
+			_nextTick += _samplesPerTick;
+		}
+
+		data += step * stereoFactor;
+		len -= step;
+	} while (len);
+}
+
+int MidiDriver_Emulated::readBuffer(int16 *data, const int numSamples) {
+	if (!_renderThread) {
+		render(data, numSamples);
+		return numSamples;
+	}
+
+	int samples = _renderRing->pop(data, numSamples);
+	if (samples < numSamples) {
+		// The render thread fell behind: render the rest here rather than
+		// let the mixer play silence
+		Common::StackLock lock(_renderMutex);
+		samples += _renderRing->pop(data + samples, numSamples - samples);
+		if (samples < numSamples)
+			render(data + samples, numSamples - samples);
+	}
+
+	wakeRenderThread();
+	return numSamples;
+}
+
+bool MidiDriver_Emulated::startRenderThread() {
+	assert(_isOpen && !_renderThread);
+
+	_renderWake = g_system->createSemaphore();
+	if (!_renderWake)
+		return false;
+
+	const int stereoFactor = isStereo() ? 2 : 1;
+	const uint chunkSamples = kRenderChunkFrames * stereoFactor;
+
+	// Stay one mixer callback and one chunk ahead, which the mixer can take
+	// all at once without running dry
+	const uint callbackFrames = (uint)((uint64)_mixer->getOutputBufSize() * getRate() / _mixer->getOutputRate());
+	_renderAhead = MIN<uint>(callbackFrames * stereoFactor + chunkSamples, kRenderRingSize);
+	_renderAhead = MAX<uint>(_renderAhead, chunkSamples);
+
+	if (!_renderRing)
+		_renderRing = new Common::SPSCQueue<int16, kRenderRingSize>();
+	_renderRing->clear();
+	_renderWakePending.store(0);
+	_renderQuit.store(0);
+
+	_renderThread = g_system->createThread(renderThreadProc, this);
+	if (!_renderThread) {
+		delete _renderWake;
+		_renderWake = nullptr;
+		return false;
+	}
+
+	wakeRenderThread();
+	return true;
+}
+
+void MidiDriver_Emulated::stopRenderThread() {
+	if (!_renderThread)
+		return;
+
+	_renderQuit.store(1);
+	_renderWake->post();
+	_renderThread->join();
+
+	delete _renderThread;
+	delete _renderWake;
+	_renderThread = nullptr;
+	_renderWake = nullptr;
+
+	// The samples left are dropped, like the ones the mixer had not played
+	_renderRing->clear();
+}
+
+void MidiDriver_Emulated::wakeRenderThread() {
+	const uint chunkSamples = kRenderChunkFrames * (isStereo() ? 2 : 1);
+	if (_renderRing->count() + chunkSamples <= _renderAhead && _renderWakePending.exchange(1) == 0)
+		_renderWake->post();
+}
+
+void MidiDriver_Emulated::renderThreadProc(void *data) {
+	((MidiDriver_Emulated *)data)->renderThreadLoop();
+}
+
+void MidiDriver_Emulated::renderThreadLoop() {
+	const uint chunkSamples = kRenderChunkFrames * (isStereo() ? 2 : 1);
+
+	for (;;) {
+		_renderWake->wait();
+		if (_renderQuit.load())
+			break;
+
+		_renderWakePending.store(0);
+
+		// Render one chunk at a time, so that the mixer can take the mutex
+		// in between when it runs dry
+		while (!_renderQuit.load() && _renderRing->count() + chunkSamples <= _renderAhead) {
+			Common::StackLock lock(_renderMutex);
+			render(_renderChunk, chunkSamples);
+			_renderRing->push(_renderChunk, chunkSamples);
+		}
+	}
+}
@@ -22,13 +22,24 @@
 #ifndef AUDIO_SOFTSYNTH_EMUMIDI_H
 #define AUDIO_SOFTSYNTH_EMUMIDI_H
 
+#include "common/atomic.h"
+#include "common/mutex.h"
+#include "common/spsc-queue.h"
+
 #include "audio/audiostream.h"
 #include "audio/mididrv.h"
 #include "audio/mixer.h"
 
+namespace Common {
+class SemaphoreInternal;
+class ThreadInternal;
+}
+
 class MidiDriver_Emulated : public Audio::AudioStream, public MidiDriver {
 protected:
 	bool _isOpen;
+	/** Whether the samples are read by the caller, rather than by the mixer. */
+	bool _offline;
 	Audio::Mixer *_mixer;
 	Audio::SoundHandle _mixerSoundHandle;
 
@@ -37,29 +48,81 @@ private:
 	void *_timerParam;
 
 	enum {
-		FIXP_SHIFT = 16
+		FIXP_SHIFT = 16,
+
+		/** Capacity of the ring of samples rendered ahead, in samples. */
+		kRenderRingSize = 16384,
+		/** Number of frames rendered at a time by the render thread. */
+		kRenderChunkFrames = 256
 	};
 
 	int _nextTick;
 	int _samplesPerTick;
 
+	/**
+	 * The render thread, which renders the samples ahead of the mixer into
+	 * a ring, and calls the timer callback at the same sample positions as
+	 * the mixer would. _renderMutex serializes the rendering between that
+	 * thread and the mixer, when the mixer runs dry.
+	 */
+	Common::ThreadInternal *_renderThread;
+	Common::SemaphoreInternal *_renderWake;
+	Common::Atomic<uint32> _renderWakePending;
+	Common::Atomic<uint32> _renderQuit;
+	Common::Atomic<uint32> _idle;
+	Common::Mutex _renderMutex;
+	Common::SPSCQueue<int16, kRenderRingSize> *_renderRing;
+	/** Number of samples the render thread keeps ahead of the mixer. */
+	uint _renderAhead;
+	int16 _renderChunk[kRenderChunkFrames * 2];
+
+	void render(int16 *data, int numSamples);
+	void wakeRenderThread();
+	static void renderThreadProc(void *data);
+	void renderThreadLoop();
+
 protected:
 	int _baseFreq;
 
 	virtual void generateSamples(int16 *buf, int len) = 0;
 	virtual void onTimer() {}
 
+	/**
+	 * Render the samples on a thread of their own, a few milliseconds ahead
+	 * of the mixer, so that heavy synths do not make the audio callback take
+	 * too long. The timer callback is then called from that thread.
+	 *
+	 * Call it from open(), before the driver is given to the mixer. It does
+	 * nothing when the backend does not support threads.
+	 *
+	 * @return True if the render thread was started.
+	 */
+	bool startRenderThread();
+
+	/**
+	 * Stop the render thread, if any. Call it from close(), once the driver
+	 * was removed from the mixer, and before the synth is destroyed.
+	 */
+	void stopRenderThread();
+
 public:
 	MidiDriver_Emulated(Audio::Mixer *mixer) :
 		_mixer(mixer),
 		_isOpen(false),
+		_offline(false),
 		_timerProc(0),
 		_timerParam(0),
 		_nextTick(0),
 		_samplesPerTick(0),
+		_renderThread(nullptr),
+		_renderWake(nullptr),
+		_renderRing(nullptr),
+		_renderAhead(0),
 		_baseFreq(250) {
 	}
 
+	~MidiDriver_Emulated();
+
 	// MidiDriver API
 	virtual int open() {
 		_isOpen = true;
@@ -77,6 +140,22 @@ public:
 
 	bool isOpen() const { return _isOpen; }
 
+	/**
+	 * Let the caller read the samples with readBuffer(), rather than give
+	 * the driver to the mixer, e.g. to render a song faster than real time.
+	 * Call it before open().
+	 */
+	void setOffline(bool offline) { _offline = offline; }
+	bool isOffline() const { return _offline; }
+
+	/**
+	 * Output silence instead of running the synth, e.g. while the music is
+	 * played from the render cache. The timer callback is still called at
+	 * the same positions.
+	 */
+	void setIdle(bool idle) { _idle.store(idle ? 1 : 0); }
+	bool isIdle() const { return _idle.load() != 0; }
+
 	virtual void setTimerCallback(void *timer_param, Common::TimerManager::TimerProc timer_proc) {
 		_timerProc = timer_proc;
 		_timerParam = timer_param;
@@ -87,34 +166,7 @@ public:
 	}
 
 	// AudioStream API
-	virtual int readBuffer(int16 *data, const int numSamples) {
-		const int stereoFactor = isStereo() ? 2 : 1;
-		int len = numSamples / stereoFactor;
-		int step;
-
-		do {
-			step = len;
-			if (step > (_nextTick >> FIXP_SHIFT))
-				step = (_nextTick >> FIXP_SHIFT);
-
-			generateSamples(data, step);
-
-			_nextTick -= step << FIXP_SHIFT;
-			if (!(_nextTick >> FIXP_SHIFT)) {
-				if (_timerProc)
-					(*_timerProc)(_timerParam);
-
-				onTimer();
-
-				_nextTick += _samplesPerTick;
-			}
-
-			data += step * stereoFactor;
-			len -= step;
-		} while (len);
-
-		return numSamples;
-	}
+	virtual int readBuffer(int16 *data, const int numSamples);
 
 	virtual bool endOfData() const {
 		return false;
@@ -112,6 +112,7 @@ protected:
 
 public:
 	MidiDriver_FluidSynth(Audio::Mixer *mixer);
+	~MidiDriver_FluidSynth();
 
 	static Common::Path getSoundFontPath(bool *exists = nullptr);
 
@@ -149,6 +150,10 @@ MidiDriver_FluidSynth::MidiDriver_FluidSynth(Audio::Mixer *mixer)
 		_outputRate = 96000;
 }
 
+MidiDriver_FluidSynth::~MidiDriver_FluidSynth() {
+	close();
+}
+
 // The string duplication below is there only because older versions (1.1.6
 // and earlier?) of FluidSynth expected the string parameters to be non-const.
 
@@ -502,7 +507,12 @@ int MidiDriver_FluidSynth::open() {
 
 	MidiDriver_Emulated::open();
 
-	_mixer->playStream(Audio::Mixer::kPlainSoundType, &_mixerSoundHandle, this, -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::NO, true);
+	if (!_offline) {
+		if (ConfMan.getBool("midi_render_thread"))
+			startRenderThread();
+
+		_mixer->playStream(Audio::Mixer::kPlainSoundType, &_mixerSoundHandle, this, -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::NO, true);
+	}
 
 	return 0;
 }
@@ -513,6 +523,7 @@ void MidiDriver_FluidSynth::close() {
 	_isOpen = false;
 
 	_mixer->stopHandle(_mixerSoundHandle);
+	stopRenderThread();
 
 	if (_soundFont != -1)
 		fluid_synth_sfunload(_synth, _soundFont, 1);
@@ -220,7 +220,12 @@ int MidiDriver_MT32::open() {
 
 	MidiDriver_Emulated::open();
 
-	_mixer->playStream(Audio::Mixer::kPlainSoundType, &_mixerSoundHandle, this, -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::NO, true);
+	if (!_offline) {
+		if (ConfMan.getBool("midi_render_thread"))
+			startRenderThread();
+
+		_mixer->playStream(Audio::Mixer::kPlainSoundType, &_mixerSoundHandle, this, -1, Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::NO, true);
+	}
 
 	return 0;
 }
@@ -268,10 +273,11 @@ void MidiDriver_MT32::close() {
 		return;
 	_isOpen = false;
 
-	// Detach the player callback handler
-	setTimerCallback(nullptr, nullptr);
 	// Detach the mixer callback handler
 	_mixer->stopHandle(_mixerSoundHandle);
+	stopRenderThread();
+	// Detach the player callback handler
+	setTimerCallback(nullptr, nullptr);
 
 	Common::StackLock lock(_mutex);
 	_service.closeSynth();
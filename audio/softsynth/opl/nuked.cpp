@@ -32,6 +32,7 @@
 #include "common/system.h"
 #include "common/scummsys.h"
 #include "nuked.h"
+#include "nuked_kernels.h"
 
 #ifndef DISABLE_NUKED_OPL
 
@@ -1111,15 +1112,84 @@ static void OPL3_ProcessSlot(opl3_slot *slot)
     OPL3_SlotGenerate(slot);
 }
 
+static void OPL3_ProcessChip(opl3_chip *chip)
+{
+    opl3_writebuf *writebuf;
+    uint8_t shift = 0;
+
+    if ((chip->timer & 0x3f) == 0x3f)
+    {
+        chip->tremolopos = (chip->tremolopos + 1) % 210;
+    }
+    if (chip->tremolopos < 105)
+    {
+        chip->tremolo = chip->tremolopos >> chip->tremoloshift;
+    }
+    else
+    {
+        chip->tremolo = (210 - chip->tremolopos) >> chip->tremoloshift;
+    }
+
+    if ((chip->timer & 0x3ff) == 0x3ff)
+    {
+        chip->vibpos = (chip->vibpos + 1) & 7;
+    }
+
+    chip->timer++;
+
+    if (chip->eg_state)
+    {
+        while (shift < 13 && ((chip->eg_timer >> shift) & 1) == 0)
+        {
+            shift++;
+        }
+        if (shift > 12)
+        {
+            chip->eg_add = 0;
+        }
+        else
+        {
+            chip->eg_add = shift + 1;
+        }
+        chip->eg_timer_lo = (uint8_t)(chip->eg_timer & 0x3u);
+    }
+
+    if (chip->eg_timerrem || chip->eg_state)
+    {
+        if (chip->eg_timer == UINT64_C(0xfffffffff))
+        {
+            chip->eg_timer = 0;
+            chip->eg_timerrem = 1;
+        }
+        else
+        {
+            chip->eg_timer++;
+            chip->eg_timerrem = 0;
+        }
+    }
+
+    chip->eg_state ^= 1;
+
+    while ((writebuf = &chip->writebuf[chip->writebuf_cur]), writebuf->time <= chip->writebuf_samplecnt)
+    {
+        if (!(writebuf->reg & 0x200))
+        {
+            break;
+        }
+        writebuf->reg &= 0x1ff;
+        OPL3_WriteReg(chip, writebuf->reg, writebuf->data);
+        chip->writebuf_cur = (chip->writebuf_cur + 1) % OPL_WRITEBUF_SIZE;
+    }
+    chip->writebuf_samplecnt++;
+}
+
 inline void OPL3_Generate4Ch(opl3_chip *chip, int16_t *buf4)
 {
     opl3_channel *channel;
-    opl3_writebuf *writebuf;
     int16_t **out;
     int32_t mix[2];
     uint8_t ii;
     int16_t accm;
-    uint8_t shift = 0;
 
     buf4[1] = OPL3_ClipSample(chip->mixbuff[1]);
     buf4[3] = OPL3_ClipSample(chip->mixbuff[3]);
@@ -1189,70 +1259,7 @@ inline void OPL3_Generate4Ch(opl3_chip *chip, int16_t *buf4)
     }
 #endif
 
-    if ((chip->timer & 0x3f) == 0x3f)
-    {
-        chip->tremolopos = (chip->tremolopos + 1) % 210;
-    }
-    if (chip->tremolopos < 105)
-    {
-        chip->tremolo = chip->tremolopos >> chip->tremoloshift;
-    }
-    else
-    {
-        chip->tremolo = (210 - chip->tremolopos) >> chip->tremoloshift;
-    }
-
-    if ((chip->timer & 0x3ff) == 0x3ff)
-    {
-        chip->vibpos = (chip->vibpos + 1) & 7;
-    }
-
-    chip->timer++;
-
-    if (chip->eg_state)
-    {
-        while (shift < 13 && ((chip->eg_timer >> shift) & 1) == 0)
-        {
-            shift++;
-        }
-        if (shift > 12)
-        {
-            chip->eg_add = 0;
-        }
-        else
-        {
-            chip->eg_add = shift + 1;
-        }
-        chip->eg_timer_lo = (uint8_t)(chip->eg_timer & 0x3u);
-    }
-
-    if (chip->eg_timerrem || chip->eg_state)
-    {
-        if (chip->eg_timer == UINT64_C(0xfffffffff))
-        {
-            chip->eg_timer = 0;
-            chip->eg_timerrem = 1;
-        }
-        else
-        {
-            chip->eg_timer++;
-            chip->eg_timerrem = 0;
-        }
-    }
-
-    chip->eg_state ^= 1;
-
-    while ((writebuf = &chip->writebuf[chip->writebuf_cur]), writebuf->time <= chip->writebuf_samplecnt)
-    {
-        if (!(writebuf->reg & 0x200))
-        {
-            break;
-        }
-        writebuf->reg &= 0x1ff;
-        OPL3_WriteReg(chip, writebuf->reg, writebuf->data);
-        chip->writebuf_cur = (chip->writebuf_cur + 1) % OPL_WRITEBUF_SIZE;
-    }
-    chip->writebuf_samplecnt++;
+    OPL3_ProcessChip(chip);
 }
 
 void OPL3_Generate(opl3_chip *chip, int16_t *buf)
@@ -1263,6 +1270,19 @@ void OPL3_Generate(opl3_chip *chip, int16_t *buf)
     buf[1] = samples[1];
 }
 
+static void OPL3_Resample4Ch(opl3_chip *chip, int16_t *buf4)
+{
+    buf4[0] = (int16_t)((chip->oldsamples[0] * (chip->rateratio - chip->samplecnt)
+                        + chip->samples[0] * chip->samplecnt) / chip->rateratio);
+    buf4[1] = (int16_t)((chip->oldsamples[1] * (chip->rateratio - chip->samplecnt)
+                        + chip->samples[1] * chip->samplecnt) / chip->rateratio);
+    buf4[2] = (int16_t)((chip->oldsamples[2] * (chip->rateratio - chip->samplecnt)
+                        + chip->samples[2] * chip->samplecnt) / chip->rateratio);
+    buf4[3] = (int16_t)((chip->oldsamples[3] * (chip->rateratio - chip->samplecnt)
+                        + chip->samples[3] * chip->samplecnt) / chip->rateratio);
+    chip->samplecnt += 1 << RSM_FRAC;
+}
+
 void OPL3_Generate4ChResampled(opl3_chip *chip, int16_t *buf4)
 {
     while (chip->samplecnt >= chip->rateratio)
@@ -1274,15 +1294,7 @@ void OPL3_Generate4ChResampled(opl3_chip *chip, int16_t *buf4)
         OPL3_Generate4Ch(chip, chip->samples);
         chip->samplecnt -= chip->rateratio;
     }
-    buf4[0] = (int16_t)((chip->oldsamples[0] * (chip->rateratio - chip->samplecnt)
-                        + chip->samples[0] * chip->samplecnt) / chip->rateratio);
-    buf4[1] = (int16_t)((chip->oldsamples[1] * (chip->rateratio - chip->samplecnt)
-                        + chip->samples[1] * chip->samplecnt) / chip->rateratio);
-    buf4[2] = (int16_t)((chip->oldsamples[2] * (chip->rateratio - chip->samplecnt)
-                        + chip->samples[2] * chip->samplecnt) / chip->rateratio);
-    buf4[3] = (int16_t)((chip->oldsamples[3] * (chip->rateratio - chip->samplecnt)
-                        + chip->samples[3] * chip->samplecnt) / chip->rateratio);
-    chip->samplecnt += 1 << RSM_FRAC;
+    OPL3_Resample4Ch(chip, buf4);
 }
 
 void OPL3_GenerateResampled(opl3_chip *chip, int16_t *buf)
@@ -1532,6 +1544,610 @@ void OPL3_GenerateStream(opl3_chip *chip, int16_t *sndptr, uint32_t numsamples)
     }
 }
 
+/*
+    Slot lanes
+*/
+
+static uint32_t OPL3_NoiseAdvance(uint32_t noise, uint8_t steps)
+{
+    /* Up to 9 steps, the new bits do not reach the tap at bit 14 yet */
+    uint32_t n_bits = (noise ^ (noise >> 14)) & ((1u << steps) - 1);
+    return (noise >> steps) | (n_bits << (23 - steps));
+}
+
+static void OPL3_LanesFeedback(opl3_lanes *lanes)
+{
+    uint8_t ii;
+    for (ii = 0; ii < kNumSlots; ii++)
+    {
+        int16_t out = lanes->out[ii];
+        /* (prout + out) >> (9 - fb), as a multiply-add and a fixed shift */
+        lanes->fbmod[ii] = (int16_t)(((lanes->out[kSlotLanes + ii] + out) * lanes->fb_mul[ii]) >> 8);
+        lanes->out[kSlotLanes + ii] = out;
+        lanes->mod[ii] = lanes->fbmod[ii] & lanes->fb_sel[ii];
+    }
+}
+
+static void OPL3_LanesEnvelope(opl3_lanes *lanes, const opl3_eg_params *eg)
+{
+    uint8_t ii;
+    for (ii = 0; ii < kNumSlots; ii++)
+    {
+        uint16_t eg_rout = lanes->eg_rout[ii];
+        uint8_t eg_gen = (uint8_t)lanes->eg_gen[ii];
+        uint8_t key = lanes->key[ii] != 0;
+        uint8_t reset = key && eg_gen == envelope_gen_num_release;
+        int16_t rate = lanes->eg_rate[reset ? (uint8_t)envelope_gen_num_attack : eg_gen][ii];
+        uint8_t rate_hi = rate & 0x0f;
+        uint8_t rate_lo = (rate >> 4) & 0x03;
+        uint8_t shift = 0;
+        uint16_t new_rout = eg_rout;
+        int16_t eg_inc = 0;
+        uint8_t eg_off;
+
+        lanes->eg_out[ii] = eg_rout + lanes->eg_base[ii] + (eg->tremolo & lanes->trem[ii]);
+        lanes->pg_reset[ii] = reset ? ~0 : 0;
+        if (rate & 0x40)
+        {
+            if (rate_hi < 12)
+            {
+                if (eg->eg_state)
+                {
+                    switch (rate_hi + eg->eg_add)
+                    {
+                    case 12:
+                        shift = 1;
+                        break;
+                    case 13:
+                        shift = (rate_lo >> 1) & 0x01;
+                        break;
+                    case 14:
+                        shift = rate_lo & 0x01;
+                        break;
+                    default:
+                        break;
+                    }
+                }
+            }
+            else
+            {
+                shift = (rate_hi & 0x03) + eg->eg_incstep[rate_lo];
+                if (shift & 0x04)
+                {
+                    shift = 0x03;
+                }
+                if (!shift)
+                {
+                    shift = eg->eg_state;
+                }
+            }
+        }
+        if (reset && rate_hi == 0x0f)
+        {
+            new_rout = 0x00;
+        }
+        eg_off = (eg_rout & 0x1f8) == 0x1f8;
+        if (eg_gen != envelope_gen_num_attack && !reset && eg_off)
+        {
+            new_rout = 0x1ff;
+        }
+        switch (eg_gen)
+        {
+        case envelope_gen_num_attack:
+            if (!eg_rout)
+            {
+                eg_gen = envelope_gen_num_decay;
+            }
+            else if (key && shift > 0 && rate_hi != 0x0f)
+            {
+                eg_inc = ~eg_rout >> (4 - shift);
+            }
+            break;
+        case envelope_gen_num_decay:
+            if ((eg_rout >> 4) == lanes->eg_sl[ii])
+            {
+                eg_gen = envelope_gen_num_sustain;
+            }
+            else if (!eg_off && !reset && shift > 0)
+            {
+                eg_inc = 1 << (shift - 1);
+            }
+            break;
+        case envelope_gen_num_sustain:
+        case envelope_gen_num_release:
+            if (!eg_off && !reset && shift > 0)
+            {
+                eg_inc = 1 << (shift - 1);
+            }
+            break;
+        }
+        lanes->eg_rout[ii] = (new_rout + eg_inc) & 0x1ff;
+        if (reset)
+        {
+            eg_gen = envelope_gen_num_attack;
+        }
+        if (!key)
+        {
+            eg_gen = envelope_gen_num_release;
+        }
+        lanes->eg_gen[ii] = eg_gen;
+    }
+}
+
+static void OPL3_LanesPhase(opl3_lanes *lanes)
+{
+    uint8_t ii;
+    for (ii = 0; ii < kNumSlots; ii++)
+    {
+        lanes->pg_phase_out[ii] = (uint16_t)(lanes->pg_phase[ii] >> 9);
+        lanes->pg_phase[ii] = (lanes->pg_phase[ii] & ~(uint32_t)(int32_t)lanes->pg_reset[ii])
+                            + lanes->pg_inc[ii];
+    }
+}
+
+static void OPL3_LanesWaveform(opl3_lanes *lanes, uint begin, uint end)
+{
+    uint ii;
+    for (ii = begin; ii < end; ii++)
+    {
+        uint16_t phase = (lanes->pg_phase_out[ii] + lanes->mod[ii]) & 0x3ff;
+        uint16_t out = NukedKernels::waveTable[lanes->wf_base[ii] + phase];
+        uint16_t level = (out & 0x7fff) + (lanes->eg_out[ii] << 3);
+        if (level > 0x1fff)
+        {
+            level = 0x1fff;
+        }
+        lanes->out[ii] = (int16_t)(NukedKernels::expTable[level] ^ ((out & 0x8000) ? 0xffff : 0));
+    }
+}
+
+static uint8_t OPL3_LanesFindSlot(opl3_chip *chip, const int16_t *out)
+{
+    uint8_t slotnum;
+    for (slotnum = 0; slotnum < kNumSlots; slotnum++)
+    {
+        if (&chip->slot[slotnum].out == out)
+        {
+            break;
+        }
+    }
+    return slotnum;
+}
+
+static void OPL3_LanesUpdatePhaseInc(opl3_chip *chip, opl3_lanes *lanes)
+{
+    opl3_slot *slot;
+    uint16_t f_num;
+    uint32_t basefreq;
+    uint8_t ii;
+
+    for (ii = 0; ii < kNumSlots; ii++)
+    {
+        slot = &chip->slot[lanes->lane_slot[ii]];
+        f_num = slot->channel->f_num;
+        if (slot->reg_vib)
+        {
+            int8_t range;
+            uint8_t vibpos;
+
+            range = (f_num >> 7) & 7;
+            vibpos = chip->vibpos;
+
+            if (!(vibpos & 3))
+            {
+                range = 0;
+            }
+            else if (vibpos & 1)
+            {
+                range >>= 1;
+            }
+            range >>= chip->vibshift;
+
+            if (vibpos & 4)
+            {
+                range = -range;
+            }
+            f_num += range;
+        }
+        basefreq = (f_num << slot->channel->block) >> 1;
+        lanes->pg_inc[ii] = (basefreq * mt[slot->reg_mult]) >> 1;
+    }
+    lanes->vibpos = chip->vibpos;
+}
+
+/* Sorts the slots by modulation level, and loads their registers */
+static void OPL3_LanesSetup(opl3_chip *chip, opl3_lanes *lanes)
+{
+    opl3_slot *slot;
+    opl3_channel *channel;
+    uint8_t level[kNumSlots];
+    uint8_t mod_slot[kNumSlots];
+    uint8_t slotnum, lane, ii, jj, g;
+
+    for (slotnum = 0; slotnum < kNumSlots; slotnum++)
+    {
+        slot = &chip->slot[slotnum];
+        mod_slot[slotnum] = OPL3_LanesFindSlot(chip, slot->mod);
+        /* The modulator is always processed before the slot it modulates */
+        level[slotnum] = mod_slot[slotnum] < slotnum ? level[mod_slot[slotnum]] + 1 : 0;
+    }
+
+    lane = 0;
+    lanes->num_levels = 0;
+    for (ii = 0; ii < kMaxModLevels && lane < kNumSlots; ii++)
+    {
+        for (slotnum = 0; slotnum < kNumSlots; slotnum++)
+        {
+            if (level[slotnum] == ii)
+            {
+                lanes->lane_slot[lane] = slotnum;
+                lanes->slot_lane[slotnum] = lane;
+                lane++;
+            }
+        }
+        lanes->level_end[ii] = lane;
+        lanes->num_levels++;
+    }
+
+    for (lane = 0; lane < kNumSlots; lane++)
+    {
+        slotnum = lanes->lane_slot[lane];
+        slot = &chip->slot[slotnum];
+        channel = slot->channel;
+        lanes->mod_lane[lane] = level[slotnum] ? lanes->slot_lane[mod_slot[slotnum]] : 0;
+        lanes->fb_mul[lane] = channel->fb ? 1 << (channel->fb - 1) : 0;
+        lanes->fb_sel[lane] = slot->mod == &slot->fbmod ? ~0 : 0;
+        lanes->eg_base[lane] = (slot->reg_tl << 2) + (slot->eg_ksl >> kslshift[slot->reg_ksl]);
+        lanes->trem[lane] = slot->trem == &chip->tremolo ? ~0 : 0;
+        lanes->key[lane] = slot->key ? ~0 : 0;
+        lanes->eg_sl[lane] = slot->reg_sl;
+        lanes->wf_base[lane] = slot->reg_wf << 10;
+        for (g = 0; g < 4; g++)
+        {
+            uint8_t reg_rate = 0;
+            uint8_t ks = channel->ksv >> ((slot->reg_ksr ^ 1) << 1);
+            uint8_t rate, rate_hi;
+            switch (g)
+            {
+            case envelope_gen_num_attack:
+                reg_rate = slot->reg_ar;
+                break;
+            case envelope_gen_num_decay:
+                reg_rate = slot->reg_dr;
+                break;
+            case envelope_gen_num_sustain:
+                if (!slot->reg_type)
+                {
+                    reg_rate = slot->reg_rr;
+                }
+                break;
+            case envelope_gen_num_release:
+                reg_rate = slot->reg_rr;
+                break;
+            }
+            rate = ks + (reg_rate << 2);
+            rate_hi = rate >> 2;
+            if (rate_hi & 0x10)
+            {
+                rate_hi = 0x0f;
+            }
+            lanes->eg_rate[g][lane] = rate_hi | ((rate & 0x03) << 4) | ((reg_rate != 0) << 6);
+        }
+    }
+
+    for (ii = 0; ii < 18; ii++)
+    {
+        channel = &chip->channel[ii];
+        lanes->mix_count[ii] = 0;
+        for (jj = 0; jj < 4; jj++)
+        {
+            if (channel->out[jj] == &chip->zeromod)
+            {
+                continue;
+            }
+            slotnum = OPL3_LanesFindSlot(chip, channel->out[jj]);
+            lane = lanes->slot_lane[slotnum];
+#if OPL_QUIRK_CHANNELSAMPLEDELAY
+            /* Some slots are processed after the channels are mixed */
+            lanes->mix_index[0][ii][lanes->mix_count[ii]] = slotnum < 15 ? lane : kSlotLanes + lane;
+            lanes->mix_index[1][ii][lanes->mix_count[ii]] = slotnum < 33 ? lane : kSlotLanes + lane;
+#else
+            lanes->mix_index[0][ii][lanes->mix_count[ii]] = lane;
+            lanes->mix_index[1][ii][lanes->mix_count[ii]] = lane;
+#endif
+            lanes->mix_count[ii]++;
+        }
+    }
+
+    OPL3_LanesUpdatePhaseInc(chip, lanes);
+}
+
+static void OPL3_LanesLoad(opl3_chip *chip, opl3_lanes *lanes)
+{
+    opl3_slot *slot;
+    uint8_t lane;
+
+    OPL3_LanesSetup(chip, lanes);
+    for (lane = 0; lane < kNumSlots; lane++)
+    {
+        slot = &chip->slot[lanes->lane_slot[lane]];
+        lanes->out[lane] = slot->out;
+        lanes->out[kSlotLanes + lane] = slot->prout;
+        lanes->fbmod[lane] = slot->fbmod;
+        lanes->eg_rout[lane] = slot->eg_rout;
+        lanes->eg_out[lane] = slot->eg_out;
+        lanes->eg_gen[lane] = slot->eg_gen;
+        lanes->pg_reset[lane] = slot->pg_reset ? ~0 : 0;
+        lanes->pg_phase[lane] = slot->pg_phase;
+        lanes->pg_phase_out[lane] = slot->pg_phase_out;
+    }
+}
+
+static void OPL3_LanesStore(opl3_chip *chip, const opl3_lanes *lanes)
+{
+    opl3_slot *slot;
+    uint8_t lane;
+
+    for (lane = 0; lane < kNumSlots; lane++)
+    {
+        slot = &chip->slot[lanes->lane_slot[lane]];
+        slot->out = lanes->out[lane];
+        slot->prout = lanes->out[kSlotLanes + lane];
+        slot->fbmod = lanes->fbmod[lane];
+        slot->eg_rout = lanes->eg_rout[lane];
+        slot->eg_out = lanes->eg_out[lane];
+        slot->eg_gen = (uint8_t)lanes->eg_gen[lane];
+        slot->pg_reset = lanes->pg_reset[lane] ? 1 : 0;
+        slot->pg_phase = lanes->pg_phase[lane];
+        slot->pg_phase_out = lanes->pg_phase_out[lane];
+    }
+}
+
+/* The noise generator and the rhythm slots, in the order of OPL3_PhaseGenerate */
+static void OPL3_LanesRhythm(opl3_chip *chip, opl3_lanes *lanes)
+{
+    uint16_t *phase_out = lanes->pg_phase_out;
+    uint32_t noise = chip->noise;
+    uint32_t noise_hh, noise_sd;
+    uint16_t phase;
+    uint8_t rm_xor;
+
+    /* The noise generator steps once per slot */
+    noise = OPL3_NoiseAdvance(noise, 9);
+    noise_hh = noise = OPL3_NoiseAdvance(noise, 4);
+    noise_sd = noise = OPL3_NoiseAdvance(noise, 3);
+    noise = OPL3_NoiseAdvance(noise, 9);
+    noise = OPL3_NoiseAdvance(noise, 9);
+    chip->noise = OPL3_NoiseAdvance(noise, 2);
+
+    phase = phase_out[lanes->slot_lane[13]];
+    chip->rm_hh_bit2 = (phase >> 2) & 1;
+    chip->rm_hh_bit3 = (phase >> 3) & 1;
+    chip->rm_hh_bit7 = (phase >> 7) & 1;
+    chip->rm_hh_bit8 = (phase >> 8) & 1;
+    if (!(chip->rhy & 0x20))
+    {
+        return;
+    }
+
+    /* hh */
+    rm_xor = (chip->rm_hh_bit2 ^ chip->rm_hh_bit7)
+           | (chip->rm_hh_bit3 ^ chip->rm_tc_bit5)
+           | (chip->rm_tc_bit3 ^ chip->rm_tc_bit5);
+    phase_out[lanes->slot_lane[13]] = (rm_xor << 9) | ((rm_xor ^ (noise_hh & 1)) ? 0xd0 : 0x34);
+    /* sd */
+    phase_out[lanes->slot_lane[16]] = (chip->rm_hh_bit8 << 9)
+                                    | ((chip->rm_hh_bit8 ^ (noise_sd & 1)) << 8);
+    /* tc */
+    phase = phase_out[lanes->slot_lane[17]];
+    chip->rm_tc_bit3 = (phase >> 3) & 1;
+    chip->rm_tc_bit5 = (phase >> 5) & 1;
+    rm_xor = (chip->rm_hh_bit2 ^ chip->rm_hh_bit7)
+           | (chip->rm_hh_bit3 ^ chip->rm_tc_bit5)
+           | (chip->rm_tc_bit3 ^ chip->rm_tc_bit5);
+    phase_out[lanes->slot_lane[17]] = (rm_xor << 9) | 0x80;
+}
+
+static void OPL3_LanesMix(opl3_chip *chip, const opl3_lanes *lanes, uint8_t side, int32_t *mix)
+{
+    opl3_channel *channel;
+    const byte *index;
+    uint8_t ii, jj;
+    int16_t accm;
+
+    mix[0] = mix[1] = 0;
+    for (ii = 0; ii < 18; ii++)
+    {
+        channel = &chip->channel[ii];
+        index = lanes->mix_index[side][ii];
+        accm = 0;
+        for (jj = 0; jj < lanes->mix_count[ii]; jj++)
+        {
+            accm += lanes->out[index[jj]];
+        }
+#if OPL_ENABLE_STEREOEXT
+        mix[0] += (int16_t)((accm * (side ? channel->rightpan : channel->leftpan)) >> 16);
+#else
+        mix[0] += (int16_t)(accm & (side ? channel->chb : channel->cha));
+#endif
+        mix[1] += (int16_t)(accm & (side ? channel->chd : channel->chc));
+    }
+}
+
+/* Same as OPL3_Generate4Ch. Returns true if registers were written. */
+static bool OPL3_Generate4ChLanes(opl3_chip *chip, opl3_lanes *lanes, const NukedKernels::Table &kernels, int16_t *buf4)
+{
+    opl3_eg_params eg;
+    int32_t mix[2];
+    uint32_t writebuf_cur;
+    uint8_t level, begin, end, ii;
+
+    buf4[1] = OPL3_ClipSample(chip->mixbuff[1]);
+    buf4[3] = OPL3_ClipSample(chip->mixbuff[3]);
+
+    if (lanes->vibpos != chip->vibpos)
+    {
+        OPL3_LanesUpdatePhaseInc(chip, lanes);
+    }
+
+    kernels.feedback(lanes);
+
+    eg.tremolo = chip->tremolo;
+    eg.eg_add = chip->eg_add;
+    eg.eg_state = chip->eg_state;
+    for (ii = 0; ii < 4; ii++)
+    {
+        eg.eg_incstep[ii] = eg_incstep[ii][chip->eg_timer_lo];
+    }
+    kernels.envelope(lanes, &eg);
+
+    kernels.phase(lanes);
+    OPL3_LanesRhythm(chip, lanes);
+
+    /* The slots of the first level are modulated by their feedback, or by nothing */
+    begin = 0;
+    for (level = 0; level < lanes->num_levels; level++)
+    {
+        end = lanes->level_end[level];
+        for (ii = level ? begin : end; ii < end; ii++)
+        {
+            lanes->mod[ii] = lanes->out[lanes->mod_lane[ii]];
+        }
+        kernels.waveform(lanes, begin, end);
+        begin = end;
+    }
+
+    OPL3_LanesMix(chip, lanes, 0, mix);
+    chip->mixbuff[0] = mix[0];
+    chip->mixbuff[2] = mix[1];
+    buf4[0] = OPL3_ClipSample(chip->mixbuff[0]);
+    buf4[2] = OPL3_ClipSample(chip->mixbuff[2]);
+
+    OPL3_LanesMix(chip, lanes, 1, mix);
+    chip->mixbuff[1] = mix[0];
+    chip->mixbuff[3] = mix[1];
+
+    writebuf_cur = chip->writebuf_cur;
+    OPL3_ProcessChip(chip);
+    return chip->writebuf_cur != writebuf_cur;
+}
+
+uint16 NukedKernels::waveTable[NukedKernels::kWaveTableSize + 1];
+uint16 NukedKernels::expTable[NukedKernels::kExpTableSize + 1];
+bool NukedKernels::_tablesBuilt = false;
+
+void NukedKernels::buildTables() {
+	if (_tablesBuilt)
+		return;
+
+	// The log-sin part of OPL3_EnvelopeCalcSin0-7
+	for (uint16 wf = 0; wf < 8; wf++) {
+		for (uint16 phase = 0; phase < 0x400; phase++) {
+			const uint16 sine = (phase & 0x100) ? logsinrom[(phase & 0xffu) ^ 0xffu] : logsinrom[phase & 0xffu];
+			const uint16 doubled = (phase & 0x80) ? logsinrom[((phase ^ 0xffu) << 1u) & 0xffu] : logsinrom[(phase << 1u) & 0xffu];
+			uint16 out = 0;
+			bool neg = false;
+
+			switch (wf) {
+			case 0:
+				out = sine;
+				neg = (phase & 0x200) != 0;
+				break;
+			case 1:
+				out = (phase & 0x200) ? 0x1000 : sine;
+				break;
+			case 2:
+				out = sine;
+				break;
+			case 3:
+				out = (phase & 0x100) ? 0x1000 : logsinrom[phase & 0xffu];
+				break;
+			case 4:
+				out = (phase & 0x200) ? 0x1000 : doubled;
+				neg = (phase & 0x300) == 0x100;
+				break;
+			case 5:
+				out = (phase & 0x200) ? 0x1000 : doubled;
+				break;
+			case 6:
+				out = 0;
+				neg = (phase & 0x200) != 0;
+				break;
+			case 7:
+				out = ((phase & 0x200) ? (phase & 0x1ff) ^ 0x1ff : phase) << 3;
+				neg = (phase & 0x200) != 0;
+				break;
+			default:
+				break;
+			}
+			waveTable[(wf << 10) + phase] = out | (neg ? 0x8000 : 0);
+		}
+	}
+	waveTable[kWaveTableSize] = 0;
+
+	for (uint32 level = 0; level < kExpTableSize; level++)
+		expTable[level] = (uint16)OPL3_EnvelopeCalcExp(level);
+	expTable[kExpTableSize] = 0;
+
+	_tablesBuilt = true;
+}
+
+const NukedKernels::Table NukedKernels::generic = {
+	OPL3_LanesFeedback,
+	OPL3_LanesEnvelope,
+	OPL3_LanesPhase,
+	OPL3_LanesWaveform
+};
+
+const NukedKernels::Table *NukedKernels::kernels = nullptr;
+
+void OPL3_GenerateBlock(opl3_chip *chip, int16_t *sndptr, uint32_t numsamples,
+                        const opl3_blockwrite *writes, uint32_t numwrites)
+{
+    const NukedKernels::Table &kernels = NukedKernels::get();
+    opl3_lanes lanes;
+    int16_t samples[4];
+    bool written = false;
+    uint32_t i;
+
+    NukedKernels::buildTables();
+    memset(&lanes, 0, sizeof(lanes));
+    OPL3_LanesLoad(chip, &lanes);
+
+    for (i = 0; i < numsamples; i++)
+    {
+        for (; numwrites && writes->sample <= i; writes++, numwrites--)
+        {
+            OPL3_WriteRegBuffered(chip, writes->reg, writes->data);
+            written = true;
+        }
+        while (chip->samplecnt >= chip->rateratio)
+        {
+            if (written)
+            {
+                OPL3_LanesStore(chip, &lanes);
+                OPL3_LanesLoad(chip, &lanes);
+            }
+            chip->oldsamples[0] = chip->samples[0];
+            chip->oldsamples[1] = chip->samples[1];
+            chip->oldsamples[2] = chip->samples[2];
+            chip->oldsamples[3] = chip->samples[3];
+            written = OPL3_Generate4ChLanes(chip, &lanes, kernels, chip->samples);
+            chip->samplecnt -= chip->rateratio;
+        }
+        OPL3_Resample4Ch(chip, samples);
+        sndptr[0] = samples[0];
+        sndptr[1] = samples[1];
+        sndptr += 2;
+    }
+
+    OPL3_LanesStore(chip, &lanes);
+    for (; numwrites; writes++, numwrites--)
+    {
+        OPL3_WriteRegBuffered(chip, writes->reg, writes->data);
+    }
+}
+
 OPL::OPL(Config::OplType type) : _type(type), _rate(0) {
 }
 
@@ -1551,6 +2167,7 @@ bool OPL::init() {
 }
 
 void OPL::reset() {
+	_writes.resize(0);
 	OPL3_Reset(&chip, _rate);
 }
 
@@ -1559,7 +2176,7 @@ void OPL::write(int port, int val) {
 		switch (_type) {
 		case Config::kOpl2:
 		case Config::kOpl3:
-			OPL3_WriteRegBuffered(&chip, (uint16_t)address[0], (uint8_t)val);
+			writeRegBuffered((uint16)address[0], (uint8)val);
 			break;
 		case Config::kDualOpl2:
 			// Not a 0x??8 port, then write to a specific port
@@ -1603,7 +2220,21 @@ void OPL::write(int port, int val) {
 
 
 void OPL::writeReg(int r, int v) {
-	OPL3_WriteRegBuffered(&chip, (uint16_t)r, (uint8_t)v);
+	writeRegBuffered((uint16)r, (uint8)v);
+}
+
+void OPL::writeRegBuffered(uint16 reg, uint8 val) {
+	const int frame = getCallbackFrame();
+	if (frame < 0) {
+		OPL3_WriteRegBuffered(&chip, reg, val);
+		return;
+	}
+
+	opl3_blockwrite write;
+	write.sample = frame;
+	write.reg = reg;
+	write.data = val;
+	_writes.push_back(write);
 }
 
 void OPL::dualWrite(uint8 index, uint8 reg, uint8 val) {
@@ -1623,11 +2254,13 @@ void OPL::dualWrite(uint8 index, uint8 reg, uint8 val) {
 	}
 
 	uint32 fullReg = reg + (index ? 0x100 : 0);
-	OPL3_WriteRegBuffered(&chip, (uint16_t)fullReg, (uint8_t)val);
+	writeRegBuffered((uint16)fullReg, (uint8)val);
 }
 
 void OPL::generateSamples(int16*buffer, int length) {
-	OPL3_GenerateStream(&chip, (int16_t*)buffer, (uint16_t)length / 2);
+	OPL3_GenerateBlock(&chip, (int16_t*)buffer, length / 2, _writes.data(), _writes.size());
+	// Keep the storage for the writes of the next buffer
+	_writes.resize(0);
 }
 
 }
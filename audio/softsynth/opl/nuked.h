@@ -29,6 +29,7 @@
 #ifndef AUDIO_SOFTSYNTH_OPL_NUKED_H
 #define AUDIO_SOFTSYNTH_OPL_NUKED_H
 
+#include "common/array.h"
 #include "common/scummsys.h"
 #include "audio/fmopl.h"
 
@@ -164,13 +165,34 @@ void OPL3_Generate4Ch(opl3_chip *chip, int16_t *buf4);
 void OPL3_Generate4ChResampled(opl3_chip *chip, int16_t *buf4);
 void OPL3_Generate4ChStream(opl3_chip *chip, int16_t *sndptr1, int16_t *sndptr2, uint32_t numsamples);
 
+/*
+    A register write applied before the given output sample of a block.
+*/
+typedef struct _opl3_blockwrite {
+    uint32_t sample;
+    uint16_t reg;
+    uint8_t data;
+} opl3_blockwrite;
+
+/*
+    Same as OPL3_GenerateStream, with the register writes applied through
+    OPL3_WriteRegBuffered at their sample, in order. Writes past the end of
+    the block are applied after it. The slots are processed in SIMD lanes by
+    the kernels of nuked_kernels.h.
+*/
+void OPL3_GenerateBlock(opl3_chip *chip, int16_t *sndptr, uint32_t numsamples,
+                        const opl3_blockwrite *writes, uint32_t numwrites);
+
 class OPL : public ::OPL::OPL, public Audio::EmulatedChip {
 private:
 	Config::OplType _type;
 	uint _rate;
 	opl3_chip chip;
 	uint address[2];
+	/** The writes of the timer callbacks, applied while generating the next buffer. */
+	Common::Array<opl3_blockwrite> _writes;
 	void dualWrite(uint8 index, uint8 reg, uint8 val);
+	void writeRegBuffered(uint16 reg, uint8 val);
 
 public:
 	OPL(Config::OplType type);
@@ -187,6 +209,7 @@ public:
 
 protected:
 	void generateSamples(int16 *buffer, int length);
+	bool queuesWrites() const override { return true; }
 };
 
 }
@@ -0,0 +1,228 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "audio/softsynth/opl/nuked_kernels.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace OPL {
+namespace NUKED {
+
+class NukedKernelsImpl_AVX2 {
+public:
+
+static inline __m256i load(const int16 *src) {
+	return _mm256_loadu_si256((const __m256i *)src);
+}
+
+static inline void store(int16 *dst, __m256i val) {
+	_mm256_storeu_si256((__m256i *)dst, val);
+}
+
+static inline __m256i select(__m256i mask, __m256i a, __m256i b) {
+	return _mm256_or_si256(_mm256_and_si256(mask, a), _mm256_andnot_si256(mask, b));
+}
+
+/**
+ * Looks up sixteen 16-bit table entries, with 32-bit gathers. The tables
+ * have one more entry so that the last one can be read this way.
+ */
+static inline __m256i lookup(const uint16 *table, __m256i index) {
+	const __m256i mask = _mm256_set1_epi32(0xffff);
+	const __m256i lo = _mm256_i32gather_epi32((const int *)table, _mm256_cvtepu16_epi32(_mm256_castsi256_si128(index)), 2);
+	const __m256i hi = _mm256_i32gather_epi32((const int *)table, _mm256_cvtepu16_epi32(_mm256_extracti128_si256(index, 1)), 2);
+	return _mm256_permute4x64_epi64(_mm256_packus_epi32(_mm256_and_si256(lo, mask), _mm256_and_si256(hi, mask)), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+static void feedback(opl3_lanes *lanes) {
+	for (uint i = 0; i < kNumSlots; i += 16) {
+		const __m256i out = load(lanes->out + i);
+		const __m256i prout = load(lanes->out + kSlotLanes + i);
+		const __m256i mul = load(lanes->fb_mul + i);
+
+		// (prout + out) * fb_mul, in 32 bits
+		const __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(out, prout), _mm256_unpacklo_epi16(mul, mul));
+		const __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(out, prout), _mm256_unpackhi_epi16(mul, mul));
+		const __m256i fbmod = _mm256_packs_epi32(_mm256_srai_epi32(lo, 8), _mm256_srai_epi32(hi, 8));
+
+		store(lanes->fbmod + i, fbmod);
+		store(lanes->out + kSlotLanes + i, out);
+		store(lanes->mod + i, _mm256_and_si256(fbmod, load(lanes->fb_sel + i)));
+	}
+}
+
+static void envelope(opl3_lanes *lanes, const opl3_eg_params *eg) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi16(1);
+	const __m256i two = _mm256_set1_epi16(2);
+	const __m256i three = _mm256_set1_epi16(3);
+	const __m256i fifteen = _mm256_set1_epi16(15);
+	const __m256i rout_mask = _mm256_set1_epi16(0x1ff);
+	const __m256i tremolo = _mm256_set1_epi16(eg->tremolo);
+	const __m256i eg_add = _mm256_set1_epi16(eg->eg_add);
+	const __m256i eg_state = _mm256_set1_epi16(eg->eg_state);
+	const __m256i eg_state_mask = _mm256_set1_epi16(eg->eg_state ? ~0 : 0);
+	const __m256i incstep1 = _mm256_set1_epi16(eg->eg_incstep[1]);
+	const __m256i incstep2 = _mm256_set1_epi16(eg->eg_incstep[2]);
+	const __m256i incstep3 = _mm256_set1_epi16(eg->eg_incstep[3]);
+
+	for (uint i = 0; i < kNumSlots; i += 16) {
+		const __m256i rout = load(lanes->eg_rout + i);
+		const __m256i gen = load(lanes->eg_gen + i);
+		const __m256i key = load(lanes->key + i);
+
+		const __m256i attack = _mm256_cmpeq_epi16(gen, zero);
+		const __m256i decay = _mm256_cmpeq_epi16(gen, one);
+		const __m256i sustain = _mm256_cmpeq_epi16(gen, two);
+		const __m256i release = _mm256_cmpeq_epi16(gen, three);
+		const __m256i reset = _mm256_and_si256(key, release);
+
+		store(lanes->eg_out + i, _mm256_add_epi16(_mm256_add_epi16(rout, load(lanes->eg_base + i)),
+		                                       _mm256_and_si256(tremolo, load(lanes->trem + i))));
+		store(lanes->pg_reset + i, reset);
+
+		// The rate of the stage, the attack rate on reset
+		__m256i rate = _mm256_and_si256(load(lanes->eg_rate[0] + i), _mm256_or_si256(attack, reset));
+		rate = _mm256_or_si256(rate, _mm256_and_si256(load(lanes->eg_rate[1] + i), decay));
+		rate = _mm256_or_si256(rate, _mm256_and_si256(load(lanes->eg_rate[2] + i), sustain));
+		rate = _mm256_or_si256(rate, _mm256_and_si256(load(lanes->eg_rate[3] + i), _mm256_andnot_si256(reset, release)));
+		const __m256i rate_hi = _mm256_and_si256(rate, fifteen);
+		const __m256i rate_lo = _mm256_and_si256(_mm256_srli_epi16(rate, 4), three);
+		const __m256i nonzero = _mm256_cmpeq_epi16(_mm256_and_si256(rate, _mm256_set1_epi16(0x40)), _mm256_set1_epi16(0x40));
+		const __m256i rate_hi_max = _mm256_cmpeq_epi16(rate_hi, fifteen);
+
+		// The shift of the slow rates
+		const __m256i eg_shift = _mm256_add_epi16(rate_hi, eg_add);
+		__m256i shift_lo = _mm256_and_si256(_mm256_cmpeq_epi16(eg_shift, _mm256_set1_epi16(12)), one);
+		shift_lo = _mm256_or_si256(shift_lo, _mm256_and_si256(_mm256_cmpeq_epi16(eg_shift, _mm256_set1_epi16(13)), _mm256_and_si256(_mm256_srli_epi16(rate_lo, 1), one)));
+		shift_lo = _mm256_or_si256(shift_lo, _mm256_and_si256(_mm256_cmpeq_epi16(eg_shift, _mm256_set1_epi16(14)), _mm256_and_si256(rate_lo, one)));
+		shift_lo = _mm256_and_si256(shift_lo, eg_state_mask);
+
+		// The shift of the fast rates
+		__m256i incstep = _mm256_and_si256(_mm256_cmpeq_epi16(rate_lo, one), incstep1);
+		incstep = _mm256_or_si256(incstep, _mm256_and_si256(_mm256_cmpeq_epi16(rate_lo, two), incstep2));
+		incstep = _mm256_or_si256(incstep, _mm256_and_si256(_mm256_cmpeq_epi16(rate_lo, three), incstep3));
+		__m256i shift_hi = _mm256_min_epi16(_mm256_add_epi16(_mm256_and_si256(rate_hi, three), incstep), three);
+		shift_hi = _mm256_or_si256(shift_hi, _mm256_and_si256(_mm256_cmpeq_epi16(shift_hi, zero), eg_state));
+
+		const __m256i slow = _mm256_cmpgt_epi16(_mm256_set1_epi16(12), rate_hi);
+		const __m256i shift = _mm256_and_si256(nonzero, select(slow, shift_lo, shift_hi));
+		const __m256i shift1 = _mm256_cmpeq_epi16(shift, one);
+		const __m256i shift2 = _mm256_cmpeq_epi16(shift, two);
+		const __m256i shift3 = _mm256_cmpeq_epi16(shift, three);
+
+		// Instant attack, and envelope off
+		const __m256i eg_off = _mm256_cmpeq_epi16(_mm256_and_si256(rout, _mm256_set1_epi16(0x1f8)), _mm256_set1_epi16(0x1f8));
+		const __m256i force_off = _mm256_andnot_si256(attack, _mm256_andnot_si256(reset, eg_off));
+		__m256i new_rout = _mm256_andnot_si256(_mm256_and_si256(reset, rate_hi_max), rout);
+		new_rout = select(force_off, rout_mask, new_rout);
+
+		// Attack: ~eg_rout >> (4 - shift)
+		const __m256i not_rout = _mm256_xor_si256(rout, _mm256_set1_epi16(-1));
+		__m256i attack_inc = _mm256_and_si256(shift1, _mm256_srai_epi16(not_rout, 3));
+		attack_inc = _mm256_or_si256(attack_inc, _mm256_and_si256(shift2, _mm256_srai_epi16(not_rout, 2)));
+		attack_inc = _mm256_or_si256(attack_inc, _mm256_and_si256(shift3, _mm256_srai_epi16(not_rout, 1)));
+		const __m256i rout_zero = _mm256_cmpeq_epi16(rout, zero);
+		const __m256i attacking = _mm256_andnot_si256(_mm256_or_si256(rout_zero, rate_hi_max), _mm256_and_si256(attack, key));
+		attack_inc = _mm256_and_si256(attacking, attack_inc);
+
+		// Decay, sustain and release: 1 << (shift - 1)
+		const __m256i reach_sl = _mm256_and_si256(decay, _mm256_cmpeq_epi16(_mm256_srli_epi16(rout, 4), load(lanes->eg_sl + i)));
+		const __m256i linear = _mm256_andnot_si256(_mm256_or_si256(eg_off, reset),
+		                                        _mm256_or_si256(_mm256_andnot_si256(reach_sl, decay), _mm256_or_si256(sustain, release)));
+		const __m256i linear_inc = _mm256_and_si256(linear, _mm256_add_epi16(shift, _mm256_and_si256(shift3, one)));
+
+		new_rout = _mm256_add_epi16(new_rout, _mm256_or_si256(attack_inc, linear_inc));
+		store(lanes->eg_rout + i, _mm256_and_si256(new_rout, rout_mask));
+
+		__m256i new_gen = select(_mm256_and_si256(attack, rout_zero), one, gen);
+		new_gen = select(reach_sl, two, new_gen);
+		new_gen = _mm256_andnot_si256(reset, new_gen);
+		new_gen = select(key, new_gen, three);
+		store(lanes->eg_gen + i, new_gen);
+	}
+}
+
+static void phase(opl3_lanes *lanes) {
+	const __m256i mask = _mm256_set1_epi32(0xffff);
+
+	for (uint i = 0; i < kNumSlots; i += 16) {
+		const __m256i reset = load(lanes->pg_reset + i);
+		__m256i lo = _mm256_loadu_si256((const __m256i *)(lanes->pg_phase + i));
+		__m256i hi = _mm256_loadu_si256((const __m256i *)(lanes->pg_phase + i + 8));
+
+		// The low 16 bits of pg_phase >> 9
+		const __m256i out_lo = _mm256_and_si256(_mm256_srli_epi32(lo, 9), mask);
+		const __m256i out_hi = _mm256_and_si256(_mm256_srli_epi32(hi, 9), mask);
+		_mm256_storeu_si256((__m256i *)(lanes->pg_phase_out + i), _mm256_permute4x64_epi64(_mm256_packus_epi32(out_lo, out_hi), _MM_SHUFFLE(3, 1, 2, 0)));
+
+		lo = _mm256_andnot_si256(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(reset)), lo);
+		hi = _mm256_andnot_si256(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(reset, 1)), hi);
+		lo = _mm256_add_epi32(lo, _mm256_loadu_si256((const __m256i *)(lanes->pg_inc + i)));
+		hi = _mm256_add_epi32(hi, _mm256_loadu_si256((const __m256i *)(lanes->pg_inc + i + 8)));
+		_mm256_storeu_si256((__m256i *)(lanes->pg_phase + i), lo);
+		_mm256_storeu_si256((__m256i *)(lanes->pg_phase + i + 8), hi);
+	}
+}
+
+static void waveform(opl3_lanes *lanes, uint begin, uint end) {
+	const __m256i phase_mask = _mm256_set1_epi16(0x3ff);
+	const __m256i max_level = _mm256_set1_epi16(0x1fff);
+
+	for (uint i = begin; i < end; i += 16) {
+		const __m256i phase = _mm256_and_si256(_mm256_add_epi16(load((const int16 *)lanes->pg_phase_out + i), load(lanes->mod + i)), phase_mask);
+		const __m256i logsin = lookup(NukedKernels::waveTable, _mm256_add_epi16(load(lanes->wf_base + i), phase));
+
+		__m256i level = _mm256_and_si256(logsin, _mm256_set1_epi16(0x7fff));
+		level = _mm256_add_epi16(level, _mm256_slli_epi16(load(lanes->eg_out + i), 3));
+		level = _mm256_min_epi16(level, max_level);
+
+		const __m256i out = _mm256_xor_si256(lookup(NukedKernels::expTable, level), _mm256_srai_epi16(logsin, 15));
+		store(lanes->out + i, out);
+	}
+}
+
+}; // End of class
+
+const NukedKernels::Table NukedKernels::avx2 = {
+	NukedKernelsImpl_AVX2::feedback,
+	NukedKernelsImpl_AVX2::envelope,
+	NukedKernelsImpl_AVX2::phase,
+	NukedKernelsImpl_AVX2::waveform
+};
+
+} // End of namespace NUKED
+} // End of namespace OPL
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
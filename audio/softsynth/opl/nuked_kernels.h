@@ -0,0 +1,204 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AUDIO_SOFTSYNTH_OPL_NUKED_KERNELS_H
+#define AUDIO_SOFTSYNTH_OPL_NUKED_KERNELS_H
+
+#include "common/cpu-kernels.h"
+#include "common/scummsys.h"
+
+#ifndef DISABLE_NUKED_OPL
+
+namespace OPL {
+namespace NUKED {
+
+enum {
+	/** Number of operator slots of an OPL3 chip. */
+	kNumSlots = 36,
+
+	/**
+	 * Number of lanes of the slot state. The kernels may run past the last
+	 * lane they are asked for up to the width of their vectors, so there is
+	 * room for the widest vectors to start at the last slot.
+	 */
+	kSlotLanes = 64,
+
+	/** Number of levels of modulation, for the four operators of a 4-op channel. */
+	kMaxModLevels = 4
+};
+
+/**
+ * The state of the slots of a chip while generating a block, stored per
+ * field so that the kernels process the slots in SIMD lanes.
+ *
+ * The lanes are sorted by modulation level: first the slots modulated by
+ * their feedback or by nothing, then the slots modulated by those, and so
+ * on. The waveform of each level is generated in one go once the outputs
+ * of the level before are known.
+ */
+struct opl3_lanes {
+	// State of the slots
+
+	/** The outputs of the slots, followed by the outputs of the previous sample. */
+	int16 out[2 * kSlotLanes];
+	int16 fbmod[kSlotLanes];
+	/** The phase modulation of the waveform, from the feedback or another slot. */
+	int16 mod[kSlotLanes];
+	int16 eg_rout[kSlotLanes];
+	int16 eg_out[kSlotLanes];
+	int16 eg_gen[kSlotLanes];
+	/** ~0 if the phase is reset, 0 otherwise. */
+	int16 pg_reset[kSlotLanes];
+	uint16 pg_phase_out[kSlotLanes];
+	uint32 pg_phase[kSlotLanes];
+
+	// Parameters, computed from the registers
+
+	/** 1 << (fb - 1), or 0 without feedback, so that pmaddwd does the shift. */
+	int16 fb_mul[kSlotLanes];
+	/** ~0 if the slot is modulated by its feedback, 0 otherwise. */
+	int16 fb_sel[kSlotLanes];
+	/** The total level and the key scale level, added to the envelope. */
+	int16 eg_base[kSlotLanes];
+	/** ~0 if the slot has tremolo, 0 otherwise. */
+	int16 trem[kSlotLanes];
+	/** ~0 if the slot is keyed on, 0 otherwise. */
+	int16 key[kSlotLanes];
+	/**
+	 * The rate of each envelope stage, as rate_hi | rate_lo << 4, with bit 6
+	 * set if the register rate is not zero.
+	 */
+	int16 eg_rate[4][kSlotLanes];
+	int16 eg_sl[kSlotLanes];
+	/** reg_wf << 10, the offset of the waveform in NukedKernels::waveTable. */
+	int16 wf_base[kSlotLanes];
+	/** The phase increment, with the vibrato at vibpos. */
+	uint32 pg_inc[kSlotLanes];
+
+	// Layout of the lanes
+
+	byte lane_slot[kNumSlots];
+	byte slot_lane[kNumSlots];
+	/** The lane of the slot which modulates each lane, for the levels after the first one. */
+	byte mod_lane[kNumSlots];
+	/** The end of the lanes of each modulation level. */
+	byte level_end[kMaxModLevels];
+	byte num_levels;
+
+	/**
+	 * The outputs added up by each channel, for each side. They index out,
+	 * so that a side mixed before a slot is processed uses the output of the
+	 * previous sample.
+	 */
+	byte mix_count[18];
+	byte mix_index[2][18][4];
+
+	/** The vibrato position pg_inc was computed for. */
+	byte vibpos;
+};
+
+/** The state of the envelope generator of the chip for the current sample. */
+struct opl3_eg_params {
+	int16 tremolo;
+	int16 eg_add;
+	int16 eg_state;
+	/** eg_incstep[rate_lo][eg_timer_lo], for each rate_lo. */
+	int16 eg_incstep[4];
+};
+
+/**
+ * The inner loops of the Nuked OPL3 emulator, which process the 36 slots of
+ * a chip in lanes. SIMD versions are selected at runtime through
+ * Common::CpuKernels. They all give the same result as the slot functions
+ * of nuked.cpp.
+ */
+class NukedKernels {
+public:
+	/**
+	 * Computes the feedback of the slots from their last two outputs, keeps
+	 * the outputs for the next sample, and sets the modulation of the slots
+	 * modulated by their feedback.
+	 */
+	typedef void (*FeedbackFunc)(opl3_lanes *lanes);
+
+	/** Computes the envelope of the slots and advances the envelope generator. */
+	typedef void (*EnvelopeFunc)(opl3_lanes *lanes, const opl3_eg_params *eg);
+
+	/**
+	 * Advances the phase of the slots. The phase of the rhythm slots is
+	 * fixed up by the caller.
+	 */
+	typedef void (*PhaseFunc)(opl3_lanes *lanes);
+
+	/** Computes the outputs of the lanes from @p begin to @p end. */
+	typedef void (*WaveformFunc)(opl3_lanes *lanes, uint begin, uint end);
+
+	struct Table {
+		FeedbackFunc feedback;
+		EnvelopeFunc envelope;
+		PhaseFunc phase;
+		WaveformFunc waveform;
+	};
+
+	static const Table generic;
+#ifdef SCUMMVM_NEON
+	static const Table neon;
+#endif
+#ifdef SCUMMVM_SSE2
+	static const Table sse2;
+#endif
+#ifdef SCUMMVM_AVX2
+	static const Table avx2;
+#endif
+
+	/** The kernels in use, see Common::CpuKernels. */
+	static const Table *kernels;
+
+	static const Table &get() { return Common::CpuKernels<NukedKernels>::get(); }
+
+	enum {
+		kWaveTableSize = 8 * 1024,
+		kExpTableSize = 0x2000
+	};
+
+	/**
+	 * The log-sin value of each waveform at each phase, with bit 15 set
+	 * where the output is negated. There is one more entry so that 32-bit
+	 * gathers can read the last one.
+	 */
+	static uint16 waveTable[kWaveTableSize + 1];
+
+	/** The output of each attenuation level, with one more entry as well. */
+	static uint16 expTable[kExpTableSize + 1];
+
+	/** Fills the tables, once. */
+	static void buildTables();
+
+private:
+	static bool _tablesBuilt;
+};
+
+} // End of namespace NUKED
+} // End of namespace OPL
+
+#endif // !DISABLE_NUKED_OPL
+
+#endif
@@ -0,0 +1,231 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "audio/softsynth/opl/nuked_kernels.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace OPL {
+namespace NUKED {
+
+class NukedKernelsImpl_NEON {
+public:
+
+static inline int16x8_t cmpeq(int16x8_t a, int16x8_t b) {
+	return vreinterpretq_s16_u16(vceqq_s16(a, b));
+}
+
+static inline int16x8_t select(int16x8_t mask, int16x8_t a, int16x8_t b) {
+	return vbslq_s16(vreinterpretq_u16_s16(mask), a, b);
+}
+
+/** Looks up eight 16-bit table entries. */
+static inline int16x8_t lookup(const uint16 *table, int16x8_t index) {
+	uint16 i[8];
+	int16 val[8];
+	vst1q_u16(i, vreinterpretq_u16_s16(index));
+	for (int j = 0; j < 8; j++)
+		val[j] = (int16)table[i[j]];
+	return vld1q_s16(val);
+}
+
+static void feedback(opl3_lanes *lanes) {
+	for (uint i = 0; i < kNumSlots; i += 8) {
+		const int16x8_t out = vld1q_s16(lanes->out + i);
+		const int16x8_t prout = vld1q_s16(lanes->out + kSlotLanes + i);
+		const int16x8_t mul = vld1q_s16(lanes->fb_mul + i);
+
+		// (prout + out) * fb_mul, in 32 bits
+		int32x4_t lo = vmull_s16(vget_low_s16(out), vget_low_s16(mul));
+		int32x4_t hi = vmull_s16(vget_high_s16(out), vget_high_s16(mul));
+		lo = vmlal_s16(lo, vget_low_s16(prout), vget_low_s16(mul));
+		hi = vmlal_s16(hi, vget_high_s16(prout), vget_high_s16(mul));
+		const int16x8_t fbmod = vcombine_s16(vqmovn_s32(vshrq_n_s32(lo, 8)), vqmovn_s32(vshrq_n_s32(hi, 8)));
+
+		vst1q_s16(lanes->fbmod + i, fbmod);
+		vst1q_s16(lanes->out + kSlotLanes + i, out);
+		vst1q_s16(lanes->mod + i, vandq_s16(fbmod, vld1q_s16(lanes->fb_sel + i)));
+	}
+}
+
+static void envelope(opl3_lanes *lanes, const opl3_eg_params *eg) {
+	const int16x8_t zero = vdupq_n_s16(0);
+	const int16x8_t one = vdupq_n_s16(1);
+	const int16x8_t two = vdupq_n_s16(2);
+	const int16x8_t three = vdupq_n_s16(3);
+	const int16x8_t fifteen = vdupq_n_s16(15);
+	const int16x8_t rout_mask = vdupq_n_s16(0x1ff);
+	const int16x8_t tremolo = vdupq_n_s16(eg->tremolo);
+	const int16x8_t eg_add = vdupq_n_s16(eg->eg_add);
+	const int16x8_t eg_state = vdupq_n_s16(eg->eg_state);
+	const int16x8_t eg_state_mask = vdupq_n_s16(eg->eg_state ? ~0 : 0);
+	const int16x8_t incstep1 = vdupq_n_s16(eg->eg_incstep[1]);
+	const int16x8_t incstep2 = vdupq_n_s16(eg->eg_incstep[2]);
+	const int16x8_t incstep3 = vdupq_n_s16(eg->eg_incstep[3]);
+
+	for (uint i = 0; i < kNumSlots; i += 8) {
+		const int16x8_t rout = vld1q_s16(lanes->eg_rout + i);
+		const int16x8_t gen = vld1q_s16(lanes->eg_gen + i);
+		const int16x8_t key = vld1q_s16(lanes->key + i);
+
+		const int16x8_t attack = cmpeq(gen, zero);
+		const int16x8_t decay = cmpeq(gen, one);
+		const int16x8_t sustain = cmpeq(gen, two);
+		const int16x8_t release = cmpeq(gen, three);
+		const int16x8_t reset = vandq_s16(key, release);
+
+		vst1q_s16(lanes->eg_out + i, vaddq_s16(vaddq_s16(rout, vld1q_s16(lanes->eg_base + i)),
+		                                       vandq_s16(tremolo, vld1q_s16(lanes->trem + i))));
+		vst1q_s16(lanes->pg_reset + i, reset);
+
+		// The rate of the stage, the attack rate on reset
+		int16x8_t rate = vandq_s16(vld1q_s16(lanes->eg_rate[0] + i), vorrq_s16(attack, reset));
+		rate = vorrq_s16(rate, vandq_s16(vld1q_s16(lanes->eg_rate[1] + i), decay));
+		rate = vorrq_s16(rate, vandq_s16(vld1q_s16(lanes->eg_rate[2] + i), sustain));
+		rate = vorrq_s16(rate, vandq_s16(vld1q_s16(lanes->eg_rate[3] + i), vbicq_s16(release, reset)));
+		const int16x8_t rate_hi = vandq_s16(rate, fifteen);
+		const int16x8_t rate_lo = vandq_s16(vshrq_n_s16(rate, 4), three);
+		const int16x8_t nonzero = cmpeq(vandq_s16(rate, vdupq_n_s16(0x40)), vdupq_n_s16(0x40));
+		const int16x8_t rate_hi_max = cmpeq(rate_hi, fifteen);
+
+		// The shift of the slow rates
+		const int16x8_t eg_shift = vaddq_s16(rate_hi, eg_add);
+		int16x8_t shift_lo = vandq_s16(cmpeq(eg_shift, vdupq_n_s16(12)), one);
+		shift_lo = vorrq_s16(shift_lo, vandq_s16(cmpeq(eg_shift, vdupq_n_s16(13)), vandq_s16(vshrq_n_s16(rate_lo, 1), one)));
+		shift_lo = vorrq_s16(shift_lo, vandq_s16(cmpeq(eg_shift, vdupq_n_s16(14)), vandq_s16(rate_lo, one)));
+		shift_lo = vandq_s16(shift_lo, eg_state_mask);
+
+		// The shift of the fast rates
+		int16x8_t incstep = vandq_s16(cmpeq(rate_lo, one), incstep1);
+		incstep = vorrq_s16(incstep, vandq_s16(cmpeq(rate_lo, two), incstep2));
+		incstep = vorrq_s16(incstep, vandq_s16(cmpeq(rate_lo, three), incstep3));
+		int16x8_t shift_hi = vminq_s16(vaddq_s16(vandq_s16(rate_hi, three), incstep), three);
+		shift_hi = vorrq_s16(shift_hi, vandq_s16(cmpeq(shift_hi, zero), eg_state));
+
+		const int16x8_t slow = vreinterpretq_s16_u16(vcltq_s16(rate_hi, vdupq_n_s16(12)));
+		const int16x8_t shift = vandq_s16(nonzero, select(slow, shift_lo, shift_hi));
+		const int16x8_t shift1 = cmpeq(shift, one);
+		const int16x8_t shift2 = cmpeq(shift, two);
+		const int16x8_t shift3 = cmpeq(shift, three);
+
+		// Instant attack, and envelope off
+		const int16x8_t eg_off = cmpeq(vandq_s16(rout, vdupq_n_s16(0x1f8)), vdupq_n_s16(0x1f8));
+		const int16x8_t force_off = vbicq_s16(vbicq_s16(eg_off, reset), attack);
+		int16x8_t new_rout = vbicq_s16(rout, vandq_s16(reset, rate_hi_max));
+		new_rout = select(force_off, rout_mask, new_rout);
+
+		// Attack: ~eg_rout >> (4 - shift)
+		const int16x8_t not_rout = vmvnq_s16(rout);
+		int16x8_t attack_inc = vandq_s16(shift1, vshrq_n_s16(not_rout, 3));
+		attack_inc = vorrq_s16(attack_inc, vandq_s16(shift2, vshrq_n_s16(not_rout, 2)));
+		attack_inc = vorrq_s16(attack_inc, vandq_s16(shift3, vshrq_n_s16(not_rout, 1)));
+		const int16x8_t rout_zero = cmpeq(rout, zero);
+		const int16x8_t attacking = vbicq_s16(vandq_s16(attack, key), vorrq_s16(rout_zero, rate_hi_max));
+		attack_inc = vandq_s16(attacking, attack_inc);
+
+		// Decay, sustain and release: 1 << (shift - 1)
+		const int16x8_t reach_sl = vandq_s16(decay, cmpeq(vshrq_n_s16(rout, 4), vld1q_s16(lanes->eg_sl + i)));
+		const int16x8_t linear = vbicq_s16(vorrq_s16(vbicq_s16(decay, reach_sl), vorrq_s16(sustain, release)),
+		                                   vorrq_s16(eg_off, reset));
+		const int16x8_t linear_inc = vandq_s16(linear, vaddq_s16(shift, vandq_s16(shift3, one)));
+
+		new_rout = vaddq_s16(new_rout, vorrq_s16(attack_inc, linear_inc));
+		vst1q_s16(lanes->eg_rout + i, vandq_s16(new_rout, rout_mask));
+
+		int16x8_t new_gen = select(vandq_s16(attack, rout_zero), one, gen);
+		new_gen = select(reach_sl, two, new_gen);
+		new_gen = vbicq_s16(new_gen, reset);
+		new_gen = select(key, new_gen, three);
+		vst1q_s16(lanes->eg_gen + i, new_gen);
+	}
+}
+
+static void phase(opl3_lanes *lanes) {
+	for (uint i = 0; i < kNumSlots; i += 8) {
+		const int16x8_t reset = vld1q_s16(lanes->pg_reset + i);
+		uint32x4_t lo = vld1q_u32(lanes->pg_phase + i);
+		uint32x4_t hi = vld1q_u32(lanes->pg_phase + i + 4);
+
+		// The low 16 bits of pg_phase >> 9
+		vst1q_u16(lanes->pg_phase_out + i, vcombine_u16(vmovn_u32(vshrq_n_u32(lo, 9)), vmovn_u32(vshrq_n_u32(hi, 9))));
+
+		lo = vbicq_u32(lo, vreinterpretq_u32_s32(vmovl_s16(vget_low_s16(reset))));
+		hi = vbicq_u32(hi, vreinterpretq_u32_s32(vmovl_s16(vget_high_s16(reset))));
+		vst1q_u32(lanes->pg_phase + i, vaddq_u32(lo, vld1q_u32(lanes->pg_inc + i)));
+		vst1q_u32(lanes->pg_phase + i + 4, vaddq_u32(hi, vld1q_u32(lanes->pg_inc + i + 4)));
+	}
+}
+
+static void waveform(opl3_lanes *lanes, uint begin, uint end) {
+	const int16x8_t phase_mask = vdupq_n_s16(0x3ff);
+	const int16x8_t max_level = vdupq_n_s16(0x1fff);
+
+	for (uint i = begin; i < end; i += 8) {
+		const int16x8_t phase = vandq_s16(vaddq_s16(vld1q_s16((const int16 *)lanes->pg_phase_out + i), vld1q_s16(lanes->mod + i)), phase_mask);
+		const int16x8_t logsin = lookup(NukedKernels::waveTable, vaddq_s16(vld1q_s16(lanes->wf_base + i), phase));
+
+		int16x8_t level = vandq_s16(logsin, vdupq_n_s16(0x7fff));
+		level = vaddq_s16(level, vshlq_n_s16(vld1q_s16(lanes->eg_out + i), 3));
+		level = vminq_s16(level, max_level);
+
+		const int16x8_t out = veorq_s16(lookup(NukedKernels::expTable, level), vshrq_n_s16(logsin, 15));
+		vst1q_s16(lanes->out + i, out);
+	}
+}
+
+}; // End of class
+
+const NukedKernels::Table NukedKernels::neon = {
+	NukedKernelsImpl_NEON::feedback,
+	NukedKernelsImpl_NEON::envelope,
+	NukedKernelsImpl_NEON::phase,
+	NukedKernelsImpl_NEON::waveform
+};
+
+} // End of namespace NUKED
+} // End of namespace OPL
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
@@ -0,0 +1,231 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "audio/softsynth/opl/nuked_kernels.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace OPL {
+namespace NUKED {
+
+class NukedKernelsImpl_SSE2 {
+public:
+
+static inline __m128i load(const int16 *src) {
+	return _mm_loadu_si128((const __m128i *)src);
+}
+
+static inline void store(int16 *dst, __m128i val) {
+	_mm_storeu_si128((__m128i *)dst, val);
+}
+
+static inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/** Looks up eight 16-bit table entries. SSE2 has no gathers. */
+static inline __m128i lookup(const uint16 *table, __m128i index) {
+	uint16 i[8];
+	_mm_storeu_si128((__m128i *)i, index);
+	return _mm_setr_epi16(table[i[0]], table[i[1]], table[i[2]], table[i[3]],
+	                      table[i[4]], table[i[5]], table[i[6]], table[i[7]]);
+}
+
+static void feedback(opl3_lanes *lanes) {
+	for (uint i = 0; i < kNumSlots; i += 8) {
+		const __m128i out = load(lanes->out + i);
+		const __m128i prout = load(lanes->out + kSlotLanes + i);
+		const __m128i mul = load(lanes->fb_mul + i);
+
+		// (prout + out) * fb_mul, in 32 bits
+		const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(out, prout), _mm_unpacklo_epi16(mul, mul));
+		const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(out, prout), _mm_unpackhi_epi16(mul, mul));
+		const __m128i fbmod = _mm_packs_epi32(_mm_srai_epi32(lo, 8), _mm_srai_epi32(hi, 8));
+
+		store(lanes->fbmod + i, fbmod);
+		store(lanes->out + kSlotLanes + i, out);
+		store(lanes->mod + i, _mm_and_si128(fbmod, load(lanes->fb_sel + i)));
+	}
+}
+
+static void envelope(opl3_lanes *lanes, const opl3_eg_params *eg) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+	const __m128i two = _mm_set1_epi16(2);
+	const __m128i three = _mm_set1_epi16(3);
+	const __m128i fifteen = _mm_set1_epi16(15);
+	const __m128i rout_mask = _mm_set1_epi16(0x1ff);
+	const __m128i tremolo = _mm_set1_epi16(eg->tremolo);
+	const __m128i eg_add = _mm_set1_epi16(eg->eg_add);
+	const __m128i eg_state = _mm_set1_epi16(eg->eg_state);
+	const __m128i eg_state_mask = _mm_set1_epi16(eg->eg_state ? ~0 : 0);
+	const __m128i incstep1 = _mm_set1_epi16(eg->eg_incstep[1]);
+	const __m128i incstep2 = _mm_set1_epi16(eg->eg_incstep[2]);
+	const __m128i incstep3 = _mm_set1_epi16(eg->eg_incstep[3]);
+
+	for (uint i = 0; i < kNumSlots; i += 8) {
+		const __m128i rout = load(lanes->eg_rout + i);
+		const __m128i gen = load(lanes->eg_gen + i);
+		const __m128i key = load(lanes->key + i);
+
+		const __m128i attack = _mm_cmpeq_epi16(gen, zero);
+		const __m128i decay = _mm_cmpeq_epi16(gen, one);
+		const __m128i sustain = _mm_cmpeq_epi16(gen, two);
+		const __m128i release = _mm_cmpeq_epi16(gen, three);
+		const __m128i reset = _mm_and_si128(key, release);
+
+		store(lanes->eg_out + i, _mm_add_epi16(_mm_add_epi16(rout, load(lanes->eg_base + i)),
+		                                       _mm_and_si128(tremolo, load(lanes->trem + i))));
+		store(lanes->pg_reset + i, reset);
+
+		// The rate of the stage, the attack rate on reset
+		__m128i rate = _mm_and_si128(load(lanes->eg_rate[0] + i), _mm_or_si128(attack, reset));
+		rate = _mm_or_si128(rate, _mm_and_si128(load(lanes->eg_rate[1] + i), decay));
+		rate = _mm_or_si128(rate, _mm_and_si128(load(lanes->eg_rate[2] + i), sustain));
+		rate = _mm_or_si128(rate, _mm_and_si128(load(lanes->eg_rate[3] + i), _mm_andnot_si128(reset, release)));
+		const __m128i rate_hi = _mm_and_si128(rate, fifteen);
+		const __m128i rate_lo = _mm_and_si128(_mm_srli_epi16(rate, 4), three);
+		const __m128i nonzero = _mm_cmpeq_epi16(_mm_and_si128(rate, _mm_set1_epi16(0x40)), _mm_set1_epi16(0x40));
+		const __m128i rate_hi_max = _mm_cmpeq_epi16(rate_hi, fifteen);
+
+		// The shift of the slow rates
+		const __m128i eg_shift = _mm_add_epi16(rate_hi, eg_add);
+		__m128i shift_lo = _mm_and_si128(_mm_cmpeq_epi16(eg_shift, _mm_set1_epi16(12)), one);
+		shift_lo = _mm_or_si128(shift_lo, _mm_and_si128(_mm_cmpeq_epi16(eg_shift, _mm_set1_epi16(13)), _mm_and_si128(_mm_srli_epi16(rate_lo, 1), one)));
+		shift_lo = _mm_or_si128(shift_lo, _mm_and_si128(_mm_cmpeq_epi16(eg_shift, _mm_set1_epi16(14)), _mm_and_si128(rate_lo, one)));
+		shift_lo = _mm_and_si128(shift_lo, eg_state_mask);
+
+		// The shift of the fast rates
+		__m128i incstep = _mm_and_si128(_mm_cmpeq_epi16(rate_lo, one), incstep1);
+		incstep = _mm_or_si128(incstep, _mm_and_si128(_mm_cmpeq_epi16(rate_lo, two), incstep2));
+		incstep = _mm_or_si128(incstep, _mm_and_si128(_mm_cmpeq_epi16(rate_lo, three), incstep3));
+		__m128i shift_hi = _mm_min_epi16(_mm_add_epi16(_mm_and_si128(rate_hi, three), incstep), three);
+		shift_hi = _mm_or_si128(shift_hi, _mm_and_si128(_mm_cmpeq_epi16(shift_hi, zero), eg_state));
+
+		const __m128i slow = _mm_cmplt_epi16(rate_hi, _mm_set1_epi16(12));
+		const __m128i shift = _mm_and_si128(nonzero, select(slow, shift_lo, shift_hi));
+		const __m128i shift1 = _mm_cmpeq_epi16(shift, one);
+		const __m128i shift2 = _mm_cmpeq_epi16(shift, two);
+		const __m128i shift3 = _mm_cmpeq_epi16(shift, three);
+
+		// Instant attack, and envelope off
+		const __m128i eg_off = _mm_cmpeq_epi16(_mm_and_si128(rout, _mm_set1_epi16(0x1f8)), _mm_set1_epi16(0x1f8));
+		const __m128i force_off = _mm_andnot_si128(attack, _mm_andnot_si128(reset, eg_off));
+		__m128i new_rout = _mm_andnot_si128(_mm_and_si128(reset, rate_hi_max), rout);
+		new_rout = select(force_off, rout_mask, new_rout);
+
+		// Attack: ~eg_rout >> (4 - shift)
+		const __m128i not_rout = _mm_xor_si128(rout, _mm_set1_epi16(-1));
+		__m128i attack_inc = _mm_and_si128(shift1, _mm_srai_epi16(not_rout, 3));
+		attack_inc = _mm_or_si128(attack_inc, _mm_and_si128(shift2, _mm_srai_epi16(not_rout, 2)));
+		attack_inc = _mm_or_si128(attack_inc, _mm_and_si128(shift3, _mm_srai_epi16(not_rout, 1)));
+		const __m128i rout_zero = _mm_cmpeq_epi16(rout, zero);
+		const __m128i attacking = _mm_andnot_si128(_mm_or_si128(rout_zero, rate_hi_max), _mm_and_si128(attack, key));
+		attack_inc = _mm_and_si128(attacking, attack_inc);
+
+		// Decay, sustain and release: 1 << (shift - 1)
+		const __m128i reach_sl = _mm_and_si128(decay, _mm_cmpeq_epi16(_mm_srli_epi16(rout, 4), load(lanes->eg_sl + i)));
+		const __m128i linear = _mm_andnot_si128(_mm_or_si128(eg_off, reset),
+		                                        _mm_or_si128(_mm_andnot_si128(reach_sl, decay), _mm_or_si128(sustain, release)));
+		const __m128i linear_inc = _mm_and_si128(linear, _mm_add_epi16(shift, _mm_and_si128(shift3, one)));
+
+		new_rout = _mm_add_epi16(new_rout, _mm_or_si128(attack_inc, linear_inc));
+		store(lanes->eg_rout + i, _mm_and_si128(new_rout, rout_mask));
+
+		__m128i new_gen = select(_mm_and_si128(attack, rout_zero), one, gen);
+		new_gen = select(reach_sl, two, new_gen);
+		new_gen = _mm_andnot_si128(reset, new_gen);
+		new_gen = select(key, new_gen, three);
+		store(lanes->eg_gen + i, new_gen);
+	}
+}
+
+static void phase(opl3_lanes *lanes) {
+	for (uint i = 0; i < kNumSlots; i += 8) {
+		const __m128i reset = load(lanes->pg_reset + i);
+		__m128i lo = _mm_loadu_si128((const __m128i *)(lanes->pg_phase + i));
+		__m128i hi = _mm_loadu_si128((const __m128i *)(lanes->pg_phase + i + 4));
+
+		// The low 16 bits of pg_phase >> 9, sign extended so that they pack unchanged
+		const __m128i out_lo = _mm_srai_epi32(_mm_slli_epi32(_mm_srli_epi32(lo, 9), 16), 16);
+		const __m128i out_hi = _mm_srai_epi32(_mm_slli_epi32(_mm_srli_epi32(hi, 9), 16), 16);
+		_mm_storeu_si128((__m128i *)(lanes->pg_phase_out + i), _mm_packs_epi32(out_lo, out_hi));
+
+		lo = _mm_andnot_si128(_mm_unpacklo_epi16(reset, reset), lo);
+		hi = _mm_andnot_si128(_mm_unpackhi_epi16(reset, reset), hi);
+		lo = _mm_add_epi32(lo, _mm_loadu_si128((const __m128i *)(lanes->pg_inc + i)));
+		hi = _mm_add_epi32(hi, _mm_loadu_si128((const __m128i *)(lanes->pg_inc + i + 4)));
+		_mm_storeu_si128((__m128i *)(lanes->pg_phase + i), lo);
+		_mm_storeu_si128((__m128i *)(lanes->pg_phase + i + 4), hi);
+	}
+}
+
+static void waveform(opl3_lanes *lanes, uint begin, uint end) {
+	const __m128i phase_mask = _mm_set1_epi16(0x3ff);
+	const __m128i max_level = _mm_set1_epi16(0x1fff);
+
+	for (uint i = begin; i < end; i += 8) {
+		const __m128i phase = _mm_and_si128(_mm_add_epi16(load((const int16 *)lanes->pg_phase_out + i), load(lanes->mod + i)), phase_mask);
+		const __m128i logsin = lookup(NukedKernels::waveTable, _mm_add_epi16(load(lanes->wf_base + i), phase));
+
+		__m128i level = _mm_and_si128(logsin, _mm_set1_epi16(0x7fff));
+		level = _mm_add_epi16(level, _mm_slli_epi16(load(lanes->eg_out + i), 3));
+		level = _mm_min_epi16(level, max_level);
+
+		const __m128i out = _mm_xor_si128(lookup(NukedKernels::expTable, level), _mm_srai_epi16(logsin, 15));
+		store(lanes->out + i, out);
+	}
+}
+
+}; // End of class
+
+const NukedKernels::Table NukedKernels::sse2 = {
+	NukedKernelsImpl_SSE2::feedback,
+	NukedKernelsImpl_SSE2::envelope,
+	NukedKernelsImpl_SSE2::phase,
+	NukedKernelsImpl_SSE2::waveform
+};
+
+} // End of namespace NUKED
+} // End of namespace OPL
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
@@ -113,7 +113,7 @@ bool DefaultAudioCDManager::play(int track, int numLoops, int startFrame, int du
 		Audio::SeekableAudioStream *stream = nullptr;
 
 		for (auto &trackName : trackNames) {
-			stream = Audio::SeekableAudioStream::openStreamFile(Common::Path(trackName, '/'));
+			stream = Audio::SeekableAudioStream::openStreamFile(Common::Path(trackName, '/'), true);
 			if (stream)
 				break;
 		}
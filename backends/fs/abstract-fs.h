@@ -172,6 +172,17 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Retrieves the size and the last modification time of the file referred
+	 * by this node. Backends which are unable to provide this information
+	 * return false, which is also the default implementation.
+	 *
+	 * @param size             receives the size of the file in bytes
+	 * @param modificationTime receives the modification time, in seconds since the epoch
+	 *
+	 * @return bool true if the information was retrieved, false otherwise.
+	 */
+	virtual bool getFileStat(int64 &size, int64 &modificationTime) const;
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
@@ -192,6 +203,15 @@ public:
 	 */
 	virtual Common::SeekableReadStream *createReadStreamForAltStream(Common::AltStreamType altStreamType);
 
+	/**
+	 * Creates a SeekableReadStream instance which maps the file referred by
+	 * this node into memory. Backends which cannot map files return 0, which
+	 * is also the default implementation.
+	 *
+	 * @return pointer to the stream object, 0 if the file cannot be mapped
+	 */
+	virtual Common::SeekableReadStream *createMappedReadStream();
+
 	/**
 	 * Creates a WriteStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -212,6 +232,14 @@ public:
 	* @return true if the directory is created successfully
 	*/
 	virtual bool createDirectory() = 0;
+
+	/**
+	 * Removes the file referred by this node. Backends which are unable to
+	 * remove files return false, which is also the default implementation.
+	 *
+	 * @return true if the file is removed successfully
+	 */
+	virtual bool removeFile();
 };
 
 
@@ -0,0 +1,60 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BACKENDS_FS_POSIX_POSIXMAPPEDSTREAM_H
+#define BACKENDS_FS_POSIX_POSIXMAPPEDSTREAM_H
+
+#include "common/memstream.h"
+#include "common/str.h"
+
+/**
+ * A read only file stream which maps the whole file into memory with mmap.
+ *
+ * The system only reads the pages of the file when they are first accessed,
+ * and shares them with its file cache. With getMappedData(), the callers can
+ * use the contents of a large data file without keeping a copy of it.
+ *
+ * If another process truncates the file, reading the missing pages raises
+ * SIGBUS instead of a read error. The file system nodes only create these
+ * streams when asked to with createMappedReadStream().
+ */
+class MappedReadStream final : public Common::MemoryReadStream {
+public:
+	/**
+	 * Map the file at @p path.
+	 *
+	 * Empty files, files which are not regular files and files larger than
+	 * what a MemoryReadStream can address are not mapped.
+	 *
+	 * @return The new stream, or nullptr if the file should not or could not be mapped.
+	 */
+	static MappedReadStream *makeFromPath(const Common::String &path);
+
+	~MappedReadStream() override;
+
+private:
+	MappedReadStream(void *data, uint32 dataSize);
+
+	void *_data;
+	uint32 _dataSize;
+};
+
+#endif
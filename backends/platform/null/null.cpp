@@ -51,6 +51,13 @@ typedef void (*sighandler_t)(int);
 #include "backends/mutex/null/null-mutex.h"
 #include "base/main.h"
 
+#ifdef NULL_DRIVER_USE_THREADS
+#include "backends/mutex/pthread/pthread-mutex.h"
+#include "common/thread.h"
+
+#include <pthread.h>
+#endif
+
 #ifndef NULL_DRIVER_USE_FOR_TEST
 #include "backends/saves/default/default-saves.h"
 #include "backends/timer/default/default-timer.h"
@@ -85,7 +92,13 @@ public:
 	virtual bool pollEvent(Common::Event &event);
 
 	virtual Common::MutexInternal *createMutex();
+#ifdef NULL_DRIVER_USE_THREADS
+	virtual Common::ThreadInternal *createThread(void (*proc)(void *data), void *data);
+	virtual Common::SemaphoreInternal *createSemaphore();
+	virtual uint32 getCurrentThreadId();
+#endif
 	virtual uint32 getMillis(bool skipRecord = false);
+	virtual uint64 getMicros();
 	virtual void delayMillis(uint msecs);
 	virtual void getTimeAndDate(TimeDate &td, bool skipRecord = false) const;
 
@@ -187,8 +200,84 @@ bool OSystem_NULL::pollEvent(Common::Event &event) {
 }
 
 Common::MutexInternal *OSystem_NULL::createMutex() {
+#ifdef NULL_DRIVER_USE_THREADS
+	return createPthreadMutexInternal();
+#else
 	return new NullMutexInternal();
+#endif
+}
+
+#ifdef NULL_DRIVER_USE_THREADS
+class NullThreadInternal : public Common::ThreadInternal {
+public:
+	NullThreadInternal(void (*proc)(void *data), void *data) : _proc(proc), _data(data) {}
+
+	bool start() { return pthread_create(&_thread, nullptr, threadProc, this) == 0; }
+	void join() override { pthread_join(_thread, nullptr); }
+
+private:
+	static void *threadProc(void *arg) {
+		NullThreadInternal *thread = (NullThreadInternal *)arg;
+		thread->_proc(thread->_data);
+		return nullptr;
+	}
+
+	pthread_t _thread;
+	void (*_proc)(void *data);
+	void *_data;
+};
+
+class NullSemaphoreInternal : public Common::SemaphoreInternal {
+public:
+	NullSemaphoreInternal() : _count(0) {
+		pthread_mutex_init(&_mutex, nullptr);
+		pthread_cond_init(&_cond, nullptr);
+	}
+
+	~NullSemaphoreInternal() override {
+		pthread_cond_destroy(&_cond);
+		pthread_mutex_destroy(&_mutex);
+	}
+
+	void post() override {
+		pthread_mutex_lock(&_mutex);
+		_count++;
+		pthread_cond_signal(&_cond);
+		pthread_mutex_unlock(&_mutex);
+	}
+
+	void wait() override {
+		pthread_mutex_lock(&_mutex);
+		while (!_count)
+			pthread_cond_wait(&_cond, &_mutex);
+		_count--;
+		pthread_mutex_unlock(&_mutex);
+	}
+
+private:
+	pthread_mutex_t _mutex;
+	pthread_cond_t _cond;
+	uint _count;
+};
+
+Common::ThreadInternal *OSystem_NULL::createThread(void (*proc)(void *data), void *data) {
+	NullThreadInternal *thread = new NullThreadInternal(proc, data);
+	if (!thread->start()) {
+		delete thread;
+		return nullptr;
+	}
+
+	return thread;
+}
+
+Common::SemaphoreInternal *OSystem_NULL::createSemaphore() {
+	return new NullSemaphoreInternal();
+}
+
+uint32 OSystem_NULL::getCurrentThreadId() {
+	return (uint32)(size_t)pthread_self();
 }
+#endif
 
 uint32 OSystem_NULL::getMillis(bool skipRecord) {
 #ifdef POSIX
@@ -205,6 +294,18 @@ uint32 OSystem_NULL::getMillis(bool skipRecord) {
 #endif
 }
 
+uint64 OSystem_NULL::getMicros() {
+#ifdef POSIX
+	timeval curTime;
+
+	gettimeofday(&curTime, 0);
+
+	return (uint64)(curTime.tv_sec - _startTime.tv_sec) * 1000000 + (curTime.tv_usec - _startTime.tv_usec);
+#else
+	return (uint64)getMillis(true) * 1000;
+#endif
+}
+
 void OSystem_NULL::delayMillis(uint msecs) {
 #ifdef POSIX
 	usleep(msecs * 1000);
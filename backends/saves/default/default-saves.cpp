@@ -233,6 +233,25 @@ bool DefaultSaveFileManager::exists(const Common::String &filename) {
 	return _saveFileCache.contains(filename);
 }
 
+bool DefaultSaveFileManager::getSavefileStat(const Common::String &filename, int64 &size, int64 &modificationTime) {
+	// Assure the savefile name cache is up-to-date.
+	assureCached(getSavePath());
+	if (getError().getCode() != Common::kNoError)
+		return false;
+
+	// Locked files are being downloaded, so their contents are about to change
+	for (const auto &lockedFile : _lockedFiles) {
+		if (filename == lockedFile)
+			return false;
+	}
+
+	SaveFileCache::const_iterator file = _saveFileCache.find(filename);
+	if (file == _saveFileCache.end())
+		return false;
+
+	return file->_value.getFileStat(size, modificationTime);
+}
+
 Common::Path DefaultSaveFileManager::getSavePath() const {
 
 	Common::Path dir;
@@ -0,0 +1,138 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#if defined(SDL_BACKEND)
+
+#include "backends/threads/sdl/sdl-threads.h"
+#include "backends/platform/sdl/sdl-sys.h"
+#include "common/textconsole.h"
+
+/**
+ * SDL thread
+ */
+class SdlThreadInternal final : public Common::ThreadInternal {
+public:
+	SdlThreadInternal(void (*proc)(void *data), void *data) : _proc(proc), _data(data), _thread(nullptr) {}
+	~SdlThreadInternal() override { assert(!_thread); }
+
+	bool start() {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+		_thread = SDL_CreateThread(threadProc, "ScummVM worker", this);
+#else
+		_thread = SDL_CreateThread(threadProc, this);
+#endif
+		return _thread != nullptr;
+	}
+
+	void join() override {
+		if (_thread) {
+			SDL_WaitThread(_thread, nullptr);
+			_thread = nullptr;
+		}
+	}
+
+private:
+	static int SDLCALL threadProc(void *data) {
+		SdlThreadInternal *thread = (SdlThreadInternal *)data;
+		thread->_proc(thread->_data);
+		return 0;
+	}
+
+	void (*_proc)(void *data);
+	void *_data;
+	SDL_Thread *_thread;
+};
+
+/**
+ * SDL semaphore
+ */
+class SdlSemaphoreInternal final : public Common::SemaphoreInternal {
+public:
+	SdlSemaphoreInternal() { _semaphore = SDL_CreateSemaphore(0); }
+	~SdlSemaphoreInternal() override { SDL_DestroySemaphore(_semaphore); }
+
+	bool isValid() const { return _semaphore != nullptr; }
+
+	void post() override {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+		SDL_SignalSemaphore(_semaphore);
+#else
+		SDL_SemPost(_semaphore);
+#endif
+	}
+
+	void wait() override {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+		SDL_WaitSemaphore(_semaphore);
+#else
+		SDL_SemWait(_semaphore);
+#endif
+	}
+
+private:
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+	SDL_Semaphore *_semaphore;
+#else
+	SDL_sem *_semaphore;
+#endif
+};
+
+Common::ThreadInternal *createSdlThreadInternal(void (*proc)(void *data), void *data) {
+	SdlThreadInternal *thread = new SdlThreadInternal(proc, data);
+	if (!thread->start()) {
+		warning("Unable to create thread: %s", SDL_GetError());
+		delete thread;
+		return nullptr;
+	}
+	return thread;
+}
+
+Common::SemaphoreInternal *createSdlSemaphoreInternal() {
+	SdlSemaphoreInternal *semaphore = new SdlSemaphoreInternal();
+	if (!semaphore->isValid()) {
+		delete semaphore;
+		return nullptr;
+	}
+	return semaphore;
+}
+
+uint getSdlCPUCount() {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+	int count = SDL_GetNumLogicalCPUCores();
+#elif SDL_VERSION_ATLEAST(2, 0, 0)
+	int count = SDL_GetCPUCount();
+#else
+	int count = 1;
+#endif
+	return count > 0 ? count : 1;
+}
+
+uint32 getSdlCurrentThreadId() {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+	return (uint32)SDL_GetCurrentThreadID();
+#else
+	return (uint32)SDL_ThreadID();
+#endif
+}
+
+#endif
@@ -27,6 +27,7 @@
 #include "engines/advancedDetector.h"
 #include "engines/metaengine.h"
 #include "base/commandLine.h"
+#include "base/detectionScanner.h"
 #include "base/plugins.h"
 #include "base/version.h"
 
@@ -97,6 +98,11 @@ static const char HELP_STRING1[] =
 	"  --auto-detect            Display a list of games from current or specified directory\n"
 	"                           and start the first one. Use --path=PATH to specify a directory.\n"
 	"  --recursive              In combination with --add or --detect recurse down all subdirectories\n"
+	"  --jobs=NUM               In combination with --add --recursive, scan the subdirectories\n"
+	"                           with NUM worker threads (default: 1, 0 = one per CPU core)\n"
+	"  --detection-cache=MODE   Select how the on-disk cache of file MD5s used by game detection\n"
+	"                           is handled: on (default), off, verify (recompute cached MD5s and\n"
+	"                           report stale entries) or rebuild (discard the cache and recompute it)\n"
 	"  --no-exit                In combination with commands that exit after running, like --add or --list-engines,\n"
 	"                           open the launcher instead of exiting\n"
 #if defined(WIN32)
@@ -205,6 +211,14 @@ static const char HELP_STRING4[] =
 	"  --screenshot-period=NUM  When recording, trigger a screenshot every NUM milliseconds\n"
 	"                           (default: 60000)\n"
 	"  --list-records           Display a list of recordings for the target specified\n"
+	"  --benchmark=FILE         Play back the recording FILE headless and as fast as\n"
+	"                           possible, and save the time spent in each frame as JSON\n"
+	"  --benchmark-output=FILE  Specify where to save the benchmark results\n"
+	"                           (default: the recording file name followed by .json)\n"
+#endif
+#ifdef ENABLE_PROFILER
+	"  --profile=FILE           Record the time spent in the instrumented code while\n"
+	"                           the game runs, and save it to FILE as a Chrome trace\n"
 #endif
 	"\n"
 #if defined(ENABLE_SKY) || defined(ENABLE_QUEEN)
@@ -322,6 +336,9 @@ void registerDefaults() {
 	ConfMan.registerDefault("dump_midi", false);
 	ConfMan.registerDefault("enable_gs", false);
 	ConfMan.registerDefault("midi_gain", 100);
+	ConfMan.registerDefault("midi_render_thread", false);
+	ConfMan.registerDefault("music_render_cache", false);
+	ConfMan.registerDefault("music_render_cache_size", 256);
 
 	ConfMan.registerDefault("music_driver", "auto");
 	ConfMan.registerDefault("mt32_device", "null");
@@ -390,6 +407,14 @@ void registerDefaults() {
 	// If number of game entries in scummvm.ini exceeds the specified
 	// number, then skip scanning. -1 = scan always
 	ConfMan.registerDefault("gui_list_max_scan_entries", -1);
+	// Number of worker threads used by the mass add, 0 = one per CPU core
+	ConfMan.registerDefault("detection_jobs", 0);
+	// Number of threads used by the TinyGL renderer, 0 = one per CPU core
+	ConfMan.registerDefault("tinygl_threads", 0);
+	// Number of threads used by the graphics scalers, 0 = one per CPU core
+	ConfMan.registerDefault("scaler_threads", 0);
+	// Number of video frames decoded ahead on a worker thread, 0 = disabled
+	ConfMan.registerDefault("video_decode_ahead", 0);
 	ConfMan.registerDefault("game", "");
 
 #ifdef USE_FLUIDSYNTH
@@ -809,6 +834,23 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 
 			DO_LONG_OPTION_INT("screenshot-period")
 			END_OPTION
+
+			DO_LONG_OPTION("benchmark")
+				settings["record-mode"] = "benchmark";
+				settings["record-file-name"] = option;
+				settings["disable-display"] = "1";
+				settings["vsync"] = "false";
+			END_OPTION
+
+			DO_LONG_OPTION("benchmark-output")
+				settings["benchmark-output"] = Common::Path::fromCommandLine(option).toConfig();
+			END_OPTION
+#endif
+
+#ifdef ENABLE_PROFILER
+			DO_LONG_OPTION("profile")
+				settings["profile"] = Common::Path::fromCommandLine(option).toConfig();
+			END_OPTION
 #endif
 
 			DO_LONG_OPTION("opl-driver")
@@ -963,6 +1005,16 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_OPTION_BOOL("recursive")
 			END_OPTION
 
+			DO_LONG_OPTION_INT("jobs")
+				if (retval < 0)
+					usage("--jobs: Invalid number of jobs '%s'", option);
+			END_OPTION
+
+			DO_LONG_OPTION("detection-cache")
+				if (strcmp(option, "on") && strcmp(option, "off") && strcmp(option, "verify") && strcmp(option, "rebuild"))
+					usage("Unrecognized detection cache mode '%s'", option);
+			END_OPTION
+
 			DO_LONG_OPTION_BOOL("exit")
 			END_OPTION
 
@@ -1572,9 +1624,8 @@ static Common::String detectGames(const Common::Path &path, const Common::String
 	return buildQualifiedGameName(candidates[0].engineId, candidates[0].gameId);
 }
 
-static int recAddGames(const Common::FSNode &dir, const Common::String &engineId, const Common::String &gameId, bool recursive) {
+static int addDetectedGames(const DetectedGames &list, const Common::String &engineId, const Common::String &gameId) {
 	int count = 0;
-	DetectedGames list = getGameList(dir);
 	for (const auto &v : list) {
 		if ((v.engineId != engineId || v.gameId != gameId)
 		    && !gameId.empty()) {
@@ -1600,6 +1651,12 @@ static int recAddGames(const Common::FSNode &dir, const Common::String &engineId
 		}
 	}
 
+	return count;
+}
+
+static int recAddGames(const Common::FSNode &dir, const Common::String &engineId, const Common::String &gameId, bool recursive) {
+	int count = addDetectedGames(getGameList(dir), engineId, gameId);
+
 	if (recursive) {
 		Common::FSList files;
 		if (dir.getChildren(files, Common::FSNode::kListDirectoriesOnly)) {
@@ -1687,10 +1744,40 @@ static void calcMD5Mac(Common::Path &filePath, int32 length) {
 	}
 }
 
-static bool addGames(const Common::Path &path, const Common::String &engineId, const Common::String &gameId, bool recursive) {
+/**
+ * Add the games found in the given directory tree, listing the directories
+ * and running the detection on a pool of worker threads.
+ */
+static int scanAddGames(const Common::FSNode &dir, const Common::String &engineId, const Common::String &gameId, uint jobs) {
+	int count = 0;
+	DetectionScanner scanner(dir, true, jobs);
+	DetectionScanner::Result result;
+
+	while (!scanner.isDone()) {
+		if (!scanner.pollResult(result)) {
+			g_system->delayMillis(10);
+			continue;
+		}
+
+		if (!result.listed) {
+			if (result.dir.getPath() == dir.getPath())
+				printf("Path %s does not exist or is not a directory.\n", dir.getPath().toString(Common::Path::kNativeSeparator).c_str());
+			continue;
+		}
+
+		if (!result.unknownGameReport.empty())
+			g_system->logMessage(LogMessageType::kInfo, result.unknownGameReport.encode().c_str());
+
+		count += addDetectedGames(result.games, engineId, gameId);
+	}
+
+	return count;
+}
+
+static bool addGames(const Common::Path &path, const Common::String &engineId, const Common::String &gameId, bool recursive, uint jobs) {
 	//Current directory
 	Common::FSNode dir(path);
-	int added = recAddGames(dir, engineId, gameId, recursive);
+	int added = (recursive && jobs != 1) ? scanAddGames(dir, engineId, gameId, jobs) : recAddGames(dir, engineId, gameId, recursive);
 	printf("Added %d games\n", added);
 	if (added == 0 && !recursive) {
 		printf("Consider using --recursive to search inside subdirectories\n");
@@ -1909,6 +1996,11 @@ bool processSettings(Common::String &command, Common::StringMap &settings, Commo
 		}
 	}
 
+	// The detection cache is used by the commands below, so this setting
+	// must be known before they run.
+	if (settings.contains("detection-cache"))
+		ConfMan.set("detection_cache", settings["detection-cache"], Common::ConfigManager::kTransientDomain);
+
 	// For commands that normally exit, check if --no-exit was specified
 	bool cmdDoExit = settings.getValOrDefault("exit", "true") == "true";
 
@@ -2038,7 +2130,8 @@ bool processSettings(Common::String &command, Common::StringMap &settings, Commo
 		return cmdDoExit;
 	} else if (command == "add") {
 		Common::Path path(Common::Path::fromConfig(settings["path"]));
-		addGames(path, gameOption.engineId, gameOption.gameId, settings["recursive"] == "true");
+		uint jobs = settings.contains("jobs") ? (uint)strtol(settings["jobs"].c_str(), nullptr, 10) : 1;
+		addGames(path, gameOption.engineId, gameOption.gameId, settings["recursive"] == "true", jobs);
 		return cmdDoExit;
 	} else if (command == "md5" || command == "md5mac") {
 		Common::String filename = settings.getValOrDefault("md5-path", "scummvm");
@@ -2148,6 +2241,7 @@ bool processSettings(Common::String &command, Common::StringMap &settings, Commo
 	// Skip some settings that should only be used for the command-line commands
 	static const char * const skipSettings[] = {
 		"recursive",
+		"jobs",
 		"exit",
 		"md5-engine",
 		"md5-length",
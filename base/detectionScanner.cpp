@@ -0,0 +1,166 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "base/detectionScanner.h"
+#include "engines/metaengine.h"
+
+#include "common/workerpool.h"
+
+class DetectionScanJob : public Common::WorkerJob {
+public:
+	DetectionScanJob(DetectionScanner *scanner, const Common::FSNode &dir) : _scanner(scanner), _dir(dir) {}
+
+	void run() override {
+		_scanner->processDirectory(_dir);
+	}
+
+private:
+	DetectionScanner *_scanner;
+	Common::FSNode _dir;
+};
+
+DetectionScanner::DetectionScanner(const Common::FSNode &startDir, bool recursive, uint numThreads, uint32 skipADFlags, bool skipIncomplete)
+	: _recursive(recursive), _skipADFlags(skipADFlags), _skipIncomplete(skipIncomplete),
+	  _outstandingDirs(1), _scannedDirs(0), _totalDirs(1), _cancelled(false) {
+	_pool = new Common::WorkerPool(numThreads);
+
+	if (_pool->getThreadCount() > 0)
+		_pool->submit(new DetectionScanJob(this, startDir));
+	else
+		_pendingDirs.push(startDir);
+}
+
+DetectionScanner::~DetectionScanner() {
+	cancel();
+	delete _pool;
+}
+
+void DetectionScanner::cancel() {
+	{
+		Common::StackLock lock(_mutex);
+		_cancelled = true;
+		_pendingDirs.clear();
+		_results.clear();
+	}
+
+	_pool->cancel();
+	_pool->wait();
+
+	Common::StackLock lock(_mutex);
+	_outstandingDirs = 0;
+	_results.clear();
+}
+
+void DetectionScanner::scanDirectory(const Common::FSNode &dir, Result &result, Common::FSList &subdirs) {
+	Common::FSList files;
+
+	result.dir = dir;
+	result.listed = dir.getChildren(files, Common::FSNode::kListAll);
+	if (!result.listed)
+		return;
+
+	{
+		// The detectors and the caches they share are not thread-safe
+		Common::StackLock lock(_detectionMutex);
+
+		DetectionResults detectionResults = EngineMan.detectGames(files, _skipADFlags, _skipIncomplete);
+		if (detectionResults.foundUnknownGames())
+			result.unknownGameReport = detectionResults.generateUnknownGameReport(false, 80);
+		result.games = detectionResults.listRecognizedGames();
+	}
+
+	if (_recursive) {
+		for (const auto &file : files) {
+			if (file.isDirectory())
+				subdirs.push_back(file);
+		}
+	}
+}
+
+void DetectionScanner::processDirectory(const Common::FSNode &dir) {
+	{
+		Common::StackLock lock(_mutex);
+		if (_cancelled)
+			return;
+	}
+
+	Result result;
+	Common::FSList subdirs;
+	scanDirectory(dir, result, subdirs);
+
+	Common::StackLock lock(_mutex);
+	if (_cancelled)
+		return;
+
+	_results.push(result);
+	_scannedDirs++;
+	_outstandingDirs += subdirs.size();
+	_totalDirs += subdirs.size();
+
+	// Submitting the jobs while holding the lock keeps _outstandingDirs
+	// from reaching zero before they are queued.
+	for (const auto &subdir : subdirs)
+		_pool->submit(new DetectionScanJob(this, subdir));
+
+	_outstandingDirs--;
+}
+
+bool DetectionScanner::pollResult(Result &result) {
+	Common::StackLock lock(_mutex);
+
+	if (_results.empty() && !_pendingDirs.empty()) {
+		// No worker threads, scan the next directory now. Subdirectories are
+		// pushed in reverse order so that they are scanned in order.
+		Common::FSNode dir = _pendingDirs.pop();
+		Common::FSList subdirs;
+		Result scanned;
+
+		scanDirectory(dir, scanned, subdirs);
+		_results.push(scanned);
+		_scannedDirs++;
+		_outstandingDirs += subdirs.size();
+		_totalDirs += subdirs.size();
+		for (int i = subdirs.size() - 1; i >= 0; i--)
+			_pendingDirs.push(subdirs[i]);
+		_outstandingDirs--;
+	}
+
+	if (_results.empty())
+		return false;
+
+	result = _results.pop();
+	return true;
+}
+
+bool DetectionScanner::isDone() const {
+	Common::StackLock lock(_mutex);
+	return _outstandingDirs == 0 && _results.empty();
+}
+
+uint DetectionScanner::getScannedDirs() const {
+	Common::StackLock lock(_mutex);
+	return _scannedDirs;
+}
+
+uint DetectionScanner::getTotalDirs() const {
+	Common::StackLock lock(_mutex);
+	return _totalDirs;
+}
@@ -0,0 +1,117 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BASE_DETECTIONSCANNER_H
+#define BASE_DETECTIONSCANNER_H
+
+#include "common/fs.h"
+#include "common/mutex.h"
+#include "common/noncopyable.h"
+#include "common/queue.h"
+#include "common/stack.h"
+#include "common/ustr.h"
+
+#include "engines/game.h"
+
+namespace Common {
+class WorkerPool;
+}
+
+/**
+ * Runs the game detection over a directory tree.
+ *
+ * Listing the directories and running the detectors is done by a pool of
+ * worker threads, while the caller polls the results. The detectors are not
+ * thread-safe, so only one of them runs at a time; the listing of the
+ * directories, which is the slow part on network storage, happens in
+ * parallel with it.
+ *
+ * When the backend does not support threads, each call to pollResult()
+ * scans one directory synchronously, so that the caller can still spread
+ * the work over several calls.
+ */
+class DetectionScanner : Common::NonCopyable {
+public:
+	struct Result {
+		Common::FSNode dir;            ///< Directory which was scanned.
+		bool listed;                   ///< False if the directory could not be listed.
+		DetectedGames games;           ///< Games recognized in this directory.
+		Common::U32String unknownGameReport; ///< Report about unknown game variants, if any.
+
+		Result() : listed(false) {}
+	};
+
+	/**
+	 * Start scanning.
+	 *
+	 * @param startDir        Directory where the scan starts.
+	 * @param recursive       Whether to scan the subdirectories.
+	 * @param numThreads      Number of worker threads, 0 for one thread per CPU core.
+	 * @param skipADFlags     Passed to EngineManager::detectGames().
+	 * @param skipIncomplete  Passed to EngineManager::detectGames().
+	 */
+	DetectionScanner(const Common::FSNode &startDir, bool recursive, uint numThreads = 0, uint32 skipADFlags = 0, bool skipIncomplete = false);
+
+	/** Stop scanning, waiting for the directories being scanned. */
+	~DetectionScanner();
+
+	/**
+	 * Fetch the result of a scanned directory.
+	 *
+	 * @return False if no result is available yet (or the scan is done).
+	 */
+	bool pollResult(Result &result);
+
+	/** Return true once all the directories were scanned and their results fetched. */
+	bool isDone() const;
+
+	/** Stop scanning. The directories being scanned are finished, the others are skipped. */
+	void cancel();
+
+	/** Return the number of directories which were scanned so far. */
+	uint getScannedDirs() const;
+
+	/** Return the number of directories found so far, scanned or not. */
+	uint getTotalDirs() const;
+
+private:
+	friend class DetectionScanJob;
+
+	void scanDirectory(const Common::FSNode &dir, Result &result, Common::FSList &subdirs);
+	void processDirectory(const Common::FSNode &dir);
+
+	bool _recursive;
+	uint32 _skipADFlags;
+	bool _skipIncomplete;
+
+	Common::Mutex _mutex;
+	Common::Mutex _detectionMutex;
+	Common::Queue<Result> _results;
+	Common::Stack<Common::FSNode> _pendingDirs; ///< Only used when scanning synchronously
+	uint _outstandingDirs;
+	uint _scannedDirs;
+	uint _totalDirs;
+	bool _cancelled;
+
+	Common::WorkerPool *_pool;
+};
+
+#endif
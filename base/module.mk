@@ -4,6 +4,7 @@ MODULE_OBJS := \
 	test_new_standards.o \
 	main.o \
 	commandLine.o \
+	detectionScanner.o \
 	plugins.o \
 	version.o
 
@@ -692,6 +692,7 @@ DetectionResults EngineManager::detectGames(const Common::FSList &fslist, uint32
 
 	// Close all archives that were opened during detection
 	ADCacheMan.clearArchives();
+	ADCacheMan.flushPersistentCache(false);
 
 	return DetectionResults(candidates);
 }
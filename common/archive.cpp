@@ -25,6 +25,7 @@
 #include "common/system.h"
 #include "common/textconsole.h"
 #include "common/memstream.h"
+#include "common/profiler.h"
 #include "common/punycode.h"
 #include "common/debug.h"
 
@@ -41,6 +42,10 @@ bool ArchiveMember::isInMacArchive() const {
 	return false;
 }
 
+SeekableReadStream *ArchiveMember::createMappedReadStream() const {
+	return nullptr;
+}
+
 bool ArchiveMember::isDirectory() const {
 	return false;
 }
@@ -570,6 +575,8 @@ const ArchiveMemberPtr SearchSet::getMember(const Path &path) const {
 }
 
 SeekableReadStream *SearchSet::createReadStreamForMember(const Path &path) const {
+	PROFILE_ZONE("SearchSet::createReadStreamForMember");
+
 	if (path.empty())
 		return nullptr;
 
@@ -83,6 +83,18 @@ public:
 	virtual void listChildren(ArchiveMemberList &childList, const char *pattern = nullptr) const; /*!< Adds the immediate children of this archive member to childList, optionally matching a pattern. */
 	virtual U32String getDisplayName() const; /*!< Get the display name of the archive member. */
 	virtual bool isInMacArchive() const; /*!< Checks if the ArchiveMember is in a Mac archive, in which case resource forks and Finder info can only be loaded via alt streams. */
+
+	/**
+	 * Create a read stream whose getMappedData() returns the whole contents,
+	 * mapped into memory instead of read, when the member supports it.
+	 *
+	 * This is meant for large files which are read many times. Reading a
+	 * mapped file which another process truncates crashes instead of failing,
+	 * so the callers must ask for it explicitly.
+	 *
+	 * @return The stream, or nullptr if the member cannot be mapped, which is the default.
+	 */
+	virtual SeekableReadStream *createMappedReadStream() const;
 };
 
 struct ArchiveMemberDetails {
@@ -0,0 +1,135 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_ATOMIC_H
+#define COMMON_ATOMIC_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace Common {
+
+/**
+ * @defgroup common_atomic Atomic variables
+ * @ingroup common
+ *
+ * @brief Integer variables that can be shared between threads without a mutex.
+ * @{
+ */
+
+/**
+ * An integer variable with atomic operations.
+ *
+ * All operations are sequentially consistent, which is the easiest memory
+ * order to reason about and cheap enough for the places this is used in.
+ *
+ * On compilers without atomic builtins, the operations fall back to plain
+ * volatile accesses. This is only safe on single core systems, which
+ * fortunately is what all such ports currently run on.
+ */
+template<typename T>
+class Atomic : NonCopyable {
+public:
+	Atomic() : _value(0) {}
+	explicit Atomic(T value) : _value(value) {}
+
+#if defined(__GNUC__) || defined(__clang__)
+
+	T load() const { return __atomic_load_n(&_value, __ATOMIC_SEQ_CST); }
+	void store(T value) { __atomic_store_n(&_value, value, __ATOMIC_SEQ_CST); }
+	T exchange(T value) { return __atomic_exchange_n(&_value, value, __ATOMIC_SEQ_CST); }
+	T fetchAdd(T value) { return __atomic_fetch_add(&_value, value, __ATOMIC_SEQ_CST); }
+	T fetchSub(T value) { return __atomic_fetch_sub(&_value, value, __ATOMIC_SEQ_CST); }
+
+	bool compareExchange(T &expected, T desired) {
+		return __atomic_compare_exchange_n(&_value, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	}
+
+#elif defined(_MSC_VER)
+
+	T load() const { return (T)interlockedCompareExchange(const_cast<volatile T *>(&_value), 0, 0); }
+	void store(T value) { interlockedExchange(&_value, value); }
+	T exchange(T value) { return (T)interlockedExchange(&_value, value); }
+	T fetchAdd(T value) { return (T)interlockedExchangeAdd(&_value, value); }
+	T fetchSub(T value) { return (T)interlockedExchangeAdd(&_value, (T)(0 - value)); }
+
+	bool compareExchange(T &expected, T desired) {
+		T previous = (T)interlockedCompareExchange(&_value, desired, expected);
+		if (previous == expected)
+			return true;
+		expected = previous;
+		return false;
+	}
+
+#else
+
+	T load() const { return _value; }
+	void store(T value) { _value = value; }
+	T exchange(T value) { T previous = _value; _value = value; return previous; }
+	T fetchAdd(T value) { T previous = _value; _value = previous + value; return previous; }
+	T fetchSub(T value) { T previous = _value; _value = previous - value; return previous; }
+
+	bool compareExchange(T &expected, T desired) {
+		if (_value != expected) {
+			expected = _value;
+			return false;
+		}
+		_value = desired;
+		return true;
+	}
+
+#endif
+
+private:
+	volatile T _value;
+
+#if defined(_MSC_VER) && !defined(__GNUC__) && !defined(__clang__)
+	STATIC_ASSERT(sizeof(T) == 4 || sizeof(T) == 8, atomic_variables_must_be_4_or_8_bytes_with_msvc);
+
+	static int64 interlockedExchange(volatile T *dst, T value) {
+		if (sizeof(T) == 4)
+			return _InterlockedExchange((volatile long *)dst, (long)value);
+		return _InterlockedExchange64((volatile __int64 *)dst, (__int64)value);
+	}
+
+	static int64 interlockedExchangeAdd(volatile T *dst, T value) {
+		if (sizeof(T) == 4)
+			return _InterlockedExchangeAdd((volatile long *)dst, (long)value);
+		return _InterlockedExchangeAdd64((volatile __int64 *)dst, (__int64)value);
+	}
+
+	static int64 interlockedCompareExchange(volatile T *dst, T desired, T expected) {
+		if (sizeof(T) == 4)
+			return _InterlockedCompareExchange((volatile long *)dst, (long)desired, (long)expected);
+		return _InterlockedCompareExchange64((volatile __int64 *)dst, (__int64)desired, (__int64)expected);
+	}
+#endif
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
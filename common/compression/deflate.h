@@ -151,6 +151,21 @@ SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped,
 		DisposeAfterUse::Flag disposeParent = DisposeAfterUse::YES, uint64 knownSize = 0,
 		const byte *dict = nullptr, uint dictLen = 0);
 
+/**
+ * Like wrapDeflateReadStream(), for large streams which are not read in
+ * order. The decompressed stream saves the state of the decompression each
+ * time checkpointInterval more bytes have been decompressed, and seeks from
+ * the closest checkpoint instead of the start of the stream. A checkpoint
+ * takes about 40 KB of memory. Without ZLIB support, no checkpoints are
+ * saved.
+ *
+ * @param toBeWrapped	the stream to be wrapped
+ * @param knownSize	the length of the uncompressed data
+ * @param checkpointInterval	the amount of uncompressed data between two checkpoints
+ */
+SeekableReadStream *wrapSeekableDeflateReadStream(SeekableReadStream *toBeWrapped,
+		DisposeAfterUse::Flag disposeParent, uint64 knownSize, uint32 checkpointInterval);
+
 /**
  * Take an arbitrary SeekableReadStream and wrap it in a custom stream which
  * provides transparent on-the-fly decompression. Assumes the data it
@@ -95,6 +95,9 @@ typedef Byte Bytef;
 #include "common/compression/deflate.h"
 #include "common/compression/unzip.h"
 #include "common/memstream.h"
+#include "common/mutex.h"
+#include "common/ptr.h"
+#include "common/substream.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -237,6 +240,16 @@ Common::SharedArchiveContents unzOpenCurrentFile(unzFile file
   If there is no error, the return value is UNZ_OK.
 */
 
+Common::SeekableReadStream *unzOpenCurrentFileStream(unzFile file, uint32 checkpointInterval);
+/*
+  Open the current file in the zipfile as a stream which reads it from the
+  zipfile when needed, instead of reading all of it in memory.
+  Deflated files are decompressed while they are read, saving the state of
+  the decompression every checkpointInterval bytes for seeking.
+  The CRC is not checked.
+  If there is an error, the return value is NULL.
+*/
+
 int unzCloseCurrentFile(unzFile file);
 /*
   Close the file in zip opened with unzOpenCurrentFile
@@ -325,6 +338,8 @@ typedef Common::HashMap<Common::Path, cached_file_in_zip, Common::Path::IgnoreCa
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::SeekableReadStream> _streamRef;	/* owner of _stream, shared with the streamed files */
+	Common::SharedPtr<Common::Mutex> _streamMutex;	/* locked around the uses of _stream once files are streamed */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -459,6 +474,7 @@ unzFile unzOpen(Common::SeekableReadStream *stream, bool flattenTree) {
 	int err = UNZ_OK;
 
 	us->_stream = stream;
+	us->_streamRef.reset(stream);
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
 	if (central_pos == 0)
@@ -489,7 +505,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream, bool flattenTree) {
 		err = UNZ_ERRNO;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return nullptr;
 	}
@@ -516,7 +531,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream, bool flattenTree) {
 		err = UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return nullptr;
 	}
@@ -606,7 +620,6 @@ int unzClose(unzFile file) {
 		return UNZ_PARAMERROR;
 	s = (unz_s *)file;
 
-	delete s->_stream;
 	delete s;
 	return UNZ_OK;
 }
@@ -1024,17 +1037,94 @@ Common::SharedArchiveContents unzOpenCurrentFile (unzFile file
 	return Common::SharedArchiveContents(uncompressedBuffer, s->cur_file_info.uncompressed_size);
 }
 
+/* A stored file, or the compressed data of a file, read from the zipfile.
+   The zipfile stream stays alive while this is open. It may be read on
+   another thread than the archive, so both lock the zipfile stream. */
+class ZipFileReadStream : public Common::SafeMutexedSeekableSubReadStream {
+public:
+	ZipFileReadStream(const Common::SharedPtr<Common::SeekableReadStream> &parentStream, const Common::SharedPtr<Common::Mutex> &mutex, uint32 begin, uint32 end) :
+		Common::SafeMutexedSeekableSubReadStream(parentStream.get(), begin, end, DisposeAfterUse::NO, *mutex),
+		_parentRef(parentStream), _mutexRef(mutex) {}
+
+	bool seek(int64 offset, int whence = SEEK_SET) override {
+		Common::StackLock lock(_mutex);
+		return Common::SafeMutexedSeekableSubReadStream::seek(offset, whence);
+	}
+
+private:
+	Common::SharedPtr<Common::SeekableReadStream> _parentRef;
+	Common::SharedPtr<Common::Mutex> _mutexRef;
+};
+
+Common::SeekableReadStream *unzOpenCurrentFileStream(unzFile file, uint32 checkpointInterval) {
+	uInt iSizeVar;
+	unz_s *s;
+	uLong offset_local_extrafield;  /* offset of the local extra field */
+	uInt  size_local_extrafield;    /* size of the local extra field */
+
+	if (file == nullptr)
+		return nullptr;
+	s = (unz_s *)file;
+	if (!s->current_file_ok)
+		return nullptr;
+
+	if (unzlocal_CheckCurrentFileCoherencyHeader(s, &iSizeVar,
+				&offset_local_extrafield, &size_local_extrafield) != UNZ_OK)
+		return nullptr;
+
+	if (!s->_streamMutex)
+		s->_streamMutex.reset(new Common::Mutex());
+
+	const uint32 begin = s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER + iSizeVar;
+	Common::SeekableReadStream *stream = new ZipFileReadStream(s->_streamRef, s->_streamMutex, begin, begin + s->cur_file_info.compressed_size);
+
+	switch (s->cur_file_info.compression_method) {
+	case 0: // Store
+		return stream;
+	case Z_DEFLATED:
+		return Common::wrapSeekableDeflateReadStream(stream, DisposeAfterUse::YES, s->cur_file_info.uncompressed_size, checkpointInterval);
+	default:
+		warning("Unknown compression algorithm %d", (int)s->cur_file_info.compression_method);
+		delete stream;
+		return nullptr;
+	}
+}
+
 
 namespace Common {
 
 
 class ZipArchive : public MemcachingCaseInsensitiveArchive {
+	enum {
+		/** Larger files are streamed from the archive rather than kept in memory */
+		kMaxInMemoryFileSize = 256 * 1024,
+		/** The distance between two saved states when streaming a deflated file */
+		kCheckpointInterval = 1024 * 1024
+	};
+
 	unzFile _zipFile;
 #ifndef USE_ZLIB
 	Common::CRC32 _crc;
 #endif
 	bool _flattenTree;
 
+	/** Lock the archive stream, which the streamed files may be reading on other threads. */
+	class StreamLock {
+	public:
+		explicit StreamLock(unzFile zipFile) : _mutex(((unz_s *)zipFile)->_streamMutex) {
+			if (_mutex)
+				_mutex->lock();
+		}
+
+		~StreamLock() {
+			if (_mutex)
+				_mutex->unlock();
+		}
+
+	private:
+		SharedPtr<Mutex> _mutex;
+	};
+
 public:
 	ZipArchive(unzFile zipFile, bool flattenTree);
 
@@ -1112,8 +1202,18 @@ const ArchiveMemberPtr ZipArchive::getMember(const Path &path) const {
 }
 
 Common::SharedArchiveContents ZipArchive::readContentsForPath(const Common::Path &path) const {
+	StreamLock lock(_zipFile);
 	if (unzLocateFile(_zipFile, path, 2) != UNZ_OK)
 		return Common::SharedArchiveContents();
+
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	if (archive->cur_file_info.uncompressed_size > kMaxInMemoryFileSize) {
+		SeekableReadStream *stream = unzOpenCurrentFileStream(_zipFile, kCheckpointInterval);
+		if (!stream)
+			return Common::SharedArchiveContents();
+		return Common::SharedArchiveContents::bypass(stream);
+	}
+
 #ifndef USE_ZLIB
 	return unzOpenCurrentFile(_zipFile, _crc);
 #else
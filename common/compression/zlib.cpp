@@ -33,6 +33,7 @@
 
 #include "common/compression/deflate.h"
 
+#include "common/array.h"
 #include "common/ptr.h"
 #include "common/util.h"
 #include "common/stream.h"
@@ -93,6 +94,10 @@ static bool _shownBackwardSeekingWarning = false;
  * A simple wrapper class which can be used to wrap around an arbitrary
  * other SeekableReadStream and will then provide on-the-fly decompression support.
  * Assumes the compressed data to be in gzip format.
+ *
+ * With a checkpoint interval, the state of the decompression is saved each
+ * time that many bytes have been decompressed, so that seeking resumes from
+ * the closest checkpoint before the new position.
  */
 class GZipReadStream : public SeekableReadStream {
 protected:
@@ -100,6 +105,13 @@ protected:
 		BUFSIZE = 16384		// 1 << MAX_WBITS
 	};
 
+	struct Checkpoint {
+		uint32 outputPos;
+		uint64 inputPos;
+		/** A copy of the state, which keeps its address as zlib requires */
+		z_stream *state;
+	};
+
 	byte	_buf[BUFSIZE];
 
 	DisposablePtr<SeekableReadStream> _wrapped;
@@ -110,9 +122,43 @@ protected:
 	uint32 _origSize;
 	bool _eos;
 
+	uint32 _checkpointInterval;
+	Array<Checkpoint> _checkpoints;
+
+	uint32 nextCheckpointPos() const {
+		return (_checkpoints.size() + 1) * _checkpointInterval;
+	}
+
+	void addCheckpoint(uint32 outputPos) {
+		Checkpoint checkpoint;
+		checkpoint.outputPos = outputPos;
+		checkpoint.inputPos = _wrapped->pos() - _stream.avail_in;
+		checkpoint.state = new z_stream();
+		if (inflateCopy(checkpoint.state, &_stream) != Z_OK) {
+			// Out of memory: keep going without checkpoints
+			delete checkpoint.state;
+			_checkpointInterval = 0;
+			return;
+		}
+		_checkpoints.push_back(checkpoint);
+	}
+
+	bool restoreCheckpoint(const Checkpoint &checkpoint) {
+		inflateEnd(&_stream);
+		_zlibErr = inflateCopy(&_stream, checkpoint.state);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		_pos = checkpoint.outputPos;
+		_wrapped->seek(checkpoint.inputPos, SEEK_SET);
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+		return true;
+	}
+
 public:
 
-	GZipReadStream(SeekableReadStream *w, DisposeAfterUse::Flag disposeParent, uint32 knownSize) : _wrapped(w, disposeParent), _stream() {
+	GZipReadStream(SeekableReadStream *w, DisposeAfterUse::Flag disposeParent, uint32 knownSize) : _wrapped(w, disposeParent), _stream(), _checkpointInterval(0) {
 		assert(w != nullptr);
 
 		_parentPos = w->pos();
@@ -148,7 +194,8 @@ public:
 		_stream.avail_in = 0;
 	}
 
-	GZipReadStream(SeekableReadStream *w, DisposeAfterUse::Flag disposeParent, uint32 knownSize, const byte *dict, uint dictLen) : _wrapped(w, disposeParent), _stream() {
+	GZipReadStream(SeekableReadStream *w, DisposeAfterUse::Flag disposeParent, uint32 knownSize, const byte *dict, uint dictLen, uint32 checkpointInterval = 0) :
+			_wrapped(w, disposeParent), _stream(), _checkpointInterval(checkpointInterval) {
 		assert(w != nullptr);
 
 		_parentPos = w->pos();
@@ -177,6 +224,11 @@ public:
 
 	~GZipReadStream() {
 		inflateEnd(&_stream);
+
+		for (uint i = 0; i < _checkpoints.size(); i++) {
+			inflateEnd(_checkpoints[i].state);
+			delete _checkpoints[i].state;
+		}
 	}
 
 	bool err() const override { return (_zlibErr != Z_OK) && (_zlibErr != Z_STREAM_END); }
@@ -187,25 +239,40 @@ public:
 
 	uint32 read(void *dataPtr, uint32 dataSize) override {
 		_stream.next_out = (byte *)dataPtr;
-		_stream.avail_out = dataSize;
-
-		// Keep going while we get no error
-		while (_zlibErr == Z_OK && _stream.avail_out) {
-			if (_stream.avail_in == 0 && !_wrapped->eos()) {
-				// If we are out of input data: Read more data, if available.
-				_stream.next_in = _buf;
-				_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
+		uint32 remaining = dataSize;
+
+		while (_zlibErr == Z_OK && remaining) {
+			// Stop at the next checkpoint to save the state there
+			uint32 chunkSize = remaining;
+			if (_checkpointInterval) {
+				const uint32 outputPos = _pos + dataSize - remaining;
+				if (outputPos == nextCheckpointPos())
+					addCheckpoint(outputPos);
+				if (_checkpointInterval)
+					chunkSize = MIN(chunkSize, nextCheckpointPos() - outputPos);
 			}
-			_zlibErr = inflate(&_stream, Z_NO_FLUSH);
+			_stream.avail_out = chunkSize;
+
+			// Keep going while we get no error
+			while (_zlibErr == Z_OK && _stream.avail_out) {
+				if (_stream.avail_in == 0 && !_wrapped->eos()) {
+					// If we are out of input data: Read more data, if available.
+					_stream.next_in = _buf;
+					_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
+				}
+				_zlibErr = inflate(&_stream, Z_NO_FLUSH);
+			}
+
+			remaining -= chunkSize - _stream.avail_out;
 		}
 
 		// Update the position counter
-		_pos += dataSize - _stream.avail_out;
+		_pos += dataSize - remaining;
 
-		if (_zlibErr == Z_STREAM_END && _stream.avail_out > 0)
+		if (_zlibErr == Z_STREAM_END && remaining > 0)
 			_eos = true;
 
-		return dataSize - _stream.avail_out;
+		return dataSize - remaining;
 	}
 
 	bool eos() const override {
@@ -236,7 +303,17 @@ public:
 
 		assert(newPos >= 0);
 
-		if ((uint32)newPos < _pos) {
+		// Find the last checkpoint before the new position
+		const Checkpoint *checkpoint = nullptr;
+		for (uint i = 0; i < _checkpoints.size() && _checkpoints[i].outputPos <= (uint32)newPos; i++)
+			checkpoint = &_checkpoints[i];
+
+		if (checkpoint && ((uint32)newPos < _pos || checkpoint->outputPos > _pos)) {
+			// Resume from there, rather than from the start of the file or
+			// from the current position
+			if (!restoreCheckpoint(*checkpoint))
+				return false;
+		} else if ((uint32)newPos < _pos) {
 			// To search backward, we have to restart the whole decompression
 			// from the start of the file. A rather wasteful operation, best
 			// to avoid it. :/
@@ -267,7 +344,10 @@ public:
 		// bytes, so this should be fine.
 		byte tmpBuf[1024];
 		while (!err() && offset > 0) {
-			offset -= read(tmpBuf, MIN((int64)sizeof(tmpBuf), offset));
+			const uint32 skipped = read(tmpBuf, MIN((int64)sizeof(tmpBuf), offset));
+			if (!skipped)
+				break;
+			offset -= skipped;
 		}
 
 		_eos = false;
@@ -422,6 +502,20 @@ SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, Dispo
 	return new GZipReadStream(toBeWrapped, disposeParent, knownSize, dict, dictLen);
 }
 
+SeekableReadStream *wrapSeekableDeflateReadStream(SeekableReadStream *toBeWrapped, DisposeAfterUse::Flag disposeParent, uint64 knownSize, uint32 checkpointInterval) {
+	if (!toBeWrapped) {
+		return nullptr;
+	}
+
+	if (toBeWrapped->eos() || toBeWrapped->err()) {
+		if (disposeParent == DisposeAfterUse::YES) {
+			delete toBeWrapped;
+		}
+		return nullptr;
+	}
+	return new GZipReadStream(toBeWrapped, disposeParent, knownSize, nullptr, 0, checkpointInterval);
+}
+
 WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped) {
 	if (!toBeWrapped)
 		return nullptr;
@@ -0,0 +1,102 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_CPU_KERNELS_H
+#define COMMON_CPU_KERNELS_H
+
+#include "common/scummsys.h"
+#include "common/system.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_cpu_kernels CPU kernels
+ * @ingroup common
+ *
+ * @brief Runtime selection of the SIMD versions of a set of kernels.
+ * @{
+ */
+
+/**
+ * Selects which version of a set of kernels runs on the CPU.
+ *
+ * The kernels are function pointers grouped in a table. @p Kernels is the
+ * class which groups their versions:
+ *
+ * - Kernels::Table, the type of the table;
+ * - Kernels::generic, the portable version;
+ * - Kernels::neon, Kernels::sse2 and Kernels::avx2, the SIMD versions,
+ *   which only exist when they are built (SCUMMVM_NEON and so on) and
+ *   written for that set of kernels;
+ * - Kernels::kernels, the version in use, or nullptr until it is selected.
+ *   The tests set it to run a given version.
+ *
+ * The fastest version which the CPU runs is selected on first use, based
+ * on the CPU features reported by the backend.
+ */
+template<class Kernels>
+class CpuKernels {
+public:
+	typedef typename Kernels::Table Table;
+
+	/** @return The version in use, which is selected on first use. */
+	static const Table &get() {
+		if (!Kernels::kernels)
+			Kernels::kernels = select();
+		return *Kernels::kernels;
+	}
+
+	/** @return The fastest version of the kernels which the CPU runs. */
+	static const Table *select() {
+		const Table *table = &Kernels::generic;
+		if (neon() && g_system->hasFeature(OSystem::kFeatureCpuNEON))
+			table = neon();
+		if (sse2() && g_system->hasFeature(OSystem::kFeatureCpuSSE2))
+			table = sse2();
+		if (avx2() && g_system->hasFeature(OSystem::kFeatureCpuAVX2))
+			table = avx2();
+		return table;
+	}
+
+	/** @return The NEON version, or nullptr if there is none. */
+	static const Table *neon() { return getNeon<Kernels>(0); }
+
+	/** @return The SSE2 version, or nullptr if there is none. */
+	static const Table *sse2() { return getSse2<Kernels>(0); }
+
+	/** @return The AVX2 version, or nullptr if there is none. */
+	static const Table *avx2() { return getAvx2<Kernels>(0); }
+
+private:
+	// The overloads taking an int are only viable when the version exists
+	template<class K> static auto getNeon(int) -> decltype(&K::neon) { return &K::neon; }
+	template<class K> static const Table *getNeon(...) { return nullptr; }
+	template<class K> static auto getSse2(int) -> decltype(&K::sse2) { return &K::sse2; }
+	template<class K> static const Table *getSse2(...) { return nullptr; }
+	template<class K> static auto getAvx2(int) -> decltype(&K::avx2) { return &K::avx2; }
+	template<class K> static const Table *getAvx2(...) { return nullptr; }
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -137,6 +137,11 @@ bool File::seek(int64 offs, int whence) {
 	return _handle->seek(offs, whence);
 }
 
+const byte *File::getMappedData() const {
+	assert(_handle);
+	return _handle->getMappedData();
+}
+
 uint32 File::read(void *ptr, uint32 len) {
 	assert(_handle);
 	return _handle->read(ptr, len);
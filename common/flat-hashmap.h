@@ -0,0 +1,580 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// The layout of this hash map follows the "Swiss tables" of the Abseil
+// library: the slots are probed a group at a time, using one control byte
+// per slot to skip over most of the keys which do not match.
+
+#ifndef COMMON_FLAT_HASHMAP_H
+#define COMMON_FLAT_HASHMAP_H
+
+#include "common/hashmap.h"
+#include "common/intrinsics.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FLAT_HASHMAP_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FLAT_HASHMAP_NEON
+#endif
+
+namespace Common {
+
+/**
+ * @defgroup common_flat_hashmap Flat hash table (FlatHashMap)
+ * @ingroup common
+ *
+ * @brief Open addressing alternative to HashMap.
+ *
+ * @{
+ */
+
+/**
+ * Operations on a group of control bytes of a FlatHashMap. Each operation
+ * returns a mask with bit i set if the control byte i of the group matches.
+ */
+struct FlatHashMapGroup {
+	enum {
+		kWidth = 16
+	};
+
+	enum {
+		kEmpty = -128,
+		kDeleted = -2
+	};
+
+#if defined(FLAT_HASHMAP_SSE2)
+	static uint32 match(const int8 *ctrl, int8 hash) {
+		const __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(hash)));
+	}
+
+	static uint32 matchEmpty(const int8 *ctrl) {
+		return match(ctrl, kEmpty);
+	}
+
+	static uint32 matchEmptyOrDeleted(const int8 *ctrl) {
+		// Only the free slots have their sign bit set
+		return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+	}
+#elif defined(FLAT_HASHMAP_NEON)
+	static uint32 toMask(uint8x16_t matches) {
+		static const uint8 bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+		const uint8x16_t masked = vandq_u8(matches, vld1q_u8(bits));
+
+		// Add up the bits of each half of the group
+		uint8x8_t sum = vpadd_u8(vget_low_u8(masked), vget_high_u8(masked));
+		sum = vpadd_u8(sum, sum);
+		sum = vpadd_u8(sum, sum);
+		return vget_lane_u8(sum, 0) | (vget_lane_u8(sum, 1) << 8);
+	}
+
+	static uint32 match(const int8 *ctrl, int8 hash) {
+		return toMask(vceqq_s8(vld1q_s8(ctrl), vdupq_n_s8(hash)));
+	}
+
+	static uint32 matchEmpty(const int8 *ctrl) {
+		return match(ctrl, kEmpty);
+	}
+
+	static uint32 matchEmptyOrDeleted(const int8 *ctrl) {
+		// Only the free slots have their sign bit set
+		return toMask(vcltq_s8(vld1q_s8(ctrl), vdupq_n_s8(0)));
+	}
+#else
+	static uint32 match(const int8 *ctrl, int8 hash) {
+		uint32 mask = 0;
+		for (int i = 0; i < kWidth; i++) {
+			if (ctrl[i] == hash)
+				mask |= 1 << i;
+		}
+		return mask;
+	}
+
+	static uint32 matchEmpty(const int8 *ctrl) {
+		return match(ctrl, kEmpty);
+	}
+
+	static uint32 matchEmptyOrDeleted(const int8 *ctrl) {
+		uint32 mask = 0;
+		for (int i = 0; i < kWidth; i++) {
+			if (ctrl[i] < 0)
+				mask |= 1 << i;
+		}
+		return mask;
+	}
+#endif
+
+	/** Return the index of the lowest bit set in a non-zero mask. */
+	static uint lowestBit(uint32 mask) {
+		return intLog2(mask & (0 - mask));
+	}
+};
+
+/**
+ * FlatHashMap<Key,Val> has the same interface as HashMap<Key,Val>, and takes
+ * the same hash and equality functors, e.g. IgnoreCase_Hash and
+ * IgnoreCase_EqualTo.
+ *
+ * The nodes are stored in the table itself rather than allocated one by one,
+ * and each of them has a control byte holding 7 bits of its hash. Lookups
+ * compare the control bytes of 16 slots at a time, with SSE2 or NEON when
+ * the compiler targets them, so they rarely have to compare keys which do
+ * not match.
+ *
+ * Unlike with HashMap, adding a key may move the other nodes of the map, so
+ * it invalidates the references to the values, and the iterators.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+	struct Node {
+		Val _value;
+		const Key _key;
+		explicit Node(const Key &key) : _value(), _key(key) {}
+	};
+
+private:
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> FHM_t;
+	typedef FlatHashMapGroup Group;
+
+	enum {
+		FLAT_HASHMAP_MIN_CAPACITY = Group::kWidth,
+
+		// The table is grown once this fraction of it is used, including the
+		// deleted slots.
+		FLAT_HASHMAP_LOADFACTOR_NUMERATOR = 7,
+		FLAT_HASHMAP_LOADFACTOR_DENOMINATOR = 8
+	};
+
+	/** Default value, returned by the const getVal. */
+	Val _defaultVal;
+
+	/**
+	 * Control bytes, one per slot: kEmpty, kDeleted or 7 bits of the hash of
+	 * the key. The first group is repeated after the last slot, so that a
+	 * group can be loaded at any slot.
+	 */
+	int8 *_ctrl;
+	Node *_slots;
+	size_type _mask;    ///< Capacity of the map minus one; the capacity is a power of two
+	size_type _size;
+	size_type _deleted; ///< Number of slots marked as kDeleted
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/**
+	 * Mix the bits of the hash, since many hash functors, e.g. the ones of
+	 * integer types, return the key as is.
+	 */
+	static uint32 mixHash(uint32 hash) {
+		hash *= 0x9E3779B1;
+		return hash ^ (hash >> 16);
+	}
+
+	static int8 ctrlHash(uint32 hash) {
+		return hash & 0x7F;
+	}
+
+	void setCtrl(size_type idx, int8 value) {
+		_ctrl[idx] = value;
+		if (idx < Group::kWidth)
+			_ctrl[_mask + 1 + idx] = value;
+	}
+
+	void allocate(size_type capacity) {
+		_mask = capacity - 1;
+		_ctrl = (int8 *)malloc(capacity + Group::kWidth);
+		_slots = (Node *)malloc(capacity * sizeof(Node));
+		assert(_ctrl && _slots);
+		memset(_ctrl, Group::kEmpty, capacity + Group::kWidth);
+		_size = 0;
+		_deleted = 0;
+	}
+
+	void destroy() {
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (_ctrl[ctr] >= 0)
+				_slots[ctr].~Node();
+		}
+		free(_ctrl);
+		free(_slots);
+	}
+
+	void assign(const FHM_t &map);
+	size_type lookup(const Key &key) const;
+	size_type findFreeSlot(uint32 hash) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	void resize(size_type newCapacity);
+
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != nullptr);
+			assert(_idx <= _hashmap->_mask);
+			assert(_hashmap->_ctrl[_idx] >= 0);
+			return &_hashmap->_slots[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(nullptr) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			_idx = _hashmap->nextUsed(_idx + 1);
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+	/** Return the first used slot starting at @p idx, or (size_type)-1. */
+	size_type nextUsed(size_type idx) const {
+		for (; idx <= _mask; ++idx) {
+			if (_ctrl[idx] >= 0)
+				return idx;
+		}
+		return (size_type)-1;
+	}
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap() : _defaultVal() {
+		allocate(FLAT_HASHMAP_MIN_CAPACITY);
+	}
+
+	FlatHashMap(const FHM_t &map) : _defaultVal() {
+		assign(map);
+	}
+
+	~FlatHashMap() {
+		destroy();
+	}
+
+	FHM_t &operator=(const FHM_t &map) {
+		if (this == &map)
+			return *this;
+
+		destroy();
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const {
+		return lookup(key) != (size_type)-1;
+	}
+
+	Val &operator[](const Key &key) { return getOrCreateVal(key); }
+	const Val &operator[](const Key &key) const { return getVal(key); }
+
+	Val &getOrCreateVal(const Key &key) {
+		// The slots may be reallocated by the insertion
+		const size_type ctr = lookupAndCreateIfMissing(key);
+		return _slots[ctr]._value;
+	}
+
+	Val &getVal(const Key &key) {
+		const size_type ctr = lookup(key);
+		if (ctr != (size_type)-1)
+			return _slots[ctr]._value;
+		// See the comment in HashMap::getVal()
+#ifdef RELEASE_BUILD
+		return _defaultVal;
+#else
+		unknownKeyError(key);
+#endif
+	}
+
+	const Val &getVal(const Key &key) const {
+		const size_type ctr = lookup(key);
+		if (ctr != (size_type)-1)
+			return _slots[ctr]._value;
+#ifdef RELEASE_BUILD
+		return _defaultVal;
+#else
+		unknownKeyError(key);
+#endif
+	}
+
+	const Val &getValOrDefault(const Key &key) const {
+		return getValOrDefault(key, _defaultVal);
+	}
+
+	const Val &getValOrDefault(const Key &key, const Val &defaultVal) const {
+		const size_type ctr = lookup(key);
+		return ctr != (size_type)-1 ? _slots[ctr]._value : defaultVal;
+	}
+
+	bool tryGetVal(const Key &key, Val &out) const {
+		const size_type ctr = lookup(key);
+		if (ctr == (size_type)-1)
+			return false;
+		out = _slots[ctr]._value;
+		return true;
+	}
+
+	void setVal(const Key &key, const Val &val) {
+		const size_type ctr = lookupAndCreateIfMissing(key);
+		_slots[ctr]._value = val;
+	}
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	iterator begin() { return iterator(nextUsed(0), this); }
+	iterator end() { return iterator((size_type)-1, this); }
+	const_iterator begin() const { return const_iterator(nextUsed(0), this); }
+	const_iterator end() const { return const_iterator((size_type)-1, this); }
+
+	iterator find(const Key &key) { return iterator(lookup(key), this); }
+	const_iterator find(const Key &key) const { return const_iterator(lookup(key), this); }
+
+	/** Return true if hashmap is empty. */
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+/**
+ * Internal method for assigning the content of another FlatHashMap to this
+ * one, keeping the layout of its table.
+ *
+ * @note The previous storage is *not* deallocated here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const FHM_t &map) {
+	allocate(map._mask + 1);
+	memcpy(_ctrl, map._ctrl, map._mask + 1 + Group::kWidth);
+
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (_ctrl[ctr] >= 0) {
+			new ((void *)&_slots[ctr]) Node(map._slots[ctr]._key);
+			_slots[ctr]._value = map._slots[ctr]._value;
+		}
+	}
+
+	_size = map._size;
+	_deleted = map._deleted;
+}
+
+/**
+ * Clear all values in the hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	if (shrinkArray && _mask >= FLAT_HASHMAP_MIN_CAPACITY) {
+		destroy();
+		allocate(FLAT_HASHMAP_MIN_CAPACITY);
+		return;
+	}
+
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (_ctrl[ctr] >= 0)
+			_slots[ctr].~Node();
+	}
+	memset(_ctrl, Group::kEmpty, _mask + 1 + Group::kWidth);
+
+	_size = 0;
+	_deleted = 0;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::resize(size_type newCapacity) {
+	const size_type oldMask = _mask;
+	int8 *oldCtrl = _ctrl;
+	Node *oldSlots = _slots;
+#ifndef RELEASE_BUILD
+	const size_type oldSize = _size;
+#endif
+
+	allocate(newCapacity);
+
+	// Since no key exists twice in the old table, the nodes can go to the
+	// first free slot of their probe sequence without comparing the keys.
+	for (size_type ctr = 0; ctr <= oldMask; ++ctr) {
+		if (oldCtrl[ctr] < 0)
+			continue;
+
+		const uint32 hash = mixHash(_hash(oldSlots[ctr]._key));
+		const size_type idx = findFreeSlot(hash);
+		new ((void *)&_slots[idx]) Node(oldSlots[ctr]._key);
+		_slots[idx]._value = oldSlots[ctr]._value;
+		setCtrl(idx, ctrlHash(hash));
+		_size++;
+
+		oldSlots[ctr].~Node();
+	}
+
+#ifndef RELEASE_BUILD
+	assert(_size == oldSize);
+#endif
+
+	free(oldCtrl);
+	free(oldSlots);
+}
+
+/**
+ * Return the slot of @p key, or (size_type)-1 if the map does not contain it.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+	const uint32 hash = mixHash(_hash(key));
+	const int8 h2 = ctrlHash(hash);
+	size_type pos = (hash >> 7) & _mask;
+
+	// The groups are probed in a triangular sequence, which visits all of
+	// them since their number is a power of two
+	for (size_type step = Group::kWidth; ; step += Group::kWidth) {
+		const int8 *group = _ctrl + pos;
+		for (uint32 matches = Group::match(group, h2); matches; matches &= matches - 1) {
+			const size_type ctr = (pos + Group::lowestBit(matches)) & _mask;
+			if (_equal(_slots[ctr]._key, key))
+				return ctr;
+		}
+
+		// The key would have been put in the empty slot
+		if (Group::matchEmpty(group))
+			return (size_type)-1;
+
+		pos = (pos + step) & _mask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::findFreeSlot(uint32 hash) const {
+	size_type pos = (hash >> 7) & _mask;
+	for (size_type step = Group::kWidth; ; step += Group::kWidth) {
+		const uint32 freeSlots = Group::matchEmptyOrDeleted(_ctrl + pos);
+		if (freeSlots)
+			return (pos + Group::lowestBit(freeSlots)) & _mask;
+
+		pos = (pos + step) & _mask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr != (size_type)-1)
+		return ctr;
+
+	// Keep the load factor below a certain threshold. Deleted slots are also
+	// counted, but if they make up most of it, the table keeps its size.
+	const size_type capacity = _mask + 1;
+	if ((_size + _deleted + 1) * FLAT_HASHMAP_LOADFACTOR_DENOMINATOR > capacity * FLAT_HASHMAP_LOADFACTOR_NUMERATOR) {
+		if ((_size + 1) * 2 * FLAT_HASHMAP_LOADFACTOR_DENOMINATOR <= capacity * FLAT_HASHMAP_LOADFACTOR_NUMERATOR)
+			resize(capacity);
+		else
+			resize(capacity * 2);
+	}
+
+	const uint32 hash = mixHash(_hash(key));
+	ctr = findFreeSlot(hash);
+	if (_ctrl[ctr] == Group::kDeleted)
+		_deleted--;
+
+	new ((void *)&_slots[ctr]) Node(key);
+	setCtrl(ctr, ctrlHash(hash));
+	_size++;
+
+	return ctr;
+}
+
+/**
+ * Erase an element referred to by an iterator.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	const size_type ctr = entry._idx;
+	assert(ctr <= _mask);
+	assert(_ctrl[ctr] >= 0);
+
+	_slots[ctr].~Node();
+	_size--;
+
+	// If every group which contains the slot also has an empty slot, no
+	// lookup ever probed past it, so it can become empty again instead of
+	// being marked as deleted.
+	const uint32 emptyAfter = Group::matchEmpty(_ctrl + ctr);
+	const uint32 emptyBefore = Group::matchEmpty(_ctrl + ((ctr - Group::kWidth) & _mask));
+	if (emptyAfter && emptyBefore &&
+	    Group::lowestBit(emptyAfter) + (Group::kWidth - 1 - intLog2(emptyBefore)) < Group::kWidth) {
+		setCtrl(ctr, Group::kEmpty);
+	} else {
+		setCtrl(ctr, Group::kDeleted);
+		_deleted++;
+	}
+}
+
+/**
+ * Erase an element specified by a key.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	const size_type ctr = lookup(key);
+	if (ctr != (size_type)-1)
+		erase(iterator(ctr, this));
+}
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -252,6 +252,19 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Retrieve the size and the last modification time of the file referred
+	 * by this node. This is cheaper than opening the file and is meant to
+	 * validate caches of data derived from the file contents.
+	 *
+	 * @param size             Receives the size of the file in bytes.
+	 * @param modificationTime Receives the modification time, in seconds since the epoch.
+	 *
+	 * @return True if the information is available, false otherwise
+	 *         (also when the backend does not support it).
+	 */
+	bool getFileStat(int64 &size, int64 &modificationTime) const;
+
 	/**
 	 * Create a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -271,6 +284,14 @@ public:
 	 */
 	SeekableReadStream *createReadStreamForAltStream(AltStreamType altStreamType) const override;
 
+	/**
+	 * Create a SeekableReadStream instance which maps the file referred by
+	 * this node into memory, on the backends which support it.
+	 *
+	 * @return Pointer to the stream object, nullptr if the file cannot be mapped.
+	 */
+	SeekableReadStream *createMappedReadStream() const override;
+
 	/**
 	 * Create a WriteStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -293,6 +314,13 @@ public:
 	 * @return True if the directory was created, false otherwise.
 	 */
 	bool createDirectory() const;
+
+	/**
+	 * Remove the file referred by this node, on the backends which support it.
+	 *
+	 * @return True if the file was removed, false otherwise.
+	 */
+	bool removeFile() const;
 };
 
 /**
@@ -22,6 +22,11 @@
 #include "common/memory.h"
 #include "common/util.h"
 
+#ifdef ENABLE_ALLOCATION_COUNTING
+#include "common/atomic.h"
+#include "common/textconsole.h"
+#endif
+
 namespace Common {
 
 void memset64(uint64 *dst, uint64 val, size_t count) {
@@ -71,3 +76,67 @@ void memset16(uint16 *dst, uint16 val, size_t count) {
 }
 
 } // End of namespace Common
+
+#ifdef ENABLE_ALLOCATION_COUNTING
+
+namespace {
+
+// Static storage is zeroed before any constructor runs, so new works from the start
+Common::Atomic<uint32> g_allocationCount;
+
+void *countedAlloc(size_t size) {
+	g_allocationCount.fetchAdd(1);
+	return malloc(size ? size : 1);
+}
+
+} // End of anonymous namespace
+
+namespace Common {
+
+uint32 getAllocationCount() {
+	return g_allocationCount.load();
+}
+
+} // End of namespace Common
+
+// The sized forms of delete call these ones by default
+
+void *operator new(size_t size) {
+	void *ptr = countedAlloc(size);
+	if (!ptr)
+		error("Out of memory allocating %u bytes", (uint)size);
+	return ptr;
+}
+
+void *operator new[](size_t size) {
+	void *ptr = countedAlloc(size);
+	if (!ptr)
+		error("Out of memory allocating %u bytes", (uint)size);
+	return ptr;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+	return countedAlloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+	return countedAlloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+	free(ptr);
+}
+
+#endif
@@ -96,6 +96,17 @@ void uninitialized_fill_n(Type *dst, size_t n, const Value &x) {
 		new ((void *)dst++) Type(x);
 }
 
+#ifdef ENABLE_ALLOCATION_COUNTING
+/**
+ * Returns the number of allocations made with new and new[] so far.
+ *
+ * This is only available when ScummVM is configured with
+ * --enable-allocation-counting, which replaces the global new and delete
+ * operators to count them. The event recorder benchmark reports it.
+ */
+uint32 getAllocationCount();
+#endif
+
 /** @} */
 
 } // End of namespace Common
@@ -45,6 +45,7 @@ MODULE_OBJS := \
 	unicode-bidi.o \
 	ustr.o \
 	util.o \
+	workerpool.o \
 	xpfloat.o \
 	zip-set.o \
 	std/std.o
@@ -54,6 +55,11 @@ MODULE_OBJS += \
 	recorderfile.o
 endif
 
+ifdef ENABLE_PROFILER
+MODULE_OBJS += \
+	profiler.o
+endif
+
 ifdef USE_UPDATES
 MODULE_OBJS += \
 	updates.o
@@ -1061,26 +1061,67 @@ uint Path::hashIgnoreCase() const {
 	return hashit_lower(_str);
 }
 
+// A component is its own identifier unless it is escaped or punycoded:
+// unescaped components cannot contain any '/'
+static inline bool isPlainComponent(const char *begin, const char *end, bool escaped) {
+	return !escaped && !(end - begin >= 4 && !strncmp(begin, "xn--", 4));
+}
+
+uint Path::hashComponentIgnoreCaseAndMac(const char *begin, const char *end, bool escaped) {
+	if (!isPlainComponent(begin, end, escaped)) {
+		String item = escaped ? unescape(kNoSeparator, begin, end) : String(begin, end);
+		return hashit_lower(getIdentifierComponent(item));
+	}
+
+	// Same as hashit_lower, on a component which isn't null terminated
+	uint hash = (begin != end ? tolower(*begin) : 0) << 7;
+	for (const char *p = begin; p != end; p++)
+		hash = (1000003 * hash) ^ tolower((byte)*p);
+	return hash ^ (uint)(end - begin);
+}
+
+bool Path::equalsComponentIgnoreCaseAndMac(const char *begin, const char *end, bool escaped,
+                                           const char *beginOther, const char *endOther, bool escapedOther) {
+	if (isPlainComponent(begin, end, escaped) && isPlainComponent(beginOther, endOther, escapedOther)) {
+		return (end - begin) == (endOther - beginOther) &&
+		       !scumm_strnicmp(begin, beginOther, end - begin);
+	}
+
+	String item = escaped ? unescape(kNoSeparator, begin, end) : String(begin, end);
+	String itemOther = escapedOther ? unescape(kNoSeparator, beginOther, endOther) : String(beginOther, endOther);
+	return getIdentifierComponent(item).equalsIgnoreCase(getIdentifierComponent(itemOther));
+}
+
 // This hash algorithm is inspired by a Python proposal to hash for tuples
 // https://bugs.python.org/issue942952#msg20602
 // As we don't have the length, it's not added in but
 // it doesn't change collisions that much on their stress test
-struct hasher {
-	uint result;
-	uint mult;
-};
-
 uint Path::hashIgnoreCaseAndMac() const {
-	hasher v = { 0x345678, 1000003 };
-	reduceComponents<hasher &>(
-		[](hasher &value, const String &in, bool last) -> hasher & {
-			uint hash = hashit_lower(getIdentifierComponent(in));
-
-			value.result = (value.result + hash) * value.mult;
-			value.mult = (value.mult * 69069);
-			return value;
-		}, v);
-	return v.result;
+	uint result = 0x345678;
+	uint mult = 1000003;
+	if (_str.empty()) {
+		return result;
+	}
+
+	const char *str = _str.c_str();
+	const char *end = str + _str.size();
+	bool escaped = isEscaped();
+	if (escaped) {
+		str++;
+	}
+
+	while (true) {
+		const char *sep = strchr(str, SEPARATOR);
+		const char *componentEnd = sep ? sep : end;
+
+		result = (result + hashComponentIgnoreCaseAndMac(str, componentEnd, escaped)) * mult;
+		mult = (mult * 69069);
+
+		if (!sep) {
+			return result;
+		}
+		str = sep + 1;
+	}
 }
 
 bool Path::matchPattern(const Path &pattern) const {
@@ -1095,10 +1136,45 @@ bool Path::equalsIgnoreCase(const Path &other) const {
 }
 
 bool Path::equalsIgnoreCaseAndMac(const Path &other) const {
-	return compareComponents(
-		[](const String &x, const String &y) {
-			return getIdentifierComponent(x).equalsIgnoreCase(getIdentifierComponent(y));
-		}, other);
+	if (_str.empty() != other._str.empty()) {
+		// One is empty and the other is not
+		return false;
+	}
+	if (_str.empty()) {
+		// Both are empty
+		return true;
+	}
+
+	const char *str = _str.c_str();
+	const char *end = str + _str.size();
+	bool escaped = isEscaped();
+	if (escaped) {
+		str++;
+	}
+
+	const char *strOther = other._str.c_str();
+	const char *endOther = strOther + other._str.size();
+	bool escapedOther = other.isEscaped();
+	if (escapedOther) {
+		strOther++;
+	}
+
+	while (true) {
+		const char *sep = strchr(str, SEPARATOR);
+		const char *sepOther = strchr(strOther, SEPARATOR);
+
+		if (!equalsComponentIgnoreCaseAndMac(str, sep ? sep : end, escaped,
+		                                     strOther, sepOther ? sepOther : endOther, escapedOther)) {
+			return false;
+		}
+		if (!sep || !sepOther) {
+			// Both must end at the same time
+			return sep == sepOther;
+		}
+
+		str = sep + 1;
+		strOther = sepOther + 1;
+	}
 }
 
 bool Path::operator<(const Path &x) const {
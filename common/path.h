@@ -164,6 +164,16 @@ private:
 	 */
 	bool compareComponents(bool (*comparator)(const String &x, const String &y), const Path &other) const;
 
+	/**
+	 * Hashes and compares the path component between @p begin and @p end
+	 * like hashIgnoreCaseAndMac() and equalsIgnoreCaseAndMac() do.
+	 * Components which need neither unescaping nor punycode decoding
+	 * are used in place, without building a String.
+	 */
+	static uint hashComponentIgnoreCaseAndMac(const char *begin, const char *end, bool escaped);
+	static bool equalsComponentIgnoreCaseAndMac(const char *begin, const char *end, bool escaped,
+	                                            const char *beginOther, const char *endOther, bool escapedOther);
+
 	/**
 	 * Determines if the path is escaped
 	 */
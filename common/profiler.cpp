@@ -0,0 +1,178 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/profiler.h"
+#include "common/array.h"
+#include "common/debug.h"
+#include "common/file.h"
+#include "common/mutex.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+namespace Common {
+
+namespace {
+
+struct ProfilerEvent {
+	enum Type {
+		kZone,
+		kCounter,
+		kFrame
+	};
+
+	Type type;
+	const char *name;
+	uint32 thread;
+	/** Microseconds since the start of the capture */
+	uint64 time;
+	/** Duration of a zone, or value of a counter */
+	int64 value;
+};
+
+enum {
+	/** Bound the memory used by a capture to a few dozen megabytes */
+	kMaxProfilerEvents = 1 << 20
+};
+
+// Allocated on the first capture, as mutexes need the backend
+Mutex *g_profilerMutex = nullptr;
+Array<ProfilerEvent> *g_profilerEvents = nullptr;
+uint64 g_profilerStartTime = 0;
+uint32 g_profilerDropped = 0;
+
+void addEvent(ProfilerEvent::Type type, const char *name, uint64 time, int64 value) {
+	StackLock lock(*g_profilerMutex);
+
+	// Skip the events which race with start() or stop()
+	if (!Profiler::isActive() || time < g_profilerStartTime)
+		return;
+
+	if (g_profilerEvents->size() >= kMaxProfilerEvents) {
+		g_profilerDropped++;
+		return;
+	}
+
+	ProfilerEvent event;
+	event.type = type;
+	event.name = name;
+	event.thread = g_system->getCurrentThreadId();
+	event.time = time - g_profilerStartTime;
+	event.value = value;
+	g_profilerEvents->push_back(event);
+}
+
+} // End of anonymous namespace
+
+volatile bool Profiler::_active = false;
+
+void Profiler::start() {
+	if (!g_profilerMutex) {
+		g_profilerMutex = new Mutex();
+		g_profilerEvents = new Array<ProfilerEvent>();
+	}
+
+	StackLock lock(*g_profilerMutex);
+	g_profilerEvents->clear();
+	g_profilerDropped = 0;
+	g_profilerStartTime = now();
+	_active = true;
+}
+
+bool Profiler::stop(const Path &fileName) {
+	DumpFile file;
+	if (!file.open(fileName, true)) {
+		_active = false;
+		warning("Profiler: Could not open '%s' for writing", fileName.toString(Path::kNativeSeparator).c_str());
+		return false;
+	}
+
+	stop(file);
+	file.flush();
+	if (file.err()) {
+		warning("Profiler: Could not write '%s'", fileName.toString(Path::kNativeSeparator).c_str());
+		return false;
+	}
+
+	debug(1, "Profiler: Wrote the trace to '%s'", fileName.toString(Path::kNativeSeparator).c_str());
+	return true;
+}
+
+void Profiler::stop(WriteStream &stream) {
+	_active = false;
+
+	stream.writeString("{\"traceEvents\":[\n");
+
+	if (g_profilerMutex) {
+		StackLock lock(*g_profilerMutex);
+
+		for (uint i = 0; i < g_profilerEvents->size(); i++) {
+			const ProfilerEvent &event = (*g_profilerEvents)[i];
+			String line;
+
+			switch (event.type) {
+			case ProfilerEvent::kZone:
+				line = String::format("{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%lld,\"pid\":1,\"tid\":%u}",
+				                      event.name, (unsigned long long)event.time, (long long)event.value, event.thread);
+				break;
+			case ProfilerEvent::kCounter:
+				line = String::format("{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%llu,\"pid\":1,\"args\":{\"value\":%lld}}",
+				                      event.name, (unsigned long long)event.time, (long long)event.value);
+				break;
+			case ProfilerEvent::kFrame:
+				line = String::format("{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%llu,\"pid\":1,\"tid\":%u}",
+				                      (unsigned long long)event.time, event.thread);
+				break;
+			default:
+				break;
+			}
+
+			if (i + 1 < g_profilerEvents->size())
+				line += ",\n";
+			stream.writeString(line);
+		}
+
+		if (g_profilerDropped)
+			warning("Profiler: Dropped %u events over the limit of %d", g_profilerDropped, kMaxProfilerEvents);
+
+		g_profilerEvents->clear();
+	}
+
+	stream.writeString("\n],\"displayTimeUnit\":\"ms\"}\n");
+}
+
+uint64 Profiler::now() {
+	return g_system->getMicros();
+}
+
+void Profiler::zone(const char *name, uint64 start) {
+	const uint64 end = now();
+	addEvent(ProfilerEvent::kZone, name, start, (int64)(end - start));
+}
+
+void Profiler::counter(const char *name, int64 value) {
+	addEvent(ProfilerEvent::kCounter, name, now(), value);
+}
+
+void Profiler::frame() {
+	addEvent(ProfilerEvent::kFrame, "Frame", now(), 0);
+}
+
+} // End of namespace Common
@@ -0,0 +1,132 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_PROFILER_H
+#define COMMON_PROFILER_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_profiler Profiler
+ * @ingroup common
+ *
+ * @brief Instrumentation of the hot paths, exported as a Chrome trace.
+ * @{
+ */
+
+/**
+ * @def PROFILE_ZONE(name)
+ * Measure the time spent from this statement to the end of the enclosing
+ * scope. @p name must be a string literal, or live at least until the
+ * capture is written.
+ *
+ * @def PROFILE_COUNTER(name, value)
+ * Record the current value of a counter, shown as a graph over time.
+ *
+ * @def PROFILE_FRAME()
+ * Mark the end of a frame.
+ *
+ * The macros compile to nothing unless ScummVM is configured with
+ * --enable-profiler. Even then, they cost a single test of a flag until
+ * a capture is started.
+ */
+#ifdef ENABLE_PROFILER
+
+class WriteStream;
+class Path;
+
+/**
+ * Collects the events of the PROFILE_* macros, from any thread, between
+ * start() and stop(), and writes them in the Chrome trace event format.
+ * The file can be opened with chrome://tracing, Perfetto or Speedscope.
+ */
+class Profiler {
+public:
+	/** Start recording events, and discard the ones of the previous capture. */
+	static void start();
+
+	/**
+	 * Stop recording events and write them to @p fileName.
+	 *
+	 * @return False if the file could not be written.
+	 */
+	static bool stop(const Path &fileName);
+
+	/** Stop recording events and write them to @p stream. */
+	static void stop(WriteStream &stream);
+
+	/** Return true between start() and stop(). */
+	static bool isActive() { return _active; }
+
+	/** Return the current time in microseconds, for ProfilerZone. */
+	static uint64 now();
+
+	static void zone(const char *name, uint64 start);
+	static void counter(const char *name, int64 value);
+	static void frame();
+
+private:
+	/** Read without a lock: a zone which races with start() or stop() is merely dropped. */
+	static volatile bool _active;
+};
+
+/** Helper for PROFILE_ZONE, which records a zone when it goes out of scope. */
+class ProfilerZone : NonCopyable {
+public:
+	explicit ProfilerZone(const char *name) : _name(name), _recording(Profiler::isActive()), _start(0) {
+		if (_recording)
+			_start = Profiler::now();
+	}
+
+	~ProfilerZone() {
+		if (_recording)
+			Profiler::zone(_name, _start);
+	}
+
+private:
+	const char *_name;
+	bool _recording;
+	uint64 _start;
+};
+
+#define PROFILE_CONCAT_INTERN(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INTERN(a, b)
+
+#define PROFILE_ZONE(name) Common::ProfilerZone PROFILE_CONCAT(profilerZone, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) do { if (Common::Profiler::isActive()) Common::Profiler::counter(name, value); } while (0)
+#define PROFILE_FRAME() do { if (Common::Profiler::isActive()) Common::Profiler::frame(); } while (0)
+
+#else
+
+#define PROFILE_ZONE(name) do {} while (0)
+#define PROFILE_COUNTER(name, value) do { if (false) (void)(value); } while (0)
+#define PROFILE_FRAME() do {} while (0)
+
+#endif
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
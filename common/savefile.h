@@ -276,6 +276,20 @@ public:
 	 * @return true if the file exists. false otherwise.
 	 */
 	virtual bool exists(const String &name) = 0;
+
+	/**
+	 * Query the size and modification time of a save file, e.g. to tell
+	 * whether data extracted from it is still up to date.
+	 *
+	 * The default implementation provides no information.
+	 *
+	 * @param name              Name of the save file.
+	 * @param size              Size of the file in bytes.
+	 * @param modificationTime  Modification time of the file, in seconds.
+	 *
+	 * @return true if the information is available, false otherwise.
+	 */
+	virtual bool getSavefileStat(const String &name, int64 &size, int64 &modificationTime) { return false; }
 };
 
 /** @} */
@@ -0,0 +1,155 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_SPSC_QUEUE_H
+#define COMMON_SPSC_QUEUE_H
+
+#include "common/scummsys.h"
+#include "common/atomic.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_spsc_queue Lock-free queue
+ * @ingroup common
+ *
+ * @brief Fixed size queue for passing items between two threads.
+ * @{
+ */
+
+/**
+ * Fixed size ring buffer that one producer thread and one consumer thread
+ * can use at the same time without locking.
+ *
+ * If several threads need to push (or pop), they have to serialize those
+ * calls among themselves, e.g. with a Common::Mutex. That mutex is never
+ * shared with the other side, so the producer never waits on the consumer
+ * and vice versa.
+ *
+ * @tparam T     Item type. It is copied in and out of the queue.
+ * @tparam size  Capacity of the queue. Must be a power of two.
+ */
+template<class T, uint size>
+class SPSCQueue : NonCopyable {
+	STATIC_ASSERT(size > 0 && (size & (size - 1)) == 0, spsc_queue_size_must_be_a_power_of_two);
+
+public:
+	/**
+	 * Add an item at the end of the queue. Only call from the producer.
+	 *
+	 * @return False if the queue is full, in which case nothing is added.
+	 */
+	bool push(const T &item) {
+		const uint32 head = _head.load();
+		if (head - _tail.load() == size)
+			return false;
+
+		_items[head & (size - 1)] = item;
+		_head.store(head + 1);
+		return true;
+	}
+
+	/**
+	 * Remove the item at the front of the queue. Only call from the consumer.
+	 *
+	 * @return False if the queue is empty, in which case @p item is unchanged.
+	 */
+	bool pop(T &item) {
+		const uint32 tail = _tail.load();
+		if (tail == _head.load())
+			return false;
+
+		item = _items[tail & (size - 1)];
+		_tail.store(tail + 1);
+		return true;
+	}
+
+	/**
+	 * Add up to @p count items at the end of the queue. Only call from the producer.
+	 *
+	 * @return The number of items added, less than @p count if the queue got full.
+	 */
+	uint32 push(const T *items, uint32 count) {
+		const uint32 head = _head.load();
+		const uint32 space = size - (head - _tail.load());
+		if (count > space)
+			count = space;
+
+		for (uint32 i = 0; i < count; i++)
+			_items[(head + i) & (size - 1)] = items[i];
+		_head.store(head + count);
+		return count;
+	}
+
+	/**
+	 * Remove up to @p count items from the front of the queue. Only call from the consumer.
+	 *
+	 * @return The number of items removed, less than @p count if the queue got empty.
+	 */
+	uint32 pop(T *items, uint32 count) {
+		const uint32 tail = _tail.load();
+		const uint32 available = _head.load() - tail;
+		if (count > available)
+			count = available;
+
+		for (uint32 i = 0; i < count; i++)
+			items[i] = _items[(tail + i) & (size - 1)];
+		_tail.store(tail + count);
+		return count;
+	}
+
+	/**
+	 * Remove all the items. Only call from the consumer, and only while the
+	 * producer does not push, or the items it pushes meanwhile may be kept.
+	 */
+	void clear() {
+		_tail.store(_head.load());
+	}
+
+	/** Return true if the queue is empty. The result may be outdated by the time it is used. */
+	bool empty() const {
+		return _head.load() == _tail.load();
+	}
+
+	/** Return the number of queued items. The result may be outdated by the time it is used. */
+	uint32 count() const {
+		return _head.load() - _tail.load();
+	}
+
+	/** Return the number of items which can still be pushed. The result may be outdated by the time it is used. */
+	uint32 space() const {
+		return size - count();
+	}
+
+private:
+	T _items[size];
+
+	/** Count of items pushed so far, only written by the producer */
+	Atomic<uint32> _head;
+	/** Count of items popped so far, only written by the consumer */
+	Atomic<uint32> _tail;
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -20,47 +20,36 @@
  */
 
 #include "common/str-base.h"
+#include "common/atomic.h"
 #include "common/hash-str.h"
 #include "common/list.h"
-#include "common/memorypool.h"
 #include "common/textconsole.h"
 #include "common/util.h"
-#include "common/mutex.h"
 
 namespace Common {
 
 #define TEMPLATE template<class T>
 #define BASESTRING BaseString<T>
 
-MemoryPool *g_refCountPool = nullptr; // FIXME: This is never freed right now
-#ifndef SCUMMVM_UTIL
-Mutex *g_refCountPoolMutex = nullptr;
-
-void lockMemoryPoolMutex() {
-	// The Mutex class can only be used once g_system is set and initialized,
-	// but we may use the String class earlier than that (it is for example
-	// used in the OSystem_POSIX constructor). However in those early stages
-	// we can hope we don't have multiple threads either.
-	if (!g_system || !g_system->backendInitialized())
-		return;
-	if (!g_refCountPoolMutex)
-		g_refCountPoolMutex = new Mutex();
-	g_refCountPoolMutex->lock();
-}
+// The reference count of a string stored on the heap lives in front of its
+// characters, in the same allocation. Sharing a string thus never allocates,
+// and the count can be updated atomically without taking any lock.
+static const uint32 kRefCountSize = 8;
 
-void unlockMemoryPoolMutex() {
-	if (g_refCountPoolMutex)
-		g_refCountPoolMutex->unlock();
-}
+STATIC_ASSERT(sizeof(Atomic<int>) <= kRefCountSize, string_refcount_must_fit_its_header);
 
-TEMPLATE void BASESTRING::releaseMemoryPoolMutex() {
-	if (g_refCountPoolMutex){
-		delete g_refCountPoolMutex;
-		g_refCountPoolMutex = nullptr;
-	}
+TEMPLATE
+typename BASESTRING::value_type *BASESTRING::allocStorage(uint32 capacity) {
+	byte *block = new byte[kRefCountSize + capacity * sizeof(value_type)];
+	assert(block);
+	new (block) Atomic<int>(1);
+	return (value_type *)(block + kRefCountSize);
 }
 
-#endif
+TEMPLATE
+Atomic<int> *BASESTRING::storageRefCount(value_type *storage) {
+	return (Atomic<int> *)((byte *)storage - kRefCountSize);
+}
 
 static uint32 computeCapacity(uint32 len) {
 	// By default, for the capacity we use the next multiple of 32
@@ -127,13 +116,13 @@ TEMPLATE void BASESTRING::ensureCapacity(uint32 new_size, bool keep_old) {
 	bool isShared;
 	uint32 curCapacity, newCapacity;
 	value_type *newStorage;
-	int *oldRefCount = _extern._refCount;
+	Atomic<int> *oldRefCount = _extern._refCount;
 
 	if (isStorageIntern()) {
 		isShared = false;
 		curCapacity = _builtinCapacity;
 	} else {
-		isShared = (oldRefCount && *oldRefCount > 1);
+		isShared = (oldRefCount->load() > 1);
 		curCapacity = _extern._capacity;
 	}
 
@@ -157,8 +146,7 @@ TEMPLATE void BASESTRING::ensureCapacity(uint32 new_size, bool keep_old) {
 			newCapacity = MAX(curCapacity * 2, computeCapacity(new_size + 1));
 
 		// Allocate new storage
-		newStorage = new value_type[newCapacity];
-		assert(newStorage);
+		newStorage = allocStorage(newCapacity);
 	}
 
 	// Copy old data if needed, elsewise reset the new storage.
@@ -180,7 +168,7 @@ TEMPLATE void BASESTRING::ensureCapacity(uint32 new_size, bool keep_old) {
 		// Set the ref count & capacity if we use an external storage.
 		// It is important to do this *after* copying any old content,
 		// else we would override data that has not yet been copied!
-		_extern._refCount = nullptr;
+		_extern._refCount = storageRefCount(newStorage);
 		_extern._capacity = newCapacity;
 	}
 }
@@ -188,52 +176,19 @@ TEMPLATE void BASESTRING::ensureCapacity(uint32 new_size, bool keep_old) {
 TEMPLATE
 void BASESTRING::incRefCount() const {
 	assert(!isStorageIntern());
-	if (_extern._refCount == nullptr) {
-#ifndef SCUMMVM_UTIL
-		lockMemoryPoolMutex();
-#endif
-		if (g_refCountPool == nullptr) {
-			g_refCountPool = new MemoryPool(sizeof(int));
-			assert(g_refCountPool);
-		}
-
-		_extern._refCount = (int *)g_refCountPool->allocChunk();
-#ifndef SCUMMVM_UTIL
-		unlockMemoryPoolMutex();
-#endif
-		*_extern._refCount = 2;
-	} else {
-		++(*_extern._refCount);
-	}
+	_extern._refCount->fetchAdd(1);
 }
 
 TEMPLATE
-void BASESTRING::decRefCount(int *oldRefCount) {
+void BASESTRING::decRefCount(Atomic<int> *oldRefCount) {
 	if (isStorageIntern())
 		return;
 
-	if (oldRefCount) {
-		--(*oldRefCount);
-	}
-	if (!oldRefCount || *oldRefCount <= 0) {
+	if (oldRefCount->fetchSub(1) == 1) {
 		// The ref count reached zero, so we free the string storage
-		// and the ref count storage.
-		if (oldRefCount) {
-#ifndef SCUMMVM_UTIL
-			lockMemoryPoolMutex();
-#endif
-			assert(g_refCountPool);
-			g_refCountPool->freeChunk(oldRefCount);
-#ifndef SCUMMVM_UTIL
-			unlockMemoryPoolMutex();
-#endif
-		}
-		// Coverity thinks that we always free memory, as it assumes
-		// (correctly) that there are cases when oldRefCount == 0
-		// Thus, DO NOT COMPILE, trick it and shut tons of false positives
-#ifndef __COVERITY__
-		delete[] _str;
-#endif
+		// together with the ref count.
+		oldRefCount->~Atomic<int>();
+		delete[] (byte *)oldRefCount;
 
 		// Even though _str points to a freed memory block now,
 		// we do not change its value, because any code that calls
@@ -251,9 +206,8 @@ TEMPLATE void BASESTRING::initWithValueTypeStr(const value_type *str, uint32 len
 	if (len >= _builtinCapacity) {
 		// Not enough internal storage, so allocate more
 		_extern._capacity = computeCapacity(len + 1);
-		_extern._refCount = nullptr;
-		_str = new value_type[_extern._capacity];
-		assert(_str != nullptr);
+		_str = allocStorage(_extern._capacity);
+		_extern._refCount = storageRefCount(_str);
 	}
 
 	// Copy the string into the storage area
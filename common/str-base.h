@@ -28,11 +28,12 @@
 #include <stdarg.h>
 
 namespace Common {
+template<typename T>
+class Atomic;
+
 template<class T>
 class BaseString {
 public:
-	static void releaseMemoryPoolMutex();
-
 	static const uint32 npos = 0xFFFFFFFF;
 	typedef T          value_type;
 	typedef T *        iterator;
@@ -67,10 +68,11 @@ protected:
 		value_type _storage[_builtinCapacity];
 		/**
 		 * External string storage data -- the refcounter, and the
-		 * capacity of the string _str points to.
+		 * capacity of the string _str points to. The refcounter is
+		 * stored in the same allocation, in front of the string.
 		 */
 		struct {
-			mutable int *_refCount;
+			Atomic<int> *_refCount;
 			uint32       _capacity;
 		} _extern;
 	};
@@ -341,7 +343,9 @@ protected:
 
 	void ensureCapacity(uint32 new_size, bool keep_old);
 	void incRefCount() const;
-	void decRefCount(int *oldRefCount);
+	void decRefCount(Atomic<int> *oldRefCount);
+	static value_type *allocStorage(uint32 capacity);
+	static Atomic<int> *storageRefCount(value_type *storage);
 	void initWithValueTypeStr(const value_type *str, uint32 len);
 
 	void assignInsert(const value_type *str, uint32 p);
@@ -792,6 +792,18 @@ public:
 	 */
 	virtual bool skip(uint32 offset) { return seek(offset, SEEK_CUR); }
 
+	/**
+	 * Obtain the whole contents of the stream without copying them, if they
+	 * are already in memory, e.g. for a memory stream or a memory mapped file.
+	 *
+	 * The returned buffer holds size() bytes, and is only valid as long as the
+	 * stream exists. It does not depend on the stream position, and reading
+	 * from it does not move the position.
+	 *
+	 * @return Pointer to the contents, or nullptr if they have to be read with read().
+	 */
+	virtual const byte *getMappedData() const { return nullptr; }
+
 	/**
 	 * Read at most one less than the number of characters specified
 	 * by @p bufSize from the stream and store them in the string buffer.
@@ -982,6 +994,7 @@ public:
 	int64 pos() const override { return _parentStream->pos(); }
 	int64 size() const override { return _parentStream->size(); }
 	bool seek(int64 offset, int whence = SEEK_SET) override { return _parentStream->seek(offset, whence); }
+	const byte *getMappedData() const override { return _parentStream->getMappedData(); }
 };
 
 /** @} */
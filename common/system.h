@@ -55,6 +55,8 @@ class Store;
 namespace Common {
 class EventManager;
 class MutexInternal;
+class SemaphoreInternal;
+class ThreadInternal;
 struct Rect;
 class SaveFileManager;
 class SearchSet;
@@ -1531,6 +1533,15 @@ public:
 	 */
 	virtual uint32 getMillis(bool skipRecord = false) = 0;
 
+	/**
+	 * Get the number of microseconds since an arbitrary point in time,
+	 * for measuring durations, e.g. by the profiler.
+	 *
+	 * Unlike getMillis(), this is never recorded by the event recorder.
+	 * The default implementation only has the precision of getMillis().
+	 */
+	virtual uint64 getMicros() { return (uint64)getMillis(true) * 1000; }
+
 	/** Delay/sleep for the specified amount of milliseconds. */
 	virtual void delayMillis(uint msecs) = 0;
 
@@ -1616,6 +1627,41 @@ public:
 	 */
 	virtual Common::MutexInternal *createMutex() = 0;
 
+	/**
+	 * Create a new thread running the given procedure.
+	 *
+	 * Threads are optional: they are only used to spread work which can
+	 * also be done synchronously (see Common::WorkerPool) over several
+	 * cores. Backends which do not support them return nullptr, which is
+	 * the default implementation. A backend returning threads must also
+	 * implement createSemaphore() and provide real mutexes.
+	 *
+	 * @param proc  Procedure to run in the new thread.
+	 * @param data  Parameter passed to the procedure.
+	 *
+	 * @return The newly created thread, or nullptr if threads are not supported.
+	 */
+	virtual Common::ThreadInternal *createThread(void (*proc)(void *data), void *data) { return nullptr; }
+
+	/**
+	 * Create a new counting semaphore, with an initial count of zero.
+	 *
+	 * @return The newly created semaphore, or nullptr if threads are not supported.
+	 */
+	virtual Common::SemaphoreInternal *createSemaphore() { return nullptr; }
+
+	/**
+	 * Return the number of logical CPU cores available to worker threads.
+	 * Backends which do not support threads return 1.
+	 */
+	virtual uint getCPUCount() { return 1; }
+
+	/**
+	 * Return an identifier of the calling thread, which is unique among
+	 * the running threads. Backends which do not support threads return 0.
+	 */
+	virtual uint32 getCurrentThreadId() { return 0; }
+
 	/** @} */
 
 
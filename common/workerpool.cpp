@@ -0,0 +1,183 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/workerpool.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+#include "common/thread.h"
+
+namespace Common {
+
+WorkerPool::WorkerPool(uint numThreads) : _jobSemaphore(nullptr), _doneSemaphore(nullptr), _pending(0), _waiting(false), _quit(false) {
+	assert(g_system);
+
+	if (numThreads == 0)
+		numThreads = getDefaultThreadCount();
+	if (numThreads <= 1)
+		return;
+
+	_jobSemaphore = g_system->createSemaphore();
+	_doneSemaphore = g_system->createSemaphore();
+	if (!_jobSemaphore || !_doneSemaphore) {
+		delete _jobSemaphore;
+		delete _doneSemaphore;
+		_jobSemaphore = _doneSemaphore = nullptr;
+		return;
+	}
+
+	for (uint i = 0; i < numThreads; i++) {
+		ThreadInternal *thread = g_system->createThread(workerProc, this);
+		if (!thread)
+			break;
+		_threads.push_back(thread);
+	}
+
+	if (_threads.empty()) {
+		delete _jobSemaphore;
+		delete _doneSemaphore;
+		_jobSemaphore = _doneSemaphore = nullptr;
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	stopThreads();
+
+	delete _jobSemaphore;
+	delete _doneSemaphore;
+}
+
+uint WorkerPool::getDefaultThreadCount() {
+	return g_system->getCPUCount();
+}
+
+void WorkerPool::stopThreads() {
+	if (_threads.empty())
+		return;
+
+	{
+		StackLock lock(_mutex);
+		_quit = true;
+	}
+
+	for (uint i = 0; i < _threads.size(); i++)
+		_jobSemaphore->post();
+
+	for (uint i = 0; i < _threads.size(); i++) {
+		_threads[i]->join();
+		delete _threads[i];
+	}
+	_threads.clear();
+
+	// Threads exit as soon as the queue is empty, but a job could have
+	// been queued between the last check of a thread and its exit.
+	while (!_jobs.empty()) {
+		WorkerJob *job = _jobs.pop();
+		job->run();
+		delete job;
+	}
+}
+
+void WorkerPool::submit(WorkerJob *job) {
+	assert(job);
+
+	if (_threads.empty()) {
+		job->run();
+		delete job;
+		return;
+	}
+
+	{
+		StackLock lock(_mutex);
+		_jobs.push(job);
+		_pending++;
+	}
+	_jobSemaphore->post();
+}
+
+void WorkerPool::wait() {
+	if (_threads.empty())
+		return;
+
+	{
+		StackLock lock(_mutex);
+		if (_pending == 0)
+			return;
+		_waiting = true;
+	}
+	_doneSemaphore->wait();
+}
+
+uint WorkerPool::cancel() {
+	StackLock lock(_mutex);
+
+	uint count = 0;
+	while (!_jobs.empty()) {
+		delete _jobs.pop();
+		count++;
+	}
+
+	_pending -= count;
+	if (_pending == 0 && _waiting) {
+		_waiting = false;
+		_doneSemaphore->post();
+	}
+
+	return count;
+}
+
+uint WorkerPool::getPendingJobs() const {
+	StackLock lock(_mutex);
+	return _pending;
+}
+
+void WorkerPool::workerProc(void *data) {
+	((WorkerPool *)data)->workerLoop();
+}
+
+void WorkerPool::workerLoop() {
+	for (;;) {
+		_jobSemaphore->wait();
+
+		WorkerJob *job = nullptr;
+		{
+			StackLock lock(_mutex);
+			if (_jobs.empty()) {
+				// Either the job was cancelled, or we were asked to quit
+				if (_quit)
+					return;
+				continue;
+			}
+			job = _jobs.pop();
+		}
+
+		job->run();
+		delete job;
+
+		StackLock lock(_mutex);
+		_pending--;
+		if (_pending == 0 && _waiting) {
+			_waiting = false;
+			_doneSemaphore->post();
+		}
+	}
+}
+
+} // End of namespace Common
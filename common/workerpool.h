@@ -0,0 +1,125 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_WORKERPOOL_H
+#define COMMON_WORKERPOOL_H
+
+#include "common/array.h"
+#include "common/mutex.h"
+#include "common/noncopyable.h"
+#include "common/queue.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_workerpool Worker pool
+ * @ingroup common
+ *
+ * @brief Pool of worker threads to run independent jobs in parallel.
+ * @{
+ */
+
+class SemaphoreInternal;
+class ThreadInternal;
+
+/**
+ * A unit of work run by a WorkerPool.
+ */
+class WorkerJob {
+public:
+	virtual ~WorkerJob() {}
+
+	/**
+	 * Do the work. This may be called on a worker thread, so it must only
+	 * touch data owned by the job or protected by a mutex.
+	 */
+	virtual void run() = 0;
+};
+
+/**
+ * Pool of worker threads processing a queue of jobs.
+ *
+ * Threads are optional in ScummVM. When the backend does not support them
+ * (or the pool is created with a single thread), no worker is started and
+ * jobs are run synchronously by submit(), so that code using the pool works
+ * the same way everywhere.
+ *
+ * Jobs may be submitted from any thread, including from running jobs, but
+ * only one thread at a time may wait() for them or cancel() them.
+ */
+class WorkerPool : NonCopyable {
+public:
+	/**
+	 * Create the pool.
+	 *
+	 * @param numThreads  Number of worker threads. 0 uses one thread per CPU
+	 *                    core. 1 runs the jobs synchronously.
+	 */
+	explicit WorkerPool(uint numThreads = 0);
+
+	/** Run the jobs which are still queued, then stop the worker threads. */
+	~WorkerPool();
+
+	/**
+	 * Queue a job. The pool takes ownership of it and deletes it once it
+	 * has been run.
+	 */
+	void submit(WorkerJob *job);
+
+	/** Wait until all the submitted jobs have been run. */
+	void wait();
+
+	/**
+	 * Remove the jobs which have not been started yet from the queue.
+	 *
+	 * @return The number of jobs which were removed.
+	 */
+	uint cancel();
+
+	/** Return the number of jobs which are queued or running. */
+	uint getPendingJobs() const;
+
+	/** Return the number of worker threads, 0 when jobs are run synchronously. */
+	uint getThreadCount() const { return _threads.size(); }
+
+	/** Return the number of worker threads used by default, based on the number of CPU cores. */
+	static uint getDefaultThreadCount();
+
+private:
+	static void workerProc(void *data);
+	void workerLoop();
+	void stopThreads();
+
+	Mutex _mutex;
+	Queue<WorkerJob *> _jobs;
+	Array<ThreadInternal *> _threads;
+	SemaphoreInternal *_jobSemaphore;
+	SemaphoreInternal *_doneSemaphore;
+	uint _pending;
+	bool _waiting;
+	bool _quit;
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -407,6 +407,7 @@ Common::Error AdvancedMetaEngineDetectionBase::identifyGame(DetectedGame &game,
 
 	// Detection is done, no need to keep archives in memory anymore
 	ADCacheMan.clearArchives();
+	ADCacheMan.flushPersistentCache(false);
 
 	if (!agdDesc.desc)
 		return Common::kNoGameDataFoundError;
@@ -468,6 +469,239 @@ namespace Common {
 	DECLARE_SINGLETON(AdvancedDetectorCacheManager);
 }
 
+/* Persistent MD5 cache */
+
+#define DETECTION_CACHE_FILENAME "scummvm-detection.cache"
+
+enum {
+	kDetectionCacheVersion = 1,
+	kDetectionCacheFlushDelay = 30 * 1000
+};
+
+static int hexDigitValue(char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+static bool md5StringToBytes(const Common::String &md5, byte *bytes) {
+	if (md5.size() != 32)
+		return false;
+
+	for (uint i = 0; i < 16; i++) {
+		int hi = hexDigitValue(md5[i * 2]);
+		int lo = hexDigitValue(md5[i * 2 + 1]);
+		if (hi < 0 || lo < 0)
+			return false;
+		bytes[i] = (byte)((hi << 4) | lo);
+	}
+
+	return true;
+}
+
+static Common::String md5BytesToString(const byte *bytes) {
+	Common::String md5;
+	for (uint i = 0; i < 16; i++)
+		md5 += Common::String::format("%02x", bytes[i]);
+	return md5;
+}
+
+static void writeCacheString(Common::WriteStream &stream, const Common::String &str) {
+	stream.writeUint16LE(str.size());
+	stream.write(str.c_str(), str.size());
+}
+
+static Common::String readCacheString(Common::ReadStream &stream) {
+	uint16 len = stream.readUint16LE();
+	Common::String str;
+	for (uint16 i = 0; i < len && !stream.eos(); i++)
+		str += (char)stream.readByte();
+	return str;
+}
+
+Common::String AdvancedDetectorCacheManager::persistentKey(const Common::String &fname, const Common::String &path) {
+	return path + '|' + fname;
+}
+
+void AdvancedDetectorCacheManager::loadPersistentCache() {
+	if (_persistentLoaded)
+		return;
+	_persistentLoaded = true;
+
+	Common::String mode = ConfMan.hasKey("detection_cache") ? ConfMan.get("detection_cache") : "on";
+	if (mode == "off") {
+		_persistentMode = kPersistentCacheOff;
+		return;
+	} else if (mode == "verify") {
+		_persistentMode = kPersistentCacheVerify;
+	} else if (mode == "rebuild") {
+		_persistentMode = kPersistentCacheRebuild;
+	} else {
+		_persistentMode = kPersistentCacheOn;
+	}
+
+	Common::Path configFile = ConfMan.getCustomConfigFileName();
+	if (configFile.empty())
+		configFile = g_system->getDefaultConfigFileName();
+	_persistentFile = Common::FSNode(configFile).getParent().getChild(DETECTION_CACHE_FILENAME);
+
+	if (_persistentMode == kPersistentCacheRebuild) {
+		// Make sure the old file gets replaced even if nothing is detected
+		_persistentDirty = true;
+		return;
+	}
+
+	if (!_persistentFile.exists())
+		return;
+
+	Common::ScopedPtr<Common::SeekableReadStream> stream(_persistentFile.createReadStream());
+	if (!stream)
+		return;
+
+	if (stream->readUint32BE() != MKTAG('S', 'V', 'D', 'C') || stream->readUint32LE() != kDetectionCacheVersion) {
+		debugC(2, kDebugGlobalDetection, "Ignoring detection cache '%s' with unknown format", _persistentFile.getPath().toString(Common::Path::kNativeSeparator).c_str());
+		return;
+	}
+
+	uint32 count = stream->readUint32LE();
+	for (uint32 i = 0; i < count; i++) {
+		PersistentEntry entry;
+		byte md5[16];
+
+		entry.path = readCacheString(*stream);
+		entry.fname = readCacheString(*stream);
+		entry.fileSize = stream->readSint64LE();
+		entry.modificationTime = stream->readSint64LE();
+		entry.props.size = stream->readSint64LE();
+		entry.props.md5prop = (MD5Properties)stream->readByte();
+		stream->read(md5, sizeof(md5));
+		entry.props.md5 = md5BytesToString(md5);
+
+		if (stream->err() || stream->eos()) {
+			warning("Detection cache '%s' is truncated, rebuilding it", _persistentFile.getPath().toString(Common::Path::kNativeSeparator).c_str());
+			_persistentHashMap.clear();
+			_persistentDirty = true;
+			return;
+		}
+
+		if (_persistentMode == kPersistentCacheVerify) {
+			// Drop the entries of files which were removed or modified
+			int64 size, mtime;
+			Common::FSNode node(Common::Path::fromConfig(entry.path));
+			if (!node.getFileStat(size, mtime) || size != entry.fileSize || mtime != entry.modificationTime) {
+				debugC(2, kDebugGlobalDetection, "Dropping outdated detection cache entry for '%s'", entry.path.c_str());
+				_persistentDirty = true;
+				continue;
+			}
+		}
+
+		_persistentHashMap.setVal(persistentKey(entry.fname, entry.path), entry);
+	}
+
+	debugC(2, kDebugGlobalDetection, "Loaded %d entries from detection cache '%s'", _persistentHashMap.size(), _persistentFile.getPath().toString(Common::Path::kNativeSeparator).c_str());
+}
+
+bool AdvancedDetectorCacheManager::isVerifyingPersistentCache() {
+	loadPersistentCache();
+	return _persistentMode == kPersistentCacheVerify;
+}
+
+bool AdvancedDetectorCacheManager::getPersistentProperties(const Common::String &fname, const Common::FSNode &node, FileProperties &fileProps) {
+	loadPersistentCache();
+	if (_persistentMode == kPersistentCacheOff)
+		return false;
+
+	int64 size, mtime;
+	if (!node.getFileStat(size, mtime))
+		return false;
+
+	PersistentHashMap::const_iterator it = _persistentHashMap.find(persistentKey(fname, node.getPath().toConfig()));
+	if (it == _persistentHashMap.end())
+		return false;
+
+	if (it->_value.fileSize != size || it->_value.modificationTime != mtime)
+		return false;
+
+	fileProps = it->_value.props;
+	_verifiedEntries++;
+	return true;
+}
+
+void AdvancedDetectorCacheManager::setPersistentProperties(const Common::String &fname, const Common::FSNode &node, const FileProperties &fileProps) {
+	loadPersistentCache();
+	if (_persistentMode == kPersistentCacheOff)
+		return;
+
+	byte md5[16];
+	if (!md5StringToBytes(fileProps.md5, md5))
+		return;
+
+	PersistentEntry entry;
+	if (!node.getFileStat(entry.fileSize, entry.modificationTime))
+		return;
+
+	entry.path = node.getPath().toConfig();
+	entry.fname = fname;
+	entry.props = fileProps;
+
+	_persistentHashMap.setVal(persistentKey(fname, entry.path), entry);
+	_persistentDirty = true;
+}
+
+void AdvancedDetectorCacheManager::reportPersistentMismatch(const Common::String &fname, const Common::FSNode &node) {
+	warning("Detection cache entry '%s' for '%s' is stale", fname.c_str(), node.getPath().toString(Common::Path::kNativeSeparator).c_str());
+	_staleEntries++;
+}
+
+void AdvancedDetectorCacheManager::flushPersistentCache(bool force) {
+	if (force && _persistentMode == kPersistentCacheVerify) {
+		debug("Detection cache: %d entries checked, %d stale", _verifiedEntries, _staleEntries);
+		_verifiedEntries = _staleEntries = 0;
+	}
+
+	if (!_persistentDirty || _persistentMode == kPersistentCacheOff)
+		return;
+
+	uint32 now = g_system->getMillis();
+	if (!force && now - _lastPersistentFlush < kDetectionCacheFlushDelay)
+		return;
+
+	Common::ScopedPtr<Common::WriteStream> stream(_persistentFile.createWriteStream());
+	if (!stream) {
+		warning("Unable to write detection cache '%s'", _persistentFile.getPath().toString(Common::Path::kNativeSeparator).c_str());
+		_persistentMode = kPersistentCacheOff;
+		return;
+	}
+
+	stream->writeUint32BE(MKTAG('S', 'V', 'D', 'C'));
+	stream->writeUint32LE(kDetectionCacheVersion);
+	stream->writeUint32LE(_persistentHashMap.size());
+
+	for (const auto &it : _persistentHashMap) {
+		const PersistentEntry &entry = it._value;
+		byte md5[16];
+
+		md5StringToBytes(entry.props.md5, md5);
+		writeCacheString(*stream, entry.path);
+		writeCacheString(*stream, entry.fname);
+		stream->writeSint64LE(entry.fileSize);
+		stream->writeSint64LE(entry.modificationTime);
+		stream->writeSint64LE(entry.props.size);
+		stream->writeByte(entry.props.md5prop);
+		stream->write(md5, sizeof(md5));
+	}
+
+	if (!stream->flush() || stream->err())
+		warning("Error while writing detection cache '%s'", _persistentFile.getPath().toString(Common::Path::kNativeSeparator).c_str());
+
+	_persistentDirty = false;
+	_lastPersistentFlush = now;
+}
+
 
 static MD5Properties gameFileToMD5Props(const ADGameFileDescription *fileEntry, uint32 gameFlags) {
 	MD5Properties ret = kMD5Head;
@@ -532,6 +766,80 @@ Common::String md5PropToGameFile(MD5Properties flags) {
 
 static bool getFilePropertiesIntern(uint md5Bytes, const AdvancedMetaEngineBase::FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, FileProperties &fileProps);
 
+/**
+ * Find the standalone file holding the resource fork of the Mac file @p fname,
+ * in the order MacResManager::open() looks for it. Return false when the fork
+ * is stored in the file itself, as MacBinary or as a native fork.
+ */
+static bool getResForkNode(const AdvancedMetaEngineBase::FileMap &allFiles, const Common::Path &fname, Common::FSNode &node) {
+	const Common::Path candidates[] = {
+		fname.append(".rsrc"),
+		fname.append(".bin"),
+		fname.getParent().appendComponent("._" + fname.baseName())
+	};
+
+	for (const Common::Path &candidate : candidates) {
+		if (allFiles.contains(candidate)) {
+			node = allFiles[candidate];
+			return true;
+		}
+	}
+
+	if (!allFiles.contains(fname))
+		return false;
+
+	// AppleDouble files in a __MACOSX directory up to the game directory
+	Common::StringArray components = allFiles[fname].getPath().splitComponents();
+	int start = MAX((int)components.size() - fname.numComponents(), 0);
+	for (int i = components.size() - 1; i >= start; i--) {
+		if (i == 0 && components[i].contains(':'))
+			break;
+
+		Common::StringArray newComponents;
+		int j;
+		for (j = 0; j < i; j++)
+			newComponents.push_back(components[j]);
+		newComponents.push_back("__MACOSX");
+		for (; j < (int)components.size() - 1; j++)
+			newComponents.push_back(components[j]);
+		newComponents.push_back("._" + components.back());
+
+		Common::FSNode appleDouble(Common::Path::joinComponents(newComponents));
+		if (appleDouble.exists()) {
+			node = appleDouble;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Return the file on disk whose size and modification time validate the
+ * persistent cache entry of @p fname. For files inside archives, this is the
+ * archive itself. For Mac resource forks, this is the file holding the fork,
+ * and @p resFork tells whether it is a different file than the data fork.
+ */
+static bool getPersistentCacheNode(const AdvancedMetaEngineBase::FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, Common::FSNode &node, bool &resFork) {
+	Common::Path path(fname);
+	resFork = false;
+
+	if (md5prop & kMD5Archive) {
+		Common::StringTokenizer tok(fname.toString(), ":");
+		tok.nextToken();
+		path = Common::Path(tok.nextToken());
+	} else if ((md5prop & kMD5MacResFork) && getResForkNode(allFiles, fname, node)) {
+		resFork = true;
+		return true;
+	}
+
+	if (!allFiles.contains(path))
+		return false;
+
+	node = allFiles[path];
+	return true;
+}
+
 bool AdvancedMetaEngineDetectionBase::getFileProperties(const FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, FileProperties &fileProps) const {
 	Common::String hashname = md5PropToCachePrefix(md5prop);
 		hashname += ':';
@@ -545,11 +853,31 @@ bool AdvancedMetaEngineDetectionBase::getFileProperties(const FileMap &allFiles,
 		return true;
 	}
 
+	Common::FSNode node;
+	bool resFork;
+	bool persistent = getPersistentCacheNode(allFiles, md5prop, fname, node, resFork);
+	FileProperties cachedProps;
+	bool cached = persistent && ADCacheMan.getPersistentProperties(hashname, node, cachedProps);
+
+	if (cached && !ADCacheMan.isVerifyingPersistentCache()) {
+		fileProps = cachedProps;
+		ADCacheMan.setMD5(hashname, fileProps.md5);
+		ADCacheMan.setSize(hashname, fileProps.size);
+		return true;
+	}
+
 	bool res = getFilePropertiesIntern(_md5Bytes, allFiles, md5prop, fname, fileProps);
 
 	if (res) {
 		ADCacheMan.setMD5(hashname, fileProps.md5);
 		ADCacheMan.setSize(hashname, fileProps.size);
+
+		if (cached && (cachedProps.md5 != fileProps.md5 || cachedProps.size != fileProps.size))
+			ADCacheMan.reportPersistentMismatch(hashname, node);
+		// The legacy Mac files fall back to the data fork, which the resource
+		// fork file does not validate
+		if (persistent && (!resFork || (fileProps.md5prop & kMD5MacResFork)))
+			ADCacheMan.setPersistentProperties(hashname, node, fileProps);
 	}
 
 	return res;
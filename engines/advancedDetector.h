@@ -731,6 +731,16 @@ private:
 
 /**
  * Singleton Cache Storage for Computed MD5s and Open Archives
+ *
+ * Besides the in-memory cache, which is cleared before each detection run,
+ * computed MD5s are also kept in a persistent cache stored in a binary file
+ * next to the configuration file. Its entries are keyed by the absolute path
+ * of the file and the MD5 properties, and are only used as long as the size
+ * and modification time of the file did not change.
+ *
+ * The persistent cache is controlled by the "detection_cache" setting:
+ * "on" (default), "off", "verify" (recompute MD5s of cache hits and report
+ * stale entries) or "rebuild" (discard the existing cache file).
  */
 class AdvancedDetectorCacheManager : public Common::Singleton<AdvancedDetectorCacheManager> {
 public:
@@ -771,10 +781,43 @@ public:
 		return archiveHashMap.getValOrDefault(node.getPath(), nullptr);
 	}
 
-	AdvancedDetectorCacheManager() {
+	/**
+	 * Look up file properties in the persistent cache.
+	 *
+	 * @param fname  Cache key, as used for the in-memory cache.
+	 * @param node   File the properties were computed from. The entry is
+	 *               discarded if its size or modification time changed.
+	 */
+	bool getPersistentProperties(const Common::String &fname, const Common::FSNode &node, FileProperties &fileProps);
+
+	/** Store file properties computed from @p node in the persistent cache. */
+	void setPersistentProperties(const Common::String &fname, const Common::FSNode &node, const FileProperties &fileProps);
+
+	/** Report a persistent cache entry which did not match the recomputed properties. */
+	void reportPersistentMismatch(const Common::String &fname, const Common::FSNode &node);
+
+	/** Return true if persistent cache hits must be recomputed and checked. */
+	bool isVerifyingPersistentCache();
+
+	/**
+	 * Write the persistent cache to disk if it was modified.
+	 *
+	 * @param force  If false, the cache is only written if the last write
+	 *               happened a while ago. This limits the I/O when detection
+	 *               is run on many directories in a row.
+	 */
+	void flushPersistentCache(bool force = true);
+
+	AdvancedDetectorCacheManager() : _persistentMode(kPersistentCacheOff), _persistentLoaded(false),
+		_persistentDirty(false), _lastPersistentFlush(0), _verifiedEntries(0), _staleEntries(0) {
 		clear();
 	}
 
+	~AdvancedDetectorCacheManager() {
+		flushPersistentCache();
+		clearArchives();
+	}
+
 	void clearArchives() {
 		for (auto &entry : archiveHashMap) {
 			delete entry._value;
@@ -791,12 +834,40 @@ public:
 private:
 	friend class Common::Singleton<AdvancedDetectorCacheManager>;
 
+	enum PersistentCacheMode {
+		kPersistentCacheOff,
+		kPersistentCacheOn,
+		kPersistentCacheVerify,
+		kPersistentCacheRebuild
+	};
+
+	struct PersistentEntry {
+		Common::String path;
+		Common::String fname;
+		int64 fileSize;
+		int64 modificationTime;
+		FileProperties props;
+	};
+
+	void loadPersistentCache();
+	static Common::String persistentKey(const Common::String &fname, const Common::String &path);
+
 	typedef Common::HashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> FileHashMap;
 	typedef Common::HashMap<Common::String, int64, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> SizeHashMap;
 	typedef Common::HashMap<Common::Path, Common::Archive *, Common::Path::IgnoreCase_Hash, Common::Path::IgnoreCase_EqualTo> ArchiveHashMap;
+	typedef Common::HashMap<Common::String, PersistentEntry> PersistentHashMap;
 	FileHashMap md5HashMap;
 	SizeHashMap sizeHashMap;
 	ArchiveHashMap archiveHashMap;
+
+	PersistentHashMap _persistentHashMap;
+	Common::FSNode _persistentFile;
+	PersistentCacheMode _persistentMode;
+	bool _persistentLoaded;
+	bool _persistentDirty;
+	uint32 _lastPersistentFlush;
+	uint _verifiedEntries;
+	uint _staleEntries;
 };
 
 /** Convenience shortcut for accessing the MD5CacheManager. */
@@ -33,6 +33,7 @@
 #include "common/error.h"
 #include "common/list.h"
 #include "common/memstream.h"
+#include "common/profiler.h"
 #include "common/savefile.h"
 #include "common/scummsys.h"
 #include "common/taskbar.h"
@@ -696,6 +697,7 @@ void Engine::errorString(const char *buf1, char *buf2, int size) {
 }
 
 PauseToken Engine::pauseEngine() {
+	PROFILE_ZONE("Engine::pauseEngine");
 	assert(_pauseLevel >= 0);
 
 	_pauseLevel++;
@@ -62,10 +62,17 @@ bool Lab::open(const Common::Path &filename, bool keepStream) {
 			parseMonkey4FileTable(file);
 	}
 	if (result && keepStream) {
-		file->seek(0, SEEK_SET);
-		byte *data = static_cast<byte*>(malloc(sizeof(byte) * file->size()));
-		file->read(data, file->size());
-		_stream = new Common::MemoryReadStream(data, file->size(), DisposeAfterUse::YES);
+		// Mapping the file into memory saves reading all of it into a copy
+		Common::ArchiveMemberPtr member = SearchMan.getMember(filename);
+		if (member)
+			_stream = member->createMappedReadStream();
+
+		if (!_stream) {
+			file->seek(0, SEEK_SET);
+			byte *data = static_cast<byte*>(malloc(sizeof(byte) * file->size()));
+			file->read(data, file->size());
+			_stream = new Common::MemoryReadStream(data, file->size(), DisposeAfterUse::YES);
+		}
 	}
 	delete file;
 
@@ -175,6 +182,9 @@ Common::SeekableReadStream *Lab::createReadStreamForMember(const Common::Path &p
 		Common::File *file = new Common::File();
 		file->open(_labFileName);
 		return new Common::SeekableSubReadStream(file, i->_offset, i->_offset + i->_len, DisposeAfterUse::YES);
+	} else if (_stream->getMappedData()) {
+		// The members borrow the contents of the lab, which outlives them
+		return new Common::MemoryReadStream(_stream->getMappedData() + i->_offset, i->_len, DisposeAfterUse::NO);
 	} else {
 		byte *data = static_cast<byte*>(malloc(sizeof(byte) * i->_len));
 		_stream->seek(i->_offset, SEEK_SET);
@@ -22,6 +22,7 @@
 #include "common/config-manager.h"
 #include "common/debug.h"
 #include "common/debug-channels.h"
+#include "common/profiler.h"
 
 #include "sci/sci.h"
 #include "sci/console.h"
@@ -349,6 +350,8 @@ static void callKernelFunc(EngineState *s, int kernelCallNr, int argc) {
 		}
 	}
 
+	// The kernel calls are where the scripts spend most of their time
+	PROFILE_ZONE(kernelCall.name);
 
 	// Call kernel function
 	if (!kernelCall.subFunctionCount) {
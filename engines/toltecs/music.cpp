@@ -78,20 +78,30 @@ void MusicPlayer::send(uint32 b) {
 	Audio::MidiPlayer::send(b);
 }
 
-void MusicPlayer::playMIDI(const byte *data, uint32 size, bool loop) {
-	Common::StackLock lock(_mutex);
+MidiParser *MusicPlayer::createParser(const byte *data) {
+	if (!memcmp(data, "FORM", 4))
+		return MidiParser::createParser_XMIDI(NULL);
+	else
+		return MidiParser::createParser_SMF();
+}
 
+void MusicPlayer::playMIDI(const byte *data, uint32 size, bool loop) {
 	stopAndClear();
 
+	// The songs do not depend on send() when they are not converted, so
+	// they can be played from the music render cache
+	if (!_milesAudioMode && (_isGM || _nativeMT32)) {
+		syncVolume();
+		if (playRendered(data, size, createParser(data), loop))
+			return;
+	}
+
+	Common::StackLock lock(_mutex);
+
 	_buffer = new byte[size];
 	memcpy(_buffer, data, size);
 
-	MidiParser *parser;
-
-	if (!memcmp(data, "FORM", 4))
-		parser = MidiParser::createParser_XMIDI(NULL);
-	else
-		parser = MidiParser::createParser_SMF();
+	MidiParser *parser = createParser(data);
 
 	if (parser->loadMusic(_buffer, size)) {
 		parser->setTrack(0);
@@ -112,9 +122,12 @@ void MusicPlayer::playMIDI(const byte *data, uint32 size, bool loop) {
 }
 
 void MusicPlayer::stopAndClear() {
-	Common::StackLock lock(_mutex);
+	// Stop the song from the render cache without _mutex locked, since the
+	// mixer calls onTimer() with its own mutex locked
 	stop();
 
+	Common::StackLock lock(_mutex);
+
 	delete[] _buffer;
 	_buffer = NULL;
 }
@@ -45,6 +45,8 @@ protected:
 	bool _isGM;
 
 private:
+	MidiParser *createParser(const byte *data);
+
 	byte *_buffer;
 	bool _milesAudioMode;
 };
@@ -0,0 +1,195 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/blit/blit-convert.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace Graphics {
+
+class CrossBlitKernelsImpl_AVX2 {
+public:
+
+enum {
+	kBlockSize = 8
+};
+
+/** The parameters of the conversion, as shift counts and masks for the vector instructions. */
+struct Constants {
+	Constants(const CrossBlitKernels::Params &params) : numChannels(params.numChannels) {
+		for (uint i = 0; i < numChannels; i++) {
+			const CrossBlitKernels::Channel &c = params.channels[i];
+			srcShift[i] = _mm_cvtsi32_si128(c.srcShift);
+			srcMask[i] = _mm256_set1_epi32(c.srcMask);
+			expandLeft[i] = _mm_cvtsi32_si128(c.expandLeft);
+			expandRight[i] = _mm_cvtsi32_si128(c.expandRight);
+			dstLoss[i] = _mm_cvtsi32_si128(c.dstLoss);
+			dstShift[i] = _mm_cvtsi32_si128(c.dstShift);
+		}
+		fill = _mm256_set1_epi32(params.fill);
+		key = _mm256_set1_epi32(params.key);
+	}
+
+	uint numChannels;
+	__m128i srcShift[4], expandLeft[4], expandRight[4], dstLoss[4], dstShift[4];
+	__m256i srcMask[4];
+	__m256i fill, key;
+};
+
+/** Loads 8 pixels in 32-bit lanes. */
+template<int Size>
+static inline __m256i load(const byte *src) {
+	if (Size == 4)
+		return _mm256_loadu_si256((const __m256i *)src);
+	if (Size == 2)
+		return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)src));
+	return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)src));
+}
+
+/** Stores 8 pixels from 32-bit lanes, keeping the low bits of the smaller ones. */
+template<int Size>
+static inline void store(byte *dst, __m256i x) {
+	if (Size == 4) {
+		_mm256_storeu_si256((__m256i *)dst, x);
+	} else {
+		x = _mm256_and_si256(x, _mm256_set1_epi32(0xFFFF));
+		_mm_storeu_si128((__m128i *)dst, _mm_packus_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1)));
+	}
+}
+
+/** Returns all bits set in the lanes of the pixels which are not drawn. */
+static inline __m256i skipped(const CrossBlitKernels::Params &params, __m256i key, __m256i color, const byte *mask) {
+	__m256i skip = _mm256_setzero_si256();
+	if (params.hasKey)
+		skip = _mm256_cmpeq_epi32(color, key);
+	if (mask)
+		skip = _mm256_or_si256(skip, _mm256_cmpeq_epi32(load<1>(mask), _mm256_setzero_si256()));
+	return skip;
+}
+
+static inline __m256i convertColors(const Constants &c, __m256i color) {
+	__m256i result = c.fill;
+	for (uint i = 0; i < c.numChannels; i++) {
+		const __m256i v = _mm256_and_si256(_mm256_srl_epi32(color, c.srcShift[i]), c.srcMask[i]);
+		const __m256i e = _mm256_or_si256(_mm256_sll_epi32(v, c.expandLeft[i]), _mm256_srl_epi32(v, c.expandRight[i]));
+		result = _mm256_or_si256(result, _mm256_sll_epi32(_mm256_srl_epi32(e, c.dstLoss[i]), c.dstShift[i]));
+	}
+	return result;
+}
+
+template<int SrcSize, int DstSize>
+static inline void convertBlock(const CrossBlitKernels::Params &params, const Constants &c, const CrossBlitKernels::Row &row, uint x) {
+	byte *dst = row.dst + x * DstSize;
+	const __m256i color = load<SrcSize>(row.src + x * SrcSize);
+	__m256i result = convertColors(c, color);
+
+	if (params.hasKey || row.mask) {
+		const __m256i skip = skipped(params, c.key, color, row.mask ? row.mask + x : nullptr);
+		result = _mm256_blendv_epi8(result, load<DstSize>(dst), skip);
+	}
+
+	store<DstSize>(dst, result);
+}
+
+template<int DstSize>
+static inline void convertMapBlock(const CrossBlitKernels::Params &params, __m256i key, const CrossBlitKernels::Row &row, uint x) {
+	byte *dst = row.dst + x * DstSize;
+	const __m256i index = load<1>(row.src + x);
+	__m256i result = _mm256_i32gather_epi32((const int *)params.map, index, 4);
+
+	if (params.hasKey || row.mask) {
+		const __m256i skip = skipped(params, key, index, row.mask ? row.mask + x : nullptr);
+		result = _mm256_blendv_epi8(result, load<DstSize>(dst), skip);
+	}
+
+	store<DstSize>(dst, result);
+}
+
+template<int SrcSize, int DstSize>
+static void convertRow(const CrossBlitKernels::Params &params, const CrossBlitKernels::Row &row) {
+	const Constants c(params);
+	const uint blocks = row.width & ~(kBlockSize - 1);
+
+	if (DstSize > SrcSize) {
+		CrossBlitKernels::convertPixels(params, row, blocks, row.width);
+		for (uint x = blocks; x > 0; x -= kBlockSize)
+			convertBlock<SrcSize, DstSize>(params, c, row, x - kBlockSize);
+	} else {
+		for (uint x = 0; x < blocks; x += kBlockSize)
+			convertBlock<SrcSize, DstSize>(params, c, row, x);
+		CrossBlitKernels::convertPixels(params, row, blocks, row.width);
+	}
+}
+
+template<int DstSize>
+static void convertMapRow(const CrossBlitKernels::Params &params, const CrossBlitKernels::Row &row) {
+	const __m256i key = _mm256_set1_epi32(params.key);
+	const uint blocks = row.width & ~(kBlockSize - 1);
+
+	CrossBlitKernels::convertPixels(params, row, blocks, row.width);
+	for (uint x = blocks; x > 0; x -= kBlockSize)
+		convertMapBlock<DstSize>(params, key, row, x - kBlockSize);
+}
+
+static void convert(const CrossBlitKernels::Params &params, const CrossBlitKernels::Row &row) {
+	if (params.srcBytesPerPixel == 2) {
+		if (params.dstBytesPerPixel == 2)
+			convertRow<2, 2>(params, row);
+		else
+			convertRow<2, 4>(params, row);
+	} else {
+		if (params.dstBytesPerPixel == 2)
+			convertRow<4, 2>(params, row);
+		else
+			convertRow<4, 4>(params, row);
+	}
+}
+
+static void convertMap(const CrossBlitKernels::Params &params, const CrossBlitKernels::Row &row) {
+	if (params.dstBytesPerPixel == 2)
+		convertMapRow<2>(params, row);
+	else
+		convertMapRow<4>(params, row);
+}
+
+}; // End of class CrossBlitKernelsImpl_AVX2
+
+const CrossBlitKernels::Table CrossBlitKernels::avx2 = {
+	CrossBlitKernelsImpl_AVX2::convert,
+	CrossBlitKernelsImpl_AVX2::convertMap
+};
+
+} // End of namespace Graphics
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,179 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "graphics/blit/blit-convert.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace Graphics {
+
+class CrossBlitKernelsImpl_NEON {
+public:
+
+enum {
+	kBlockSize = 4
+};
+
+/** The parameters of the conversion, as shift counts and masks for the vector instructions. */
+struct Constants {
+	Constants(const CrossBlitKernels::Params &params) : numChannels(params.numChannels) {
+		// Right shifts are left shifts by negative counts
+		for (uint i = 0; i < numChannels; i++) {
+			const CrossBlitKernels::Channel &c = params.channels[i];
+			srcShift[i] = vdupq_n_s32(-(int32)c.srcShift);
+			srcMask[i] = vdupq_n_u32(c.srcMask);
+			expandLeft[i] = vdupq_n_s32(c.expandLeft);
+			expandRight[i] = vdupq_n_s32(-(int32)c.expandRight);
+			dstLoss[i] = vdupq_n_s32(-(int32)c.dstLoss);
+			dstShift[i] = vdupq_n_s32(c.dstShift);
+		}
+		fill = vdupq_n_u32(params.fill);
+		key = vdupq_n_u32(params.key);
+	}
+
+	uint numChannels;
+	int32x4_t srcShift[4], expandLeft[4], expandRight[4], dstLoss[4], dstShift[4];
+	uint32x4_t srcMask[4];
+	uint32x4_t fill, key;
+};
+
+/** Loads 4 pixels in 32-bit lanes. */
+template<int Size>
+static inline uint32x4_t load(const byte *src) {
+	if (Size == 4)
+		return vld1q_u32((const uint32 *)src);
+	return vmovl_u16(vld1_u16((const uint16 *)src));
+}
+
+/** Stores 4 pixels from 32-bit lanes, keeping the low bits of the smaller ones. */
+template<int Size>
+static inline void store(byte *dst, uint32x4_t x) {
+	if (Size == 4)
+		vst1q_u32((uint32 *)dst, x);
+	else
+		vst1_u16((uint16 *)dst, vmovn_u32(x));
+}
+
+/** Returns all bits set in the lanes of the pixels which are not drawn. */
+static inline uint32x4_t skipped(const CrossBlitKernels::Params &params, const Constants &c, uint32x4_t color, const byte *mask) {
+	uint32x4_t skip = vdupq_n_u32(0);
+	if (params.hasKey)
+		skip = vceqq_u32(color, c.key);
+	if (mask) {
+		uint32 m;
+		memcpy(&m, mask, sizeof(m));
+		const uint32x4_t m32 = vmovl_u16(vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(m)))));
+		skip = vorrq_u32(skip, vceqq_u32(m32, vdupq_n_u32(0)));
+	}
+	return skip;
+}
+
+static inline uint32x4_t convertColors(const Constants &c, uint32x4_t color) {
+	uint32x4_t result = c.fill;
+	for (uint i = 0; i < c.numChannels; i++) {
+		const uint32x4_t v = vandq_u32(vshlq_u32(color, c.srcShift[i]), c.srcMask[i]);
+		const uint32x4_t e = vorrq_u32(vshlq_u32(v, c.expandLeft[i]), vshlq_u32(v, c.expandRight[i]));
+		result = vorrq_u32(result, vshlq_u32(vshlq_u32(e, c.dstLoss[i]), c.dstShift[i]));
+	}
+	return result;
+}
+
+template<int SrcSize, int DstSize>
+static inline void convertBlock(const CrossBlitKernels::Params &params, const Constants &c, const CrossBlitKernels::Row &row, uint x) {
+	byte *dst = row.dst + x * DstSize;
+	const uint32x4_t color = load<SrcSize>(row.src + x * SrcSize);
+	uint32x4_t result = convertColors(c, color);
+
+	if (params.hasKey || row.mask) {
+		const uint32x4_t skip = skipped(params, c, color, row.mask ? row.mask + x : nullptr);
+		result = vbslq_u32(skip, load<DstSize>(dst), result);
+	}
+
+	store<DstSize>(dst, result);
+}
+
+template<int SrcSize, int DstSize>
+static void convertRow(const CrossBlitKernels::Params &params, const CrossBlitKernels::Row &row) {
+	const Constants c(params);
+	const uint blocks = row.width & ~(kBlockSize - 1);
+
+	if (DstSize > SrcSize) {
+		CrossBlitKernels::convertPixels(params, row, blocks, row.width);
+		for (uint x = blocks; x > 0; x -= kBlockSize)
+			convertBlock<SrcSize, DstSize>(params, c, row, x - kBlockSize);
+	} else {
+		for (uint x = 0; x < blocks; x += kBlockSize)
+			convertBlock<SrcSize, DstSize>(params, c, row, x);
+		CrossBlitKernels::convertPixels(params, row, blocks, row.width);
+	}
+}
+
+static void convert(const CrossBlitKernels::Params &params, const CrossBlitKernels::Row &row) {
+	if (params.srcBytesPerPixel == 2) {
+		if (params.dstBytesPerPixel == 2)
+			convertRow<2, 2>(params, row);
+		else
+			convertRow<2, 4>(params, row);
+	} else {
+		if (params.dstBytesPerPixel == 2)
+			convertRow<4, 2>(params, row);
+		else
+			convertRow<4, 4>(params, row);
+	}
+}
+
+}; // End of class CrossBlitKernelsImpl_NEON
+
+// There is no gather instruction to look up the map, which the scalar
+// code already does with a single load per pixel
+const CrossBlitKernels::Table CrossBlitKernels::neon = {
+	CrossBlitKernelsImpl_NEON::convert,
+	nullptr
+};
+
+} // End of namespace Graphics
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
@@ -0,0 +1,176 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/blit/blit-convert.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Graphics {
+
+class CrossBlitKernelsImpl_SSE2 {
+public:
+
+enum {
+	kBlockSize = 4
+};
+
+/** The parameters of the conversion, as shift counts and masks for the vector instructions. */
+struct Constants {
+	Constants(const CrossBlitKernels::Params &params) : numChannels(params.numChannels) {
+		for (uint i = 0; i < numChannels; i++) {
+			const CrossBlitKernels::Channel &c = params.channels[i];
+			srcShift[i] = _mm_cvtsi32_si128(c.srcShift);
+			srcMask[i] = _mm_set1_epi32(c.srcMask);
+			expandLeft[i] = _mm_cvtsi32_si128(c.expandLeft);
+			expandRight[i] = _mm_cvtsi32_si128(c.expandRight);
+			dstLoss[i] = _mm_cvtsi32_si128(c.dstLoss);
+			dstShift[i] = _mm_cvtsi32_si128(c.dstShift);
+		}
+		fill = _mm_set1_epi32(params.fill);
+		key = _mm_set1_epi32(params.key);
+	}
+
+	uint numChannels;
+	__m128i srcShift[4], srcMask[4], expandLeft[4], expandRight[4], dstLoss[4], dstShift[4];
+	__m128i fill, key;
+};
+
+/** Loads 4 pixels in 32-bit lanes. */
+template<int Size>
+static inline __m128i load(const byte *src) {
+	if (Size == 4)
+		return _mm_loadu_si128((const __m128i *)src);
+	return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)src), _mm_setzero_si128());
+}
+
+/** Stores 4 pixels from 32-bit lanes, keeping the low bits of the smaller ones. */
+template<int Size>
+static inline void store(byte *dst, __m128i x) {
+	if (Size == 4) {
+		_mm_storeu_si128((__m128i *)dst, x);
+	} else {
+		x = _mm_srai_epi32(_mm_slli_epi32(x, 16), 16);
+		_mm_storel_epi64((__m128i *)dst, _mm_packs_epi32(x, x));
+	}
+}
+
+/** Returns all bits set in the lanes of the pixels which are not drawn. */
+static inline __m128i skipped(const CrossBlitKernels::Params &params, const Constants &c, __m128i color, const byte *mask) {
+	__m128i skip = _mm_setzero_si128();
+	if (params.hasKey)
+		skip = _mm_cmpeq_epi32(color, c.key);
+	if (mask) {
+		int32 m;
+		memcpy(&m, mask, sizeof(m));
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i m32 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(m), zero), zero);
+		skip = _mm_or_si128(skip, _mm_cmpeq_epi32(m32, zero));
+	}
+	return skip;
+}
+
+static inline __m128i convertColors(const Constants &c, __m128i color) {
+	__m128i result = c.fill;
+	for (uint i = 0; i < c.numChannels; i++) {
+		const __m128i v = _mm_and_si128(_mm_srl_epi32(color, c.srcShift[i]), c.srcMask[i]);
+		const __m128i e = _mm_or_si128(_mm_sll_epi32(v, c.expandLeft[i]), _mm_srl_epi32(v, c.expandRight[i]));
+		result = _mm_or_si128(result, _mm_sll_epi32(_mm_srl_epi32(e, c.dstLoss[i]), c.dstShift[i]));
+	}
+	return result;
+}
+
+template<int SrcSize, int DstSize>
+static inline void convertBlock(const CrossBlitKernels::Params &params, const Constants &c, const CrossBlitKernels::Row &row, uint x) {
+	byte *dst = row.dst + x * DstSize;
+	const __m128i color = load<SrcSize>(row.src + x * SrcSize);
+	__m128i result = convertColors(c, color);
+
+	if (params.hasKey || row.mask) {
+		const __m128i skip = skipped(params, c, color, row.mask ? row.mask + x : nullptr);
+		result = _mm_or_si128(_mm_and_si128(skip, load<DstSize>(dst)), _mm_andnot_si128(skip, result));
+	}
+
+	store<DstSize>(dst, result);
+}
+
+template<int SrcSize, int DstSize>
+static void convertRow(const CrossBlitKernels::Params &params, const CrossBlitKernels::Row &row) {
+	const Constants c(params);
+	const uint blocks = row.width & ~(kBlockSize - 1);
+
+	if (DstSize > SrcSize) {
+		CrossBlitKernels::convertPixels(params, row, blocks, row.width);
+		for (uint x = blocks; x > 0; x -= kBlockSize)
+			convertBlock<SrcSize, DstSize>(params, c, row, x - kBlockSize);
+	} else {
+		for (uint x = 0; x < blocks; x += kBlockSize)
+			convertBlock<SrcSize, DstSize>(params, c, row, x);
+		CrossBlitKernels::convertPixels(params, row, blocks, row.width);
+	}
+}
+
+static void convert(const CrossBlitKernels::Params &params, const CrossBlitKernels::Row &row) {
+	if (params.srcBytesPerPixel == 2) {
+		if (params.dstBytesPerPixel == 2)
+			convertRow<2, 2>(params, row);
+		else
+			convertRow<2, 4>(params, row);
+	} else {
+		if (params.dstBytesPerPixel == 2)
+			convertRow<4, 2>(params, row);
+		else
+			convertRow<4, 4>(params, row);
+	}
+}
+
+}; // End of class CrossBlitKernelsImpl_SSE2
+
+// There is no gather instruction to look up the map, which the scalar
+// code already does with a single load per pixel
+const CrossBlitKernels::Table CrossBlitKernels::sse2 = {
+	CrossBlitKernelsImpl_SSE2::convert,
+	nullptr
+};
+
+} // End of namespace Graphics
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
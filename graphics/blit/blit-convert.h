@@ -0,0 +1,150 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHICS_BLIT_BLIT_CONVERT_H
+#define GRAPHICS_BLIT_BLIT_CONVERT_H
+
+#include "common/cpu-kernels.h"
+#include "common/scummsys.h"
+
+namespace Graphics {
+
+struct PixelFormat;
+
+/**
+ * SIMD versions of the rows of crossBlit() and crossBlitMap(), and of
+ * their variants with a color key or a mask.
+ *
+ * The kernels convert between any 16 and 32 bits per pixel formats whose
+ * source components have 0 or 4 to 8 bits, which includes RGB565, RGB555,
+ * RGBA4444 and all the 8 bits per component formats. They compute the same
+ * colors as PixelFormat::colorToARGB() followed by ARGBToColor().
+ */
+class CrossBlitKernels {
+public:
+	/** How a component is moved from the source to the destination color. */
+	struct Channel {
+		/** The component is (color >> srcShift) & srcMask... */
+		byte srcShift;
+		uint32 srcMask;
+		/** ...expanded to 8 bits as (c << expandLeft) | (c >> expandRight)... */
+		byte expandLeft, expandRight;
+		/** ...and stored as (c >> dstLoss) << dstShift. */
+		byte dstLoss, dstShift;
+	};
+
+	struct Params {
+		/**
+		 * Set up the conversion between two formats.
+		 *
+		 * @return false if the kernels cannot convert between the formats
+		 */
+		bool init(const PixelFormat &srcFmt, const PixelFormat &dstFmt);
+
+		/**
+		 * Set up the conversion of palette indices through a map, as
+		 * built by convertPaletteToMap().
+		 *
+		 * @return false if the kernels cannot write pixels of this size
+		 */
+		bool initMap(const uint32 *colorMap, uint bytesPerPixel);
+
+		/** Convert a single color, for the end of the rows. */
+		uint32 convert(uint32 color) const {
+			if (map)
+				return map[color];
+
+			uint32 result = fill;
+			for (uint i = 0; i < numChannels; i++) {
+				const Channel &c = channels[i];
+				const uint32 v = (color >> c.srcShift) & c.srcMask;
+				result |= (((v << c.expandLeft) | (v >> c.expandRight)) >> c.dstLoss) << c.dstShift;
+			}
+			return result;
+		}
+
+		byte srcBytesPerPixel, dstBytesPerPixel;
+
+		/** The components present in both formats */
+		Channel channels[4];
+		uint numChannels;
+		/** The bits set in every result, for a source without alpha */
+		uint32 fill;
+
+		/** The palette of crossBlitMap(), or nullptr to convert between formats */
+		const uint32 *map;
+
+		/** Skip the source pixels of this color */
+		bool hasKey;
+		uint32 key;
+	};
+
+	/** A row of pixels to convert. */
+	struct Row {
+		byte *dst;
+		const byte *src;
+		/** Skip the pixels whose mask value is 0, unless this is nullptr */
+		const byte *mask;
+		uint width;
+	};
+
+	/**
+	 * Convert a row of pixels. When the destination pixels are larger than
+	 * the source ones, the row is converted from its end, so that a surface
+	 * can be converted in place like crossBlit() allows.
+	 */
+	typedef void (*RowFunc)(const Params &params, const Row &row);
+
+	struct Table {
+		/** Convert between two formats, for the Params set up by init() */
+		RowFunc convert;
+		/** Convert palette indices, for the Params set up by initMap() */
+		RowFunc convertMap;
+	};
+
+	/** The per pixel loops of crossBlit() only */
+	static const Table generic;
+#ifdef SCUMMVM_NEON
+	static const Table neon;
+#endif
+#ifdef SCUMMVM_SSE2
+	static const Table sse2;
+#endif
+#ifdef SCUMMVM_AVX2
+	static const Table avx2;
+#endif
+
+	/** The kernels in use, see Common::CpuKernels. */
+	static const Table *kernels;
+
+	static const Table &get() { return Common::CpuKernels<CrossBlitKernels>::get(); }
+
+	/**
+	 * Convert the pixels [start, end) of a row one by one, in the same
+	 * order as the RowFunc does. The kernels use this for the pixels left
+	 * at the end of the rows.
+	 */
+	static void convertPixels(const Params &params, const Row &row, uint start, uint end);
+};
+
+} // End of namespace Graphics
+
+#endif
@@ -20,8 +20,10 @@
  */
 
 #include "graphics/blit.h"
+#include "graphics/blit/blit-convert.h"
 #include "graphics/pixelformat.h"
 #include "common/endian.h"
+#include "common/system.h"
 
 namespace Graphics {
 
@@ -163,8 +165,119 @@ bool maskBlit(byte *dst, const byte *src, const byte *mask,
 	return true;
 }
 
+bool CrossBlitKernels::Params::init(const PixelFormat &srcFmt, const PixelFormat &dstFmt) {
+	if ((srcFmt.bytesPerPixel != 2 && srcFmt.bytesPerPixel != 4) ||
+	    (dstFmt.bytesPerPixel != 2 && dstFmt.bytesPerPixel != 4))
+		return false;
+
+	srcBytesPerPixel = srcFmt.bytesPerPixel;
+	dstBytesPerPixel = dstFmt.bytesPerPixel;
+	numChannels = 0;
+	fill = 0;
+	map = nullptr;
+	hasKey = false;
+	key = 0;
+
+	const byte srcBits[4] = { srcFmt.aBits(), srcFmt.rBits(), srcFmt.gBits(), srcFmt.bBits() };
+	const byte srcShifts[4] = { srcFmt.aShift, srcFmt.rShift, srcFmt.gShift, srcFmt.bShift };
+	const byte dstLosses[4] = { dstFmt.aLoss, dstFmt.rLoss, dstFmt.gLoss, dstFmt.bLoss };
+	const byte dstShifts[4] = { dstFmt.aShift, dstFmt.rShift, dstFmt.gShift, dstFmt.bShift };
+
+	for (uint i = 0; i < 4; i++) {
+		// The destination has no room for this component
+		if (dstLosses[i] >= 8)
+			continue;
+
+		// colorToARGB() returns 0xFF for a missing alpha, and 0 for the others
+		if (srcBits[i] == 0) {
+			if (i == 0)
+				fill |= (0xFF >> dstLosses[i]) << dstShifts[i];
+			continue;
+		}
+
+		// The smaller components are expanded differently
+		if (srcBits[i] < 4 || srcBits[i] > 8)
+			return false;
+
+		Channel &c = channels[numChannels++];
+		c.srcShift = srcShifts[i];
+		c.srcMask = (1 << srcBits[i]) - 1;
+		c.expandLeft = 8 - srcBits[i];
+		c.expandRight = 2 * srcBits[i] - 8;
+		c.dstLoss = dstLosses[i];
+		c.dstShift = dstShifts[i];
+	}
+
+	return true;
+}
+
+bool CrossBlitKernels::Params::initMap(const uint32 *colorMap, uint bytesPerPixel) {
+	if (bytesPerPixel != 2 && bytesPerPixel != 4)
+		return false;
+
+	srcBytesPerPixel = 1;
+	dstBytesPerPixel = bytesPerPixel;
+	numChannels = 0;
+	fill = 0;
+	map = colorMap;
+	hasKey = false;
+	key = 0;
+	return true;
+}
+
+void CrossBlitKernels::convertPixels(const Params &params, const Row &row, uint start, uint end) {
+	const bool backward = params.dstBytesPerPixel > params.srcBytesPerPixel;
+
+	for (uint i = start; i < end; i++) {
+		const uint x = backward ? start + end - 1 - i : i;
+		const byte *src = row.src + x * params.srcBytesPerPixel;
+
+		uint32 color;
+		if (params.srcBytesPerPixel == 4)
+			color = READ_UINT32(src);
+		else if (params.srcBytesPerPixel == 2)
+			color = READ_UINT16(src);
+		else
+			color = *src;
+
+		if ((params.hasKey && color == params.key) || (row.mask && !row.mask[x]))
+			continue;
+
+		byte *dst = row.dst + x * params.dstBytesPerPixel;
+		if (params.dstBytesPerPixel == 4)
+			WRITE_UINT32(dst, params.convert(color));
+		else
+			WRITE_UINT16(dst, params.convert(color));
+	}
+}
+
+const CrossBlitKernels::Table CrossBlitKernels::generic = {
+	nullptr,
+	nullptr
+};
+
+const CrossBlitKernels::Table *CrossBlitKernels::kernels = nullptr;
+
 namespace {
 
+void crossBlitKernelRows(CrossBlitKernels::RowFunc func, const CrossBlitKernels::Params &params,
+						 byte *dst, const byte *src, const byte *mask, const uint w, const uint h,
+						 const uint srcPitch, const uint dstPitch, const uint maskPitch) {
+	// Like the loops below, start from the bottom when the destination
+	// pixels are larger, to allow converting a surface in place
+	const bool backward = params.dstBytesPerPixel > params.srcBytesPerPixel;
+
+	CrossBlitKernels::Row row;
+	row.width = w;
+	for (uint i = 0; i < h; ++i) {
+		const uint y = backward ? h - 1 - i : i;
+		row.dst = dst + y * dstPitch;
+		row.src = src + y * srcPitch;
+		row.mask = mask ? mask + y * maskPitch : nullptr;
+		func(params, row);
+	}
+}
+
 template<typename SrcColor, int SrcSize, typename DstColor, int DstSize, bool backward, bool hasKey, bool hasMask>
 inline void crossBlitLogic(byte *dst, const byte *src, const byte *mask, const uint w, const uint h,
 						   const PixelFormat &srcFmt, const PixelFormat &dstFmt,
@@ -227,6 +340,15 @@ inline bool crossBlitHelper(byte *dst, const byte *src, const byte *mask, const
 						   const PixelFormat &srcFmt, const PixelFormat &dstFmt,
 						   const uint srcPitch, const uint dstPitch, const uint maskPitch,
 						   const uint32 key) {
+	const CrossBlitKernels::Table &kernels = CrossBlitKernels::get();
+	CrossBlitKernels::Params params;
+	if (kernels.convert && params.init(srcFmt, dstFmt)) {
+		params.hasKey = hasKey;
+		params.key = key;
+		crossBlitKernelRows(kernels.convert, params, dst, src, hasMask ? mask : nullptr, w, h, srcPitch, dstPitch, maskPitch);
+		return true;
+	}
+
 	// Faster, but larger, to provide optimized handling for each case.
 	const uint srcDelta = (srcPitch - w * srcFmt.bytesPerPixel);
 	const uint dstDelta = (dstPitch - w * dstFmt.bytesPerPixel);
@@ -394,6 +516,15 @@ inline bool crossBlitMapHelperLogic(byte *dst, const byte *src, const byte *mask
 						   const uint bytesPerPixel, const uint32 *map,
 						   const uint srcPitch, const uint dstPitch, const uint maskPitch,
 						   const uint32 key) {
+	const CrossBlitKernels::Table &kernels = CrossBlitKernels::get();
+	CrossBlitKernels::Params params;
+	if (kernels.convertMap && params.initMap(map, bytesPerPixel)) {
+		params.hasKey = hasKey;
+		params.key = key;
+		crossBlitKernelRows(kernels.convertMap, params, dst, src, hasMask ? mask : nullptr, w, h, srcPitch, dstPitch, maskPitch);
+		return true;
+	}
+
 	// Faster, but larger, to provide optimized handling for each case.
 	const uint srcDelta  = (srcPitch  - w);
 	const uint dstDelta  = (dstPitch  - w * bytesPerPixel);
@@ -0,0 +1,142 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHICS_MANAGED_SURFACE_KERNELS_H
+#define GRAPHICS_MANAGED_SURFACE_KERNELS_H
+
+#include "common/cpu-kernels.h"
+#include "common/scummsys.h"
+
+namespace Graphics {
+
+struct PixelFormat;
+
+/**
+ * SIMD versions of the rows of the ManagedSurface blits which are the most
+ * used by the engines: the 8 bits per pixel transBlitFrom() with a color
+ * key, and the blitFrom() of 32 bits per pixel surfaces with alpha.
+ *
+ * The kernels compute the same pixels as the generic loops do. The pixels
+ * left at the end of the rows are blitted by the generic loops.
+ */
+class ManagedSurfaceKernels {
+public:
+	/** A row of 8 bits per pixel transBlitFrom(), without palette remapping. */
+	struct KeyedRow {
+		byte *dst;
+		const byte *src;
+		int width;
+		/** Skip the source pixels of this color */
+		byte key;
+	};
+
+	/** A 32 bits per pixel format with 8 bits per component, as the kernels use it. */
+	struct AlphaParams {
+		/**
+		 * Set up the blending of pixels of the given format.
+		 *
+		 * @return false if the format does not have 8 bits per component
+		 */
+		bool init(const PixelFormat &format);
+
+		/**
+		 * Blend a single pixel, like blitFrom() does for pixels of the same
+		 * format. The kernels use this for the pixels they cannot blend.
+		 */
+		uint32 blend(uint32 src, uint32 dst) const {
+			const byte aSrc = (src >> aShift) & 0xff;
+			if (aSrc == 0xff)
+				return src;
+			if (aSrc == 0)
+				return dst;
+
+			const byte rSrc = (src >> rShift) & 0xff;
+			const byte gSrc = (src >> gShift) & 0xff;
+			const byte bSrc = (src >> bShift) & 0xff;
+			byte aDest = (dst >> aShift) & 0xff;
+			byte rDest = (dst >> rShift) & 0xff;
+			byte gDest = (dst >> gShift) & 0xff;
+			byte bDest = (dst >> bShift) & 0xff;
+
+			if (aDest == 0xff) {
+				// Opaque target
+				rDest = static_cast<uint8>((((rDest * (255U - aSrc) + rSrc * aSrc) * (257U * 257U)) >> 24) & 0xff);
+				gDest = static_cast<uint8>((((gDest * (255U - aSrc) + gSrc * aSrc) * (257U * 257U)) >> 24) & 0xff);
+				bDest = static_cast<uint8>((((bDest * (255U - aSrc) + bSrc * aSrc) * (257U * 257U)) >> 24) & 0xff);
+			} else {
+				// Translucent target
+				double sAlpha = (double)aSrc / 255.0;
+				double dAlpha = (double)aDest / 255.0;
+				dAlpha *= (1.0 - sAlpha);
+				rDest = static_cast<uint8>((rSrc * sAlpha + rDest * dAlpha) / (sAlpha + dAlpha));
+				gDest = static_cast<uint8>((gSrc * sAlpha + gDest * dAlpha) / (sAlpha + dAlpha));
+				bDest = static_cast<uint8>((bSrc * sAlpha + bDest * dAlpha) / (sAlpha + dAlpha));
+				aDest = static_cast<uint8>(255. * (sAlpha + dAlpha));
+			}
+
+			return ((uint32)aDest << aShift) | ((uint32)rDest << rShift) |
+			       ((uint32)gDest << gShift) | ((uint32)bDest << bShift);
+		}
+
+		byte aShift, rShift, gShift, bShift;
+	};
+
+	/** A row of 32 bits per pixel blitFrom() between surfaces of the same format. */
+	struct AlphaRow {
+		uint32 *dst;
+		const uint32 *src;
+		int width;
+	};
+
+	/**
+	 * Blit the pixels at the start of a row.
+	 *
+	 * @return the number of pixels blitted, which is a multiple of the
+	 *         block size of the kernel
+	 */
+	typedef int (*KeyedRowFunc)(const KeyedRow &row);
+	typedef int (*AlphaRowFunc)(const AlphaParams &params, const AlphaRow &row);
+
+	struct Table {
+		/** 8 bits per pixel with a color key */
+		KeyedRowFunc keyed8;
+		/** 32 bits per pixel with alpha, between surfaces of the same format */
+		AlphaRowFunc alpha32;
+	};
+
+	/** The generic loops only */
+	static const Table generic;
+#ifdef SCUMMVM_NEON
+	static const Table neon;
+#endif
+#ifdef SCUMMVM_SSE2
+	static const Table sse2;
+#endif
+
+	/** The kernels in use, see Common::CpuKernels. */
+	static const Table *kernels;
+
+	static const Table &get() { return Common::CpuKernels<ManagedSurfaceKernels>::get(); }
+};
+
+} // End of namespace Graphics
+
+#endif
@@ -0,0 +1,142 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "graphics/managed_surface-kernels.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace Graphics {
+
+class ManagedSurfaceKernelsImpl_NEON {
+public:
+
+static int keyed8(const ManagedSurfaceKernels::KeyedRow &row) {
+	const uint8x16_t key = vdupq_n_u8(row.key);
+
+	int x = 0;
+	for (; x + 16 <= row.width; x += 16) {
+		const uint8x16_t src = vld1q_u8(row.src + x);
+		const uint8x16_t dst = vld1q_u8(row.dst + x);
+		vst1q_u8(row.dst + x, vbslq_u8(vceqq_u8(src, key), dst, src));
+	}
+
+	return x;
+}
+
+static inline bool allSet(uint32x4_t mask) {
+	const uint32x2_t m = vand_u32(vget_low_u32(mask), vget_high_u32(mask));
+	return (vget_lane_u32(m, 0) & vget_lane_u32(m, 1)) == 0xffffffff;
+}
+
+/** The blended components of an opaque destination: sum * 257 * 257 >> 24. */
+static inline uint8x8_t divideComponents(uint16x8_t sum) {
+	// The sum fits in 16 bits, but its product does not
+	uint32x4_t lo = vmovl_u16(vget_low_u16(sum));
+	uint32x4_t hi = vmovl_u16(vget_high_u16(sum));
+	lo = vaddq_u32(lo, vshlq_n_u32(lo, 8));
+	lo = vaddq_u32(lo, vshlq_n_u32(lo, 8));
+	hi = vaddq_u32(hi, vshlq_n_u32(hi, 8));
+	hi = vaddq_u32(hi, vshlq_n_u32(hi, 8));
+	return vshrn_n_u16(vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16)), 8);
+}
+
+static int alpha32(const ManagedSurfaceKernels::AlphaParams &params, const ManagedSurfaceKernels::AlphaRow &row) {
+	const uint32x4_t componentMask = vdupq_n_u32(0xff);
+	const int32x4_t aShift = vdupq_n_s32(-(int)params.aShift);
+	const uint32x4_t aMask = vdupq_n_u32(0xffU << params.aShift);
+
+	int x = 0;
+	for (; x + 4 <= row.width; x += 4) {
+		const uint32x4_t src = vld1q_u32(row.src + x);
+		const uint32x4_t dst = vld1q_u32(row.dst + x);
+		const uint32x4_t aSrc = vandq_u32(vshlq_u32(src, aShift), componentMask);
+		const uint32x4_t srcOpaque = vceqq_u32(aSrc, componentMask);
+		const uint32x4_t srcClear = vceqq_u32(aSrc, vdupq_n_u32(0));
+
+		if (allSet(srcOpaque)) {
+			vst1q_u32(row.dst + x, src);
+			continue;
+		}
+		if (allSet(srcClear))
+			continue;
+
+		// Translucent pixels onto translucent pixels are blended with
+		// floating point values
+		const uint32x4_t dstOpaque = vceqq_u32(vandq_u32(dst, aMask), aMask);
+		if (!allSet(vorrq_u32(vorrq_u32(srcOpaque, srcClear), dstOpaque))) {
+			for (int i = x; i < x + 4; i++)
+				row.dst[i] = params.blend(row.src[i], row.dst[i]);
+			continue;
+		}
+
+		// The alpha of each pixel for its 4 components
+		const uint8x16_t alpha = vreinterpretq_u8_u32(vmulq_n_u32(aSrc, 0x01010101));
+		const uint8x16_t invAlpha = vmvnq_u8(alpha);
+		const uint8x16_t s = vreinterpretq_u8_u32(src);
+		const uint8x16_t d = vreinterpretq_u8_u32(dst);
+		const uint16x8_t sumLo = vmlal_u8(vmull_u8(vget_low_u8(d), vget_low_u8(invAlpha)), vget_low_u8(s), vget_low_u8(alpha));
+		const uint16x8_t sumHi = vmlal_u8(vmull_u8(vget_high_u8(d), vget_high_u8(invAlpha)), vget_high_u8(s), vget_high_u8(alpha));
+		const uint32x4_t result = vreinterpretq_u32_u8(vcombine_u8(divideComponents(sumLo), divideComponents(sumHi)));
+
+		// The blending gives back the components of the opaque and clear
+		// source pixels. The alpha stays the one of the destination, except
+		// for the opaque source pixels.
+		vst1q_u32(row.dst + x, vbslq_u32(aMask, vorrq_u32(dst, srcOpaque), result));
+	}
+
+	return x;
+}
+
+}; // End of class ManagedSurfaceKernelsImpl_NEON
+
+const ManagedSurfaceKernels::Table ManagedSurfaceKernels::neon = {
+	ManagedSurfaceKernelsImpl_NEON::keyed8,
+	ManagedSurfaceKernelsImpl_NEON::alpha32
+};
+
+} // End of namespace Graphics
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
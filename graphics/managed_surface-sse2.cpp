@@ -0,0 +1,139 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/managed_surface-kernels.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Graphics {
+
+class ManagedSurfaceKernelsImpl_SSE2 {
+public:
+
+static int keyed8(const ManagedSurfaceKernels::KeyedRow &row) {
+	const __m128i key = _mm_set1_epi8((char)row.key);
+
+	int x = 0;
+	for (; x + 16 <= row.width; x += 16) {
+		const __m128i src = _mm_loadu_si128((const __m128i *)(row.src + x));
+		const __m128i dst = _mm_loadu_si128((const __m128i *)(row.dst + x));
+		const __m128i skip = _mm_cmpeq_epi8(src, key);
+		_mm_storeu_si128((__m128i *)(row.dst + x), _mm_or_si128(_mm_and_si128(skip, dst), _mm_andnot_si128(skip, src)));
+	}
+
+	return x;
+}
+
+/**
+ * Blend the components of two pixels, as 16 bits values, onto an opaque
+ * destination: (d * (255 - a) + s * a) * 257 * 257 >> 24.
+ */
+static inline __m128i blendComponents(__m128i s, __m128i d, __m128i a) {
+	const __m128i zero = _mm_setzero_si128();
+
+	// The sum fits in 16 bits, but its product does not
+	const __m128i sum = _mm_add_epi16(_mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), a)), _mm_mullo_epi16(s, a));
+	__m128i lo = _mm_unpacklo_epi16(sum, zero);
+	__m128i hi = _mm_unpackhi_epi16(sum, zero);
+	lo = _mm_add_epi32(lo, _mm_slli_epi32(lo, 8));
+	lo = _mm_add_epi32(lo, _mm_slli_epi32(lo, 8));
+	hi = _mm_add_epi32(hi, _mm_slli_epi32(hi, 8));
+	hi = _mm_add_epi32(hi, _mm_slli_epi32(hi, 8));
+	return _mm_packs_epi32(_mm_srli_epi32(lo, 24), _mm_srli_epi32(hi, 24));
+}
+
+static int alpha32(const ManagedSurfaceKernels::AlphaParams &params, const ManagedSurfaceKernels::AlphaRow &row) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i componentMask = _mm_set1_epi32(0xff);
+	const __m128i aShift = _mm_cvtsi32_si128(params.aShift);
+	const __m128i aMask = _mm_sll_epi32(componentMask, aShift);
+
+	int x = 0;
+	for (; x + 4 <= row.width; x += 4) {
+		const __m128i src = _mm_loadu_si128((const __m128i *)(row.src + x));
+		const __m128i dst = _mm_loadu_si128((const __m128i *)(row.dst + x));
+		const __m128i aSrc = _mm_and_si128(_mm_srl_epi32(src, aShift), componentMask);
+		const __m128i srcOpaque = _mm_cmpeq_epi32(aSrc, componentMask);
+		const __m128i srcClear = _mm_cmpeq_epi32(aSrc, zero);
+
+		if (_mm_movemask_epi8(srcOpaque) == 0xffff) {
+			_mm_storeu_si128((__m128i *)(row.dst + x), src);
+			continue;
+		}
+		if (_mm_movemask_epi8(srcClear) == 0xffff)
+			continue;
+
+		// Translucent pixels onto translucent pixels are blended with
+		// floating point values
+		const __m128i dstOpaque = _mm_cmpeq_epi32(_mm_and_si128(dst, aMask), aMask);
+		if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(srcOpaque, srcClear), dstOpaque)) != 0xffff) {
+			for (int i = x; i < x + 4; i++)
+				row.dst[i] = params.blend(row.src[i], row.dst[i]);
+			continue;
+		}
+
+		// The alpha of each pixel for its 4 components
+		const __m128i alpha = _mm_or_si128(aSrc, _mm_slli_epi32(aSrc, 16));
+		const __m128i lo = blendComponents(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero), _mm_unpacklo_epi32(alpha, alpha));
+		const __m128i hi = blendComponents(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero), _mm_unpackhi_epi32(alpha, alpha));
+
+		// The blending gives back the components of the opaque and clear
+		// source pixels. The alpha stays the one of the destination, except
+		// for the opaque source pixels.
+		const __m128i result = _mm_packus_epi16(lo, hi);
+		const __m128i resultAlpha = _mm_and_si128(_mm_or_si128(dst, srcOpaque), aMask);
+		_mm_storeu_si128((__m128i *)(row.dst + x), _mm_or_si128(_mm_andnot_si128(aMask, result), resultAlpha));
+	}
+
+	return x;
+}
+
+}; // End of class ManagedSurfaceKernelsImpl_SSE2
+
+const ManagedSurfaceKernels::Table ManagedSurfaceKernels::sse2 = {
+	ManagedSurfaceKernelsImpl_SSE2::keyed8,
+	ManagedSurfaceKernelsImpl_SSE2::alpha32
+};
+
+} // End of namespace Graphics
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
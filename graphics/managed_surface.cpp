@@ -20,17 +20,38 @@
  */
 
 #include "graphics/managed_surface.h"
+#include "graphics/managed_surface-kernels.h"
 #include "graphics/blit.h"
 #include "graphics/palette.h"
 #include "graphics/transform_tools.h"
 #include "common/algorithm.h"
 #include "common/textconsole.h"
 #include "common/endian.h"
+#include "common/system.h"
 
 namespace Graphics {
 
 const int SCALE_THRESHOLD = 0x100;
 
+bool ManagedSurfaceKernels::AlphaParams::init(const PixelFormat &format) {
+	if (format.bytesPerPixel != 4 || format.aBits() != 8 || format.rBits() != 8 ||
+			format.gBits() != 8 || format.bBits() != 8)
+		return false;
+
+	aShift = format.aShift;
+	rShift = format.rShift;
+	gShift = format.gShift;
+	bShift = format.bShift;
+	return true;
+}
+
+const ManagedSurfaceKernels::Table ManagedSurfaceKernels::generic = {
+	nullptr,
+	nullptr
+};
+
+const ManagedSurfaceKernels::Table *ManagedSurfaceKernels::kernels = nullptr;
+
 ManagedSurface::ManagedSurface() :
 		w(_innerSurface.w), h(_innerSurface.h), pitch(_innerSurface.pitch), format(_innerSurface.format),
 		_disposeAfterUse(DisposeAfterUse::NO), _owner(nullptr),
@@ -495,6 +516,40 @@ void ManagedSurface::blitFrom(const ManagedSurface &src, const Common::Rect &src
 		blitFromInner(src._innerSurface, srcRect, destRect, src._palette);
 }
 
+/**
+ * The unscaled blitFrom() between surfaces of the same format, which copies
+ * the pixels, or blends them when the format has alpha.
+ */
+static void blitRows(const Surface &src, const Common::Rect &srcRect, ManagedSurface &dest,
+		const Common::Rect &destRect, const ManagedSurfaceKernels::AlphaParams *alphaParams) {
+	// Clip the rows once rather than each pixel
+	const int left = MAX<int>(destRect.left, 0);
+	const int right = MIN<int>(destRect.right, dest.w);
+	if (left >= right)
+		return;
+
+	const ManagedSurfaceKernels::AlphaRowFunc kernel = alphaParams ? ManagedSurfaceKernels::get().alpha32 : nullptr;
+	const int bytesPerPixel = dest.format.bytesPerPixel;
+	const int width = right - left;
+
+	for (int destY = MAX<int>(destRect.top, 0); destY < MIN<int>(destRect.bottom, dest.h); ++destY) {
+		const byte *srcP = (const byte *)src.getBasePtr(srcRect.left + left - destRect.left, srcRect.top + destY - destRect.top);
+		byte *destP = (byte *)dest.getBasePtr(left, destY);
+
+		if (!alphaParams) {
+			// No alpha: all the pixels are opaque. The rows may overlap when
+			// blitting within the same surface
+			memmove(destP, srcP, width * bytesPerPixel);
+			continue;
+		}
+
+		ManagedSurfaceKernels::AlphaRow row = { (uint32 *)destP, (const uint32 *)srcP, width };
+		int x = kernel ? kernel(*alphaParams, row) : 0;
+		for (; x < width; x++)
+			row.dst[x] = alphaParams->blend(row.src[x], row.dst[x]);
+	}
+}
+
 void ManagedSurface::blitFromInner(const Surface &src, const Common::Rect &srcRect,
 		const Common::Rect &destRect, const Palette *srcPalette) {
 
@@ -529,6 +584,16 @@ void ManagedSurface::blitFromInner(const Surface &src, const Common::Rect &srcRe
 		alphaMask = (((static_cast<uint32>(1) << (srcFormat.aBits() - 1)) - 1) * 2 + 1) << srcFormat.aShift;
 
 	const bool noScale = scaleX == SCALE_THRESHOLD && scaleY == SCALE_THRESHOLD;
+
+	// Unscaled blits between surfaces of the same format either copy the
+	// rows, or blend them with the SIMD kernels
+	ManagedSurfaceKernels::AlphaParams alphaParams;
+	if (noScale && isSameFormat && !destFormat.isCLUT8() && (alphaMask == 0 || alphaParams.init(destFormat))) {
+		blitRows(src, srcRect, *this, destRect, alphaMask == 0 ? nullptr : &alphaParams);
+		addDirtyRect(destRect);
+		return;
+	}
+
 	for (int destY = destRect.top, scaleYCtr = 0; destY < destRect.bottom; ++destY, scaleYCtr += scaleY) {
 		if (destY < 0 || destY >= h)
 			continue;
@@ -718,6 +783,7 @@ static byte *createPaletteLookup(const Palette *srcPalette, const Palette *dstPa
 	byte *lookup = new byte[srcPalette->size()];
 	byte rSrc, gSrc, bSrc;
 	byte rDst, gDst, bDst;
+	bool identity = true;
 
 	for (uint i = 0; i < srcPalette->size(); i++) {
 		srcPalette->get(i, rSrc, gSrc, bSrc);
@@ -730,6 +796,13 @@ static byte *createPaletteLookup(const Palette *srcPalette, const Palette *dstPa
 		}
 
 		lookup[i] = dstPalette->findBestColor(rSrc, gSrc, bSrc);
+		identity = identity && lookup[i] == i;
+	}
+
+	// The palettes usually match, and the pixels can then be copied as they are
+	if (identity) {
+		delete[] lookup;
+		return nullptr;
 	}
 
 	return lookup;
@@ -793,19 +866,15 @@ void transBlitPixel<byte, byte>(byte srcVal, byte &destVal, const Graphics::Pixe
 		destVal = lookup[destVal];
 }
 
-template<typename TSRC, typename TDEST>
+template<typename TSRC, typename TDEST, bool SCALED, bool FLIPPED>
 void transBlit(const Surface &src, const Common::Rect &srcRect, ManagedSurface &dest, const Common::Rect &destRect,
-		TSRC transColor, bool flipped, uint32 srcAlpha, const Palette *srcPalette,
-		const Palette *dstPalette) {
-	int scaleX = SCALE_THRESHOLD * srcRect.width() / destRect.width();
-	int scaleY = SCALE_THRESHOLD * srcRect.height() / destRect.height();
+		uint32 transColor32, uint32 srcAlpha, const Palette *srcPalette, const byte *lookup) {
+	const TSRC transColor = transColor32;
+	const int scaleX = SCALE_THRESHOLD * srcRect.width() / destRect.width();
+	const int scaleY = SCALE_THRESHOLD * srcRect.height() / destRect.height();
 	byte rst = 0, gst = 0, bst = 0, rdt = 0, gdt = 0, bdt = 0;
 	byte r = 0, g = 0, b = 0;
 
-	byte *lookup = nullptr;
-	if (srcPalette && dstPalette)
-		lookup = createPaletteLookup(srcPalette, dstPalette);
-
 	// If we're dealing with a 32-bit source surface, we need to split up the RGB,
 	// since we'll want to find matching RGB pixels irrespective of the alpha
 	bool isSrcTrans32 = src.format.aBits() != 0 && transColor != (uint32)-1 && transColor > 0;
@@ -816,32 +885,50 @@ void transBlit(const Surface &src, const Common::Rect &srcRect, ManagedSurface &
 	if (isDestTrans32) {
 		dest.format.colorToRGB(dest.getTransparentColor(), rdt, gdt, bdt);
 	}
+	const bool hasDestTrans = dest.hasTransparentColor();
+	const uint32 destTransColor = dest.getTransparentColor();
+
+	// Clip the rows once rather than each pixel
+	const int left = MAX<int>(destRect.left, 0);
+	const int right = MIN<int>(destRect.right, dest.w);
+	if (left >= right)
+		return;
+
+	// The 8 bits rows with a color key only, which are the most common ones,
+	// have a SIMD kernel. A clear source leaves the transparent color of the
+	// destination to 0 below, and the kernel does not handle that.
+	ManagedSurfaceKernels::KeyedRowFunc kernel = nullptr;
+	if (sizeof(TSRC) == 1 && sizeof(TDEST) == 1 && !SCALED && !FLIPPED && !isSrcTrans32 &&
+			!lookup && srcAlpha != 0 && src.getPixels() != dest.getPixels())
+		kernel = ManagedSurfaceKernels::get().keyed8;
 
 	// Loop through drawing output lines
-	for (int destY = destRect.top, scaleYCtr = 0; destY < destRect.bottom; ++destY, scaleYCtr += scaleY) {
-		if (destY < 0 || destY >= dest.h)
-			continue;
+	for (int destY = MAX<int>(destRect.top, 0); destY < MIN<int>(destRect.bottom, dest.h); ++destY) {
+		const int scaleYCtr = (destY - destRect.top) * scaleY;
 		const TSRC *srcLine = (const TSRC *)src.getBasePtr(srcRect.left, scaleYCtr / SCALE_THRESHOLD + srcRect.top);
 		TDEST *destLine = (TDEST *)dest.getBasePtr(destRect.left, destY);
 
-		// Loop through drawing the pixels of the row
-		for (int destX = destRect.left, xCtr = 0, scaleXCtr = 0; destX < destRect.right; ++destX, ++xCtr, scaleXCtr += scaleX) {
-			if (destX < 0 || destX >= dest.w)
-				continue;
+		int xCtr = left - destRect.left;
+		const int xEnd = right - destRect.left;
+		if (kernel) {
+			ManagedSurfaceKernels::KeyedRow row = { (byte *)(destLine + xCtr), (const byte *)(srcLine + xCtr), xEnd - xCtr, (byte)transColor };
+			xCtr += kernel(row);
+		}
 
-			TSRC srcVal = srcLine[flipped ? src.w - scaleXCtr / SCALE_THRESHOLD - 1 : scaleXCtr / SCALE_THRESHOLD];
+		// Loop through drawing the pixels of the row
+		for (; xCtr < xEnd; ++xCtr) {
+			const int srcX = SCALED ? xCtr * scaleX / SCALE_THRESHOLD : xCtr;
+			TSRC srcVal = srcLine[FLIPPED ? src.w - srcX - 1 : srcX];
 			TDEST &destVal = destLine[xCtr];
 
-			dest.format.colorToRGB(destVal, r, g, b);
-
 			// Check if dest pixel is transparent
 			bool isDestPixelTrans = false;
 			if (isDestTrans32) {
 				dest.format.colorToRGB(destVal, r, g, b);
 				if (rdt == r && gdt == g && bdt == b)
 					isDestPixelTrans = true;
-			} else if (dest.hasTransparentColor()) {
-				isDestPixelTrans = destVal == dest.getTransparentColor();
+			} else if (hasDestTrans) {
+				isDestPixelTrans = destVal == destTransColor;
 			}
 
 			if (isSrcTrans32) {
@@ -859,14 +946,40 @@ void transBlit(const Surface &src, const Common::Rect &srcRect, ManagedSurface &
 			transBlitPixel<TSRC, TDEST>(srcVal, destVal, src.format, dest.format, srcAlpha, srcPalette, lookup);
 		}
 	}
-
-	delete[] lookup;
 }
 
-#define HANDLE_BLIT(SRC_BYTES, DEST_BYTES, SRC_TYPE, DEST_TYPE) \
-	if (src.format.bytesPerPixel == SRC_BYTES && format.bytesPerPixel == DEST_BYTES) \
-		transBlit<SRC_TYPE, DEST_TYPE>(src, srcRect, *this, destRect, transColor, flipped, srcAlpha, srcPalette, dstPalette); \
-	else
+typedef void (*TransBlitFunc)(const Surface &src, const Common::Rect &srcRect, ManagedSurface &dest, const Common::Rect &destRect,
+		uint32 transColor, uint32 srcAlpha, const Palette *srcPalette, const byte *lookup);
+
+#define TRANS_BLIT_FUNCS(SRC_TYPE, DEST_TYPE) \
+	{ { transBlit<SRC_TYPE, DEST_TYPE, false, false>, transBlit<SRC_TYPE, DEST_TYPE, false, true> }, \
+	  { transBlit<SRC_TYPE, DEST_TYPE, true, false>, transBlit<SRC_TYPE, DEST_TYPE, true, true> } }
+
+/**
+ * The transBlitFrom() loops, specialized for the source and destination
+ * pixel sizes, scaling and flipping, as [src][dest][scaled][flipped]
+ * with the pixel sizes 1, 2 and 4 bytes.
+ */
+static const TransBlitFunc transBlitFuncs[3][3][2][2] = {
+	{ TRANS_BLIT_FUNCS(uint8,  uint8), TRANS_BLIT_FUNCS(uint8,  uint16), TRANS_BLIT_FUNCS(uint8,  uint32) },
+	{ TRANS_BLIT_FUNCS(uint16, uint8), TRANS_BLIT_FUNCS(uint16, uint16), TRANS_BLIT_FUNCS(uint16, uint32) },
+	{ TRANS_BLIT_FUNCS(uint32, uint8), TRANS_BLIT_FUNCS(uint32, uint16), TRANS_BLIT_FUNCS(uint32, uint32) }
+};
+
+#undef TRANS_BLIT_FUNCS
+
+static int transBlitFuncIndex(uint bytesPerPixel) {
+	switch (bytesPerPixel) {
+	case 1:
+		return 0;
+	case 2:
+		return 1;
+	case 4:
+		return 2;
+	default:
+		return -1;
+	}
+}
 
 void ManagedSurface::transBlitFromInner(const Surface &src, const Common::Rect &srcRect,
 		const Common::Rect &destRect, uint32 transColor, bool flipped,
@@ -874,23 +987,27 @@ void ManagedSurface::transBlitFromInner(const Surface &src, const Common::Rect &
 	if (src.w == 0 || src.h == 0 || destRect.width() == 0 || destRect.height() == 0)
 		return;
 
-	HANDLE_BLIT(1, 1, uint8,  uint8)
-	HANDLE_BLIT(1, 2, uint8,  uint16)
-	HANDLE_BLIT(1, 4, uint8,  uint32)
-	HANDLE_BLIT(2, 1, uint16, uint8)
-	HANDLE_BLIT(2, 2, uint16, uint16)
-	HANDLE_BLIT(2, 4, uint16, uint32)
-	HANDLE_BLIT(4, 1, uint32, uint8)
-	HANDLE_BLIT(4, 2, uint32, uint16)
-	HANDLE_BLIT(4, 4, uint32, uint32)
-	error("Surface::transBlitFrom: bytesPerPixel must be 1, 2, or 4");
+	const int srcIndex = transBlitFuncIndex(src.format.bytesPerPixel);
+	const int destIndex = transBlitFuncIndex(format.bytesPerPixel);
+	if (srcIndex < 0 || destIndex < 0)
+		error("Surface::transBlitFrom: bytesPerPixel must be 1, 2, or 4");
+
+	// Pick the loop once for the whole blit
+	const bool scaled = SCALE_THRESHOLD * srcRect.width() / destRect.width() != SCALE_THRESHOLD;
+	const TransBlitFunc func = transBlitFuncs[srcIndex][destIndex][scaled][flipped];
+
+	byte *lookup = nullptr;
+	if (srcPalette && dstPalette)
+		lookup = createPaletteLookup(srcPalette, dstPalette);
+
+	func(src, srcRect, *this, destRect, transColor, srcAlpha, srcPalette, lookup);
+
+	delete[] lookup;
 
 	// Mark the affected area
 	addDirtyRect(destRect);
 }
 
-#undef HANDLE_BLIT
-
 Common::Rect ManagedSurface::blendBlitTo(ManagedSurface &target,
 										 const int posX, const int posY,
 										 const int flipping,
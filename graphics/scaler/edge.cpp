@@ -3533,9 +3533,42 @@ void EdgeScaler::initTables(const uint8 *srcPtr, uint32 srcPitch,
 EdgeScaler::EdgeScaler(const Graphics::PixelFormat &format) : SourceScaler(format) {
 	_factor = 2;
 
+	_rgbTable = new int16[65536][3];
+	_greyscaleTable = new int16[3][65536];
+	_ownsTables = true;
 	initTables(0, 0, 0, 0);
 }
 
+EdgeScaler::EdgeScaler(const EdgeScaler *parent) : SourceScaler(parent->_format) {
+	_factor = parent->_factor;
+
+	_rgbTable = parent->_rgbTable;
+	_greyscaleTable = parent->_greyscaleTable;
+	_ownsTables = false;
+}
+
+EdgeScaler::~EdgeScaler() {
+	for (uint i = 0; i < _bandScalers.size(); i++)
+		delete _bandScalers[i];
+
+	if (_ownsTables) {
+		delete[] _rgbTable;
+		delete[] _greyscaleTable;
+	}
+}
+
+void EdgeScaler::beginBands(uint numBands) {
+	while (_bandScalers.size() + 1 < numBands)
+		_bandScalers.push_back(new EdgeScaler(this));
+
+	for (uint i = 0; i < _bandScalers.size(); i++)
+		_bandScalers[i]->_factor = _factor;
+}
+
+SourceScaler *EdgeScaler::getBandScaler(uint band) {
+	return band ? _bandScalers[band - 1] : this;
+}
+
 #if 0
 void EdgeScaler::scale(const uint8 *srcPtr, uint32 srcPitch,
 					   uint8 *dstPtr, uint32 dstPitch, int width, int height, int x, int y) {
@@ -27,11 +27,16 @@ class EdgeScaler : public SourceScaler {
 public:
 
 	EdgeScaler(const Graphics::PixelFormat &format);
+	~EdgeScaler() override;
 	uint increaseFactor() override;
 	uint decreaseFactor() override;
 
 protected:
 
+	bool canScaleInBands() const override { return true; }
+	void beginBands(uint numBands) override;
+	SourceScaler *getBandScaler(uint band) override;
+
 	virtual void internScale(const uint8 *srcPtr, uint32 srcPitch,
 						   uint8 *dstPtr, uint32 dstPitch,
 						   const uint8 *oldSrcPtr, uint32 oldSrcPitch,
@@ -39,6 +44,12 @@ protected:
 
 private:
 
+	/**
+	 * Create a scaler for the bands of @p parent, with its own state for
+	 * the pixel being scaled but sharing the lookup tables of the parent.
+	 */
+	explicit EdgeScaler(const EdgeScaler *parent);
+
 	/**
 	 * Choose greyscale bitplane to use, return diff array.  Exit early and
 	 * return NULL for a block of solid color (all diffs zero).
@@ -160,8 +171,10 @@ private:
 		const uint8* oldSrc, int oldPitch,
 		const uint8 *buffer, int bufferPitch);
 
-	int16 _rgbTable[65536][3];       ///< table lookup for RGB
-	int16 _greyscaleTable[3][65536]; ///< greyscale tables
+	int16 (*_rgbTable)[3];                 ///< table lookup for RGB, 65536 entries
+	int16 (*_greyscaleTable)[65536];       ///< 3 greyscale tables
+	bool _ownsTables;                      ///< false for the scalers of the bands
+	Common::Array<EdgeScaler *> _bandScalers; ///< scalers for the bands after the first one
 	int16 *_chosenGreyscale;               ///< pointer to chosen greyscale table
 	int16 *_bptr;                          ///< too awkward to pass variables
 	int8 _simSum;                          ///< sum of similarity matrix
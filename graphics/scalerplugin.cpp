@@ -20,6 +20,9 @@
 
 #include "graphics/scalerplugin.h"
 
+#include "common/config-manager.h"
+#include "common/workerpool.h"
+
 namespace {
 /**
  * Trivial 'scaler' - in fact it doesn't do any scaling but just copies the
@@ -42,6 +45,44 @@ void Normal1x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPit
 }
 } // End of anonymous namespace
 
+class Scaler::BandJob : public Common::WorkerJob {
+public:
+	BandJob(Scaler *scaler, uint band, const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
+	        uint32 dstPitch, int width, int height, int x, int y) :
+		_scaler(scaler), _band(band), _srcPtr(srcPtr), _srcPitch(srcPitch), _dstPtr(dstPtr),
+		_dstPitch(dstPitch), _width(width), _height(height), _x(x), _y(y) {}
+
+	void run() override {
+		_scaler->scaleBand(_band, _srcPtr, _srcPitch, _dstPtr, _dstPitch, _width, _height, _x, _y);
+	}
+
+private:
+	Scaler *_scaler;
+	uint _band;
+	const uint8 *_srcPtr;
+	uint32 _srcPitch;
+	uint8 *_dstPtr;
+	uint32 _dstPitch;
+	int _width, _height;
+	int _x, _y;
+};
+
+Scaler::~Scaler() {
+	delete _pool;
+}
+
+void Scaler::setThreadCount(uint numThreads) {
+	delete _pool;
+	_pool = nullptr;
+
+	if (numThreads == 0)
+		numThreads = Common::WorkerPool::getDefaultThreadCount();
+	_numThreads = MAX<uint>(numThreads, 1);
+
+	if (_numThreads > 1)
+		_pool = new Common::WorkerPool(_numThreads);
+}
+
 void Scaler::scale(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
 	                           uint32 dstPitch, int width, int height, int x, int y) {
 	if (_factor == 1) {
@@ -53,10 +94,42 @@ void Scaler::scale(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
 			Normal1x<uint32>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 		}
 	} else {
-		scaleIntern(srcPtr, srcPitch, dstPtr, dstPitch, width, height, x, y);
+		uint numBands = 1;
+		if (height >= 2 * kMinBandHeight && canScaleInBands()) {
+			if (!_numThreads) {
+				setThreadCount(ConfMan.hasKey("scaler_threads") ? MAX(ConfMan.getInt("scaler_threads"), 0) : 0);
+				// Without threads, the bands would only add overhead
+				if (_pool && _pool->getThreadCount() == 0)
+					setThreadCount(1);
+			}
+			if (_pool)
+				numBands = MIN<uint>(_numThreads, height / kMinBandHeight);
+		}
+
+		if (numBands > 1)
+			scaleInBands(numBands, srcPtr, srcPitch, dstPtr, dstPitch, width, height, x, y);
+		else
+			scaleIntern(srcPtr, srcPitch, dstPtr, dstPitch, width, height, x, y);
 	}
 }
 
+void Scaler::scaleInBands(uint numBands, const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
+                          uint32 dstPitch, int width, int height, int x, int y) {
+	beginBands(numBands);
+
+	int top = 0;
+	for (uint band = 0; band < numBands; band++) {
+		const int bottom = height * (band + 1) / numBands;
+		_pool->submit(new BandJob(this, band, srcPtr + top * srcPitch, srcPitch,
+		                          dstPtr + top * _factor * dstPitch, dstPitch,
+		                          width, bottom - top, x, y + top));
+		top = bottom;
+	}
+	_pool->wait();
+
+	endBands(srcPtr, srcPitch, width, height, x, y);
+}
+
 SourceScaler::SourceScaler(const Graphics::PixelFormat &format) : Scaler(format), _width(0), _height(0), _oldSrc(NULL), _enable(false) {
 }
 
@@ -95,22 +168,30 @@ uint SourceScaler::setFactor(uint factor) {
 
 void SourceScaler::scaleIntern(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
 						 uint32 dstPitch, int width, int height, int x, int y) {
+	scaleBand(0, srcPtr, srcPitch, dstPtr, dstPitch, width, height, x, y);
+	endBands(srcPtr, srcPitch, width, height, x, y);
+}
+
+void SourceScaler::scaleBand(uint band, const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
+						 uint32 dstPitch, int width, int height, int x, int y) {
+	SourceScaler *scaler = getBandScaler(band);
+
 	if (!_enable) {
 		// Do not pass _oldSrc, do not update _oldSrc
-		internScale(srcPtr, srcPitch,
-		            dstPtr, dstPitch,
-		            NULL, 0,
-		            width, height,
-		            NULL, 0);
+		scaler->internScale(srcPtr, srcPitch,
+		                    dstPtr, dstPitch,
+		                    NULL, 0,
+		                    width, height,
+		                    NULL, 0);
 		return;
 	}
 	int offset = (_padding + x) * _format.bytesPerPixel + (_padding + y) * srcPitch;
 	// Call user defined scale function
-	internScale(srcPtr, srcPitch,
-	            dstPtr, dstPitch,
-	            _oldSrc + offset, srcPitch,
-	            width, height,
-	            (uint8 *)_bufferedOutput.getBasePtr(x * _factor, y * _factor), _bufferedOutput.pitch);
+	scaler->internScale(srcPtr, srcPitch,
+	                    dstPtr, dstPitch,
+	                    _oldSrc + offset, srcPitch,
+	                    width, height,
+	                    (uint8 *)_bufferedOutput.getBasePtr(x * _factor, y * _factor), _bufferedOutput.pitch);
 
 	// Update the destination buffer
 	byte *buffer = (byte *)_bufferedOutput.getBasePtr(x * _factor, y * _factor);
@@ -119,8 +200,14 @@ void SourceScaler::scaleIntern(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstP
 		buffer += _bufferedOutput.pitch;
 		dstPtr += dstPitch;
 	}
+}
+
+void SourceScaler::endBands(const uint8 *srcPtr, uint32 srcPitch, int width, int height, int x, int y) {
+	if (!_enable)
+		return;
 
 	// Update old src
+	int offset = (_padding + x) * _format.bytesPerPixel + (_padding + y) * srcPitch;
 	byte *oldSrc = _oldSrc + offset;
 	while (height--) {
 		memcpy(oldSrc, srcPtr, width * _format.bytesPerPixel);
@@ -128,4 +215,3 @@ void SourceScaler::scaleIntern(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstP
 		srcPtr += srcPitch;
 	}
 }
-
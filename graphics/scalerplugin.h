@@ -25,14 +25,21 @@
 #include "graphics/pixelformat.h"
 #include "graphics/surface.h"
 
+namespace Common {
+class WorkerPool;
+}
+
 class Scaler {
 public:
-	Scaler(const Graphics::PixelFormat &format) : _format(format) {}
-	virtual ~Scaler() {}
+	Scaler(const Graphics::PixelFormat &format) : _format(format), _numThreads(0), _pool(nullptr) {}
+	virtual ~Scaler();
 
 	/**
 	 * Scale a rect.
 	 *
+	 * Scalers which support it scale large rects in horizontal bands, on
+	 * several threads at once (see setThreadCount).
+	 *
 	 * @param srcPtr   Pointer to the source buffer.
 	 * @param srcPitch The number of bytes in a scanline of the source.
 	 * @param dstPtr   Pointer to the destination buffer.
@@ -94,6 +101,17 @@ public:
 		assert(0);
 	}
 
+	/**
+	 * Set the number of threads used to scale large rects.
+	 *
+	 * By default, this is read from the "scaler_threads" setting the first
+	 * time it is needed.
+	 *
+	 * @param numThreads 0 uses one thread per CPU core, 1 scales everything
+	 *                   on the calling thread.
+	 */
+	void setThreadCount(uint numThreads);
+
 protected:
 	/**
 	 * @see scale
@@ -101,8 +119,55 @@ protected:
 	virtual void scaleIntern(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
 	                         uint32 dstPitch, int width, int height, int x, int y) = 0;
 
+	/**
+	 * Return true if different bands of a rect can be scaled at the same
+	 * time by scaleBand.
+	 *
+	 * The bands only split the destination: each band still reads the
+	 * source pixels around it (up to ScalerPluginObject::extraPixels), which
+	 * are never written while scaling.
+	 */
+	virtual bool canScaleInBands() const { return false; }
+
+	/**
+	 * Prepare for scaling a rect in @p numBands bands. This is called on the
+	 * calling thread before any band is scaled.
+	 */
+	virtual void beginBands(uint numBands) {}
+
+	/**
+	 * Scale the band number @p band of a rect. This is called on the worker
+	 * threads, at the same time for all the bands.
+	 */
+	virtual void scaleBand(uint band, const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
+	                       uint32 dstPitch, int width, int height, int x, int y) {
+		scaleIntern(srcPtr, srcPitch, dstPtr, dstPitch, width, height, x, y);
+	}
+
+	/**
+	 * Finish scaling a rect once all its bands have been scaled. This is
+	 * called on the calling thread.
+	 */
+	virtual void endBands(const uint8 *srcPtr, uint32 srcPitch, int width, int height, int x, int y) {}
+
 	uint _factor;
 	Graphics::PixelFormat _format;
+
+private:
+	class BandJob;
+
+	enum {
+		/** Rects are not split into bands of less rows than this */
+		kMinBandHeight = 16
+	};
+
+	void scaleInBands(uint numBands, const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
+	                  uint32 dstPitch, int width, int height, int x, int y);
+
+	/** Number of threads to use, 0 until it has been set */
+	uint _numThreads;
+	/** Worker threads, or nullptr to scale everything on the calling thread */
+	Common::WorkerPool *_pool;
 };
 
 /**
@@ -127,6 +192,22 @@ protected:
 	virtual void scaleIntern(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
 	                         uint32 dstPitch, int width, int height, int x, int y) final;
 
+	/**
+	 * Scale a band with internScale. The old source is only updated by
+	 * endBands, as the bands compare the rows around them with it.
+	 */
+	virtual void scaleBand(uint band, const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
+	                       uint32 dstPitch, int width, int height, int x, int y) override final;
+
+	virtual void endBands(const uint8 *srcPtr, uint32 srcPitch, int width, int height, int x, int y) override final;
+
+	/**
+	 * Return the scaler whose internScale draws the band number @p band.
+	 * Scalers which keep some state while scaling return a different
+	 * instance for each band.
+	 */
+	virtual SourceScaler *getBandScaler(uint band) { return this; }
+
 	/**
 	 * Scalers must implement this function. It will be called by oldSrcScale.
 	 * If by comparing the src and oldsrc images it is discovered that no change
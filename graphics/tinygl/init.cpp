@@ -27,6 +27,8 @@
 
 #include "common/singleton.h"
 #include "common/array.h"
+#include "common/config-manager.h"
+#include "common/workerpool.h"
 
 #include "graphics/tinygl/tinygl.h"
 #include "graphics/tinygl/zgl.h"
@@ -363,9 +365,27 @@ void GLContext::init(int screenW, int screenH, Graphics::PixelFormat pixelFormat
 	_drawCallAllocator[1].initialize(drawCallMemorySize);
 	_debugRectsEnabled = false;
 	_profilingEnabled = false;
+
+	// 0 uses one thread per CPU core
+	int numThreads = ConfMan.hasKey("tinygl_threads") ? ConfMan.getInt("tinygl_threads") : 0;
+	if (numThreads <= 0)
+		numThreads = Common::WorkerPool::getDefaultThreadCount();
+
+	_isTileContext = false;
+	_tileRenderer = nullptr;
+	if (numThreads > 1) {
+		_tileRenderer = new TileRenderer(this, numThreads);
+		if (_tileRenderer->getThreadCount() == 0) {
+			delete _tileRenderer;
+			_tileRenderer = nullptr;
+		}
+	}
 }
 
 void GLContext::deinit() {
+	delete _tileRenderer;
+	_tileRenderer = nullptr;
+
 	disposeDrawCallLists();
 	disposeResources();
 
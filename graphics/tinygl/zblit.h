@@ -30,6 +30,7 @@
 namespace TinyGL {
 
 struct BlitImage;
+struct GLContext;
 
 namespace Internal {
 	/**
@@ -38,12 +39,13 @@ namespace Internal {
 	void tglCleanupImages(); // This function checks if any blit image is to be cleaned up and deletes it.
 
 	// Documentation for those is the same as the one before, only those function are the one that actually execute the correct code path.
-	void tglBlit(BlitImage *blitImage, const BlitTransform &transform);
+	// They draw into the frame buffer of the given context.
+	void tglBlit(GLContext *c, BlitImage *blitImage, const BlitTransform &transform);
 
 	// Disables blending, transforms and tinting.
-	void tglBlitFast(BlitImage *blitImage, int x, int y);
+	void tglBlitFast(GLContext *c, BlitImage *blitImage, int x, int y);
 
-	void tglBlitZBuffer(BlitImage *blitImage, int x, int y);
+	void tglBlitZBuffer(GLContext *c, BlitImage *blitImage, int x, int y);
 
 } // end of namespace Internal
 
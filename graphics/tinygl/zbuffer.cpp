@@ -56,15 +56,30 @@ FrameBuffer::FrameBuffer(int width, int height, const Graphics::PixelFormat &for
 	_currentTexture = nullptr;
 
 	_clippingEnabled = false;
+
+	_parent = nullptr;
+}
+
+FrameBuffer::FrameBuffer(const FrameBuffer *parent) : _parent(parent) {
+	syncWithParent();
 }
 
 FrameBuffer::~FrameBuffer() {
+	if (_parent)
+		return;
+
 	gl_free(_pbuf);
 	gl_free(_zbuf);
 	if (_sbuf)
 		gl_free(_sbuf);
 }
 
+void FrameBuffer::syncWithParent() {
+	const FrameBuffer *parent = _parent;
+	*this = *parent;
+	_parent = parent;
+}
+
 Buffer *FrameBuffer::genOffscreenBuffer() {
 	Buffer *buf = (Buffer *)gl_malloc(sizeof(Buffer));
 	buf->pbuf = (byte *)gl_zalloc(_pbufHeight * _pbufPitch);
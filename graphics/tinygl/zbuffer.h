@@ -31,6 +31,7 @@
 #include "graphics/surface.h"
 #include "graphics/tinygl/texelbuffer.h"
 #include "graphics/tinygl/gl.h"
+#include "graphics/tinygl/zspan.h"
 
 #include "common/rect.h"
 #include "common/textconsole.h"
@@ -105,8 +106,18 @@ struct ZBufferPoint {
 
 struct FrameBuffer {
 	FrameBuffer(int width, int height, const Graphics::PixelFormat &format, bool enableStencilBuffer);
+	/**
+	 * Create a frame buffer drawing into the buffers of another one, but with
+	 * its own render state. The buffers stay owned by the parent.
+	 */
+	explicit FrameBuffer(const FrameBuffer *parent);
 	~FrameBuffer();
 
+	/**
+	 * Copy the buffers and the render state of the parent frame buffer again.
+	 */
+	void syncWithParent();
+
 	Graphics::PixelFormat getPixelFormat() {
 		return _pbufFormat;
 	}
@@ -373,6 +384,12 @@ private:
 	template <bool kDepthWrite, bool kEnableScissor, bool kStencilEnabled, bool StippleEnabled, bool kDepthTestEnabled>
 	void putPixelDepth(uint *pz, byte *ps, int _a, int x, int y, uint &z, int &dzdx);
 
+	SpanKernels::TexturedFunc setupTexturedSpan(SpanKernels::State &state, bool depthTest, bool depthWrite, bool alphaTest, bool scissor, bool blending) const;
+
+	template <bool kSmoothMode>
+	SpanKernels::Block makeSpanBlock(int fbOffset, uint *pz, int x, int count, uint z, int dzdx, int s, int t, int dsdx, int dtdx,
+	                                 uint r, uint g, uint b, uint a, int drdx, int dgdx, int dbdx, int dadx);
+
 
 	template <bool kEnableAlphaTest>
 	FORCEINLINE void writePixel(int pixel, int value) {
@@ -820,6 +837,8 @@ private:
 	float _fogColorR;
 	float _fogColorG;
 	float _fogColorB;
+
+	const FrameBuffer *_parent;
 };
 
 // memory.c
@@ -191,12 +191,20 @@ void GLContext::presentBufferDirtyRects(Common::List<Common::Rect> &dirtyAreas)
 		}
 
 		// Execute draw calls.
-		for (auto &drawCall : _drawCallsQueue) {
-			Common::Rect drawCallRegion = drawCall->getDirtyRegion();
+		if (_tileRenderer && render_mode != TGL_SELECT) {
+			Common::List<Common::Rect> areas;
 			for (auto &rect : rectangles) {
-				Common::Rect dirtyRegion = rect.rectangle;
-				if (dirtyRegion.intersects(drawCallRegion)) {
-					drawCall->execute(true, &dirtyRegion);
+				areas.push_back(rect.rectangle);
+			}
+			_tileRenderer->execute(_drawCallsQueue, areas);
+		} else {
+			for (auto &drawCall : _drawCallsQueue) {
+				Common::Rect drawCallRegion = drawCall->getDirtyRegion();
+				for (auto &rect : rectangles) {
+					Common::Rect dirtyRegion = rect.rectangle;
+					if (dirtyRegion.intersects(drawCallRegion)) {
+						drawCall->execute(this, true, &dirtyRegion);
+					}
 				}
 			}
 		}
@@ -234,10 +242,20 @@ void GLContext::presentBufferDirtyRects(Common::List<Common::Rect> &dirtyAreas)
 }
 
 void GLContext::presentBufferSimple(Common::List<Common::Rect> &dirtyAreas) {
-	dirtyAreas.push_back(Common::Rect(fb->getPixelBufferWidth(), fb->getPixelBufferHeight()));
+	const Common::Rect area(fb->getPixelBufferWidth(), fb->getPixelBufferHeight());
+	dirtyAreas.push_back(area);
+
+	if (_tileRenderer && render_mode != TGL_SELECT) {
+		Common::List<Common::Rect> areas;
+		areas.push_back(area);
+		_tileRenderer->execute(_drawCallsQueue, areas);
+	} else {
+		for (const auto &drawCall : _drawCallsQueue) {
+			drawCall->execute(this, true);
+		}
+	}
 
 	for (const auto &drawCall : _drawCallsQueue) {
-		drawCall->execute(true);
 		delete drawCall;
 	}
 
@@ -262,6 +280,152 @@ void presentBuffer() {
 	presentBuffer(dirtyAreas);
 }
 
+class TileRenderer::TileJob : public Common::WorkerJob {
+public:
+	TileJob(TileRenderer *renderer, GLContext *tileContext) : _renderer(renderer), _tileContext(tileContext) {}
+
+	void run() override {
+		_renderer->drawTiles(_tileContext);
+	}
+
+private:
+	TileRenderer *_renderer;
+	GLContext *_tileContext;
+};
+
+TileRenderer::TileRenderer(GLContext *c, uint numThreads) : _context(c), _pool(numThreads) {
+	// Without worker threads, the tiles are drawn one after the other
+	const uint numTileContexts = MAX<uint>(_pool.getThreadCount(), 1);
+	for (uint i = 0; i < numTileContexts; i++) {
+		GLContext *tileContext = new GLContext();
+		tileContext->fb = new FrameBuffer(c->fb);
+		tileContext->_isTileContext = true;
+		_tileContexts.push_back(tileContext);
+	}
+}
+
+TileRenderer::~TileRenderer() {
+	for (auto &tileContext : _tileContexts) {
+		delete tileContext->fb;
+		delete tileContext;
+	}
+}
+
+void TileRenderer::syncTileContext(GLContext *tileContext) const {
+	const GLContext *c = _context;
+
+	// The frame buffer may have been switched to an offscreen buffer since
+	// the last frame, so the view into it is refreshed as well.
+	tileContext->fb->syncWithParent();
+	tileContext->renderRect = c->renderRect;
+	tileContext->render_mode = c->render_mode;
+	tileContext->vertex_n = c->vertex_n;
+	tileContext->current_cull_face = c->current_cull_face;
+	tileContext->_profilingEnabled = c->_profilingEnabled;
+
+	// Executing a draw call restores this state afterwards, like it does on
+	// the main context, so it has to match the one of the main context.
+	tileContext->scissor_test_enabled = c->scissor_test_enabled;
+	memcpy(tileContext->scissor, c->scissor, sizeof(c->scissor));
+	tileContext->blending_enabled = c->blending_enabled;
+	tileContext->source_blending_factor = c->source_blending_factor;
+	tileContext->destination_blending_factor = c->destination_blending_factor;
+	tileContext->alpha_test_enabled = c->alpha_test_enabled;
+	tileContext->alpha_test_func = c->alpha_test_func;
+	tileContext->alpha_test_ref_val = c->alpha_test_ref_val;
+	tileContext->depth_test_enabled = c->depth_test_enabled;
+	tileContext->depth_func = c->depth_func;
+	tileContext->depth_write_mask = c->depth_write_mask;
+	tileContext->stencil_test_enabled = c->stencil_test_enabled;
+	tileContext->stencil_test_func = c->stencil_test_func;
+	tileContext->stencil_ref_val = c->stencil_ref_val;
+	tileContext->stencil_mask = c->stencil_mask;
+	tileContext->stencil_write_mask = c->stencil_write_mask;
+	tileContext->stencil_sfail = c->stencil_sfail;
+	tileContext->stencil_dpfail = c->stencil_dpfail;
+	tileContext->stencil_dppass = c->stencil_dppass;
+	tileContext->polygon_stipple_enabled = c->polygon_stipple_enabled;
+	memcpy(tileContext->polygon_stipple_pattern, c->polygon_stipple_pattern, sizeof(c->polygon_stipple_pattern));
+	tileContext->offset_states = c->offset_states;
+	tileContext->offset_factor = c->offset_factor;
+	tileContext->offset_units = c->offset_units;
+	tileContext->cull_face_enabled = c->cull_face_enabled;
+	tileContext->begin_type = c->begin_type;
+	tileContext->color_mask_red = c->color_mask_red;
+	tileContext->color_mask_green = c->color_mask_green;
+	tileContext->color_mask_blue = c->color_mask_blue;
+	tileContext->color_mask_alpha = c->color_mask_alpha;
+	tileContext->current_front_face = c->current_front_face;
+	tileContext->current_shade_model = c->current_shade_model;
+	tileContext->polygon_mode_back = c->polygon_mode_back;
+	tileContext->polygon_mode_front = c->polygon_mode_front;
+	tileContext->texture_2d_enabled = c->texture_2d_enabled;
+	tileContext->current_texture = c->current_texture;
+	tileContext->texture_wrap_s = c->texture_wrap_s;
+	tileContext->texture_wrap_t = c->texture_wrap_t;
+	tileContext->lighting_enabled = c->lighting_enabled;
+	tileContext->fog_enabled = c->fog_enabled;
+	tileContext->fog_color = c->fog_color;
+	tileContext->viewport = c->viewport;
+}
+
+void TileRenderer::execute(const Common::List<DrawCall *> &drawCalls, const Common::List<Common::Rect> &areas) {
+	const int width = _context->fb->getPixelBufferWidth();
+	const int height = _context->fb->getPixelBufferHeight();
+	const uint numTiles = (height + kTileHeight - 1) / kTileHeight;
+
+	_tiles.resize(numTiles);
+	for (uint i = 0; i < numTiles; i++) {
+		Tile &tile = _tiles[i];
+		tile.bounds = Common::Rect(0, i * kTileHeight, width, MIN<int>((i + 1) * kTileHeight, height));
+		tile.areas.clear();
+		tile.drawCalls.clear();
+
+		for (const auto &area : areas) {
+			if (area.intersects(tile.bounds))
+				tile.areas.push_back(area.findIntersectingRect(tile.bounds));
+		}
+	}
+
+	for (const auto &drawCall : drawCalls) {
+		const Common::Rect region = drawCall->getDirtyRegion();
+		if (region.isEmpty() || region.bottom <= 0 || region.top >= height)
+			continue;
+
+		const int firstTile = MAX<int>(region.top, 0) / kTileHeight;
+		const int lastTile = (MIN<int>(region.bottom, height) - 1) / kTileHeight;
+		for (int i = firstTile; i <= lastTile; i++) {
+			if (!_tiles[i].areas.empty())
+				_tiles[i].drawCalls.push_back(drawCall);
+		}
+	}
+
+	for (auto &tileContext : _tileContexts)
+		syncTileContext(tileContext);
+
+	_nextTile.store(0);
+	for (auto &tileContext : _tileContexts)
+		_pool.submit(new TileJob(this, tileContext));
+	_pool.wait();
+}
+
+void TileRenderer::drawTiles(GLContext *tileContext) {
+	for (;;) {
+		const uint32 index = _nextTile.fetchAdd(1);
+		if (index >= _tiles.size())
+			break;
+
+		const Tile &tile = _tiles[index];
+		for (const auto &drawCall : tile.drawCalls) {
+			const Common::Rect region = drawCall->getDirtyRegion();
+			for (const auto &area : tile.areas) {
+				if (area.intersects(region))
+					drawCall->execute(tileContext, true, &area);
+			}
+		}
+	}
+}
+
 bool DrawCall::operator==(const DrawCall &other) const {
 	if (_type == other._type) {
 		switch (_type) {
@@ -290,8 +454,8 @@ RasterizationDrawCall::RasterizationDrawCall() : DrawCall(DrawCall_Rasterization
 	_drawTriangleFront = c->draw_triangle_front;
 	_drawTriangleBack = c->draw_triangle_back;
 	memcpy(_vertex, c->vertex, sizeof(GLVertex) * _vertexCount);
-	_state = captureState();
-	if (c->_enableDirtyRectangles) {
+	_state = captureState(c);
+	if (c->_enableDirtyRectangles || c->_tileRenderer) {
 		computeDirtyRegion();
 	}
 }
@@ -329,20 +493,26 @@ void RasterizationDrawCall::computeDirtyRegion() {
 	}
 }
 
-void RasterizationDrawCall::execute(bool restoreState, const Common::Rect *clippingRectangle) const {
-	GLContext *c = gl_get_context();
-
+void RasterizationDrawCall::execute(GLContext *c, bool restoreState, const Common::Rect *clippingRectangle) const {
 	RasterizationDrawCall::RasterizationState backupState;
 	if (restoreState) {
-		backupState = captureState();
+		backupState = captureState(c);
 	}
-	applyState(_state, clippingRectangle);
+	applyState(c, _state, clippingRectangle);
 
 	GLVertex *prevVertex = c->vertex;
 	int prevVertexCount = c->vertex_cnt;
 
 	c->vertex = _vertex;
 	c->vertex_cnt = _vertexCount;
+
+	// Drawing temporarily changes some vertex fields, so the tile contexts,
+	// which draw the same call at the same time, work on their own copy.
+	if (c->_isTileContext) {
+		c->_tileVertices.resize(_vertexCount);
+		memcpy(c->_tileVertices.data(), _vertex, sizeof(GLVertex) * _vertexCount);
+		c->vertex = c->_tileVertices.data();
+	}
 	c->draw_triangle_front = (gl_draw_triangle_func)_drawTriangleFront;
 	c->draw_triangle_back = (gl_draw_triangle_func)_drawTriangleBack;
 
@@ -425,13 +595,12 @@ void RasterizationDrawCall::execute(bool restoreState, const Common::Rect *clipp
 	c->vertex_cnt = prevVertexCount;
 
 	if (restoreState) {
-		applyState(backupState, nullptr);
+		applyState(c, backupState, nullptr);
 	}
 }
 
-RasterizationDrawCall::RasterizationState RasterizationDrawCall::captureState() const {
+RasterizationDrawCall::RasterizationState RasterizationDrawCall::captureState(GLContext *c) const {
 	RasterizationState state;
-	GLContext *c = gl_get_context();
 	state.enableScissor = c->scissor_test_enabled;
 	state.enableBlending = c->blending_enabled;
 	state.sfactor = c->source_blending_factor;
@@ -484,8 +653,7 @@ RasterizationDrawCall::RasterizationState RasterizationDrawCall::captureState()
 	return state;
 }
 
-void RasterizationDrawCall::applyState(const RasterizationDrawCall::RasterizationState &state, const Common::Rect *clippingRectangle) const {
-	GLContext *c = gl_get_context();
+void RasterizationDrawCall::applyState(GLContext *c, const RasterizationDrawCall::RasterizationState &state, const Common::Rect *clippingRectangle) const {
 	c->fb->setupScissor(state.enableScissor, state.scissor, clippingRectangle);
 	c->fb->enableBlending(state.enableBlending);
 	c->fb->setBlendingFactors(state.sfactor, state.dfactor);
@@ -568,10 +736,11 @@ bool RasterizationDrawCall::operator==(const RasterizationDrawCall &other) const
 
 
 BlittingDrawCall::BlittingDrawCall(BlitImage *image, const BlitTransform &transform, BlittingMode blittingMode) : DrawCall(DrawCall_Blitting), _transform(transform), _mode(blittingMode), _image(image) {
+	GLContext *c = gl_get_context();
 	tglIncBlitImageRef(image);
-	_blitState = captureState();
+	_blitState = captureState(c);
 	_imageVersion = tglGetBlitImageVersion(image);
-	if (gl_get_context()->_enableDirtyRectangles) {
+	if (c->_enableDirtyRectangles || c->_tileRenderer) {
 		computeDirtyRegion();
 	}
 }
@@ -580,34 +749,33 @@ BlittingDrawCall::~BlittingDrawCall() {
 	tglDeleteBlitImage(_image);
 }
 
-void BlittingDrawCall::execute(bool restoreState, const Common::Rect *clippingRectangle) const {
+void BlittingDrawCall::execute(GLContext *c, bool restoreState, const Common::Rect *clippingRectangle) const {
 	BlittingState backupState;
 	if (restoreState) {
-		backupState = captureState();
+		backupState = captureState(c);
 	}
-	applyState(_blitState, clippingRectangle);
+	applyState(c, _blitState, clippingRectangle);
 
 	switch (_mode) {
 	case BlittingDrawCall::BlitMode_Regular:
-		Internal::tglBlit(_image, _transform);
+		Internal::tglBlit(c, _image, _transform);
 		break;
 	case BlittingDrawCall::BlitMode_Fast:
-		Internal::tglBlitFast(_image, _transform._destinationRectangle.left, _transform._destinationRectangle.top);
+		Internal::tglBlitFast(c, _image, _transform._destinationRectangle.left, _transform._destinationRectangle.top);
 		break;
 	case BlittingDrawCall::BlitMode_ZBuffer:
-		Internal::tglBlitZBuffer(_image, _transform._destinationRectangle.left, _transform._destinationRectangle.top);
+		Internal::tglBlitZBuffer(c, _image, _transform._destinationRectangle.left, _transform._destinationRectangle.top);
 		break;
 	default:
 		break;
 	}
 	if (restoreState) {
-		applyState(backupState, nullptr);
+		applyState(c, backupState, nullptr);
 	}
 }
 
-BlittingDrawCall::BlittingState BlittingDrawCall::captureState() const {
+BlittingDrawCall::BlittingState BlittingDrawCall::captureState(GLContext *c) const {
 	BlittingState state;
-	TinyGL::GLContext *c = gl_get_context();
 	state.enableScissor = c->scissor_test_enabled;
 	state.enableBlending = c->blending_enabled;
 	state.sfactor = c->source_blending_factor;
@@ -621,8 +789,7 @@ BlittingDrawCall::BlittingState BlittingDrawCall::captureState() const {
 	return state;
 }
 
-void BlittingDrawCall::applyState(const BlittingState &state, const Common::Rect *clippingRectangle) const {
-	TinyGL::GLContext *c = gl_get_context();
+void BlittingDrawCall::applyState(GLContext *c, const BlittingState &state, const Common::Rect *clippingRectangle) const {
 	c->fb->setupScissor(state.enableScissor, state.scissor, clippingRectangle);
 	c->fb->enableBlending(state.enableBlending);
 	c->fb->setBlendingFactors(state.sfactor, state.dfactor);
@@ -688,38 +855,35 @@ ClearBufferDrawCall::ClearBufferDrawCall(bool clearZBuffer, int zValue,
 	: _clearZBuffer(clearZBuffer), _clearColorBuffer(clearColorBuffer), _zValue(zValue),
 	  _rValue(rValue), _gValue(gValue), _bValue(bValue), _clearStencilBuffer(clearStencilBuffer),
 	  _stencilValue(stencilValue), DrawCall(DrawCall_Clear) {
-	_clearState = captureState();
 	TinyGL::GLContext *c = gl_get_context();
-	if (c->_enableDirtyRectangles) {
+	_clearState = captureState(c);
+	if (c->_enableDirtyRectangles || c->_tileRenderer) {
 		_dirtyRegion = c->renderRect;
 	}
 }
 
-void ClearBufferDrawCall::execute(bool restoreState, const Common::Rect *clippingRectangle) const {
+void ClearBufferDrawCall::execute(GLContext *c, bool restoreState, const Common::Rect *clippingRectangle) const {
 	ClearBufferState backupState;
 	if (restoreState) {
-		backupState = captureState();
+		backupState = captureState(c);
 	}
-	applyState(_clearState, clippingRectangle);
+	applyState(c, _clearState, clippingRectangle);
 
-	TinyGL::GLContext *c = gl_get_context();
 	c->fb->clear(_clearZBuffer, _zValue, _clearColorBuffer, _rValue, _gValue, _bValue, _clearStencilBuffer, _stencilValue);
 
 	if (restoreState) {
-		applyState(backupState, nullptr);
+		applyState(c, backupState, nullptr);
 	}
 }
 
-ClearBufferDrawCall::ClearBufferState ClearBufferDrawCall::captureState() const {
+ClearBufferDrawCall::ClearBufferState ClearBufferDrawCall::captureState(GLContext *c) const {
 	ClearBufferState state;
-	TinyGL::GLContext *c = gl_get_context();
 	state.enableScissor = c->scissor_test_enabled;
 	memcpy(state.scissor, c->scissor, sizeof(state.scissor));
 	return state;
 }
 
-void ClearBufferDrawCall::applyState(const ClearBufferState &state, const Common::Rect *clippingRectangle) const {
-	TinyGL::GLContext *c = gl_get_context();
+void ClearBufferDrawCall::applyState(GLContext *c, const ClearBufferState &state, const Common::Rect *clippingRectangle) const {
 	c->fb->setupScissor(state.enableScissor, state.scissor, clippingRectangle);
 
 	c->scissor_test_enabled = state.enableScissor;
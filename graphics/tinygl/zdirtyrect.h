@@ -25,6 +25,9 @@
 #include "common/types.h"
 #include "common/rect.h"
 #include "common/array.h"
+#include "common/atomic.h"
+#include "common/list.h"
+#include "common/workerpool.h"
 
 #include "graphics/tinygl/zblit.h"
 
@@ -53,7 +56,7 @@ public:
 	bool operator!=(const DrawCall &other) const {
 		return !(*this == other);
 	}
-	virtual void execute(bool restoreState, const Common::Rect *clippingRectangle = nullptr) const = 0;
+	virtual void execute(GLContext *c, bool restoreState, const Common::Rect *clippingRectangle = nullptr) const = 0;
 	DrawCallType getType() const { return _type; }
 	virtual const Common::Rect getDirtyRegion() const { return _dirtyRegion; }
 protected:
@@ -67,7 +70,7 @@ public:
 	ClearBufferDrawCall(bool clearZBuffer, int zValue, bool clearColorBuffer, int rValue, int gValue, int bValue, bool clearStencilBuffer, int stencilValue);
 	virtual ~ClearBufferDrawCall() { }
 	bool operator==(const ClearBufferDrawCall &other) const;
-	virtual void execute(bool restoreState, const Common::Rect *clippingRectangle = nullptr) const;
+	virtual void execute(GLContext *c, bool restoreState, const Common::Rect *clippingRectangle = nullptr) const;
 
 	void *operator new(size_t size) {
 		return Internal::allocateFrame(size);
@@ -91,8 +94,8 @@ private:
 		}
 	};
 
-	ClearBufferState captureState() const;
-	void applyState(const ClearBufferState &state, const Common::Rect *clippingRectangle) const;
+	ClearBufferState captureState(GLContext *c) const;
+	void applyState(GLContext *c, const ClearBufferState &state, const Common::Rect *clippingRectangle) const;
 
 	ClearBufferState _clearState;
 };
@@ -103,7 +106,7 @@ public:
 	RasterizationDrawCall();
 	virtual ~RasterizationDrawCall() { }
 	bool operator==(const RasterizationDrawCall &other) const;
-	virtual void execute(bool restoreState, const Common::Rect *clippingRectangle = nullptr) const;
+	virtual void execute(GLContext *c, bool restoreState, const Common::Rect *clippingRectangle = nullptr) const;
 
 	void *operator new(size_t size) {
 		return Internal::allocateFrame(size);
@@ -169,8 +172,8 @@ private:
 
 	RasterizationState _state;
 
-	RasterizationState captureState() const;
-	void applyState(const RasterizationState &state, const Common::Rect *clippingRectangle) const;
+	RasterizationState captureState(GLContext *c) const;
+	void applyState(GLContext *c, const RasterizationState &state, const Common::Rect *clippingRectangle) const;
 };
 
 // Encapsulate a blit call: it might execute either a color buffer or z buffer blit.
@@ -185,7 +188,7 @@ public:
 	BlittingDrawCall(BlitImage *image, const BlitTransform &transform, BlittingMode blittingMode);
 	virtual ~BlittingDrawCall();
 	bool operator==(const BlittingDrawCall &other) const;
-	virtual void execute(bool restoreState, const Common::Rect *clippingRectangle = nullptr) const;
+	virtual void execute(GLContext *c, bool restoreState, const Common::Rect *clippingRectangle = nullptr) const;
 
 	BlittingMode getBlittingMode() const { return _mode; }
 
@@ -227,12 +230,58 @@ private:
 		}
 	};
 
-	BlittingState captureState() const;
-	void applyState(const BlittingState &state, const Common::Rect *clippingRectangle) const;
+	BlittingState captureState(GLContext *c) const;
+	void applyState(GLContext *c, const BlittingState &state, const Common::Rect *clippingRectangle) const;
 
 	BlittingState _blitState;
 };
 
+/**
+ * Draws the queued draw calls of a frame on several threads.
+ *
+ * The frame buffer is split into bands of whole scan lines and every draw call
+ * is binned into the bands its dirty region overlaps. Each worker owns a tile
+ * context that shares the buffers of the main context, and draws whole bands
+ * clipped to their bounds. As the calls of a band are drawn in their original
+ * order, the result is the same as drawing them on a single thread.
+ */
+class TileRenderer {
+public:
+	TileRenderer(GLContext *c, uint numThreads);
+	~TileRenderer();
+
+	/**
+	 * Execute the draw calls, clipped to the given areas of the frame buffer.
+	 * The areas must not overlap each other.
+	 */
+	void execute(const Common::List<DrawCall *> &drawCalls, const Common::List<Common::Rect> &areas);
+
+	/** Return the number of worker threads, 0 if the backend can not create any. */
+	uint getThreadCount() const { return _pool.getThreadCount(); }
+
+private:
+	enum {
+		kTileHeight = 32
+	};
+
+	struct Tile {
+		Common::Rect bounds;
+		Common::Array<Common::Rect> areas;
+		Common::Array<DrawCall *> drawCalls;
+	};
+
+	class TileJob;
+
+	void syncTileContext(GLContext *tileContext) const;
+	void drawTiles(GLContext *tileContext);
+
+	GLContext *_context;
+	Common::Array<GLContext *> _tileContexts;
+	Common::Array<Tile> _tiles;
+	Common::Atomic<uint32> _nextTile;
+	Common::WorkerPool _pool;
+};
+
 } // end of namespace TinyGL
 
 #endif
@@ -275,6 +275,7 @@ private:
 };
 
 struct GLContext;
+class TileRenderer;
 
 typedef void (*gl_draw_triangle_func)(GLContext *c, GLVertex *p0, GLVertex *p1, GLVertex *p2);
 
@@ -469,6 +470,11 @@ struct GLContext {
 	bool _debugRectsEnabled;
 	bool _profilingEnabled;
 
+	// Parallel rendering of the draw calls, if enabled
+	TileRenderer *_tileRenderer;
+	bool _isTileContext;
+	Common::Array<GLVertex> _tileVertices;
+
 	void gl_vertex_transform(GLVertex *v);
 	void gl_calc_fog_factor(GLVertex *v);
 
@@ -0,0 +1,211 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/tinygl/zspan.h"
+#include "graphics/tinygl/gl.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace TinyGL {
+
+class SpanKernelsImpl_AVX2 {
+public:
+
+/** Returns base, base + delta, base + 2 * delta... */
+static inline __m256i ramp(uint base, int delta) {
+	const uint d = delta;
+	return _mm256_setr_epi32(base, base + d, base + 2 * d, base + 3 * d, base + 4 * d, base + 5 * d, base + 6 * d, base + 7 * d);
+}
+
+/** Compares unsigned values the way FrameBuffer::compareDepth and checkAlphaTest do. */
+static inline __m256i compare(int func, __m256i a, __m256i b) {
+	const __m256i bias = _mm256_set1_epi32((int)0x80000000);
+	const __m256i ones = _mm256_set1_epi32(-1);
+	a = _mm256_xor_si256(a, bias);
+	b = _mm256_xor_si256(b, bias);
+	switch (func) {
+	case TGL_LESS:
+		return _mm256_cmpgt_epi32(b, a);
+	case TGL_EQUAL:
+		return _mm256_cmpeq_epi32(a, b);
+	case TGL_LEQUAL:
+		return _mm256_xor_si256(_mm256_cmpgt_epi32(a, b), ones);
+	case TGL_GREATER:
+		return _mm256_cmpgt_epi32(a, b);
+	case TGL_NOTEQUAL:
+		return _mm256_xor_si256(_mm256_cmpeq_epi32(a, b), ones);
+	case TGL_GEQUAL:
+		return _mm256_xor_si256(_mm256_cmpgt_epi32(b, a), ones);
+	case TGL_ALWAYS:
+		return ones;
+	default:
+		return _mm256_setzero_si256();
+	}
+}
+
+/** The scalar code stores the depth through a float, which rounds large values. */
+static inline __m256i roundDepth(__m256i z) {
+	const __m256 hi = _mm256_cvtepi32_ps(_mm256_srli_epi32(z, 16));
+	const __m256 lo = _mm256_cvtepi32_ps(_mm256_and_si256(z, _mm256_set1_epi32(0xFFFF)));
+	const __m256 f = _mm256_add_ps(_mm256_mul_ps(hi, _mm256_set1_ps(65536.0f)), lo);
+
+	// There is no unsigned conversion, so values from 2^31 are converted
+	// from the difference to 2^31 instead
+	const __m256 two31 = _mm256_set1_ps(2147483648.0f);
+	const __m256 big = _mm256_cmp_ps(f, two31, _CMP_GE_OQ);
+	const __m256i result = _mm256_cvttps_epi32(_mm256_sub_ps(f, _mm256_and_ps(big, two31)));
+	return _mm256_xor_si256(result, _mm256_and_si256(_mm256_castps_si256(big), _mm256_set1_epi32((int)0x80000000)));
+}
+
+/** Multiplies a color component by the 16.16 fixed point light like putPixelTexture, keeping 8 bits. */
+static inline __m256i light(__m256i c, uint base, int delta) {
+	const __m256i l = _mm256_and_si256(_mm256_srli_epi32(ramp(base, delta), 8), _mm256_set1_epi32(0xFFFF));
+	return _mm256_srli_epi32(_mm256_mullo_epi16(c, l), 8);
+}
+
+static inline __m256i getComponent(__m256i pixels, int shift) {
+	return _mm256_and_si256(_mm256_srl_epi32(pixels, _mm_cvtsi32_si128(shift)), _mm256_set1_epi32(0xFF));
+}
+
+static inline __m256i putComponent(__m256i c, int shift) {
+	return _mm256_sll_epi32(c, _mm_cvtsi32_si128(shift));
+}
+
+static inline __m256i scale(__m256i c, __m256i factor) {
+	return _mm256_srli_epi32(_mm256_mullo_epi16(c, factor), 8);
+}
+
+static void textured(const SpanKernels::State &state, const SpanKernels::Block &block) {
+	uint32 *pbuf = block.pbuf;
+	uint *zbuf = block.zbuf;
+
+	// Work on a copy of partial blocks, so that no memory after the end
+	// of the scan line is touched
+	uint32 pbufCopy[SpanKernels::kBlockSize];
+	uint zbufCopy[SpanKernels::kBlockSize];
+	if (block.count < SpanKernels::kBlockSize) {
+		memset(pbufCopy, 0, sizeof(pbufCopy));
+		memset(zbufCopy, 0, sizeof(zbufCopy));
+		memcpy(pbufCopy, block.pbuf, block.count * sizeof(uint32));
+		memcpy(zbufCopy, block.zbuf, block.count * sizeof(uint));
+		pbuf = pbufCopy;
+		zbuf = zbufCopy;
+	}
+
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i x = _mm256_add_epi32(_mm256_set1_epi32(block.x), lane);
+	__m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(block.count), lane);
+	mask = _mm256_and_si256(mask, _mm256_cmpgt_epi32(x, _mm256_set1_epi32(state.clipLeft - 1)));
+	mask = _mm256_and_si256(mask, _mm256_cmpgt_epi32(_mm256_set1_epi32(state.clipRight), x));
+
+	const __m256i z = ramp(block.z, block.dzdx);
+	__m256i *zdst = (__m256i *)zbuf;
+	const __m256i oldZ = _mm256_loadu_si256(zdst);
+	if (state.depthTest)
+		mask = _mm256_and_si256(mask, compare(state.depthFunc, oldZ, z));
+
+	const uint visible = _mm256_movemask_ps(_mm256_castsi256_ps(mask));
+	if (!visible)
+		return;
+
+	uint32 texels[SpanKernels::kBlockSize];
+	SpanKernels::fetchTexels(state, block, visible, texels);
+
+	const __m256i ff = _mm256_set1_epi32(0xFF);
+	const __m256i tex = _mm256_loadu_si256((const __m256i *)texels);
+	const __m256i a = light(_mm256_srli_epi32(tex, 24), block.a, block.dadx);
+	const __m256i r = light(_mm256_and_si256(_mm256_srli_epi32(tex, 16), ff), block.r, block.drdx);
+	const __m256i g = light(_mm256_and_si256(_mm256_srli_epi32(tex, 8), ff), block.g, block.dgdx);
+	const __m256i b = light(_mm256_and_si256(tex, ff), block.b, block.dbdx);
+
+	if (state.alphaTest)
+		mask = _mm256_and_si256(mask, compare(state.alphaFunc, a, _mm256_set1_epi32(state.alphaRef)));
+
+	if (state.depthWrite)
+		_mm256_storeu_si256(zdst, _mm256_blendv_epi8(oldZ, roundDepth(z), mask));
+
+	__m256i *dst = (__m256i *)pbuf;
+	const __m256i old = _mm256_loadu_si256(dst);
+	__m256i color;
+	if (!state.blending) {
+		color = _mm256_or_si256(_mm256_or_si256(putComponent(r, state.rShift), putComponent(g, state.gShift)), putComponent(b, state.bShift));
+		if (state.hasAlpha)
+			color = _mm256_or_si256(color, putComponent(a, state.aShift));
+	} else {
+		__m256i sr = r, sg = g, sb = b;
+		if (state.srcAlpha) {
+			sr = scale(sr, a);
+			sg = scale(sg, a);
+			sb = scale(sb, a);
+		}
+
+		__m256i dr, dg, db;
+		if (state.dstFactor == TGL_ZERO) {
+			dr = dg = db = _mm256_setzero_si256();
+		} else {
+			dr = getComponent(old, state.rShift);
+			dg = getComponent(old, state.gShift);
+			db = getComponent(old, state.bShift);
+			if (state.dstFactor == TGL_ONE_MINUS_SRC_ALPHA) {
+				const __m256i oneMinusA = _mm256_sub_epi32(ff, a);
+				dr = scale(dr, oneMinusA);
+				dg = scale(dg, oneMinusA);
+				db = scale(db, oneMinusA);
+			}
+		}
+
+		const __m256i fr = _mm256_min_epi32(_mm256_add_epi32(dr, sr), ff);
+		const __m256i fg = _mm256_min_epi32(_mm256_add_epi32(dg, sg), ff);
+		const __m256i fb = _mm256_min_epi32(_mm256_add_epi32(db, sb), ff);
+		color = _mm256_or_si256(_mm256_or_si256(putComponent(fr, state.rShift), putComponent(fg, state.gShift)), putComponent(fb, state.bShift));
+		if (state.hasAlpha)
+			color = _mm256_or_si256(color, putComponent(ff, state.aShift));
+	}
+	_mm256_storeu_si256(dst, _mm256_blendv_epi8(old, color, mask));
+
+	if (block.count < SpanKernels::kBlockSize) {
+		memcpy(block.pbuf, pbufCopy, block.count * sizeof(uint32));
+		memcpy(block.zbuf, zbufCopy, block.count * sizeof(uint));
+	}
+}
+
+}; // End of class SpanKernelsImpl_AVX2
+
+const SpanKernels::Table SpanKernels::avx2 = {
+	SpanKernelsImpl_AVX2::textured
+};
+
+} // end of namespace TinyGL
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,220 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "graphics/tinygl/zspan.h"
+#include "graphics/tinygl/gl.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace TinyGL {
+
+class SpanKernelsImpl_NEON {
+public:
+
+/** Returns base, base + delta, base + 2 * delta... starting at lane @p first. */
+static inline uint32x4_t ramp(uint base, int delta, int first) {
+	const uint d = delta;
+	const uint32 values[4] = { base + first * d, base + (first + 1) * d, base + (first + 2) * d, base + (first + 3) * d };
+	return vld1q_u32(values);
+}
+
+/** Compares unsigned values the way FrameBuffer::compareDepth and checkAlphaTest do. */
+static inline uint32x4_t compare(int func, uint32x4_t a, uint32x4_t b) {
+	switch (func) {
+	case TGL_LESS:
+		return vcltq_u32(a, b);
+	case TGL_EQUAL:
+		return vceqq_u32(a, b);
+	case TGL_LEQUAL:
+		return vcleq_u32(a, b);
+	case TGL_GREATER:
+		return vcgtq_u32(a, b);
+	case TGL_NOTEQUAL:
+		return vmvnq_u32(vceqq_u32(a, b));
+	case TGL_GEQUAL:
+		return vcgeq_u32(a, b);
+	case TGL_ALWAYS:
+		return vdupq_n_u32(0xFFFFFFFF);
+	default:
+		return vdupq_n_u32(0);
+	}
+}
+
+/** The scalar code stores the depth through a float, which rounds large values. */
+static inline uint32x4_t roundDepth(uint32x4_t z) {
+	return vcvtq_u32_f32(vcvtq_f32_u32(z));
+}
+
+/** Multiplies a color component by the 16.16 fixed point light like putPixelTexture, keeping 8 bits. */
+static inline uint32x4_t light(uint32x4_t c, uint base, int delta, int first) {
+	const uint32x4_t l = vshrq_n_u32(ramp(base, delta, first), 8);
+	return vshrq_n_u32(vandq_u32(vmulq_u32(c, l), vdupq_n_u32(0xFFFF)), 8);
+}
+
+static inline uint32x4_t getComponent(uint32x4_t pixels, int shift) {
+	return vandq_u32(vshlq_u32(pixels, vdupq_n_s32(-shift)), vdupq_n_u32(0xFF));
+}
+
+static inline uint32x4_t putComponent(uint32x4_t c, int shift) {
+	return vshlq_u32(c, vdupq_n_s32(shift));
+}
+
+static inline uint32x4_t scale(uint32x4_t c, uint32x4_t factor) {
+	return vshrq_n_u32(vmulq_u32(c, factor), 8);
+}
+
+static void textured(const SpanKernels::State &state, const SpanKernels::Block &block) {
+	uint32 *pbuf = block.pbuf;
+	uint *zbuf = block.zbuf;
+
+	// Work on a copy of partial blocks, so that no memory after the end
+	// of the scan line is touched
+	uint32 pbufCopy[SpanKernels::kBlockSize];
+	uint zbufCopy[SpanKernels::kBlockSize];
+	if (block.count < SpanKernels::kBlockSize) {
+		memset(pbufCopy, 0, sizeof(pbufCopy));
+		memset(zbufCopy, 0, sizeof(zbufCopy));
+		memcpy(pbufCopy, block.pbuf, block.count * sizeof(uint32));
+		memcpy(zbufCopy, block.zbuf, block.count * sizeof(uint));
+		pbuf = pbufCopy;
+		zbuf = zbufCopy;
+	}
+
+	uint32x4_t mask[2], z[2];
+	for (int h = 0; h < 2; h++) {
+		const int32 lanes[4] = { h * 4, h * 4 + 1, h * 4 + 2, h * 4 + 3 };
+		const int32x4_t lane = vld1q_s32(lanes);
+		const int32x4_t x = vaddq_s32(vdupq_n_s32(block.x), lane);
+		mask[h] = vcltq_s32(lane, vdupq_n_s32(block.count));
+		mask[h] = vandq_u32(mask[h], vcgeq_s32(x, vdupq_n_s32(state.clipLeft)));
+		mask[h] = vandq_u32(mask[h], vcltq_s32(x, vdupq_n_s32(state.clipRight)));
+
+		z[h] = ramp(block.z, block.dzdx, h * 4);
+		if (state.depthTest)
+			mask[h] = vandq_u32(mask[h], compare(state.depthFunc, vld1q_u32(zbuf + h * 4), z[h]));
+	}
+
+	uint32 maskBits[SpanKernels::kBlockSize];
+	vst1q_u32(maskBits, mask[0]);
+	vst1q_u32(maskBits + 4, mask[1]);
+	uint visible = 0;
+	for (int i = 0; i < SpanKernels::kBlockSize; i++)
+		visible |= (maskBits[i] & 1) << i;
+	if (!visible)
+		return;
+
+	uint32 texels[SpanKernels::kBlockSize];
+	SpanKernels::fetchTexels(state, block, visible, texels);
+
+	const uint32x4_t ff = vdupq_n_u32(0xFF);
+	for (int h = 0; h < 2; h++) {
+		const uint32x4_t tex = vld1q_u32(texels + h * 4);
+		const uint32x4_t a = light(vshrq_n_u32(tex, 24), block.a, block.dadx, h * 4);
+		const uint32x4_t r = light(vandq_u32(vshrq_n_u32(tex, 16), ff), block.r, block.drdx, h * 4);
+		const uint32x4_t g = light(vandq_u32(vshrq_n_u32(tex, 8), ff), block.g, block.dgdx, h * 4);
+		const uint32x4_t b = light(vandq_u32(tex, ff), block.b, block.dbdx, h * 4);
+
+		uint32x4_t m = mask[h];
+		if (state.alphaTest)
+			m = vandq_u32(m, compare(state.alphaFunc, a, vdupq_n_u32(state.alphaRef)));
+
+		if (state.depthWrite)
+			vst1q_u32(zbuf + h * 4, vbslq_u32(m, roundDepth(z[h]), vld1q_u32(zbuf + h * 4)));
+
+		const uint32x4_t old = vld1q_u32(pbuf + h * 4);
+		uint32x4_t color;
+		if (!state.blending) {
+			color = vorrq_u32(vorrq_u32(putComponent(r, state.rShift), putComponent(g, state.gShift)), putComponent(b, state.bShift));
+			if (state.hasAlpha)
+				color = vorrq_u32(color, putComponent(a, state.aShift));
+		} else {
+			uint32x4_t sr = r, sg = g, sb = b;
+			if (state.srcAlpha) {
+				sr = scale(sr, a);
+				sg = scale(sg, a);
+				sb = scale(sb, a);
+			}
+
+			uint32x4_t dr, dg, db;
+			if (state.dstFactor == TGL_ZERO) {
+				dr = dg = db = vdupq_n_u32(0);
+			} else {
+				dr = getComponent(old, state.rShift);
+				dg = getComponent(old, state.gShift);
+				db = getComponent(old, state.bShift);
+				if (state.dstFactor == TGL_ONE_MINUS_SRC_ALPHA) {
+					const uint32x4_t oneMinusA = vsubq_u32(ff, a);
+					dr = scale(dr, oneMinusA);
+					dg = scale(dg, oneMinusA);
+					db = scale(db, oneMinusA);
+				}
+			}
+
+			const uint32x4_t fr = vminq_u32(vaddq_u32(dr, sr), ff);
+			const uint32x4_t fg = vminq_u32(vaddq_u32(dg, sg), ff);
+			const uint32x4_t fb = vminq_u32(vaddq_u32(db, sb), ff);
+			color = vorrq_u32(vorrq_u32(putComponent(fr, state.rShift), putComponent(fg, state.gShift)), putComponent(fb, state.bShift));
+			if (state.hasAlpha)
+				color = vorrq_u32(color, putComponent(ff, state.aShift));
+		}
+		vst1q_u32(pbuf + h * 4, vbslq_u32(m, color, old));
+	}
+
+	if (block.count < SpanKernels::kBlockSize) {
+		memcpy(block.pbuf, pbufCopy, block.count * sizeof(uint32));
+		memcpy(block.zbuf, zbufCopy, block.count * sizeof(uint));
+	}
+}
+
+}; // End of class SpanKernelsImpl_NEON
+
+const SpanKernels::Table SpanKernels::neon = {
+	SpanKernelsImpl_NEON::textured
+};
+
+} // end of namespace TinyGL
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
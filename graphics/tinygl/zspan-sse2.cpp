@@ -0,0 +1,227 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/tinygl/zspan.h"
+#include "graphics/tinygl/gl.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace TinyGL {
+
+class SpanKernelsImpl_SSE2 {
+public:
+
+/** Returns base, base + delta, base + 2 * delta... starting at lane @p first. */
+static inline __m128i ramp(uint base, int delta, int first) {
+	const uint d = delta;
+	return _mm_setr_epi32(base + first * d, base + (first + 1) * d, base + (first + 2) * d, base + (first + 3) * d);
+}
+
+/** Compares unsigned values the way FrameBuffer::compareDepth and checkAlphaTest do. */
+static inline __m128i compare(int func, __m128i a, __m128i b) {
+	const __m128i bias = _mm_set1_epi32((int)0x80000000);
+	const __m128i ones = _mm_set1_epi32(-1);
+	a = _mm_xor_si128(a, bias);
+	b = _mm_xor_si128(b, bias);
+	switch (func) {
+	case TGL_LESS:
+		return _mm_cmplt_epi32(a, b);
+	case TGL_EQUAL:
+		return _mm_cmpeq_epi32(a, b);
+	case TGL_LEQUAL:
+		return _mm_xor_si128(_mm_cmpgt_epi32(a, b), ones);
+	case TGL_GREATER:
+		return _mm_cmpgt_epi32(a, b);
+	case TGL_NOTEQUAL:
+		return _mm_xor_si128(_mm_cmpeq_epi32(a, b), ones);
+	case TGL_GEQUAL:
+		return _mm_xor_si128(_mm_cmplt_epi32(a, b), ones);
+	case TGL_ALWAYS:
+		return ones;
+	default:
+		return _mm_setzero_si128();
+	}
+}
+
+/** The scalar code stores the depth through a float, which rounds large values. */
+static inline __m128i roundDepth(__m128i z) {
+	const __m128 hi = _mm_cvtepi32_ps(_mm_srli_epi32(z, 16));
+	const __m128 lo = _mm_cvtepi32_ps(_mm_and_si128(z, _mm_set1_epi32(0xFFFF)));
+	const __m128 f = _mm_add_ps(_mm_mul_ps(hi, _mm_set1_ps(65536.0f)), lo);
+
+	// There is no unsigned conversion, so values from 2^31 are converted
+	// from the difference to 2^31 instead
+	const __m128 two31 = _mm_set1_ps(2147483648.0f);
+	const __m128 big = _mm_cmpge_ps(f, two31);
+	const __m128i result = _mm_cvttps_epi32(_mm_sub_ps(f, _mm_and_ps(big, two31)));
+	return _mm_xor_si128(result, _mm_and_si128(_mm_castps_si128(big), _mm_set1_epi32((int)0x80000000)));
+}
+
+/** Multiplies a color component by the 16.16 fixed point light like putPixelTexture, keeping 8 bits. */
+static inline __m128i light(__m128i c, uint base, int delta, int first) {
+	const __m128i l = _mm_and_si128(_mm_srli_epi32(ramp(base, delta, first), 8), _mm_set1_epi32(0xFFFF));
+	return _mm_srli_epi32(_mm_mullo_epi16(c, l), 8);
+}
+
+static inline __m128i getComponent(__m128i pixels, int shift) {
+	return _mm_and_si128(_mm_srl_epi32(pixels, _mm_cvtsi32_si128(shift)), _mm_set1_epi32(0xFF));
+}
+
+static inline __m128i putComponent(__m128i c, int shift) {
+	return _mm_sll_epi32(c, _mm_cvtsi32_si128(shift));
+}
+
+static inline __m128i scale(__m128i c, __m128i factor) {
+	return _mm_srli_epi32(_mm_mullo_epi16(c, factor), 8);
+}
+
+static void textured(const SpanKernels::State &state, const SpanKernels::Block &block) {
+	uint32 *pbuf = block.pbuf;
+	uint *zbuf = block.zbuf;
+
+	// Work on a copy of partial blocks, so that no memory after the end
+	// of the scan line is touched
+	uint32 pbufCopy[SpanKernels::kBlockSize];
+	uint zbufCopy[SpanKernels::kBlockSize];
+	if (block.count < SpanKernels::kBlockSize) {
+		memset(pbufCopy, 0, sizeof(pbufCopy));
+		memset(zbufCopy, 0, sizeof(zbufCopy));
+		memcpy(pbufCopy, block.pbuf, block.count * sizeof(uint32));
+		memcpy(zbufCopy, block.zbuf, block.count * sizeof(uint));
+		pbuf = pbufCopy;
+		zbuf = zbufCopy;
+	}
+
+	__m128i mask[2], z[2];
+	for (int h = 0; h < 2; h++) {
+		const __m128i lane = _mm_setr_epi32(h * 4, h * 4 + 1, h * 4 + 2, h * 4 + 3);
+		const __m128i x = _mm_add_epi32(_mm_set1_epi32(block.x), lane);
+		mask[h] = _mm_cmplt_epi32(lane, _mm_set1_epi32(block.count));
+		mask[h] = _mm_and_si128(mask[h], _mm_cmpgt_epi32(x, _mm_set1_epi32(state.clipLeft - 1)));
+		mask[h] = _mm_and_si128(mask[h], _mm_cmplt_epi32(x, _mm_set1_epi32(state.clipRight)));
+
+		z[h] = ramp(block.z, block.dzdx, h * 4);
+		if (state.depthTest)
+			mask[h] = _mm_and_si128(mask[h], compare(state.depthFunc, _mm_loadu_si128((const __m128i *)(zbuf + h * 4)), z[h]));
+	}
+
+	const uint visible = _mm_movemask_ps(_mm_castsi128_ps(mask[0])) | (_mm_movemask_ps(_mm_castsi128_ps(mask[1])) << 4);
+	if (!visible)
+		return;
+
+	uint32 texels[SpanKernels::kBlockSize];
+	SpanKernels::fetchTexels(state, block, visible, texels);
+
+	const __m128i ff = _mm_set1_epi32(0xFF);
+	for (int h = 0; h < 2; h++) {
+		const __m128i tex = _mm_loadu_si128((const __m128i *)(texels + h * 4));
+		const __m128i a = light(_mm_srli_epi32(tex, 24), block.a, block.dadx, h * 4);
+		const __m128i r = light(_mm_and_si128(_mm_srli_epi32(tex, 16), ff), block.r, block.drdx, h * 4);
+		const __m128i g = light(_mm_and_si128(_mm_srli_epi32(tex, 8), ff), block.g, block.dgdx, h * 4);
+		const __m128i b = light(_mm_and_si128(tex, ff), block.b, block.dbdx, h * 4);
+
+		__m128i m = mask[h];
+		if (state.alphaTest)
+			m = _mm_and_si128(m, compare(state.alphaFunc, a, _mm_set1_epi32(state.alphaRef)));
+
+		if (state.depthWrite) {
+			__m128i *dst = (__m128i *)(zbuf + h * 4);
+			const __m128i old = _mm_loadu_si128(dst);
+			_mm_storeu_si128(dst, _mm_or_si128(_mm_and_si128(m, roundDepth(z[h])), _mm_andnot_si128(m, old)));
+		}
+
+		__m128i *dst = (__m128i *)(pbuf + h * 4);
+		const __m128i old = _mm_loadu_si128(dst);
+		__m128i color;
+		if (!state.blending) {
+			color = _mm_or_si128(_mm_or_si128(putComponent(r, state.rShift), putComponent(g, state.gShift)), putComponent(b, state.bShift));
+			if (state.hasAlpha)
+				color = _mm_or_si128(color, putComponent(a, state.aShift));
+		} else {
+			__m128i sr = r, sg = g, sb = b;
+			if (state.srcAlpha) {
+				sr = scale(sr, a);
+				sg = scale(sg, a);
+				sb = scale(sb, a);
+			}
+
+			__m128i dr, dg, db;
+			if (state.dstFactor == TGL_ZERO) {
+				dr = dg = db = _mm_setzero_si128();
+			} else {
+				dr = getComponent(old, state.rShift);
+				dg = getComponent(old, state.gShift);
+				db = getComponent(old, state.bShift);
+				if (state.dstFactor == TGL_ONE_MINUS_SRC_ALPHA) {
+					const __m128i oneMinusA = _mm_sub_epi32(ff, a);
+					dr = scale(dr, oneMinusA);
+					dg = scale(dg, oneMinusA);
+					db = scale(db, oneMinusA);
+				}
+			}
+
+			// The sums fit in the low 16 bits of each lane
+			const __m128i fr = _mm_min_epi16(_mm_add_epi32(dr, sr), ff);
+			const __m128i fg = _mm_min_epi16(_mm_add_epi32(dg, sg), ff);
+			const __m128i fb = _mm_min_epi16(_mm_add_epi32(db, sb), ff);
+			color = _mm_or_si128(_mm_or_si128(putComponent(fr, state.rShift), putComponent(fg, state.gShift)), putComponent(fb, state.bShift));
+			if (state.hasAlpha)
+				color = _mm_or_si128(color, putComponent(ff, state.aShift));
+		}
+		_mm_storeu_si128(dst, _mm_or_si128(_mm_and_si128(m, color), _mm_andnot_si128(m, old)));
+	}
+
+	if (block.count < SpanKernels::kBlockSize) {
+		memcpy(block.pbuf, pbufCopy, block.count * sizeof(uint32));
+		memcpy(block.zbuf, zbufCopy, block.count * sizeof(uint));
+	}
+}
+
+}; // End of class SpanKernelsImpl_SSE2
+
+const SpanKernels::Table SpanKernels::sse2 = {
+	SpanKernelsImpl_SSE2::textured
+};
+
+} // end of namespace TinyGL
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
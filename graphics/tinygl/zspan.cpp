@@ -0,0 +1,51 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/system.h"
+
+#include "graphics/tinygl/zspan.h"
+#include "graphics/tinygl/texelbuffer.h"
+
+namespace TinyGL {
+
+const SpanKernels::Table SpanKernels::generic = {
+	nullptr
+};
+
+const SpanKernels::Table *SpanKernels::kernels = nullptr;
+
+void SpanKernels::fetchTexels(const State &state, const Block &block, uint mask, uint32 *texels) {
+	// Step like the scalar code does, wrapping around on overflow
+	uint s = block.s, t = block.t;
+	for (int i = 0; i < block.count; i++) {
+		if (mask & (1 << i)) {
+			uint8 a, r, g, b;
+			state.texture->getARGBAt(state.wrapS, state.wrapT, (int)s, (int)t, a, r, g, b);
+			texels[i] = ((uint32)a << 24) | ((uint32)r << 16) | ((uint32)g << 8) | b;
+		} else {
+			texels[i] = 0;
+		}
+		s += block.dsdx;
+		t += block.dtdx;
+	}
+}
+
+} // end of namespace TinyGL
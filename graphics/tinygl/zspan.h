@@ -0,0 +1,128 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHICS_TINYGL_ZSPAN_H
+#define GRAPHICS_TINYGL_ZSPAN_H
+
+#include "common/cpu-kernels.h"
+#include "common/scummsys.h"
+
+namespace TinyGL {
+
+class TexelBuffer;
+
+/**
+ * SIMD versions of the innermost loop of the textured triangle fill.
+ *
+ * A kernel draws a block of up to kBlockSize pixels of a scan line at once:
+ * it runs the scissor, depth and alpha tests, lights the texels, blends them
+ * and writes the passing pixels and their depth. The texels themselves are
+ * still fetched one by one, as the texel buffers decode their format behind
+ * a virtual call.
+ *
+ * The kernels produce the same output as FrameBuffer::putPixelTexture, which
+ * stays the reference and the fallback for the states the kernels do not
+ * handle: fog, stencil test, other blending factors and frame buffers which
+ * are not 32 bits with 8 bits per color component.
+ */
+class SpanKernels {
+public:
+	enum {
+		kBlockSize = 8
+	};
+
+	/** The state of a triangle, which is the same for all its blocks. */
+	struct State {
+		const TexelBuffer *texture;
+		uint wrapS, wrapT;
+
+		bool depthTest;
+		int depthFunc;
+		bool depthWrite;
+
+		bool alphaTest;
+		int alphaFunc;
+		int alphaRef;
+
+		bool blending;
+		/** True for a TGL_SRC_ALPHA source factor, false for TGL_ONE */
+		bool srcAlpha;
+		/** TGL_ZERO, TGL_ONE or TGL_ONE_MINUS_SRC_ALPHA */
+		int dstFactor;
+
+		/** Pixels outside of [clipLeft, clipRight) are not drawn */
+		int clipLeft, clipRight;
+
+		/** Shifts of the color components in a frame buffer pixel */
+		int aShift, rShift, gShift, bShift;
+		bool hasAlpha;
+	};
+
+	/** Consecutive pixels of a scan line, and the interpolated values at the first one. */
+	struct Block {
+		uint32 *pbuf;
+		uint *zbuf;
+		int x;
+		int count;
+
+		uint z;
+		int dzdx;
+		int s, t;
+		int dsdx, dtdx;
+		uint r, g, b, a;
+		int drdx, dgdx, dbdx, dadx;
+	};
+
+	typedef void (*TexturedFunc)(const State &state, const Block &block);
+
+	struct Table {
+		/** Draw a textured block, or nullptr to use the scalar code */
+		TexturedFunc textured;
+	};
+
+	/** The scalar code only */
+	static const Table generic;
+#ifdef SCUMMVM_NEON
+	static const Table neon;
+#endif
+#ifdef SCUMMVM_SSE2
+	static const Table sse2;
+#endif
+#ifdef SCUMMVM_AVX2
+	static const Table avx2;
+#endif
+
+	/** The kernels in use, see Common::CpuKernels. */
+	static const Table *kernels;
+
+	static const Table &get() { return Common::CpuKernels<SpanKernels>::get(); }
+
+	/**
+	 * Fill @p texels with the texels of the pixels of @p block set in
+	 * @p mask, packed as 0xAARRGGBB. The kernels use this after the depth
+	 * test, so only the visible texels are fetched.
+	 */
+	static void fetchTexels(const State &state, const Block &block, uint mask, uint32 *texels);
+};
+
+} // end of namespace TinyGL
+
+#endif
@@ -182,6 +182,71 @@ end:
 	z += dzdx;
 }
 
+SpanKernels::TexturedFunc FrameBuffer::setupTexturedSpan(SpanKernels::State &state, bool depthTest, bool depthWrite, bool alphaTest, bool scissor, bool blending) const {
+	SpanKernels::TexturedFunc func = SpanKernels::get().textured;
+	if (!func)
+		return nullptr;
+
+	// The kernels only write 32 bits pixels with 8 bits per color component
+	if (_pbufBpp != 4 || _pbufFormat.rLoss != 0 || _pbufFormat.gLoss != 0 || _pbufFormat.bLoss != 0 ||
+	    (_pbufFormat.aLoss != 0 && _pbufFormat.aLoss != 8))
+		return nullptr;
+
+	if (blending) {
+		if (_sourceBlendingFactor != TGL_ONE && _sourceBlendingFactor != TGL_SRC_ALPHA)
+			return nullptr;
+		if (_destinationBlendingFactor != TGL_ZERO && _destinationBlendingFactor != TGL_ONE &&
+		    _destinationBlendingFactor != TGL_ONE_MINUS_SRC_ALPHA)
+			return nullptr;
+	}
+
+	state.texture = _currentTexture;
+	state.wrapS = _wrapS;
+	state.wrapT = _wrapT;
+	state.depthTest = depthTest;
+	state.depthFunc = _depthFunc;
+	state.depthWrite = depthWrite;
+	state.alphaTest = alphaTest;
+	state.alphaFunc = _alphaTestFunc;
+	state.alphaRef = _alphaTestRefVal;
+	state.blending = blending;
+	state.srcAlpha = (_sourceBlendingFactor == TGL_SRC_ALPHA);
+	state.dstFactor = _destinationBlendingFactor;
+	state.clipLeft = scissor ? _clipRectangle.left : 0;
+	state.clipRight = scissor ? _clipRectangle.right : _pbufWidth;
+	state.aShift = _pbufFormat.aShift;
+	state.rShift = _pbufFormat.rShift;
+	state.gShift = _pbufFormat.gShift;
+	state.bShift = _pbufFormat.bShift;
+	state.hasAlpha = (_pbufFormat.aLoss == 0);
+	return func;
+}
+
+template <bool kSmoothMode>
+SpanKernels::Block FrameBuffer::makeSpanBlock(int fbOffset, uint *pz, int x, int count, uint z, int dzdx, int s, int t, int dsdx, int dtdx,
+                                              uint r, uint g, uint b, uint a, int drdx, int dgdx, int dbdx, int dadx) {
+	SpanKernels::Block block;
+	block.pbuf = (uint32 *)_pbuf + fbOffset;
+	block.zbuf = pz;
+	block.x = x;
+	block.count = count;
+	block.z = z;
+	block.dzdx = dzdx;
+	block.s = s;
+	block.t = t;
+	block.dsdx = dsdx;
+	block.dtdx = dtdx;
+	block.r = r;
+	block.g = g;
+	block.b = b;
+	block.a = a;
+	block.drdx = kSmoothMode ? drdx : 0;
+	block.dgdx = kSmoothMode ? dgdx : 0;
+	block.dbdx = kSmoothMode ? dbdx : 0;
+	block.dadx = kSmoothMode ? dadx : 0;
+	return block;
+}
+
 template <bool kInterpRGB, bool kInterpZ, bool kInterpST, bool kInterpSTZ, bool kSmoothMode,
           bool kDepthWrite, bool kFogMode, bool kAlphaTestEnabled, bool kEnableScissor,
           bool kBlendingEnabled, bool kStencilEnabled, bool kStippleEnabled, bool kDepthTestEnabled>
@@ -342,12 +407,18 @@ void FrameBuffer::fillTriangle(ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint
 		a1 = p2->a;
 	}
 
+	SpanKernels::TexturedFunc spanKernel = nullptr;
+	SpanKernels::State spanState;
 	if (kInterpRGB && (kInterpST || kInterpSTZ)) {
 		texture = _currentTexture;
 		fdzdx = (float)dzdx;
 		fndzdx = NB_INTERP * fdzdx;
 		ndszdx = NB_INTERP * dszdx;
 		ndtzdx = NB_INTERP * dtzdx;
+
+		// Fog and the stencil test are only handled by the scalar code
+		if (kInterpZ && !kFogMode && !kStencilEnabled)
+			spanKernel = setupTexturedSpan(spanState, kDepthTestEnabled, kDepthWrite, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled);
 	}
 
 	if (fz0 > 0) {
@@ -449,7 +520,9 @@ void FrameBuffer::fillTriangle(ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint
 		// we draw all the scan line of the part
 		while (nb_lines > 0) {
 			int x = x1;
-			if (!kInterpRGB) {
+			if (kEnableScissor && (y < _clipRectangle.top || y >= _clipRectangle.bottom)) {
+				// The whole line is clipped, only step along the edges
+			} else if (!kInterpRGB) {
 				int n;
 				uint *pz;
 				byte *ps = nullptr;
@@ -582,9 +655,22 @@ void FrameBuffer::fillTriangle(ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint
 						fz += fndzdx;
 						zinv = (float)(1.0 / fz);
 					}
-					for (int _a = 0; _a < NB_INTERP; _a++) {
-						putPixelTexture<kDepthWrite, kInterpRGB, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kDepthTestEnabled>
-						               (pp, texture, _wrapS, _wrapT, pz, ps, _a, x, y, z, t, s, r, g, b, a, dzdx, dsdx, dtdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
+					if (spanKernel) {
+						spanKernel(spanState, makeSpanBlock<kSmoothMode>(pp, pz, x, NB_INTERP, z, dzdx, s, t, dsdx, dtdx, r, g, b, a, drdx, dgdx, dbdx, dadx));
+						z += NB_INTERP * (uint)dzdx;
+						s += NB_INTERP * dsdx;
+						t += NB_INTERP * dtdx;
+						if (kSmoothMode) {
+							a += NB_INTERP * (uint)dadx;
+							r += NB_INTERP * (uint)drdx;
+							g += NB_INTERP * (uint)dgdx;
+							b += NB_INTERP * (uint)dbdx;
+						}
+					} else {
+						for (int _a = 0; _a < NB_INTERP; _a++) {
+							putPixelTexture<kDepthWrite, kInterpRGB, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kDepthTestEnabled>
+							               (pp, texture, _wrapS, _wrapT, pz, ps, _a, x, y, z, t, s, r, g, b, a, dzdx, dsdx, dtdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
+						}
 					}
 					pp += NB_INTERP;
 					if (kInterpZ) {
@@ -609,6 +695,11 @@ void FrameBuffer::fillTriangle(ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint
 					dtdx = (int)((dtzdx - tt * fdzdx) * zinv);
 				}
 
+				if (spanKernel && n >= 0) {
+					spanKernel(spanState, makeSpanBlock<kSmoothMode>(pp, pz, x, n + 1, z, dzdx, s, t, dsdx, dtdx, r, g, b, a, drdx, dgdx, dbdx, dadx));
+					n = -1;
+				}
+
 				while (n >= 0) {
 					putPixelTexture<kDepthWrite, kInterpRGB, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kDepthTestEnabled>
 					               (pp, texture, _wrapS, _wrapT, pz, ps, 0, x, y, z, t, s, r, g, b, a, dzdx, dsdx, dtdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
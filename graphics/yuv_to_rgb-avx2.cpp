@@ -0,0 +1,156 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/yuv_to_rgb-kernels.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace Graphics {
+
+class YUVToRGBKernelsImpl_AVX2 {
+public:
+
+enum {
+	kBlockSize = 16
+};
+
+/** Returns trunc(k * (c - 128)) for each chroma value @p c, with k = factor / 65536 << shift. */
+template<int shift, int factor>
+static inline __m256i chroma(__m256i c) {
+	const __m256i d = _mm256_sub_epi16(c, _mm256_set1_epi16(128));
+	const __m256i s = _mm256_srai_epi16(d, 15);
+	const __m256i m = _mm256_sub_epi16(_mm256_xor_si256(d, s), s);
+	const __m256i t = _mm256_mulhi_epu16(_mm256_slli_epi16(m, shift), _mm256_set1_epi16((int16)factor));
+	return _mm256_sub_epi16(_mm256_xor_si256(t, s), s);
+}
+
+/** Clips a component like the lookup tables do, and drops its lost bits. */
+static inline __m256i clip(__m256i x, const YUVToRGBKernels::Params &params, int loss) {
+	if (params.itu) {
+		x = _mm256_sub_epi16(_mm256_min_epi16(_mm256_max_epi16(x, _mm256_set1_epi16(16)), _mm256_set1_epi16(235)), _mm256_set1_epi16(16));
+		x = _mm256_mulhi_epu16(_mm256_slli_epi16(x, YUVToRGBKernels::kITUShift), _mm256_set1_epi16((int16)YUVToRGBKernels::kITUFactor));
+	} else {
+		x = _mm256_min_epi16(_mm256_max_epi16(x, _mm256_setzero_si256()), _mm256_set1_epi16(255));
+	}
+	return _mm256_srl_epi16(x, _mm_cvtsi32_si128(loss));
+}
+
+/** Packs 8 pixels of 32 bits, from their 16-bit components. */
+static inline __m256i pack32(const YUVToRGBKernels::Params &params, __m128i r, __m128i g, __m128i b) {
+	__m256i pix = _mm256_or_si256(_mm256_sll_epi32(_mm256_cvtepu16_epi32(r), _mm_cvtsi32_si128(params.rShift)),
+	                              _mm256_sll_epi32(_mm256_cvtepu16_epi32(g), _mm_cvtsi32_si128(params.gShift)));
+	return _mm256_or_si256(pix, _mm256_sll_epi32(_mm256_cvtepu16_epi32(b), _mm_cvtsi32_si128(params.bShift)));
+}
+
+/** Returns the alpha of 8 pixels of 32 bits. */
+static inline __m256i alpha32(const YUVToRGBKernels::Params &params, const byte *a) {
+	if (!a)
+		return _mm256_set1_epi32((int32)params.aMask);
+
+	const __m256i alpha = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)a));
+	return _mm256_sll_epi32(_mm256_srl_epi32(alpha, _mm_cvtsi32_si128(params.aLoss)), _mm_cvtsi32_si128(params.aShift));
+}
+
+/** Converts and stores 16 pixels, from their 16-bit luminance, chroma and alpha values. */
+static inline void convertBlock(const YUVToRGBKernels::Params &params, byte *dst, __m256i y, __m256i u, __m256i v, const byte *a) {
+	const __m256i cr = chroma<YUVToRGBKernels::kCrRShift, YUVToRGBKernels::kCrRFactor>(v);
+	const __m256i cg = _mm256_add_epi16(chroma<YUVToRGBKernels::kCrGShift, YUVToRGBKernels::kCrGFactor>(v),
+	                                    chroma<YUVToRGBKernels::kCbGShift, YUVToRGBKernels::kCbGFactor>(u));
+	const __m256i cb = chroma<YUVToRGBKernels::kCbBShift, YUVToRGBKernels::kCbBFactor>(u);
+
+	const __m256i r = clip(_mm256_add_epi16(y, cr), params, params.rLoss);
+	// The green factors are negated
+	const __m256i g = clip(_mm256_sub_epi16(y, cg), params, params.gLoss);
+	const __m256i b = clip(_mm256_add_epi16(y, cb), params, params.bLoss);
+
+	if (params.bytesPerPixel == 2) {
+		__m256i pix = _mm256_or_si256(_mm256_sll_epi16(r, _mm_cvtsi32_si128(params.rShift)),
+		                              _mm256_sll_epi16(g, _mm_cvtsi32_si128(params.gShift)));
+		pix = _mm256_or_si256(pix, _mm256_sll_epi16(b, _mm_cvtsi32_si128(params.bShift)));
+		if (a) {
+			const __m256i alpha = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)a));
+			pix = _mm256_or_si256(pix, _mm256_sll_epi16(_mm256_srl_epi16(alpha, _mm_cvtsi32_si128(params.aLoss)), _mm_cvtsi32_si128(params.aShift)));
+		} else {
+			pix = _mm256_or_si256(pix, _mm256_set1_epi16((int16)params.aMask));
+		}
+		_mm256_storeu_si256((__m256i *)dst, pix);
+		return;
+	}
+
+	const __m256i lo = pack32(params, _mm256_castsi256_si128(r), _mm256_castsi256_si128(g), _mm256_castsi256_si128(b));
+	const __m256i hi = pack32(params, _mm256_extracti128_si256(r, 1), _mm256_extracti128_si256(g, 1), _mm256_extracti128_si256(b, 1));
+	_mm256_storeu_si256((__m256i *)dst, _mm256_or_si256(lo, alpha32(params, a)));
+	_mm256_storeu_si256((__m256i *)(dst + 32), _mm256_or_si256(hi, alpha32(params, a ? a + 8 : nullptr)));
+}
+
+static int convert444(const YUVToRGBKernels::Params &params, const YUVToRGBKernels::Row &row) {
+	int x = 0;
+
+	for (; x + kBlockSize <= row.width; x += kBlockSize) {
+		const __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(row.y + x)));
+		const __m256i u = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(row.u + x)));
+		const __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(row.v + x)));
+		convertBlock(params, row.dst + x * params.bytesPerPixel, y, u, v, row.a ? row.a + x : nullptr);
+	}
+
+	return x;
+}
+
+static int convert422(const YUVToRGBKernels::Params &params, const YUVToRGBKernels::Row &row) {
+	int x = 0;
+
+	for (; x + kBlockSize <= row.width; x += kBlockSize) {
+		// Each chroma value is used for two pixels
+		__m128i u = _mm_loadl_epi64((const __m128i *)(row.u + x / 2));
+		__m128i v = _mm_loadl_epi64((const __m128i *)(row.v + x / 2));
+		u = _mm_unpacklo_epi8(u, u);
+		v = _mm_unpacklo_epi8(v, v);
+
+		const __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(row.y + x)));
+		convertBlock(params, row.dst + x * params.bytesPerPixel, y, _mm256_cvtepu8_epi16(u), _mm256_cvtepu8_epi16(v), row.a ? row.a + x : nullptr);
+	}
+
+	return x;
+}
+
+}; // End of class YUVToRGBKernelsImpl_AVX2
+
+const YUVToRGBKernels::Table YUVToRGBKernels::avx2 = {
+	YUVToRGBKernelsImpl_AVX2::convert444,
+	YUVToRGBKernelsImpl_AVX2::convert422
+};
+
+} // End of namespace Graphics
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,120 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHICS_YUV_TO_RGB_KERNELS_H
+#define GRAPHICS_YUV_TO_RGB_KERNELS_H
+
+#include "common/cpu-kernels.h"
+#include "common/scummsys.h"
+
+namespace Graphics {
+
+struct PixelFormat;
+
+/**
+ * SIMD versions of the conversion of a row of YUV pixels to RGB.
+ *
+ * The lookup tables of YUVToRGBManager stay the reference: the kernels
+ * compute the same pixels with fixed point multiplications, which were
+ * checked against the tables for all the chroma and luminance values.
+ * The tables also convert the pixels left at the end of each row.
+ */
+class YUVToRGBKernels {
+public:
+	/** The destination format and luminance scale, as the kernels use them. */
+	struct Params {
+		Params(const PixelFormat &format, bool ituScale);
+
+		byte bytesPerPixel;
+		/** Luminance values range from [16, 235] instead of [0, 255] */
+		bool itu;
+		byte rShift, gShift, bShift, aShift;
+		byte rLoss, gLoss, bLoss, aLoss;
+		uint32 aMask;
+	};
+
+	/** A row of pixels to convert. */
+	struct Row {
+		byte *dst;
+		const byte *y;
+		const byte *u;
+		const byte *v;
+		/** The alpha value of each pixel, or nullptr for opaque pixels */
+		const byte *a;
+		int width;
+	};
+
+	/**
+	 * Convert the pixels at the start of a row.
+	 *
+	 * @return the number of pixels converted, which is a multiple of the
+	 *         block size of the kernel
+	 */
+	typedef int (*RowFunc)(const Params &params, const Row &row);
+
+	struct Table {
+		/** One chroma sample for each pixel, without alpha */
+		RowFunc convert444;
+		/** One chroma sample for two horizontal pixels */
+		RowFunc convert422;
+	};
+
+	/** The lookup tables only */
+	static const Table generic;
+#ifdef SCUMMVM_NEON
+	static const Table neon;
+#endif
+#ifdef SCUMMVM_SSE2
+	static const Table sse2;
+#endif
+#ifdef SCUMMVM_AVX2
+	static const Table avx2;
+#endif
+
+	/** The kernels in use, see Common::CpuKernels. */
+	static const Table *kernels;
+
+	static const Table &get() { return Common::CpuKernels<YUVToRGBKernels>::get(); }
+
+	/**
+	 * The fixed point versions of the chroma factors of the lookup tables:
+	 * a factor is applied to the magnitude m of a chroma value minus 128 as
+	 * (m << kChromaShift) * k >> 16, truncated like the tables are.
+	 */
+	enum {
+		kCrRShift = 1,
+		kCrRFactor = 45916, // 0.419 / 0.299
+		kCrGShift = 0,
+		kCrGFactor = 46763, // 0.299 / 0.419, negated
+		kCbGShift = 0,
+		kCbGFactor = 22568, // 0.114 / 0.331, negated
+		kCbBShift = 1,
+		kCbBFactor = 58109, // 0.587 / 0.331
+
+		/** (l << kITUShift) * kITUFactor >> 16 is l * 255 / 219 */
+		kITUShift = 1,
+		kITUFactor = 38155
+	};
+};
+
+} // End of namespace Graphics
+
+#endif
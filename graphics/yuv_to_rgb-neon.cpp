@@ -0,0 +1,180 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "graphics/yuv_to_rgb-kernels.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace Graphics {
+
+class YUVToRGBKernelsImpl_NEON {
+public:
+
+enum {
+	kBlockSize = 8
+};
+
+/** Returns the high 16 bits of the products of @p x and @p factor. */
+static inline uint16x8_t mulhi(uint16x8_t x, uint16 factor) {
+	return vcombine_u16(vshrn_n_u32(vmull_n_u16(vget_low_u16(x), factor), 16),
+	                    vshrn_n_u32(vmull_n_u16(vget_high_u16(x), factor), 16));
+}
+
+/** Returns trunc(k * (c - 128)) for each chroma value @p c, with k = factor / 65536 << shift. */
+template<int shift, int factor>
+static inline int16x8_t chroma(uint16x8_t c) {
+	const int16x8_t d = vsubq_s16(vreinterpretq_s16_u16(c), vdupq_n_s16(128));
+	const uint16x8_t m = vreinterpretq_u16_s16(vabsq_s16(d));
+	const int16x8_t t = vreinterpretq_s16_u16(mulhi(vshlq_n_u16(m, shift), factor));
+	return vbslq_s16(vcltq_s16(d, vdupq_n_s16(0)), vnegq_s16(t), t);
+}
+
+/** Clips a component like the lookup tables do, and drops its lost bits. */
+static inline uint16x8_t clip(int16x8_t x, const YUVToRGBKernels::Params &params, int loss) {
+	uint16x8_t c;
+	if (params.itu) {
+		x = vsubq_s16(vminq_s16(vmaxq_s16(x, vdupq_n_s16(16)), vdupq_n_s16(235)), vdupq_n_s16(16));
+		c = mulhi(vshlq_n_u16(vreinterpretq_u16_s16(x), YUVToRGBKernels::kITUShift), YUVToRGBKernels::kITUFactor);
+	} else {
+		c = vreinterpretq_u16_s16(vminq_s16(vmaxq_s16(x, vdupq_n_s16(0)), vdupq_n_s16(255)));
+	}
+	return vshlq_u16(c, vdupq_n_s16(-loss));
+}
+
+/** Packs 4 pixels of 32 bits, from their 16-bit components. */
+static inline uint32x4_t pack32(const YUVToRGBKernels::Params &params, uint16x4_t r, uint16x4_t g, uint16x4_t b) {
+	uint32x4_t pix = vorrq_u32(vshlq_u32(vmovl_u16(r), vdupq_n_s32(params.rShift)),
+	                           vshlq_u32(vmovl_u16(g), vdupq_n_s32(params.gShift)));
+	return vorrq_u32(pix, vshlq_u32(vmovl_u16(b), vdupq_n_s32(params.bShift)));
+}
+
+/** Converts and stores 8 pixels, from their 16-bit luminance, chroma and alpha values. */
+static inline void convertBlock(const YUVToRGBKernels::Params &params, byte *dst, uint16x8_t y, uint16x8_t u, uint16x8_t v, const byte *a) {
+	const int16x8_t yy = vreinterpretq_s16_u16(y);
+	const int16x8_t cr = chroma<YUVToRGBKernels::kCrRShift, YUVToRGBKernels::kCrRFactor>(v);
+	const int16x8_t cg = vaddq_s16(chroma<YUVToRGBKernels::kCrGShift, YUVToRGBKernels::kCrGFactor>(v),
+	                               chroma<YUVToRGBKernels::kCbGShift, YUVToRGBKernels::kCbGFactor>(u));
+	const int16x8_t cb = chroma<YUVToRGBKernels::kCbBShift, YUVToRGBKernels::kCbBFactor>(u);
+
+	const uint16x8_t r = clip(vaddq_s16(yy, cr), params, params.rLoss);
+	// The green factors are negated
+	const uint16x8_t g = clip(vsubq_s16(yy, cg), params, params.gLoss);
+	const uint16x8_t b = clip(vaddq_s16(yy, cb), params, params.bLoss);
+
+	if (params.bytesPerPixel == 2) {
+		uint16x8_t pix = vorrq_u16(vshlq_u16(r, vdupq_n_s16(params.rShift)),
+		                           vshlq_u16(g, vdupq_n_s16(params.gShift)));
+		pix = vorrq_u16(pix, vshlq_u16(b, vdupq_n_s16(params.bShift)));
+		if (a) {
+			const uint16x8_t alpha = vshlq_u16(vmovl_u8(vld1_u8(a)), vdupq_n_s16(-params.aLoss));
+			pix = vorrq_u16(pix, vshlq_u16(alpha, vdupq_n_s16(params.aShift)));
+		} else {
+			pix = vorrq_u16(pix, vdupq_n_u16((uint16)params.aMask));
+		}
+		vst1q_u16((uint16 *)dst, pix);
+		return;
+	}
+
+	uint32x4_t lo = pack32(params, vget_low_u16(r), vget_low_u16(g), vget_low_u16(b));
+	uint32x4_t hi = pack32(params, vget_high_u16(r), vget_high_u16(g), vget_high_u16(b));
+
+	if (a) {
+		const uint16x8_t alpha = vshlq_u16(vmovl_u8(vld1_u8(a)), vdupq_n_s16(-params.aLoss));
+		lo = vorrq_u32(lo, vshlq_u32(vmovl_u16(vget_low_u16(alpha)), vdupq_n_s32(params.aShift)));
+		hi = vorrq_u32(hi, vshlq_u32(vmovl_u16(vget_high_u16(alpha)), vdupq_n_s32(params.aShift)));
+	} else {
+		lo = vorrq_u32(lo, vdupq_n_u32(params.aMask));
+		hi = vorrq_u32(hi, vdupq_n_u32(params.aMask));
+	}
+
+	vst1q_u32((uint32 *)dst, lo);
+	vst1q_u32((uint32 *)(dst + 16), hi);
+}
+
+static int convert444(const YUVToRGBKernels::Params &params, const YUVToRGBKernels::Row &row) {
+	int x = 0;
+
+	for (; x + kBlockSize <= row.width; x += kBlockSize) {
+		const uint16x8_t y = vmovl_u8(vld1_u8(row.y + x));
+		const uint16x8_t u = vmovl_u8(vld1_u8(row.u + x));
+		const uint16x8_t v = vmovl_u8(vld1_u8(row.v + x));
+		convertBlock(params, row.dst + x * params.bytesPerPixel, y, u, v, row.a ? row.a + x : nullptr);
+	}
+
+	return x;
+}
+
+static int convert422(const YUVToRGBKernels::Params &params, const YUVToRGBKernels::Row &row) {
+	int x = 0;
+
+	for (; x + kBlockSize <= row.width; x += kBlockSize) {
+		uint32 u4, v4;
+		memcpy(&u4, row.u + x / 2, sizeof(u4));
+		memcpy(&v4, row.v + x / 2, sizeof(v4));
+
+		// Each chroma value is used for two pixels
+		uint8x8_t u = vreinterpret_u8_u32(vdup_n_u32(u4));
+		uint8x8_t v = vreinterpret_u8_u32(vdup_n_u32(v4));
+		u = vzip_u8(u, u).val[0];
+		v = vzip_u8(v, v).val[0];
+
+		const uint16x8_t y = vmovl_u8(vld1_u8(row.y + x));
+		convertBlock(params, row.dst + x * params.bytesPerPixel, y, vmovl_u8(u), vmovl_u8(v), row.a ? row.a + x : nullptr);
+	}
+
+	return x;
+}
+
+}; // End of class YUVToRGBKernelsImpl_NEON
+
+const YUVToRGBKernels::Table YUVToRGBKernels::neon = {
+	YUVToRGBKernelsImpl_NEON::convert444,
+	YUVToRGBKernelsImpl_NEON::convert422
+};
+
+} // End of namespace Graphics
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
@@ -0,0 +1,175 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/yuv_to_rgb-kernels.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Graphics {
+
+class YUVToRGBKernelsImpl_SSE2 {
+public:
+
+enum {
+	kBlockSize = 8
+};
+
+/** Returns trunc(k * (c - 128)) for each chroma value @p c, with k = factor / 65536 << shift. */
+template<int shift, int factor>
+static inline __m128i chroma(__m128i c) {
+	const __m128i d = _mm_sub_epi16(c, _mm_set1_epi16(128));
+	const __m128i s = _mm_srai_epi16(d, 15);
+	const __m128i m = _mm_sub_epi16(_mm_xor_si128(d, s), s);
+	const __m128i t = _mm_mulhi_epu16(_mm_slli_epi16(m, shift), _mm_set1_epi16((int16)factor));
+	return _mm_sub_epi16(_mm_xor_si128(t, s), s);
+}
+
+/** Clips a component like the lookup tables do, and drops its lost bits. */
+static inline __m128i clip(__m128i x, const YUVToRGBKernels::Params &params, int loss) {
+	if (params.itu) {
+		x = _mm_sub_epi16(_mm_min_epi16(_mm_max_epi16(x, _mm_set1_epi16(16)), _mm_set1_epi16(235)), _mm_set1_epi16(16));
+		x = _mm_mulhi_epu16(_mm_slli_epi16(x, YUVToRGBKernels::kITUShift), _mm_set1_epi16((int16)YUVToRGBKernels::kITUFactor));
+	} else {
+		x = _mm_min_epi16(_mm_max_epi16(x, _mm_setzero_si128()), _mm_set1_epi16(255));
+	}
+	return _mm_srl_epi16(x, _mm_cvtsi32_si128(loss));
+}
+
+/** Converts and stores 8 pixels, from their 16-bit luminance, chroma and alpha values. */
+static inline void convertBlock(const YUVToRGBKernels::Params &params, byte *dst, __m128i y, __m128i u, __m128i v, const byte *a) {
+	const __m128i cr = chroma<YUVToRGBKernels::kCrRShift, YUVToRGBKernels::kCrRFactor>(v);
+	const __m128i cg = _mm_add_epi16(chroma<YUVToRGBKernels::kCrGShift, YUVToRGBKernels::kCrGFactor>(v),
+	                                 chroma<YUVToRGBKernels::kCbGShift, YUVToRGBKernels::kCbGFactor>(u));
+	const __m128i cb = chroma<YUVToRGBKernels::kCbBShift, YUVToRGBKernels::kCbBFactor>(u);
+
+	const __m128i r = clip(_mm_add_epi16(y, cr), params, params.rLoss);
+	// The green factors are negated
+	const __m128i g = clip(_mm_sub_epi16(y, cg), params, params.gLoss);
+	const __m128i b = clip(_mm_add_epi16(y, cb), params, params.bLoss);
+
+	if (params.bytesPerPixel == 2) {
+		__m128i pix = _mm_or_si128(_mm_sll_epi16(r, _mm_cvtsi32_si128(params.rShift)),
+		                           _mm_sll_epi16(g, _mm_cvtsi32_si128(params.gShift)));
+		pix = _mm_or_si128(pix, _mm_sll_epi16(b, _mm_cvtsi32_si128(params.bShift)));
+		if (a) {
+			const __m128i alpha = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)a), _mm_setzero_si128());
+			pix = _mm_or_si128(pix, _mm_sll_epi16(_mm_srl_epi16(alpha, _mm_cvtsi32_si128(params.aLoss)), _mm_cvtsi32_si128(params.aShift)));
+		} else {
+			pix = _mm_or_si128(pix, _mm_set1_epi16((int16)params.aMask));
+		}
+		_mm_storeu_si128((__m128i *)dst, pix);
+		return;
+	}
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rShift = _mm_cvtsi32_si128(params.rShift);
+	const __m128i gShift = _mm_cvtsi32_si128(params.gShift);
+	const __m128i bShift = _mm_cvtsi32_si128(params.bShift);
+
+	__m128i lo = _mm_or_si128(_mm_sll_epi32(_mm_unpacklo_epi16(r, zero), rShift),
+	                          _mm_sll_epi32(_mm_unpacklo_epi16(g, zero), gShift));
+	__m128i hi = _mm_or_si128(_mm_sll_epi32(_mm_unpackhi_epi16(r, zero), rShift),
+	                          _mm_sll_epi32(_mm_unpackhi_epi16(g, zero), gShift));
+	lo = _mm_or_si128(lo, _mm_sll_epi32(_mm_unpacklo_epi16(b, zero), bShift));
+	hi = _mm_or_si128(hi, _mm_sll_epi32(_mm_unpackhi_epi16(b, zero), bShift));
+
+	if (a) {
+		const __m128i alpha = _mm_srl_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)a), zero),
+		                                    _mm_cvtsi32_si128(params.aLoss));
+		const __m128i aShift = _mm_cvtsi32_si128(params.aShift);
+		lo = _mm_or_si128(lo, _mm_sll_epi32(_mm_unpacklo_epi16(alpha, zero), aShift));
+		hi = _mm_or_si128(hi, _mm_sll_epi32(_mm_unpackhi_epi16(alpha, zero), aShift));
+	} else {
+		lo = _mm_or_si128(lo, _mm_set1_epi32((int32)params.aMask));
+		hi = _mm_or_si128(hi, _mm_set1_epi32((int32)params.aMask));
+	}
+
+	_mm_storeu_si128((__m128i *)dst, lo);
+	_mm_storeu_si128((__m128i *)(dst + 16), hi);
+}
+
+static int convert444(const YUVToRGBKernels::Params &params, const YUVToRGBKernels::Row &row) {
+	const __m128i zero = _mm_setzero_si128();
+	int x = 0;
+
+	for (; x + kBlockSize <= row.width; x += kBlockSize) {
+		const __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(row.y + x)), zero);
+		const __m128i u = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(row.u + x)), zero);
+		const __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(row.v + x)), zero);
+		convertBlock(params, row.dst + x * params.bytesPerPixel, y, u, v, row.a ? row.a + x : nullptr);
+	}
+
+	return x;
+}
+
+static int convert422(const YUVToRGBKernels::Params &params, const YUVToRGBKernels::Row &row) {
+	const __m128i zero = _mm_setzero_si128();
+	int x = 0;
+
+	for (; x + kBlockSize <= row.width; x += kBlockSize) {
+		int32 u4, v4;
+		memcpy(&u4, row.u + x / 2, sizeof(u4));
+		memcpy(&v4, row.v + x / 2, sizeof(v4));
+
+		// Each chroma value is used for two pixels
+		__m128i u = _mm_cvtsi32_si128(u4);
+		__m128i v = _mm_cvtsi32_si128(v4);
+		u = _mm_unpacklo_epi8(_mm_unpacklo_epi8(u, u), zero);
+		v = _mm_unpacklo_epi8(_mm_unpacklo_epi8(v, v), zero);
+
+		const __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(row.y + x)), zero);
+		convertBlock(params, row.dst + x * params.bytesPerPixel, y, u, v, row.a ? row.a + x : nullptr);
+	}
+
+	return x;
+}
+
+}; // End of class YUVToRGBKernelsImpl_SSE2
+
+const YUVToRGBKernels::Table YUVToRGBKernels::sse2 = {
+	YUVToRGBKernelsImpl_SSE2::convert444,
+	YUVToRGBKernelsImpl_SSE2::convert422
+};
+
+} // End of namespace Graphics
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
@@ -82,8 +82,10 @@
 // BASIS, AND BROWN UNIVERSITY HAS NO OBLIGATION TO PROVIDE MAINTENANCE,
 // SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
 
+#include "common/system.h"
 #include "graphics/surface.h"
 #include "graphics/yuv_to_rgb.h"
+#include "graphics/yuv_to_rgb-kernels.h"
 
 namespace Common {
 DECLARE_SINGLETON(Graphics::YUVToRGBManager);
@@ -99,15 +101,39 @@ public:
 	YUVToRGBManager::LuminanceScale getScale() const { return _scale; }
 	const int16 *getColorTable() const { return _colorTab; }
 	const byte *getClipTable() const { return _clipTable; }
+	const YUVToRGBKernels::Params &getParams() const { return _params; }
 
 private:
 	Graphics::PixelFormat _format;
 	YUVToRGBManager::LuminanceScale _scale;
+	YUVToRGBKernels::Params _params;
 	int16 _colorTab[4 * 256]; // 2048 bytes
 	byte _clipTable[3 * 768];
 };
 
-YUVToRGBLookup::YUVToRGBLookup(Graphics::PixelFormat format, YUVToRGBManager::LuminanceScale scale) {
+YUVToRGBKernels::Params::Params(const PixelFormat &format, bool ituScale) {
+	bytesPerPixel = format.bytesPerPixel;
+	itu = ituScale;
+	rShift = format.rShift;
+	gShift = format.gShift;
+	bShift = format.bShift;
+	aShift = format.aShift;
+	rLoss = format.rLoss;
+	gLoss = format.gLoss;
+	bLoss = format.bLoss;
+	aLoss = format.aLoss;
+	aMask = (0xFF >> format.aLoss) << format.aShift;
+}
+
+const YUVToRGBKernels::Table YUVToRGBKernels::generic = {
+	nullptr,
+	nullptr
+};
+
+const YUVToRGBKernels::Table *YUVToRGBKernels::kernels = nullptr;
+
+YUVToRGBLookup::YUVToRGBLookup(Graphics::PixelFormat format, YUVToRGBManager::LuminanceScale scale) :
+		_params(format, scale == YUVToRGBManager::kScaleITU) {
 	_format = format;
 	_scale = scale;
 
@@ -216,8 +242,21 @@ void convertYUV444ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const byte b_shift = lookup->getFormat().bShift;
 	const PixelInt a_mask = (0xFF >> lookup->getFormat().aLoss) << lookup->getFormat().aShift;
 
+	YUVToRGBKernels::RowFunc kernel = YUVToRGBKernels::get().convert444;
+
 	for (int h = 0; h < yHeight; h++) {
-		for (int w = 0; w < yWidth; w++) {
+		// Convert the start of the row with SIMD, if available
+		int start = 0;
+		if (kernel) {
+			YUVToRGBKernels::Row row = { dstPtr, ySrc, uSrc, vSrc, nullptr, yWidth };
+			start = kernel(lookup->getParams(), row);
+			dstPtr += start * sizeof(PixelInt);
+			ySrc += start;
+			uSrc += start;
+			vSrc += start;
+		}
+
+		for (int w = start; w < yWidth; w++) {
 			const byte *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -269,8 +308,21 @@ void convertYUV422ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const byte b_shift = lookup->getFormat().bShift;
 	const PixelInt a_mask = (0xFF >> lookup->getFormat().aLoss) << lookup->getFormat().aShift;
 
+	YUVToRGBKernels::RowFunc kernel = YUVToRGBKernels::get().convert422;
+
 	for (int h = 0; h < yHeight; h++) {
-		for (int w = 0; w < halfWidth; w++) {
+		// Convert the start of the row with SIMD, if available
+		int start = 0;
+		if (kernel) {
+			YUVToRGBKernels::Row row = { dstPtr, ySrc, uSrc, vSrc, nullptr, yWidth };
+			start = kernel(lookup->getParams(), row);
+			dstPtr += start * sizeof(PixelInt);
+			ySrc += start;
+			uSrc += start >> 1;
+			vSrc += start >> 1;
+		}
+
+		for (int w = start >> 1; w < halfWidth; w++) {
 			const byte *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -327,8 +379,25 @@ void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const byte b_shift = lookup->getFormat().bShift;
 	const PixelInt a_mask = (0xFF >> lookup->getFormat().aLoss) << lookup->getFormat().aShift;
 
+	YUVToRGBKernels::RowFunc kernel = YUVToRGBKernels::get().convert422;
+
 	for (int h = 0; h < halfHeight; h++) {
-		for (int w = 0; w < halfWidth; w++) {
+		// Convert the start of both rows with SIMD, if available
+		int start = 0;
+		if (kernel) {
+			YUVToRGBKernels::Row row = { dstPtr, ySrc, uSrc, vSrc, nullptr, yWidth };
+			start = kernel(lookup->getParams(), row);
+			row.dst += dstPitch;
+			row.y += yPitch;
+			kernel(lookup->getParams(), row);
+
+			dstPtr += start * sizeof(PixelInt);
+			ySrc += start;
+			uSrc += start >> 1;
+			vSrc += start >> 1;
+		}
+
+		for (int w = start >> 1; w < halfWidth; w++) {
 			const byte *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -393,8 +462,27 @@ void convertYUVA420ToRGBA(byte *dstPtr, int dstPitch, const YUVToRGBLookup *look
 	const byte a_shift = lookup->getFormat().aShift;
 	const byte a_loss = lookup->getFormat().aLoss;
 
+	YUVToRGBKernels::RowFunc kernel = YUVToRGBKernels::get().convert422;
+
 	for (int h = 0; h < halfHeight; h++) {
-		for (int w = 0; w < halfWidth; w++) {
+		// Convert the start of both rows with SIMD, if available
+		int start = 0;
+		if (kernel) {
+			YUVToRGBKernels::Row row = { dstPtr, ySrc, uSrc, vSrc, aSrc, yWidth };
+			start = kernel(lookup->getParams(), row);
+			row.dst += dstPitch;
+			row.y += yPitch;
+			row.a += yPitch;
+			kernel(lookup->getParams(), row);
+
+			dstPtr += start * sizeof(PixelInt);
+			ySrc += start;
+			aSrc += start;
+			uSrc += start >> 1;
+			vSrc += start >> 1;
+		}
+
+		for (int w = start >> 1; w < halfWidth; w++) {
 			const byte *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -464,6 +552,20 @@ void YUVToRGBManager::convert420Alpha(Graphics::Surface *dst, YUVToRGBManager::L
 	ySrc++; \
 	xDiff++
 
+enum {
+	/** The number of pixels of a row whose chroma is interpolated at once */
+	kYUV410Chunk = 256
+};
+
+/** Interpolate the chroma of four pixels, like DO_INTERPOLATION does. */
+static inline void interpolateYUV410(const byte *src, int uvPitch, int yDiff, byte *dst) {
+	const int a = src[0], b = src[1], c = src[uvPitch], d = src[uvPitch + 1];
+
+	for (int xDiff = 0; xDiff < 4; xDiff++)
+		dst[xDiff] = (a * (4 - xDiff) * (4 - yDiff) + b * xDiff * (4 - yDiff) +
+		              c * yDiff * (4 - xDiff) + d * xDiff * yDiff) >> 4;
+}
+
 template<typename PixelInt>
 void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	// Keep the tables in pointers here to avoid a dereference on each pixel
@@ -480,6 +582,50 @@ void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 
 	int quarterWidth = yWidth >> 2;
 
+	YUVToRGBKernels::RowFunc kernel = YUVToRGBKernels::get().convert444;
+
+	if (kernel) {
+		// Interpolate the chroma of a part of a row, and convert it like YUV444
+		byte uRow[kYUV410Chunk], vRow[kYUV410Chunk];
+
+		for (int y = 0; y < yHeight; y++) {
+			const byte *uLine = uSrc + (y >> 2) * uvPitch;
+			const byte *vLine = vSrc + (y >> 2) * uvPitch;
+			const int yDiff = y & 3;
+
+			for (int x = 0; x < yWidth; x += kYUV410Chunk) {
+				const int count = MIN<int>(kYUV410Chunk, yWidth - x);
+
+				for (int i = 0; i < count; i += 4) {
+					interpolateYUV410(uLine + ((x + i) >> 2), uvPitch, yDiff, uRow + i);
+					interpolateYUV410(vLine + ((x + i) >> 2), uvPitch, yDiff, vRow + i);
+				}
+
+				YUVToRGBKernels::Row row = { dstPtr, ySrc, uRow, vRow, nullptr, count };
+				const int start = kernel(lookup->getParams(), row);
+				dstPtr += start * sizeof(PixelInt);
+				ySrc += start;
+
+				for (int i = start; i < count; i++) {
+					const byte *L;
+
+					int16 cr_r  = Cr_r_tab[vRow[i]];
+					int16 crb_g = Cr_g_tab[vRow[i]] + Cb_g_tab[uRow[i]];
+					int16 cb_b  = Cb_b_tab[uRow[i]];
+
+					PUT_PIXEL(*ySrc, dstPtr);
+					ySrc++;
+					dstPtr += sizeof(PixelInt);
+				}
+			}
+
+			dstPtr += dstPitch - yWidth * sizeof(PixelInt);
+			ySrc += yPitch - yWidth;
+		}
+
+		return;
+	}
+
 	for (int y = 0; y < yHeight; y++) {
 		for (int x = 0; x < quarterWidth; x++) {
 			// Perform bilinear interpolation on the chroma values
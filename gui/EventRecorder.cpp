@@ -32,7 +32,10 @@ DECLARE_SINGLETON(GUI::EventRecorder);
 #include "backends/timer/sdl/sdl-timer.h"
 #include "backends/mixer/mixer.h"
 #include "common/config-manager.h"
+#include "common/file.h"
+#include "common/formats/json.h"
 #include "common/md5.h"
+#include "common/memory.h"
 #include "gui/gui-manager.h"
 #include "gui/widget.h"
 #include "gui/onscreendialog.h"
@@ -78,6 +81,12 @@ EventRecorder::EventRecorder() {
 	_screenshotPeriod = 0;
 	_playbackFile = nullptr;
 	_recordFile = nullptr;
+	_benchmark = false;
+	_frameEndMicros = 0;
+	_updateScreenMicros = 0;
+#ifdef ENABLE_ALLOCATION_COUNTING
+	_lastAllocations = 0;
+#endif
 }
 
 EventRecorder::~EventRecorder() {
@@ -89,6 +98,8 @@ void EventRecorder::deinit() {
 		return;
 	}
 	setFileHeader();
+	if (_benchmark)
+		saveBenchmarkResults();
 	_needRedraw = false;
 	_initialized = false;
 	_recordMode = kPassthrough;
@@ -282,6 +293,8 @@ void EventRecorder::processScreenUpdate() {
 		_timerManager->handler();
 		_controlPanel->setReplayedTime(_fakeTimer);
 		_processingMillis = false;
+		if (_benchmark)
+			startBenchmarkUpdateScreen();
 		break;
 	default:
 		break;
@@ -380,7 +393,7 @@ Common::String EventRecorder::generateRecordFileName(const Common::String &targe
 }
 
 
-void EventRecorder::init(const Common::String &recordFileName, RecordMode mode) {
+void EventRecorder::init(const Common::String &recordFileName, RecordMode mode, bool benchmark) {
 	_fakeMixerManager = new NullMixerManager();
 	_fakeMixerManager->init();
 	_fakeMixerManager->suspendAudio();
@@ -388,6 +401,7 @@ void EventRecorder::init(const Common::String &recordFileName, RecordMode mode)
 	_lastMillis = g_system->getMillis();
 	_lastScreenshotTime = 0;
 	_recordMode = mode;
+	_recordFileName = recordFileName;
 	_needcontinueGame = false;
 	if (ConfMan.hasKey("disable_display")) {
 		DebugMan.enableDebugChannel("EventRec");
@@ -417,6 +431,19 @@ void EventRecorder::init(const Common::String &recordFileName, RecordMode mode)
 		applyPlaybackSettings();
 		_nextEvent = _playbackFile->getNextEvent();
 	}
+	_benchmark = benchmark && _recordMode == kRecorderPlayback;
+	if (_benchmark) {
+		// Run as fast as possible, whatever the recorded settings are
+		_fastPlayback = true;
+		ConfMan.setBool("vsync", false, ConfMan.kTransientDomain);
+
+		_benchmarkFrames.clear();
+		_benchmarkFrame = BenchmarkFrame();
+#ifdef ENABLE_ALLOCATION_COUNTING
+		_lastAllocations = Common::getAllocationCount();
+#endif
+		_frameEndMicros = g_system->getMicros();
+	}
 	if ((_recordMode == kRecorderRecord) || (_recordMode == kRecorderUpdate)) {
 		getConfig();
 	}
@@ -571,7 +598,13 @@ void EventRecorder::updateSubsystems() {
 	}
 	RecordMode oldRecordMode = _recordMode;
 	_recordMode = kPassthrough;
-	_fakeMixerManager->update();
+	if (_benchmark) {
+		const uint64 start = g_system->getMicros();
+		_fakeMixerManager->update();
+		_benchmarkFrame.audioTime += g_system->getMicros() - start;
+	} else {
+		_fakeMixerManager->update();
+	}
 	_recordMode = oldRecordMode;
 }
 
@@ -699,6 +732,10 @@ Common::SaveFileManager *EventRecorder::getSaveManager(Common::SaveFileManager *
 }
 
 void EventRecorder::preDrawOverlayGui() {
+	// The control panel is not shown in benchmark mode, as it is not part
+	// of what is measured
+	if (_benchmark)
+		return;
 	if ((_initialized) || (_needRedraw)) {
 		RecordMode oldMode = _recordMode;
 		_recordMode = kPassthrough;
@@ -716,6 +753,11 @@ void EventRecorder::preDrawOverlayGui() {
 }
 
 void EventRecorder::postDrawOverlayGui() {
+	if (_benchmark) {
+		if (_initialized)
+			endBenchmarkFrame();
+		return;
+	}
 	if ((_initialized) || (_needRedraw)) {
 		RecordMode oldMode = _recordMode;
 		_recordMode = kPassthrough;
@@ -808,6 +850,87 @@ bool EventRecorder::checkForContinueGame() {
 	return result;
 }
 
+void EventRecorder::startBenchmarkUpdateScreen() {
+	// Everything since the end of the previous frame, except for the audio
+	// mixing, has been done by the engine
+	_updateScreenMicros = g_system->getMicros();
+	_benchmarkFrame.engineTime = (uint32)(_updateScreenMicros - _frameEndMicros) - _benchmarkFrame.audioTime;
+	_benchmarkFrame.time = _fakeTimer;
+}
+
+void EventRecorder::endBenchmarkFrame() {
+	_frameEndMicros = g_system->getMicros();
+	_benchmarkFrame.updateScreenTime = (uint32)(_frameEndMicros - _updateScreenMicros);
+
+#ifdef ENABLE_ALLOCATION_COUNTING
+	const uint32 allocations = Common::getAllocationCount();
+	_benchmarkFrame.allocations = allocations - _lastAllocations;
+	_lastAllocations = allocations;
+#endif
+
+	_benchmarkFrames.push_back(_benchmarkFrame);
+	_benchmarkFrame = BenchmarkFrame();
+}
+
+void EventRecorder::saveBenchmarkResults() {
+	_benchmark = false;
+
+	long long totalEngineTime = 0, totalUpdateScreenTime = 0, totalAudioTime = 0;
+#ifdef ENABLE_ALLOCATION_COUNTING
+	long long totalAllocations = 0;
+#endif
+	Common::JSONArray frames;
+	for (const BenchmarkFrame &frame : _benchmarkFrames) {
+		Common::JSONObject entry;
+		entry.setVal("time", new Common::JSONValue((long long)frame.time));
+		entry.setVal("engine_us", new Common::JSONValue((long long)frame.engineTime));
+		entry.setVal("update_screen_us", new Common::JSONValue((long long)frame.updateScreenTime));
+#ifdef ENABLE_ALLOCATION_COUNTING
+		entry.setVal("allocations", new Common::JSONValue((long long)frame.allocations));
+#endif
+		entry.setVal("audio_us", new Common::JSONValue((long long)frame.audioTime));
+		frames.push_back(new Common::JSONValue(entry));
+
+		totalEngineTime += frame.engineTime;
+		totalUpdateScreenTime += frame.updateScreenTime;
+		totalAudioTime += frame.audioTime;
+#ifdef ENABLE_ALLOCATION_COUNTING
+		totalAllocations += frame.allocations;
+#endif
+	}
+
+	Common::JSONObject totals;
+	totals.setVal("engine_us", new Common::JSONValue(totalEngineTime));
+	totals.setVal("update_screen_us", new Common::JSONValue(totalUpdateScreenTime));
+#ifdef ENABLE_ALLOCATION_COUNTING
+	totals.setVal("allocations", new Common::JSONValue(totalAllocations));
+#endif
+	totals.setVal("audio_us", new Common::JSONValue(totalAudioTime));
+
+	Common::JSONObject root;
+	root.setVal("recording", new Common::JSONValue(_recordFileName));
+	root.setVal("target", new Common::JSONValue(ConfMan.getActiveDomainName()));
+	root.setVal("frame_count", new Common::JSONValue((long long)_benchmarkFrames.size()));
+	root.setVal("totals", new Common::JSONValue(totals));
+	root.setVal("frames", new Common::JSONValue(frames));
+
+	Common::JSONValue results(root);
+	const Common::String json = results.stringify(true);
+	_benchmarkFrames.clear();
+
+	const Common::Path path = ConfMan.hasKey("benchmark_output") ? ConfMan.getPath("benchmark_output") : Common::Path(_recordFileName + ".json");
+	Common::DumpFile file;
+	if (file.open(path, true)) {
+		file.writeString(json);
+		file.flush();
+	}
+	if (!file.isOpen() || file.err()) {
+		warning("Could not write the benchmark results to '%s'", path.toString(Common::Path::kNativeSeparator).c_str());
+		return;
+	}
+	debug("playback:action=benchmark frames=%u output=%s", frames.size(), path.toString(Common::Path::kNativeSeparator).c_str());
+}
+
 void EventRecorder::deleteTemporarySave() {
 	if (_temporarySlot == -1) return;
 	const Plugin *plugin = PluginMan.findEnginePlugin(ConfMan.get("engineid"));
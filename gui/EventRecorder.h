@@ -77,7 +77,14 @@ public:
 		kRecorderUpdate = 4			/**< kRecorderUpdate, playback existing recording and update all hashes */
 	};
 
-	void init(const Common::String &recordFileName, RecordMode mode);
+	/**
+	 * Start recording or playing back.
+	 *
+	 * @param benchmark  Only for kRecorderPlayback: play the recording back
+	 *                   as fast as possible and save the time spent in each
+	 *                   frame as JSON when done (see deinit).
+	 */
+	void init(const Common::String &recordFileName, RecordMode mode, bool benchmark = false);
 	void deinit();
 	bool processDelayMillis();
 	uint32 getRandomSeed(const Common::String &name);
@@ -249,6 +256,30 @@ private:
 	bool _fastPlayback;
 	bool _needRedraw;
 	bool _processingMillis;
+
+	/** What a frame cost while playing back in benchmark mode */
+	struct BenchmarkFrame {
+		uint32 time;             ///< time of the frame in the recording, in milliseconds
+		uint32 engineTime;       ///< time spent in the engine since the previous frame, in microseconds
+		uint32 updateScreenTime; ///< time spent in OSystem::updateScreen, in microseconds
+		uint32 audioTime;        ///< time spent mixing the audio since the previous frame, in microseconds
+#ifdef ENABLE_ALLOCATION_COUNTING
+		uint32 allocations;      ///< number of allocations with new since the previous frame
+#endif
+	};
+
+	bool _benchmark;
+	Common::Array<BenchmarkFrame> _benchmarkFrames;
+	BenchmarkFrame _benchmarkFrame;
+	uint64 _frameEndMicros;
+	uint64 _updateScreenMicros;
+#ifdef ENABLE_ALLOCATION_COUNTING
+	uint32 _lastAllocations;
+#endif
+
+	void startBenchmarkUpdateScreen();
+	void endBenchmarkFrame();
+	void saveBenchmarkResults();
 };
 
 } // End of namespace GUI
@@ -29,6 +29,8 @@
 
 #include "engines/advancedDetector.h"
 
+#include "base/detectionScanner.h"
+
 #include "gui/massadd.h"
 
 #ifndef DISABLE_MASS_ADD
@@ -45,7 +47,7 @@ TODO:
 enum {
 	// Upper bound (im milliseconds) we want to spend in handleTickle.
 	// Setting this low makes the GUI more responsive but also slows
-	// down the scanning.
+	// down the scanning when it is not done by worker threads.
 	kMaxScanTime = 50
 };
 
@@ -58,18 +60,13 @@ enum {
 
 MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	: Dialog("MassAdd"),
-	_dirsScanned(0),
 	_oldGamesCount(0),
-	_dirTotal(0),
 	_okButton(nullptr),
 	_dirProgressText(nullptr),
 	_gameProgressText(nullptr) {
 
 	Common::U32StringArray l;
 
-	// The dir we start our scan at
-	_scanStack.push(startDir);
-
 	// Removed for now... Why would you put a title on mass add dialog called "Mass Add Dialog"?
 	// new StaticTextWidget(this, "massadddialog_caption", "Mass Add Dialog");
 
@@ -107,6 +104,13 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 			_pathToTargets[path].push_back(iter->_key);
 		}
 	}
+
+	// Start scanning at the given dir. The directories are listed and the
+	// detectors run on worker threads, see handleTickle for the results.
+	_scanner.reset(new DetectionScanner(startDir, true, ConfMan.getInt("detection_jobs"), (ADGF_WARNING | ADGF_UNSUPPORTED), true));
+}
+
+MassAddDialog::~MassAddDialog() {
 }
 
 struct GameTargetLess {
@@ -130,6 +134,11 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 #endif
 
 	// FIXME: It's a really bad thing that we use two arbitrary constants
+	if (cmd == kOkCmd || cmd == kCancelCmd) {
+		// Stop the worker threads before leaving
+		_scanner->cancel();
+	}
+
 	if (cmd == kOkCmd) {
 		// Sort the detected games. This is not strictly necessary, but nice for
 		// people who want to edit their config file by hand after a mass add.
@@ -183,100 +192,86 @@ void MassAddDialog::updateGameList() {
 	}
 }
 
-void MassAddDialog::handleTickle() {
-	if (_scanStack.empty())
-		return;	// We have finished scanning
-
-	uint32 t = g_system->getMillis();
-
-	// Perform a breadth-first scan of the filesystem.
-	while (!_scanStack.empty() && (g_system->getMillis() - t) < kMaxScanTime) {
-		Common::FSNode dir = _scanStack.pop();
+void MassAddDialog::addScanResult(const Common::FSNode &dir, const DetectedGames &candidates) {
+	// Just add all detected games / game variants. If we get more than one,
+	// that either means the directory contains multiple games, or the detector
+	// could not fully determine which game variant it was seeing. In either
+	// case, let the user choose which entries he wants to keep.
+	//
+	// However, we only add games which are not already in the config file.
+	for (const auto &cand : candidates) {
+		const DetectedGame &result = cand;
+
+		Common::Path path = dir.getPath();
+		path.removeTrailingSeparators();
 
-		Common::FSList files;
-		if (!dir.getChildren(files, Common::FSNode::kListAll)) {
-			continue;
+		// Check for existing config entries for this path/engineid/gameid/lang/platform combination
+		if (_pathToTargets.contains(path)) {
+			Common::String resultPlatformCode = Common::getPlatformCode(result.platform);
+			Common::String resultLanguageCode = Common::getLanguageCode(result.language);
+
+			bool duplicate = false;
+			const Common::StringArray &targets = _pathToTargets[path];
+			for (const auto &target : targets) {
+				// If the engineid, gameid, platform and language match -> skip it
+				Common::ConfigManager::Domain *dom = ConfMan.getDomain(target);
+				assert(dom);
+
+				if ((!dom->contains("engineid") || (*dom)["engineid"] == result.engineId) &&
+					(*dom)["gameid"] == result.gameId &&
+				    dom->getValOrDefault("platform") == resultPlatformCode &&
+					parseLanguage(dom->getValOrDefault("language")) == parseLanguage(resultLanguageCode)) {
+					duplicate = true;
+					break;
+				}
+			}
+			if (duplicate) {
+				_oldGamesCount++;
+				continue;	// Skip duplicates
+			}
 		}
+		_games.push_back(result);
 
-		// Run the detector on the dir
-		DetectionResults detectionResults = EngineMan.detectGames(files, (ADGF_WARNING | ADGF_UNSUPPORTED), true);
-
-		if (detectionResults.foundUnknownGames()) {
-			Common::U32String report = detectionResults.generateUnknownGameReport(false, 80);
-			g_system->logMessage(LogMessageType::kInfo, report.encode().c_str());
-		}
+		_list->append(result.description);
+	}
+}
 
-		// Just add all detected games / game variants. If we get more than one,
-		// that either means the directory contains multiple games, or the detector
-		// could not fully determine which game variant it was seeing. In either
-		// case, let the user choose which entries he wants to keep.
-		//
-		// However, we only add games which are not already in the config file.
-		DetectedGames candidates = detectionResults.listRecognizedGames();
-		for (const auto &cand : candidates) {
-			const DetectedGame &result = cand;
-
-			Common::Path path = dir.getPath();
-			path.removeTrailingSeparators();
-
-			// Check for existing config entries for this path/engineid/gameid/lang/platform combination
-			if (_pathToTargets.contains(path)) {
-				Common::String resultPlatformCode = Common::getPlatformCode(result.platform);
-				Common::String resultLanguageCode = Common::getLanguageCode(result.language);
-
-				bool duplicate = false;
-				const Common::StringArray &targets = _pathToTargets[path];
-				for (const auto &target : targets) {
-					// If the engineid, gameid, platform and language match -> skip it
-					Common::ConfigManager::Domain *dom = ConfMan.getDomain(target);
-					assert(dom);
-
-					if ((!dom->contains("engineid") || (*dom)["engineid"] == result.engineId) &&
-						(*dom)["gameid"] == result.gameId &&
-					    dom->getValOrDefault("platform") == resultPlatformCode &&
-						parseLanguage(dom->getValOrDefault("language")) == parseLanguage(resultLanguageCode)) {
-						duplicate = true;
-						break;
-					}
-				}
-				if (duplicate) {
-					_oldGamesCount++;
-					continue;	// Skip duplicates
-				}
-			}
-			_games.push_back(result);
+void MassAddDialog::handleTickle() {
+	if (_okButton->isEnabled())
+		return;	// We have finished scanning
 
-			_list->append(result.description);
-		}
+	uint32 t = g_system->getMillis();
+	bool gamesAdded = false;
+
+	// Fetch the results of the directories scanned so far. Without worker
+	// threads, each call to pollResult scans one directory.
+	DetectionScanner::Result result;
+	while ((g_system->getMillis() - t) < kMaxScanTime && _scanner->pollResult(result)) {
+		if (!result.unknownGameReport.empty())
+			g_system->logMessage(LogMessageType::kInfo, result.unknownGameReport.encode().c_str());
+
+		uint oldGames = _games.size();
+		addScanResult(result.dir, result.games);
+		gamesAdded = gamesAdded || _games.size() != oldGames;
+	}
 
+	if (gamesAdded) {
 		for (DetectedGame &game : _games) {
 			game.isSelected = true;
 		}
 
 		updateGameList();
-
-		// Recurse into all subdirs
-		for (const auto &file : files) {
-			if (file.isDirectory()) {
-				_scanStack.push(file);
-
-				_dirTotal++;
-			}
-		}
-
-		_dirsScanned++;
+	}
 
 #if defined(USE_TASKBAR)
-		g_system->getTaskbarManager()->setProgressValue(_dirsScanned, _dirTotal);
-		g_system->getTaskbarManager()->setCount(_games.size());
+	g_system->getTaskbarManager()->setProgressValue(_scanner->getScannedDirs(), _scanner->getTotalDirs());
+	g_system->getTaskbarManager()->setCount(_games.size());
 #endif
-	}
-
 
 	// Update the dialog
 	Common::U32String buf;
 
-	if (_scanStack.empty()) {
+	if (_scanner->isDone()) {
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
@@ -287,7 +282,7 @@ void MassAddDialog::handleTickle() {
 		_gameProgressText->setLabel(buf);
 
 	} else {
-		buf = Common::U32String::format(_("Scanned %d directories ..."), _dirsScanned);
+		buf = Common::U32String::format(_("Scanned %d directories ..."), _scanner->getScannedDirs());
 		_dirProgressText->setLabel(buf);
 
 		buf = Common::U32String::format(_("Discovered %d new games, ignored %d previously added games ..."), _games.size(), _oldGamesCount);
@@ -24,6 +24,7 @@ MODULE_OBJS := \
 	predictivedialog.o \
 	saveload.o \
 	saveload-dialog.o \
+	saveload-metaloader.o \
 	shaderbrowser-dialog.o \
 	textviewer.o \
 	themebrowser.o \
@@ -32,6 +32,7 @@
 
 #include "gui/message.h"
 #include "gui/gui-manager.h"
+#include "gui/saveload-metaloader.h"
 #include "gui/ThemeEval.h"
 #include "gui/widgets/edittext.h"
 
@@ -174,7 +175,7 @@ enum {
 SaveLoadChooserDialog::SaveLoadChooserDialog(const Common::String &dialogName, const bool saveMode)
 	: Dialog(dialogName), _metaEngine(nullptr), _delSupport(false), _metaInfoSupport(false),
 	_thumbnailSupport(false), _saveDateSupport(false), _playTimeSupport(false), _saveMode(saveMode),
-	_dialogWasShown(false)
+	_dialogWasShown(false), _metaLoader(nullptr)
 #ifndef DISABLE_SAVELOADCHOOSER_GRID
 	, _listButton(nullptr), _gridButton(nullptr)
 #endif // !DISABLE_SAVELOADCHOOSER_GRID
@@ -190,7 +191,7 @@ SaveLoadChooserDialog::SaveLoadChooserDialog(const Common::String &dialogName, c
 SaveLoadChooserDialog::SaveLoadChooserDialog(int x, int y, int w, int h, const bool saveMode)
 	: Dialog(x, y, w, h), _metaEngine(nullptr), _delSupport(false), _metaInfoSupport(false),
 	_thumbnailSupport(false), _saveDateSupport(false), _playTimeSupport(false), _saveMode(saveMode),
-	_dialogWasShown(false)
+	_dialogWasShown(false), _metaLoader(nullptr)
 #ifndef DISABLE_SAVELOADCHOOSER_GRID
 	, _listButton(nullptr), _gridButton(nullptr)
 #endif // !DISABLE_SAVELOADCHOOSER_GRID
@@ -204,9 +205,14 @@ SaveLoadChooserDialog::SaveLoadChooserDialog(int x, int y, int w, int h, const b
 }
 
 SaveLoadChooserDialog::~SaveLoadChooserDialog() {
+	delete _metaLoader;
 }
 
 void SaveLoadChooserDialog::open() {
+	// Opening the dialog already reflows it, which shows the saves
+	delete _metaLoader;
+	_metaLoader = _metaEngine ? new SaveMetaLoader(_metaEngine, _target) : nullptr;
+
 	Dialog::open();
 
 	// So that quitting ScummVM will not cause the dialog result to say a
@@ -217,6 +223,9 @@ void SaveLoadChooserDialog::open() {
 }
 
 void SaveLoadChooserDialog::close() {
+	delete _metaLoader;
+	_metaLoader = nullptr;
+
 	Dialog::close();
 }
 
@@ -325,6 +334,10 @@ void SaveLoadChooserDialog::updateSaveList(bool external) {
 }
 
 void SaveLoadChooserDialog::listSaves() {
+	// The loader must not query the engine while the saves change
+	if (_metaLoader)
+		_metaLoader->reset();
+
 	if (!_metaEngine) return; //very strange
 	_saveList = _metaEngine->listSaves(_target.c_str(), _saveMode);
 
@@ -540,6 +553,8 @@ void SaveLoadChooserSimple::handleCommand(CommandSender *sender, uint32 cmd, uin
 								_("Delete"), _("Cancel"));
 			if (alert.runModal() == kMessageOK) {
 				int saveSlot = _saveList[selItem].getSaveSlot();
+				if (_metaLoader)
+					_metaLoader->reset();
 				if (_metaEngine->removeSaveState(_target.c_str(), saveSlot)) {
 					setResult(-1);
 					int scrollPos = _list->getCurrentScrollPos();
@@ -654,7 +669,13 @@ void SaveLoadChooserSimple::updateSelection(bool redraw) {
 	_playtime->setLabel(_("No playtime saved"));
 
 	if (selItem >= 0 && _metaInfoSupport) {
-		SaveStateDescriptor desc = (_saveList[selItem].getLocked() ? _saveList[selItem] : _metaEngine->querySaveMetaInfos(_target.c_str(), _saveList[selItem].getSaveSlot()));
+		SaveStateDescriptor desc;
+		if (_saveList[selItem].getLocked())
+			desc = _saveList[selItem];
+		else if (_metaLoader)
+			desc = _metaLoader->query(_saveList[selItem].getSaveSlot());
+		else
+			desc = _metaEngine->querySaveMetaInfos(_target.c_str(), _saveList[selItem].getSaveSlot());
 		if (!_saveList[selItem].getLocked() && desc.getSaveSlot() >= 0 && !desc.getDescription().empty())
 			_saveList[selItem] = desc;
 
@@ -1104,6 +1125,24 @@ void SaveLoadChooserGrid::close() {
 	hideButtons();
 }
 
+void SaveLoadChooserGrid::handleTickle() {
+	// Fill in the saves of the current page as their meta infos are loaded
+	Common::Array<int> slots;
+	if (_metaLoader && _metaLoader->pollLoaded(slots)) {
+		const uint first = _curPage * _entriesPerPage;
+		bool visible = false;
+		for (uint i = first; i < _saveList.size() && i < first + _entriesPerPage && !visible; ++i)
+			visible = Common::find(slots.begin(), slots.end(), _saveList[i].getSaveSlot()) != slots.end();
+
+		if (visible) {
+			updateSaves();
+			g_gui.scheduleTopDialogRedraw();
+		}
+	}
+
+	SaveLoadChooserDialog::handleTickle();
+}
+
 int SaveLoadChooserGrid::runIntern() {
 	int slot;
 	do {
@@ -1169,7 +1208,15 @@ void SaveLoadChooserGrid::updateSaves() {
 	for (uint i = _curPage * _entriesPerPage, curNum = 0; i < _saveList.size() && curNum < _entriesPerPage; ++i, ++curNum) {
 		const uint saveSlot = _saveList[i].getSaveSlot();
 
-		SaveStateDescriptor desc =  (_saveList[i].getLocked() ? _saveList[i] : _metaEngine->querySaveMetaInfos(_target.c_str(), saveSlot));
+		SaveStateDescriptor desc;
+		if (_saveList[i].getLocked()) {
+			desc = _saveList[i];
+		} else if (!_metaLoader) {
+			desc = _metaEngine->querySaveMetaInfos(_target.c_str(), saveSlot);
+		} else if (!_metaLoader->getResult(saveSlot, desc)) {
+			// Show what the list of saves knows until the meta infos are loaded
+			desc = _saveList[i];
+		}
 		if (!_saveList[i].getLocked() && desc.getSaveSlot() >= 0 && !desc.getDescription().empty())
 			_saveList[i] = desc;
 		SlotButton &curButton = _buttons[curNum];
@@ -1222,6 +1269,19 @@ void SaveLoadChooserGrid::updateSaves() {
 		curButton.description->setEnabled(!desc.getLocked());
 	}
 
+	if (_metaLoader) {
+		// Load the meta infos of the current page first, then those of the
+		// following pages
+		Common::Array<int> slots;
+		const uint first = _curPage * _entriesPerPage;
+		for (uint i = first; i < first + _saveList.size(); ++i) {
+			const SaveStateDescriptor &save = _saveList[i % _saveList.size()];
+			if (!save.getLocked())
+				slots.push_back(save.getSaveSlot());
+		}
+		_metaLoader->request(slots);
+	}
+
 	const uint numPages = (_entriesPerPage != 0 && !_saveList.empty()) ? ((_saveList.size() + _entriesPerPage - 1) / _entriesPerPage) : 1;
 	_pageDisplay->setLabel(Common::String::format("%u/%u", _curPage + 1, numPages));
 
@@ -29,6 +29,8 @@
 
 namespace GUI {
 
+class SaveMetaLoader;
+
 #if defined(USE_CLOUD) && defined(USE_LIBCURL)
 class SaveLoadChooserDialog;
 
@@ -125,6 +127,7 @@ protected:
 	bool _dialogWasShown;
 	SaveStateList				_saveList;
 	Common::U32String			_resultString;
+	SaveMetaLoader				*_metaLoader;
 
 #ifndef DISABLE_SAVELOADCHOOSER_GRID
 	ButtonWidget *_listButton;
@@ -216,6 +219,8 @@ public:
 	SaveLoadChooserType getType() const override { return kSaveLoadDialogGrid; }
 
 	void close() override;
+
+	void handleTickle() override;
 protected:
 	void handleCommand(CommandSender *sender, uint32 cmd, uint32 data) override;
 	void handleMouseWheel(int x, int y, int direction) override;
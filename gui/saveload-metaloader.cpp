@@ -0,0 +1,519 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "gui/saveload-metaloader.h"
+
+#include "common/config-manager.h"
+#include "common/ptr.h"
+#include "common/savefile.h"
+#include "common/stream.h"
+#include "common/system.h"
+#include "common/workerpool.h"
+
+#include "engines/metaengine.h"
+#include "graphics/surface.h"
+
+namespace GUI {
+
+#define SAVE_META_CACHE_DIRECTORY "savecache"
+
+enum {
+	kSaveMetaCacheVersion = 1,
+
+	kSaveMetaCacheDeletable = 1 << 0,
+	kSaveMetaCacheWriteProtected = 1 << 1,
+	kSaveMetaCacheAutosave = 1 << 2,
+	kSaveMetaCachePlayTime = 1 << 3
+};
+
+static void writeCacheString(Common::WriteStream &stream, const Common::String &str) {
+	stream.writeUint16LE(str.size());
+	stream.write(str.c_str(), str.size());
+}
+
+static Common::String readCacheString(Common::ReadStream &stream) {
+	uint16 len = stream.readUint16LE();
+	Common::String str;
+	for (uint16 i = 0; i < len && !stream.eos(); i++)
+		str += (char)stream.readByte();
+	return str;
+}
+
+/** Split a date or time formatted by SaveStateDescriptor back into its fields. */
+static bool parseFields(const Common::String &str, char separator, int *fields, uint count) {
+	const char *s = str.c_str();
+	for (uint i = 0; i < count; i++) {
+		char *end;
+		fields[i] = strtol(s, &end, 10);
+		if (end == s || *end != (i + 1 < count ? separator : '\0'))
+			return false;
+		s = end + 1;
+	}
+	return true;
+}
+
+static bool statSavefile(const Common::String &filename, int64 &fileSize, int64 &modificationTime) {
+	return g_system->getSavefileManager()->getSavefileStat(filename, fileSize, modificationTime);
+}
+
+SaveMetaCache::SaveMetaCache(const Common::String &target) : _statSave(statSavefile), _dirty(false) {
+	Common::Path configFile = ConfMan.getCustomConfigFileName();
+	if (configFile.empty())
+		configFile = g_system->getDefaultConfigFileName();
+	_file = Common::FSNode(configFile).getParent().getChild(SAVE_META_CACHE_DIRECTORY).getChild(target + ".cache");
+
+	load();
+}
+
+SaveMetaCache::SaveMetaCache(const Common::FSNode &file, StatFunc statSave) :
+		_file(file), _statSave(statSave), _dirty(false) {
+	load();
+}
+
+SaveMetaCache::~SaveMetaCache() {
+	flush();
+}
+
+void SaveMetaCache::load() {
+	if (!_file.exists())
+		return;
+
+	Common::ScopedPtr<Common::SeekableReadStream> stream(_file.createReadStream());
+	if (!stream)
+		return;
+
+	if (stream->readUint32BE() != MKTAG('S', 'V', 'M', 'C') || stream->readUint32LE() != kSaveMetaCacheVersion)
+		return;
+
+	// The thumbnails are stored in the byte order of the machine
+#ifdef SCUMM_BIG_ENDIAN
+	if (stream->readByte() != 1)
+		return;
+#else
+	if (stream->readByte() != 0)
+		return;
+#endif
+
+	uint32 count = stream->readUint32LE();
+	for (uint32 i = 0; i < count; i++) {
+		Entry entry;
+		const int slot = stream->readSint32LE();
+
+		entry.filename = readCacheString(*stream);
+		entry.fileSize = stream->readSint64LE();
+		entry.modificationTime = stream->readSint64LE();
+		entry.description = readCacheString(*stream).decode();
+
+		const byte flags = stream->readByte();
+		entry.deletable = (flags & kSaveMetaCacheDeletable) != 0;
+		entry.writeProtected = (flags & kSaveMetaCacheWriteProtected) != 0;
+		entry.autosave = (flags & kSaveMetaCacheAutosave) != 0;
+		entry.hasPlayTime = (flags & kSaveMetaCachePlayTime) != 0;
+
+		entry.saveDate = readCacheString(*stream);
+		entry.saveTime = readCacheString(*stream);
+		entry.playTimeMSecs = stream->readUint32LE();
+
+		entry.thumbnailWidth = stream->readUint16LE();
+		entry.thumbnailHeight = stream->readUint16LE();
+		if (entry.thumbnailWidth && entry.thumbnailHeight) {
+			byte format[9];
+			stream->read(format, sizeof(format));
+			entry.thumbnailFormat = Graphics::PixelFormat(format[0], format[1], format[2], format[3], format[4],
+			                                              format[5], format[6], format[7], format[8]);
+			// Relative to the end of the index until the whole index is read
+			entry.thumbnailOffset = stream->readUint32LE();
+		}
+
+		if (stream->err() || stream->eos()) {
+			warning("Save meta cache '%s' is truncated, rebuilding it", _file.getPath().toString(Common::Path::kNativeSeparator).c_str());
+			_entries.clear();
+			_dirty = true;
+			return;
+		}
+
+		_entries.setVal(slot, entry);
+	}
+
+	const uint32 dataStart = stream->pos();
+	for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		if (i->_value.thumbnailWidth && i->_value.thumbnailHeight)
+			i->_value.thumbnailOffset += dataStart;
+	}
+}
+
+bool SaveMetaCache::readThumbnail(Common::SeekableReadStream &stream, Entry &entry) const {
+	const uint32 size = entry.thumbnailWidth * entry.thumbnailHeight * entry.thumbnailFormat.bytesPerPixel;
+	entry.thumbnailPixels.resize(size);
+	return stream.seek(entry.thumbnailOffset) && stream.read(entry.thumbnailPixels.data(), size) == size;
+}
+
+bool SaveMetaCache::get(const MetaEngine *metaEngine, int slot, const Common::String &filename,
+                        int64 fileSize, int64 modificationTime, SaveStateDescriptor &desc) {
+	Entry entry;
+	{
+		Common::StackLock lock(_mutex);
+		EntryMap::const_iterator i = _entries.find(slot);
+		if (i == _entries.end() || i->_value.filename != filename ||
+		    i->_value.fileSize != fileSize || i->_value.modificationTime != modificationTime)
+			return false;
+		entry = i->_value;
+	}
+
+	// The thumbnails which are still on disk are read without holding the lock
+	Graphics::Surface *thumbnail = nullptr;
+	if (entry.thumbnailWidth && entry.thumbnailHeight) {
+		if (entry.thumbnailOffset) {
+			Common::ScopedPtr<Common::SeekableReadStream> stream(_file.createReadStream());
+			if (!stream || !readThumbnail(*stream, entry))
+				return false;
+		}
+
+		thumbnail = new Graphics::Surface();
+		thumbnail->create(entry.thumbnailWidth, entry.thumbnailHeight, entry.thumbnailFormat);
+		memcpy(thumbnail->getPixels(), entry.thumbnailPixels.data(), entry.thumbnailPixels.size());
+	}
+
+	desc = SaveStateDescriptor(metaEngine, slot, entry.description);
+	desc.setDeletableFlag(entry.deletable);
+	desc.setWriteProtectedFlag(entry.writeProtected);
+	if (entry.autosave)
+		desc.setAutosave(true);
+
+	int fields[3];
+	if (parseFields(entry.saveDate, '-', fields, 3))
+		desc.setSaveDate(fields[0], fields[1], fields[2]);
+	if (parseFields(entry.saveTime, ':', fields, 2))
+		desc.setSaveTime(fields[0], fields[1]);
+	if (entry.hasPlayTime)
+		desc.setPlayTime(entry.playTimeMSecs);
+
+	if (thumbnail)
+		desc.setThumbnail(thumbnail);
+	return true;
+}
+
+void SaveMetaCache::set(int slot, const Common::String &filename, int64 fileSize, int64 modificationTime,
+                        const SaveStateDescriptor &desc) {
+	Entry entry;
+	entry.filename = filename;
+	entry.fileSize = fileSize;
+	entry.modificationTime = modificationTime;
+	entry.description = desc.getDescription();
+	entry.deletable = desc.getDeletableFlag();
+	entry.writeProtected = desc.getWriteProtectedFlag();
+	entry.autosave = desc.isAutosave();
+	entry.saveDate = desc.getSaveDate();
+	entry.saveTime = desc.getSaveTime();
+	entry.hasPlayTime = !desc.getPlayTime().empty();
+	entry.playTimeMSecs = desc.getPlayTimeMSecs();
+
+	// Only cache what can be restored exactly through the setters
+	int fields[3];
+	if ((!entry.saveDate.empty() && (!parseFields(entry.saveDate, '-', fields, 3) ||
+	     Common::String::format("%.4d-%.2d-%.2d", fields[0], fields[1], fields[2]) != entry.saveDate)) ||
+	    (!entry.saveTime.empty() && (!parseFields(entry.saveTime, ':', fields, 2) ||
+	     Common::String::format("%.2d:%.2d", fields[0], fields[1]) != entry.saveTime)))
+		return;
+
+	const Graphics::Surface *thumbnail = desc.getThumbnail();
+	if (thumbnail && thumbnail->getPixels() && thumbnail->w > 0 && thumbnail->h > 0) {
+		const uint rowSize = thumbnail->w * thumbnail->format.bytesPerPixel;
+		entry.thumbnailWidth = thumbnail->w;
+		entry.thumbnailHeight = thumbnail->h;
+		entry.thumbnailFormat = thumbnail->format;
+		entry.thumbnailPixels.resize(rowSize * thumbnail->h);
+		for (int y = 0; y < thumbnail->h; y++)
+			memcpy(&entry.thumbnailPixels[y * rowSize], thumbnail->getBasePtr(0, y), rowSize);
+	}
+
+	Common::StackLock lock(_mutex);
+	_entries.setVal(slot, entry);
+	_dirty = true;
+}
+
+void SaveMetaCache::flush() {
+	Common::ScopedPtr<Common::SeekableReadStream> oldFile;
+	Common::Array<int> removed;
+
+	// Drop the saves which were removed or modified meanwhile
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		const Entry &entry = i->_value;
+		int64 fileSize, modificationTime;
+		if (!_statSave(entry.filename, fileSize, modificationTime) ||
+		    fileSize != entry.fileSize || modificationTime != entry.modificationTime)
+			removed.push_back(i->_key);
+	}
+
+	if (!_dirty && removed.empty())
+		return;
+
+	// The file is replaced, so the thumbnails still on disk are read first
+	for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		Entry &entry = i->_value;
+		if (!entry.thumbnailOffset)
+			continue;
+
+		if (!oldFile)
+			oldFile.reset(_file.createReadStream());
+		if (!oldFile || !readThumbnail(*oldFile, entry))
+			removed.push_back(i->_key);
+		else
+			entry.thumbnailOffset = 0;
+	}
+
+	for (uint i = 0; i < removed.size(); i++)
+		_entries.erase(removed[i]);
+	oldFile.reset();
+
+	Common::FSNode dir = _file.getParent();
+	if (!dir.exists() && !dir.createDirectory()) {
+		warning("Unable to create the save meta cache directory '%s'", dir.getPath().toString(Common::Path::kNativeSeparator).c_str());
+		return;
+	}
+
+	Common::ScopedPtr<Common::WriteStream> stream(_file.createWriteStream());
+	if (!stream) {
+		warning("Unable to write save meta cache '%s'", _file.getPath().toString(Common::Path::kNativeSeparator).c_str());
+		return;
+	}
+
+	stream->writeUint32BE(MKTAG('S', 'V', 'M', 'C'));
+	stream->writeUint32LE(kSaveMetaCacheVersion);
+#ifdef SCUMM_BIG_ENDIAN
+	stream->writeByte(1);
+#else
+	stream->writeByte(0);
+#endif
+	stream->writeUint32LE(_entries.size());
+
+	uint32 dataOffset = 0;
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		const Entry &entry = i->_value;
+		byte flags = 0;
+		if (entry.deletable)
+			flags |= kSaveMetaCacheDeletable;
+		if (entry.writeProtected)
+			flags |= kSaveMetaCacheWriteProtected;
+		if (entry.autosave)
+			flags |= kSaveMetaCacheAutosave;
+		if (entry.hasPlayTime)
+			flags |= kSaveMetaCachePlayTime;
+
+		stream->writeSint32LE(i->_key);
+		writeCacheString(*stream, entry.filename);
+		stream->writeSint64LE(entry.fileSize);
+		stream->writeSint64LE(entry.modificationTime);
+		writeCacheString(*stream, entry.description.encode());
+		stream->writeByte(flags);
+		writeCacheString(*stream, entry.saveDate);
+		writeCacheString(*stream, entry.saveTime);
+		stream->writeUint32LE(entry.playTimeMSecs);
+
+		stream->writeUint16LE(entry.thumbnailWidth);
+		stream->writeUint16LE(entry.thumbnailHeight);
+		if (entry.thumbnailWidth && entry.thumbnailHeight) {
+			const Graphics::PixelFormat &format = entry.thumbnailFormat;
+			stream->writeByte(format.bytesPerPixel);
+			stream->writeByte(format.rBits());
+			stream->writeByte(format.gBits());
+			stream->writeByte(format.bBits());
+			stream->writeByte(format.aBits());
+			stream->writeByte(format.rShift);
+			stream->writeByte(format.gShift);
+			stream->writeByte(format.bShift);
+			stream->writeByte(format.aShift);
+			stream->writeUint32LE(dataOffset);
+			dataOffset += entry.thumbnailPixels.size();
+		}
+	}
+
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		if (!i->_value.thumbnailPixels.empty())
+			stream->write(i->_value.thumbnailPixels.data(), i->_value.thumbnailPixels.size());
+	}
+
+	if (!stream->flush() || stream->err())
+		warning("Error while writing save meta cache '%s'", _file.getPath().toString(Common::Path::kNativeSeparator).c_str());
+
+	_dirty = false;
+}
+
+class SaveMetaLoadJob : public Common::WorkerJob {
+public:
+	explicit SaveMetaLoadJob(SaveMetaLoader *loader) : _loader(loader) {}
+
+	void run() override {
+		_loader->processQueue();
+	}
+
+private:
+	SaveMetaLoader *_loader;
+};
+
+SaveMetaLoader::SaveMetaLoader(const MetaEngine *metaEngine, const Common::String &target, uint numThreads)
+	: _metaEngine(metaEngine), _target(target), _cache(target), _runningJobs(0), _cancelled(false) {
+	_pool = new Common::WorkerPool(numThreads);
+}
+
+SaveMetaLoader::~SaveMetaLoader() {
+	reset();
+	delete _pool;
+}
+
+void SaveMetaLoader::reset() {
+	{
+		Common::StackLock lock(_mutex);
+		_cancelled = true;
+		_queue.clear();
+	}
+
+	_pool->cancel();
+	_pool->wait();
+
+	Common::StackLock lock(_mutex);
+	_results.clear();
+	_loaded.clear();
+	_runningJobs = 0;
+	_cancelled = false;
+}
+
+void SaveMetaLoader::request(const Common::Array<int> &slots) {
+	Common::StackLock lock(_mutex);
+
+	_queue.clear();
+	for (uint i = 0; i < slots.size(); i++) {
+		if (!_results.contains(slots[i]))
+			_queue.push_back(slots[i]);
+	}
+
+	// Without worker threads, the saves are loaded by pollLoaded()
+	const uint threads = _pool->getThreadCount();
+	for (uint queued = _queue.size(); _runningJobs < threads && _runningJobs < queued; ) {
+		_runningJobs++;
+		_pool->submit(new SaveMetaLoadJob(this));
+	}
+}
+
+bool SaveMetaLoader::getResult(int slot, SaveStateDescriptor &desc) {
+	Common::StackLock lock(_mutex);
+	Common::HashMap<int, SaveStateDescriptor>::const_iterator i = _results.find(slot);
+	if (i == _results.end())
+		return false;
+
+	desc = i->_value;
+	return true;
+}
+
+SaveStateDescriptor SaveMetaLoader::query(int slot) {
+	SaveStateDescriptor desc;
+	if (getResult(slot, desc))
+		return desc;
+
+	desc = loadSlot(slot);
+	SaveStateDescriptor result = desc;
+	storeResult(slot, result);
+	return desc;
+}
+
+bool SaveMetaLoader::pollLoaded(Common::Array<int> &slots) {
+	if (_pool->getThreadCount() == 0) {
+		const uint32 start = g_system->getMillis();
+		do {
+			int slot;
+			{
+				Common::StackLock lock(_mutex);
+				if (_queue.empty())
+					break;
+				slot = _queue.front();
+				_queue.pop_front();
+			}
+
+			SaveStateDescriptor desc = loadSlot(slot);
+			storeResult(slot, desc);
+		} while (g_system->getMillis() - start < kSyncLoadTime);
+	}
+
+	Common::StackLock lock(_mutex);
+	if (_loaded.empty())
+		return false;
+
+	slots = _loaded;
+	_loaded.clear();
+	return true;
+}
+
+SaveStateDescriptor SaveMetaLoader::loadSlot(int slot) {
+	Common::String filename;
+	int64 fileSize = 0, modificationTime = 0;
+	bool hasStat;
+	{
+		// The engines and the save file manager are not thread-safe
+		Common::StackLock lock(_queryMutex);
+		filename = _metaEngine->getSavegameFile(slot, _target.c_str());
+		hasStat = g_system->getSavefileManager()->getSavefileStat(filename, fileSize, modificationTime);
+	}
+
+	SaveStateDescriptor desc;
+	if (hasStat && _cache.get(_metaEngine, slot, filename, fileSize, modificationTime, desc))
+		return desc;
+
+	{
+		Common::StackLock lock(_queryMutex);
+		desc = _metaEngine->querySaveMetaInfos(_target.c_str(), slot);
+	}
+
+	if (hasStat && desc.isValid() && !desc.getLocked())
+		_cache.set(slot, filename, fileSize, modificationTime, desc);
+	return desc;
+}
+
+void SaveMetaLoader::storeResult(int slot, SaveStateDescriptor &desc) {
+	Common::StackLock lock(_mutex);
+	if (!_cancelled && !_results.contains(slot)) {
+		_results.setVal(slot, desc);
+		_loaded.push_back(slot);
+	}
+
+	// The reference counts of the thumbnails are not atomic, so they are
+	// only shared while holding the lock
+	desc = SaveStateDescriptor();
+}
+
+void SaveMetaLoader::processQueue() {
+	while (true) {
+		int slot;
+		{
+			Common::StackLock lock(_mutex);
+			if (_cancelled || _queue.empty()) {
+				_runningJobs--;
+				return;
+			}
+			slot = _queue.front();
+			_queue.pop_front();
+		}
+
+		SaveStateDescriptor desc = loadSlot(slot);
+		storeResult(slot, desc);
+	}
+}
+
+} // End of namespace GUI
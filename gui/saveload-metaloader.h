@@ -0,0 +1,210 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GUI_SAVELOAD_METALOADER_H
+#define GUI_SAVELOAD_METALOADER_H
+
+#include "common/array.h"
+#include "common/fs.h"
+#include "common/hashmap.h"
+#include "common/list.h"
+#include "common/mutex.h"
+#include "common/noncopyable.h"
+#include "common/str.h"
+
+#include "engines/savestate.h"
+#include "graphics/pixelformat.h"
+
+class MetaEngine;
+
+namespace Common {
+class SeekableReadStream;
+class WorkerPool;
+}
+
+namespace GUI {
+
+/**
+ * Persistent cache of the save meta infos of a target: descriptions, dates,
+ * play times and thumbnails.
+ *
+ * The cache is stored in the "savecache" directory next to the configuration
+ * file, one file per target. An entry is only used as long as the size and
+ * modification time of its save file did not change. Thumbnails stay on
+ * disk until they are needed.
+ *
+ * get() and set() may be called from several threads at a time.
+ */
+class SaveMetaCache : Common::NonCopyable {
+public:
+	/** Get the size and modification time of a save, false if it does not exist. */
+	typedef bool (*StatFunc)(const Common::String &filename, int64 &fileSize, int64 &modificationTime);
+
+	explicit SaveMetaCache(const Common::String &target);
+
+	/** Use the given cache file, for the saves described by @p statSave. */
+	SaveMetaCache(const Common::FSNode &file, StatFunc statSave);
+
+	/** Write the cache back if it changed. */
+	~SaveMetaCache();
+
+	/**
+	 * Look up the meta infos of a save.
+	 *
+	 * @return False if the save is not in the cache, or was modified since.
+	 */
+	bool get(const MetaEngine *metaEngine, int slot, const Common::String &filename,
+	         int64 fileSize, int64 modificationTime, SaveStateDescriptor &desc);
+
+	/** Store the meta infos of a save, as returned by the engine. */
+	void set(int slot, const Common::String &filename, int64 fileSize, int64 modificationTime,
+	         const SaveStateDescriptor &desc);
+
+	/**
+	 * Write the cache to disk, dropping the entries of the saves which
+	 * were removed or modified. It must not be used meanwhile.
+	 */
+	void flush();
+
+private:
+	struct Entry {
+		Common::String filename;
+		int64 fileSize;
+		int64 modificationTime;
+
+		Common::U32String description;
+		bool deletable;
+		bool writeProtected;
+		bool autosave;
+		Common::String saveDate;
+		Common::String saveTime;
+		bool hasPlayTime;
+		uint32 playTimeMSecs;
+
+		uint16 thumbnailWidth;
+		uint16 thumbnailHeight;
+		Graphics::PixelFormat thumbnailFormat;
+		/** Position of the thumbnail pixels in the file, 0 once they are in memory. */
+		uint32 thumbnailOffset;
+		Common::Array<byte> thumbnailPixels;
+
+		Entry() : fileSize(0), modificationTime(0), deletable(true), writeProtected(false), autosave(false),
+			hasPlayTime(false), playTimeMSecs(0), thumbnailWidth(0), thumbnailHeight(0), thumbnailOffset(0) {}
+	};
+
+	typedef Common::HashMap<int, Entry> EntryMap;
+
+	void load();
+	bool readThumbnail(Common::SeekableReadStream &stream, Entry &entry) const;
+
+	Common::FSNode _file;
+	StatFunc _statSave;
+	Common::Mutex _mutex;
+	EntryMap _entries;
+	bool _dirty;
+};
+
+/**
+ * Loads the meta infos of the saves shown by a save/load chooser in the
+ * background.
+ *
+ * The saves are loaded by a pool of worker threads, in the order of the
+ * latest request, so that the chooser can ask for the visible saves first.
+ * The engines and the save file manager are not thread-safe, so only one
+ * save is queried from them at a time; the saves found in the cache are
+ * loaded in parallel with it.
+ *
+ * When the backend does not support threads, each call to pollLoaded()
+ * loads saves synchronously for a few milliseconds.
+ */
+class SaveMetaLoader : Common::NonCopyable {
+public:
+	/**
+	 * Create the loader.
+	 *
+	 * @param metaEngine  Meta engine of the target.
+	 * @param target      Target whose saves are loaded.
+	 * @param numThreads  Number of worker threads, 0 for one thread per CPU core.
+	 */
+	SaveMetaLoader(const MetaEngine *metaEngine, const Common::String &target, uint numThreads = 0);
+
+	/** Stop loading, waiting for the saves being loaded, and write the cache. */
+	~SaveMetaLoader();
+
+	/**
+	 * Set the saves to load next, in this order. They replace the saves
+	 * which were requested before and are not loaded yet.
+	 */
+	void request(const Common::Array<int> &slots);
+
+	/**
+	 * Get the meta infos of a save loaded in the background.
+	 *
+	 * @return False if the save has not been loaded yet.
+	 */
+	bool getResult(int slot, SaveStateDescriptor &desc);
+
+	/** Get the meta infos of a save, loading them on the calling thread if needed. */
+	SaveStateDescriptor query(int slot);
+
+	/**
+	 * Fetch the saves which were loaded since the last call.
+	 *
+	 * @return False if no save was loaded.
+	 */
+	bool pollLoaded(Common::Array<int> &slots);
+
+	/**
+	 * Stop loading and forget the loaded saves, e.g. before the saves are
+	 * modified.
+	 */
+	void reset();
+
+private:
+	friend class SaveMetaLoadJob;
+
+	enum {
+		/** Time spent loading saves by each call to pollLoaded() without threads. */
+		kSyncLoadTime = 10
+	};
+
+	SaveStateDescriptor loadSlot(int slot);
+	void storeResult(int slot, SaveStateDescriptor &desc);
+	void processQueue();
+
+	const MetaEngine *_metaEngine;
+	Common::String _target;
+	SaveMetaCache _cache;
+
+	Common::Mutex _mutex;
+	Common::Mutex _queryMutex;
+	Common::List<int> _queue;
+	Common::HashMap<int, SaveStateDescriptor> _results;
+	Common::Array<int> _loaded;
+	uint _runningJobs;
+	bool _cancelled;
+
+	Common::WorkerPool *_pool;
+};
+
+} // End of namespace GUI
+
+#endif
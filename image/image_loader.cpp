@@ -0,0 +1,220 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "image/image_loader.h"
+#include "image/jpeg.h"
+#include "image/png.h"
+
+#include "common/endian.h"
+#include "common/stream.h"
+#include "common/system.h"
+#include "common/thread.h"
+#include "graphics/blit.h"
+#include "graphics/surface.h"
+
+namespace Image {
+
+ImageFuture::ImageFuture(Common::SemaphoreInternal *done) : _done(done), _waited(false) {
+	_state.store(kStatePending);
+}
+
+ImageFuture::~ImageFuture() {
+	wait();
+	delete _done;
+}
+
+bool ImageFuture::wait() {
+	// The job may only forget about the future once it posted the
+	// semaphore, so it is waited for even if the state is already set
+	if (_done && !_waited) {
+		_done->wait();
+		_waited = true;
+	}
+
+	assert(isReady());
+	return _state.load() == kStateSucceeded;
+}
+
+void ImageFuture::finish(bool success) {
+	_state.store(success ? kStateSucceeded : kStateFailed);
+	if (_done)
+		_done->post();
+}
+
+class ImageLoader::DecodeJob : public Common::WorkerJob {
+public:
+	DecodeJob(ImageLoader *loader, Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeStream,
+	          Graphics::Surface *surface, const Graphics::PixelFormat &format, ImageFuture *future) :
+		_loader(loader), _stream(stream), _disposeStream(disposeStream), _surface(surface),
+		_format(format), _future(future) {}
+
+	void run() override {
+		const bool success = _loader->decode(*_stream, *_surface, _format);
+		if (_disposeStream == DisposeAfterUse::YES)
+			delete _stream;
+
+		// The future may be deleted as soon as it is finished
+		_future->finish(success);
+	}
+
+private:
+	ImageLoader *_loader;
+	Common::SeekableReadStream *_stream;
+	DisposeAfterUse::Flag _disposeStream;
+	Graphics::Surface *_surface;
+	Graphics::PixelFormat _format;
+	ImageFuture *_future;
+};
+
+ImageLoader::ImageLoader(uint numThreads) : _pool(numThreads) {
+}
+
+ImageLoader::~ImageLoader() {
+	_pool.wait();
+
+	for (uint i = 0; i < _pngDecoders.size(); i++)
+		delete _pngDecoders[i];
+	for (uint i = 0; i < _jpegDecoders.size(); i++)
+		delete _jpegDecoders[i];
+}
+
+ImageLoader::Format ImageLoader::detectFormat(Common::SeekableReadStream &stream) {
+	byte signature[8];
+	const int64 pos = stream.pos();
+	const uint32 size = stream.read(signature, sizeof(signature));
+	stream.seek(pos);
+
+	if (size >= 8 && READ_BE_UINT32(signature) == MKTAG(0x89, 'P', 'N', 'G') &&
+	    READ_BE_UINT32(signature + 4) == MKTAG(0x0d, 0x0a, 0x1a, 0x0a))
+		return kFormatPNG;
+	if (size >= 3 && signature[0] == 0xFF && signature[1] == 0xD8 && signature[2] == 0xFF)
+		return kFormatJPEG;
+	return kFormatUnknown;
+}
+
+template<class T>
+T *ImageLoader::acquireDecoder(Common::Array<T *> &decoders) {
+	Common::StackLock lock(_mutex);
+	if (decoders.empty())
+		return new T();
+
+	T *decoder = decoders.back();
+	decoders.pop_back();
+	return decoder;
+}
+
+template<class T>
+void ImageLoader::releaseDecoder(Common::Array<T *> &decoders, T *decoder) {
+	Common::StackLock lock(_mutex);
+	decoders.push_back(decoder);
+}
+
+bool ImageLoader::decode(Common::SeekableReadStream &stream, Graphics::Surface &surface, const Graphics::PixelFormat &format) {
+	const Graphics::PixelFormat &dstFormat = surface.getPixels() ? surface.format : format;
+	if (dstFormat.bytesPerPixel <= 1)
+		return false;
+
+	bool success = false;
+
+	switch (detectFormat(stream)) {
+	case kFormatPNG: {
+		PNGDecoder *decoder = acquireDecoder(_pngDecoders);
+		success = decoder->loadStream(stream) && copyImage(*decoder, surface, format);
+		releaseDecoder(_pngDecoders, decoder);
+		break;
+	}
+	case kFormatJPEG: {
+		JPEGDecoder *decoder = acquireDecoder(_jpegDecoders);
+		// libjpeg-turbo writes the rows straight into the surface, in its format
+		decoder->setOutputPixelFormat(dstFormat);
+		success = decoder->loadStreamInto(stream, surface);
+		releaseDecoder(_jpegDecoders, decoder);
+		break;
+	}
+	default:
+		break;
+	}
+
+	return success;
+}
+
+bool ImageLoader::copyImage(const ImageDecoder &decoder, Graphics::Surface &surface, const Graphics::PixelFormat &format) {
+	const Graphics::Surface *image = decoder.getSurface();
+	if (!image || !image->getPixels())
+		return false;
+
+	if (!surface.getPixels())
+		surface.create(image->w, image->h, format);
+	else if (surface.w != image->w || surface.h != image->h)
+		return false;
+
+	if (image->format.isCLUT8()) {
+		const Graphics::Palette &palette = decoder.getPalette();
+		uint32 map[256];
+		memset(map, 0, sizeof(map));
+
+		for (uint i = 0; i < palette.size() && i < 256; i++) {
+			byte r, g, b;
+			palette.get(i, r, g, b);
+			const byte a = (decoder.hasTransparentColor() && decoder.getTransparentColor() == i) ? 0 : 0xFF;
+			map[i] = surface.format.ARGBToColor(a, r, g, b);
+		}
+
+		return Graphics::crossBlitMap((byte *)surface.getPixels(), (const byte *)image->getPixels(),
+		                              surface.pitch, image->pitch, image->w, image->h,
+		                              surface.format.bytesPerPixel, map);
+	}
+
+	return Graphics::crossBlit((byte *)surface.getPixels(), (const byte *)image->getPixels(),
+	                           surface.pitch, image->pitch, image->w, image->h,
+	                           surface.format, image->format);
+}
+
+ImageFuture *ImageLoader::decodeAsync(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeStream,
+                                      Graphics::Surface *surface, const Graphics::PixelFormat &format) {
+	assert(stream && surface);
+
+	// Without worker threads, the image is decoded by submit()
+	Common::SemaphoreInternal *done = getThreadCount() ? g_system->createSemaphore() : nullptr;
+	ImageFuture *future = new ImageFuture(done);
+	_pool.submit(new DecodeJob(this, stream, disposeStream, surface, format, future));
+	return future;
+}
+
+uint ImageLoader::decodeBatch(Common::Array<Request> &requests, const Graphics::PixelFormat &format) {
+	Common::Array<ImageFuture *> futures;
+	futures.reserve(requests.size());
+
+	for (uint i = 0; i < requests.size(); i++)
+		futures.push_back(decodeAsync(requests[i].stream, DisposeAfterUse::NO, requests[i].surface, format));
+
+	uint decoded = 0;
+	for (uint i = 0; i < requests.size(); i++) {
+		requests[i].success = futures[i]->wait();
+		if (requests[i].success)
+			decoded++;
+		delete futures[i];
+	}
+
+	return decoded;
+}
+
+} // End of namespace Image
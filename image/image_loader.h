@@ -0,0 +1,206 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IMAGE_IMAGE_LOADER_H
+#define IMAGE_IMAGE_LOADER_H
+
+#include "common/array.h"
+#include "common/atomic.h"
+#include "common/mutex.h"
+#include "common/noncopyable.h"
+#include "common/types.h"
+#include "common/workerpool.h"
+#include "graphics/pixelformat.h"
+
+namespace Common {
+class SeekableReadStream;
+class SemaphoreInternal;
+}
+
+namespace Graphics {
+struct Surface;
+}
+
+namespace Image {
+
+/**
+ * @defgroup image_loader Image loader
+ * @ingroup image
+ *
+ * @brief Service decoding many PNG and JPEG images, possibly in parallel.
+ * @{
+ */
+
+class ImageDecoder;
+class JPEGDecoder;
+class PNGDecoder;
+
+/**
+ * An image decoded in the background by ImageLoader::decodeAsync().
+ *
+ * The surface given to decodeAsync() must not be used until the image is
+ * ready. Only one thread may wait for a future. Deleting it waits for the
+ * image as well.
+ */
+class ImageFuture : Common::NonCopyable {
+public:
+	~ImageFuture();
+
+	/** Return whether the image has been decoded, without waiting. */
+	bool isReady() const { return _state.load() != kStatePending; }
+
+	/**
+	 * Wait until the image has been decoded.
+	 *
+	 * @return Whether the image was decoded successfully.
+	 */
+	bool wait();
+
+private:
+	friend class ImageLoader;
+
+	enum State {
+		kStatePending,
+		kStateSucceeded,
+		kStateFailed
+	};
+
+	explicit ImageFuture(Common::SemaphoreInternal *done);
+	void finish(bool success);
+
+	Common::Atomic<uint32> _state;
+	// Posted once the image is decoded, nullptr when decoded synchronously
+	Common::SemaphoreInternal *_done;
+	bool _waited;
+};
+
+/**
+ * Service decoding PNG and JPEG images into surfaces provided by the
+ * caller, e.g. to load the assets of a scene.
+ *
+ * The loader keeps the decoders it used, along with their libjpeg
+ * contexts and buffers, for the next images. Images may be decoded in
+ * parallel on the worker threads of the loader, which fall back to
+ * decoding synchronously on backends without thread support.
+ *
+ * JPEG images are decoded straight into the surface of the caller when
+ * libjpeg-turbo can output its format. PNG images, and JPEG images without
+ * libjpeg-turbo, are decoded into the surface of their decoder, then
+ * converted to the format of the surface of the caller and copied into it.
+ * Paletted images are expanded with their palette, and their transparent
+ * color, if any, becomes fully transparent. Surfaces in CLUT8 are not
+ * supported.
+ */
+class ImageLoader : Common::NonCopyable {
+public:
+	enum Format {
+		kFormatUnknown,
+		kFormatPNG,
+		kFormatJPEG
+	};
+
+	/** An image to decode with decodeBatch(). */
+	struct Request {
+		Request() : stream(nullptr), surface(nullptr), success(false) {}
+		Request(Common::SeekableReadStream *s, Graphics::Surface *surf) : stream(s), surface(surf), success(false) {}
+
+		Common::SeekableReadStream *stream;
+		Graphics::Surface *surface;
+		/** Set by decodeBatch() to whether the image was decoded. */
+		bool success;
+	};
+
+	/**
+	 * Create the loader.
+	 *
+	 * @param numThreads  Number of worker threads. 0 uses one thread per CPU
+	 *                    core. 1 decodes the images synchronously.
+	 */
+	explicit ImageLoader(uint numThreads = 0);
+
+	/** Wait for the images which are still decoded, then free the decoders. */
+	~ImageLoader();
+
+	/**
+	 * Detect the format of an image from its signature. The stream is
+	 * left at its current position.
+	 */
+	static Format detectFormat(Common::SeekableReadStream &stream);
+
+	/**
+	 * Decode an image on the calling thread.
+	 *
+	 * If the surface has no pixels, it is created with the size of the
+	 * image and @p format, and then belongs to the caller. Otherwise, the
+	 * image must have the size of the surface, and is converted to the
+	 * format of the surface.
+	 *
+	 * This may be called from several threads at a time.
+	 *
+	 * @return Whether the image was decoded.
+	 */
+	bool decode(Common::SeekableReadStream &stream, Graphics::Surface &surface, const Graphics::PixelFormat &format);
+
+	/**
+	 * Decode an image on a worker thread, like decode().
+	 *
+	 * The stream is read on the worker thread, so it must not share an
+	 * underlying stream with other streams used at the same time, e.g.
+	 * read the image into a MemoryReadStream first.
+	 *
+	 * @return The future of the image, which belongs to the caller.
+	 */
+	ImageFuture *decodeAsync(Common::SeekableReadStream *stream, DisposeAfterUse::Flag disposeStream,
+	                         Graphics::Surface *surface, const Graphics::PixelFormat &format);
+
+	/**
+	 * Decode several images in parallel, and wait for all of them. The
+	 * streams must follow the rules of decodeAsync().
+	 *
+	 * @return The number of images which were decoded.
+	 */
+	uint decodeBatch(Common::Array<Request> &requests, const Graphics::PixelFormat &format);
+
+	/** Return the number of worker threads, 0 when the images are decoded synchronously. */
+	uint getThreadCount() const { return _pool.getThreadCount(); }
+
+private:
+	class DecodeJob;
+
+	template<class T>
+	T *acquireDecoder(Common::Array<T *> &decoders);
+	template<class T>
+	void releaseDecoder(Common::Array<T *> &decoders, T *decoder);
+
+	static bool copyImage(const ImageDecoder &decoder, Graphics::Surface &surface, const Graphics::PixelFormat &format);
+
+	Common::Mutex _mutex;
+	// The decoders which are not in use
+	Common::Array<PNGDecoder *> _pngDecoders;
+	Common::Array<JPEGDecoder *> _jpegDecoders;
+	Common::WorkerPool _pool;
+};
+
+/** @} */
+
+} // End of namespace Image
+
+#endif
@@ -30,6 +30,7 @@
 #include "common/stream.h"
 #include "common/textconsole.h"
 #include "common/util.h"
+#include "graphics/blit.h"
 #include "graphics/pixelformat.h"
 
 #ifdef USE_JPEG
@@ -45,6 +46,7 @@ extern "C" {
 namespace Image {
 
 JPEGDecoder::JPEGDecoder() :
+		_context(nullptr),
 		_surface(),
 		_palette(0),
 		_colorSpace(kColorSpaceRGB),
@@ -54,6 +56,7 @@ JPEGDecoder::JPEGDecoder() :
 
 JPEGDecoder::~JPEGDecoder() {
 	destroy();
+	destroyContext();
 }
 
 Graphics::PixelFormat JPEGDecoder::getByteOrderRgbPixelFormat() const {
@@ -235,21 +238,55 @@ J_COLOR_SPACE fromScummvmPixelFormat(const Graphics::PixelFormat &format) {
 } // End of anonymous namespace
 #endif
 
-bool JPEGDecoder::loadStream(Common::SeekableReadStream &stream) {
 #ifdef USE_JPEG
-	// Reset member variables from previous decodings
-	destroy();
-
+struct JPEGDecoder::DecompressContext {
 	jpeg_decompress_struct cinfo;
 	jpeg_error_mgr jerr;
+};
+#endif
+
+void JPEGDecoder::destroyContext() {
+#ifdef USE_JPEG
+	if (_context) {
+		jpeg_destroy_decompress(&_context->cinfo);
+		delete _context;
+		_context = nullptr;
+	}
+#endif
+}
+
+bool JPEGDecoder::loadStream(Common::SeekableReadStream &stream) {
+	return decodeImage(stream, nullptr);
+}
+
+bool JPEGDecoder::loadStreamInto(Common::SeekableReadStream &stream, Graphics::Surface &surface) {
+	if (_colorSpace != kColorSpaceRGB)
+		return false;
 
-	// Initialize error handling callbacks
-	cinfo.err = jpeg_std_error(&jerr);
-	cinfo.err->error_exit = &errorExit;
-	cinfo.err->output_message = &outputMessage;
+	return decodeImage(stream, &surface);
+}
+
+bool JPEGDecoder::decodeImage(Common::SeekableReadStream &stream, Graphics::Surface *target) {
+#ifdef USE_JPEG
+	// The surface of the previous image is kept, and reused when the new
+	// image has the same size and format. This saves an allocation per
+	// frame to Motion JPEG videos, and per image to the image loader.
+
+	// The decompression object is created once, since libjpeg allows
+	// reusing it after jpeg_finish_decompress()
+	if (!_context) {
+		_context = new DecompressContext();
+
+		// Initialize error handling callbacks
+		_context->cinfo.err = jpeg_std_error(&_context->jerr);
+		_context->cinfo.err->error_exit = &errorExit;
+		_context->cinfo.err->output_message = &outputMessage;
+
+		// Initialize the decompression structure
+		jpeg_create_decompress(&_context->cinfo);
+	}
 
-	// Initialize the decompression structure
-	jpeg_create_decompress(&cinfo);
+	jpeg_decompress_struct &cinfo = _context->cinfo;
 
 	if (_accuracy <= CodecAccuracy::Fast)
 		cinfo.dct_method = JDCT_FASTEST;
@@ -296,47 +333,68 @@ bool JPEGDecoder::loadStream(Common::SeekableReadStream &stream) {
 	jpeg_start_decompress(&cinfo);
 
 	// Allocate buffers for the output data
+	Graphics::PixelFormat outputPixelFormat;
 	switch (_colorSpace) {
-	case kColorSpaceRGB: {
-		Graphics::PixelFormat outputPixelFormat;
+	case kColorSpaceRGB:
 		if (cinfo.out_color_space == JCS_RGB) {
 			outputPixelFormat = getByteOrderRgbPixelFormat();
 		} else {
 			outputPixelFormat = _requestedPixelFormat;
 		}
-		_surface.create(cinfo.output_width, cinfo.output_height, outputPixelFormat);
 		break;
-	}
 	case kColorSpaceYUV:
 		// We use YUV with 3 bytes per pixel otherwise.
 		// This is pretty ugly since our PixelFormat cannot express YUV...
-		_surface.create(cinfo.output_width, cinfo.output_height, Graphics::PixelFormat(3, 0, 0, 0, 0, 0, 0, 0, 0));
+		outputPixelFormat = Graphics::PixelFormat(3, 0, 0, 0, 0, 0, 0, 0, 0);
 		break;
 	default:
 		break;
 	}
+
+	// The rows go straight into the surface of the caller when libjpeg
+	// outputs its format
+	Graphics::Surface *output = &_surface;
+	if (target) {
+		if (!target->getPixels())
+			target->create(cinfo.output_width, cinfo.output_height, _requestedPixelFormat);
+
+		if (target->w != (int)cinfo.output_width || target->h != (int)cinfo.output_height) {
+			jpeg_abort_decompress(&cinfo);
+			return false;
+		}
+
+		if (target->format == outputPixelFormat)
+			output = target;
+	}
+
+	if (output == &_surface && (!_surface.getPixels() || _surface.w != (int)cinfo.output_width ||
+	    _surface.h != (int)cinfo.output_height || _surface.format != outputPixelFormat))
+		_surface.create(cinfo.output_width, cinfo.output_height, outputPixelFormat);
+
 	// Size of output pixel must match 4 bytes.
 	if (cinfo.out_color_space == JCS_CMYK) {
-		assert(_surface.format.bytesPerPixel == 4);
+		assert(output->format.bytesPerPixel == 4);
 	}
 
-	// Allocate buffer for one scanline
-	JDIMENSION pitch = cinfo.output_width * _surface.format.bytesPerPixel;
-	assert(_surface.pitch >= (int)pitch);
-	JSAMPARRAY buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, JPOOL_IMAGE, pitch, 1);
-
-	// Go through the image data scanline by scanline
+	// Go through the image data scanline by scanline, straight into the surface
+	assert(output->pitch >= (int)(cinfo.output_width * output->format.bytesPerPixel));
 	while (cinfo.output_scanline < cinfo.output_height) {
-		byte *dst = (byte *)_surface.getBasePtr(0, cinfo.output_scanline);
-
-		jpeg_read_scanlines(&cinfo, buffer, 1);
-
-		memcpy(dst, buffer[0], pitch);
+		JSAMPROW row = (JSAMPROW)output->getBasePtr(0, cinfo.output_scanline);
+		jpeg_read_scanlines(&cinfo, &row, 1);
 	}
 
-	// We are done with decompressing, thus free all the data
+	// We are done with decompressing, which frees the data of this image
 	jpeg_finish_decompress(&cinfo);
-	jpeg_destroy_decompress(&cinfo);
+
+	if (output == target)
+		return true;
+
+	if (target) {
+		// Slow path, without libjpeg-turbo
+		return Graphics::crossBlit((byte *)target->getPixels(), (const byte *)_surface.getPixels(),
+		                           target->pitch, _surface.pitch, _surface.w, _surface.h,
+		                           target->format, _surface.format);
+	}
 
 	if (_colorSpace == kColorSpaceRGB && _surface.format != _requestedPixelFormat) {
 		_surface.convertToInPlace(_requestedPixelFormat); // Slow path
@@ -104,7 +104,31 @@ public:
 	 */
 	void setOutputColorSpace(ColorSpace outSpace) { _colorSpace = outSpace; }
 
+	/**
+	 * Decode an image straight into a surface of the caller, instead of the
+	 * surface of the decoder, which is left as it was.
+	 *
+	 * If the surface has no pixels, it is created with the size of the image
+	 * and the format set with setOutputPixelFormat(), and then belongs to
+	 * the caller. Otherwise, the image must have the size of the surface.
+	 * libjpeg writes the rows into the surface when it can output its
+	 * format, which needs libjpeg-turbo. Otherwise, the image is decoded
+	 * then converted into the surface.
+	 *
+	 * Only the RGB color space is supported.
+	 *
+	 * @param stream  The JPEG image.
+	 * @param surface The surface to decode the image into.
+	 *
+	 * @return Whether the image was decoded.
+	 */
+	bool loadStreamInto(Common::SeekableReadStream &stream, Graphics::Surface &surface);
+
 private:
+	// The libjpeg decompression object, which is kept for the next images
+	struct DecompressContext;
+	DecompressContext *_context;
+
 	Graphics::Surface _surface;
 	Graphics::Palette _palette;
 	ColorSpace _colorSpace;
@@ -112,6 +136,8 @@ private:
 	CodecAccuracy _accuracy;
 
 	Graphics::PixelFormat getByteOrderRgbPixelFormat() const;
+	void destroyContext();
+	bool decodeImage(Common::SeekableReadStream &stream, Graphics::Surface *target);
 };
 /** @} */
 } // End of namespace Image
@@ -109,16 +109,32 @@ void pngFlushStream(png_structp pngPtr) {
  *
  */
 
+void PNGDecoder::createOutputSurface(int width, int height, const Graphics::PixelFormat &format) {
+	if (!_outputSurface)
+		_outputSurface = new Graphics::Surface();
+	else if (_outputSurface->getPixels() && _outputSurface->w == width && _outputSurface->h == height && _outputSurface->format == format)
+		return;
+
+	_outputSurface->create(width, height, format);
+}
+
 bool PNGDecoder::loadStream(Common::SeekableReadStream &stream) {
 #ifdef USE_PNG
-	destroy();
+	// libpng cannot reuse its read structures, but the surface of the
+	// previous image is kept, and reused when the new image has the same
+	// size and format. This saves an allocation per image to the image
+	// loader, which keeps its decoders.
+	_palette.clear();
+	_hasTransparentColor = false;
 
 	// First, check the PNG signature (if not set to skip it)
 	if (!_skipSignature) {
 		if (stream.readUint32BE() != MKTAG(0x89, 'P', 'N', 'G')) {
+			destroy();
 			return false;
 		}
 		if (stream.readUint32BE() != MKTAG(0x0d, 0x0a, 0x1a, 0x0a)) {
+			destroy();
 			return false;
 		}
 	}
@@ -129,11 +145,13 @@ bool PNGDecoder::loadStream(Common::SeekableReadStream &stream) {
 	// along with the png-loading code used in the sword25-engine.
 	png_structp pngPtr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
 	if (!pngPtr) {
+		destroy();
 		return false;
 	}
 	png_infop infoPtr = png_create_info_struct(pngPtr);
 	if (!infoPtr) {
 		png_destroy_read_struct(&pngPtr, NULL, NULL);
+		destroy();
 		return false;
 	}
 
@@ -160,8 +178,6 @@ bool PNGDecoder::loadStream(Common::SeekableReadStream &stream) {
 
 	// Allocate memory for the final image data.
 	// To keep memory framentation low this happens before allocating memory for temporary image data.
-	_outputSurface = new Graphics::Surface();
-
 	// Images of all color formats except PNG_COLOR_TYPE_PALETTE
 	// will be transformed into ARGB images
 	if (colorType == PNG_COLOR_TYPE_PALETTE && (_keepTransparencyPaletted || !png_get_valid(pngPtr, infoPtr, PNG_INFO_tRNS))) {
@@ -173,6 +189,7 @@ bool PNGDecoder::loadStream(Common::SeekableReadStream &stream) {
 		uint32 success = png_get_PLTE(pngPtr, infoPtr, &palette, &numPalette);
 		if (success != PNG_INFO_PLTE) {
 			png_destroy_read_struct(&pngPtr, &infoPtr, NULL);
+			destroy();
 			return false;
 		}
 
@@ -198,7 +215,7 @@ bool PNGDecoder::loadStream(Common::SeekableReadStream &stream) {
 			}
 		}
 
-		_outputSurface->create(width, height,
+		createOutputSurface(width, height,
 			hasRgbaPalette ? getByteOrderRgbaPixelFormat(true) : Graphics::PixelFormat::createFormatCLUT8());
 		png_set_packing(pngPtr);
 
@@ -221,7 +238,7 @@ bool PNGDecoder::loadStream(Common::SeekableReadStream &stream) {
 			png_set_expand(pngPtr);
 		}
 
-		_outputSurface->create(width, height, getByteOrderRgbaPixelFormat(isAlpha));
+		createOutputSurface(width, height, getByteOrderRgbaPixelFormat(isAlpha));
 		if (!_outputSurface->getPixels()) {
 			error("Could not allocate memory for output image.");
 		}
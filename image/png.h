@@ -69,6 +69,7 @@ public:
 	void setKeepTransparencyPaletted(bool keep) { _keepTransparencyPaletted = keep; }
 private:
 	Graphics::PixelFormat getByteOrderRgbaPixelFormat(bool isAlpha) const;
+	void createOutputSurface(int width, int height, const Graphics::PixelFormat &format);
 
 	Graphics::Palette _palette;
 
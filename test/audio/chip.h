@@ -0,0 +1,94 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/chip.h"
+#include "common/system.h"
+#include "common/thread.h"
+
+#include "../null_osystem.h"
+
+/** A chip which queues its writes, and records where the callbacks run. */
+class QueuingChip : public Audio::EmulatedChip {
+public:
+	enum {
+		kRate = 1000,
+		kTimerFrequency = 100
+	};
+
+	Common::Array<int> callbackFrames;
+	Common::Array<int> otherThreadFrames;
+	Common::Array<int> generatedSamples;
+
+	QueuingChip() {
+		_callback.reset(new Common::Functor0Mem<void, QueuingChip>(this, &QueuingChip::onTimer));
+		setCallbackFrequency(kTimerFrequency);
+	}
+
+	using Audio::EmulatedChip::getCallbackFrame;
+
+	int getRate() const override { return kRate; }
+	bool isStereo() const override { return false; }
+
+protected:
+	bool queuesWrites() const override { return true; }
+
+	void generateSamples(int16 *buffer, int numSamples) override {
+		memset(buffer, 0, numSamples * sizeof(int16));
+		generatedSamples.push_back(numSamples);
+	}
+
+private:
+	static void readCallbackFrame(void *data) {
+		QueuingChip *chip = (QueuingChip *)data;
+		chip->otherThreadFrames.push_back(chip->getCallbackFrame());
+	}
+
+	void onTimer() {
+		callbackFrames.push_back(getCallbackFrame());
+
+		// The writes of the other threads meanwhile are not queued
+		Common::ThreadInternal *thread = g_system->createThread(readCallbackFrame, this);
+		if (thread) {
+			thread->join();
+			delete thread;
+		}
+	}
+};
+
+class ChipTestSuite : public CxxTest::TestSuite {
+public:
+	void test_queued_writes() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		QueuingChip chip;
+		int16 buffer[35];
+		TS_ASSERT_EQUALS(chip.readBuffer(buffer, 35), 35);
+		TS_ASSERT_EQUALS(chip.readBuffer(buffer, 35), 35);
+
+		// A callback every 10 frames, the last one at the end of the buffer
+		static const int expectedFrames[] = { 0, 10, 20, 30, 5, 15, 25, 35 };
+		TS_ASSERT_EQUALS(chip.callbackFrames.size(), ARRAYSIZE(expectedFrames));
+		if (!g_system->getCurrentThreadId()) {
+			// Without thread identifiers, the chunks between the callbacks
+			// are generated one by one, and the writes applied right away
+			for (uint i = 0; i < chip.callbackFrames.size(); i++)
+				TS_ASSERT_EQUALS(chip.callbackFrames[i], -1);
+			return;
+		}
+
+		for (uint i = 0; i < chip.callbackFrames.size() && i < ARRAYSIZE(expectedFrames); i++)
+			TS_ASSERT_EQUALS(chip.callbackFrames[i], expectedFrames[i]);
+		TS_ASSERT_EQUALS(chip.otherThreadFrames.size(), chip.callbackFrames.size());
+		for (uint i = 0; i < chip.otherThreadFrames.size(); i++)
+			TS_ASSERT_EQUALS(chip.otherThreadFrames[i], -1);
+
+		// Each buffer is generated at once
+		TS_ASSERT_EQUALS(chip.generatedSamples.size(), 2u);
+		for (uint i = 0; i < chip.generatedSamples.size(); i++)
+			TS_ASSERT_EQUALS(chip.generatedSamples[i], 35);
+
+		// Outside of the callbacks, the writes are never queued
+		TS_ASSERT_EQUALS(chip.getCallbackFrame(), -1);
+#endif
+	}
+};
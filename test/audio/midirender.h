@@ -0,0 +1,257 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/midirender.h"
+#include "common/compression/deflate.h"
+#include "common/config-manager.h"
+#include "common/fs.h"
+#include "common/ptr.h"
+#include "common/system.h"
+
+#include "../null_osystem.h"
+
+class MidiRenderCacheTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kRate = 10000,
+		kNumFrames = 3000,
+		kEndFrame = 2000
+	};
+
+	static const byte *getSong(uint32 &size) {
+		static const byte song[] = {
+			'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96,
+			'M', 'T', 'r', 'k', 0, 0, 0, 12,
+			0x00, 0x90, 60, 100,
+			0x60, 0x80, 60, 0,
+			0x60, 0xFF, 0x2F, 0x00
+		};
+		size = sizeof(song);
+		return song;
+	}
+
+	Common::FSNode _dir;
+	bool _hadCachePath;
+	Common::String _cachePath;
+
+	static Common::String getKey(int track = 0) {
+		uint32 size;
+		const byte *song = getSong(size);
+		return Audio::MidiRenderer::getCacheKey(song, size, track, "test", kRate);
+	}
+
+	static int16 getSample(uint32 frame) {
+		return (int16)(frame * 7);
+	}
+
+	static Audio::MidiRenderMarkers makeMarkers() {
+		Audio::MidiRenderMarkers markers;
+		markers.rate = kRate;
+		markers.stereo = false;
+		markers.numFrames = kNumFrames;
+		markers.endFrame = kEndFrame;
+
+		Audio::MidiRenderMarkers::TickFrame tick = { 0, 0 };
+		markers.ticks.push_back(tick);
+		tick.tick = 96;
+		tick.frame = 1000;
+		markers.ticks.push_back(tick);
+
+		Audio::MidiRenderMarkers::JumpIndexFrame jumpIndex = { 3, 1500 };
+		markers.jumpIndices.push_back(jumpIndex);
+		return markers;
+	}
+
+	/** Write the files of a rendering, the way MidiRenderer does. */
+	static void writeCache(const Common::String &key, const Audio::MidiRenderMarkers *markers, uint32 numFrames) {
+		Common::ScopedPtr<Common::WriteStream> pcm(Common::wrapCompressedWriteStream(Audio::MidiRenderer::getCacheFile(key, "pcm").createWriteStream()));
+		TS_ASSERT(pcm);
+		if (!pcm)
+			return;
+		for (uint32 frame = 0; frame < numFrames; frame++)
+			pcm->writeSint16LE(getSample(frame));
+		pcm->finalize();
+
+		Common::ScopedPtr<Common::WriteStream> stream(Common::wrapCompressedWriteStream(Audio::MidiRenderer::getCacheFile(key, "markers").createWriteStream()));
+		TS_ASSERT(stream);
+		if (stream && markers) {
+			markers->save(*stream);
+			stream->finalize();
+		}
+	}
+
+	/** Check the samples of a cached song, from @p frame. */
+	static uint64 getCacheSize(const Common::String &key) {
+		int64 pcmSize, markersSize, modificationTime;
+		TS_ASSERT(Audio::MidiRenderer::getCacheFile(key, "pcm").getFileStat(pcmSize, modificationTime));
+		TS_ASSERT(Audio::MidiRenderer::getCacheFile(key, "markers").getFileStat(markersSize, modificationTime));
+		return pcmSize + markersSize;
+	}
+
+	static bool isCached(const Common::String &key) {
+		Audio::MidiRenderMarkers markers;
+		return Audio::MidiRenderer::loadCachedMarkers(key, markers);
+	}
+
+	static void checkStream(Audio::AudioStream *stream, uint32 frame, uint32 numSamples, bool loop) {
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+
+		int16 *buffer = new int16[numSamples + 100];
+		TS_ASSERT_EQUALS(stream->readBuffer(buffer, numSamples + 100), loop ? (int)numSamples + 100 : (int)numSamples);
+		TS_ASSERT_EQUALS(stream->endOfData(), !loop);
+
+		for (uint32 i = 0; i < numSamples; i++, frame++) {
+			if (loop && frame >= kEndFrame)
+				frame = 0;
+			if (buffer[i] != getSample(frame)) {
+				TS_FAIL("The cached samples are not the ones rendered");
+				break;
+			}
+		}
+
+		delete[] buffer;
+		delete stream;
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+		_dir = Common::createTestTempDirectory();
+
+		// Point the cache to the temporary directory for the test only
+		Common::ConfigManager::Domain *transient = ConfMan.getDomain(Common::ConfigManager::kTransientDomain);
+		_hadCachePath = transient->tryGetVal("music_render_cache_path", _cachePath);
+		transient->setVal("music_render_cache_path", _dir.getPath().toString(Common::Path::kNativeSeparator));
+	}
+
+	void tearDown() {
+		Common::ConfigManager::Domain *transient = ConfMan.getDomain(Common::ConfigManager::kTransientDomain);
+		if (_hadCachePath)
+			transient->setVal("music_render_cache_path", _cachePath);
+		else
+			transient->erase("music_render_cache_path");
+
+		Common::removeTestTempDirectory(_dir);
+	}
+
+	void test_cache_directory() {
+		TS_ASSERT_EQUALS(Audio::MidiRenderer::getCacheDirectory().getPath(), _dir.getPath());
+		TS_ASSERT_EQUALS(Audio::MidiRenderer::getCacheFile(getKey(), "pcm").getPath(), _dir.getChild(getKey() + ".pcm").getPath());
+	}
+
+	void test_cache_hit() {
+		const Common::String key = getKey();
+		const Audio::MidiRenderMarkers expected = makeMarkers();
+		writeCache(key, &expected, kNumFrames);
+
+		Audio::MidiRenderMarkers markers;
+		TS_ASSERT(Audio::MidiRenderer::loadCachedMarkers(key, markers));
+		TS_ASSERT_EQUALS(markers.rate, kRate);
+		TS_ASSERT(!markers.stereo);
+		TS_ASSERT_EQUALS(markers.numFrames, (uint32)kNumFrames);
+		TS_ASSERT_EQUALS(markers.endFrame, (uint32)kEndFrame);
+		TS_ASSERT_EQUALS(markers.loopStartFrame, -1);
+		TS_ASSERT_EQUALS(markers.getTickFrame(50), 1000);
+		TS_ASSERT_EQUALS(markers.getTickFrame(97), -1);
+		TS_ASSERT_EQUALS(markers.getJumpIndexFrame(3), 1500);
+		TS_ASSERT_EQUALS(markers.getJumpIndexFrame(4), -1);
+
+		// The whole song, then from a tick, with the release of the last notes
+		checkStream(Audio::MidiRenderer::openCachedStream(key, markers, 0, false), 0, kNumFrames, false);
+		checkStream(Audio::MidiRenderer::openCachedStream(key, markers, 1000, false), 1000, kNumFrames - 1000, false);
+
+		// A looping song jumps back at the end of the track
+		checkStream(Audio::MidiRenderer::openCachedStream(key, markers, 1500, true), 1500, 5000, true);
+	}
+
+	void test_cache_miss() {
+		const Common::String key = getKey();
+		const Audio::MidiRenderMarkers expected = makeMarkers();
+		Audio::MidiRenderMarkers markers;
+
+		TS_ASSERT(!Audio::MidiRenderer::loadCachedMarkers("0123456789abcdef0123456789abcdef-01234567", markers));
+
+		// The markers are written last: without them, the rendering is incomplete
+		writeCache(key, nullptr, kNumFrames);
+		TS_ASSERT(!Audio::MidiRenderer::loadCachedMarkers(key, markers));
+
+		writeCache(key, &expected, kNumFrames);
+		TS_ASSERT(Audio::MidiRenderer::loadCachedMarkers(key, markers));
+	}
+
+	void test_cache_invalidation() {
+		uint32 size;
+		const byte *song = getSong(size);
+		const Common::String key = getKey();
+
+		// Anything which changes the rendering changes the key
+		byte *other = (byte *)malloc(size);
+		memcpy(other, song, size);
+		other[size - 6]++;
+		TS_ASSERT_DIFFERS(Audio::MidiRenderer::getCacheKey(other, size, 0, "test", kRate), key);
+		free(other);
+
+		TS_ASSERT_DIFFERS(Audio::MidiRenderer::getCacheKey(song, size, 1, "test", kRate), key);
+		TS_ASSERT_DIFFERS(Audio::MidiRenderer::getCacheKey(song, size, 0, "other", kRate), key);
+		TS_ASSERT_DIFFERS(Audio::MidiRenderer::getCacheKey(song, size, 0, "test", 22050), key);
+
+		Common::ConfigManager::Domain *transient = ConfMan.getDomain(Common::ConfigManager::kTransientDomain);
+		transient->setVal("midi_gain", "150");
+		TS_ASSERT_DIFFERS(getKey(), key);
+		transient->erase("midi_gain");
+		TS_ASSERT_EQUALS(getKey(), key);
+
+		// The samples must be as long as the markers tell
+		const Audio::MidiRenderMarkers expected = makeMarkers();
+		Audio::MidiRenderMarkers markers;
+		writeCache(key, &expected, kNumFrames - 100);
+		TS_ASSERT(Audio::MidiRenderer::loadCachedMarkers(key, markers));
+		TS_ASSERT(!Audio::MidiRenderer::openCachedStream(key, markers, 0, false));
+
+		// Markers which do not fit the song are not used
+		Audio::MidiRenderMarkers invalid = makeMarkers();
+		invalid.endFrame = kNumFrames + 1;
+		writeCache(key, &invalid, kNumFrames);
+		TS_ASSERT(!Audio::MidiRenderer::loadCachedMarkers(key, markers));
+	}
+
+	void test_cache_eviction() {
+		const Audio::MidiRenderMarkers markers = makeMarkers();
+		const Common::String first = getKey(0), second = getKey(1), leftover = getKey(2);
+		writeCache(first, &markers, kNumFrames);
+		writeCache(second, &markers, kNumFrames);
+		writeCache(leftover, &markers, kNumFrames);
+		const uint64 songSize = getCacheSize(first);
+
+		// Loading the markers uses a song, and the song missing from the
+		// index is evicted before the least recently used one
+		TS_ASSERT(isCached(second));
+		TS_ASSERT(isCached(first));
+		Audio::MidiRenderer::purgeCache(songSize * 3);
+		TS_ASSERT(Audio::MidiRenderer::getCacheFile(leftover, "pcm").exists());
+
+		Audio::MidiRenderer::purgeCache(songSize * 2);
+		TS_ASSERT(!Audio::MidiRenderer::getCacheFile(leftover, "pcm").exists());
+		TS_ASSERT(!Audio::MidiRenderer::getCacheFile(leftover, "markers").exists());
+		TS_ASSERT(Audio::MidiRenderer::getCacheFile(second, "pcm").exists());
+
+		Audio::MidiRenderer::purgeCache(songSize);
+		TS_ASSERT(!Audio::MidiRenderer::getCacheFile(second, "pcm").exists());
+		TS_ASSERT(isCached(first));
+
+		// A song which is used again moves to the end of the index
+		writeCache(second, &markers, kNumFrames);
+		TS_ASSERT(isCached(second));
+		TS_ASSERT(isCached(first));
+		Audio::MidiRenderer::purgeCache(songSize);
+		TS_ASSERT(!isCached(second));
+		TS_ASSERT(isCached(first));
+
+		// Purging to 0 empties the cache
+		Audio::MidiRenderer::purgeCache(0);
+		TS_ASSERT(!isCached(first));
+		TS_ASSERT(!Audio::MidiRenderer::getCacheFile(first, "pcm").exists());
+	}
+};
@@ -0,0 +1,147 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/decoders/raw.h"
+#include "audio/mixer_intern.h"
+#include "audio/rate_kernels.h"
+
+#include "../null_osystem.h"
+
+class MixerTestSuite : public CxxTest::TestSuite {
+private:
+	int16 _data[4096];
+	int16 _output[512];
+
+	Audio::AudioStream *makeStream() {
+		return Audio::makeRawStream((const byte *)_data, sizeof(_data), 22050, Audio::FLAG_16BITS, DisposeAfterUse::NO);
+	}
+
+	void play(Audio::Mixer &mixer, Audio::Mixer::SoundType type, Audio::SoundHandle *handle, int id = -1) {
+		mixer.playStream(type, handle, makeStream(), id);
+	}
+
+	void mix(Audio::MixerImpl &mixer) {
+		mixer.mixCallback((byte *)_output, sizeof(_output));
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+		// The test backend has no graphics manager to ask about the CPU features
+		Audio::RateKernels::kernels = &Audio::RateKernels::generic;
+		for (uint i = 0; i < ARRAYSIZE(_data); ++i)
+			_data[i] = 1000;
+	}
+
+	void test_settings_are_visible_before_mixing() {
+		Audio::MixerImpl mixer(22050, true, 128);
+		mixer.setReady(true);
+
+		Audio::SoundHandle handle;
+		play(mixer, Audio::Mixer::kSFXSoundType, &handle, 7);
+		TS_ASSERT(mixer.isSoundHandleActive(handle));
+		TS_ASSERT(mixer.isSoundIDActive(7));
+		TS_ASSERT_EQUALS(mixer.getSoundID(handle), 7);
+		TS_ASSERT(mixer.hasActiveChannelOfType(Audio::Mixer::kSFXSoundType));
+		TS_ASSERT(!mixer.hasActiveChannelOfType(Audio::Mixer::kMusicSoundType));
+
+		// The changes are queued, but reading them back must not wait for the mixer
+		mixer.setChannelVolume(handle, 100);
+		mixer.setChannelBalance(handle, -20);
+		mixer.setChannelRate(handle, 11025);
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(handle), 100);
+		TS_ASSERT_EQUALS(mixer.getChannelBalance(handle), -20);
+		TS_ASSERT_EQUALS(mixer.getChannelRate(handle), 11025u);
+
+		mix(mixer);
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(handle), 100);
+		TS_ASSERT_EQUALS(mixer.getChannelBalance(handle), -20);
+		TS_ASSERT_EQUALS(mixer.getChannelRate(handle), 11025u);
+
+		mixer.resetChannelRate(handle);
+		TS_ASSERT_EQUALS(mixer.getChannelRate(handle), 22050u);
+	}
+
+	void test_queued_volume_is_applied() {
+		Audio::MixerImpl mixer(22050, false, 128);
+		mixer.setReady(true);
+
+		Audio::SoundHandle handle;
+		play(mixer, Audio::Mixer::kPlainSoundType, &handle);
+
+		mixer.setChannelVolume(handle, 0);
+		mix(mixer);
+		for (uint i = 0; i < ARRAYSIZE(_output); ++i)
+			TS_ASSERT_EQUALS(_output[i], 0);
+
+		mixer.setChannelVolume(handle, Audio::Mixer::kMaxChannelVolume);
+		mix(mixer);
+		TS_ASSERT_DIFFERS(_output[0], 0);
+	}
+
+	void test_stop() {
+		Audio::MixerImpl mixer(22050, true, 128);
+		mixer.setReady(true);
+
+		Audio::SoundHandle handle;
+		play(mixer, Audio::Mixer::kSFXSoundType, &handle, 3);
+		mixer.setChannelVolume(handle, 10);
+		mixer.stopHandle(handle);
+
+		TS_ASSERT(!mixer.isSoundHandleActive(handle));
+		TS_ASSERT(!mixer.isSoundIDActive(3));
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(handle), 0);
+
+		// A stale command for the stopped channel must be dropped
+		mix(mixer);
+		TS_ASSERT(!mixer.isSoundHandleActive(handle));
+	}
+
+	void test_stream_end() {
+		Audio::MixerImpl mixer(22050, true, 128);
+		mixer.setReady(true);
+
+		Audio::SoundHandle handle;
+		play(mixer, Audio::Mixer::kSFXSoundType, &handle);
+
+		// The stream is 4096 samples long, which is 16 callbacks of 256 frames
+		for (int i = 0; i < 20 && mixer.isSoundHandleActive(handle); ++i)
+			mix(mixer);
+		TS_ASSERT(!mixer.isSoundHandleActive(handle));
+	}
+
+	void test_channels_are_clipped_once() {
+		Audio::MixerImpl mixer(22050, false, 256);
+		Audio::Mixer &base = mixer;
+		mixer.setReady(true);
+
+		// Two loud channels and one which cancels one of them: clipping each
+		// addition would lose what the first two add above the maximum
+		static const int16 levels[] = { 30000, 30000, -30000 };
+		int16 data[ARRAYSIZE(levels)][256];
+		for (uint c = 0; c < ARRAYSIZE(levels); ++c) {
+			for (uint i = 0; i < 256; ++i)
+				WRITE_BE_INT16(&data[c][i], levels[c]);
+
+			Audio::SoundHandle handle;
+			base.playStream(Audio::Mixer::kPlainSoundType, &handle,
+				Audio::makeRawStream((const byte *)data[c], sizeof(data[c]), 22050, Audio::FLAG_16BITS, DisposeAfterUse::NO));
+		}
+
+		mix(mixer);
+		for (uint i = 0; i < 256; ++i)
+			TS_ASSERT_EQUALS(_output[i], 30000);
+
+		// Beyond the sample range, the sum is clipped
+		mixer.stopAll();
+		for (uint c = 0; c < 2; ++c) {
+			Audio::SoundHandle handle;
+			base.playStream(Audio::Mixer::kPlainSoundType, &handle,
+				Audio::makeRawStream((const byte *)data[c], sizeof(data[c]), 22050, Audio::FLAG_16BITS, DisposeAfterUse::NO));
+		}
+
+		mix(mixer);
+		for (uint i = 0; i < 256; ++i)
+			TS_ASSERT_EQUALS(_output[i], 32767);
+	}
+};
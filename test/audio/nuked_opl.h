@@ -0,0 +1,201 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/softsynth/opl/nuked.h"
+#include "audio/softsynth/opl/nuked_kernels.h"
+
+#include "test/kernel_tables.h"
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+#ifndef DISABLE_NUKED_OPL
+
+class NukedOPLTestSuite : public CxxTest::TestSuite
+{
+private:
+	typedef OPL::NUKED::NukedKernels NukedKernels;
+
+	TestRandom _random;
+
+	/** A random register write, keeping the chip in OPL3 mode most of the time. */
+	OPL::NUKED::opl3_blockwrite randomWrite(uint32 sample) {
+		OPL::NUKED::opl3_blockwrite write;
+		write.sample = sample;
+		write.data = _random.next() & 0xff;
+
+		const uint32 kind = _random.next() % 32;
+		if (kind == 0) {
+			// Rhythm mode and the depth of the vibrato and tremolo
+			write.reg = 0xbd;
+		} else if (kind == 1) {
+			// 4-op channels
+			write.reg = 0x104;
+			write.data &= 0x3f;
+		} else if (kind == 2) {
+			write.reg = 0x105;
+			write.data = (_random.next() % 4) != 0;
+		} else if (kind < 8) {
+			// Key on and off
+			write.reg = (_random.next() & 0x100) | (0xb0 + _random.next() % 9);
+		} else {
+			write.reg = (_random.next() & 0x100) | (0x20 + _random.next() % 0xd6);
+		}
+		return write;
+	}
+
+	void resetChip(OPL::NUKED::opl3_chip *chip, uint32 rate) {
+		OPL::NUKED::OPL3_Reset(chip, rate);
+		OPL::NUKED::OPL3_WriteReg(chip, 0x105, 0x01);
+		for (uint16 reg = 0x20; reg < 0xf6; reg++) {
+			OPL::NUKED::OPL3_WriteReg(chip, reg, _random.next() & 0xff);
+			OPL::NUKED::OPL3_WriteReg(chip, reg | 0x100, _random.next() & 0xff);
+		}
+	}
+
+	/**
+	 * Generates blocks of random sizes with random writes, and checks them
+	 * against the samples generated one by one.
+	 */
+	void checkBlocks(const NukedKernels::Table &kernels, uint32 rate, uint32 seed) {
+		OPL::NUKED::opl3_chip *expectedChip = new OPL::NUKED::opl3_chip();
+		OPL::NUKED::opl3_chip *actualChip = new OPL::NUKED::opl3_chip();
+		int16 expected[2 * 2048], actual[2 * 2048];
+		bool sound = false;
+
+		NukedKernels::kernels = &kernels;
+
+		_random.setSeed(seed);
+		resetChip(expectedChip, rate);
+		_random.setSeed(seed);
+		resetChip(actualChip, rate);
+
+		for (int block = 0; block < 24; block++) {
+			const uint32 numSamples = 1 + _random.next() % 2048;
+			Common::Array<OPL::NUKED::opl3_blockwrite> writes;
+
+			// Some of the writes fall after the end of the block
+			const uint32 numWrites = _random.next() % 64;
+			uint32 sample = 0;
+			for (uint32 i = 0; i < numWrites; i++) {
+				sample += _random.next() % (2 * numSamples / (numWrites + 1) + 1);
+				writes.push_back(randomWrite(sample));
+			}
+
+			uint32 w = 0;
+			for (uint32 i = 0; i < numSamples; i++) {
+				for (; w < writes.size() && writes[w].sample <= i; w++)
+					OPL::NUKED::OPL3_WriteRegBuffered(expectedChip, writes[w].reg, writes[w].data);
+				OPL::NUKED::OPL3_GenerateStream(expectedChip, expected + 2 * i, 1);
+			}
+			for (; w < writes.size(); w++)
+				OPL::NUKED::OPL3_WriteRegBuffered(expectedChip, writes[w].reg, writes[w].data);
+
+			OPL::NUKED::OPL3_GenerateBlock(actualChip, actual, numSamples, writes.data(), writes.size());
+
+			TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(int16) * 2 * numSamples), 0);
+			for (uint32 i = 0; i < 2 * numSamples; i++)
+				sound |= (expected[i] != 0);
+		}
+
+		TS_ASSERT(sound);
+
+		NukedKernels::kernels = nullptr;
+		delete expectedChip;
+		delete actualChip;
+	}
+
+public:
+	void test_generate_block() {
+		Common::Array<const NukedKernels::Table *> tables = getKernelTables<NukedKernels>();
+		for (uint i = 0; i < tables.size(); i++) {
+			checkBlocks(*tables[i], 49716, 1);
+			checkBlocks(*tables[i], 44100, 2);
+			checkBlocks(*tables[i], 22050, 3);
+		}
+	}
+
+	void test_generate_block_rhythm() {
+		Common::Array<const NukedKernels::Table *> tables = getKernelTables<NukedKernels>();
+		for (uint i = 0; i < tables.size(); i++) {
+			OPL::NUKED::opl3_chip *expectedChip = new OPL::NUKED::opl3_chip();
+			OPL::NUKED::opl3_chip *actualChip = new OPL::NUKED::opl3_chip();
+			int16 expected[2 * 4096], actual[2 * 4096];
+
+			NukedKernels::kernels = tables[i];
+
+			// All the channels keyed on, with the drums hit now and then
+			_random.setSeed(4);
+			resetChip(expectedChip, 49716);
+			_random.setSeed(4);
+			resetChip(actualChip, 49716);
+
+			Common::Array<OPL::NUKED::opl3_blockwrite> writes;
+			for (uint32 sample = 0; sample < 4096; sample += 256) {
+				OPL::NUKED::opl3_blockwrite write;
+				write.sample = sample;
+				write.reg = 0xbd;
+				write.data = 0x20 | (_random.next() & 0xdf);
+				writes.push_back(write);
+			}
+
+			uint32 w = 0;
+			for (uint32 s = 0; s < 4096; s++) {
+				for (; w < writes.size() && writes[w].sample <= s; w++)
+					OPL::NUKED::OPL3_WriteRegBuffered(expectedChip, writes[w].reg, writes[w].data);
+				OPL::NUKED::OPL3_GenerateStream(expectedChip, expected + 2 * s, 1);
+			}
+			OPL::NUKED::OPL3_GenerateBlock(actualChip, actual, 4096, writes.data(), writes.size());
+
+			TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(expected)), 0);
+
+			NukedKernels::kernels = nullptr;
+			delete expectedChip;
+			delete actualChip;
+		}
+	}
+
+	void test_generate_block_speed() {
+#if BENCHMARK_TIME
+		Common::install_null_g_system();
+
+#ifdef SLOW_TESTS
+		const uint32 numBlocks = 2000;
+#else
+		const uint32 numBlocks = 20;
+#endif
+		const uint32 blockSize = 2048;
+		OPL::NUKED::opl3_chip *chip = new OPL::NUKED::opl3_chip();
+		int16 *buffer = new int16[2 * blockSize];
+
+		_random.setSeed(5);
+		resetChip(chip, 44100);
+		uint32 start = g_system->getMillis();
+		for (uint32 i = 0; i < numBlocks; i++)
+			OPL::NUKED::OPL3_GenerateStream(chip, buffer, blockSize);
+		uint32 streamTime = g_system->getMillis() - start;
+		debug("Nuked OPL3, %u samples one by one: %u ms", numBlocks * blockSize, streamTime);
+
+		Common::Array<const NukedKernels::Table *> tables = getKernelTables<NukedKernels>();
+		for (uint t = 0; t < tables.size(); t++) {
+			NukedKernels::kernels = tables[t];
+			_random.setSeed(5);
+			resetChip(chip, 44100);
+			start = g_system->getMillis();
+			for (uint32 i = 0; i < numBlocks; i++)
+				OPL::NUKED::OPL3_GenerateBlock(chip, buffer, blockSize, nullptr, 0);
+			debug("Nuked OPL3, %u samples in blocks with kernels %u: %u ms", numBlocks * blockSize, t, g_system->getMillis() - start);
+		}
+		NukedKernels::kernels = nullptr;
+
+		delete[] buffer;
+		delete chip;
+#endif
+	}
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/prefetching_stream.h"
+
+#include "../null_osystem.h"
+
+#include "helper.h"
+
+class PrefetchingAudioStreamTestSuite : public CxxTest::TestSuite {
+private:
+	/** Read the whole stream in chunks of an odd size, which do not match the chunks decoded ahead. */
+	static int readAll(Audio::AudioStream *stream, int16 *buffer, int maxSamples, int step) {
+		int total = 0;
+		while (!stream->endOfData() && total < maxSamples) {
+			const int samples = stream->readBuffer(buffer + total, MIN(step, maxSamples - total));
+			if (samples == 0)
+				break;
+			total += samples;
+		}
+		return total;
+	}
+
+	void testReadSeek(const int sampleRate, const bool isStereo) {
+		const int time = 3;
+		const int channels = isStereo ? 2 : 1;
+		const int samples = sampleRate * time * channels;
+
+		int16 *sine = nullptr;
+		Audio::SeekableAudioStream *parent = createSineStream<int16>(sampleRate, time, &sine, false, isStereo);
+		Audio::PrefetchingAudioStream *stream = new Audio::PrefetchingAudioStream(parent);
+		TS_ASSERT_EQUALS(stream->isStereo(), isStereo);
+		TS_ASSERT_EQUALS(stream->getRate(), sampleRate);
+		TS_ASSERT_EQUALS(stream->getLength(), Audio::Timestamp(time * 1000, sampleRate));
+
+		int16 *buffer = new int16[samples + 1000];
+
+		TS_ASSERT_EQUALS(readAll(stream, buffer, samples + 1000, 1000 * channels + channels), samples);
+		TS_ASSERT_EQUALS(memcmp(buffer, sine, samples * sizeof(int16)), 0);
+		TS_ASSERT(stream->endOfData());
+		TS_ASSERT_EQUALS(stream->readBuffer(buffer, 100), 0);
+
+		// Rewind, then seek back in the middle of a read
+		TS_ASSERT(stream->rewind());
+		TS_ASSERT(!stream->endOfData());
+		TS_ASSERT_EQUALS(stream->readBuffer(buffer, 500 * channels), 500 * channels);
+		TS_ASSERT_EQUALS(memcmp(buffer, sine, 500 * channels * sizeof(int16)), 0);
+
+		TS_ASSERT(stream->seek(Audio::Timestamp(1000, sampleRate)));
+		const int offset = sampleRate * channels;
+		TS_ASSERT_EQUALS(readAll(stream, buffer, samples, 777 * channels), samples - offset);
+		TS_ASSERT_EQUALS(memcmp(buffer, sine + offset, (samples - offset) * sizeof(int16)), 0);
+		TS_ASSERT(stream->endOfData());
+
+		// Loop it, which rewinds it at each iteration
+		stream->rewind();
+		Audio::AudioStream *loop = Audio::makeLoopingAudioStream(stream, 3);
+		for (int i = 0; i < 3; i++) {
+			TS_ASSERT_EQUALS(readAll(loop, buffer, samples, samples), samples);
+			TS_ASSERT_EQUALS(memcmp(buffer, sine, samples * sizeof(int16)), 0);
+		}
+		TS_ASSERT(loop->endOfData());
+
+		delete loop;
+		delete[] buffer;
+		delete[] sine;
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+	}
+
+	void test_prefetching_mono_11025() {
+		testReadSeek(11025, false);
+	}
+
+	void test_prefetching_stereo_22050() {
+		testReadSeek(22050, true);
+	}
+
+	void test_make_without_threads() {
+		Audio::SeekableAudioStream *parent = createSineStream<int16>(11025, 1, nullptr, false, false);
+		Audio::SeekableAudioStream *stream = Audio::makePrefetchingAudioStream(parent);
+		// Without threads, decoding ahead on the mixer thread would not help
+		if (stream != parent)
+			TS_ASSERT(static_cast<Audio::PrefetchingAudioStream *>(stream)->hasThread());
+		delete stream;
+	}
+};
@@ -0,0 +1,214 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/decoders/raw.h"
+#include "audio/mixer.h"
+#include "audio/rate.h"
+#include "audio/rate_kernels.h"
+
+#include "common/memstream.h"
+
+#include "test/kernel_tables.h"
+
+class RateConverterTestSuite : public CxxTest::TestSuite
+{
+private:
+	TestRandom _random;
+
+	void fillRandom(int16 *buf, uint count) {
+		for (uint i = 0; i < count; ++i)
+			buf[i] = (int16)_random.next();
+	}
+
+	Common::Array<const Audio::RateKernels::Table *> getSIMDTables() {
+		// All but the generic kernels, which the others are checked against
+		Common::Array<const Audio::RateKernels::Table *> tables = getKernelTables<Audio::RateKernels>();
+		tables.remove_at(0);
+		return tables;
+	}
+
+	void checkMix(const Audio::RateKernels::Table &kernels, Audio::RateKernels::Mode mode, uint numFrames, Audio::st_volume_t volL, Audio::st_volume_t volR) {
+		const bool inStereo = (mode != Audio::RateKernels::kMonoToMono && mode != Audio::RateKernels::kMonoToStereo);
+		const bool outStereo = (mode != Audio::RateKernels::kMonoToMono && mode != Audio::RateKernels::kStereoToMono);
+
+		int16 in[128], expected[128], actual[128];
+		fillRandom(in, numFrames * (inStereo ? 2 : 1));
+		fillRandom(expected, numFrames * (outStereo ? 2 : 1));
+		memcpy(actual, expected, sizeof(expected));
+
+		Audio::RateKernels::generic.mix[mode](expected, in, numFrames, volL, volR);
+		kernels.mix[mode](actual, in, numFrames, volL, volR);
+
+		TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(int16) * numFrames * (outStereo ? 2 : 1)), 0);
+	}
+
+	void checkMixBus(const Audio::RateKernels::Table &kernels, Audio::RateKernels::Mode mode, uint numFrames, Audio::st_volume_t volL, Audio::st_volume_t volR) {
+		const bool inStereo = (mode != Audio::RateKernels::kMonoToMono && mode != Audio::RateKernels::kMonoToStereo);
+		const bool outStereo = (mode != Audio::RateKernels::kMonoToMono && mode != Audio::RateKernels::kStereoToMono);
+
+		int16 in[128];
+		int32 expected[128], actual[128];
+		fillRandom(in, numFrames * (inStereo ? 2 : 1));
+		for (uint i = 0; i < numFrames * (outStereo ? 2 : 1); ++i)
+			expected[i] = (int16)_random.next() * 3;
+		memcpy(actual, expected, sizeof(expected));
+
+		Audio::RateKernels::generic.mixBus[mode](expected, in, numFrames, volL, volR);
+		kernels.mixBus[mode](actual, in, numFrames, volL, volR);
+
+		TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(int32) * numFrames * (outStereo ? 2 : 1)), 0);
+	}
+
+	void checkConvert(const Audio::RateKernels::Table &kernels, Audio::st_rate_t inRate, Audio::st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo) {
+		const uint inSamples = 4000 * (inStereo ? 2 : 1);
+		const uint outSamples = 3000 * (outStereo ? 2 : 1);
+		const uint numFrames = 1500;
+
+		int16 *in = new int16[inSamples];
+		fillRandom(in, inSamples);
+
+		int16 *expected = new int16[outSamples];
+		int16 *actual = new int16[outSamples];
+		memset(expected, 0, sizeof(int16) * outSamples);
+		memset(actual, 0, sizeof(int16) * outSamples);
+
+		const Audio::RateKernels::Table *oldKernels = Audio::RateKernels::kernels;
+
+		for (int pass = 0; pass < 2; ++pass) {
+			Audio::RateKernels::kernels = pass ? &kernels : &Audio::RateKernels::generic;
+			int16 *out = pass ? actual : expected;
+
+			Audio::AudioStream *stream = Audio::makeRawStream((const byte *)in, inSamples * sizeof(int16), inRate,
+				Audio::FLAG_16BITS | (inStereo ? Audio::FLAG_STEREO : 0), DisposeAfterUse::NO);
+			Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, inStereo, outStereo, reverseStereo);
+
+			// Convert in two odd sized chunks to exercise the state kept between calls
+			int written = converter->convert(*stream, out, 333, 200, 256);
+			written += converter->convert(*stream, out + 333 * (outStereo ? 2 : 1), numFrames - 333, 256, 77);
+			TS_ASSERT_EQUALS(written, (int)numFrames);
+
+			delete converter;
+			delete stream;
+		}
+
+		Audio::RateKernels::kernels = oldKernels;
+
+		TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(int16) * outSamples), 0);
+
+		delete[] in;
+		delete[] expected;
+		delete[] actual;
+	}
+
+public:
+	void setUp() {
+		_random.setSeed(12345);
+	}
+
+	void test_mix_kernels() {
+		static const Audio::st_volume_t volumes[] = { 0, 1, 77, 128, 129, 255, Audio::RateKernels::kMaxSIMDVolume };
+		Common::Array<const Audio::RateKernels::Table *> tables = getSIMDTables();
+
+		for (uint t = 0; t < tables.size(); ++t) {
+			for (int mode = 0; mode < Audio::RateKernels::kModeCount; ++mode) {
+				for (uint numFrames = 0; numFrames <= 64; ++numFrames) {
+					for (uint v = 0; v < ARRAYSIZE(volumes); ++v)
+						checkMix(*tables[t], (Audio::RateKernels::Mode)mode, numFrames, volumes[v], volumes[ARRAYSIZE(volumes) - 1 - v]);
+				}
+			}
+		}
+	}
+
+	void test_mix_bus_kernels() {
+		static const Audio::st_volume_t volumes[] = { 0, 1, 77, 128, 129, 255, Audio::RateKernels::kMaxSIMDVolume };
+		Common::Array<const Audio::RateKernels::Table *> tables = getSIMDTables();
+
+		for (uint t = 0; t < tables.size(); ++t) {
+			for (int mode = 0; mode < Audio::RateKernels::kModeCount; ++mode) {
+				for (uint numFrames = 0; numFrames <= 64; ++numFrames) {
+					for (uint v = 0; v < ARRAYSIZE(volumes); ++v)
+						checkMixBus(*tables[t], (Audio::RateKernels::Mode)mode, numFrames, volumes[v], volumes[ARRAYSIZE(volumes) - 1 - v]);
+				}
+			}
+		}
+	}
+
+	void test_mix_bus_matches_clipped_mix() {
+		// A single channel mixed into a bus, then clipped, gives the same
+		// samples as when it is mixed into the output directly
+		for (int mode = 0; mode < Audio::RateKernels::kModeCount; ++mode) {
+			int16 in[128], expected[128], actual[128];
+			int32 bus[128];
+			fillRandom(in, ARRAYSIZE(in));
+			memset(expected, 0, sizeof(expected));
+			memset(bus, 0, sizeof(bus));
+
+			Audio::RateKernels::generic.mix[mode](expected, in, 64, 255, 256);
+			Audio::RateKernels::generic.mixBus[mode](bus, in, 64, 255, 256);
+			Audio::RateKernels::generic.clamp(actual, bus, ARRAYSIZE(bus));
+
+			TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(expected)), 0);
+		}
+	}
+
+	void test_clamp_kernels() {
+		Common::Array<const Audio::RateKernels::Table *> tables = getSIMDTables();
+
+		for (uint t = 0; t < tables.size(); ++t) {
+			for (uint numSamples = 0; numSamples <= 64; ++numSamples) {
+				int32 bus[64];
+				int16 expected[64], actual[64];
+				for (uint i = 0; i < numSamples; ++i)
+					bus[i] = (int16)_random.next() * (int32)(i % 5);
+				// Include both ends of the range
+				if (numSamples > 1) {
+					bus[0] = -32768;
+					bus[1] = 32767;
+				}
+
+				Audio::RateKernels::generic.clamp(expected, bus, numSamples);
+				tables[t]->clamp(actual, bus, numSamples);
+
+				TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(int16) * numSamples), 0);
+			}
+		}
+	}
+
+	void test_interpolate_kernels() {
+		Common::Array<const Audio::RateKernels::Table *> tables = getSIMDTables();
+
+		for (uint t = 0; t < tables.size(); ++t) {
+			for (uint numSamples = 0; numSamples <= 64; ++numSamples) {
+				int16 pairs[128], weights[128], expected[64], actual[64];
+				fillRandom(pairs, numSamples * 2);
+
+				for (uint i = 0; i < numSamples; ++i) {
+					// Include both ends of the weight range
+					int16 frac = (i == 0) ? 0 : (i == 1) ? Audio::RateKernels::kFracOne - 1 : (_random.next() & (Audio::RateKernels::kFracOne - 1));
+					weights[i * 2] = Audio::RateKernels::kFracOne - 1 - frac;
+					weights[i * 2 + 1] = frac;
+				}
+
+				Audio::RateKernels::generic.interpolate(expected, pairs, weights, numSamples);
+				tables[t]->interpolate(actual, pairs, weights, numSamples);
+
+				TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(int16) * numSamples), 0);
+			}
+		}
+	}
+
+	void test_converters() {
+		// Copy, simple and interpolating conversions
+		static const Audio::st_rate_t rates[][2] = { { 22050, 22050 }, { 44100, 22050 }, { 11025, 22050 }, { 22050, 48000 }, { 48000, 44100 } };
+		Common::Array<const Audio::RateKernels::Table *> tables = getSIMDTables();
+
+		for (uint t = 0; t < tables.size(); ++t) {
+			for (uint r = 0; r < ARRAYSIZE(rates); ++r) {
+				checkConvert(*tables[t], rates[r][0], rates[r][1], false, false, false);
+				checkConvert(*tables[t], rates[r][0], rates[r][1], false, true, false);
+				checkConvert(*tables[t], rates[r][0], rates[r][1], true, false, false);
+				checkConvert(*tables[t], rates[r][0], rates[r][1], true, true, false);
+				checkConvert(*tables[t], rates[r][0], rates[r][1], true, true, true);
+			}
+		}
+	}
+};
@@ -0,0 +1,108 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/fs.h"
+#include "common/ptr.h"
+#include "common/stream.h"
+
+#include "../../null_osystem.h"
+
+class MappedReadStreamTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kFileSize = 100000
+	};
+
+	Common::FSNode _dir;
+
+	static byte getByte(uint32 pos) {
+		return (byte)(pos * 7 + (pos >> 8));
+	}
+
+	Common::FSNode writeFile(const char *name, uint32 size) {
+		Common::FSNode file = _dir.getChild(name);
+		Common::ScopedPtr<Common::SeekableWriteStream> stream(file.createWriteStream(false));
+		TS_ASSERT(stream);
+		if (stream) {
+			for (uint32 i = 0; i < size; i++)
+				stream->writeByte(getByte(i));
+			stream->finalize();
+		}
+		return file;
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+		_dir = Common::createTestTempDirectory();
+	}
+
+	void tearDown() {
+		Common::removeTestTempDirectory(_dir);
+	}
+
+	void test_read_and_seek() {
+		Common::FSNode file = writeFile("mapped.bin", kFileSize);
+
+		Common::ScopedPtr<Common::SeekableReadStream> stream(file.createMappedReadStream());
+		// The file is only mapped where mmap is available
+		if (!stream)
+			return;
+
+		TS_ASSERT_EQUALS(stream->size(), kFileSize);
+		TS_ASSERT_EQUALS(stream->pos(), 0);
+
+		byte buffer[16];
+		TS_ASSERT_EQUALS(stream->read(buffer, sizeof(buffer)), sizeof(buffer));
+		for (uint32 i = 0; i < sizeof(buffer); i++)
+			TS_ASSERT_EQUALS(buffer[i], getByte(i));
+
+		TS_ASSERT(stream->seek(50000));
+		TS_ASSERT_EQUALS(stream->readByte(), getByte(50000));
+		TS_ASSERT(stream->seek(-2, SEEK_END));
+		TS_ASSERT_EQUALS(stream->pos(), kFileSize - 2);
+		TS_ASSERT_EQUALS(stream->read(buffer, sizeof(buffer)), 2u);
+		TS_ASSERT_EQUALS(buffer[1], getByte(kFileSize - 1));
+		TS_ASSERT(stream->eos());
+	}
+
+	void test_mapped_data() {
+		Common::FSNode file = writeFile("mapped.bin", kFileSize);
+
+		Common::ScopedPtr<Common::SeekableReadStream> stream(file.createMappedReadStream());
+		if (!stream)
+			return;
+
+		const byte *data = stream->getMappedData();
+		TS_ASSERT(data);
+		if (!data)
+			return;
+		for (uint32 i = 0; i < kFileSize; i++) {
+			if (data[i] != getByte(i)) {
+				TS_FAIL("The mapped data is not the contents of the file");
+				break;
+			}
+		}
+
+		// Reading does not move the mapped data
+		stream->seek(1000);
+		stream->readUint32LE();
+		TS_ASSERT_EQUALS(stream->getMappedData(), data);
+
+		// Files are only mapped when asked to
+		Common::ScopedPtr<Common::SeekableReadStream> plain(file.createReadStream());
+		TS_ASSERT(plain);
+		if (plain)
+			TS_ASSERT(!plain->getMappedData());
+	}
+
+	void test_not_mapped() {
+		Common::FSNode file = writeFile("empty.bin", 0);
+
+		Common::ScopedPtr<Common::SeekableReadStream> stream(file.createMappedReadStream());
+		TS_ASSERT(!stream);
+		stream.reset(_dir.createMappedReadStream());
+		TS_ASSERT(!stream);
+		stream.reset(_dir.getChild("missing.bin").createMappedReadStream());
+		TS_ASSERT(!stream);
+	}
+};
@@ -0,0 +1,298 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/atomic.h"
+#include "common/compression/deflate.h"
+#include "common/compression/unzip.h"
+#include "common/crc.h"
+#include "common/memstream.h"
+#include "common/system.h"
+#include "common/thread.h"
+
+#include "test/kernel_tables.h"
+
+#include "../../null_osystem.h"
+
+/** An archive stream which lets the other threads run in the middle of its uses. */
+class YieldingReadStream : public Common::SeekableReadStream {
+public:
+	explicit YieldingReadStream(Common::SeekableReadStream *stream) : _stream(stream) {}
+	~YieldingReadStream() override { delete _stream; }
+
+	bool eos() const override { return _stream->eos(); }
+	bool err() const override { return _stream->err(); }
+	void clearErr() override { _stream->clearErr(); }
+	int64 pos() const override { return _stream->pos(); }
+	int64 size() const override { return _stream->size(); }
+	bool seek(int64 offset, int whence = SEEK_SET) override { return _stream->seek(offset, whence); }
+
+	uint32 read(void *dataPtr, uint32 dataSize) override {
+		if (_reads.fetchAdd(1) % 4 == 0)
+			g_system->delayMillis(1);
+		return _stream->read(dataPtr, dataSize);
+	}
+
+private:
+	Common::SeekableReadStream *_stream;
+	Common::Atomic<uint32> _reads;
+};
+
+class ZipTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kSmallSize = 1000,
+		// Larger than the files the archive keeps in memory, and with a
+		// checkpoint after the first megabyte
+		kLargeSize = 1536 * 1024
+	};
+
+	struct File {
+		const char *name;
+		Common::Array<byte> data;
+		Common::Array<byte> compressed;
+		bool deflated;
+	};
+
+	struct StreamReader {
+		Common::SeekableReadStream *stream;
+		const Common::Array<byte> *data;
+		bool matches;
+		Common::Atomic<uint32> done;
+	};
+
+	/** Read a stream a few times on a worker thread, where the test cannot assert. */
+	static void readStream(void *data) {
+		StreamReader *reader = (StreamReader *)data;
+		const uint32 size = reader->data->size();
+		byte buffer[4096];
+
+		for (int i = 0; i < 2; i++) {
+			reader->stream->seek(0);
+			for (uint32 pos = 0; pos < size; pos += sizeof(buffer)) {
+				const uint32 length = MIN<uint32>(sizeof(buffer), size - pos);
+				if (reader->stream->read(buffer, length) != length || memcmp(buffer, reader->data->data() + pos, length))
+					reader->matches = false;
+			}
+		}
+		reader->done.store(1);
+	}
+
+	/** Return text-like data which compresses well, but not too well. */
+	Common::Array<byte> makeData(uint size, uint32 seed) {
+		TestRandom rnd(seed);
+		Common::Array<byte> data(size);
+		for (uint i = 0; i < size; i++)
+			data[i] = 'a' + rnd.next() % 16;
+		return data;
+	}
+
+	/** Return the raw deflate data, without the gzip header and footer. */
+	Common::Array<byte> deflate(const Common::Array<byte> &data) {
+		Common::MemoryWriteStreamDynamic *memory = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+		Common::WriteStream *gzip = Common::wrapCompressedWriteStream(memory);
+		gzip->write(data.data(), data.size());
+		gzip->finalize();
+
+		Common::Array<byte> compressed(memory->getData() + 10, memory->size() - 18);
+		delete gzip;
+		return compressed;
+	}
+
+	void checkRead(Common::SeekableReadStream &stream, const Common::Array<byte> &data, uint32 pos, uint32 size) {
+		TS_ASSERT(stream.seek(pos));
+		TS_ASSERT_EQUALS(stream.pos(), (int64)pos);
+
+		Common::Array<byte> buffer(size);
+		TS_ASSERT_EQUALS(stream.read(buffer.data(), size), size);
+		TS_ASSERT_EQUALS(memcmp(buffer.data(), data.data() + pos, size), 0);
+	}
+
+	/** Read the whole stream, then seek backward and forward across the checkpoints. */
+	void checkStream(Common::SeekableReadStream &stream, const Common::Array<byte> &data) {
+		TS_ASSERT_EQUALS(stream.size(), (int64)data.size());
+		checkRead(stream, data, 0, data.size());
+
+		byte b;
+		TS_ASSERT_EQUALS(stream.read(&b, 1), 0u);
+		TS_ASSERT(stream.eos());
+
+		const uint32 size = data.size();
+		checkRead(stream, data, size / 2, size / 8);
+		checkRead(stream, data, 10, size / 4);
+		checkRead(stream, data, size - size / 8, size / 8);
+		checkRead(stream, data, size / 3, size / 3);
+		checkRead(stream, data, 0, 100);
+	}
+
+	Common::SeekableReadStream *makeZip(const Common::Array<File> &files) {
+		Common::CRC32 crc;
+		Common::MemoryWriteStreamDynamic zip(DisposeAfterUse::YES);
+		Common::MemoryWriteStreamDynamic centralDir(DisposeAfterUse::YES);
+
+		for (uint i = 0; i < files.size(); i++) {
+			const File &file = files[i];
+			const Common::Array<byte> &contents = file.deflated ? file.compressed : file.data;
+			const uint32 checksum = crc.crcFast(file.data.data(), file.data.size());
+			const uint16 nameLength = strlen(file.name);
+
+			centralDir.writeUint32LE(0x02014b50);
+			centralDir.writeUint16LE(20);
+			centralDir.writeUint16LE(20);
+			centralDir.writeUint16LE(0);
+			centralDir.writeUint16LE(file.deflated ? 8 : 0);
+			centralDir.writeUint32LE(0);
+			centralDir.writeUint32LE(checksum);
+			centralDir.writeUint32LE(contents.size());
+			centralDir.writeUint32LE(file.data.size());
+			centralDir.writeUint16LE(nameLength);
+			centralDir.writeUint16LE(0);
+			centralDir.writeUint16LE(0);
+			centralDir.writeUint16LE(0);
+			centralDir.writeUint16LE(0);
+			centralDir.writeUint32LE(0);
+			centralDir.writeUint32LE(zip.pos());
+			centralDir.write(file.name, nameLength);
+
+			zip.writeUint32LE(0x04034b50);
+			zip.writeUint16LE(20);
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(file.deflated ? 8 : 0);
+			zip.writeUint32LE(0);
+			zip.writeUint32LE(checksum);
+			zip.writeUint32LE(contents.size());
+			zip.writeUint32LE(file.data.size());
+			zip.writeUint16LE(nameLength);
+			zip.writeUint16LE(0);
+			zip.write(file.name, nameLength);
+			zip.write(contents.data(), contents.size());
+		}
+
+		const uint32 centralDirOffset = zip.pos();
+		zip.write(centralDir.getData(), centralDir.size());
+		zip.writeUint32LE(0x06054b50);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(files.size());
+		zip.writeUint16LE(files.size());
+		zip.writeUint32LE(centralDir.size());
+		zip.writeUint32LE(centralDirOffset);
+		zip.writeUint16LE(0);
+
+		byte *data = (byte *)malloc(zip.size());
+		memcpy(data, zip.getData(), zip.size());
+		return new Common::MemoryReadStream(data, zip.size(), DisposeAfterUse::YES);
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+	}
+
+	void test_deflate_checkpoints() {
+#ifdef USE_ZLIB
+		const Common::Array<byte> data = makeData(100000, 1);
+		const Common::Array<byte> compressed = deflate(data);
+
+		Common::SeekableReadStream *stream = Common::wrapSeekableDeflateReadStream(
+			new Common::MemoryReadStream(compressed.data(), compressed.size()), DisposeAfterUse::YES, data.size(), 4096);
+		TS_ASSERT(stream);
+		checkStream(*stream, data);
+		delete stream;
+#endif
+	}
+
+	void test_zip_members() {
+		Common::Array<File> files;
+		File file;
+
+		file.name = "small.txt";
+		file.data = makeData(kSmallSize, 2);
+		file.deflated = false;
+		files.push_back(file);
+
+		file.name = "stored.txt";
+		file.data = makeData(kLargeSize, 3);
+		files.push_back(file);
+
+#ifdef USE_ZLIB
+		file.name = "small-deflated.txt";
+		file.data = makeData(kSmallSize, 4);
+		file.compressed = deflate(file.data);
+		file.deflated = true;
+		files.push_back(file);
+
+		file.name = "deflated.txt";
+		file.data = makeData(kLargeSize, 5);
+		file.compressed = deflate(file.data);
+		files.push_back(file);
+#endif
+
+		Common::Archive *archive = Common::makeZipArchive(makeZip(files));
+		TS_ASSERT(archive);
+
+		Common::Array<Common::SeekableReadStream *> streams;
+		for (uint i = 0; i < files.size(); i++) {
+			Common::SeekableReadStream *stream = archive->createReadStreamForMember(files[i].name);
+			TS_ASSERT(stream);
+			streams.push_back(stream);
+		}
+
+		// Interleave the reads of the members, which share the archive stream
+		for (uint i = 0; i < files.size(); i++)
+			checkRead(*streams[i], files[i].data, files[i].data.size() / 4, 100);
+
+		// The streamed members stay valid after the archive is closed
+		delete archive;
+		for (uint i = 0; i < files.size(); i++) {
+			checkStream(*streams[i], files[i].data);
+			delete streams[i];
+		}
+	}
+
+	void test_zip_members_on_threads() {
+		Common::Array<File> files;
+		File file;
+
+		file.name = "stored.txt";
+		file.data = makeData(kLargeSize, 6);
+		file.deflated = false;
+		files.push_back(file);
+
+		file.name = "other.txt";
+		file.data = makeData(kLargeSize, 7);
+		files.push_back(file);
+
+		Common::Archive *archive = Common::makeZipArchive(new YieldingReadStream(makeZip(files)));
+		TS_ASSERT(archive);
+		if (!archive)
+			return;
+
+		StreamReader reader;
+		reader.stream = archive->createReadStreamForMember(files[0].name);
+		reader.data = &files[0].data;
+		reader.matches = true;
+		TS_ASSERT(reader.stream);
+
+		// A streamed member is read on a worker thread while the archive
+		// opens and reads the other one
+		Common::ThreadInternal *thread = g_system->createThread(readStream, &reader);
+		for (uint32 i = 0; thread && !reader.done.load(); i++) {
+			Common::SeekableReadStream *stream = archive->createReadStreamForMember(files[1].name);
+			TS_ASSERT(stream);
+			if (stream) {
+				checkRead(*stream, files[1].data, (i * 30011) % (kLargeSize - 4096), 4096);
+				delete stream;
+			}
+		}
+		if (thread) {
+			thread->join();
+			delete thread;
+		} else {
+			readStream(&reader);
+		}
+		TS_ASSERT(reader.matches);
+
+		delete reader.stream;
+		delete archive;
+	}
+};
@@ -0,0 +1,193 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/debug.h"
+#include "common/flat-hashmap.h"
+#include "common/hash-str.h"
+#include "common/system.h"
+
+#include "test/kernel_tables.h"
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite {
+private:
+	typedef Common::FlatHashMap<Common::String, int, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> IgnoreCaseMap;
+
+	TestRandom _random;
+
+	/** Paths like the ones of the members of a SearchSet. */
+	static Common::Array<Common::String> makePaths(uint count) {
+		static const char *const dirs[] = { "data", "video", "audio/speech", "audio/music", "rooms", "fonts" };
+		static const char *const exts[] = { "bmp", "smk", "wav", "ogg", "dat", "fnt" };
+		Common::Array<Common::String> paths;
+		for (uint i = 0; i < count; i++)
+			paths.push_back(Common::String::format("%s/room%03u/RES%05u.%s", dirs[i % 6], i / 37, i, exts[(i / 6) % 6]));
+		return paths;
+	}
+
+	/** Names like the ones of SCI selectors or Lingo variables. */
+	static Common::Array<Common::String> makeNames(uint count) {
+		static const char *const names[] = {
+			"x", "y", "view", "loop", "cel", "priority", "signal", "nsLeft", "nsTop", "nsRight",
+			"nsBottom", "client", "cycler", "mover", "init", "dispose", "doit", "handleEvent",
+			"setCycle", "setMotion", "cue", "state", "changeState", "number", "script"
+		};
+		Common::Array<Common::String> keys;
+		for (uint i = 0; i < count; i++) {
+			if (i < ARRAYSIZE(names))
+				keys.push_back(names[i]);
+			else
+				keys.push_back(Common::String::format("%s%u", names[i % ARRAYSIZE(names)], i));
+		}
+		return keys;
+	}
+
+	template<class Map>
+	uint32 timeLookups(const Common::Array<Common::String> &keys, int iters, uint &found) {
+		Map map;
+		for (uint i = 0; i < keys.size(); i += 2)
+			map[keys[i]] = i;
+
+		// Half of the keys are missing, like when a SearchSet asks each of
+		// its archives in turn
+		const uint32 start = g_system->getMillis();
+		for (int i = 0; i < iters; i++) {
+			for (uint k = 0; k < keys.size(); k++)
+				found += map.contains(keys[k]);
+		}
+		return g_system->getMillis() - start;
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		TS_ASSERT(container.contains(1));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		TS_ASSERT_EQUALS(container.size(), 2u);
+		container[1] = 42;
+		TS_ASSERT_EQUALS(container[1], 42);
+		container.erase(container.find(0));
+		TS_ASSERT(!container.contains(0));
+		TS_ASSERT_EQUALS(container.getValOrDefault(0, -10), -10);
+		TS_ASSERT_EQUALS(container.getValOrDefault(2), 45);
+
+		int val = 0;
+		TS_ASSERT(container.tryGetVal(1, val));
+		TS_ASSERT_EQUALS(val, 42);
+		TS_ASSERT(!container.tryGetVal(5, val));
+
+		container.clear();
+		TS_ASSERT(container.empty());
+		TS_ASSERT_EQUALS(container.begin(), container.end());
+	}
+
+	void test_ignore_case() {
+		IgnoreCaseMap map;
+		map["Data/Room001.BMP"] = 1;
+		map["fonts/main.fnt"] = 2;
+		TS_ASSERT(map.contains("data/room001.bmp"));
+		TS_ASSERT(map.contains("FONTS/MAIN.FNT"));
+		TS_ASSERT(!map.contains("fonts/main.fn"));
+		map["DATA/ROOM001.bmp"] = 3;
+		TS_ASSERT_EQUALS(map.size(), 2u);
+		TS_ASSERT_EQUALS(map["data/room001.bmp"], 3);
+	}
+
+	void test_copy_iterate() {
+		Common::FlatHashMap<int, Common::String> map1;
+		for (int i = 0; i < 100; i++)
+			map1[i * 7] = Common::String::format("%d", i);
+		for (int i = 0; i < 100; i += 3)
+			map1.erase(i * 7);
+
+		Common::FlatHashMap<int, Common::String> map2(map1), map3;
+		map3 = map2;
+		TS_ASSERT_EQUALS(map3.size(), map1.size());
+
+		uint count = 0;
+		for (Common::FlatHashMap<int, Common::String>::const_iterator i = map3.begin(); i != map3.end(); ++i) {
+			TS_ASSERT_EQUALS(i->_key % 7, 0);
+			TS_ASSERT_DIFFERS((i->_key / 7) % 3, 0);
+			TS_ASSERT_EQUALS(i->_value, map1[i->_key]);
+			count++;
+		}
+		TS_ASSERT_EQUALS(count, map1.size());
+	}
+
+	void test_random_operations() {
+		// Compare with HashMap over inserts and erases which leave enough
+		// deleted slots to trigger the rehashing in place
+		Common::FlatHashMap<int, int> flat;
+		Common::HashMap<int, int> reference;
+		_random.setSeed(1234);
+
+		for (int i = 0; i < 20000; i++) {
+			const int key = _random.next() % 3000;
+			switch (_random.next() % 3) {
+			case 0:
+			case 1:
+				flat[key] = i;
+				reference[key] = i;
+				break;
+			default:
+				flat.erase(key);
+				reference.erase(key);
+				break;
+			}
+		}
+
+		TS_ASSERT_EQUALS(flat.size(), reference.size());
+		for (int key = 0; key < 3000; key++) {
+			TS_ASSERT_EQUALS(flat.contains(key), reference.contains(key));
+			if (reference.contains(key))
+				TS_ASSERT_EQUALS(flat[key], reference[key]);
+		}
+
+		// Colliding keys, which only differ in their high bits
+		Common::FlatHashMap<uint, int> collisions;
+		for (uint i = 0; i < 1000; i++)
+			collisions[i << 20] = i;
+		for (uint i = 0; i < 1000; i += 2)
+			collisions.erase(i << 20);
+		for (uint i = 0; i < 1000; i++)
+			TS_ASSERT_EQUALS(collisions.contains(i << 20), (i & 1) != 0);
+	}
+
+	void test_lookup_speed() {
+#if BENCHMARK_TIME
+#ifdef SLOW_TESTS
+		const int iters = 2000;
+#else
+		const int iters = 10;
+#endif
+		const Common::Array<Common::String> paths = makePaths(4000);
+		const Common::Array<Common::String> names = makeNames(1000);
+		uint found = 0;
+
+		const uint32 pathTime = timeLookups<Common::HashMap<Common::String, int, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> >(paths, iters, found);
+		const uint32 flatPathTime = timeLookups<IgnoreCaseMap>(paths, iters, found);
+		debug("%u lookups of archive paths in %u ms with HashMap, %u ms with FlatHashMap", iters * paths.size(), pathTime, flatPathTime);
+
+		const uint32 nameTime = timeLookups<Common::HashMap<Common::String, int> >(names, iters, found);
+		const uint32 flatNameTime = timeLookups<Common::FlatHashMap<Common::String, int> >(names, iters, found);
+		debug("%u lookups of selector names in %u ms with HashMap, %u ms with FlatHashMap", iters * names.size(), nameTime, flatNameTime);
+
+		TS_ASSERT_EQUALS(found, (paths.size() + names.size()) * iters);
+#endif
+	}
+};
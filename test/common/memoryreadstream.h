@@ -104,4 +104,15 @@ class MemoryReadStreamTestSuite : public CxxTest::TestSuite {
 		ms.seek(0, SEEK_SET);
 		TS_ASSERT(!ms.eos());
 	}
+
+	void test_mapped_data() {
+		byte contents[] = { 1, 2, 3, 4, 5, 6, 7 };
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		// The contents are not copied, and do not depend on the position
+		TS_ASSERT_EQUALS(ms.getMappedData(), contents);
+		ms.seek(3, SEEK_SET);
+		TS_ASSERT_EQUALS(ms.getMappedData(), contents);
+		TS_ASSERT_EQUALS(ms.readByte(), 4);
+	}
 };
@@ -2,8 +2,18 @@
 
 #include "test/common/str-helper.h"
 
+#include "common/debug.h"
 #include "common/path.h"
 #include "common/hashmap.h"
+#include "common/system.h"
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
 
 static const char *TEST_PATH = "parent/dir/file.txt";
 static const char *TEST_ESCAPED1_PATH = "|parent/dir/file.txt";
@@ -538,4 +548,56 @@ class PathTestSuite : public CxxTest::TestSuite
 	void test_canUnescape() {
 		TS_ASSERT(Common::Path::canUnescape(true, true, ""));
 	}
+
+	void test_mixed_escaping_hash() {
+		// Escaped and unescaped paths with the same components must be found
+		// in the same bucket
+		Common::Path p1("data/Sound Manager 3.1 : SoundLib/Sound");
+		Common::Path p2("data:Sound Manager 3.1 / SoundLib:SOUND", ':');
+		Common::Path p3("DATA/xn--Sound Manager 3.1  SoundLib-lba84k/sound");
+		Common::Path p4("data/Sound Manager 3.1 : SoundLib/Sounds");
+		Common::Path p5("data/Sound Manager 3.1 : SoundLib");
+
+		TS_ASSERT(p1.equalsIgnoreCaseAndMac(p2));
+		TS_ASSERT(p2.equalsIgnoreCaseAndMac(p3));
+		TS_ASSERT(p3.equalsIgnoreCaseAndMac(p1));
+		TS_ASSERT(!p1.equalsIgnoreCaseAndMac(p4));
+		TS_ASSERT(!p1.equalsIgnoreCaseAndMac(p5));
+		TS_ASSERT(!p5.equalsIgnoreCaseAndMac(p1));
+		TS_ASSERT_EQUALS(p1.hashIgnoreCaseAndMac(), p2.hashIgnoreCaseAndMac());
+		TS_ASSERT_EQUALS(p1.hashIgnoreCaseAndMac(), p3.hashIgnoreCaseAndMac());
+		TS_ASSERT_DIFFERS(p1.hashIgnoreCaseAndMac(), p4.hashIgnoreCaseAndMac());
+	}
+
+	void test_lookup_speed() {
+#if BENCHMARK_TIME
+		Common::install_null_g_system();
+#ifdef SLOW_TESTS
+		const int iters = 1000;
+#else
+		const int iters = 10;
+#endif
+		// The keys of the node caches of an FSDirectory
+		typedef Common::HashMap<Common::Path, int,
+				Common::Path::IgnoreCaseAndMac_Hash, Common::Path::IgnoreCaseAndMac_EqualTo> TestPathMap;
+		Common::Array<Common::Path> paths;
+		TestPathMap map;
+		for (int i = 0; i < 2000; i++) {
+			Common::Path path(Common::String::format("data/room%03d", i / 50));
+			path.joinInPlace(Common::String::format("Resource %04d.bin", i));
+			paths.push_back(path);
+			if (i & 1)
+				map[path] = i;
+		}
+
+		uint found = 0;
+		const uint32 start = g_system->getMillis();
+		for (int i = 0; i < iters; i++) {
+			for (uint p = 0; p < paths.size(); p++)
+				found += map.contains(paths[p]);
+		}
+		debug("%u lookups of paths in %u ms", iters * paths.size(), g_system->getMillis() - start);
+		TS_ASSERT_EQUALS(found, iters * paths.size() / 2);
+#endif
+	}
 };
@@ -0,0 +1,98 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/formats/json.h"
+#include "common/memstream.h"
+#include "common/profiler.h"
+
+#include "../null_osystem.h"
+
+class ProfilerTestSuite : public CxxTest::TestSuite {
+private:
+	Common::JSONValue *stopCapture() {
+		Common::MemoryWriteStreamDynamic stream(DisposeAfterUse::YES);
+		Common::Profiler::stop(stream);
+		stream.writeByte(0);
+
+		Common::JSONValue *trace = Common::JSON::parse((const char *)stream.getData());
+		TS_ASSERT(trace);
+		TS_ASSERT(trace->isObject());
+		TS_ASSERT(trace->asObject().contains("traceEvents"));
+		return trace;
+	}
+
+	const Common::JSONObject &getEvent(Common::JSONValue *trace, uint i) {
+		return trace->asObject()["traceEvents"]->asArray()[i]->asObject();
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+	}
+
+	void test_inactive() {
+		TS_ASSERT(!Common::Profiler::isActive());
+
+		{
+			PROFILE_ZONE("zone");
+			PROFILE_COUNTER("counter", 1);
+			PROFILE_FRAME();
+		}
+
+		Common::JSONValue *trace = stopCapture();
+		TS_ASSERT_EQUALS(trace->asObject()["traceEvents"]->asArray().size(), 0u);
+		delete trace;
+	}
+
+	void test_capture() {
+		Common::Profiler::start();
+		TS_ASSERT(Common::Profiler::isActive());
+
+		{
+			PROFILE_ZONE("outer");
+			{
+				PROFILE_ZONE("inner");
+				g_system->delayMillis(2);
+			}
+			PROFILE_COUNTER("counter", 42);
+			PROFILE_FRAME();
+		}
+
+		Common::JSONValue *trace = stopCapture();
+		TS_ASSERT(!Common::Profiler::isActive());
+
+		const Common::JSONArray &events = trace->asObject()["traceEvents"]->asArray();
+		TS_ASSERT_EQUALS(events.size(), 4u);
+		if (events.size() != 4) {
+			delete trace;
+			return;
+		}
+
+		// The zones are recorded when they end
+		const Common::JSONObject &inner = getEvent(trace, 0);
+		const Common::JSONObject &counter = getEvent(trace, 1);
+		const Common::JSONObject &frame = getEvent(trace, 2);
+		const Common::JSONObject &outer = getEvent(trace, 3);
+
+		TS_ASSERT_EQUALS(inner["name"]->asString(), "inner");
+		TS_ASSERT_EQUALS(inner["ph"]->asString(), "X");
+		TS_ASSERT_LESS_THAN_EQUALS(2000, inner["dur"]->asIntegerNumber());
+
+		TS_ASSERT_EQUALS(counter["name"]->asString(), "counter");
+		TS_ASSERT_EQUALS(counter["ph"]->asString(), "C");
+		TS_ASSERT_EQUALS(counter["args"]->asObject()["value"]->asIntegerNumber(), 42);
+
+		TS_ASSERT_EQUALS(frame["ph"]->asString(), "i");
+
+		TS_ASSERT_EQUALS(outer["name"]->asString(), "outer");
+		TS_ASSERT_LESS_THAN_EQUALS(outer["ts"]->asIntegerNumber(), inner["ts"]->asIntegerNumber());
+		TS_ASSERT_LESS_THAN_EQUALS(inner["ts"]->asIntegerNumber() + inner["dur"]->asIntegerNumber(),
+		                           outer["ts"]->asIntegerNumber() + outer["dur"]->asIntegerNumber());
+		delete trace;
+
+		// A new capture starts empty
+		Common::Profiler::start();
+		trace = stopCapture();
+		TS_ASSERT_EQUALS(trace->asObject()["traceEvents"]->asArray().size(), 0u);
+		delete trace;
+	}
+};
@@ -1,5 +1,6 @@
 #include <cxxtest/TestSuite.h>
 
+#include "common/bufferedstream.h"
 #include "common/memstream.h"
 #include "common/substream.h"
 
@@ -70,4 +71,20 @@ class SeekableSubReadStreamTestSuite : public CxxTest::TestSuite {
 		b = ssrs.readByte();
 		TS_ASSERT_EQUALS(b, 1);
 	}
+
+	void test_mapped_data() {
+		byte contents[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		Common::MemoryReadStream ms(contents, 10);
+
+		Common::SeekableSubReadStream ssrs(&ms, 3, 9);
+		TS_ASSERT_EQUALS(ssrs.getMappedData(), contents + 3);
+
+		// A sub stream of a stream which is not in memory is not either
+		Common::SeekableReadStream *buffered = Common::wrapBufferedSeekableReadStream(&ms, 4, DisposeAfterUse::NO);
+		TS_ASSERT(!buffered->getMappedData());
+
+		Common::SeekableSubReadStream bufferedSubStream(buffered, 3, 9);
+		TS_ASSERT(!bufferedSubStream.getMappedData());
+		delete buffered;
+	}
 };
@@ -0,0 +1,82 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/spsc-queue.h"
+
+class SPSCQueueTestSuite : public CxxTest::TestSuite {
+public:
+	void test_push_pop() {
+		Common::SPSCQueue<int, 4> queue;
+		int item = -1;
+
+		TS_ASSERT(queue.empty());
+		TS_ASSERT(!queue.pop(item));
+		TS_ASSERT_EQUALS(item, -1);
+
+		TS_ASSERT(queue.push(1));
+		TS_ASSERT(queue.push(2));
+		TS_ASSERT(!queue.empty());
+		TS_ASSERT_EQUALS(queue.count(), 2u);
+
+		TS_ASSERT(queue.pop(item));
+		TS_ASSERT_EQUALS(item, 1);
+		TS_ASSERT(queue.pop(item));
+		TS_ASSERT_EQUALS(item, 2);
+		TS_ASSERT(queue.empty());
+	}
+
+	void test_full() {
+		Common::SPSCQueue<int, 4> queue;
+		int item = 0;
+
+		for (int i = 0; i < 4; ++i)
+			TS_ASSERT(queue.push(i));
+		TS_ASSERT(!queue.push(4));
+		TS_ASSERT_EQUALS(queue.count(), 4u);
+
+		TS_ASSERT(queue.pop(item));
+		TS_ASSERT_EQUALS(item, 0);
+		TS_ASSERT(queue.push(4));
+		TS_ASSERT(!queue.push(5));
+	}
+
+	void test_wrap_around() {
+		Common::SPSCQueue<int, 8> queue;
+		int item = 0;
+
+		// Keep the queue partially filled while the indices wrap many times
+		for (int i = 0; i < 5; ++i)
+			queue.push(i);
+
+		for (int i = 5; i < 1000; ++i) {
+			TS_ASSERT(queue.push(i));
+			TS_ASSERT(queue.pop(item));
+			TS_ASSERT_EQUALS(item, i - 5);
+		}
+		TS_ASSERT_EQUALS(queue.count(), 5u);
+	}
+
+	void test_bulk() {
+		Common::SPSCQueue<int16, 16> queue;
+		int16 items[20], out[20];
+		for (int i = 0; i < 20; ++i)
+			items[i] = i;
+
+		TS_ASSERT_EQUALS(queue.push(items, 10), 10u);
+		TS_ASSERT_EQUALS(queue.pop(out, 4), 4u);
+		TS_ASSERT_EQUALS(out[3], 3);
+		TS_ASSERT_EQUALS(queue.space(), 10u);
+
+		// Only the free space is filled, across the end of the buffer
+		TS_ASSERT_EQUALS(queue.push(items + 10, 10), 10u);
+		TS_ASSERT_EQUALS(queue.push(items, 5), 0u);
+		TS_ASSERT_EQUALS(queue.pop(out, 20), 16u);
+		for (int i = 0; i < 16; ++i)
+			TS_ASSERT_EQUALS(out[i], i + 4);
+		TS_ASSERT(queue.empty());
+
+		queue.push(items, 7);
+		queue.clear();
+		TS_ASSERT(queue.empty());
+		TS_ASSERT_EQUALS(queue.pop(out, 1), 0u);
+	}
+};
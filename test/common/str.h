@@ -1,13 +1,107 @@
 #include <cxxtest/TestSuite.h>
 
+#include "common/array.h"
+#include "common/debug.h"
 #include "common/str.h"
+#include "common/system.h"
 #include "common/ustr.h"
+#include "common/workerpool.h"
 
 #include "test/common/str-helper.h"
 
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class StringCopyJob : public Common::WorkerJob {
+public:
+	StringCopyJob(const Common::String &str, Common::String &result) : _str(str), _result(result) {}
+
+	void run() override {
+		// Share the storage of a string which other threads share too
+		for (int i = 0; i < 10000; i++) {
+			Common::String copy(_str);
+			Common::String other;
+			other = copy;
+			if (i & 1)
+				other += 'x';
+			_result = copy;
+		}
+	}
+
+private:
+	const Common::String &_str;
+	Common::String &_result;
+};
+
 class StringTestSuite : public CxxTest::TestSuite
 {
+	/** A Lingo-like script, as the Director lexer gets it. */
+	static Common::String makeScript(int lines) {
+		Common::String script;
+		for (int i = 0; i < lines; i++)
+			script += Common::String::format("on mouseUp%d\n  set the locH of sprite %d to the mouseH + gOffset%d\n  put \"a rather long string literal\" into field %d\nend mouseUp%d\n", i, i % 48, i, i, i);
+		return script;
+	}
+
+	/** Split into tokens, which are copied around like the lexer and parser do. */
+	static uint tokenize(const Common::String &script, Common::Array<Common::String> &tokens) {
+		tokens.clear();
+		const char *p = script.c_str();
+		while (*p) {
+			while (*p == ' ' || *p == '\n')
+				p++;
+			const char *start = p;
+			if (*p == '"') {
+				p = strchr(p + 1, '"') + 1;
+			} else {
+				while (*p && *p != ' ' && *p != '\n')
+					p++;
+			}
+			if (p != start) {
+				Common::String token(start, p);
+				tokens.push_back(token);
+			}
+		}
+
+		uint length = 0;
+		Common::Array<Common::String> copy(tokens);
+		for (uint i = 0; i < copy.size(); i++)
+			length += copy[i].size();
+		return length;
+	}
+
+	/** Append words to lines and scroll them, like a Glk text buffer window. */
+	static uint fillTextWindow(const Common::Array<Common::String> &words, Common::Array<Common::String> &scrollback) {
+		scrollback.clear();
+		Common::String line;
+		for (uint i = 0; i < words.size(); i++) {
+			if (line.size() + words[i].size() >= 78) {
+				scrollback.push_back(line);
+				line.clear();
+			}
+			line += words[i];
+			line += ' ';
+		}
+		scrollback.push_back(line);
+
+		uint length = 0;
+		for (uint i = 0; i < scrollback.size(); i++) {
+			Common::String visible = scrollback[i];
+			length += visible.size();
+		}
+		return length;
+	}
+
 	public:
+	void setUp() {
+		Common::install_null_g_system();
+	}
+
 	void test_constructors() {
 		Common::String str("test-string");
 		TS_ASSERT_EQUALS(str, "test-string");
@@ -745,4 +839,51 @@ class StringTestSuite : public CxxTest::TestSuite
 		TS_ASSERT(a > c);
 		TS_ASSERT(c < a);
 	}
+
+	void test_shared_between_threads() {
+		Common::String str("A string long enough to be stored on the heap and shared");
+		Common::String results[8];
+
+		{
+			Common::WorkerPool pool(4);
+			for (int i = 0; i < 8; i++)
+				pool.submit(new StringCopyJob(str, results[i]));
+			pool.wait();
+		}
+
+		for (int i = 0; i < 8; i++)
+			TS_ASSERT_EQUALS(results[i], str);
+
+		// The copies are still shared, modifying one must not change the others
+		results[0] += " and modified";
+		TS_ASSERT_EQUALS(results[1], str);
+		TS_ASSERT_EQUALS(results[0], str + " and modified");
+	}
+
+	void test_copy_speed() {
+#if BENCHMARK_TIME
+#ifdef SLOW_TESTS
+		const int iters = 200;
+#else
+		const int iters = 5;
+#endif
+		const Common::String script = makeScript(500);
+		Common::Array<Common::String> tokens, scrollback;
+		uint length = 0;
+
+		uint32 start = g_system->getMillis();
+		for (int i = 0; i < iters; i++)
+			length += tokenize(script, tokens);
+		const uint32 lexerTime = g_system->getMillis() - start;
+
+		start = g_system->getMillis();
+		for (int i = 0; i < iters; i++)
+			length += fillTextWindow(tokens, scrollback);
+		const uint32 windowTime = g_system->getMillis() - start;
+
+		debug("%d x %u tokens lexed in %u ms, %d x %u lines of text window in %u ms",
+		      iters, tokens.size(), lexerTime, iters, scrollback.size(), windowTime);
+		TS_ASSERT_DIFFERS(length, 0u);
+#endif
+	}
 };
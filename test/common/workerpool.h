@@ -0,0 +1,66 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/workerpool.h"
+
+class CountingJob : public Common::WorkerJob {
+public:
+	CountingJob(Common::Mutex &mutex, int &counter, Common::WorkerPool *pool = nullptr, int children = 0)
+		: _mutex(mutex), _counter(counter), _pool(pool), _children(children) {}
+
+	void run() override {
+		{
+			Common::StackLock lock(_mutex);
+			_counter++;
+		}
+
+		for (int i = 0; i < _children; i++)
+			_pool->submit(new CountingJob(_mutex, _counter));
+	}
+
+private:
+	Common::Mutex &_mutex;
+	int &_counter;
+	Common::WorkerPool *_pool;
+	int _children;
+};
+
+class WorkerPoolTestSuite : public CxxTest::TestSuite {
+public:
+	void test_submit_wait() {
+		Common::Mutex mutex;
+		int counter = 0;
+		Common::WorkerPool pool;
+
+		for (int i = 0; i < 100; i++)
+			pool.submit(new CountingJob(mutex, counter));
+		pool.wait();
+
+		TS_ASSERT_EQUALS(counter, 100);
+		TS_ASSERT_EQUALS(pool.getPendingJobs(), 0u);
+	}
+
+	void test_nested_submit() {
+		Common::Mutex mutex;
+		int counter = 0;
+		Common::WorkerPool pool(4);
+
+		for (int i = 0; i < 10; i++)
+			pool.submit(new CountingJob(mutex, counter, &pool, 5));
+		pool.wait();
+
+		TS_ASSERT_EQUALS(counter, 60);
+	}
+
+	void test_destructor_runs_queued_jobs() {
+		Common::Mutex mutex;
+		int counter = 0;
+
+		{
+			Common::WorkerPool pool(2);
+			for (int i = 0; i < 20; i++)
+				pool.submit(new CountingJob(mutex, counter));
+		}
+
+		TS_ASSERT_EQUALS(counter, 20);
+	}
+};
@@ -0,0 +1,220 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/blit.h"
+#include "graphics/blit/blit-convert.h"
+
+#include "test/kernel_tables.h"
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class CrossBlitTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kWidth = 37,
+		kHeight = 5,
+		kPitch = kWidth * 4 + 12,
+		kBufferSize = kPitch * kHeight
+	};
+
+	enum Variant {
+		kPlain,
+		kKey,
+		kMask,
+		kInPlace
+	};
+
+	TestRandom _random;
+	byte _src[kBufferSize];
+	byte _mask[kBufferSize];
+	uint32 _map[256];
+
+	Common::Array<const Graphics::CrossBlitKernels::Table *> getSIMDTables() {
+		// All but the generic kernels, which the others are checked against
+		Common::Array<const Graphics::CrossBlitKernels::Table *> tables = getKernelTables<Graphics::CrossBlitKernels>();
+		tables.remove_at(0);
+		return tables;
+	}
+
+	Common::Array<Graphics::PixelFormat> getFormats() {
+		Common::Array<Graphics::PixelFormat> formats;
+		formats.push_back(Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+		formats.push_back(Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0));
+		formats.push_back(Graphics::PixelFormat(2, 4, 4, 4, 4, 8, 4, 0, 12));
+		formats.push_back(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+		formats.push_back(Graphics::PixelFormat(4, 8, 8, 8, 8, 0, 8, 16, 24));
+		formats.push_back(Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0));
+		formats.push_back(Graphics::PixelFormat(4, 8, 8, 8, 0, 8, 16, 24, 0));
+		// Not handled by the kernels
+		formats.push_back(Graphics::PixelFormat(2, 3, 3, 2, 0, 5, 2, 0, 0));
+		return formats;
+	}
+
+	void fillBuffers() {
+		_random.setSeed(1234);
+		for (int i = 0; i < kBufferSize; i++) {
+			_src[i] = _random.next();
+			_mask[i] = (_random.next() & 3) ? 0xFF : 0;
+		}
+		for (int i = 0; i < 256; i++)
+			_map[i] = _random.next() | (_random.next() << 16);
+	}
+
+	/** Return the color of the first pixel, which then appears in most rows as the key. */
+	uint32 getKey(uint srcBytesPerPixel) {
+		for (int y = 1; y < kHeight; y++)
+			memcpy(_src + y * kPitch + (y * 7) * srcBytesPerPixel, _src, srcBytesPerPixel);
+		if (srcBytesPerPixel == 4)
+			return READ_UINT32(_src);
+		else if (srcBytesPerPixel == 2)
+			return READ_UINT16(_src);
+		return _src[0];
+	}
+
+	void blit(byte *dst, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat *srcFmt, Variant variant) {
+		const uint srcBytesPerPixel = srcFmt ? srcFmt->bytesPerPixel : 1;
+		const byte *src = _src;
+		if (variant == kInPlace) {
+			memcpy(dst, _src, kBufferSize);
+			src = dst;
+		}
+
+		if (srcFmt) {
+			if (variant == kKey)
+				Graphics::crossKeyBlit(dst, src, kPitch, kPitch, kWidth, kHeight, dstFmt, *srcFmt, getKey(srcBytesPerPixel));
+			else if (variant == kMask)
+				Graphics::crossMaskBlit(dst, src, _mask, kPitch, kPitch, kPitch, kWidth, kHeight, dstFmt, *srcFmt);
+			else
+				Graphics::crossBlit(dst, src, kPitch, kPitch, kWidth, kHeight, dstFmt, *srcFmt);
+		} else {
+			if (variant == kKey)
+				Graphics::crossKeyBlitMap(dst, src, kPitch, kPitch, kWidth, kHeight, dstFmt.bytesPerPixel, _map, getKey(srcBytesPerPixel));
+			else if (variant == kMask)
+				Graphics::crossMaskBlitMap(dst, src, _mask, kPitch, kPitch, kPitch, kWidth, kHeight, dstFmt.bytesPerPixel, _map);
+			else
+				Graphics::crossBlitMap(dst, src, kPitch, kPitch, kWidth, kHeight, dstFmt.bytesPerPixel, _map);
+		}
+	}
+
+	/** Compare the kernels with the scalar code, for a source format or the map if @p srcFmt is nullptr. */
+	void checkConversion(const Graphics::CrossBlitKernels::Table *table, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat *srcFmt) {
+		for (int variant = kPlain; variant <= kInPlace; variant++) {
+			byte expected[kBufferSize], actual[kBufferSize];
+			memset(expected, 0x55, sizeof(expected));
+			memset(actual, 0x55, sizeof(actual));
+
+			fillBuffers();
+			Graphics::CrossBlitKernels::kernels = &Graphics::CrossBlitKernels::generic;
+			blit(expected, dstFmt, srcFmt, (Variant)variant);
+
+			fillBuffers();
+			Graphics::CrossBlitKernels::kernels = table;
+			blit(actual, dstFmt, srcFmt, (Variant)variant);
+
+			TS_ASSERT_EQUALS(memcmp(expected, actual, kBufferSize), 0);
+		}
+
+		Graphics::CrossBlitKernels::kernels = &Graphics::CrossBlitKernels::generic;
+	}
+
+	uint32 timeConversion(const Graphics::CrossBlitKernels::Table *table, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat *srcFmt, int iters) {
+		const uint w = 640, h = 480;
+		const uint srcPitch = w * (srcFmt ? srcFmt->bytesPerPixel : 1);
+		const uint dstPitch = w * dstFmt.bytesPerPixel;
+		byte *src = new byte[srcPitch * h];
+		byte *dst = new byte[dstPitch * h];
+
+		_random.setSeed(4321);
+		for (uint i = 0; i < srcPitch * h; i++)
+			src[i] = _random.next();
+		fillBuffers();
+
+		Graphics::CrossBlitKernels::kernels = table;
+		const uint32 start = g_system->getMillis();
+		for (int i = 0; i < iters; i++) {
+			if (srcFmt)
+				Graphics::crossBlit(dst, src, dstPitch, srcPitch, w, h, dstFmt, *srcFmt);
+			else
+				Graphics::crossBlitMap(dst, src, dstPitch, srcPitch, w, h, dstFmt.bytesPerPixel, _map);
+		}
+		const uint32 time = g_system->getMillis() - start;
+		Graphics::CrossBlitKernels::kernels = &Graphics::CrossBlitKernels::generic;
+
+		delete[] src;
+		delete[] dst;
+		return time;
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+		// The test backend has no graphics manager to ask about the CPU features
+		Graphics::CrossBlitKernels::kernels = &Graphics::CrossBlitKernels::generic;
+	}
+
+	void test_cross_blit_kernels() {
+		Common::Array<const Graphics::CrossBlitKernels::Table *> tables = getSIMDTables();
+		Common::Array<Graphics::PixelFormat> formats = getFormats();
+
+		for (uint t = 0; t < tables.size(); t++) {
+			for (uint d = 0; d < formats.size(); d++) {
+				for (uint s = 0; s < formats.size(); s++) {
+					if (s != d)
+						checkConversion(tables[t], formats[d], &formats[s]);
+				}
+			}
+		}
+	}
+
+	void test_cross_blit_map_kernels() {
+		Common::Array<const Graphics::CrossBlitKernels::Table *> tables = getSIMDTables();
+		Common::Array<Graphics::PixelFormat> formats = getFormats();
+
+		for (uint t = 0; t < tables.size(); t++) {
+			for (uint d = 0; d < formats.size(); d++)
+				checkConversion(tables[t], formats[d], nullptr);
+			checkConversion(tables[t], Graphics::PixelFormat::createFormatCLUT8(), nullptr);
+		}
+	}
+
+	void test_cross_blit_speed() {
+#if BENCHMARK_TIME
+#ifdef SLOW_TESTS
+		const int iters = 200;
+#else
+		const int iters = 1;
+#endif
+		Common::Array<const Graphics::CrossBlitKernels::Table *> tables = getSIMDTables();
+		if (tables.empty())
+			return;
+
+		struct Benchmark {
+			const char *name;
+			Graphics::PixelFormat dstFmt;
+			bool useMap;
+			Graphics::PixelFormat srcFmt;
+		};
+
+		const Benchmark benchmarks[] = {
+			{ "CLUT8 to RGB565", Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0), true, Graphics::PixelFormat() },
+			{ "CLUT8 to XRGB8888", Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0), true, Graphics::PixelFormat() },
+			{ "RGB565 to XRGB8888", Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0), false, Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0) },
+			{ "XRGB8888 to RGB565", Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0), false, Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0) },
+			{ "RGBA8888 to ABGR8888", Graphics::PixelFormat(4, 8, 8, 8, 8, 0, 8, 16, 24), false, Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0) }
+		};
+
+		for (uint b = 0; b < ARRAYSIZE(benchmarks); b++) {
+			const Graphics::PixelFormat *srcFmt = benchmarks[b].useMap ? nullptr : &benchmarks[b].srcFmt;
+			const uint32 genericTime = timeConversion(&Graphics::CrossBlitKernels::generic, benchmarks[b].dstFmt, srcFmt, iters);
+			const uint32 simdTime = timeConversion(tables.back(), benchmarks[b].dstFmt, srcFmt, iters);
+			debug("%s: %d frames of 640x480 in %u ms with the scalar code, %u ms with SIMD",
+			      benchmarks[b].name, iters, genericTime, simdTime);
+		}
+#endif
+	}
+};
@@ -0,0 +1,229 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/debug.h"
+#include "common/system.h"
+#include "graphics/managed_surface.h"
+#include "graphics/managed_surface-kernels.h"
+
+#include "test/kernel_tables.h"
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class ManagedSurfaceBlitTestSuite : public CxxTest::TestSuite {
+private:
+	TestRandom _random;
+
+	/** Pixels with a few transparent ones, like the sprites of the engines. */
+	void fill8(Graphics::ManagedSurface &surf, byte key) {
+		for (int y = 0; y < surf.h; y++) {
+			for (int x = 0; x < surf.w; x++)
+				*(byte *)surf.getBasePtr(x, y) = (_random.next() % 4) ? _random.next() : key;
+		}
+	}
+
+	/** Pixels with many opaque and clear ones, onto a mostly opaque destination. */
+	void fill32(Graphics::ManagedSurface &surf, bool dest) {
+		for (int y = 0; y < surf.h; y++) {
+			for (int x = 0; x < surf.w; x++) {
+				byte a = _random.next();
+				switch (_random.next() % 4) {
+				case 0:
+					a = 0xff;
+					break;
+				case 1:
+					a = dest ? 0xff : 0;
+					break;
+				default:
+					break;
+				}
+				*(uint32 *)surf.getBasePtr(x, y) = surf.format.ARGBToColor(a, _random.next(), _random.next(), _random.next());
+			}
+		}
+	}
+
+	/** transBlitFrom() of 8 bits pixels, one pixel at a time. */
+	static void referenceTransBlit8(const Graphics::ManagedSurface &src, Graphics::ManagedSurface &dest,
+			const Common::Rect &destRect, byte key, bool flipped) {
+		const int scaleX = 256 * src.w / destRect.width();
+		const int scaleY = 256 * src.h / destRect.height();
+		for (int y = destRect.top; y < destRect.bottom; y++) {
+			for (int x = destRect.left; x < destRect.right; x++) {
+				if (x < 0 || y < 0 || x >= dest.w || y >= dest.h)
+					continue;
+				const int srcX = (x - destRect.left) * scaleX / 256;
+				const int srcY = (y - destRect.top) * scaleY / 256;
+				const byte val = *(const byte *)src.getBasePtr(flipped ? src.w - srcX - 1 : srcX, srcY);
+				if (val != key)
+					*(byte *)dest.getBasePtr(x, y) = val;
+			}
+		}
+	}
+
+	/** blitFrom() of 32 bits pixels of the same format, one pixel at a time. */
+	static void referenceAlphaBlit(const Graphics::ManagedSurface &src, Graphics::ManagedSurface &dest, const Common::Point &pos) {
+		Graphics::ManagedSurfaceKernels::AlphaParams params;
+		params.init(src.format);
+		for (int y = 0; y < src.h; y++) {
+			for (int x = 0; x < src.w; x++) {
+				if (x + pos.x < 0 || y + pos.y < 0 || x + pos.x >= dest.w || y + pos.y >= dest.h)
+					continue;
+				uint32 *destP = (uint32 *)dest.getBasePtr(x + pos.x, y + pos.y);
+				*destP = params.blend(*(const uint32 *)src.getBasePtr(x, y), *destP);
+			}
+		}
+	}
+
+	static bool equalSurfaces(const Graphics::ManagedSurface &a, const Graphics::ManagedSurface &b) {
+		for (int y = 0; y < a.h; y++) {
+			if (memcmp(a.getBasePtr(0, y), b.getBasePtr(0, y), a.w * a.format.bytesPerPixel))
+				return false;
+		}
+		return true;
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+		// The test backend has no graphics manager to ask about the CPU features
+		Graphics::ManagedSurfaceKernels::kernels = &Graphics::ManagedSurfaceKernels::generic;
+	}
+
+	void test_trans_blit_8() {
+		Common::Array<const Graphics::ManagedSurfaceKernels::Table *> tables = getKernelTables<Graphics::ManagedSurfaceKernels>();
+		const Graphics::PixelFormat clut8 = Graphics::PixelFormat::createFormatCLUT8();
+		const Common::Rect destRects[] = {
+			Common::Rect(3, 2, 3 + 45, 2 + 13),
+			Common::Rect(-7, -3, -7 + 45, -3 + 13),
+			Common::Rect(40, 20, 40 + 45, 20 + 13),
+			Common::Rect(5, 1, 5 + 67, 1 + 20),
+			Common::Rect(-2, 4, -2 + 30, 4 + 9)
+		};
+
+		for (uint t = 0; t < tables.size(); t++) {
+			Graphics::ManagedSurfaceKernels::kernels = tables[t];
+			_random.setSeed(1234);
+
+			for (uint r = 0; r < ARRAYSIZE(destRects); r++) {
+				for (int flipped = 0; flipped < 2; flipped++) {
+					Graphics::ManagedSurface src(45, 13, clut8), dest(64, 24, clut8), expected(64, 24, clut8);
+					fill8(src, 0x55);
+					fill8(dest, 0);
+					expected.copyFrom(dest);
+
+					src.setTransparentColor(0x55);
+					dest.transBlitFrom(src, Common::Rect(0, 0, src.w, src.h), destRects[r], 0x55, flipped);
+					referenceTransBlit8(src, expected, destRects[r], 0x55, flipped);
+					TS_ASSERT(equalSurfaces(dest, expected));
+				}
+			}
+		}
+
+		Graphics::ManagedSurfaceKernels::kernels = &Graphics::ManagedSurfaceKernels::generic;
+	}
+
+	void test_blit_overlapping() {
+		const Graphics::PixelFormat rgb565(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		const Common::Rect srcRect(8, 4, 8 + 40, 4 + 10);
+		_random.setSeed(1234);
+
+		// Scroll a part of the surface onto itself, to the left and to the right
+		for (int dx = -5; dx <= 5; dx += 10) {
+			Graphics::ManagedSurface surf(64, 24, rgb565), expected(64, 24, rgb565);
+			for (int y = 0; y < surf.h; y++) {
+				for (int x = 0; x < surf.w; x++)
+					*(uint16 *)surf.getBasePtr(x, y) = _random.next();
+			}
+			expected.copyFrom(surf);
+
+			for (int y = srcRect.top; y < srcRect.bottom; y++) {
+				for (int x = srcRect.left; x < srcRect.right; x++)
+					*(uint16 *)expected.getBasePtr(x + dx, y) = *(const uint16 *)surf.getBasePtr(x, y);
+			}
+
+			surf.blitFrom(surf, srcRect, Common::Point(srcRect.left + dx, srcRect.top));
+			TS_ASSERT(equalSurfaces(surf, expected));
+		}
+	}
+
+	void test_alpha_blit_32() {
+		Common::Array<const Graphics::ManagedSurfaceKernels::Table *> tables = getKernelTables<Graphics::ManagedSurfaceKernels>();
+		const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24)
+		};
+		const Common::Point positions[] = {
+			Common::Point(0, 0), Common::Point(3, 1), Common::Point(-5, -2), Common::Point(30, 17)
+		};
+
+		for (uint t = 0; t < tables.size(); t++) {
+			Graphics::ManagedSurfaceKernels::kernels = tables[t];
+			_random.setSeed(5678);
+
+			for (uint f = 0; f < ARRAYSIZE(formats); f++) {
+				for (uint p = 0; p < ARRAYSIZE(positions); p++) {
+					Graphics::ManagedSurface src(37, 11, formats[f]), dest(50, 20, formats[f]), expected(50, 20, formats[f]);
+					fill32(src, false);
+					fill32(dest, true);
+					expected.copyFrom(dest);
+
+					dest.blitFrom(src, positions[p]);
+					referenceAlphaBlit(src, expected, positions[p]);
+					TS_ASSERT(equalSurfaces(dest, expected));
+				}
+			}
+		}
+
+		Graphics::ManagedSurfaceKernels::kernels = &Graphics::ManagedSurfaceKernels::generic;
+	}
+
+	void test_blit_speed() {
+#if BENCHMARK_TIME
+#ifdef SLOW_TESTS
+		const int iters = 200;
+#else
+		const int iters = 2;
+#endif
+		Common::Array<const Graphics::ManagedSurfaceKernels::Table *> tables = getKernelTables<Graphics::ManagedSurfaceKernels>();
+		const Graphics::PixelFormat clut8 = Graphics::PixelFormat::createFormatCLUT8();
+		const Graphics::PixelFormat rgba(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		_random.setSeed(42);
+
+		Graphics::ManagedSurface sprite8(320, 200, clut8), screen8(640, 480, clut8);
+		Graphics::ManagedSurface sprite32(320, 200, rgba), screen32(640, 480, rgba);
+		fill8(sprite8, 0);
+		fill32(sprite32, false);
+		fill32(screen32, true);
+
+		// The scalar loops of the table are the ones the blits use on
+		// backends without SIMD
+		for (uint t = 0; t < tables.size(); t++) {
+			Graphics::ManagedSurfaceKernels::kernels = tables[t];
+
+			uint32 start = g_system->getMillis();
+			for (int i = 0; i < iters; i++) {
+				for (int s = 0; s < 4; s++)
+					screen8.transBlitFrom(sprite8, Common::Point((s & 1) * 320, (s >> 1) * 240), 0);
+			}
+			const uint32 keyedTime = g_system->getMillis() - start;
+
+			start = g_system->getMillis();
+			for (int i = 0; i < iters; i++) {
+				for (int s = 0; s < 4; s++)
+					screen32.blitFrom(sprite32, Common::Point((s & 1) * 320, (s >> 1) * 240));
+			}
+			const uint32 alphaTime = g_system->getMillis() - start;
+
+			debug("%s: %d frames of 640x480 keyed 8 bits sprites in %u ms, 32 bits sprites with alpha in %u ms",
+			      t == 0 ? "Scalar" : "SIMD", iters, keyedTime, alphaTime);
+		}
+
+		Graphics::ManagedSurfaceKernels::kernels = &Graphics::ManagedSurfaceKernels::generic;
+#endif
+	}
+};
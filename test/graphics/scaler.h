@@ -0,0 +1,212 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/textconsole.h"
+#include "graphics/scaler/edge.h"
+#include "graphics/scaler/hq.h"
+#include "graphics/scaler/sai.h"
+
+#include "test/kernel_tables.h"
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class ScalerTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kWidth = 320,
+		kHeight = 200,
+		kPadding = 4
+	};
+
+	typedef Scaler *(*CreateFunc)(const Graphics::PixelFormat &format);
+
+	template<class T>
+	static Scaler *create(const Graphics::PixelFormat &format) {
+		return new T(format);
+	}
+
+	TestRandom _random;
+
+	/**
+	 * Fill a source frame with blocks of solid colors and some noise, so that
+	 * the scalers find both edges and flat areas. Only the noise changes
+	 * between frames, to also test the scalers which skip unchanged pixels.
+	 */
+	void drawFrame(Graphics::Surface &src, uint frame) {
+		_random.setSeed(4321);
+		src.fillRect(Common::Rect(src.w, src.h), src.format.RGBToColor(0, 0, 0));
+
+		for (int i = 0; i < 60; i++) {
+			const int x = _random.next() % src.w;
+			const int y = _random.next() % src.h;
+			Common::Rect r(x, y, x + 1 + _random.next() % 40, y + 1 + _random.next() % 40);
+			r.clip(src.w, src.h);
+			src.fillRect(r, src.format.RGBToColor(_random.next() & 0xFF, _random.next() & 0xFF, _random.next() & 0xFF));
+		}
+
+		_random.setSeed(1234 + frame);
+		for (int i = 0; i < 2000; i++)
+			src.setPixel(_random.next() % src.w, _random.next() % src.h, src.format.RGBToColor(_random.next() & 0xFF, _random.next() & 0xFF, _random.next() & 0xFF));
+	}
+
+	void scaleFrame(Scaler *scaler, const Graphics::Surface &src, Graphics::Surface &dst, const Common::Rect &rect) {
+		const uint factor = scaler->getFactor();
+		scaler->scale((const uint8 *)src.getBasePtr(kPadding + rect.left, kPadding + rect.top), src.pitch,
+		              (uint8 *)dst.getBasePtr(rect.left * factor, rect.top * factor), dst.pitch,
+		              rect.width(), rect.height(), rect.left, rect.top);
+	}
+
+	void checkBands(CreateFunc createFunc, uint factor, const Graphics::PixelFormat &format, bool useOldSource) {
+		Graphics::Surface src, expected, actual;
+		src.create(kWidth + 2 * kPadding, kHeight + 2 * kPadding, format);
+		expected.create(kWidth * factor, kHeight * factor, format);
+		actual.create(kWidth * factor, kHeight * factor, format);
+
+		Scaler *serial = createFunc(format);
+		Scaler *banded = createFunc(format);
+		serial->setFactor(factor);
+		banded->setFactor(factor);
+		serial->setThreadCount(1);
+		banded->setThreadCount(4);
+
+		if (useOldSource) {
+			serial->setSource((const byte *)src.getPixels(), src.pitch, kWidth, kHeight, kPadding);
+			banded->setSource((const byte *)src.getPixels(), src.pitch, kWidth, kHeight, kPadding);
+			serial->enableSource(true);
+			banded->enableSource(true);
+		}
+
+		// The following frames only redraw a part of the screen, which
+		// is also not aligned with the bands
+		const Common::Rect rects[] = {
+			Common::Rect(kWidth, kHeight),
+			Common::Rect(7, 13, 208, 163),
+			Common::Rect(0, 41, kWidth, 107)
+		};
+
+		for (uint frame = 0; frame < ARRAYSIZE(rects); frame++) {
+			drawFrame(src, frame);
+			scaleFrame(serial, src, expected, rects[frame]);
+			scaleFrame(banded, src, actual, rects[frame]);
+
+			for (int y = 0; y < expected.h; y++)
+				TS_ASSERT_EQUALS(memcmp(expected.getBasePtr(0, y), actual.getBasePtr(0, y), expected.w * format.bytesPerPixel), 0);
+		}
+
+		delete serial;
+		delete banded;
+		src.free();
+		expected.free();
+		actual.free();
+	}
+
+	void checkScaler(CreateFunc createFunc, uint maxFactor, bool useOldSource) {
+		const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0)
+		};
+
+		for (uint factor = 2; factor <= maxFactor; factor++) {
+			for (uint i = 0; i < ARRAYSIZE(formats); i++)
+				checkBands(createFunc, factor, formats[i], useOldSource);
+		}
+	}
+
+	uint32 timeScaler(CreateFunc createFunc, uint factor, const Graphics::PixelFormat &format, uint numThreads, int iters) {
+		Graphics::Surface src, dst;
+		src.create(kWidth + 2 * kPadding, kHeight + 2 * kPadding, format);
+		dst.create(kWidth * factor, kHeight * factor, format);
+
+		Scaler *scaler = createFunc(format);
+		scaler->setFactor(factor);
+		scaler->setThreadCount(numThreads);
+
+		uint32 time = 0;
+		for (int i = 0; i < iters; i++) {
+			drawFrame(src, i);
+			const uint32 start = g_system->getMillis();
+			scaleFrame(scaler, src, dst, Common::Rect(kWidth, kHeight));
+			time += g_system->getMillis() - start;
+		}
+
+		delete scaler;
+		src.free();
+		dst.free();
+		return time;
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+	}
+
+	void test_hq_bands() {
+#ifdef USE_HQ_SCALERS
+		checkScaler(&create<HQScaler>, 3, false);
+#endif
+	}
+
+	void test_sai_bands() {
+#ifdef USE_SCALERS
+		checkScaler(&create<SAIScaler>, 2, false);
+		checkScaler(&create<SuperSAIScaler>, 2, false);
+		checkScaler(&create<SuperEagleScaler>, 2, false);
+#endif
+	}
+
+	void test_edge_bands() {
+#ifdef USE_EDGE_SCALERS
+		checkScaler(&create<EdgeScaler>, 3, false);
+		checkScaler(&create<EdgeScaler>, 3, true);
+#endif
+	}
+
+	void test_scaler_speed() {
+#if BENCHMARK_TIME && defined(USE_SCALERS)
+#ifdef SLOW_TESTS
+		const int iters = 100;
+#else
+		const int iters = 1;
+#endif
+		struct Benchmark {
+			const char *name;
+			CreateFunc createFunc;
+			uint maxFactor;
+		};
+
+		const Benchmark benchmarks[] = {
+#ifdef USE_HQ_SCALERS
+			{ "HQ", &create<HQScaler>, 3 },
+#endif
+#ifdef USE_EDGE_SCALERS
+			{ "Edge", &create<EdgeScaler>, 3 },
+#endif
+			{ "SaI", &create<SAIScaler>, 2 },
+			{ "SuperSaI", &create<SuperSAIScaler>, 2 },
+			{ "SuperEagle", &create<SuperEagleScaler>, 2 }
+		};
+
+		const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0)
+		};
+
+		for (uint b = 0; b < ARRAYSIZE(benchmarks); b++) {
+			for (uint factor = 2; factor <= benchmarks[b].maxFactor; factor++) {
+				for (uint f = 0; f < ARRAYSIZE(formats); f++) {
+					const uint32 serialTime = timeScaler(benchmarks[b].createFunc, factor, formats[f], 1, iters);
+					const uint32 bandedTime = timeScaler(benchmarks[b].createFunc, factor, formats[f], 0, iters);
+					debug("%s %ux %dbpp: %d frames of %dx%d in %u ms on one thread, %u ms in bands",
+					      benchmarks[b].name, factor, formats[f].bytesPerPixel * 8, iters, kWidth, kHeight,
+					      serialTime, bandedTime);
+				}
+			}
+		}
+#endif
+	}
+};
@@ -0,0 +1,247 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/tinygl/tinygl.h"
+#include "graphics/tinygl/zgl.h"
+#include "graphics/tinygl/zspan.h"
+
+#include "test/kernel_tables.h"
+
+#include "../null_osystem.h"
+
+class TinyGLTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kWidth = 160,
+		kHeight = 200,
+		kTextureSize = 64
+	};
+
+	typedef void (TinyGLTestSuite::*SceneFunc)(int frame);
+
+	TestRandom _random;
+
+	Common::Array<const TinyGL::SpanKernels::Table *> getSIMDTables() {
+		// All but the generic kernels, which the others are checked against
+		Common::Array<const TinyGL::SpanKernels::Table *> tables = getKernelTables<TinyGL::SpanKernels>();
+		tables.remove_at(0);
+		return tables;
+	}
+
+	void drawTriangle(float x, float y, float size, float z, float r, float g, float b, float a) {
+		tglBegin(TGL_TRIANGLES);
+		tglColor4f(r, g, b, a);
+		tglVertex3f(x, y, z);
+		tglColor4f(g, b, r, a);
+		tglVertex3f(x + size, y, z);
+		tglColor4f(b, r, g, a);
+		tglVertex3f(x + size * 0.3f, y + size * 1.7f, z);
+		tglEnd();
+	}
+
+	void drawScene(int frame) {
+		tglClearColor(0.1f, 0.2f, 0.3f, 1.0f);
+		tglClear(TGL_COLOR_BUFFER_BIT | TGL_DEPTH_BUFFER_BIT);
+
+		tglEnable(TGL_DEPTH_TEST);
+		drawTriangle(-0.9f, -0.9f, 1.5f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f);
+		drawTriangle(-0.5f + frame * 0.1f, -0.7f, 1.2f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
+
+		tglEnable(TGL_BLEND);
+		tglBlendFunc(TGL_SRC_ALPHA, TGL_ONE_MINUS_SRC_ALPHA);
+		drawTriangle(-0.2f, -0.95f, 1.1f, -0.5f, 1.0f, 1.0f, 0.0f, 0.5f);
+		tglDisable(TGL_BLEND);
+
+		tglEnable(TGL_SCISSOR_TEST);
+		tglScissor(10, 50, 100, 70);
+		drawTriangle(-1.0f, -1.0f, 2.0f, -0.8f, 0.5f, 0.5f, 1.0f, 1.0f);
+		tglDisable(TGL_SCISSOR_TEST);
+
+		tglBegin(TGL_LINES);
+		tglColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+		tglVertex3f(-0.95f, 0.9f, -0.9f);
+		tglVertex3f(0.9f, -0.95f + frame * 0.2f, -0.9f);
+		tglEnd();
+		tglDisable(TGL_DEPTH_TEST);
+	}
+
+	void drawQuad(float x, float y, float w, float h, float z, float angle, float alpha) {
+		tglPushMatrix();
+		tglTranslatef(x, y, z);
+		tglRotatef(angle, 0.3f, 1.0f, 0.2f);
+		tglBegin(TGL_TRIANGLES);
+		tglColor4f(1.0f, 1.0f, 1.0f, alpha);
+		tglTexCoord2f(-0.2f, -0.1f);
+		tglVertex3f(-w, -h, 0.0f);
+		tglColor4f(0.2f, 1.0f, 0.6f, alpha * 0.5f);
+		tglTexCoord2f(1.3f, 0.0f);
+		tglVertex3f(w, -h, 0.0f);
+		tglColor4f(1.0f, 0.4f, 0.8f, alpha);
+		tglTexCoord2f(1.1f, 1.2f);
+		tglVertex3f(w, h, 0.0f);
+		tglVertex3f(w, h, 0.0f);
+		tglColor4f(0.7f, 0.7f, 0.1f, 1.0f);
+		tglTexCoord2f(0.0f, 1.0f);
+		tglVertex3f(-w, h, 0.0f);
+		tglColor4f(1.0f, 1.0f, 1.0f, alpha);
+		tglTexCoord2f(-0.2f, -0.1f);
+		tglVertex3f(-w, -h, 0.0f);
+		tglEnd();
+		tglPopMatrix();
+	}
+
+	void drawTexturedScene(int frame) {
+		TGLuint textures[2];
+		tglGenTextures(2, textures);
+
+		byte pixels[kTextureSize * kTextureSize * 4];
+		for (int i = 0; i < kTextureSize * kTextureSize * 4; i++)
+			pixels[i] = _random.next() & 0xFF;
+
+		for (int i = 0; i < 2; i++) {
+			tglBindTexture(TGL_TEXTURE_2D, textures[i]);
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_MIN_FILTER, i ? TGL_LINEAR : TGL_NEAREST);
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_MAG_FILTER, i ? TGL_LINEAR : TGL_NEAREST);
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_WRAP_S, i ? TGL_CLAMP_TO_EDGE : TGL_REPEAT);
+			tglTexImage2D(TGL_TEXTURE_2D, 0, TGL_RGBA, kTextureSize, kTextureSize, 0, TGL_RGBA, TGL_UNSIGNED_BYTE, pixels);
+		}
+
+		tglClearColor(0.3f, 0.2f, 0.1f, 0.5f);
+		tglClear(TGL_COLOR_BUFFER_BIT | TGL_DEPTH_BUFFER_BIT);
+
+		tglMatrixMode(TGL_PROJECTION);
+		tglLoadIdentity();
+		tglFrustum(-0.1, 0.1, -0.1, 0.1, 0.1, 100.0);
+		tglMatrixMode(TGL_MODELVIEW);
+		tglLoadIdentity();
+
+		tglEnable(TGL_TEXTURE_2D);
+		tglEnable(TGL_DEPTH_TEST);
+
+		static const TGLenum depthFuncs[] = { TGL_LESS, TGL_LEQUAL, TGL_GREATER, TGL_ALWAYS };
+		static const TGLenum blendFuncs[][2] = {
+			{ TGL_SRC_ALPHA, TGL_ONE_MINUS_SRC_ALPHA },
+			{ TGL_ONE, TGL_ONE_MINUS_SRC_ALPHA },
+			{ TGL_ONE, TGL_ONE },
+			{ TGL_SRC_ALPHA, TGL_ZERO },
+			{ TGL_DST_COLOR, TGL_ZERO }
+		};
+
+		for (int i = 0; i < 24; i++) {
+			tglBindTexture(TGL_TEXTURE_2D, textures[i & 1]);
+			tglShadeModel((i & 2) ? TGL_FLAT : TGL_SMOOTH);
+			tglDepthFunc(depthFuncs[(i / 3 + frame) % ARRAYSIZE(depthFuncs)]);
+			tglDepthMask((i % 5) != 0);
+
+			if (i % 3 == 1) {
+				tglEnable(TGL_BLEND);
+				tglBlendFunc(blendFuncs[i % ARRAYSIZE(blendFuncs)][0], blendFuncs[i % ARRAYSIZE(blendFuncs)][1]);
+			} else {
+				tglDisable(TGL_BLEND);
+			}
+
+			if (i % 4 == 3) {
+				tglEnable(TGL_ALPHA_TEST);
+				tglAlphaFunc((i & 4) ? TGL_GREATER : TGL_LESS, 0.4f);
+			} else {
+				tglDisable(TGL_ALPHA_TEST);
+			}
+
+			if (i % 7 == 2) {
+				tglEnable(TGL_SCISSOR_TEST);
+				tglScissor(13, 27, 91, 113);
+			} else {
+				tglDisable(TGL_SCISSOR_TEST);
+			}
+
+			// Include quads partly outside of the screen, and very thin ones
+			// for spans shorter than a block
+			const float x = (int)(_random.next() % 200 - 100) * 0.02f;
+			const float y = (int)(_random.next() % 200 - 100) * 0.02f;
+			const float w = (i % 6 == 5) ? 0.01f : 0.2f + (_random.next() % 100) * 0.02f;
+			drawQuad(x, y, w, 0.2f + (_random.next() % 100) * 0.02f, -2.0f - (_random.next() % 100) * 0.05f,
+			         (float)(_random.next() % 360), (_random.next() % 100) * 0.01f);
+		}
+
+		tglDisable(TGL_SCISSOR_TEST);
+		tglDisable(TGL_ALPHA_TEST);
+		tglDisable(TGL_BLEND);
+		tglDisable(TGL_DEPTH_TEST);
+		tglDepthMask(TGL_TRUE);
+		tglDepthFunc(TGL_LESS);
+		tglShadeModel(TGL_SMOOTH);
+		tglDisable(TGL_TEXTURE_2D);
+		tglDeleteTextures(2, textures);
+	}
+
+	Graphics::Surface *render(const Graphics::PixelFormat &format, SceneFunc scene, bool dirtyRects, bool tiled) {
+		TinyGL::ContextHandle *handle = TinyGL::createContext(kWidth, kHeight, format, 256, false, dirtyRects);
+		TinyGL::GLContext *c = TinyGL::gl_get_context();
+
+		delete c->_tileRenderer;
+		c->_tileRenderer = tiled ? new TinyGL::TileRenderer(c, 4) : nullptr;
+
+		_random.setSeed(12345);
+		for (int frame = 0; frame < 3; frame++) {
+			(this->*scene)(frame);
+			TinyGL::presentBuffer();
+		}
+
+		Graphics::Surface *result = TinyGL::copyFromFrameBuffer(format);
+		TinyGL::destroyContext(handle);
+		return result;
+	}
+
+	void checkEqual(Graphics::Surface *expected, Graphics::Surface *actual) {
+		for (int y = 0; y < kHeight; y++)
+			TS_ASSERT_EQUALS(memcmp(expected->getBasePtr(0, y), actual->getBasePtr(0, y), kWidth * expected->format.bytesPerPixel), 0);
+
+		expected->free();
+		actual->free();
+		delete expected;
+		delete actual;
+	}
+
+	void checkTiledRendering(bool dirtyRects) {
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		Graphics::Surface *expected = render(format, &TinyGLTestSuite::drawScene, dirtyRects, false);
+		Graphics::Surface *actual = render(format, &TinyGLTestSuite::drawScene, dirtyRects, true);
+		checkEqual(expected, actual);
+	}
+
+	void checkSpanKernels(const Graphics::PixelFormat &format) {
+		Common::Array<const TinyGL::SpanKernels::Table *> tables = getSIMDTables();
+
+		for (uint t = 0; t < tables.size(); t++) {
+			// The scalar code renders the reference image
+			TinyGL::SpanKernels::kernels = &TinyGL::SpanKernels::generic;
+			Graphics::Surface *expected = render(format, &TinyGLTestSuite::drawTexturedScene, false, false);
+
+			TinyGL::SpanKernels::kernels = tables[t];
+			Graphics::Surface *actual = render(format, &TinyGLTestSuite::drawTexturedScene, false, false);
+
+			checkEqual(expected, actual);
+		}
+
+		TinyGL::SpanKernels::kernels = &TinyGL::SpanKernels::generic;
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+		// The test backend has no graphics manager to ask about the CPU features
+		TinyGL::SpanKernels::kernels = &TinyGL::SpanKernels::generic;
+	}
+
+	void test_tiled_rendering() {
+		checkTiledRendering(false);
+	}
+
+	void test_tiled_rendering_dirty_rects() {
+		checkTiledRendering(true);
+	}
+
+	void test_span_kernels() {
+		checkSpanKernels(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+		checkSpanKernels(Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0));
+	}
+};
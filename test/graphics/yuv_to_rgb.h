@@ -0,0 +1,131 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+#include "graphics/yuv_to_rgb-kernels.h"
+
+#include "test/kernel_tables.h"
+
+#include "../null_osystem.h"
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kHeight = 8,
+		kPitch = 320,
+		kPlaneSize = kPitch * (kHeight + 1)
+	};
+
+	enum Subsampling {
+		k444,
+		k422,
+		k420,
+		k420Alpha,
+		k410
+	};
+
+	byte _y[kPlaneSize], _u[kPlaneSize], _v[kPlaneSize], _a[kPlaneSize];
+
+	Common::Array<const Graphics::YUVToRGBKernels::Table *> getSIMDTables() {
+		// All but the generic kernels, which the others are checked against
+		Common::Array<const Graphics::YUVToRGBKernels::Table *> tables = getKernelTables<Graphics::YUVToRGBKernels>();
+		tables.remove_at(0);
+		return tables;
+	}
+
+	void fillPlanes() {
+		TestRandom rnd(1234);
+		for (int i = 0; i < kPlaneSize; i++) {
+			_y[i] = rnd.next();
+			_u[i] = rnd.next();
+			_v[i] = rnd.next();
+			_a[i] = rnd.next();
+		}
+
+		// Include the extreme values, which need clipping
+		for (int i = 0; i < 16; i++) {
+			_y[i] = (i & 1) ? 0 : 255;
+			_u[i] = (i & 2) ? 0 : 255;
+			_v[i] = (i & 4) ? 0 : 255;
+		}
+	}
+
+	void convert(Graphics::Surface &dst, Subsampling subsampling, Graphics::YUVToRGBManager::LuminanceScale scale, int width) {
+		switch (subsampling) {
+		case k444:
+			YUVToRGBMan.convert444(&dst, scale, _y, _u, _v, width, kHeight, kPitch, kPitch);
+			break;
+		case k422:
+			YUVToRGBMan.convert422(&dst, scale, _y, _u, _v, width, kHeight, kPitch, kPitch);
+			break;
+		case k420:
+			YUVToRGBMan.convert420(&dst, scale, _y, _u, _v, width, kHeight, kPitch, kPitch);
+			break;
+		case k420Alpha:
+			YUVToRGBMan.convert420Alpha(&dst, scale, _y, _u, _v, _a, width, kHeight, kPitch, kPitch);
+			break;
+		case k410:
+			YUVToRGBMan.convert410(&dst, scale, _y, _u, _v, width, kHeight, kPitch, kPitch);
+			break;
+		default:
+			break;
+		}
+	}
+
+	void checkKernels(const Graphics::PixelFormat &format) {
+		Common::Array<const Graphics::YUVToRGBKernels::Table *> tables = getSIMDTables();
+		const Graphics::YUVToRGBManager::LuminanceScale scales[] = {
+			Graphics::YUVToRGBManager::kScaleFull,
+			Graphics::YUVToRGBManager::kScaleITU
+		};
+		// Include a row which is shorter than a block, and one which
+		// ends with a part of a block
+		const int widths[] = { 4, 300 };
+
+		Graphics::Surface expected, actual;
+		expected.create(kPitch, kHeight, format);
+		actual.create(kPitch, kHeight, format);
+
+		for (uint t = 0; t < tables.size(); t++) {
+			for (int s = k444; s <= k410; s++) {
+				for (uint i = 0; i < ARRAYSIZE(scales); i++) {
+					for (uint w = 0; w < ARRAYSIZE(widths); w++) {
+						// The lookup tables convert the reference image
+						Graphics::YUVToRGBKernels::kernels = &Graphics::YUVToRGBKernels::generic;
+						convert(expected, (Subsampling)s, scales[i], widths[w]);
+
+						Graphics::YUVToRGBKernels::kernels = tables[t];
+						convert(actual, (Subsampling)s, scales[i], widths[w]);
+
+						for (int y = 0; y < kHeight; y++)
+							TS_ASSERT_EQUALS(memcmp(expected.getBasePtr(0, y), actual.getBasePtr(0, y), widths[w] * format.bytesPerPixel), 0);
+					}
+				}
+			}
+		}
+
+		Graphics::YUVToRGBKernels::kernels = &Graphics::YUVToRGBKernels::generic;
+		expected.free();
+		actual.free();
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+		// The test backend has no graphics manager to ask about the CPU features
+		Graphics::YUVToRGBKernels::kernels = &Graphics::YUVToRGBKernels::generic;
+		fillPlanes();
+	}
+
+	void test_kernels_16bpp() {
+		checkKernels(Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+		checkKernels(Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15));
+		checkKernels(Graphics::PixelFormat(2, 4, 4, 4, 4, 12, 8, 4, 0));
+	}
+
+	void test_kernels_32bpp() {
+		checkKernels(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+		checkKernels(Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0));
+		checkKernels(Graphics::PixelFormat(4, 8, 8, 8, 8, 0, 8, 16, 24));
+	}
+};
@@ -0,0 +1,133 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/fs.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/ptr.h"
+#include "engines/savestate.h"
+#include "graphics/surface.h"
+#include "gui/saveload-metaloader.h"
+
+#include "../null_osystem.h"
+
+// The engines are not linked into the tests
+class Engine;
+Engine *g_engine = nullptr;
+
+struct SaveMetaCacheTestStat {
+	int64 size;
+	int64 modificationTime;
+};
+
+/** The size and modification time of the saves, which only exist in the tests. */
+static Common::HashMap<Common::String, SaveMetaCacheTestStat> g_saveMetaCacheTestStats;
+
+static bool statSaveMetaCacheTest(const Common::String &filename, int64 &fileSize, int64 &modificationTime) {
+	if (!g_saveMetaCacheTestStats.contains(filename))
+		return false;
+	fileSize = g_saveMetaCacheTestStats[filename].size;
+	modificationTime = g_saveMetaCacheTestStats[filename].modificationTime;
+	return true;
+}
+
+class SaveMetaCacheTestSuite : public CxxTest::TestSuite {
+private:
+	Common::FSNode getCacheFile() {
+		// Start from an invalid cache, which is ignored
+		Common::FSNode file(Common::Path("test/savemetacache.cache"));
+		Common::ScopedPtr<Common::WriteStream> stream(file.createWriteStream());
+		return file;
+	}
+
+	static void setStat(const Common::String &filename, int64 size, int64 modificationTime) {
+		SaveMetaCacheTestStat stat = { size, modificationTime };
+		g_saveMetaCacheTestStats.setVal(filename, stat);
+	}
+
+	SaveStateDescriptor makeDesc(int slot) {
+		SaveStateDescriptor desc(nullptr, slot, Common::U32String("Test save"));
+		desc.setSaveDate(2024, 5, 6);
+		desc.setSaveTime(7, 8);
+		desc.setPlayTime(7500000u);
+
+		Graphics::Surface *thumbnail = new Graphics::Surface();
+		thumbnail->create(4, 3, Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+		for (int y = 0; y < thumbnail->h; y++) {
+			for (int x = 0; x < thumbnail->w; x++)
+				*(uint16 *)thumbnail->getBasePtr(x, y) = y * 0x1234 + x * 0x0101;
+		}
+		desc.setThumbnail(thumbnail);
+		return desc;
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+		g_saveMetaCacheTestStats.clear();
+	}
+
+	void test_round_trip() {
+		Common::FSNode file = getCacheFile();
+		setStat("game.001", 100, 5000);
+
+		const SaveStateDescriptor desc = makeDesc(1);
+		{
+			GUI::SaveMetaCache cache(file, statSaveMetaCacheTest);
+			cache.set(1, "game.001", 100, 5000, desc);
+		}
+
+		GUI::SaveMetaCache cache(file, statSaveMetaCacheTest);
+		SaveStateDescriptor loaded;
+		TS_ASSERT(cache.get(nullptr, 1, "game.001", 100, 5000, loaded));
+		TS_ASSERT_EQUALS(loaded.getSaveSlot(), 1);
+		TS_ASSERT_EQUALS(loaded.getDescription(), desc.getDescription());
+		TS_ASSERT_EQUALS(loaded.getSaveDate(), "2024-05-06");
+		TS_ASSERT_EQUALS(loaded.getSaveTime(), "07:08");
+		TS_ASSERT_EQUALS(loaded.getPlayTimeMSecs(), 7500000u);
+		TS_ASSERT_EQUALS(loaded.getPlayTime(), "02:05");
+		TS_ASSERT_EQUALS(loaded.getDeletableFlag(), desc.getDeletableFlag());
+		TS_ASSERT_EQUALS(loaded.getWriteProtectedFlag(), desc.getWriteProtectedFlag());
+		TS_ASSERT(!loaded.isAutosave());
+
+		const Graphics::Surface *thumbnail = loaded.getThumbnail();
+		const Graphics::Surface *expected = desc.getThumbnail();
+		TS_ASSERT(thumbnail);
+		if (!thumbnail)
+			return;
+		TS_ASSERT_EQUALS(thumbnail->w, expected->w);
+		TS_ASSERT_EQUALS(thumbnail->h, expected->h);
+		TS_ASSERT(thumbnail->format == expected->format);
+		for (int y = 0; y < expected->h; y++)
+			TS_ASSERT(!memcmp(thumbnail->getBasePtr(0, y), expected->getBasePtr(0, y), expected->w * expected->format.bytesPerPixel));
+	}
+
+	void test_stale_entries() {
+		Common::FSNode file = getCacheFile();
+		setStat("game.002", 200, 6000);
+
+		{
+			GUI::SaveMetaCache cache(file, statSaveMetaCacheTest);
+			cache.set(2, "game.002", 200, 6000, makeDesc(2));
+		}
+
+		// The entry is not used for a save of another size or date
+		{
+			GUI::SaveMetaCache cache(file, statSaveMetaCacheTest);
+			SaveStateDescriptor loaded;
+			TS_ASSERT(!cache.get(nullptr, 2, "game.002", 201, 6000, loaded));
+			TS_ASSERT(!cache.get(nullptr, 2, "game.002", 200, 6001, loaded));
+			TS_ASSERT(!cache.get(nullptr, 2, "game.003", 200, 6000, loaded));
+			TS_ASSERT(!cache.get(nullptr, 3, "game.002", 200, 6000, loaded));
+			TS_ASSERT(cache.get(nullptr, 2, "game.002", 200, 6000, loaded));
+
+			// The save is overwritten before the cache is written back
+			setStat("game.002", 250, 7000);
+		}
+
+		// So the entry was dropped
+		GUI::SaveMetaCache cache(file, statSaveMetaCacheTest);
+		SaveStateDescriptor loaded;
+		TS_ASSERT(!cache.get(nullptr, 2, "game.002", 200, 6000, loaded));
+		TS_ASSERT(!cache.get(nullptr, 2, "game.002", 250, 7000, loaded));
+	}
+};
@@ -0,0 +1,247 @@
+#include <cxxtest/TestSuite.h>
+
+#if defined(HAVE_CONFIG_H)
+#include "config.h"
+#endif
+
+#include "common/memstream.h"
+#include "graphics/blit/blit-convert.h"
+#include "graphics/surface.h"
+#include "image/image_loader.h"
+#include "image/jpeg.h"
+#include "image/png.h"
+
+#include "test/kernel_tables.h"
+
+#include "../null_osystem.h"
+
+class ImageLoaderTestSuite : public CxxTest::TestSuite {
+private:
+	/** A 16x8 grayscale JPEG, with a left block of 138 and a right block of 108. */
+	static const uint8 *getJPEG(uint32 &size) {
+		static const uint8 jpegBuf[155] = {
+			0xff, 0xd8, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+			0x01, 0x01, 0x01, 0x01, 0x01, 0xff, 0xc0, 0x00, 0x0b, 0x08, 0x00,
+			0x08, 0x00, 0x10, 0x01, 0x01, 0x11, 0x00, 0xff, 0xc4, 0x00, 0x1f,
+			0x00, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04,
+			0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xc4, 0x00, 0x14,
+			0x10, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xda, 0x00, 0x08,
+			0x01, 0x01, 0x00, 0x00, 0x3f, 0x00, 0x7a, 0x08, 0x0f, 0x7f, 0xff,
+			0xd9
+		};
+
+		size = sizeof(jpegBuf);
+		return jpegBuf;
+	}
+
+	static Graphics::PixelFormat getFormat() {
+		return Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0);
+	}
+
+	/** Fill a surface with a pattern depending on @p seed. */
+	static void makeImage(Graphics::Surface &surface, int w, int h, uint32 seed) {
+		TestRandom rnd(seed);
+		surface.create(w, h, getFormat());
+		for (int y = 0; y < h; y++) {
+			for (int x = 0; x < w; x++)
+				surface.setPixel(x, y, (rnd.next() << 16) | rnd.next() | 0xFF);
+		}
+	}
+
+	/** Return a PNG of the image, which is owned by the caller. */
+	static Common::SeekableReadStream *makePNG(const Graphics::Surface &surface) {
+		Common::MemoryWriteStreamDynamic png(DisposeAfterUse::NO);
+		Image::writePNG(png, surface);
+		return new Common::MemoryReadStream(png.getData(), png.size(), DisposeAfterUse::YES);
+	}
+
+	static bool sameImage(const Graphics::Surface &a, const Graphics::Surface &b) {
+		if (a.w != b.w || a.h != b.h || a.format != b.format)
+			return false;
+		for (int y = 0; y < a.h; y++) {
+			if (memcmp(a.getBasePtr(0, y), b.getBasePtr(0, y), a.w * a.format.bytesPerPixel))
+				return false;
+		}
+		return true;
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+		// The test backend has no graphics manager to ask about the CPU features
+		Graphics::CrossBlitKernels::kernels = &Graphics::CrossBlitKernels::generic;
+	}
+
+	void test_detect_format() {
+		uint32 size;
+		const uint8 *jpeg = getJPEG(size);
+		Common::MemoryReadStream jpegStream(jpeg, size);
+		TS_ASSERT_EQUALS(Image::ImageLoader::detectFormat(jpegStream), Image::ImageLoader::kFormatJPEG);
+		TS_ASSERT_EQUALS(jpegStream.pos(), 0);
+
+		const uint8 garbage[4] = { 0x89, 'P', 'N', 'G' };
+		Common::MemoryReadStream garbageStream(garbage, sizeof(garbage));
+		TS_ASSERT_EQUALS(Image::ImageLoader::detectFormat(garbageStream), Image::ImageLoader::kFormatUnknown);
+	}
+
+	void test_decode_png() {
+#ifdef USE_PNG
+		Image::ImageLoader loader(1);
+		Graphics::Surface image1, image2, surface;
+		makeImage(image1, 33, 17, 1);
+		makeImage(image2, 33, 17, 2);
+
+		Common::SeekableReadStream *png = makePNG(image1);
+		TS_ASSERT(loader.decode(*png, surface, getFormat()));
+		TS_ASSERT(sameImage(image1, surface));
+		delete png;
+
+		// The second image goes into the same surface, through the same decoder
+		const void *pixels = surface.getPixels();
+		png = makePNG(image2);
+		TS_ASSERT(loader.decode(*png, surface, getFormat()));
+		TS_ASSERT_EQUALS(surface.getPixels(), pixels);
+		TS_ASSERT(sameImage(image2, surface));
+		delete png;
+
+		// The images are converted to the format of the surface
+		Graphics::Surface small;
+		small.create(33, 17, Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+		png = makePNG(image1);
+		TS_ASSERT(loader.decode(*png, small, getFormat()));
+		Graphics::Surface *expected = image1.convertTo(small.format);
+		TS_ASSERT(sameImage(*expected, small));
+		expected->free();
+		delete expected;
+		delete png;
+
+		// A surface of another size is rejected
+		Graphics::Surface other;
+		other.create(32, 17, getFormat());
+		png = makePNG(image1);
+		TS_ASSERT(!loader.decode(*png, other, getFormat()));
+		delete png;
+
+		image1.free();
+		image2.free();
+		surface.free();
+		small.free();
+		other.free();
+#endif
+	}
+
+	void test_decode_jpeg() {
+#ifdef USE_JPEG
+		Image::ImageLoader loader(1);
+		uint32 size;
+		const uint8 *jpeg = getJPEG(size);
+		const Graphics::PixelFormat format(4, 8, 8, 8, 0, 16, 8, 0, 0);
+
+		// Decode twice, the second time with the libjpeg context kept by the loader
+		for (int i = 0; i < 2; i++) {
+			Graphics::Surface surface;
+			Common::MemoryReadStream stream(jpeg, size);
+			TS_ASSERT(loader.decode(stream, surface, format));
+			TS_ASSERT_EQUALS(surface.w, 16);
+			TS_ASSERT_EQUALS(surface.h, 8);
+			TS_ASSERT(surface.format == format);
+			TS_ASSERT_EQUALS(surface.getPixel(3, 4) & 0xFFFFFF, 0x8A8A8Au);
+			TS_ASSERT_EQUALS(surface.getPixel(12, 5) & 0xFFFFFF, 0x6C6C6Cu);
+			surface.free();
+		}
+#endif
+	}
+
+	void test_decode_jpeg_into_surface() {
+#ifdef USE_JPEG
+		Image::JPEGDecoder decoder;
+		uint32 size;
+		const uint8 *jpeg = getJPEG(size);
+		const Graphics::PixelFormat format(4, 8, 8, 8, 0, 16, 8, 0, 0);
+		TS_ASSERT(decoder.setOutputPixelFormat(format));
+
+		Graphics::Surface surface;
+		Common::MemoryReadStream stream(jpeg, size);
+		TS_ASSERT(decoder.loadStreamInto(stream, surface));
+		TS_ASSERT_EQUALS(surface.w, 16);
+		TS_ASSERT_EQUALS(surface.h, 8);
+		TS_ASSERT(surface.format == format);
+		TS_ASSERT_EQUALS(surface.getPixel(3, 4) & 0xFFFFFF, 0x8A8A8Au);
+
+		// The next image goes into the same pixels
+		const void *pixels = surface.getPixels();
+		surface.fillRect(Common::Rect(surface.w, surface.h), 0);
+		stream.seek(0);
+		TS_ASSERT(decoder.loadStreamInto(stream, surface));
+		TS_ASSERT_EQUALS(surface.getPixels(), pixels);
+		TS_ASSERT_EQUALS(surface.getPixel(12, 5) & 0xFFFFFF, 0x6C6C6Cu);
+
+		// A surface in another format is converted into
+		Graphics::Surface small;
+		small.create(16, 8, Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+		decoder.setOutputPixelFormat(small.format);
+		stream.seek(0);
+		TS_ASSERT(decoder.loadStreamInto(stream, small));
+		TS_ASSERT_EQUALS(small.getPixel(3, 4), small.format.RGBToColor(0x8A, 0x8A, 0x8A));
+
+		// A surface of another size is rejected, and the decoder still works
+		Graphics::Surface other;
+		other.create(15, 8, format);
+		decoder.setOutputPixelFormat(format);
+		stream.seek(0);
+		TS_ASSERT(!decoder.loadStreamInto(stream, other));
+		stream.seek(0);
+		TS_ASSERT(decoder.loadStreamInto(stream, surface));
+		TS_ASSERT_EQUALS(surface.getPixel(3, 4) & 0xFFFFFF, 0x8A8A8Au);
+
+		surface.free();
+		small.free();
+		other.free();
+#endif
+	}
+
+	void test_decode_batch() {
+		Image::ImageLoader loader(4);
+		Common::Array<Image::ImageLoader::Request> requests;
+		Common::Array<Graphics::Surface> images, surfaces;
+		uint expectedCount = 0;
+
+		images.resize(8);
+		surfaces.resize(9);
+		for (uint i = 0; i < images.size(); i++)
+			makeImage(images[i], 20 + i, 10 + 2 * i, i);
+
+#ifdef USE_PNG
+		for (uint i = 0; i < images.size(); i++)
+			requests.push_back(Image::ImageLoader::Request(makePNG(images[i]), &surfaces[i]));
+		expectedCount += images.size();
+#endif
+
+		const uint8 garbage[16] = { 0xff, 0xd8 };
+		requests.push_back(Image::ImageLoader::Request(new Common::MemoryReadStream(garbage, sizeof(garbage)), &surfaces[8]));
+
+		TS_ASSERT_EQUALS(loader.decodeBatch(requests, getFormat()), expectedCount);
+
+		for (uint i = 0; i < requests.size(); i++) {
+			if (i < expectedCount) {
+				TS_ASSERT(requests[i].success);
+				TS_ASSERT(sameImage(images[i], surfaces[i]));
+			} else {
+				TS_ASSERT(!requests[i].success);
+			}
+			delete requests[i].stream;
+		}
+
+		for (uint i = 0; i < images.size(); i++)
+			images[i].free();
+		for (uint i = 0; i < surfaces.size(); i++)
+			surfaces[i].free();
+	}
+};
@@ -0,0 +1,49 @@
+#ifndef TEST_KERNEL_TABLES_H
+#define TEST_KERNEL_TABLES_H
+
+#include "common/cpu-kernels.h"
+
+#include "test/instrset_detect.h"
+
+/**
+ * A seeded random number generator for the inputs of the tests, which gives
+ * the same numbers on every platform.
+ */
+class TestRandom {
+public:
+	explicit TestRandom(uint32 seed = 1) : _seed(seed) {}
+
+	void setSeed(uint32 seed) { _seed = seed; }
+
+	/** @return 16 random bits. */
+	uint32 next() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 16;
+	}
+
+private:
+	uint32 _seed;
+};
+
+/**
+ * The versions of a set of kernels which the CPU runs, the generic one
+ * first, whatever the backend reports. See Common::CpuKernels.
+ */
+template<class Kernels>
+Common::Array<const typename Kernels::Table *> getKernelTables() {
+	typedef Common::CpuKernels<Kernels> Versions;
+
+	Common::Array<const typename Kernels::Table *> tables;
+	tables.push_back(&Kernels::generic);
+	if (Versions::neon())
+		tables.push_back(Versions::neon());
+#if defined(SCUMMVM_SSE2) || defined(SCUMMVM_AVX2)
+	if (Versions::sse2() && instrset_detect() >= 2)
+		tables.push_back(Versions::sse2());
+	if (Versions::avx2() && instrset_detect() >= 8)
+		tables.push_back(Versions::avx2());
+#endif
+	return tables;
+}
+
+#endif
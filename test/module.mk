@@ -5,17 +5,36 @@
 #
 ######################################################################
 
-TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/common/formats/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/math/*.h $(srcdir)/test/image/*.h
+TESTS        := $(filter-out $(srcdir)/test/common/profiler.h,$(wildcard $(srcdir)/test/common/*.h)) $(srcdir)/test/common/compression/zip.h $(srcdir)/test/common/formats/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/math/*.h $(srcdir)/test/image/*.h $(srcdir)/test/graphics/blit.h $(srcdir)/test/graphics/managed_surface.h $(srcdir)/test/graphics/scaler.h $(srcdir)/test/graphics/yuv_to_rgb.h $(srcdir)/test/video/video_decoder.h
 TEST_LIBS    :=
 
+ifdef USE_TINYGL
+TESTS += $(srcdir)/test/graphics/tinygl.h
+endif
+
+ifdef USE_BINK
+TESTS += $(srcdir)/test/video/bink.h
+endif
+
+ifdef ENABLE_PROFILER
+TESTS += $(srcdir)/test/common/profiler.h
+endif
+
 ifdef POSIX
+# The cache file of the test is written with the POSIX file system
+TESTS += $(srcdir)/test/gui/saveload-metaloader.h
+TESTS += $(srcdir)/test/backends/fs/posix-mappedstream.h
 TEST_LIBS += test/null_osystem.o \
 	backends/fs/posix/posix-fs-factory.o \
 	backends/fs/posix/posix-fs.o \
 	backends/fs/posix/posix-iostream.o \
+	backends/fs/posix/posix-mappedstream.o \
 	backends/fs/abstract-fs.o \
 	backends/fs/stdiostream.o \
-	backends/modular-backend.o
+	backends/modular-backend.o \
+	backends/mutex/pthread/pthread-mutex.o \
+	gui/saveload-metaloader.o \
+	engines/savestate.o
 endif
 
 ifdef WIN32
@@ -28,7 +47,7 @@ TEST_LIBS += test/null_osystem.o \
 	backends/platform/sdl/win32/win32_wrapper.o
 endif
 
-TEST_LIBS +=	audio/libaudio.a math/libmath.a common/formats/libformats.a common/compression/libcompression.a common/libcommon.a image/libimage.a graphics/libgraphics.a
+TEST_LIBS +=	video/libvideo.a audio/libaudio.a math/libmath.a common/formats/libformats.a common/compression/libcompression.a common/libcommon.a image/libimage.a graphics/libgraphics.a
 
 ifeq ($(ENABLE_WINTERMUTE), STATIC_PLUGIN)
 	TESTS += $(srcdir)/test/engines/wintermute/*.h
@@ -52,6 +71,10 @@ TEST_LDFLAGS := $(LDFLAGS) $(LIBS)
 TEST_CXXFLAGS  := $(filter-out -Wglobal-constructors,$(CXXFLAGS))
 TEST_CXXFLAGS += -Wno-self-assign-overloaded
 
+ifdef POSIX
+TEST_LDFLAGS += -lpthread
+endif
+
 ifdef WIN32
 TEST_LDFLAGS := $(filter-out -mwindows,$(TEST_LDFLAGS))
 endif
@@ -81,7 +104,7 @@ test/runner.cpp: $(TESTS) $(srcdir)/test/module.mk
 
 clean: clean-test
 clean-test:
-	-$(RM) test/runner.cpp test/runner test/engine-data/encoding.dat test/null_osystem.o
+	-$(RM) test/runner.cpp test/runner test/engine-data/encoding.dat test/null_osystem.o test/savemetacache.cache
 	-rmdir test/engine-data
 
 test/engine-data/encoding.dat: $(srcdir)/dists/engine-data/encoding.dat
@@ -1,10 +1,22 @@
 #define FORBIDDEN_SYMBOL_EXCEPTION_abort
+#define FORBIDDEN_SYMBOL_EXCEPTION_getenv
+#define FORBIDDEN_SYMBOL_EXCEPTION_unlink
 
 #define USE_NULL_DRIVER 1
 #define NULL_DRIVER_USE_FOR_TEST 1
+#ifdef POSIX
+// For the tests of the code running on worker threads
+#define NULL_DRIVER_USE_THREADS 1
+#endif
 #include "null_osystem.h"
 #include "../backends/platform/null/null.cpp"
 
+#include "common/fs.h"
+
+#ifdef POSIX
+#include <stdlib.h>
+#endif
+
 //#define DISPLAY_ERROR_MESSAGES
 
 void Common::install_null_g_system() {
@@ -17,6 +29,45 @@ void Common::install_null_g_system() {
 	g_system = OSystem_NULL_create(silenceLogs);
 }
 
+Common::FSNode Common::createTestTempDirectory() {
+#if defined(POSIX)
+	const char *tmp = getenv("TMPDIR");
+	Common::String path = Common::String::format("%s/scummvm-test-XXXXXX", tmp && *tmp ? tmp : "/tmp");
+	if (!mkdtemp(path.begin()))
+		error("Could not create a temporary directory for the tests");
+#else
+	char tmp[MAX_PATH];
+	if (!GetTempPathA(MAX_PATH, tmp))
+		error("Could not find the temporary directory for the tests");
+	Common::String path = Common::String::format("%sscummvm-test-%u-%u", tmp, (uint)GetCurrentProcessId(), (uint)GetTickCount());
+	if (!CreateDirectoryA(path.c_str(), nullptr))
+		error("Could not create a temporary directory for the tests");
+#endif
+	return Common::FSNode(Common::Path(path, Common::Path::kNativeSeparator));
+}
+
+void Common::removeTestTempDirectory(const Common::FSNode &dir) {
+	Common::FSList files;
+	if (dir.getChildren(files, Common::FSNode::kListAll, true)) {
+		for (const Common::FSNode &file : files) {
+			if (file.isDirectory())
+				removeTestTempDirectory(file);
+			else
+#if defined(POSIX)
+				unlink(file.getPath().toString(Common::Path::kNativeSeparator).c_str());
+#else
+				DeleteFileA(file.getPath().toString(Common::Path::kNativeSeparator).c_str());
+#endif
+		}
+	}
+
+#if defined(POSIX)
+	rmdir(dir.getPath().toString(Common::Path::kNativeSeparator).c_str());
+#else
+	RemoveDirectoryA(dir.getPath().toString(Common::Path::kNativeSeparator).c_str());
+#endif
+}
+
 void OSystem_NULL::quit() {
 	abort();
 }
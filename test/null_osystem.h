@@ -2,7 +2,16 @@
 #define TEST_NULL_OSYSTEM 1
 namespace Common {
 #if defined(POSIX) || defined(WIN32)
+class FSNode;
+
 void install_null_g_system();
+
+/** Create an empty directory for the files of a test, in the temporary directory of the system. */
+FSNode createTestTempDirectory();
+
+/** Delete a directory from createTestTempDirectory(), with the files in it. */
+void removeTestTempDirectory(const FSNode &dir);
+
 #define NULL_OSYSTEM_IS_AVAILABLE 1
 #else
 #define NULL_OSYSTEM_IS_AVAILABLE 0
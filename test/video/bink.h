@@ -0,0 +1,105 @@
+#include <cxxtest/TestSuite.h>
+
+#include "video/bink_kernels.h"
+
+#include "test/kernel_tables.h"
+
+#include "../null_osystem.h"
+
+class BinkTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kPitch = 24,
+		kBlocks = 200
+	};
+
+	TestRandom _random;
+
+	int randomRange(int min, int max) {
+		return min + (int)(_random.next() % (max - min + 1));
+	}
+
+	Common::Array<const Video::BinkKernels::Table *> getSIMDTables() {
+		// All but the generic kernels, which the others are checked against
+		Common::Array<const Video::BinkKernels::Table *> tables = getKernelTables<Video::BinkKernels>();
+		tables.remove_at(0);
+		return tables;
+	}
+
+	/** Fill a block like the DCT coefficients of the decoder: a DC value, and a few others. */
+	void fillCoefficients(int32 *block, uint n) {
+		memset(block, 0, 64 * sizeof(int32));
+		block[0] = randomRange(-2048, 2047);
+
+		// Include blocks with a single column, and blocks out of the range of the pixels
+		const uint count = (n % 4 == 0) ? 0 : _random.next() % 24;
+		const int range = (n % 7 == 0) ? 8192 : 1024;
+		for (uint i = 0; i < count; i++)
+			block[_random.next() % 64] = randomRange(-range, range);
+	}
+
+	void fillPixels(byte *pixels) {
+		for (int i = 0; i < kPitch * 16; i++)
+			pixels[i] = _random.next();
+	}
+
+	void checkEqual(const byte *expected, const byte *actual) {
+		TS_ASSERT_EQUALS(memcmp(expected, actual, kPitch * 16), 0);
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+		// The test backend has no graphics manager to ask about the CPU features
+		Video::BinkKernels::kernels = &Video::BinkKernels::generic;
+	}
+
+	void test_kernels() {
+		Common::Array<const Video::BinkKernels::Table *> tables = getSIMDTables();
+		const Video::BinkKernels::Table &generic = Video::BinkKernels::generic;
+
+		for (uint t = 0; t < tables.size(); t++) {
+			_random.setSeed(1234);
+
+			for (uint n = 0; n < kBlocks; n++) {
+				int32 coeffs[64];
+				int16 residue[64];
+				byte src[64], pattern[8];
+				byte expected[kPitch * 16], actual[kPitch * 16];
+
+				fillCoefficients(coeffs, n);
+				for (int i = 0; i < 64; i++) {
+					residue[i] = randomRange(-300, 300);
+					src[i] = _random.next();
+				}
+				for (int i = 0; i < 8; i++)
+					pattern[i] = _random.next();
+				const byte col0 = _random.next();
+				const byte col1 = _random.next();
+
+				// Write at an offset, to check that the pixels around the block are kept
+				fillPixels(expected);
+				memcpy(actual, expected, sizeof(actual));
+				generic.idctPut(expected + 3, kPitch, coeffs);
+				tables[t]->idctPut(actual + 3, kPitch, coeffs);
+				checkEqual(expected, actual);
+
+				generic.idctAdd(expected + 5, kPitch, coeffs);
+				tables[t]->idctAdd(actual + 5, kPitch, coeffs);
+				checkEqual(expected, actual);
+
+				generic.addResidue(expected + 1, kPitch, residue);
+				tables[t]->addResidue(actual + 1, kPitch, residue);
+				checkEqual(expected, actual);
+
+				generic.putPattern(expected + 7, kPitch, col0, col1, pattern);
+				tables[t]->putPattern(actual + 7, kPitch, col0, col1, pattern);
+				checkEqual(expected, actual);
+
+				generic.putScaled(expected + 2, kPitch, src);
+				tables[t]->putScaled(actual + 2, kPitch, src);
+				checkEqual(expected, actual);
+			}
+		}
+	}
+};
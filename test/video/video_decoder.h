@@ -0,0 +1,191 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/atomic.h"
+#include "common/system.h"
+#include "common/thread.h"
+#include "graphics/surface.h"
+#include "video/video_decoder.h"
+
+#include "../null_osystem.h"
+
+/**
+ * A video of frames filled with their number, at 1000 frames per second. Each
+ * frame is only decoded once the test posts the gate.
+ */
+class GatedVideoDecoder : public Video::VideoDecoder {
+public:
+	GatedVideoDecoder(int frameCount, Common::SemaphoreInternal *gate, Common::SemaphoreInternal *entered) {
+		_track = new GatedVideoTrack(frameCount, gate, entered);
+		addTrack(_track);
+	}
+
+	~GatedVideoDecoder() override {
+		close();
+	}
+
+	bool loadStream(Common::SeekableReadStream *stream) override { return false; }
+
+	/** The number of calls to the track which depend on the frames decoded. */
+	uint32 getTrackAccesses() const { return _track->_accesses.load(); }
+
+protected:
+	bool supportsDecodeAhead() const override { return true; }
+
+private:
+	class GatedVideoTrack : public FixedRateVideoTrack {
+	public:
+		GatedVideoTrack(int frameCount, Common::SemaphoreInternal *gate, Common::SemaphoreInternal *entered) :
+				_frameCount(frameCount), _curFrame(-1), _gate(gate), _entered(entered) {
+			_surface.create(4, 4, Graphics::PixelFormat::createFormatCLUT8());
+		}
+
+		~GatedVideoTrack() override {
+			_surface.free();
+		}
+
+		uint16 getWidth() const override { return _surface.w; }
+		uint16 getHeight() const override { return _surface.h; }
+		Graphics::PixelFormat getPixelFormat() const override { return _surface.format; }
+		int getFrameCount() const override { return _frameCount; }
+
+		bool endOfTrack() const override {
+			_accesses.fetchAdd(1);
+			return FixedRateVideoTrack::endOfTrack();
+		}
+
+		int getCurFrame() const override {
+			_accesses.fetchAdd(1);
+			return _curFrame;
+		}
+
+		uint32 getNextFrameStartTime() const override {
+			_accesses.fetchAdd(1);
+			return FixedRateVideoTrack::getNextFrameStartTime();
+		}
+
+		const Graphics::Surface *decodeNextFrame() override {
+			_entered->post();
+			_gate->wait();
+
+			_curFrame++;
+			_surface.fillRect(Common::Rect(_surface.w, _surface.h), _curFrame);
+			return &_surface;
+		}
+
+		mutable Common::Atomic<uint32> _accesses;
+
+	protected:
+		Common::Rational getFrameRate() const override { return 1000; }
+
+	private:
+		Graphics::Surface _surface;
+		int _frameCount;
+		int _curFrame;
+		Common::SemaphoreInternal *_gate;
+		Common::SemaphoreInternal *_entered;
+	};
+
+	GatedVideoTrack *_track;
+};
+
+class VideoDecoderTestSuite : public CxxTest::TestSuite {
+private:
+	Common::SemaphoreInternal *_gate;
+	Common::SemaphoreInternal *_entered;
+
+	/** Wait until the next frame is due, without waiting for the worker. */
+	static bool waitForUpdate(const Video::VideoDecoder &decoder) {
+		for (int i = 0; i < 5000; i++) {
+			if (decoder.needsUpdate())
+				return true;
+			g_system->delayMillis(1);
+		}
+		return false;
+	}
+
+public:
+	void setUp() {
+		Common::install_null_g_system();
+		_gate = g_system->createSemaphore();
+		_entered = g_system->createSemaphore();
+	}
+
+	void tearDown() {
+		delete _gate;
+		delete _entered;
+	}
+
+	void test_decode_ahead_does_not_wait() {
+		// The frames are only decoded ahead on backends with threads
+		if (!_gate || !_entered)
+			return;
+
+		const int frameCount = 4;
+		GatedVideoDecoder decoder(frameCount, _gate, _entered);
+		TS_ASSERT(decoder.setDecodeAhead(2));
+		decoder.start();
+
+		_gate->post();
+		const Graphics::Surface *surface = decoder.decodeNextFrame();
+		TS_ASSERT(surface);
+		TS_ASSERT_EQUALS(*(const byte *)surface->getPixels(), 0);
+		_entered->wait();
+
+		for (int i = 1; i < frameCount; i++) {
+			// The worker is stuck in the frame, which would be due by now
+			_entered->wait();
+			g_system->delayMillis(5);
+
+			const uint32 accesses = decoder.getTrackAccesses();
+			TS_ASSERT(!decoder.needsUpdate());
+			TS_ASSERT_DIFFERS(decoder.getTimeToNextFrame(), 0u);
+			TS_ASSERT(!decoder.endOfVideo());
+			TS_ASSERT_EQUALS(decoder.getCurFrame(), i - 1);
+			TS_ASSERT_EQUALS(decoder.getTrackAccesses(), accesses);
+
+			_gate->post();
+			TS_ASSERT(waitForUpdate(decoder));
+
+			surface = decoder.decodeNextFrame();
+			TS_ASSERT(surface);
+			if (surface)
+				TS_ASSERT_EQUALS(*(const byte *)surface->getPixels(), i);
+			TS_ASSERT_EQUALS(decoder.getCurFrame(), i);
+		}
+
+		// The worker finds the end of the video by itself
+		for (int i = 0; i < 5000 && !decoder.endOfVideo(); i++)
+			g_system->delayMillis(1);
+		TS_ASSERT(decoder.endOfVideo());
+		TS_ASSERT(!decoder.decodeNextFrame());
+	}
+
+	void test_decode_ahead_end_time() {
+		if (!_gate || !_entered)
+			return;
+
+		// The worker is stopped by the free slots before the end of the video
+		const int frameCount = 20;
+		GatedVideoDecoder decoder(frameCount, _gate, _entered);
+		for (int i = 0; i < frameCount; i++)
+			_gate->post();
+
+		TS_ASSERT(decoder.setDecodeAhead(2));
+		decoder.setEndFrame(2);
+		decoder.start();
+
+		int frames = 0;
+		for (int i = 0; i < 5000 && !decoder.endOfVideo(); i++) {
+			if (decoder.needsUpdate()) {
+				TS_ASSERT(decoder.decodeNextFrame());
+				frames++;
+			} else {
+				g_system->delayMillis(1);
+			}
+		}
+
+		TS_ASSERT(decoder.endOfVideo());
+		TS_ASSERT_EQUALS(frames, 3);
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 2);
+	}
+};
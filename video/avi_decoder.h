@@ -103,6 +103,8 @@ protected:
 	void readNextPacket();
 	bool seekIntern(const Audio::Timestamp &time);
 	bool supportsAudioTrackSwitching() const { return true; }
+	// The transparency track is decoded separately, by the caller
+	bool supportsDecodeAhead() const { return !_transparencyTrack.track; }
 	AudioTrack *getAudioTrack(int index);
 
 	/**
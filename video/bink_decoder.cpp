@@ -29,6 +29,7 @@
 #include "common/util.h"
 #include "common/textconsole.h"
 #include "common/intrinsics.h"
+#include "common/memstream.h"
 #include "common/stream.h"
 #include "common/substream.h"
 #include "common/file.h"
@@ -36,6 +37,7 @@
 #include "common/bitstream.h"
 #include "common/compression/huffman.h"
 #include "common/system.h"
+#include "common/workerpool.h"
 
 #include "graphics/yuv_to_rgb.h"
 #include "graphics/surface.h"
@@ -203,13 +205,20 @@ void BinkDecoder::readNextPacket() {
 	uint32 videoPacketStart = _bink->pos();
 	uint32 videoPacketEnd   = _bink->pos() + frameSize;
 
-	frame.bits = new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink,
-			videoPacketStart, videoPacketEnd), DisposeAfterUse::YES);
+	// Read the whole packet, so that the planes can be decoded in parallel
+	byte *data = (byte *)malloc(videoPacketEnd - videoPacketStart);
+	if (!data || _bink->read(data, videoPacketEnd - videoPacketStart) != videoPacketEnd - videoPacketStart)
+		error("Failed to read the video packet of frame %d", videoTrack->getCurFrame() + 1);
+
+	frame.data = data;
+	frame.bits = new Common::BitStream32LELSB(new Common::MemoryReadStream(data,
+			videoPacketEnd - videoPacketStart, DisposeAfterUse::YES), DisposeAfterUse::YES);
 
 	videoTrack->decodePacket(frame);
 
 	delete frame.bits;
 	frame.bits = 0;
+	frame.data = 0;
 }
 
 VideoDecoder::AudioTrack *BinkDecoder::getAudioTrack(int index) {
@@ -222,7 +231,7 @@ VideoDecoder::AudioTrack *BinkDecoder::getAudioTrack(int index) {
 	return (AudioTrack *)track;
 }
 
-BinkDecoder::VideoFrame::VideoFrame() : bits(0) {
+BinkDecoder::VideoFrame::VideoFrame() : bits(0), data(0), speculative(false), invalid(false) {
 }
 
 BinkDecoder::VideoFrame::~VideoFrame() {
@@ -249,24 +258,11 @@ BinkDecoder::BinkVideoTrack::BinkVideoTrack(uint32 width, uint32 height, uint32
 	for (int i = 0; i < 16; i++)
 		_huffman[i] = 0;
 
-	for (int i = 0; i < kSourceMAX; i++) {
-		_bundles[i].countLength = 0;
-
-		_bundles[i].huffman.index = 0;
-		for (int j = 0; j < 16; j++)
-			_bundles[i].huffman.symbols[j] = j;
-
-		_bundles[i].data     = 0;
-		_bundles[i].dataEnd  = 0;
-		_bundles[i].curDec   = 0;
-		_bundles[i].curPtr   = 0;
-	}
-
-	for (int i = 0; i < 16; i++) {
-		_colHighHuffman[i].index = 0;
-		for (int j = 0; j < 16; j++)
-			_colHighHuffman[i].symbols[j] = j;
-	}
+	_chromaState = nullptr;
+	_pool = nullptr;
+	_chromaOffset = kChromaOffsetUnknown;
+	_chromaOffsetSeen = kChromaOffsetUnknown;
+	_chromaInvalid = false;
 
 	// Make the surface even-sized:
 	_surfaceHeight = _height = height;
@@ -305,7 +301,7 @@ BinkDecoder::BinkVideoTrack::BinkVideoTrack(uint32 width, uint32 height, uint32
 	memset(_curPlanes[3], 255, _yBlockWidth  * 8 * _yBlockHeight  * 8);
 	memset(_oldPlanes[3], 255, _yBlockWidth  * 8 * _yBlockHeight  * 8);
 
-	initBundles();
+	initBundles(_planeState);
 	initHuffman();
 }
 
@@ -315,7 +311,16 @@ BinkDecoder::BinkVideoTrack::~BinkVideoTrack() {
 		delete[] _oldPlanes[i]; _oldPlanes[i] = 0;
 	}
 
-	deinitBundles();
+	// Stop the worker before freeing what it uses
+	delete _pool;
+	_pool = nullptr;
+
+	deinitBundles(_planeState);
+	if (_chromaState) {
+		deinitBundles(*_chromaState);
+		delete _chromaState;
+		_chromaState = nullptr;
+	}
 
 	for (int i = 0; i < 16; i++) {
 		delete _huffman[i];
@@ -446,6 +451,30 @@ bool BinkDecoder::BinkVideoTrack::rewind() {
 	return true;
 }
 
+class BinkDecoder::BinkVideoTrack::ChromaJob : public Common::WorkerJob {
+public:
+	ChromaJob(BinkVideoTrack *track, const byte *data, uint32 size, uint32 start) :
+			_track(track), _data(data), _size(size), _start(start) {
+	}
+
+	void run() override {
+		VideoFrame frame;
+		frame.data = _data;
+		frame.bits = new Common::BitStream32LELSB(new Common::MemoryReadStream(_data, _size), DisposeAfterUse::YES);
+		frame.bits->skip(_start);
+		frame.speculative = true;
+
+		_track->decodeChromaPlanes(frame, *_track->_chromaState);
+		_track->_chromaInvalid = frame.invalid;
+	}
+
+private:
+	BinkVideoTrack *_track;
+	const byte *_data;
+	uint32 _size;
+	uint32 _start;
+};
+
 void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
 	assert(frame.bits);
 
@@ -463,21 +492,53 @@ void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
 		if (_id == kBIKiID)
 			frame.bits->skip(32);
 
-		decodePlane(frame, 3, false);
+		decodePlane(frame, _planeState, 3, false);
 	}
 
-	if (_id == kBIKiID)
-		frame.bits->skip(32);
+	uint32 planeOffset = 0;
+	uint32 fieldEnd = 0;
+	if (_id == kBIKiID) {
+		planeOffset = frame.bits->getBits<32>();
+		fieldEnd = frame.bits->pos();
+	}
 
-	for (int i = 0; i < 3; i++) {
-		int planeIdx = ((i == 0) || !_swapPlanes) ? i : (i ^ 3);
+	// Once it is known where the chroma planes start, decode them on a
+	// worker thread while this one decodes the luma plane
+	bool parallel = false;
+	uint32 chromaStart = 0;
+	if (_chromaOffset == kChromaOffsetFromPacket || _chromaOffset == kChromaOffsetFromField) {
+		chromaStart = planeOffset * 8;
+		if (_chromaOffset == kChromaOffsetFromField)
+			chromaStart += fieldEnd;
+
+		// The planes start at 32-bit boundaries, after the luma plane
+		if (chromaStart > frame.bits->pos() && chromaStart < frame.bits->size() && !(chromaStart & 0x1F) &&
+				(_pool || startChromaWorker())) {
+			BinkKernels::get();
+			_pool->submit(new ChromaJob(this, frame.data, frame.bits->size() / 8, chromaStart));
+			parallel = true;
+		}
+	}
 
-		decodePlane(frame, planeIdx, i != 0);
+	decodePlane(frame, _planeState, 0, false);
+	const uint32 lumaEnd = frame.bits->pos();
 
-		if (frame.bits->pos() >= frame.bits->size())
-			break;
+	if (parallel)
+		_pool->wait();
+
+	if (_id == kBIKiID && lumaEnd < frame.bits->size())
+		checkChromaOffset(planeOffset, fieldEnd, lumaEnd);
+
+	if (parallel && (lumaEnd != chromaStart || _chromaInvalid)) {
+		// The offset did not point to the chroma planes after all, so drop
+		// what the worker thread decoded from there
+		warning("Bink: Unexpected plane offset in frame %d, decoding the planes serially", _curFrame + 1);
+		parallel = false;
 	}
 
+	if (!parallel && lumaEnd < frame.bits->size())
+		decodeChromaPlanes(frame, _planeState);
+
 	// Convert the YUV data we have to our format
 	// The width used here is the surface-width, and not the video-width
 	// to allow for odd-sized videos.
@@ -498,7 +559,7 @@ void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
 	_curFrame++;
 }
 
-void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, bool isChroma) {
+void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, PlaneState &state, int planeIdx, bool isChroma) {
 	uint32 blockWidth  = isChroma ? _uvBlockWidth  : _yBlockWidth;
 	uint32 blockHeight = isChroma ? _uvBlockHeight : _yBlockHeight;
 	uint32 width       = blockWidth  * 8;
@@ -507,6 +568,8 @@ void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, b
 	DecodeContext ctx;
 
 	ctx.video     = &video;
+	ctx.state     = &state;
+	ctx.kernels   = &BinkKernels::get();
 	ctx.planeIdx  = planeIdx;
 	ctx.destStart = _curPlanes[planeIdx];
 	ctx.destEnd   = _curPlanes[planeIdx] + width * height;
@@ -524,27 +587,30 @@ void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, b
 	}
 
 	for (int i = 0; i < kSourceMAX; i++) {
-		_bundles[i].countLength = _bundles[i].countLengths[isChroma ? 1 : 0];
+		state.bundles[i].countLength = state.bundles[i].countLengths[isChroma ? 1 : 0];
 
-		readBundle(video, (Source) i);
+		readBundle(video, state, (Source) i);
 	}
 
 	for (ctx.blockY = 0; ctx.blockY < blockHeight; ctx.blockY++) {
-		readBlockTypes              (video, _bundles[kSourceBlockTypes]);
-		readBlockTypes              (video, _bundles[kSourceSubBlockTypes]);
-		readColors                  (video, _bundles[kSourceColors]);
-		readPatterns                (video, _bundles[kSourcePattern]);
-		readMotionValues            (video, _bundles[kSourceXOff]);
-		readMotionValues            (video, _bundles[kSourceYOff]);
-		readDCS<kDCStartBits, false>(video, _bundles[kSourceIntraDC]);
-		readDCS<kDCStartBits, true> (video, _bundles[kSourceInterDC]);
-		readRuns                    (video, _bundles[kSourceRun]);
+		readBlockTypes              (video, state.bundles[kSourceBlockTypes]);
+		readBlockTypes              (video, state.bundles[kSourceSubBlockTypes]);
+		readColors                  (video, state);
+		readPatterns                (video, state.bundles[kSourcePattern]);
+		readMotionValues            (video, state.bundles[kSourceXOff]);
+		readMotionValues            (video, state.bundles[kSourceYOff]);
+		readDCS<kDCStartBits, false>(video, state.bundles[kSourceIntraDC]);
+		readDCS<kDCStartBits, true> (video, state.bundles[kSourceInterDC]);
+		readRuns                    (video, state.bundles[kSourceRun]);
+
+		if (video.invalid)
+			return;
 
 		ctx.dest = ctx.destStart + 8 * ctx.blockY * ctx.pitch;
 		ctx.prev = ctx.prevStart + 8 * ctx.blockY * ctx.pitch;
 
 		for (ctx.blockX = 0; ctx.blockX < blockWidth; ctx.blockX++, ctx.dest += 8, ctx.prev += 8) {
-			BlockType blockType = (BlockType) getBundleValue(kSourceBlockTypes);
+			BlockType blockType = (BlockType) state.getBundleValue(kSourceBlockTypes);
 
 			// 16x16 block type on odd line means part of the already decoded block, so skip it
 			if ((ctx.blockY & 1) && (blockType == kBlockScaled)) {
@@ -586,9 +652,11 @@ void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, b
 				blockRaw(ctx);
 				break;
 			default:
-				error("Unknown block type: %d", blockType);
+				invalidData(video, "Unknown block type: %d", blockType);
 			}
 
+			if (video.invalid)
+				return;
 		}
 
 	}
@@ -598,19 +666,83 @@ void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, b
 
 }
 
-void BinkDecoder::BinkVideoTrack::readBundle(VideoFrame &video, Source source) {
+void BinkDecoder::BinkVideoTrack::decodeChromaPlanes(VideoFrame &video, PlaneState &state) {
+	for (int i = 1; i < 3; i++) {
+		int planeIdx = !_swapPlanes ? i : (i ^ 3);
+
+		decodePlane(video, state, planeIdx, true);
+
+		if (video.invalid || video.bits->pos() >= video.bits->size())
+			break;
+	}
+}
+
+bool BinkDecoder::BinkVideoTrack::startChromaWorker() {
+	if (Common::WorkerPool::getDefaultThreadCount() < 2) {
+		_chromaOffset = kChromaOffsetNone;
+		return false;
+	}
+
+	_pool = new Common::WorkerPool(2);
+	if (_pool->getThreadCount() == 0) {
+		delete _pool;
+		_pool = nullptr;
+		_chromaOffset = kChromaOffsetNone;
+		return false;
+	}
+
+	_chromaState = new PlaneState();
+	initBundles(*_chromaState);
+	return true;
+}
+
+void BinkDecoder::BinkVideoTrack::invalidData(VideoFrame &video, const char *s, ...) {
+	if (video.speculative) {
+		video.invalid = true;
+		return;
+	}
+
+	va_list va;
+	va_start(va, s);
+	Common::String message = Common::String::vformat(s, va);
+	va_end(va);
+
+	error("%s", message.c_str());
+}
+
+void BinkDecoder::BinkVideoTrack::checkChromaOffset(uint32 planeOffset, uint32 fieldEnd, uint32 lumaEnd) {
+	if (_chromaOffset == kChromaOffsetNone)
+		return;
+
+	ChromaOffset seen = kChromaOffsetNone;
+	if (planeOffset * 8 == lumaEnd)
+		seen = kChromaOffsetFromPacket;
+	else if (fieldEnd + planeOffset * 8 == lumaEnd)
+		seen = kChromaOffsetFromField;
+
+	if (_chromaOffset == kChromaOffsetUnknown) {
+		// Wait for a second frame to agree, to not trust a coincidence
+		if (seen == kChromaOffsetNone || seen == _chromaOffsetSeen)
+			_chromaOffset = seen;
+		_chromaOffsetSeen = seen;
+	} else if (seen != _chromaOffset) {
+		_chromaOffset = kChromaOffsetNone;
+	}
+}
+
+void BinkDecoder::BinkVideoTrack::readBundle(VideoFrame &video, PlaneState &state, Source source) {
 	if (source == kSourceColors) {
 		for (int i = 0; i < 16; i++)
-			readHuffman(video, _colHighHuffman[i]);
+			readHuffman(video, state.colHighHuffman[i]);
 
-		_colLastVal = 0;
+		state.colLastVal = 0;
 	}
 
 	if ((source != kSourceIntraDC) && (source != kSourceInterDC))
-		readHuffman(video, _bundles[source].huffman);
+		readHuffman(video, state.bundles[source].huffman);
 
-	_bundles[source].curDec = _bundles[source].data;
-	_bundles[source].curPtr = _bundles[source].data;
+	state.bundles[source].curDec = state.bundles[source].data;
+	state.bundles[source].curPtr = state.bundles[source].data;
 }
 
 void BinkDecoder::BinkVideoTrack::readHuffman(VideoFrame &video, Huffman &huffman) {
@@ -687,14 +819,14 @@ void BinkDecoder::BinkVideoTrack::mergeHuffmanSymbols(VideoFrame &video, byte *d
 		*dst++ = *src2++;
 }
 
-void BinkDecoder::BinkVideoTrack::initBundles() {
+void BinkDecoder::BinkVideoTrack::initBundles(PlaneState &state) {
 	uint32 bw     = (_width + 7) >> 3;
 	uint32 bh     = (_height + 7) >> 3;
 	uint32 blocks = bw * bh;
 
 	for (int i = 0; i < kSourceMAX; i++) {
-		_bundles[i].data    = new byte[blocks * 64];
-		_bundles[i].dataEnd = _bundles[i].data + blocks * 64;
+		state.bundles[i].data    = new byte[blocks * 64];
+		state.bundles[i].dataEnd = state.bundles[i].data + blocks * 64;
 	}
 
 	uint32 cbw[2] = { (uint32)((_width + 7) >> 3), (uint32)((_width  + 15) >> 4) };
@@ -704,21 +836,21 @@ void BinkDecoder::BinkVideoTrack::initBundles() {
 	for (int i = 0; i < 2; i++) {
 		int width = MAX<uint32>(cw[i], 8);
 
-		_bundles[kSourceBlockTypes   ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourceSubBlockTypes].countLengths[i] = Common::intLog2(((width + 7) >> 4) + 511) + 1;
-		_bundles[kSourceColors       ].countLengths[i] = Common::intLog2((cbw[i])     * 64  + 511) + 1;
-		_bundles[kSourceIntraDC      ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourceInterDC      ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourceXOff         ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourceYOff         ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourcePattern      ].countLengths[i] = Common::intLog2((cbw[i]      << 3) + 511) + 1;
-		_bundles[kSourceRun          ].countLengths[i] = Common::intLog2((cbw[i])     * 48  + 511) + 1;
+		state.bundles[kSourceBlockTypes   ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+		state.bundles[kSourceSubBlockTypes].countLengths[i] = Common::intLog2(((width + 7) >> 4) + 511) + 1;
+		state.bundles[kSourceColors       ].countLengths[i] = Common::intLog2((cbw[i])     * 64  + 511) + 1;
+		state.bundles[kSourceIntraDC      ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+		state.bundles[kSourceInterDC      ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+		state.bundles[kSourceXOff         ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+		state.bundles[kSourceYOff         ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+		state.bundles[kSourcePattern      ].countLengths[i] = Common::intLog2((cbw[i]      << 3) + 511) + 1;
+		state.bundles[kSourceRun          ].countLengths[i] = Common::intLog2((cbw[i])     * 48  + 511) + 1;
 	}
 }
 
-void BinkDecoder::BinkVideoTrack::deinitBundles() {
+void BinkDecoder::BinkVideoTrack::deinitBundles(PlaneState &state) {
 	for (int i = 0; i < kSourceMAX; i++)
-		delete[] _bundles[i].data;
+		delete[] state.bundles[i].data;
 }
 
 void BinkDecoder::BinkVideoTrack::initHuffman() {
@@ -730,16 +862,41 @@ byte BinkDecoder::BinkVideoTrack::getHuffmanSymbol(VideoFrame &video, Huffman &h
 	return huffman.symbols[_huffman[huffman.index]->getSymbol(*video.bits)];
 }
 
-int32 BinkDecoder::BinkVideoTrack::getBundleValue(Source source) {
+BinkDecoder::BinkVideoTrack::PlaneState::PlaneState() {
+	for (int i = 0; i < kSourceMAX; i++) {
+		bundles[i].countLengths[0] = 0;
+		bundles[i].countLengths[1] = 0;
+		bundles[i].countLength = 0;
+
+		bundles[i].huffman.index = 0;
+		for (int j = 0; j < 16; j++)
+			bundles[i].huffman.symbols[j] = j;
+
+		bundles[i].data     = 0;
+		bundles[i].dataEnd  = 0;
+		bundles[i].curDec   = 0;
+		bundles[i].curPtr   = 0;
+	}
+
+	for (int i = 0; i < 16; i++) {
+		colHighHuffman[i].index = 0;
+		for (int j = 0; j < 16; j++)
+			colHighHuffman[i].symbols[j] = j;
+	}
+
+	colLastVal = 0;
+}
+
+int32 BinkDecoder::BinkVideoTrack::PlaneState::getBundleValue(Source source) {
 	if ((source < kSourceXOff) || (source == kSourceRun))
-		return *_bundles[source].curPtr++;
+		return *bundles[source].curPtr++;
 
 	if ((source == kSourceXOff) || (source == kSourceYOff))
-		return (int8) *_bundles[source].curPtr++;
+		return (int8) *bundles[source].curPtr++;
 
-	int16 ret = *((int16 *) _bundles[source].curPtr);
+	int16 ret = *((int16 *) bundles[source].curPtr);
 
-	_bundles[source].curPtr += 2;
+	bundles[source].curPtr += 2;
 
 	return ret;
 }
@@ -776,15 +933,17 @@ void BinkDecoder::BinkVideoTrack::blockScaledRun(DecodeContext &ctx) {
 
 	int i = 0;
 	do {
-		int run = getBundleValue(kSourceRun) + 1;
+		int run = ctx.state->getBundleValue(kSourceRun) + 1;
 
 		i += run;
-		if (i > 64)
-			error("Run went out of bounds");
+		if (i > 64) {
+			invalidData(*ctx.video, "Run went out of bounds");
+			return;
+		}
 
 		if (ctx.video->bits->getBit()) {
 
-			byte v = getBundleValue(kSourceColors);
+			byte v = ctx.state->getBundleValue(kSourceColors);
 			for (int j = 0; j < run; j++, scan++)
 				ctx.dest[ctx.coordScaledMap1[*scan]] =
 				ctx.dest[ctx.coordScaledMap2[*scan]] =
@@ -796,7 +955,7 @@ void BinkDecoder::BinkVideoTrack::blockScaledRun(DecodeContext &ctx) {
 				ctx.dest[ctx.coordScaledMap1[*scan]] =
 				ctx.dest[ctx.coordScaledMap2[*scan]] =
 				ctx.dest[ctx.coordScaledMap3[*scan]] =
-				ctx.dest[ctx.coordScaledMap4[*scan]] = getBundleValue(kSourceColors);
+				ctx.dest[ctx.coordScaledMap4[*scan]] = ctx.state->getBundleValue(kSourceColors);
 
 	} while (i < 63);
 
@@ -804,32 +963,24 @@ void BinkDecoder::BinkVideoTrack::blockScaledRun(DecodeContext &ctx) {
 		ctx.dest[ctx.coordScaledMap1[*scan]] =
 		ctx.dest[ctx.coordScaledMap2[*scan]] =
 		ctx.dest[ctx.coordScaledMap3[*scan]] =
-		ctx.dest[ctx.coordScaledMap4[*scan]] = getBundleValue(kSourceColors);
+		ctx.dest[ctx.coordScaledMap4[*scan]] = ctx.state->getBundleValue(kSourceColors);
 }
 
 void BinkDecoder::BinkVideoTrack::blockScaledIntra(DecodeContext &ctx) {
 	int32 block[64];
 	memset(block, 0, 64 * sizeof(int32));
 
-	block[0] = getBundleValue(kSourceIntraDC);
+	block[0] = ctx.state->getBundleValue(kSourceIntraDC);
 
 	readDCTCoeffs(*ctx.video, block, true);
 
-	IDCT(block);
-
-	int32 *src   = block;
-	byte  *dest1 = ctx.dest;
-	byte  *dest2 = ctx.dest + ctx.pitch;
-	for (int j = 0; j < 8; j++, dest1 += (ctx.pitch << 1) - 16, dest2 += (ctx.pitch << 1) - 16, src += 8) {
-
-		for (int i = 0; i < 8; i++, dest1 += 2, dest2 += 2)
-			dest1[0] = dest1[1] = dest2[0] = dest2[1] = src[i];
-
-	}
+	byte pixels[64];
+	ctx.kernels->idctPut(pixels, 8, block);
+	ctx.kernels->putScaled(ctx.dest, ctx.pitch, pixels);
 }
 
 void BinkDecoder::BinkVideoTrack::blockScaledFill(DecodeContext &ctx) {
-	byte v = getBundleValue(kSourceColors);
+	byte v = ctx.state->getBundleValue(kSourceColors);
 
 	byte *dest = ctx.dest;
 	for (int i = 0; i < 16; i++, dest += ctx.pitch)
@@ -840,35 +991,25 @@ void BinkDecoder::BinkVideoTrack::blockScaledPattern(DecodeContext &ctx) {
 	byte col[2];
 
 	for (int i = 0; i < 2; i++)
-		col[i] = getBundleValue(kSourceColors);
+		col[i] = ctx.state->getBundleValue(kSourceColors);
 
-	byte *dest1 = ctx.dest;
-	byte *dest2 = ctx.dest + ctx.pitch;
-	for (int j = 0; j < 8; j++, dest1 += (ctx.pitch << 1) - 16, dest2 += (ctx.pitch << 1) - 16) {
-		byte v = getBundleValue(kSourcePattern);
+	Bundle &pattern = ctx.state->bundles[kSourcePattern];
 
-		for (int i = 0; i < 8; i++, dest1 += 2, dest2 += 2, v >>= 1)
-			dest1[0] = dest1[1] = dest2[0] = dest2[1] = col[v & 1];
-	}
+	byte pixels[64];
+	ctx.kernels->putPattern(pixels, 8, col[0], col[1], pattern.curPtr);
+	ctx.kernels->putScaled(ctx.dest, ctx.pitch, pixels);
+
+	pattern.curPtr += 8;
 }
 
 void BinkDecoder::BinkVideoTrack::blockScaledRaw(DecodeContext &ctx) {
-	byte row[8];
-
-	byte *dest1 = ctx.dest;
-	byte *dest2 = ctx.dest + ctx.pitch;
-	for (int j = 0; j < 8; j++, dest1 += (ctx.pitch << 1) - 16, dest2 += (ctx.pitch << 1) - 16) {
-		memcpy(row, _bundles[kSourceColors].curPtr, 8);
-
-		for (int i = 0; i < 8; i++, dest1 += 2, dest2 += 2)
-			dest1[0] = dest1[1] = dest2[0] = dest2[1] = row[i];
+	ctx.kernels->putScaled(ctx.dest, ctx.pitch, ctx.state->bundles[kSourceColors].curPtr);
 
-		_bundles[kSourceColors].curPtr += 8;
-	}
+	ctx.state->bundles[kSourceColors].curPtr += 64;
 }
 
 void BinkDecoder::BinkVideoTrack::blockScaled(DecodeContext &ctx) {
-	BlockType blockType = (BlockType) getBundleValue(kSourceSubBlockTypes);
+	BlockType blockType = (BlockType) ctx.state->getBundleValue(kSourceSubBlockTypes);
 
 	switch (blockType) {
 	case kBlockRun:
@@ -887,7 +1028,8 @@ void BinkDecoder::BinkVideoTrack::blockScaled(DecodeContext &ctx) {
 		blockScaledRaw(ctx);
 		break;
 	default:
-		error("Invalid 16x16 block type: %d", blockType);
+		invalidData(*ctx.video, "Invalid 16x16 block type: %d", blockType);
+		return;
 	}
 
 	ctx.blockX += 1;
@@ -896,13 +1038,15 @@ void BinkDecoder::BinkVideoTrack::blockScaled(DecodeContext &ctx) {
 }
 
 void BinkDecoder::BinkVideoTrack::blockMotion(DecodeContext &ctx) {
-	int8 xOff = getBundleValue(kSourceXOff);
-	int8 yOff = getBundleValue(kSourceYOff);
+	int8 xOff = ctx.state->getBundleValue(kSourceXOff);
+	int8 yOff = ctx.state->getBundleValue(kSourceYOff);
 
 	byte *dest = ctx.dest;
 	byte *prev = ctx.prev + yOff * ((int32) ctx.pitch) + xOff;
-	if ((prev < ctx.prevStart) || (prev > ctx.prevEnd))
-		error("Copy out of bounds (%d | %d)", ctx.blockX * 8 + xOff, ctx.blockY * 8 + yOff);
+	if ((prev < ctx.prevStart) || (prev > ctx.prevEnd)) {
+		invalidData(*ctx.video, "Copy out of bounds (%d | %d)", ctx.blockX * 8 + xOff, ctx.blockY * 8 + yOff);
+		return;
+	}
 
 	for (int j = 0; j < 8; j++, dest += ctx.pitch, prev += ctx.pitch)
 		memcpy(dest, prev, 8);
@@ -913,26 +1057,28 @@ void BinkDecoder::BinkVideoTrack::blockRun(DecodeContext &ctx) {
 
 	int i = 0;
 	do {
-		int run = getBundleValue(kSourceRun) + 1;
+		int run = ctx.state->getBundleValue(kSourceRun) + 1;
 
 		i += run;
-		if (i > 64)
-			error("Run went out of bounds");
+		if (i > 64) {
+			invalidData(*ctx.video, "Run went out of bounds");
+			return;
+		}
 
 		if (ctx.video->bits->getBit()) {
 
-			byte v = getBundleValue(kSourceColors);
+			byte v = ctx.state->getBundleValue(kSourceColors);
 			for (int j = 0; j < run; j++)
 				ctx.dest[ctx.coordMap[*scan++]] = v;
 
 		} else
 			for (int j = 0; j < run; j++)
-				ctx.dest[ctx.coordMap[*scan++]] = getBundleValue(kSourceColors);
+				ctx.dest[ctx.coordMap[*scan++]] = ctx.state->getBundleValue(kSourceColors);
 
 	} while (i < 63);
 
 	if (i == 63)
-		ctx.dest[ctx.coordMap[*scan++]] = getBundleValue(kSourceColors);
+		ctx.dest[ctx.coordMap[*scan++]] = ctx.state->getBundleValue(kSourceColors);
 }
 
 void BinkDecoder::BinkVideoTrack::blockResidue(DecodeContext &ctx) {
@@ -945,26 +1091,22 @@ void BinkDecoder::BinkVideoTrack::blockResidue(DecodeContext &ctx) {
 
 	readResidue(*ctx.video, block, v);
 
-	byte  *dst = ctx.dest;
-	int16 *src = block;
-	for (int i = 0; i < 8; i++, dst += ctx.pitch, src += 8)
-		for (int j = 0; j < 8; j++)
-			dst[j] += src[j];
+	ctx.kernels->addResidue(ctx.dest, ctx.pitch, block);
 }
 
 void BinkDecoder::BinkVideoTrack::blockIntra(DecodeContext &ctx) {
 	int32 block[64];
 	memset(block, 0, 64 * sizeof(int32));
 
-	block[0] = getBundleValue(kSourceIntraDC);
+	block[0] = ctx.state->getBundleValue(kSourceIntraDC);
 
 	readDCTCoeffs(*ctx.video, block, true);
 
-	IDCTPut(ctx, block);
+	ctx.kernels->idctPut(ctx.dest, ctx.pitch, block);
 }
 
 void BinkDecoder::BinkVideoTrack::blockFill(DecodeContext &ctx) {
-	byte v = getBundleValue(kSourceColors);
+	byte v = ctx.state->getBundleValue(kSourceColors);
 
 	byte *dest = ctx.dest;
 	for (int i = 0; i < 8; i++, dest += ctx.pitch)
@@ -977,35 +1119,32 @@ void BinkDecoder::BinkVideoTrack::blockInter(DecodeContext &ctx) {
 	int32 block[64];
 	memset(block, 0, 64 * sizeof(int32));
 
-	block[0] = getBundleValue(kSourceInterDC);
+	block[0] = ctx.state->getBundleValue(kSourceInterDC);
 
 	readDCTCoeffs(*ctx.video, block, false);
 
-	IDCTAdd(ctx, block);
+	ctx.kernels->idctAdd(ctx.dest, ctx.pitch, block);
 }
 
 void BinkDecoder::BinkVideoTrack::blockPattern(DecodeContext &ctx) {
 	byte col[2];
 
 	for (int i = 0; i < 2; i++)
-		col[i] = getBundleValue(kSourceColors);
+		col[i] = ctx.state->getBundleValue(kSourceColors);
 
-	byte *dest = ctx.dest;
-	for (int i = 0; i < 8; i++, dest += ctx.pitch - 8) {
-		byte v = getBundleValue(kSourcePattern);
+	Bundle &pattern = ctx.state->bundles[kSourcePattern];
+	ctx.kernels->putPattern(ctx.dest, ctx.pitch, col[0], col[1], pattern.curPtr);
 
-		for (int j = 0; j < 8; j++, v >>= 1)
-			*dest++ = col[v & 1];
-	}
+	pattern.curPtr += 8;
 }
 
 void BinkDecoder::BinkVideoTrack::blockRaw(DecodeContext &ctx) {
 	byte *dest = ctx.dest;
-	byte *data = _bundles[kSourceColors].curPtr;
+	byte *data = ctx.state->bundles[kSourceColors].curPtr;
 	for (int i = 0; i < 8; i++, dest += ctx.pitch, data += 8)
 		memcpy(dest, data, 8);
 
-	_bundles[kSourceColors].curPtr += 64;
+	ctx.state->bundles[kSourceColors].curPtr += 64;
 }
 
 void BinkDecoder::BinkVideoTrack::readRuns(VideoFrame &video, Bundle &bundle) {
@@ -1014,8 +1153,10 @@ void BinkDecoder::BinkVideoTrack::readRuns(VideoFrame &video, Bundle &bundle) {
 		return;
 
 	byte *decEnd = bundle.curDec + n;
-	if (decEnd > bundle.dataEnd)
-		error("Run value went out of bounds");
+	if (decEnd > bundle.dataEnd) {
+		invalidData(video, "Run value went out of bounds");
+		return;
+	}
 
 	if (video.bits->getBit()) {
 		byte v = video.bits->getBits<4>();
@@ -1034,8 +1175,10 @@ void BinkDecoder::BinkVideoTrack::readMotionValues(VideoFrame &video, Bundle &bu
 		return;
 
 	byte *decEnd = bundle.curDec + n;
-	if (decEnd > bundle.dataEnd)
-		error("Too many motion values");
+	if (decEnd > bundle.dataEnd) {
+		invalidData(video, "Too many motion values");
+		return;
+	}
 
 	if (video.bits->getBit()) {
 		byte v = video.bits->getBits<4>();
@@ -1071,8 +1214,10 @@ void BinkDecoder::BinkVideoTrack::readBlockTypes(VideoFrame &video, Bundle &bund
 		return;
 
 	byte *decEnd = bundle.curDec + n;
-	if (decEnd > bundle.dataEnd)
-		error("Too many block type values");
+	if (decEnd > bundle.dataEnd) {
+		invalidData(video, "Too many block type values");
+		return;
+	}
 
 	if (video.bits->getBit()) {
 		byte v = video.bits->getBits<4>();
@@ -1108,8 +1253,10 @@ void BinkDecoder::BinkVideoTrack::readPatterns(VideoFrame &video, Bundle &bundle
 		return;
 
 	byte *decEnd = bundle.curDec + n;
-	if (decEnd > bundle.dataEnd)
-		error("Too many pattern values");
+	if (decEnd > bundle.dataEnd) {
+		invalidData(video, "Too many pattern values");
+		return;
+	}
 
 	byte v;
 	while (bundle.curDec < decEnd) {
@@ -1120,21 +1267,25 @@ void BinkDecoder::BinkVideoTrack::readPatterns(VideoFrame &video, Bundle &bundle
 }
 
 
-void BinkDecoder::BinkVideoTrack::readColors(VideoFrame &video, Bundle &bundle) {
+void BinkDecoder::BinkVideoTrack::readColors(VideoFrame &video, PlaneState &state) {
+	Bundle &bundle = state.bundles[kSourceColors];
+
 	uint32 n = readBundleCount(video, bundle);
 	if (n == 0)
 		return;
 
 	byte *decEnd = bundle.curDec + n;
-	if (decEnd > bundle.dataEnd)
-		error("Too many color values");
+	if (decEnd > bundle.dataEnd) {
+		invalidData(video, "Too many color values");
+		return;
+	}
 
 	if (video.bits->getBit()) {
-		_colLastVal = getHuffmanSymbol(video, _colHighHuffman[_colLastVal]);
+		state.colLastVal = getHuffmanSymbol(video, state.colHighHuffman[state.colLastVal]);
 
 		byte v;
 		v = getHuffmanSymbol(video, bundle.huffman);
-		v = (_colLastVal << 4) | v;
+		v = (state.colLastVal << 4) | v;
 
 		if (_id != kBIKiID) {
 			int sign = ((int8) v) >> 7;
@@ -1149,11 +1300,11 @@ void BinkDecoder::BinkVideoTrack::readColors(VideoFrame &video, Bundle &bundle)
 	}
 
 	while (bundle.curDec < decEnd) {
-		_colLastVal = getHuffmanSymbol(video, _colHighHuffman[_colLastVal]);
+		state.colLastVal = getHuffmanSymbol(video, state.colHighHuffman[state.colLastVal]);
 
 		byte v;
 		v = getHuffmanSymbol(video, bundle.huffman);
-		v = (_colLastVal << 4) | v;
+		v = (state.colLastVal << 4) | v;
 
 		if (_id != kBIKiID) {
 			int sign = ((int8) v) >> 7;
@@ -1198,8 +1349,10 @@ void BinkDecoder::BinkVideoTrack::readDCS(VideoFrame &video, Bundle &bundle) {
 				v += v2;
 				*dest++ = v;
 
-				if ((v < -32768) || (v > 32767))
-					error("DC value went out of bounds: %d", v);
+				if ((v < -32768) || (v > 32767)) {
+					invalidData(video, "DC value went out of bounds: %d", v);
+					return;
+				}
 			}
 
 		} else
@@ -1410,88 +1563,6 @@ void BinkDecoder::BinkVideoTrack::readResidue(VideoFrame &video, int16 *block, i
 	}
 }
 
-#define A1  2896 /* (1/sqrt(2))<<12 */
-#define A2  2217
-#define A3  3784
-#define A4 -5352
-
-#define IDCT_TRANSFORM(dest,s0,s1,s2,s3,s4,s5,s6,s7,d0,d1,d2,d3,d4,d5,d6,d7,munge,src) {\
-	const int a0 = (src)[s0] + (src)[s4]; \
-	const int a1 = (src)[s0] - (src)[s4]; \
-	const int a2 = (src)[s2] + (src)[s6]; \
-	const int a3 = (A1*((src)[s2] - (src)[s6])) >> 11; \
-	const int a4 = (src)[s5] + (src)[s3]; \
-	const int a5 = (src)[s5] - (src)[s3]; \
-	const int a6 = (src)[s1] + (src)[s7]; \
-	const int a7 = (src)[s1] - (src)[s7]; \
-	const int b0 = a4 + a6; \
-	const int b1 = (A3*(a5 + a7)) >> 11; \
-	const int b2 = ((A4*a5) >> 11) - b0 + b1; \
-	const int b3 = (A1*(a6 - a4) >> 11) - b2; \
-	const int b4 = ((A2*a7) >> 11) + b3 - b1; \
-	(dest)[d0] = munge(a0+a2   +b0); \
-	(dest)[d1] = munge(a1+a3-a2+b2); \
-	(dest)[d2] = munge(a1-a3+a2+b3); \
-	(dest)[d3] = munge(a0-a2   -b4); \
-	(dest)[d4] = munge(a0-a2   +b4); \
-	(dest)[d5] = munge(a1-a3+a2-b3); \
-	(dest)[d6] = munge(a1+a3-a2-b2); \
-	(dest)[d7] = munge(a0+a2   -b0); \
-}
-/* end IDCT_TRANSFORM macro */
-
-#define MUNGE_NONE(x) (x)
-#define IDCT_COL(dest,src) IDCT_TRANSFORM(dest,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,MUNGE_NONE,src)
-
-#define MUNGE_ROW(x) (((x) + 0x7F)>>8)
-#define IDCT_ROW(dest,src) IDCT_TRANSFORM(dest,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,MUNGE_ROW,src)
-
-static inline void IDCTCol(int32 *dest, const int32 *src) {
-	if ((src[8] | src[16] | src[24] | src[32] | src[40] | src[48] | src[56]) == 0) {
-		dest[ 0] =
-		dest[ 8] =
-		dest[16] =
-		dest[24] =
-		dest[32] =
-		dest[40] =
-		dest[48] =
-		dest[56] = src[0];
-	} else {
-		IDCT_COL(dest, src);
-	}
-}
-
-void BinkDecoder::BinkVideoTrack::IDCT(int32 *block) {
-	int i;
-	int32 temp[64];
-
-	for (i = 0; i < 8; i++)
-		IDCTCol(&temp[i], &block[i]);
-	for (i = 0; i < 8; i++) {
-		IDCT_ROW( (&block[8*i]), (&temp[8*i]) );
-	}
-}
-
-void BinkDecoder::BinkVideoTrack::IDCTAdd(DecodeContext &ctx, int32 *block) {
-	int i, j;
-
-	IDCT(block);
-	byte *dest = ctx.dest;
-	for (i = 0; i < 8; i++, dest += ctx.pitch, block += 8)
-		for (j = 0; j < 8; j++)
-			 dest[j] += block[j];
-}
-
-void BinkDecoder::BinkVideoTrack::IDCTPut(DecodeContext &ctx, int32 *block) {
-	int i;
-	int32 temp[64];
-	for (i = 0; i < 8; i++)
-		IDCTCol(&temp[i], &block[i]);
-	for (i = 0; i < 8; i++) {
-		IDCT_ROW( (&ctx.dest[i*ctx.pitch]), (&temp[8*i]) );
-	}
-}
-
 BinkDecoder::BinkAudioTrack::BinkAudioTrack(BinkDecoder::AudioInfo &audio, Audio::Mixer::SoundType soundType) :
 		AudioTrack(soundType),
 		_audioInfo(&audio) {
@@ -34,6 +34,7 @@
 #include "common/bitstream.h"
 #include "common/rational.h"
 
+#include "video/bink_kernels.h"
 #include "video/video_decoder.h"
 
 #include "graphics/surface.h"
@@ -45,6 +46,7 @@ class QueuingAudioStream;
 
 namespace Common {
 class SeekableReadStream;
+class WorkerPool;
 template <class BITSTREAM>
 class Huffman;
 }
@@ -79,6 +81,7 @@ public:
 protected:
 	void readNextPacket();
 	bool supportsAudioTrackSwitching() const { return true; }
+	bool supportsDecodeAhead() const { return true; }
 	AudioTrack *getAudioTrack(int index);
 	bool seekIntern(const Audio::Timestamp &time);
 	uint32 findKeyFrame(uint32 frame) const;
@@ -140,6 +143,13 @@ private:
 		uint32 size;
 
 		Common::BitStream32LELSB *bits;
+		/** The data of the video packet read by bits, while it is decoded. */
+		const byte *data;
+
+		/** Whether this is a guess, which may be invalid data rather than a plane. */
+		bool speculative;
+		/** Whether the speculative decoding hit invalid data, and stopped. */
+		bool invalid;
 
 		VideoFrame();
 		~VideoFrame();
@@ -174,9 +184,14 @@ private:
 		Common::Rational getFrameRate() const override { return _frameRate; }
 
 	private:
+		struct PlaneState;
+		class ChromaJob;
+
 		/** A decoder state. */
 		struct DecodeContext {
 			VideoFrame *video;
+			PlaneState *state;
+			const BinkKernels::Table *kernels;
 
 			uint32 planeIdx;
 
@@ -247,6 +262,29 @@ private:
 			byte *curPtr; ///< Pointer to the data that wasn't yet read.
 		};
 
+		/** The state of the decoding of a plane, so that planes can be decoded in parallel. */
+		struct PlaneState {
+			Bundle bundles[kSourceMAX]; ///< Bundles for decoding all data types.
+
+			/** Huffman codebooks to use for decoding high nibbles in color data types. */
+			Huffman colHighHuffman[16];
+			/** Value of the last decoded high nibble in color data types. */
+			int colLastVal;
+
+			PlaneState();
+
+			/** Get a direct value out of a bundle. */
+			int32 getBundleValue(Source source);
+		};
+
+		/** Where the plane offset of BIKi frames points to. */
+		enum ChromaOffset {
+			kChromaOffsetUnknown,     ///< Not checked yet.
+			kChromaOffsetFromPacket,  ///< Bytes from the start of the packet to the chroma planes.
+			kChromaOffsetFromField,   ///< Bytes from the end of the offset to the chroma planes.
+			kChromaOffsetNone         ///< Not to the chroma planes, which are decoded after the luma plane.
+		};
+
 		int _curFrame;
 		int _frameCount;
 
@@ -264,14 +302,15 @@ private:
 
 		Common::Rational _frameRate;
 
-		Bundle _bundles[kSourceMAX]; ///< Bundles for decoding all data types.
+		PlaneState _planeState; ///< State for decoding the planes on the decoding thread.
 
 		Common::Huffman<Common::BitStream32LELSB> *_huffman[16]; ///< The 16 Huffman codebooks used in Bink decoding.
 
-		/** Huffman codebooks to use for decoding high nibbles in color data types. */
-		Huffman _colHighHuffman[16];
-		/** Value of the last decoded high nibble in color data types. */
-		int _colLastVal;
+		PlaneState *_chromaState;       ///< State for decoding the chroma planes on a worker thread.
+		Common::WorkerPool *_pool;      ///< The worker thread decoding the chroma planes.
+		ChromaOffset _chromaOffset;     ///< Whether the chroma planes can be found before decoding the luma plane.
+		ChromaOffset _chromaOffsetSeen; ///< The meaning of the plane offset in the previous frame, while it is checked.
+		bool _chromaInvalid;            ///< Whether the worker thread hit invalid data decoding the chroma planes.
 
 		uint32 _yBlockWidth;   ///< Width of the Y plane in blocks
 		uint32 _yBlockHeight;  ///< Height of the Y plane in blocks
@@ -282,18 +321,34 @@ private:
 		byte *_oldPlanes[4]; ///< The 4 color planes, YUVA, last frame.
 
 		/** Initialize the bundles. */
-		void initBundles();
+		void initBundles(PlaneState &state);
 		/** Deinitialize the bundles. */
-		void deinitBundles();
+		void deinitBundles(PlaneState &state);
 
 		/** Initialize the Huffman decoders. */
 		void initHuffman();
 
 		/** Decode a plane. */
-		void decodePlane(VideoFrame &video, int planeIdx, bool isChroma);
+		void decodePlane(VideoFrame &video, PlaneState &state, int planeIdx, bool isChroma);
+		/** Decode the two chroma planes, which follow the luma plane. */
+		void decodeChromaPlanes(VideoFrame &video, PlaneState &state);
+
+		/**
+		 * Check where the plane offset of a BIKi frame points to, once the
+		 * end of the luma plane is known. The chroma planes are decoded in
+		 * parallel with the luma plane once two frames agree.
+		 */
+		void checkChromaOffset(uint32 planeOffset, uint32 fieldEnd, uint32 lumaEnd);
+		/** Create the worker thread decoding the chroma planes, if the system has more than one core. */
+		bool startChromaWorker();
+		/**
+		 * Report invalid data in a plane. This is fatal, unless the plane is
+		 * decoded speculatively, where decoding stops and the result is dropped.
+		 */
+		static void invalidData(VideoFrame &video, const char *s, ...) GCC_PRINTF(2, 3);
 
 		/** Read/Initialize a bundle for decoding a plane. */
-		void readBundle(VideoFrame &video, Source source);
+		void readBundle(VideoFrame &video, PlaneState &state, Source source);
 
 		/** Read the symbols for a Huffman code. */
 		void readHuffman(VideoFrame &video, Huffman &huffman);
@@ -303,8 +358,6 @@ private:
 		/** Read and translate a symbol out of a Huffman code. */
 		byte getHuffmanSymbol(VideoFrame &video, Huffman &huffman);
 
-		/** Get a direct value out of a bundle. */
-		int32 getBundleValue(Source source);
 		/** Read a count value out of a bundle. */
 		uint32 readBundleCount(VideoFrame &video, Bundle &bundle);
 
@@ -331,16 +384,11 @@ private:
 		void readMotionValues(VideoFrame &video, Bundle &bundle);
 		void readBlockTypes  (VideoFrame &video, Bundle &bundle);
 		void readPatterns    (VideoFrame &video, Bundle &bundle);
-		void readColors      (VideoFrame &video, Bundle &bundle);
+		void readColors      (VideoFrame &video, PlaneState &state);
 		template<int startBits, bool hasSign>
 		void readDCS         (VideoFrame &video, Bundle &bundle);
 		void readDCTCoeffs   (VideoFrame &video, int32 *block, bool isIntra);
 		void readResidue     (VideoFrame &video, int16 *block, int masksCount);
-
-		// Bink video IDCT
-		void IDCT(int32 *block);
-		void IDCTPut(DecodeContext &ctx, int32 *block);
-		void IDCTAdd(DecodeContext &ctx, int32 *block);
 	};
 
 	class BinkAudioTrack : public AudioTrack {
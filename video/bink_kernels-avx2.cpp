@@ -0,0 +1,200 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "video/bink_kernels.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace Video {
+
+class BinkKernelsImpl_AVX2 {
+public:
+
+/** Returns (k * a) >> 11, like the IDCT of the generic kernels. */
+static inline __m256i scale(__m256i a, int k) {
+	return _mm256_srai_epi32(_mm256_mullo_epi32(a, _mm256_set1_epi32(k)), 11);
+}
+
+/** The IDCT of 8 columns or rows, with s[i] holding their i-th coefficients. */
+static inline void transform(const __m256i *s, __m256i *d) {
+	const __m256i a0 = _mm256_add_epi32(s[0], s[4]);
+	const __m256i a1 = _mm256_sub_epi32(s[0], s[4]);
+	const __m256i a2 = _mm256_add_epi32(s[2], s[6]);
+	const __m256i a3 = scale(_mm256_sub_epi32(s[2], s[6]), BinkKernels::kIDCTA1);
+	const __m256i a4 = _mm256_add_epi32(s[5], s[3]);
+	const __m256i a5 = _mm256_sub_epi32(s[5], s[3]);
+	const __m256i a6 = _mm256_add_epi32(s[1], s[7]);
+	const __m256i a7 = _mm256_sub_epi32(s[1], s[7]);
+	const __m256i b0 = _mm256_add_epi32(a4, a6);
+	const __m256i b1 = scale(_mm256_add_epi32(a5, a7), BinkKernels::kIDCTA3);
+	const __m256i b2 = _mm256_add_epi32(_mm256_sub_epi32(scale(a5, BinkKernels::kIDCTA4), b0), b1);
+	const __m256i b3 = _mm256_sub_epi32(scale(_mm256_sub_epi32(a6, a4), BinkKernels::kIDCTA1), b2);
+	const __m256i b4 = _mm256_sub_epi32(_mm256_add_epi32(scale(a7, BinkKernels::kIDCTA2), b3), b1);
+	const __m256i c0 = _mm256_add_epi32(a0, a2);
+	const __m256i c1 = _mm256_sub_epi32(_mm256_add_epi32(a1, a3), a2);
+	const __m256i c2 = _mm256_add_epi32(_mm256_sub_epi32(a1, a3), a2);
+	const __m256i c3 = _mm256_sub_epi32(a0, a2);
+	d[0] = _mm256_add_epi32(c0, b0);
+	d[1] = _mm256_add_epi32(c1, b2);
+	d[2] = _mm256_add_epi32(c2, b3);
+	d[3] = _mm256_sub_epi32(c3, b4);
+	d[4] = _mm256_add_epi32(c3, b4);
+	d[5] = _mm256_sub_epi32(c2, b3);
+	d[6] = _mm256_sub_epi32(c1, b2);
+	d[7] = _mm256_sub_epi32(c0, b0);
+}
+
+static inline void transpose(__m256i *r) {
+	__m256i t[8], u[8];
+
+	for (int i = 0; i < 8; i += 2) {
+		t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+		t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+	}
+
+	for (int i = 0; i < 8; i += 4) {
+		u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+		u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+		u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+		u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+	}
+
+	for (int i = 0; i < 4; i++) {
+		r[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+		r[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+	}
+}
+
+/** Returns the rows of the IDCT of @p block. */
+static inline void idct(const int32 *block, __m256i *rows) {
+	__m256i s[8];
+
+	for (int i = 0; i < 8; i++)
+		s[i] = _mm256_loadu_si256((const __m256i *)(block + i * 8));
+	transform(s, rows);
+	transpose(rows);
+
+	for (int i = 0; i < 8; i++)
+		s[i] = rows[i];
+	transform(s, rows);
+
+	const __m256i round = _mm256_set1_epi32(0x7F);
+	for (int i = 0; i < 8; i++)
+		rows[i] = _mm256_srai_epi32(_mm256_add_epi32(rows[i], round), 8);
+
+	transpose(rows);
+}
+
+/** Returns the low bytes of the 8 values of a row, in the low half. */
+static inline __m128i lowBytes(__m256i row) {
+	row = _mm256_and_si256(row, _mm256_set1_epi32(0xFF));
+	const __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(row), _mm256_extracti128_si256(row, 1));
+	return _mm_packus_epi16(words, words);
+}
+
+static void idctPut(byte *dest, uint32 pitch, const int32 *block) {
+	__m256i rows[8];
+	idct(block, rows);
+
+	for (int i = 0; i < 8; i++, dest += pitch)
+		_mm_storel_epi64((__m128i *)dest, lowBytes(rows[i]));
+}
+
+static void idctAdd(byte *dest, uint32 pitch, const int32 *block) {
+	__m256i rows[8];
+	idct(block, rows);
+
+	for (int i = 0; i < 8; i++, dest += pitch) {
+		const __m128i pixels = _mm_loadl_epi64((const __m128i *)dest);
+		_mm_storel_epi64((__m128i *)dest, _mm_add_epi8(pixels, lowBytes(rows[i])));
+	}
+}
+
+static void addResidue(byte *dest, uint32 pitch, const int16 *block) {
+	const __m128i mask = _mm_set1_epi16(0xFF);
+
+	for (int i = 0; i < 8; i++, dest += pitch, block += 8) {
+		const __m128i residue = _mm_and_si128(_mm_loadu_si128((const __m128i *)block), mask);
+		const __m128i pixels = _mm_loadl_epi64((const __m128i *)dest);
+		_mm_storel_epi64((__m128i *)dest, _mm_add_epi8(pixels, _mm_packus_epi16(residue, residue)));
+	}
+}
+
+static void putPattern(byte *dest, uint32 pitch, byte col0, byte col1, const byte *pattern) {
+	const __m256i bits = _mm256_set1_epi64x(0x8040201008040201LL);
+
+	// Repeat the pattern byte of each row 8 times
+	const __m256i p = _mm256_shuffle_epi8(_mm256_broadcastq_epi64(_mm_loadl_epi64((const __m128i *)pattern)),
+	                                      _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+	                                                       2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3));
+	const __m256i q = _mm256_shuffle_epi8(_mm256_broadcastq_epi64(_mm_loadl_epi64((const __m128i *)pattern)),
+	                                      _mm256_setr_epi8(4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 5, 5, 5, 5,
+	                                                       6, 6, 6, 6, 6, 6, 6, 6, 7, 7, 7, 7, 7, 7, 7, 7));
+	const __m256i rows[2] = { p, q };
+
+	for (int i = 0; i < 2; i++) {
+		const __m256i m = _mm256_cmpeq_epi8(_mm256_and_si256(rows[i], bits), bits);
+		const __m256i v = _mm256_blendv_epi8(_mm256_set1_epi8((char)col0), _mm256_set1_epi8((char)col1), m);
+		const __m128i v0 = _mm256_castsi256_si128(v);
+		const __m128i v1 = _mm256_extracti128_si256(v, 1);
+		_mm_storel_epi64((__m128i *)dest, v0);
+		_mm_storel_epi64((__m128i *)(dest + pitch), _mm_srli_si128(v0, 8));
+		_mm_storel_epi64((__m128i *)(dest + pitch * 2), v1);
+		_mm_storel_epi64((__m128i *)(dest + pitch * 3), _mm_srli_si128(v1, 8));
+		dest += pitch * 4;
+	}
+}
+
+static void putScaled(byte *dest, uint32 pitch, const byte *src) {
+	for (int i = 0; i < 8; i++, dest += pitch * 2, src += 8) {
+		__m128i v = _mm_loadl_epi64((const __m128i *)src);
+		v = _mm_unpacklo_epi8(v, v);
+		_mm_storeu_si128((__m128i *)dest, v);
+		_mm_storeu_si128((__m128i *)(dest + pitch), v);
+	}
+}
+
+}; // End of class BinkKernelsImpl_AVX2
+
+const BinkKernels::Table BinkKernels::avx2 = {
+	BinkKernelsImpl_AVX2::idctPut,
+	BinkKernelsImpl_AVX2::idctAdd,
+	BinkKernelsImpl_AVX2::addResidue,
+	BinkKernelsImpl_AVX2::putPattern,
+	BinkKernelsImpl_AVX2::putScaled
+};
+
+} // End of namespace Video
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,204 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "video/bink_kernels.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace Video {
+
+class BinkKernelsImpl_NEON {
+public:
+
+/** Returns (k * a) >> 11, like the IDCT of the generic kernels. */
+static inline int32x4_t scale(int32x4_t a, int k) {
+	return vshrq_n_s32(vmulq_n_s32(a, k), 11);
+}
+
+/** The IDCT of 4 columns or rows, with s[i] holding their i-th coefficients. */
+static inline void transform(const int32x4_t *s, int32x4_t *d) {
+	const int32x4_t a0 = vaddq_s32(s[0], s[4]);
+	const int32x4_t a1 = vsubq_s32(s[0], s[4]);
+	const int32x4_t a2 = vaddq_s32(s[2], s[6]);
+	const int32x4_t a3 = scale(vsubq_s32(s[2], s[6]), BinkKernels::kIDCTA1);
+	const int32x4_t a4 = vaddq_s32(s[5], s[3]);
+	const int32x4_t a5 = vsubq_s32(s[5], s[3]);
+	const int32x4_t a6 = vaddq_s32(s[1], s[7]);
+	const int32x4_t a7 = vsubq_s32(s[1], s[7]);
+	const int32x4_t b0 = vaddq_s32(a4, a6);
+	const int32x4_t b1 = scale(vaddq_s32(a5, a7), BinkKernels::kIDCTA3);
+	const int32x4_t b2 = vaddq_s32(vsubq_s32(scale(a5, BinkKernels::kIDCTA4), b0), b1);
+	const int32x4_t b3 = vsubq_s32(scale(vsubq_s32(a6, a4), BinkKernels::kIDCTA1), b2);
+	const int32x4_t b4 = vsubq_s32(vaddq_s32(scale(a7, BinkKernels::kIDCTA2), b3), b1);
+	const int32x4_t c0 = vaddq_s32(a0, a2);
+	const int32x4_t c1 = vsubq_s32(vaddq_s32(a1, a3), a2);
+	const int32x4_t c2 = vaddq_s32(vsubq_s32(a1, a3), a2);
+	const int32x4_t c3 = vsubq_s32(a0, a2);
+	d[0] = vaddq_s32(c0, b0);
+	d[1] = vaddq_s32(c1, b2);
+	d[2] = vaddq_s32(c2, b3);
+	d[3] = vsubq_s32(c3, b4);
+	d[4] = vaddq_s32(c3, b4);
+	d[5] = vsubq_s32(c2, b3);
+	d[6] = vsubq_s32(c1, b2);
+	d[7] = vsubq_s32(c0, b0);
+}
+
+static inline void transpose4x4(int32x4_t &r0, int32x4_t &r1, int32x4_t &r2, int32x4_t &r3) {
+	const int32x4x2_t t01 = vtrnq_s32(r0, r1);
+	const int32x4x2_t t23 = vtrnq_s32(r2, r3);
+	r0 = vcombine_s32(vget_low_s32(t01.val[0]), vget_low_s32(t23.val[0]));
+	r1 = vcombine_s32(vget_low_s32(t01.val[1]), vget_low_s32(t23.val[1]));
+	r2 = vcombine_s32(vget_high_s32(t01.val[0]), vget_high_s32(t23.val[0]));
+	r3 = vcombine_s32(vget_high_s32(t01.val[1]), vget_high_s32(t23.val[1]));
+}
+
+/**
+ * Transposes an 8x8 matrix, whose rows are split in their left half
+ * in @p lo and their right half in @p hi.
+ */
+static inline void transpose(int32x4_t *lo, int32x4_t *hi) {
+	transpose4x4(lo[0], lo[1], lo[2], lo[3]);
+	transpose4x4(lo[4], lo[5], lo[6], lo[7]);
+	transpose4x4(hi[0], hi[1], hi[2], hi[3]);
+	transpose4x4(hi[4], hi[5], hi[6], hi[7]);
+
+	for (int i = 0; i < 4; i++) {
+		const int32x4_t t = lo[i + 4];
+		lo[i + 4] = hi[i];
+		hi[i] = t;
+	}
+}
+
+/** Returns the rows of the IDCT of @p block, split like for transpose(). */
+static inline void idct(const int32 *block, int32x4_t *lo, int32x4_t *hi) {
+	int32x4_t s[8];
+
+	for (int i = 0; i < 8; i++)
+		s[i] = vld1q_s32(block + i * 8);
+	transform(s, lo);
+	for (int i = 0; i < 8; i++)
+		s[i] = vld1q_s32(block + i * 8 + 4);
+	transform(s, hi);
+
+	transpose(lo, hi);
+
+	for (int i = 0; i < 8; i++)
+		s[i] = lo[i];
+	transform(s, lo);
+	for (int i = 0; i < 8; i++)
+		s[i] = hi[i];
+	transform(s, hi);
+
+	const int32x4_t round = vdupq_n_s32(0x7F);
+	for (int i = 0; i < 8; i++) {
+		lo[i] = vshrq_n_s32(vaddq_s32(lo[i], round), 8);
+		hi[i] = vshrq_n_s32(vaddq_s32(hi[i], round), 8);
+	}
+
+	transpose(lo, hi);
+}
+
+/** Returns the low bytes of the 8 values of a row. */
+static inline uint8x8_t lowBytes(int32x4_t lo, int32x4_t hi) {
+	return vmovn_u16(vreinterpretq_u16_s16(vcombine_s16(vmovn_s32(lo), vmovn_s32(hi))));
+}
+
+static void idctPut(byte *dest, uint32 pitch, const int32 *block) {
+	int32x4_t lo[8], hi[8];
+	idct(block, lo, hi);
+
+	for (int i = 0; i < 8; i++, dest += pitch)
+		vst1_u8(dest, lowBytes(lo[i], hi[i]));
+}
+
+static void idctAdd(byte *dest, uint32 pitch, const int32 *block) {
+	int32x4_t lo[8], hi[8];
+	idct(block, lo, hi);
+
+	for (int i = 0; i < 8; i++, dest += pitch)
+		vst1_u8(dest, vadd_u8(vld1_u8(dest), lowBytes(lo[i], hi[i])));
+}
+
+static void addResidue(byte *dest, uint32 pitch, const int16 *block) {
+	for (int i = 0; i < 8; i++, dest += pitch, block += 8) {
+		const uint8x8_t residue = vreinterpret_u8_s8(vmovn_s16(vld1q_s16(block)));
+		vst1_u8(dest, vadd_u8(vld1_u8(dest), residue));
+	}
+}
+
+static void putPattern(byte *dest, uint32 pitch, byte col0, byte col1, const byte *pattern) {
+	const uint8x8_t bits = vcreate_u8(0x8040201008040201ULL);
+	const uint8x8_t c0 = vdup_n_u8(col0);
+	const uint8x8_t c1 = vdup_n_u8(col1);
+
+	for (int i = 0; i < 8; i++, dest += pitch)
+		vst1_u8(dest, vbsl_u8(vtst_u8(vdup_n_u8(pattern[i]), bits), c1, c0));
+}
+
+static void putScaled(byte *dest, uint32 pitch, const byte *src) {
+	for (int i = 0; i < 8; i++, dest += pitch * 2, src += 8) {
+		const uint8x8_t v = vld1_u8(src);
+		const uint8x8x2_t z = vzip_u8(v, v);
+		const uint8x16_t row = vcombine_u8(z.val[0], z.val[1]);
+		vst1q_u8(dest, row);
+		vst1q_u8(dest + pitch, row);
+	}
+}
+
+}; // End of class BinkKernelsImpl_NEON
+
+const BinkKernels::Table BinkKernels::neon = {
+	BinkKernelsImpl_NEON::idctPut,
+	BinkKernelsImpl_NEON::idctAdd,
+	BinkKernelsImpl_NEON::addResidue,
+	BinkKernelsImpl_NEON::putPattern,
+	BinkKernelsImpl_NEON::putScaled
+};
+
+} // End of namespace Video
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
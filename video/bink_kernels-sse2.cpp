@@ -0,0 +1,232 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "video/bink_kernels.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Video {
+
+class BinkKernelsImpl_SSE2 {
+public:
+
+/** Returns the low 32 bits of the products, as SSE2 has no _mm_mullo_epi32. */
+static inline __m128i mul(__m128i a, int k) {
+	const __m128i f = _mm_set1_epi32(k);
+	const __m128i even = _mm_mul_epu32(a, f);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), f);
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/** Returns (k * a) >> 11, like the IDCT of the generic kernels. */
+static inline __m128i scale(__m128i a, int k) {
+	return _mm_srai_epi32(mul(a, k), 11);
+}
+
+/** The IDCT of 4 columns or rows, with s[i] holding their i-th coefficients. */
+static inline void transform(const __m128i *s, __m128i *d) {
+	const __m128i a0 = _mm_add_epi32(s[0], s[4]);
+	const __m128i a1 = _mm_sub_epi32(s[0], s[4]);
+	const __m128i a2 = _mm_add_epi32(s[2], s[6]);
+	const __m128i a3 = scale(_mm_sub_epi32(s[2], s[6]), BinkKernels::kIDCTA1);
+	const __m128i a4 = _mm_add_epi32(s[5], s[3]);
+	const __m128i a5 = _mm_sub_epi32(s[5], s[3]);
+	const __m128i a6 = _mm_add_epi32(s[1], s[7]);
+	const __m128i a7 = _mm_sub_epi32(s[1], s[7]);
+	const __m128i b0 = _mm_add_epi32(a4, a6);
+	const __m128i b1 = scale(_mm_add_epi32(a5, a7), BinkKernels::kIDCTA3);
+	const __m128i b2 = _mm_add_epi32(_mm_sub_epi32(scale(a5, BinkKernels::kIDCTA4), b0), b1);
+	const __m128i b3 = _mm_sub_epi32(scale(_mm_sub_epi32(a6, a4), BinkKernels::kIDCTA1), b2);
+	const __m128i b4 = _mm_sub_epi32(_mm_add_epi32(scale(a7, BinkKernels::kIDCTA2), b3), b1);
+	const __m128i c0 = _mm_add_epi32(a0, a2);
+	const __m128i c1 = _mm_sub_epi32(_mm_add_epi32(a1, a3), a2);
+	const __m128i c2 = _mm_add_epi32(_mm_sub_epi32(a1, a3), a2);
+	const __m128i c3 = _mm_sub_epi32(a0, a2);
+	d[0] = _mm_add_epi32(c0, b0);
+	d[1] = _mm_add_epi32(c1, b2);
+	d[2] = _mm_add_epi32(c2, b3);
+	d[3] = _mm_sub_epi32(c3, b4);
+	d[4] = _mm_add_epi32(c3, b4);
+	d[5] = _mm_sub_epi32(c2, b3);
+	d[6] = _mm_sub_epi32(c1, b2);
+	d[7] = _mm_sub_epi32(c0, b0);
+}
+
+static inline void transpose4x4(__m128i &r0, __m128i &r1, __m128i &r2, __m128i &r3) {
+	const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+	const __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+	const __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+	const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+	r0 = _mm_unpacklo_epi64(t0, t1);
+	r1 = _mm_unpackhi_epi64(t0, t1);
+	r2 = _mm_unpacklo_epi64(t2, t3);
+	r3 = _mm_unpackhi_epi64(t2, t3);
+}
+
+/**
+ * Transposes an 8x8 matrix, whose rows are split in their left half
+ * in @p lo and their right half in @p hi.
+ */
+static inline void transpose(__m128i *lo, __m128i *hi) {
+	transpose4x4(lo[0], lo[1], lo[2], lo[3]);
+	transpose4x4(lo[4], lo[5], lo[6], lo[7]);
+	transpose4x4(hi[0], hi[1], hi[2], hi[3]);
+	transpose4x4(hi[4], hi[5], hi[6], hi[7]);
+
+	for (int i = 0; i < 4; i++) {
+		const __m128i t = lo[i + 4];
+		lo[i + 4] = hi[i];
+		hi[i] = t;
+	}
+}
+
+/** Returns the rows of the IDCT of @p block, split like for transpose(). */
+static inline void idct(const int32 *block, __m128i *lo, __m128i *hi) {
+	__m128i s[8];
+
+	for (int i = 0; i < 8; i++)
+		s[i] = _mm_loadu_si128((const __m128i *)(block + i * 8));
+	transform(s, lo);
+	for (int i = 0; i < 8; i++)
+		s[i] = _mm_loadu_si128((const __m128i *)(block + i * 8 + 4));
+	transform(s, hi);
+
+	transpose(lo, hi);
+
+	const __m128i round = _mm_set1_epi32(0x7F);
+	for (int i = 0; i < 8; i++)
+		s[i] = lo[i];
+	transform(s, lo);
+	for (int i = 0; i < 8; i++)
+		s[i] = hi[i];
+	transform(s, hi);
+
+	for (int i = 0; i < 8; i++) {
+		lo[i] = _mm_srai_epi32(_mm_add_epi32(lo[i], round), 8);
+		hi[i] = _mm_srai_epi32(_mm_add_epi32(hi[i], round), 8);
+	}
+
+	transpose(lo, hi);
+}
+
+/** Returns the low bytes of the 8 values of a row, in the low half. */
+static inline __m128i lowBytes(__m128i lo, __m128i hi) {
+	const __m128i mask = _mm_set1_epi32(0xFF);
+	const __m128i words = _mm_packs_epi32(_mm_and_si128(lo, mask), _mm_and_si128(hi, mask));
+	return _mm_packus_epi16(words, words);
+}
+
+static void idctPut(byte *dest, uint32 pitch, const int32 *block) {
+	__m128i lo[8], hi[8];
+	idct(block, lo, hi);
+
+	for (int i = 0; i < 8; i++, dest += pitch)
+		_mm_storel_epi64((__m128i *)dest, lowBytes(lo[i], hi[i]));
+}
+
+static void idctAdd(byte *dest, uint32 pitch, const int32 *block) {
+	__m128i lo[8], hi[8];
+	idct(block, lo, hi);
+
+	for (int i = 0; i < 8; i++, dest += pitch) {
+		const __m128i pixels = _mm_loadl_epi64((const __m128i *)dest);
+		_mm_storel_epi64((__m128i *)dest, _mm_add_epi8(pixels, lowBytes(lo[i], hi[i])));
+	}
+}
+
+static void addResidue(byte *dest, uint32 pitch, const int16 *block) {
+	const __m128i mask = _mm_set1_epi16(0xFF);
+
+	for (int i = 0; i < 8; i++, dest += pitch, block += 8) {
+		const __m128i residue = _mm_and_si128(_mm_loadu_si128((const __m128i *)block), mask);
+		const __m128i pixels = _mm_loadl_epi64((const __m128i *)dest);
+		_mm_storel_epi64((__m128i *)dest, _mm_add_epi8(pixels, _mm_packus_epi16(residue, residue)));
+	}
+}
+
+static void putPattern(byte *dest, uint32 pitch, byte col0, byte col1, const byte *pattern) {
+	const __m128i bits = _mm_set1_epi64x(0x8040201008040201LL);
+	const __m128i c0 = _mm_set1_epi8((char)col0);
+	const __m128i c1 = _mm_set1_epi8((char)col1);
+
+	// Repeat the pattern byte of each row 8 times
+	__m128i p = _mm_loadl_epi64((const __m128i *)pattern);
+	p = _mm_unpacklo_epi8(p, p);
+	const __m128i p4 = _mm_unpacklo_epi16(p, p);
+	const __m128i p8 = _mm_unpackhi_epi16(p, p);
+	const __m128i rows[4] = {
+		_mm_unpacklo_epi32(p4, p4), _mm_unpackhi_epi32(p4, p4),
+		_mm_unpacklo_epi32(p8, p8), _mm_unpackhi_epi32(p8, p8)
+	};
+
+	for (int i = 0; i < 4; i++) {
+		const __m128i m = _mm_cmpeq_epi8(_mm_and_si128(rows[i], bits), bits);
+		const __m128i v = _mm_or_si128(_mm_and_si128(m, c1), _mm_andnot_si128(m, c0));
+		_mm_storel_epi64((__m128i *)dest, v);
+		dest += pitch;
+		_mm_storel_epi64((__m128i *)dest, _mm_srli_si128(v, 8));
+		dest += pitch;
+	}
+}
+
+static void putScaled(byte *dest, uint32 pitch, const byte *src) {
+	for (int i = 0; i < 8; i++, dest += pitch * 2, src += 8) {
+		__m128i v = _mm_loadl_epi64((const __m128i *)src);
+		v = _mm_unpacklo_epi8(v, v);
+		_mm_storeu_si128((__m128i *)dest, v);
+		_mm_storeu_si128((__m128i *)(dest + pitch), v);
+	}
+}
+
+}; // End of class BinkKernelsImpl_SSE2
+
+const BinkKernels::Table BinkKernels::sse2 = {
+	BinkKernelsImpl_SSE2::idctPut,
+	BinkKernelsImpl_SSE2::idctAdd,
+	BinkKernelsImpl_SSE2::addResidue,
+	BinkKernelsImpl_SSE2::putPattern,
+	BinkKernelsImpl_SSE2::putScaled
+};
+
+} // End of namespace Video
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
@@ -0,0 +1,143 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "video/bink_kernels.h"
+
+namespace Video {
+
+namespace {
+
+#define IDCT_TRANSFORM(dest,s0,s1,s2,s3,s4,s5,s6,s7,d0,d1,d2,d3,d4,d5,d6,d7,munge,src) {\
+	const int a0 = (src)[s0] + (src)[s4]; \
+	const int a1 = (src)[s0] - (src)[s4]; \
+	const int a2 = (src)[s2] + (src)[s6]; \
+	const int a3 = (BinkKernels::kIDCTA1*((src)[s2] - (src)[s6])) >> 11; \
+	const int a4 = (src)[s5] + (src)[s3]; \
+	const int a5 = (src)[s5] - (src)[s3]; \
+	const int a6 = (src)[s1] + (src)[s7]; \
+	const int a7 = (src)[s1] - (src)[s7]; \
+	const int b0 = a4 + a6; \
+	const int b1 = (BinkKernels::kIDCTA3*(a5 + a7)) >> 11; \
+	const int b2 = ((BinkKernels::kIDCTA4*a5) >> 11) - b0 + b1; \
+	const int b3 = (BinkKernels::kIDCTA1*(a6 - a4) >> 11) - b2; \
+	const int b4 = ((BinkKernels::kIDCTA2*a7) >> 11) + b3 - b1; \
+	(dest)[d0] = munge(a0+a2   +b0); \
+	(dest)[d1] = munge(a1+a3-a2+b2); \
+	(dest)[d2] = munge(a1-a3+a2+b3); \
+	(dest)[d3] = munge(a0-a2   -b4); \
+	(dest)[d4] = munge(a0-a2   +b4); \
+	(dest)[d5] = munge(a1-a3+a2-b3); \
+	(dest)[d6] = munge(a1+a3-a2-b2); \
+	(dest)[d7] = munge(a0+a2   -b0); \
+}
+/* end IDCT_TRANSFORM macro */
+
+#define MUNGE_NONE(x) (x)
+#define IDCT_COL(dest,src) IDCT_TRANSFORM(dest,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,MUNGE_NONE,src)
+
+#define MUNGE_ROW(x) (((x) + 0x7F)>>8)
+#define IDCT_ROW(dest,src) IDCT_TRANSFORM(dest,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,MUNGE_ROW,src)
+
+inline void IDCTCol(int32 *dest, const int32 *src) {
+	if ((src[8] | src[16] | src[24] | src[32] | src[40] | src[48] | src[56]) == 0) {
+		dest[ 0] =
+		dest[ 8] =
+		dest[16] =
+		dest[24] =
+		dest[32] =
+		dest[40] =
+		dest[48] =
+		dest[56] = src[0];
+	} else {
+		IDCT_COL(dest, src);
+	}
+}
+
+void IDCTPut(byte *dest, uint32 pitch, const int32 *block) {
+	int32 temp[64];
+	for (int i = 0; i < 8; i++)
+		IDCTCol(&temp[i], &block[i]);
+	for (int i = 0; i < 8; i++) {
+		IDCT_ROW( (&dest[i*pitch]), (&temp[8*i]) );
+	}
+}
+
+void IDCTAdd(byte *dest, uint32 pitch, const int32 *block) {
+	int32 temp[64], result[64];
+	for (int i = 0; i < 8; i++)
+		IDCTCol(&temp[i], &block[i]);
+	for (int i = 0; i < 8; i++) {
+		IDCT_ROW( (&result[8*i]), (&temp[8*i]) );
+	}
+
+	const int32 *src = result;
+	for (int i = 0; i < 8; i++, dest += pitch, src += 8)
+		for (int j = 0; j < 8; j++)
+			dest[j] += src[j];
+}
+
+#undef IDCT_ROW
+#undef MUNGE_ROW
+#undef IDCT_COL
+#undef MUNGE_NONE
+#undef IDCT_TRANSFORM
+
+void addResidue(byte *dest, uint32 pitch, const int16 *block) {
+	for (int i = 0; i < 8; i++, dest += pitch, block += 8)
+		for (int j = 0; j < 8; j++)
+			dest[j] += block[j];
+}
+
+void putPattern(byte *dest, uint32 pitch, byte col0, byte col1, const byte *pattern) {
+	const byte col[2] = { col0, col1 };
+
+	for (int i = 0; i < 8; i++, dest += pitch) {
+		byte v = pattern[i];
+
+		for (int j = 0; j < 8; j++, v >>= 1)
+			dest[j] = col[v & 1];
+	}
+}
+
+void putScaled(byte *dest, uint32 pitch, const byte *src) {
+	byte *dest1 = dest;
+	byte *dest2 = dest + pitch;
+	for (int j = 0; j < 8; j++, dest1 += (pitch << 1) - 16, dest2 += (pitch << 1) - 16, src += 8) {
+
+		for (int i = 0; i < 8; i++, dest1 += 2, dest2 += 2)
+			dest1[0] = dest1[1] = dest2[0] = dest2[1] = src[i];
+
+	}
+}
+
+} // End of anonymous namespace
+
+const BinkKernels::Table BinkKernels::generic = {
+	IDCTPut,
+	IDCTAdd,
+	addResidue,
+	putPattern,
+	putScaled
+};
+
+const BinkKernels::Table *BinkKernels::kernels = nullptr;
+
+} // End of namespace Video
@@ -0,0 +1,85 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef VIDEO_BINK_KERNELS_H
+#define VIDEO_BINK_KERNELS_H
+
+#include "common/cpu-kernels.h"
+#include "common/scummsys.h"
+
+namespace Video {
+
+/**
+ * The block operations of the Bink video decoder, with SIMD versions.
+ *
+ * All the versions produce the same pixels as the generic one. Like the
+ * original decoder, they wrap the pixel values around instead of clipping
+ * them.
+ */
+class BinkKernels {
+public:
+	/** Apply the IDCT to an 8x8 block of coefficients, and store the pixels. */
+	typedef void (*IDCTPutFunc)(byte *dest, uint32 pitch, const int32 *block);
+	/** Apply the IDCT to an 8x8 block of coefficients, and add it to the pixels. */
+	typedef void (*IDCTAddFunc)(byte *dest, uint32 pitch, const int32 *block);
+	/** Add an 8x8 block of residues to the pixels. */
+	typedef void (*AddResidueFunc)(byte *dest, uint32 pitch, const int16 *block);
+	/** Fill an 8x8 block with two colors, following one byte of @p pattern per row. */
+	typedef void (*PutPatternFunc)(byte *dest, uint32 pitch, byte col0, byte col1, const byte *pattern);
+	/** Scale an 8x8 block of pixels, packed in 64 bytes, to 16x16. */
+	typedef void (*PutScaledFunc)(byte *dest, uint32 pitch, const byte *src);
+
+	struct Table {
+		IDCTPutFunc idctPut;
+		IDCTAddFunc idctAdd;
+		AddResidueFunc addResidue;
+		PutPatternFunc putPattern;
+		PutScaledFunc putScaled;
+	};
+
+	static const Table generic;
+#ifdef SCUMMVM_NEON
+	static const Table neon;
+#endif
+#ifdef SCUMMVM_SSE2
+	static const Table sse2;
+#endif
+#ifdef SCUMMVM_AVX2
+	static const Table avx2;
+#endif
+
+	/** The kernels in use, see Common::CpuKernels. */
+	static const Table *kernels;
+
+	static const Table &get() { return Common::CpuKernels<BinkKernels>::get(); }
+
+	/** The fixed point factors of the IDCT, in 1 / 2048 units. */
+	enum {
+		kIDCTA1 = 2896, // (1/sqrt(2))<<12
+		kIDCTA2 = 2217,
+		kIDCTA3 = 3784,
+		kIDCTA4 = -5352
+	};
+};
+
+} // End of namespace Video
+
+#endif
@@ -18,7 +18,21 @@ MODULE_OBJS := \
 
 ifdef USE_BINK
 MODULE_OBJS += \
-	bink_decoder.o
+	bink_decoder.o \
+	bink_kernels.o
+
+ifdef SCUMMVM_NEON
+MODULE_OBJS += \
+	bink_kernels-neon.o
+endif
+ifdef SCUMMVM_SSE2
+MODULE_OBJS += \
+	bink_kernels-sse2.o
+endif
+ifdef SCUMMVM_AVX2
+MODULE_OBJS += \
+	bink_kernels-avx2.o
+endif
 endif
 
 ifdef USE_HNM
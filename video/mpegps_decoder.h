@@ -63,6 +63,7 @@ public:
 protected:
 	void readNextPacket();
 	bool useAudioSync() const { return false; }
+	bool supportsDecodeAhead() const { return true; }
 
 private:
 	class MPEGPSDemuxer {
@@ -101,10 +101,6 @@ const Graphics::Surface *QuickTimeDecoder::decodeNextFrame() {
 	if (isVR())
 		updateAngles();
 
-	// Update audio buffers too
-	// (needs to be done after we find the next track)
-	updateAudioBuffer();
-
 	// We have to initialize the scaled surface
 	if (frame && (_scaleFactorX != 1 || _scaleFactorY != 1)) {
 		if (!_scaledSurface) {
@@ -119,6 +115,16 @@ const Graphics::Surface *QuickTimeDecoder::decodeNextFrame() {
 	return frame;
 }
 
+const Graphics::Surface *QuickTimeDecoder::decodeNextFrameIntern() {
+	const Graphics::Surface *frame = VideoDecoder::decodeNextFrameIntern();
+
+	// Update audio buffers too, as they are read from the same stream
+	// (needs to be done after we find the next track)
+	updateAudioBuffer();
+
+	return frame;
+}
+
 Common::QuickTimeParser::SampleDesc *QuickTimeDecoder::readSampleDesc(Common::QuickTimeParser::Track *track, uint32 format, uint32 descSize) {
 	if (track->codecType == CODEC_TYPE_VIDEO) {
 		debugC(0, kDebugLevelGVideo, "Video Codec FourCC: \'%s\'", tag2str(format));
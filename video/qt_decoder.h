@@ -159,6 +159,10 @@ public:
 	void goToNode(uint32 nodeID);
 
 protected:
+	const Graphics::Surface *decodeNextFrameIntern();
+	// The panoramas are decoded on demand, for the current view
+	bool supportsDecodeAhead() const { return !isVR(); }
+
 	Common::QuickTimeParser::SampleDesc *readSampleDesc(Common::QuickTimeParser::Track *track, uint32 format, uint32 descSize);
 	Common::QuickTimeParser::SampleDesc *readPanoSampleDesc(Common::QuickTimeParser::Track *track, uint32 format, uint32 descSize);
 
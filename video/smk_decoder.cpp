@@ -301,6 +301,7 @@ SmackerDecoder::SmackerDecoder() {
 	_firstFrameStart = 0;
 	_frameTypes = 0;
 	_frameSizes = 0;
+	_fullDirtyRectFrame = -1;
 }
 
 SmackerDecoder::~SmackerDecoder() {
@@ -448,6 +449,7 @@ bool SmackerDecoder::rewind() {
 
 	// And seek back to where the first frame begins
 	_fileStream->seek(_firstFrameStart);
+	_fullDirtyRectFrame = -1;
 	return true;
 }
 
@@ -969,6 +971,17 @@ Common::Rational SmackerDecoder::getFrameRate() const {
 const Common::Rect *SmackerDecoder::getNextDirtyRect() {
 	SmackerVideoTrack *videoTrack = (SmackerVideoTrack *)getTrack(0);
 
+	// The dirty blocks of the track belong to the last frame decoded ahead,
+	// so the whole frame is dirty instead
+	if (isDecodingAhead()) {
+		if (_fullDirtyRectFrame == getCurFrame())
+			return nullptr;
+
+		_fullDirtyRectFrame = getCurFrame();
+		_fullDirtyRect = Common::Rect(videoTrack->getWidth(), videoTrack->getHeight());
+		return &_fullDirtyRect;
+	}
+
 	return videoTrack->getNextDirtyRect();
 }
 
@@ -91,6 +91,7 @@ public:
 protected:
 	void readNextPacket();
 	bool supportsAudioTrackSwitching() const { return true; }
+	bool supportsDecodeAhead() const { return true; }
 	AudioTrack *getAudioTrack(int index);
 
 	virtual void handleAudioTrack(byte track, uint32 chunkSize, uint32 unpackedSize);
@@ -222,6 +223,10 @@ protected:
 
 private:
 	uint32 _firstFrameStart;
+
+	// The dirty rects of frames decoded ahead
+	int _fullDirtyRectFrame;
+	Common::Rect _fullDirtyRect;
 };
 
 } // End of namespace Video
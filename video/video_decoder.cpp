@@ -24,12 +24,313 @@
 #include "audio/audiostream.h"
 #include "audio/mixer.h" // for kMaxChannelVolume
 
+#include "common/atomic.h"
+#include "common/config-manager.h"
 #include "common/rational.h"
 #include "common/file.h"
 #include "common/system.h"
+#include "common/thread.h"
+
+#include "graphics/surface.h"
 
 namespace Video {
 
+/**
+ * Decodes the frames of a VideoDecoder ahead on a worker thread, into a ring
+ * of surfaces which are only allocated again when the frame size changes.
+ *
+ * While the worker runs, it owns the decoding state: the tracks, the stream
+ * and the decoder's _nextVideoTrack and _palette. The caller's thread only
+ * reads the snapshots taken in each slot of the ring. The slot of the frame
+ * returned last by decodeNextFrame() is kept until the next one is taken,
+ * so that the caller can keep drawing it.
+ *
+ * Only takeFrame() waits for the worker. The other queries tell a frame
+ * which is not decoded yet apart from the end of the video, so that the
+ * caller's loop does not stall when the worker is behind.
+ *
+ * Once the worker is stopped, the frames left in the ring are still returned
+ * before the decoder goes on decoding by itself, unless they are discarded.
+ */
+class VideoDecoder::DecodeAhead {
+public:
+	struct Frame {
+		Frame() : isNull(true), dirtyPalette(false), curFrame(-1), track(nullptr), trackCurFrame(-1), startTime(0) {}
+
+		Graphics::Surface surface;
+		bool isNull;
+		byte palette[256 * 3];
+		bool dirtyPalette;
+		/** The value of getCurFrame() once this frame is decoded */
+		int curFrame;
+		VideoTrack *track;
+		int trackCurFrame;
+		uint32 startTime;
+	};
+
+	DecodeAhead(VideoDecoder *decoder, uint numFrames);
+	~DecodeAhead();
+
+	/**
+	 * Start decoding from the current state of the decoder.
+	 *
+	 * @return false if the backend has no threads
+	 */
+	bool start();
+
+	/** Stop the worker, but keep the frames it already decoded. */
+	void stop();
+
+	/**
+	 * Drop the decoded frames which were not returned yet. The last frame
+	 * returned is kept.
+	 *
+	 * @return true if frames were dropped, i.e. the tracks are ahead of the
+	 *         last frame returned
+	 */
+	bool discard();
+
+	/** Is the worker running, or are there frames left from it? */
+	bool isActive() const { return _thread || _consumed != _produced.load(); }
+	/** Is the worker still decoding, and so still using the tracks? */
+	bool isDecoding() const { return _thread && !_finished.load(); }
+	uint getNumFrames() const { return _frames.size() - 1; }
+
+	/**
+	 * Return the next frame without taking it, if it is already decoded.
+	 *
+	 * @return the next frame, or nullptr if it is not decoded yet (see
+	 *         isDecoding()) or at the end of the video
+	 */
+	const Frame *peekFrame() const;
+
+	/**
+	 * Wait until the next frame is decoded, and take it. Its slot is kept
+	 * until the next call.
+	 *
+	 * @return the next frame, or nullptr at the end of the video
+	 */
+	const Frame *takeFrame();
+
+	int getCurFrame() const { return _curFrame; }
+	VideoTrack *getTrack() const { return _track; }
+	int getTrackCurFrame() const { return _trackCurFrame; }
+
+	const byte *getPalette() { _dirtyPalette = false; return _palette; }
+	bool hasDirtyPalette() const { return _dirtyPalette; }
+	void clearDirtyPalette() { _dirtyPalette = false; }
+
+private:
+	static void workerProc(void *data);
+	void run();
+	void copyFrame(Frame &frame, const Graphics::Surface *surface);
+	void handOver();
+	Frame &getSlot(uint32 index) { return _frames[(_firstSlot + index) % _frames.size()]; }
+	const Frame &getSlot(uint32 index) const { return _frames[(_firstSlot + index) % _frames.size()]; }
+
+	VideoDecoder *_decoder;
+	Common::Array<Frame> _frames;
+	Common::ThreadInternal *_thread;
+	Common::SemaphoreInternal *_freeSlots;
+	Common::SemaphoreInternal *_readySlots;
+	Common::Atomic<uint32> _produced;
+	Common::Atomic<uint32> _finished;
+	Common::Atomic<uint32> _quit;
+
+	// Only used by the caller's thread
+	uint _firstSlot;
+	uint32 _consumed;
+	int _shownSlot;
+	int _curFrame;
+	VideoTrack *_track;
+	int _trackCurFrame;
+	byte _palette[256 * 3];
+	bool _dirtyPalette;
+};
+
+VideoDecoder::DecodeAhead::DecodeAhead(VideoDecoder *decoder, uint numFrames) :
+		_decoder(decoder), _thread(nullptr), _freeSlots(nullptr), _readySlots(nullptr),
+		_firstSlot(0), _consumed(0), _shownSlot(-1), _curFrame(-1), _track(nullptr),
+		_trackCurFrame(-1), _dirtyPalette(false) {
+	// One more slot for the frame which is shown
+	_frames.resize(numFrames + 1);
+	memset(_palette, 0, sizeof(_palette));
+}
+
+VideoDecoder::DecodeAhead::~DecodeAhead() {
+	stop();
+
+	for (auto &frame : _frames)
+		frame.surface.free();
+}
+
+bool VideoDecoder::DecodeAhead::start() {
+	assert(!isActive());
+
+	_freeSlots = g_system->createSemaphore();
+	_readySlots = g_system->createSemaphore();
+	if (!_freeSlots || !_readySlots) {
+		delete _freeSlots;
+		delete _readySlots;
+		_freeSlots = _readySlots = nullptr;
+		return false;
+	}
+
+	// Keep the slot of the frame which is still shown
+	_firstSlot = _shownSlot >= 0 ? (_shownSlot + 1) % _frames.size() : 0;
+	_consumed = 0;
+	_produced.store(0);
+	_finished.store(0);
+	_quit.store(0);
+
+	_curFrame = _decoder->getLastDecodedFrame();
+	_track = _decoder->_nextVideoTrack;
+	_trackCurFrame = _track ? _track->getCurFrame() : -1;
+
+	// That slot is then released by takeFrame()
+	for (uint i = (_shownSlot >= 0) ? 1 : 0; i < _frames.size(); i++)
+		_freeSlots->post();
+
+	_thread = g_system->createThread(workerProc, this);
+	if (!_thread) {
+		delete _freeSlots;
+		delete _readySlots;
+		_freeSlots = _readySlots = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+void VideoDecoder::DecodeAhead::stop() {
+	if (!_thread)
+		return;
+
+	_quit.store(1);
+	_freeSlots->post();
+	_thread->join();
+
+	delete _thread;
+	delete _freeSlots;
+	delete _readySlots;
+	_thread = nullptr;
+	_freeSlots = _readySlots = nullptr;
+
+	if (!isActive())
+		handOver();
+}
+
+bool VideoDecoder::DecodeAhead::discard() {
+	stop();
+
+	const bool dropped = _consumed != _produced.load();
+	_consumed = _produced.load();
+	handOver();
+	return dropped;
+}
+
+void VideoDecoder::DecodeAhead::handOver() {
+	// A palette change which was not returned yet still has to be, by the
+	// decoder. Its palette is the one of the last frame decoded.
+	if (_dirtyPalette)
+		_decoder->_dirtyPalette = true;
+
+	_dirtyPalette = false;
+}
+
+const VideoDecoder::DecodeAhead::Frame *VideoDecoder::DecodeAhead::peekFrame() const {
+	if (_consumed == _produced.load())
+		return nullptr;
+
+	return &getSlot(_consumed);
+}
+
+const VideoDecoder::DecodeAhead::Frame *VideoDecoder::DecodeAhead::takeFrame() {
+	if (_consumed == _produced.load() && isDecoding()) {
+		// Wait for the worker, and leave the count for below
+		_readySlots->wait();
+		_readySlots->post();
+	}
+
+	if (!peekFrame())
+		return nullptr;
+
+	// The previous frame is not shown anymore, so its slot can be reused
+	if (_thread) {
+		_readySlots->wait();
+		if (_shownSlot >= 0)
+			_freeSlots->post();
+	}
+
+	_shownSlot = (_firstSlot + _consumed) % _frames.size();
+	_consumed++;
+
+	const Frame &frame = _frames[_shownSlot];
+	_curFrame = frame.curFrame;
+	_track = frame.track;
+	_trackCurFrame = frame.trackCurFrame;
+
+	if (frame.dirtyPalette) {
+		memcpy(_palette, frame.palette, sizeof(_palette));
+		_dirtyPalette = true;
+	}
+
+	// The decoder takes over after the last frame left by the worker
+	if (!isActive())
+		handOver();
+
+	return &frame;
+}
+
+void VideoDecoder::DecodeAhead::workerProc(void *data) {
+	((DecodeAhead *)data)->run();
+}
+
+void VideoDecoder::DecodeAhead::run() {
+	for (uint32 index = 0; ; index++) {
+		_freeSlots->wait();
+		if (_quit.load())
+			break;
+
+		// This is where the decoder would return no frame anymore
+		if (!_decoder->_nextVideoTrack) {
+			_finished.store(1);
+			_readySlots->post();
+			break;
+		}
+
+		Frame &frame = getSlot(index);
+		frame.track = _decoder->_nextVideoTrack;
+		frame.startTime = frame.track->getNextFrameStartTime();
+
+		copyFrame(frame, _decoder->decodeNextFrameIntern());
+
+		frame.trackCurFrame = frame.track->getCurFrame();
+		frame.curFrame = _decoder->getLastDecodedFrame();
+		frame.dirtyPalette = _decoder->_dirtyPalette;
+		if (frame.dirtyPalette) {
+			memcpy(frame.palette, _decoder->_palette, sizeof(frame.palette));
+			_decoder->_dirtyPalette = false;
+		}
+
+		_produced.fetchAdd(1);
+		_readySlots->post();
+	}
+}
+
+void VideoDecoder::DecodeAhead::copyFrame(Frame &frame, const Graphics::Surface *surface) {
+	frame.isNull = !surface;
+	if (!surface)
+		return;
+
+	if (frame.surface.w != surface->w || frame.surface.h != surface->h || frame.surface.format != surface->format) {
+		frame.surface.free();
+		frame.surface.create(surface->w, surface->h, surface->format);
+	}
+
+	frame.surface.copyRectToSurface(*surface, 0, 0, Common::Rect(surface->w, surface->h));
+}
+
 VideoDecoder::VideoDecoder() {
 	_startTime = 0;
 	_dirtyPalette = false;
@@ -48,9 +349,20 @@ VideoDecoder::VideoDecoder() {
 	_canSetDither = true;
 	_canSetDefaultFormat = true;
 	_videoCodecAccuracy = Image::CodecAccuracy::Default;
+	_decodeAhead = nullptr;
+	_decodeAheadFrames = MAX(ConfMan.getInt("video_decode_ahead"), 0);
+	_decodeAheadBlocked = 0;
+}
+
+VideoDecoder::~VideoDecoder() {
+	delete _decodeAhead;
 }
 
 void VideoDecoder::close() {
+	// Stop the worker before anything it uses is freed
+	delete _decodeAhead;
+	_decodeAhead = nullptr;
+
 	if (isPlaying())
 		stop();
 
@@ -212,6 +524,21 @@ const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	_canSetDither = false;
 	_canSetDefaultFormat = false;
 
+	if (!isDecodingAhead() && _decodeAheadFrames && !_decodeAheadBlocked)
+		startDecodeAhead();
+
+	if (isDecodingAhead()) {
+		const DecodeAhead::Frame *frame = _decodeAhead->takeFrame();
+		if (!frame || frame->isNull)
+			return 0;
+
+		return &frame->surface;
+	}
+
+	return decodeNextFrameIntern();
+}
+
+const Graphics::Surface *VideoDecoder::decodeNextFrameIntern() {
 	readNextPacket();
 
 	// If we have no next video track at this point, there shouldn't be
@@ -237,26 +564,126 @@ bool VideoDecoder::setReverse(bool reverse) {
 	if (reverse && hasAudio())
 		return false;
 
+	_decodeAheadBlocked++;
+
+	// The tracks reverse from the frame which is shown, so bring them back
+	// there if the worker decoded past it
+	if (reverse && isDecodingAhead()) {
+		const int curFrame = _decodeAhead->getTrackCurFrame();
+		VideoTrack *curTrack = _decodeAhead->getTrack();
+
+		if (_decodeAhead->discard() && curTrack && curFrame >= 0 && curTrack->isSeekable()) {
+			seekIntern(curTrack->getFrameTime(curFrame));
+			findNextVideoTrack();
+			decodeNextFrameIntern();
+		}
+	}
+
+	// The worker only runs while all the tracks play forward
+	if (isDecodingAhead()) {
+		_decodeAheadBlocked--;
+		return true;
+	}
+
 	// Attempt to make sure all the tracks are in the requested direction
 	for (auto &track : _tracks) {
 		if (track->getTrackType() == Track::kTrackTypeVideo && ((VideoTrack *)track)->isReversed() != reverse) {
-			if (!((VideoTrack *)track)->setReverse(reverse))
+			if (!((VideoTrack *)track)->setReverse(reverse)) {
+				_decodeAheadBlocked--;
 				return false;
+			}
 
 			_needsUpdate = true; // force an update
 		}
 	}
 
 	findNextVideoTrack();
+	_decodeAheadBlocked--;
+	return true;
+}
+
+bool VideoDecoder::setDecodeAhead(uint numFrames) {
+	if (!supportsDecodeAhead()) {
+		_decodeAheadFrames = 0;
+		return false;
+	}
+
+	// The frames already decoded are still returned, and the worker starts
+	// again with a new ring after them
+	if (numFrames != _decodeAheadFrames) {
+		if (_decodeAhead)
+			_decodeAhead->stop();
+
+		_decodeAheadFrames = numFrames;
+	}
+
 	return true;
 }
 
+bool VideoDecoder::isDecodingAhead() const {
+	return _decodeAhead && _decodeAhead->isActive();
+}
+
+void VideoDecoder::startDecodeAhead() {
+	if (!supportsDecodeAhead()) {
+		_decodeAheadFrames = 0;
+		return;
+	}
+
+	if (!_nextVideoTrack)
+		return;
+
+	// Reversed videos seek before each frame, which is not worth it
+	for (const auto &track : _tracks)
+		if (track->getTrackType() == Track::kTrackTypeVideo && ((const VideoTrack *)track)->isReversed())
+			return;
+
+	// The frame returned last is not used anymore at this point
+	if (_decodeAhead && _decodeAhead->getNumFrames() != _decodeAheadFrames) {
+		delete _decodeAhead;
+		_decodeAhead = nullptr;
+	}
+
+	if (!_decodeAhead)
+		_decodeAhead = new DecodeAhead(this, _decodeAheadFrames);
+
+	if (!_decodeAhead->start()) {
+		// No threads on this backend, so do not try again
+		delete _decodeAhead;
+		_decodeAhead = nullptr;
+		_decodeAheadFrames = 0;
+	}
+}
+
+void VideoDecoder::discardDecodeAhead() {
+	// The last frame returned is kept until the next one is decoded
+	if (_decodeAhead)
+		_decodeAhead->discard();
+}
+
 const byte *VideoDecoder::getPalette() {
+	if (isDecodingAhead())
+		return _decodeAhead->getPalette();
+
 	_dirtyPalette = false;
 	return _palette;
 }
 
+bool VideoDecoder::hasDirtyPalette() const {
+	if (isDecodingAhead())
+		return _decodeAhead->hasDirtyPalette();
+
+	return _dirtyPalette;
+}
+
 int VideoDecoder::getCurFrame() const {
+	if (isDecodingAhead())
+		return _decodeAhead->getCurFrame();
+
+	return getLastDecodedFrame();
+}
+
+int VideoDecoder::getLastDecodedFrame() const {
 	int32 frame = -1;
 
 	for (const auto &track : _tracks)
@@ -298,6 +725,24 @@ uint32 VideoDecoder::getTime() const {
 }
 
 uint32 VideoDecoder::getTimeToNextFrame() const {
+	if (isDecodingAhead()) {
+		if (endOfVideo() || _needsUpdate)
+			return 0;
+
+		// A frame which is not decoded yet is not due either, so that the
+		// caller does not wait for the worker
+		const DecodeAhead::Frame *frame = _decodeAhead->peekFrame();
+		if (!frame)
+			return _decodeAhead->isDecoding() ? 1 : 0;
+
+		uint32 currentTime = getTime();
+
+		if (frame->startTime <= currentTime)
+			return 0;
+
+		return frame->startTime - currentTime;
+	}
+
 	if (endOfVideo() || _needsUpdate || !_nextVideoTrack)
 		return 0;
 
@@ -320,6 +765,23 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 }
 
 bool VideoDecoder::endOfVideo() const {
+	if (isDecodingAhead()) {
+		if (hasFramesLeft())
+			return false;
+
+		// The video tracks reached the end time before the worker reached
+		// the end of the video. The frames past it are not needed, and the
+		// other tracks are only checked once the worker does not use them.
+		if (_decodeAhead->isDecoding())
+			_decodeAhead->stop();
+
+		for (const auto &track : _tracks)
+			if (track->getTrackType() != Track::kTrackTypeVideo && !track->endOfTrack())
+				return false;
+
+		return true;
+	}
+
 	for (const auto &track : _tracks) {
 		bool videoEndTimeReached = _endTimeSet && track->getTrackType() == Track::kTrackTypeVideo && ((const VideoTrack *)track)->getNextFrameStartTime() >= (uint)_endTime.msecs();
 		bool endReached = track->endOfTrack() || (isPlaying() && videoEndTimeReached);
@@ -345,6 +807,8 @@ bool VideoDecoder::rewind() {
 	if (!isRewindable())
 		return false;
 
+	discardDecodeAhead();
+
 	// Stop all tracks so they can be rewound
 	if (isPlaying())
 		stopAudio();
@@ -379,12 +843,18 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 	if (!isSeekable())
 		return false;
 
+	discardDecodeAhead();
+
 	// Stop all tracks so they can be seek'ed
 	if (isPlaying())
 		stopAudio();
 
-	// Do the actual seeking
-	if (!seekIntern(time))
+	// Do the actual seeking, which may decode frames itself
+	_decodeAheadBlocked++;
+	bool success = seekIntern(time);
+	_decodeAheadBlocked--;
+
+	if (!success)
 		return false;
 
 	// Seek any external track too
@@ -456,10 +926,16 @@ void VideoDecoder::stop() {
 
 	_playbackRate = 0;
 	_startTime = 0;
-	_palette = 0;
-	_dirtyPalette = false;
 	_needsUpdate = false;
 
+	// The palette belongs to the worker while it runs
+	if (isDecodingAhead()) {
+		_decodeAhead->clearDirtyPalette();
+	} else {
+		_palette = 0;
+		_dirtyPalette = false;
+	}
+
 	// Also reset the pause state.
 	_pauseLevel = 0;
 
@@ -947,8 +1423,19 @@ void VideoDecoder::setEndFrame(uint frame) {
 }
 
 void VideoDecoder::resetStartTime() {
-	if (_nextVideoTrack) {
-		Audio::Timestamp curTime = _nextVideoTrack->getFrameTime(_nextVideoTrack->getCurFrame());
+	VideoTrack *videoTrack;
+	int curFrame;
+
+	if (isDecodingAhead()) {
+		videoTrack = _decodeAhead->getTrack();
+		curFrame = _decodeAhead->getTrackCurFrame();
+	} else {
+		videoTrack = _nextVideoTrack;
+		curFrame = videoTrack ? videoTrack->getCurFrame() : -1;
+	}
+
+	if (videoTrack) {
+		Audio::Timestamp curTime = videoTrack->getFrameTime(curFrame);
 		if (isPlaying()) {
 			_startTime = g_system->getMillis() - (curTime.msecs() / _playbackRate).toInt();
 		}
@@ -1032,6 +1519,14 @@ bool VideoDecoder::hasFramesLeft() const {
 	// This is similar to endOfVideo(), except it doesn't take Audio into account (and returns true if not the end of the video)
 	// This is only used for needsUpdate() atm so that setEndTime() works properly
 	// And unlike endOfVideoTracks(), this takes into account _endTime
+	if (isDecodingAhead()) {
+		const DecodeAhead::Frame *frame = _decodeAhead->peekFrame();
+		if (!frame)
+			return _decodeAhead->isDecoding();
+
+		return !(isPlaying() && _endTimeSet && frame->startTime >= (uint)_endTime.msecs());
+	}
+
 	for (const auto &track : _tracks) {
 		if (track->getTrackType() != Track::kTrackTypeVideo)
 			continue;
@@ -53,7 +53,7 @@ namespace Video {
 class VideoDecoder {
 public:
 	VideoDecoder();
-	virtual ~VideoDecoder() {}
+	virtual ~VideoDecoder();
 
 	/////////////////////////////////////////
 	// Opening/Closing a Video
@@ -328,7 +328,7 @@ public:
 	/**
 	 * Returns if the palette is dirty or not.
 	 */
-	bool hasDirtyPalette() const { return _dirtyPalette; }
+	bool hasDirtyPalette() const;
 
 	/**
 	 * Delay/sleep for the specified amount of milliseconds, or until the next
@@ -365,6 +365,22 @@ public:
 	 */
 	virtual const Graphics::Surface *decodeNextFrame();
 
+	/**
+	 * Decode up to the given number of frames ahead of the displayed one, on
+	 * a worker thread. decodeNextFrame() then only has to hand out a frame
+	 * which is already decoded, instead of decoding it in the caller's loop.
+	 *
+	 * The frames are only decoded ahead on backends with threads, and while
+	 * the video plays forward. After seeking, rewinding or reversing the
+	 * video, the worker starts again on the next call to decodeNextFrame().
+	 *
+	 * By default, this is set from the video_decode_ahead setting.
+	 *
+	 * @param numFrames The number of frames to decode ahead, 0 to disable it
+	 * @return true if this video format supports decoding frames ahead
+	 */
+	bool setDecodeAhead(uint numFrames);
+
 	/**
 	 * Set the video to decode frames in reverse.
 	 *
@@ -973,6 +989,34 @@ protected:
 	 */
 	virtual bool seekIntern(const Audio::Timestamp &time);
 
+	/**
+	 * The internal function that does the actual decoding of the next frame.
+	 *
+	 * When frames are decoded ahead, this is called from the worker thread.
+	 * A subclass overriding it must then not touch anything used by the
+	 * caller's thread, apart from the tracks.
+	 *
+	 * @see decodeNextFrame()
+	 */
+	virtual const Graphics::Surface *decodeNextFrameIntern();
+
+	/**
+	 * Can the frames of this video be decoded ahead on a worker thread?
+	 *
+	 * A subclass returning true must decode everything from readNextPacket()
+	 * and decodeNextFrameIntern(), and stop the worker by calling
+	 * VideoDecoder::close() before it frees anything these use.
+	 */
+	virtual bool supportsDecodeAhead() const { return false; }
+
+	/**
+	 * Are the frames currently decoded ahead on a worker thread?
+	 *
+	 * When they are, the state of the tracks is the one of the last frame
+	 * decoded, which may be ahead of the one returned by decodeNextFrame().
+	 */
+	bool isDecodingAhead() const;
+
 	/**
 	 * Does this video format support switching between audio tracks?
 	 *
@@ -1014,6 +1058,15 @@ private:
 	bool _canSetDither;
 	bool _canSetDefaultFormat;
 
+	// Decoding frames ahead on a worker thread
+	class DecodeAhead;
+	DecodeAhead *_decodeAhead;
+	uint _decodeAheadFrames;
+	uint _decodeAheadBlocked;
+	void startDecodeAhead();
+	void discardDecodeAhead();
+	int getLastDecodedFrame() const;
+
 protected:
 	// Internal helper functions
 	void stopAudio();